@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::asbuild
+{
+    struct BlasBuildQueueDesc
+    {
+        // Queue that executes the builds. Falls back to the graphics queue if the device doesn't have a compute queue.
+        CommandQueue queue = CommandQueue::Compute;
+
+        // Maximum number of builds recorded into one submission by submitPendingBuilds, or 0 for no limit.
+        size_t maxBuildsPerSubmit = 0;
+
+        // Scratch memory settings of the internal command list, see CommandListParameters.
+        size_t scratchChunkSize = 16 * 1024 * 1024;
+        bool useSharedScratchPool = false;
+
+        BlasBuildQueueDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        BlasBuildQueueDesc& setMaxBuildsPerSubmit(size_t value) { maxBuildsPerSubmit = value; return *this; }
+        BlasBuildQueueDesc& setScratchChunkSize(size_t value) { scratchChunkSize = value; return *this; }
+        BlasBuildQueueDesc& setUseSharedScratchPool(bool value) { useSharedScratchPool = value; return *this; }
+    };
+
+    // Identifies a build request. Tokens are issued in increasing order and requests are executed in the same order,
+    // so when a request is complete, all requests with smaller tokens are complete too.
+    typedef uint64_t BuildToken;
+    constexpr BuildToken c_InvalidBuildToken = 0;
+
+    // Batches BLAS builds and refits from any thread and executes them on a separate queue, usually the async compute
+    // queue, so that they don't compete with rendering on the graphics queue. The builds are recorded through
+    // ICommandList::buildBottomLevelAccelStructs, so they use the regular scratch memory and state tracking of the
+    // backend, and the BLASes are returned to the AccelStructBuildBlas state at the end of each submission.
+    // Geometry buffers must be in a state that allows reading them on the build queue, for example by creating them
+    // with keepInitialState = true.
+    // A typical frame queues the refits of skinned meshes and the builds of streamed geometry, calls
+    // submitPendingBuilds, and then queueWaitForBuilds(CommandQueue::Graphics, token) before the TLAS build.
+    class IBlasBuildQueue : public IResource
+    {
+    public:
+        // Queues a BLAS build. The geometry descriptors are copied, and the BLAS and the geometry buffers are kept alive
+        // until the build has finished executing. Thread-safe. Returns c_InvalidBuildToken if the arguments are invalid.
+        virtual BuildToken build(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
+        // Queues an update of a BLAS built with AllowUpdate, with new vertex data and otherwise the same geometry.
+        // Same as build(...) with the PerformUpdate flag added.
+        virtual BuildToken refit(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
+        // Records the pending requests, up to BlasBuildQueueDesc::maxBuildsPerSubmit, into a command list and executes it.
+        // Call this once per frame from a thread that is allowed to execute command lists.
+        // Returns the token of the last submitted request, or c_InvalidBuildToken if nothing was pending.
+        virtual BuildToken submitPendingBuilds() = 0;
+
+        // Returns true when the request has finished executing on the GPU.
+        virtual bool isBuildComplete(BuildToken token) = 0;
+
+        // Makes 'waitQueue' wait on the GPU until the request has finished executing, without blocking the CPU.
+        // Returns false and doesn't insert a wait if the request hasn't been submitted yet.
+        virtual bool queueWaitForBuilds(CommandQueue waitQueue, BuildToken token) = 0;
+
+        // Returns the number of queued requests that haven't been submitted yet.
+        virtual size_t getPendingBuildCount() = 0;
+    };
+
+    typedef RefCountPtr<IBlasBuildQueue> BlasBuildQueueHandle;
+
+    NVRHI_API BlasBuildQueueHandle createBlasBuildQueue(IDevice* device, const BlasBuildQueueDesc& desc = BlasBuildQueueDesc());
+}
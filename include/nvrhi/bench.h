@@ -0,0 +1,138 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <string>
+#include <vector>
+
+namespace nvrhi::bench
+{
+    // One measured operation. Times are per iteration.
+    struct BenchmarkResult
+    {
+        std::string name;
+        uint32_t iterations = 0;
+
+        // GPU execution time measured with timestamps, 0 if the device doesn't support timestamp query pools.
+        double gpuMillisecondsMin = 0.0;
+        double gpuMillisecondsAvg = 0.0;
+
+        // CPU time spent in the recording calls.
+        double cpuMillisecondsMin = 0.0;
+        double cpuMillisecondsAvg = 0.0;
+
+        // Number of API calls measured in one iteration, 0 if the iteration is a single operation.
+        uint64_t operationsPerIteration = 0;
+
+        // Memory used by the results of the operation and by its scratch buffers, 0 if it's not known.
+        uint64_t resultBytes = 0;
+        uint64_t scratchBytes = 0;
+
+        // Non-empty if the operation was not measured, e.g. because the device doesn't support it.
+        std::string skipReason;
+    };
+
+    struct BenchmarkReport
+    {
+        std::string suite;
+        std::string graphicsAPI;
+        std::vector<BenchmarkResult> results;
+    };
+
+    // Writes the report as a JSON object with the 'suite', 'graphicsAPI' and 'results' fields,
+    // where the results are objects with the field names of BenchmarkResult.
+    std::string writeReportJson(const BenchmarkReport& report);
+
+    struct RayTracingBenchmarkDesc
+    {
+        // Synthetic geometry: each BLAS is a grid of triangles, the TLAS instances reference the BLASes in turn.
+        uint32_t blasCount = 16;
+        uint32_t trianglesPerBlas = 64 * 1024;
+        uint32_t instanceCount = 16 * 1024;
+        uint32_t iterations = 8;
+
+        // Opacity micromaps with 4-state data at this subdivision level, one per OMM index, shared by the triangles.
+        uint32_t ommCount = 1024;
+        uint32_t ommSubdivisionLevel = 4;
+
+        // Cluster operation to measure with executeMultiIndirectClusterOperation. Its indirect arguments are
+        // in the API-specific layout, so the input and output buffers are prepared by the application.
+        // The cluster benchmark is skipped when this is null.
+        const rt::cluster::OperationDesc* clusterOperation = nullptr;
+
+        RayTracingBenchmarkDesc& setBlasCount(uint32_t value) { blasCount = value; return *this; }
+        RayTracingBenchmarkDesc& setTrianglesPerBlas(uint32_t value) { trianglesPerBlas = value; return *this; }
+        RayTracingBenchmarkDesc& setInstanceCount(uint32_t value) { instanceCount = value; return *this; }
+        RayTracingBenchmarkDesc& setIterations(uint32_t value) { iterations = value; return *this; }
+        RayTracingBenchmarkDesc& setOmmCount(uint32_t value) { ommCount = value; return *this; }
+        RayTracingBenchmarkDesc& setOmmSubdivisionLevel(uint32_t value) { ommSubdivisionLevel = value; return *this; }
+        RayTracingBenchmarkDesc& setClusterOperation(const rt::cluster::OperationDesc* value) { clusterOperation = value; return *this; }
+    };
+
+    // Measures BLAS builds, refits and compaction, TLAS builds including the CPU-side instance conversion,
+    // OMM builds and, optionally, a cluster operation on the device's graphics queue. The device must be idle,
+    // the function waits for the GPU after every iteration.
+    BenchmarkReport runRayTracingBenchmarks(IDevice* device, const RayTracingBenchmarkDesc& desc = RayTracingBenchmarkDesc());
+
+    struct CpuBenchmarkDesc
+    {
+        uint32_t iterations = 16;
+
+        // Number of API calls in one iteration of each benchmark.
+        uint32_t drawsPerIteration = 10000;
+        uint32_t bindingSetsPerIteration = 1000;
+        uint32_t bufferWritesPerIteration = 1000;
+        uint32_t descriptorTableSize = 4096;
+        uint32_t commandListsPerIteration = 64;
+
+        // The texture state benchmark transitions each array slice of every texture separately.
+        uint32_t textureCount = 256;
+        uint32_t textureArraySize = 16;
+
+        // State used by the setGraphicsState + drawIndexed benchmarks. The pipeline and its shaders are
+        // API-specific, so the state is prepared by the application; it must include an index buffer.
+        // The draw benchmarks are skipped when this is null.
+        const GraphicsState* graphicsState = nullptr;
+        DrawArguments drawArguments = DrawArguments().setVertexCount(3);
+
+        CpuBenchmarkDesc& setIterations(uint32_t value) { iterations = value; return *this; }
+        CpuBenchmarkDesc& setDrawsPerIteration(uint32_t value) { drawsPerIteration = value; return *this; }
+        CpuBenchmarkDesc& setBindingSetsPerIteration(uint32_t value) { bindingSetsPerIteration = value; return *this; }
+        CpuBenchmarkDesc& setBufferWritesPerIteration(uint32_t value) { bufferWritesPerIteration = value; return *this; }
+        CpuBenchmarkDesc& setDescriptorTableSize(uint32_t value) { descriptorTableSize = value; return *this; }
+        CpuBenchmarkDesc& setCommandListsPerIteration(uint32_t value) { commandListsPerIteration = value; return *this; }
+        CpuBenchmarkDesc& setTextureCount(uint32_t value) { textureCount = value; return *this; }
+        CpuBenchmarkDesc& setTextureArraySize(uint32_t value) { textureArraySize = value; return *this; }
+        CpuBenchmarkDesc& setGraphicsState(const GraphicsState* value) { graphicsState = value; return *this; }
+        CpuBenchmarkDesc& setDrawArguments(const DrawArguments& value) { drawArguments = value; return *this; }
+    };
+
+    // Measures the CPU cost of the RHI hot paths: setGraphicsState + drawIndexed with redundant and changing state,
+    // createBindingSet, writeBuffer on volatile and static buffers, setTextureState + commitBarriers,
+    // descriptor table allocation and writes, and executeCommandLists. Only the API calls are timed, the GPU work
+    // is waited for between iterations. Run it on a device from nvrhi::null::createDevice to measure NVRHI
+    // without the driver's share of the cost.
+    BenchmarkReport runCpuBenchmarks(IDevice* device, const CpuBenchmarkDesc& desc = CpuBenchmarkDesc());
+}
@@ -0,0 +1,95 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <string>
+#include <vector>
+
+// The capture layer records the calls made to a device and its command lists into a binary trace file,
+// and replayCapture re-executes such a trace on any device, to reproduce CPU and GPU performance problems offline.
+//
+// Captured calls:
+// - Creation of textures, buffers, staging textures, samplers, shaders, input layouts, binding layouts,
+//   binding sets, framebuffers, graphics, compute and meshlet pipelines (including the async versions)
+//   and command lists. Native textures and buffers are replaced with regular resources on replay.
+// - The contents of writeBuffer, writeTexture and writeTextureRegions calls, and of write-mapped buffers
+//   on unmapBuffer and flushMappedRange.
+// - Command list recording: clears, copies, state setup, draws, dispatches, markers and state tracking.
+// - executeCommandLists and executeSubmitGraph, which is replayed as plain submissions in graph order,
+//   and runGarbageCollection, which marks the end of a frame.
+//
+// Other calls, such as ray tracing, queries, bindless descriptor tables, indirect command layouts
+// and command bundles, are forwarded to the device and recorded by name only. The replay skips them,
+// and objects created by them are missing on replay. Object destruction is not recorded, so the replay
+// keeps all objects alive until it finishes.
+
+namespace nvrhi::capture
+{
+    struct CaptureLayerDesc
+    {
+        // Path of the trace file, which is created or overwritten by createCaptureLayer
+        std::string fileName;
+
+        // Record the data written into resources by the application. Without it, traces are much smaller
+        // and keep the same command stream, but the replay renders from uninitialized resources.
+        bool captureResourceContents = true;
+
+        CaptureLayerDesc& setFileName(const std::string& value) { fileName = value; return *this; }
+        CaptureLayerDesc& setCaptureResourceContents(bool value) { captureResourceContents = value; return *this; }
+    };
+
+    // Returns nullptr if the trace file cannot be created. The file is complete when the returned device
+    // is destroyed, and it is flushed on every runGarbageCollection call before that.
+    NVRHI_API DeviceHandle createCaptureLayer(IDevice* underlyingDevice, const CaptureLayerDesc& desc);
+
+    struct ReplayDesc
+    {
+        // Call waitForIdle at the end of every frame, so that the frame times include the GPU work.
+        bool waitForIdleEveryFrame = true;
+
+        ReplayDesc& setWaitForIdleEveryFrame(bool value) { waitForIdleEveryFrame = value; return *this; }
+    };
+
+    struct ReplayStatistics
+    {
+        // Calls that were executed, and calls that the capture layer only recorded by name
+        uint64_t replayedCalls = 0;
+        uint64_t skippedCalls = 0;
+
+        // References to objects that were not created through the capture layer or failed to be created on replay
+        uint64_t missingObjects = 0;
+
+        uint64_t executedCommandLists = 0;
+
+        // CPU time of every frame of the trace, and of the whole replay including resource creation
+        std::vector<double> frameMilliseconds;
+        double totalMilliseconds = 0.0;
+    };
+
+    // Replays a trace file written by the capture layer on 'device'. Returns false if the file cannot be read,
+    // was written by a different NVRHI version, or is truncated; errors are reported to the message callback
+    // of the device. 'outStatistics' is filled in also when the replay fails.
+    NVRHI_API bool replayCapture(IDevice* device, const char* fileName, const ReplayDesc& desc = ReplayDesc(),
+        ReplayStatistics* outStatistics = nullptr);
+}
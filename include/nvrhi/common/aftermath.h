@@ -29,6 +29,11 @@
 #include <set>
 #include <unordered_map>
 #include <filesystem>
+#include <array>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace nvrhi
 {
@@ -41,6 +46,26 @@ namespace nvrhi
     // we want the marker payloads to represent the whole "stack" of regimes, not just the last one
     // AftermathMarkerTracker pushes/pops regimes to this stack
     // The payload itself is a 64bit value, so AftermathMarkerTracker stores the mappings of strings<->hashes
+    // AftermathMarkerNameRegistry interns the marker names used by the compact marker mode, see
+    // AftermathCrashDumpHelper::setCompactMarkers. Each distinct name is copied once and given a 32-bit ID.
+    // Names are identified by their hash, like the marker payloads of the full mode.
+    class AftermathMarkerNameRegistry
+    {
+    public:
+        uint32_t intern(std::string_view name, size_t nameHash);
+        bool getName(uint32_t id, std::string& outName) const;
+    private:
+        mutable std::mutex m_Mutex;
+        std::unordered_map<size_t, uint32_t> m_IdsByHash;
+        std::vector<std::string> m_Names;
+    };
+
+    // Aftermath will return the payload of the last marker the GPU executed, so in cases of nested regimes,
+    // we want the marker payloads to represent the whole "stack" of regimes, not just the last one
+    // AftermathMarkerTracker pushes/pops regimes to this stack
+    // The payload itself is a 64bit value, so AftermathMarkerTracker stores the mappings of strings<->hashes
+    // In the compact mode, the tracker stores (payload, parent payload, name ID) records in a fixed-size table
+    // instead, and the "a/b/c" strings are only built when a crash dump is decoded
     // There should be one AftermathMarkerTracker per graphics API-level command list
     class AftermathMarkerTracker
     {
@@ -51,7 +76,12 @@ namespace nvrhi
         void popEvent();
 
         ResolvedMarker getEventString(size_t hash);
+
+        // Switches the tracker to the compact mode when a registry is provided, called by AftermathCrashDumpHelper
+        void setNameRegistry(AftermathMarkerNameRegistry* registry);
     private:
+        size_t pushCompactEvent(const char* name);
+
         // using a filesystem path to track the event stack since that automatically inserts "/" separators
         // and is easy to push/pop entries
         std::filesystem::path m_EventStack;
@@ -62,6 +92,33 @@ namespace nvrhi
         std::array<size_t, MaxEventStrings> m_EventHashes;
         size_t m_OldestHashIndex;
         std::unordered_map<size_t, std::string> m_EventStrings;
+
+        // Compact mode state. The records are indexed by payload, so that a repeated marker costs one compare,
+        // and the name cache keeps the hot path away from the registry mutex after the first use of a name.
+        struct CompactRecord
+        {
+            size_t payload = 0;
+            size_t parentPayload = 0;
+            uint32_t nameId = 0;
+        };
+
+        struct CachedName
+        {
+            size_t nameHash = 0;
+            uint32_t nameId = 0;
+            bool valid = false;
+        };
+
+        static constexpr size_t MaxCompactRecords = 256;
+        static constexpr size_t NameCacheSize = 64;
+        static constexpr uint32_t MaxCompactStackDepth = 64;
+
+        AftermathMarkerNameRegistry* m_NameRegistry = nullptr;
+        std::array<CompactRecord, MaxCompactRecords> m_CompactRecords;
+        std::array<CachedName, NameCacheSize> m_NameCache;
+        std::array<size_t, MaxCompactStackDepth> m_PayloadStack{};
+        uint32_t m_StackDepth = 0;
+        std::string m_ResolvedString;
     };
 
     // AftermathCrashDumpHelper tracks all nvrhi::IDevice-level constructs that we need when generating a crash dump
@@ -74,6 +131,10 @@ namespace nvrhi
     {
     public:
         AftermathCrashDumpHelper();
+
+        // Enables the compact marker mode for the trackers registered after this call. It is set by the device
+        // from DeviceDesc::aftermathCompactMarkers before any command lists are created.
+        void setCompactMarkers(bool enable) { m_CompactMarkers = enable; }
         
         void registerAftermathMarkerTracker(AftermathMarkerTracker* tracker);
         void unRegisterAftermathMarkerTracker(AftermathMarkerTracker* tracker);
@@ -88,5 +149,7 @@ namespace nvrhi
         // so we keep around a small number of recently destroyed marker trackers just in case
         std::deque<AftermathMarkerTracker> m_DestroyedMarkerTrackers;
         std::unordered_map<void*, ShaderBinaryLookupCallback> m_ShaderBinaryLookupCallbacks;
+        AftermathMarkerNameRegistry m_MarkerNames;
+        bool m_CompactMarkers = false;
     };
 } // namespace nvrhi
\ No newline at end of file
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 #include <cassert>
 
 namespace nvrhi 
@@ -69,6 +70,20 @@ namespace nvrhi
         return uint32_t(hash) ^ (uint32_t(hash >> 32));
     }
 
+    // 64-bit FNV-1a hash of a block of memory. Unlike std::hash, the result is the same across runs and platforms,
+    // which makes it suitable for keys that are stored persistently.
+    inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
     // A type cast that is safer than static_cast in debug builds, and is a simple static_cast in release builds.
     // Used for downcasting various ISomething* pointers to their implementation classes in the backends.
     template <typename T, typename U>
@@ -63,6 +63,8 @@ namespace nvrhi
         constexpr ObjectType D3D12_RootSignature                    = 0x00020009;
         constexpr ObjectType D3D12_PipelineState                    = 0x0002000a;
         constexpr ObjectType D3D12_CommandAllocator                 = 0x0002000b;
+        constexpr ObjectType D3D12_Fence                            = 0x0002000c;
+        constexpr ObjectType D3D12_CommandSignature                 = 0x0002000d;
 
         constexpr ObjectType VK_Device                              = 0x00030001;
         constexpr ObjectType VK_PhysicalDevice                      = 0x00030002;
@@ -87,6 +89,8 @@ namespace nvrhi
         constexpr ObjectType VK_Pipeline                            = 0x00030013;
         constexpr ObjectType VK_Micromap                            = 0x00030014;
         constexpr ObjectType VK_ImageCreateInfo                     = 0x00030015;
+        constexpr ObjectType VK_Semaphore                           = 0x00030016;
+        constexpr ObjectType VK_IndirectCommandsLayoutEXT           = 0x00030017;
     };
 
     struct Object
@@ -42,6 +42,17 @@ namespace nvrhi::d3d11
         IMessageCallback* messageCallback = nullptr;
         ID3D11DeviceContext* context = nullptr;
         bool aftermathEnabled = false;
+        bool aftermathCompactMarkers = false; // see AftermathCrashDumpHelper::setCompactMarkers
+
+        // Number of threads used by the create...PipelineAsync functions, 0 means half of the CPU cores
+        uint32_t numPipelineCompileThreads = 0;
+
+        // Size of the dynamic constant buffer that volatile constant buffer writes are sub-allocated from.
+        // The ring is written with D3D11_MAP_WRITE_NO_OVERWRITE and only discarded when the writes wrap around,
+        // and the volatile buffers are bound with *SetConstantBuffers1 offsets into it. Requires D3D11.1 constant
+        // buffer offsetting and no-overwrite maps of constant buffers; without them, or when this is 0,
+        // each volatile buffer is renamed with D3D11_MAP_WRITE_DISCARD on every write.
+        uint32_t volatileConstantRingSize = 0;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
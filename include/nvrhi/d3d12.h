@@ -118,6 +118,9 @@ namespace nvrhi::d3d12
         uint32_t samplerHeapSize = 1024;
         uint32_t maxTimerQueries = 256;
 
+        // Number of threads used by the create...PipelineAsync functions, 0 means half of the CPU cores
+        uint32_t numPipelineCompileThreads = 0;
+
         // If enabled and the device has the capability,
         // create RootSignatures with D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED 
         // and D3D12_ROOT_SIGNATURE_FLAG_SAMPLER_HEAP_DIRECTLY_INDEXED
@@ -125,9 +128,49 @@ namespace nvrhi::d3d12
 
         bool aftermathEnabled = false;
 
+        // Stores Aftermath markers as interned name IDs in fixed-size per-command-list tables instead of
+        // full marker path strings, which makes beginMarker cheap enough for production builds.
+        // The marker strings are rebuilt when AftermathCrashDumpHelper::ResolveMarker is called.
+        bool aftermathCompactMarkers = false;
+
+        // If enabled and the driver supports enhanced barriers (D3D12_FEATURE_D3D12_OPTIONS12), the automatic
+        // barriers on graphics and compute command lists are issued through ID3D12GraphicsCommandList7::Barrier
+        // instead of the legacy resource state transitions. Copy command lists always use legacy barriers.
+        bool enableEnhancedBarriers = false;
+
         // Enable logging the buffer lifetime to IMessageCallback
         // Useful for debugging resource lifetimes
         bool logBufferLifetime = false;
+
+        // Makes createShader return the existing shader when it is called again with the same bytecode and
+        // settings, e.g. when many materials load the same permutation. Shaders stay in the cache until
+        // runGarbageCollection finds that the application and the pipelines no longer reference them.
+        bool enableShaderCache = false;
+
+        // Makes createSampler, createInputLayout and createBindingLayout return the existing object when one
+        // with an identical description is alive. This keeps the sampler count under the heap limit when many
+        // materials use the same states, and lets identical layouts share a root signature.
+        bool enableStateObjectInterning = false;
+
+        // Optional contents of the pipeline library, as previously returned by IDevice::getPipelineCacheData.
+        // Data from a different device or driver is discarded and an empty library is created instead.
+        const void* pipelineCacheData = nullptr;
+        size_t pipelineCacheDataSize = 0;
+
+        // Size of the upload ring buffer created for each queue when the first command list with
+        // CommandListParameters::useSharedUploadRing uploads data. This is the cap on the upload memory
+        // shared by those command lists; 0 disables the rings.
+        uint64_t uploadRingSize = 64 * 1024 * 1024;
+
+        // Size of the chunks that command lists claim from the upload ring and sub-allocate from without locking.
+        uint64_t uploadRingChunkSize = 256 * 1024;
+
+        // Budget for the AS build scratch pool created for each queue, used by the command lists with
+        // CommandListParameters::useSharedScratchPool. 0 disables the pools.
+        uint64_t scratchPoolMaxMemory = 256 * 1024 * 1024;
+
+        // Minimum size of the chunks in the scratch pools. Larger chunks are created for builds that need more.
+        uint64_t scratchPoolChunkSize = 4 * 1024 * 1024;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
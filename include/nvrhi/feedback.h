@@ -0,0 +1,117 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::feedback
+{
+    struct FeedbackReaderDesc
+    {
+        // Number of readback buffers in the ring, i.e. the number of decode batches that can be in flight at once
+        uint32_t numSlots = 3;
+
+        // Maximum number of feedback textures decoded by one recordDecode call
+        uint32_t maxTexturesPerBatch = 32;
+
+        // Size of each readback buffer. The decoded feedback of a batch is packed into one buffer,
+        // so this also limits the amount of data read back per batch.
+        uint64_t readbackBufferSize = 4 * 1024 * 1024;
+
+        // Queue that the command lists with the decodes are executed on
+        CommandQueue queue = CommandQueue::Graphics;
+
+        std::string debugName;
+
+        FeedbackReaderDesc& setNumSlots(uint32_t value) { numSlots = value; return *this; }
+        FeedbackReaderDesc& setMaxTexturesPerBatch(uint32_t value) { maxTexturesPerBatch = value; return *this; }
+        FeedbackReaderDesc& setReadbackBufferSize(uint64_t value) { readbackBufferSize = value; return *this; }
+        FeedbackReaderDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        FeedbackReaderDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Identifies a feedback texture registered with the reader. IDs are never reused.
+    typedef uint32_t FeedbackTextureId;
+    constexpr FeedbackTextureId c_InvalidFeedbackTexture = 0;
+
+    // The decoded MinMip feedback of one texture. 'minMips' has one byte per mip region of the paired texture,
+    // holding the most detailed mip level sampled in the region, or 0xFF if the region was not sampled.
+    // Rows are 'rowPitch' bytes apart, which is a multiple of 256 like the rows of texture copies on D3D12.
+    struct FeedbackResult
+    {
+        FeedbackTextureId id = c_InvalidFeedbackTexture;
+        ISamplerFeedbackTexture* feedbackTexture = nullptr;
+        const uint8_t* minMips = nullptr;
+        uint32_t widthInRegions = 0;
+        uint32_t heightInRegions = 0;
+        size_t rowPitch = 0;
+        // Increments with every recordDecode call, identifies which batch the result came from
+        uint64_t batchIndex = 0;
+    };
+
+    // Receives the decoded feedback. A typical implementation compares the requested mips with the resident tiles
+    // of the paired texture, maps the missing tiles with nvrhi::tiles::ITilePool::mapTile, uploads their contents
+    // with nvrhi::streaming::IStreamingService, and frees the tiles of regions that haven't been sampled for a while.
+    class IFeedbackListener
+    {
+    public:
+        virtual ~IFeedbackListener() = default;
+
+        // The data is only valid during the call.
+        virtual void onFeedback(const FeedbackResult& result) = 0;
+    };
+
+    // Decodes the MinMip sampler feedback of many textures on a rotating schedule, a bounded number of textures per
+    // batch, and reads the results back into one packed buffer per batch. None of the functions wait for the GPU:
+    // results are delivered once the batch has finished executing, usually a few frames later.
+    // The feedback textures are cleared after decoding, so each result covers the sampling since the texture's
+    // previous decode. Only supported on devices with Feature::SamplerFeedback. The functions are thread-safe.
+    class ISamplerFeedbackReader : public IResource
+    {
+    public:
+        // Registers a feedback texture with the MinMipOpaque format. Returns c_InvalidFeedbackTexture on failure.
+        virtual FeedbackTextureId addTexture(ISamplerFeedbackTexture* feedbackTexture) = 0;
+
+        // Unregisters a texture. Results of batches that are still in flight are dropped.
+        virtual void removeTexture(FeedbackTextureId id) = 0;
+
+        // Records the decoding, readback and clearing of the next textures in the rotation into the command list.
+        // Returns the number of recorded textures, which is 0 when every readback buffer is in flight or waiting
+        // for processResults.
+        virtual uint32_t recordDecode(ICommandList* commandList) = 0;
+
+        // Marks the batch recorded since the previous call as submitted. Call it right after the command list
+        // with the decodes has been executed on FeedbackReaderDesc::queue.
+        virtual void markSubmitted() = 0;
+
+        // Passes the results of all finished batches to the listener, oldest batch first, and makes their readback
+        // buffers available for new batches. Returns the number of delivered results.
+        // The listener may call the other functions of the reader.
+        virtual uint32_t processResults(IFeedbackListener& listener) = 0;
+    };
+
+    typedef RefCountPtr<ISamplerFeedbackReader> SamplerFeedbackReaderHandle;
+
+    NVRHI_API SamplerFeedbackReaderHandle createSamplerFeedbackReader(IDevice* device,
+        const FeedbackReaderDesc& desc = FeedbackReaderDesc());
+}
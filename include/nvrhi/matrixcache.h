@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::coopvec
+{
+    struct MatrixCacheDesc
+    {
+        // Size of the buffers that the converted matrices are sub-allocated from.
+        // Matrices larger than this get a buffer of their own.
+        uint64_t poolBufferSize = 16 * 1024 * 1024;
+
+        std::string debugName;
+
+        MatrixCacheDesc& setPoolBufferSize(uint64_t value) { poolBufferSize = value; return *this; }
+        MatrixCacheDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Location of a converted matrix in the pool. The pool buffers are created with canHaveRawViews and canHaveUAVs,
+    // and are kept in the ShaderResource state between command lists.
+    struct CachedMatrix
+    {
+        IBuffer* buffer = nullptr;
+        uint64_t offset = 0;
+        size_t size = 0;
+
+        [[nodiscard]] bool isValid() const { return buffer != nullptr; }
+    };
+
+    struct MatrixCacheStatistics
+    {
+        uint32_t numMatrices = 0;
+        uint32_t pendingConversions = 0;
+        uint64_t cacheHits = 0;
+        uint64_t cacheMisses = 0;
+        uint64_t poolBytes = 0;
+        uint64_t usedBytes = 0;
+    };
+
+    // Keeps converted Cooperative Vector matrices, such as network weights in the inferencing-optimal layout,
+    // so that loading the same weights again doesn't convert them again. Matrices are identified by their source
+    // buffer range, data types, layouts and dimensions, and by an application-defined content version that should
+    // change when new data is written into the source range, e.g. when a network is hot-reloaded.
+    // Only one version of each matrix is kept: requesting a different content version converts the new data into
+    // the memory of the previous version, so hot-reloading doesn't grow the pool.
+    // All conversions requested between two recordPendingConversions calls are recorded with one
+    // ICommandList::convertCoopVecMatrices call. The functions are thread-safe.
+    class IMatrixCache : public IResource
+    {
+    public:
+        // Returns the location of the converted matrix. On a cache miss, the destination memory is allocated from
+        // the pool and the conversion is queued: the matrix contents are only valid after the command list passed
+        // to the next recordPendingConversions call has executed. 'src.size' must be set.
+        // The cache keeps a reference to the source buffer until the matrix is evicted.
+        // When 'contentVersion' differs from the cached one, the previous contents of the returned location are
+        // overwritten by the conversion, like after evict(), and the location stays the same.
+        // Returns an invalid location if the device doesn't support the conversion or the pool cannot grow.
+        virtual CachedMatrix getConvertedMatrix(const MatrixLayoutDesc& src, uint32_t numRows, uint32_t numColumns,
+            DataType dstType, MatrixLayout dstLayout, uint64_t contentVersion = 0) = 0;
+
+        // Records all queued conversions into the command list. Returns the number of recorded conversions.
+        virtual uint32_t recordPendingConversions(ICommandList* commandList) = 0;
+
+        // Removes the cached matrices converted from 'sourceBuffer', or all matrices if it's nullptr.
+        // Their pool memory is reused by later conversions. These are ordered after the earlier work on their queue
+        // by the barriers before the conversion; matrices used on other queues must be synchronized by the application.
+        virtual void evict(IBuffer* sourceBuffer = nullptr) = 0;
+
+        virtual MatrixCacheStatistics getStatistics() = 0;
+    };
+
+    typedef RefCountPtr<IMatrixCache> MatrixCacheHandle;
+
+    NVRHI_API MatrixCacheHandle createMatrixCache(IDevice* device, const MatrixCacheDesc& desc = MatrixCacheDesc());
+}
@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::null
+{
+    // The null device implements the NVRHI interfaces without a GPU: resource creation, state tracking,
+    // binding set bookkeeping and upload buffer management run through the same logic as in the other backends,
+    // but no native API calls are made and no GPU work is done. Command lists complete as soon as they are executed.
+    // It is meant for measuring the CPU overhead of NVRHI itself and for running applications on machines
+    // without a GPU. Texture and buffer contents are not stored, except for the CPU-accessible buffers and
+    // staging textures, whose memory can be mapped.
+    struct DeviceDesc
+    {
+        IMessageCallback* messageCallback = nullptr;
+
+        // Number of threads used by the create...PipelineAsync functions, 0 means half of the CPU cores
+        uint32_t numPipelineCompileThreads = 0;
+
+        // The device reports these queues as available, see IDevice::createCommandList
+        bool enableComputeQueue = true;
+        bool enableCopyQueue = true;
+
+        // Deduplicates shaders and specializations like the shader caches of the other backends
+        bool enableShaderCache = false;
+
+        // Shares the samplers, input layouts and binding layouts created from identical descriptions
+        bool enableStateObjectInterning = false;
+    };
+
+    NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
+}
@@ -64,7 +64,7 @@ namespace nvrhi
 {
     // Version of the public API provided by NVRHI.
     // Increment this when any changes to the API are made.
-    static constexpr uint32_t c_HeaderVersion = 23;
+    static constexpr uint32_t c_HeaderVersion = 70;
 
     // Verifies that the version of the implementation matches the version of the header.
     // Returns true if they match. Use this when initializing apps using NVRHI as a shared library.
@@ -77,6 +77,8 @@ namespace nvrhi
     static constexpr uint32_t c_MaxBindlessRegisterSpaces = 16;
     static constexpr uint32_t c_MaxVolatileConstantBuffersPerLayout = 6;
     static constexpr uint32_t c_MaxVolatileConstantBuffers = 32;
+    static constexpr uint32_t c_MaxPushDescriptorsPerLayout = 8; // D3D12: every root descriptor takes 2 DWORDs of the root signature
+    static constexpr uint32_t c_MaxMemoryHeaps = 16; // VK_MAX_MEMORY_HEAPS
     static constexpr uint32_t c_MaxPushConstantSize = 128; // D3D12: root signature is 256 bytes max., Vulkan: 128 bytes of push constants guaranteed
     static constexpr uint32_t c_ConstantBufferOffsetSizeAlignment = 256; // Partially bound constant buffers must have offsets aligned to this and sizes multiple of this
 
@@ -154,7 +156,8 @@ namespace nvrhi
     {
         D3D11,
         D3D12,
-        VULKAN
+        VULKAN,
+        NONE // The null device, see nvrhi/null.h
     };
 
     enum class Format : uint8_t
@@ -374,6 +377,7 @@ namespace nvrhi
         OpacityMicromapBuildInput   = 0x00400000,
         ConvertCoopVecMatrixInput   = 0x00800000,
         ConvertCoopVecMatrixOutput  = 0x01000000,
+        Predication                 = 0x02000000,
     };
 
     NVRHI_ENUM_CLASS_FLAG_OPERATORS(ResourceStates)
@@ -494,6 +498,22 @@ namespace nvrhi
         constexpr TextureSlice& setArraySlice(ArraySlice slice) { arraySlice = slice; return *this; }
     };
 
+    // One subresource or a box within it uploaded by ICommandList::writeTextureRegions.
+    // The default slice size covers the whole subresource, so a slice with a non-zero origin needs an explicit size.
+    // The data starts at the origin of the box, with the same row and depth pitch rules as writeTexture.
+    struct TextureUploadRegion
+    {
+        TextureSlice slice;
+        const void* data = nullptr;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+
+        constexpr TextureUploadRegion& setSlice(const TextureSlice& value) { slice = value; return *this; }
+        constexpr TextureUploadRegion& setData(const void* value) { data = value; return *this; }
+        constexpr TextureUploadRegion& setRowPitch(size_t value) { rowPitch = value; return *this; }
+        constexpr TextureUploadRegion& setDepthPitch(size_t value) { depthPitch = value; return *this; }
+    };
+
     struct TextureSubresourceSet
     {
         static constexpr MipLevel AllMipLevels = MipLevel(-1);
@@ -582,6 +602,14 @@ namespace nvrhi
         IHeap* heap = nullptr;
     };
 
+    // Tile mappings of one texture in a batch, see IDevice::updateTextureTileMappingsBatch(...)
+    struct TextureTilesMappingUpdate
+    {
+        ITexture* texture = nullptr;
+        const TextureTilesMapping* tileMappings = nullptr;
+        uint32_t numTileMappings = 0;
+    };
+
     struct PackedMipDesc
     {
         uint32_t numStandardMips = 0;
@@ -651,6 +679,18 @@ namespace nvrhi
         constexpr VertexAttributeDesc& setOffset(uint32_t value) { offset = value; return *this; }
         constexpr VertexAttributeDesc& setElementStride(uint32_t value) { elementStride = value; return *this; }
         constexpr VertexAttributeDesc& setIsInstanced(bool value) { isInstanced = value; return *this; }
+
+        bool operator ==(const VertexAttributeDesc& b) const
+        {
+            return name == b.name
+                && format == b.format
+                && arraySize == b.arraySize
+                && bufferIndex == b.bufferIndex
+                && offset == b.offset
+                && elementStride == b.elementStride
+                && isInstanced == b.isInstanced;
+        }
+        bool operator !=(const VertexAttributeDesc& b) const { return !(*this == b); }
     };
 
     class IInputLayout : public IResource
@@ -670,7 +710,7 @@ namespace nvrhi
     {
         uint64_t byteSize = 0;
         uint32_t structStride = 0; // if non-zero it's structured
-        uint32_t maxVersions = 0; // only valid and required to be nonzero for volatile buffers on Vulkan
+        uint32_t maxVersions = 0; // only valid and required to be nonzero for volatile buffers on Vulkan, unless the volatile constant ring is used
         std::string debugName;
         Format format = Format::UNKNOWN; // for typed buffer views
         bool canHaveUAVs = false;
@@ -684,6 +724,9 @@ namespace nvrhi
         bool isAccelStructStorage = false;
         bool isShaderBindingTable = false;
 
+        // The buffer can be used as the source of ICommandList::beginPredication
+        bool isPredicationBuffer = false;
+
         // A dynamic/upload buffer whose contents only live in the current command list
         bool isVolatile = false;
 
@@ -716,6 +759,7 @@ namespace nvrhi
         constexpr BufferDesc& setIsAccelStructBuildInput(bool value) { isAccelStructBuildInput = value; return *this; }
         constexpr BufferDesc& setIsAccelStructStorage(bool value) { isAccelStructStorage = value; return *this; }
         constexpr BufferDesc& setIsShaderBindingTable(bool value) { isShaderBindingTable = value; return *this; }
+        constexpr BufferDesc& setIsPredicationBuffer(bool value) { isPredicationBuffer = value; return *this; }
         constexpr BufferDesc& setIsVolatile(bool value) { isVolatile = value; return *this; }
         constexpr BufferDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
         constexpr BufferDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
@@ -1258,6 +1302,21 @@ namespace nvrhi
         SamplerDesc& setAddressW(SamplerAddressMode mode) { addressW = mode; return *this; }
         SamplerDesc& setAllAddressModes(SamplerAddressMode mode) { addressU = addressV = addressW = mode; return *this; }
         SamplerDesc& setReductionType(SamplerReductionType type) { reductionType = type; return *this; }
+
+        bool operator ==(const SamplerDesc& b) const
+        {
+            return borderColor == b.borderColor
+                && maxAnisotropy == b.maxAnisotropy
+                && mipBias == b.mipBias
+                && minFilter == b.minFilter
+                && magFilter == b.magFilter
+                && mipFilter == b.mipFilter
+                && addressU == b.addressU
+                && addressV == b.addressV
+                && addressW == b.addressW
+                && reductionType == b.reductionType;
+        }
+        bool operator !=(const SamplerDesc& b) const { return !(*this == b); }
     };
 
     class ISampler : public IResource
@@ -1719,6 +1778,10 @@ namespace nvrhi
             bool isTopLevel = false;
             bool isVirtual = false;
 
+            // Only applies when isTopLevel = true. Creates a GPU-resident buffer for topLevelMaxInstances instances
+            // that is owned by the TLAS and updated in ranges with ICommandList::updateTopLevelInstances(...).
+            bool persistentInstanceBuffer = false;
+
             AccelStructDesc& setTopLevelMaxInstances(size_t value) { topLevelMaxInstances = value; isTopLevel = true; return *this; }
             AccelStructDesc& addBottomLevelGeometry(const GeometryDesc& value) { bottomLevelGeometries.push_back(value); isTopLevel = false; return *this; }
             AccelStructDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
@@ -1726,6 +1789,46 @@ namespace nvrhi
             AccelStructDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
             AccelStructDesc& setIsTopLevel(bool value) { isTopLevel = value; return *this; }
             AccelStructDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+            AccelStructDesc& setPersistentInstanceBuffer(bool value) { persistentInstanceBuffer = value; return *this; }
+        };
+
+        // One BLAS build in a batch passed to ICommandList::buildBottomLevelAccelStructs(...).
+        // The geometry array is only read during the call.
+        struct BlasBuildDesc
+        {
+            IAccelStruct* accelStruct = nullptr;
+            const GeometryDesc* geometries = nullptr;
+            size_t numGeometries = 0;
+            AccelStructBuildFlags buildFlags = AccelStructBuildFlags::None;
+
+            BlasBuildDesc& setAccelStruct(IAccelStruct* value) { accelStruct = value; return *this; }
+            BlasBuildDesc& setGeometries(const GeometryDesc* value, size_t count) { geometries = value; numGeometries = count; return *this; }
+            BlasBuildDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
+        };
+
+        // Memory needed to build an acceleration structure, see IDevice::getAccelStructBuildSizes(...)
+        struct AccelStructBuildSizes
+        {
+            uint64_t resultSize = 0;
+            uint64_t buildScratchSize = 0;
+            uint64_t updateScratchSize = 0;
+        };
+
+        // Header at the start of the data written by ICommandList::serializeAccelStruct(...).
+        // DX12 and Vulkan use the same layout for these fields, the header is followed by driver-specific data.
+        struct AccelStructSerializedHeader
+        {
+            uint8_t driverIdentifier[32];
+            uint64_t serializedSize; // including the header
+            uint64_t deserializedSize; // memory required for the AS passed to deserializeAccelStruct(...)
+            uint64_t numBottomLevelHandles; // always 0 for BLASes
+        };
+
+        // Written by ICommandList::writeAccelStructSerializedSize(...)
+        struct AccelStructSerializedSizeInfo
+        {
+            uint64_t serializedSize;
+            uint64_t reserved; // undefined on Vulkan
         };
 
         //////////////////////////////////////////////////////////////////////////
@@ -1738,6 +1841,10 @@ namespace nvrhi
             [[nodiscard]] virtual const AccelStructDesc& getDesc() const = 0;
             [[nodiscard]] virtual bool isCompacted() const = 0;
             [[nodiscard]] virtual uint64_t getDeviceAddress() const = 0;
+
+            // Returns the persistent instance buffer of a TLAS created with persistentInstanceBuffer = true,
+            // or nullptr otherwise.
+            [[nodiscard]] virtual IBuffer* getInstanceBuffer() const = 0;
         };
 
         typedef RefCountPtr<IAccelStruct> AccelStructHandle;
@@ -1977,6 +2084,15 @@ namespace nvrhi
         constexpr VulkanBindingOffsets& setSamplerOffset(uint32_t value) { sampler = value; return *this; }
         constexpr VulkanBindingOffsets& setConstantBufferOffset(uint32_t value) { constantBuffer = value; return *this; }
         constexpr VulkanBindingOffsets& setUnorderedAccessViewOffset(uint32_t value) { unorderedAccess = value; return *this; }
+
+        constexpr bool operator ==(const VulkanBindingOffsets& b) const
+        {
+            return shaderResource == b.shaderResource
+                && sampler == b.sampler
+                && constantBuffer == b.constantBuffer
+                && unorderedAccess == b.unorderedAccess;
+        }
+        constexpr bool operator !=(const VulkanBindingOffsets& b) const { return !(*this == b); }
     };
 
     struct BindingLayoutDesc
@@ -2002,6 +2118,22 @@ namespace nvrhi
         //   an error.
         bool registerSpaceIsDescriptorSet = false;
 
+        // Push layouts are meant for small binding sets that change often, such as per-draw or per-dispatch buffers.
+        // Binding sets created with a push layout do not own descriptors in any heap or pool; the descriptors
+        // are written into the command list when the set is bound, which makes such sets cheap to create, 
+        // especially as transient sets (see ICommandList::createTransientBindingSet).
+        // - On Vulkan, the layout becomes a push descriptor set layout, and the descriptors are written with
+        //   vkCmdPushDescriptorSetKHR. Requires the VK_KHR_push_descriptor extension, see Feature::PushDescriptors;
+        //   when it's not available, the flag is ignored. Only one push layout may be used in a pipeline.
+        // - On DX12, single constant buffers, structured and raw buffer SRVs and UAVs, and acceleration structures
+        //   are bound as root descriptors. Other items are placed into descriptor tables as usual.
+        //   Note that root descriptors do not perform bounds checking, and constant buffer ranges must be
+        //   aligned to c_ConstantBufferOffsetSizeAlignment.
+        // - On DX11, the flag is ignored.
+        // Push layouts cannot contain volatile constant buffers, and may contain at most c_MaxPushDescriptorsPerLayout
+        // descriptors, not counting push constants.
+        bool usePushDescriptors = false;
+
         std::vector<BindingLayoutItem> bindings;
         VulkanBindingOffsets bindingOffsets;
 
@@ -2010,8 +2142,20 @@ namespace nvrhi
         BindingLayoutDesc& setRegisterSpaceIsDescriptorSet(bool value) { registerSpaceIsDescriptorSet = value; return *this; }
         // Shortcut for .setRegisterSpace(value).setRegisterSpaceIsDescriptorSet(true)
         BindingLayoutDesc& setRegisterSpaceAndDescriptorSet(uint32_t value) { registerSpace = value; registerSpaceIsDescriptorSet = true; return *this; }
+        BindingLayoutDesc& setUsePushDescriptors(bool value) { usePushDescriptors = value; return *this; }
         BindingLayoutDesc& addItem(const BindingLayoutItem& value) { bindings.push_back(value); return *this; }
         BindingLayoutDesc& setBindingOffsets(const VulkanBindingOffsets& value) { bindingOffsets = value; return *this; }
+
+        bool operator ==(const BindingLayoutDesc& b) const
+        {
+            return visibility == b.visibility
+                && registerSpace == b.registerSpace
+                && registerSpaceIsDescriptorSet == b.registerSpaceIsDescriptorSet
+                && usePushDescriptors == b.usePushDescriptors
+                && bindings == b.bindings
+                && bindingOffsets == b.bindingOffsets;
+        }
+        bool operator !=(const BindingLayoutDesc& b) const { return !(*this == b); }
     };
 
     // Bindless layouts allow applications to attach a descriptor table to an unbounded
@@ -2462,6 +2606,88 @@ namespace nvrhi
         constexpr RenderState& setSinglePassStereoState(const SinglePassStereoState& value) { singlePassStereo = value; return *this; }
     };
 
+    // Parts of the render state that a graphics pipeline can take from GraphicsState::dynamicRenderState
+    // instead of its RenderState, so that draws that only differ in these values can share one pipeline.
+    // Use IDevice::queryFeatureSupport(Feature::ExtendedDynamicState, &DynamicRenderStateFeatureInfo, ...)
+    // to find out which states are supported by the device.
+    // - On Vulkan, all states are supported through the extended dynamic state of Vulkan 1.3.
+    // - On DX12, PrimitiveTopology and ViewportCount are always supported, and DepthBias is supported when
+    //   the device reports DynamicDepthBiasSupported.
+    // - On DX11, all states are supported, the state objects are looked up when the values change.
+    enum class DynamicRenderState : uint16_t
+    {
+        None                = 0x0000,
+        // The primitive type may only change within its topology class: points, lines, triangles, or patches.
+        PrimitiveTopology   = 0x0001,
+        // The number of viewports and scissor rects is taken from GraphicsState::viewport.
+        // Without this flag, Vulkan pipelines use exactly one viewport.
+        ViewportCount       = 0x0002,
+        CullMode            = 0x0004,
+        FrontFace           = 0x0008,
+        DepthBias           = 0x0010,
+        DepthTestEnable     = 0x0020,
+        DepthWriteEnable    = 0x0040,
+        DepthCompareOp      = 0x0080,
+        StencilTestEnable   = 0x0100,
+        StencilOp           = 0x0200,
+    };
+
+    NVRHI_ENUM_CLASS_FLAG_OPERATORS(DynamicRenderState)
+
+    // Values for the states marked as dynamic in GraphicsPipelineDesc::dynamicRenderState.
+    // The other values are ignored.
+    struct DynamicRenderStateValues
+    {
+        PrimitiveType primType = PrimitiveType::TriangleList;
+        RasterCullMode cullMode = RasterCullMode::Back;
+        bool frontCounterClockwise = false;
+        int depthBias = 0;
+        float depthBiasClamp = 0.f;
+        float slopeScaledDepthBias = 0.f;
+        bool depthTestEnable = true;
+        bool depthWriteEnable = true;
+        ComparisonFunc depthFunc = ComparisonFunc::Less;
+        bool stencilEnable = false;
+        DepthStencilState::StencilOpDesc frontFaceStencil{};
+        DepthStencilState::StencilOpDesc backFaceStencil{};
+
+        constexpr DynamicRenderStateValues& setPrimType(PrimitiveType value) { primType = value; return *this; }
+        constexpr DynamicRenderStateValues& setCullMode(RasterCullMode value) { cullMode = value; return *this; }
+        constexpr DynamicRenderStateValues& setFrontCounterClockwise(bool value) { frontCounterClockwise = value; return *this; }
+        constexpr DynamicRenderStateValues& setDepthBias(int value) { depthBias = value; return *this; }
+        constexpr DynamicRenderStateValues& setDepthBiasClamp(float value) { depthBiasClamp = value; return *this; }
+        constexpr DynamicRenderStateValues& setSlopeScaleDepthBias(float value) { slopeScaledDepthBias = value; return *this; }
+        constexpr DynamicRenderStateValues& setDepthTestEnable(bool value) { depthTestEnable = value; return *this; }
+        constexpr DynamicRenderStateValues& setDepthWriteEnable(bool value) { depthWriteEnable = value; return *this; }
+        constexpr DynamicRenderStateValues& setDepthFunc(ComparisonFunc value) { depthFunc = value; return *this; }
+        constexpr DynamicRenderStateValues& setStencilEnable(bool value) { stencilEnable = value; return *this; }
+        constexpr DynamicRenderStateValues& setFrontFaceStencil(const DepthStencilState::StencilOpDesc& value) { frontFaceStencil = value; return *this; }
+        constexpr DynamicRenderStateValues& setBackFaceStencil(const DepthStencilState::StencilOpDesc& value) { backFaceStencil = value; return *this; }
+
+        bool operator ==(const DynamicRenderStateValues& b) const
+        {
+            auto stencilOpsEqual = [](const DepthStencilState::StencilOpDesc& x, const DepthStencilState::StencilOpDesc& y)
+            {
+                return x.failOp == y.failOp && x.depthFailOp == y.depthFailOp && x.passOp == y.passOp && x.stencilFunc == y.stencilFunc;
+            };
+
+            return primType == b.primType
+                && cullMode == b.cullMode
+                && frontCounterClockwise == b.frontCounterClockwise
+                && depthBias == b.depthBias
+                && depthBiasClamp == b.depthBiasClamp
+                && slopeScaledDepthBias == b.slopeScaledDepthBias
+                && depthTestEnable == b.depthTestEnable
+                && depthWriteEnable == b.depthWriteEnable
+                && depthFunc == b.depthFunc
+                && stencilEnable == b.stencilEnable
+                && stencilOpsEqual(frontFaceStencil, b.frontFaceStencil)
+                && stencilOpsEqual(backFaceStencil, b.backFaceStencil);
+        }
+
+        bool operator !=(const DynamicRenderStateValues& b) const { return !(*this == b); }
+    };
+
     enum class VariableShadingRate : uint8_t
     {
         e1x1,
@@ -2522,6 +2748,9 @@ namespace nvrhi
         RenderState renderState;
         VariableRateShadingState shadingRateState;
 
+        // The states that are taken from GraphicsState::dynamicRenderState instead of renderState and primType
+        DynamicRenderState dynamicRenderState = DynamicRenderState::None;
+
         BindingLayoutVector bindingLayouts;
         
         GraphicsPipelineDesc& setPrimType(PrimitiveType value) { primType = value; return *this; }
@@ -2537,6 +2766,7 @@ namespace nvrhi
         GraphicsPipelineDesc& setFragmentShader(IShader* value) { PS = value; return *this; }
         GraphicsPipelineDesc& setRenderState(const RenderState& value) { renderState = value; return *this; }
         GraphicsPipelineDesc& setVariableRateShadingState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
+        GraphicsPipelineDesc& setDynamicRenderState(DynamicRenderState value) { dynamicRenderState = value; return *this; }
         GraphicsPipelineDesc& addBindingLayout(IBindingLayout* layout) { bindingLayouts.push_back(layout); return *this; }
     };
 
@@ -2608,6 +2838,83 @@ namespace nvrhi
     class ITimerQuery : public IResource { };
     typedef RefCountPtr<ITimerQuery> TimerQueryHandle;
 
+    struct TimestampQueryPoolDesc
+    {
+        uint32_t queryCount = 0;
+        std::string debugName;
+
+        TimestampQueryPoolDesc& setQueryCount(uint32_t value) { queryCount = value; return *this; }
+        TimestampQueryPoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // A pool of raw GPU timestamps that are written and resolved in batches, for profilers that take many
+    // measurements per frame. Unlike ITimerQuery, reading the results never waits for the GPU: the caller is
+    // expected to track completion of the command list that resolved the timestamps, e.g. with an event query.
+    class ITimestampQueryPool : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const TimestampQueryPoolDesc& getDesc() const = 0;
+    };
+    typedef RefCountPtr<ITimestampQueryPool> TimestampQueryPoolHandle;
+
+    enum class QueryType : uint8_t
+    {
+        // The number of samples that passed the depth and stencil tests
+        Occlusion,
+
+        // Non-zero if any sample passed the depth and stencil tests, which can be cheaper than counting them
+        BinaryOcclusion,
+
+        // Shader invocation and primitive counts, see PipelineStatistics.
+        // Requires Feature::PipelineStatisticsQueries.
+        PipelineStatistics
+    };
+
+    // The resolved data of one PipelineStatistics query. The layout matches D3D12_QUERY_DATA_PIPELINE_STATISTICS
+    // and the order of the Vulkan pipeline statistic bits, so that both backends resolve into it directly.
+    struct PipelineStatistics
+    {
+        uint64_t inputVertices = 0;
+        uint64_t inputPrimitives = 0;
+        uint64_t vertexShaderInvocations = 0;
+        uint64_t geometryShaderInvocations = 0;
+        uint64_t geometryShaderPrimitives = 0;
+        uint64_t clippingInvocations = 0;
+        uint64_t clippingPrimitives = 0;
+        uint64_t pixelShaderInvocations = 0;
+        uint64_t hullShaderInvocations = 0;
+        uint64_t domainShaderInvocations = 0;
+        uint64_t computeShaderInvocations = 0;
+    };
+
+    struct QueryPoolDesc
+    {
+        QueryType type = QueryType::Occlusion;
+        uint32_t queryCount = 0;
+        std::string debugName;
+
+        QueryPoolDesc& setType(QueryType value) { type = value; return *this; }
+        QueryPoolDesc& setQueryCount(uint32_t value) { queryCount = value; return *this; }
+        QueryPoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // A pool of occlusion or pipeline statistics queries, which are resolved in batches into a GPU buffer.
+    // Resolved occlusion results are one uint64_t per query, pipeline statistics one PipelineStatistics structure.
+    // The buffer can be read back, used by shaders, or used for predication with ICommandList::beginPredication.
+    class IQueryPool : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const QueryPoolDesc& getDesc() const = 0;
+    };
+    typedef RefCountPtr<IQueryPool> QueryPoolHandle;
+
+    enum class PredicationOp : uint8_t
+    {
+        // Skip rendering and dispatch commands if the predicate value is zero, e.g. if nothing was visible
+        SkipIfZero,
+        SkipIfNotZero
+    };
+
     struct VertexBufferBinding
     {
         IBuffer* buffer = nullptr;
@@ -2657,6 +2964,7 @@ namespace nvrhi
         VariableRateShadingState shadingRateState;
         Color blendConstantColor{};
         uint8_t dynamicStencilRefValue = 0;
+        DynamicRenderStateValues dynamicRenderState;
 
         BindingSetVector bindings;
 
@@ -2672,6 +2980,7 @@ namespace nvrhi
         GraphicsState& setShadingRateState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
         GraphicsState& setBlendColor(const Color& value) { blendConstantColor = value; return *this; }
         GraphicsState& setDynamicStencilRefValue(uint8_t value) { dynamicStencilRefValue = value; return *this; }
+        GraphicsState& setDynamicRenderState(const DynamicRenderStateValues& value) { dynamicRenderState = value; return *this; }
         GraphicsState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         GraphicsState& addVertexBuffer(const VertexBufferBinding& value) { vertexBuffers.push_back(value); return *this; }
         GraphicsState& setIndexBuffer(const IndexBufferBinding& value) { indexBuffer = value; return *this; }
@@ -2679,6 +2988,23 @@ namespace nvrhi
         GraphicsState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
     };
 
+    // Lists the resources used by the draws into one framebuffer, see ICommandList::beginRenderPassScope(...)
+    struct RenderPassScope
+    {
+        IFramebuffer* framebuffer = nullptr;
+
+        std::vector<IBindingSet*> bindingSets;
+        std::vector<IBuffer*> vertexBuffers;
+        std::vector<IBuffer*> indexBuffers;
+        std::vector<IBuffer*> indirectBuffers;
+
+        RenderPassScope& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
+        RenderPassScope& addBindingSet(IBindingSet* value) { bindingSets.push_back(value); return *this; }
+        RenderPassScope& addVertexBuffer(IBuffer* value) { vertexBuffers.push_back(value); return *this; }
+        RenderPassScope& addIndexBuffer(IBuffer* value) { indexBuffers.push_back(value); return *this; }
+        RenderPassScope& addIndirectBuffer(IBuffer* value) { indirectBuffers.push_back(value); return *this; }
+    };
+
     struct DrawArguments
     {
         uint32_t vertexCount = 0;
@@ -2694,6 +3020,45 @@ namespace nvrhi
         constexpr DrawArguments& setStartInstanceLocation(uint32_t value) { startInstanceLocation = value; return *this; }
     };
 
+    //////////////////////////////////////////////////////////////////////////
+    // Command Bundles
+    //////////////////////////////////////////////////////////////////////////
+
+    struct CommandBundleDraw
+    {
+        GraphicsState state;
+        DrawArguments args;
+        bool indexed = false;
+
+        CommandBundleDraw& setState(const GraphicsState& value) { state = value; return *this; }
+        CommandBundleDraw& setArgs(const DrawArguments& value) { args = value; return *this; }
+        CommandBundleDraw& setIndexed(bool value) { indexed = value; return *this; }
+    };
+
+    // A sequence of draws that is recorded once and replayed with ICommandList::executeBundle(...).
+    // All draws must use the same framebuffer, viewport state and shading rate state, because D3D12 bundles
+    // inherit those from the calling command list. Indirect draws, push constants and binding sets with
+    // volatile constant buffers cannot be used in bundles.
+    struct CommandBundleDesc
+    {
+        std::vector<CommandBundleDraw> draws;
+        std::string debugName;
+
+        CommandBundleDesc& addDraw(const GraphicsState& state, const DrawArguments& args)
+            { draws.push_back(CommandBundleDraw().setState(state).setArgs(args)); return *this; }
+        CommandBundleDesc& addDrawIndexed(const GraphicsState& state, const DrawArguments& args)
+            { draws.push_back(CommandBundleDraw().setState(state).setArgs(args).setIndexed(true)); return *this; }
+        CommandBundleDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    class ICommandBundle : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const CommandBundleDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<ICommandBundle> CommandBundleHandle;
+
     struct DrawIndirectArguments
     {
         uint32_t vertexCount = 0;
@@ -2729,10 +3094,12 @@ namespace nvrhi
         BindingSetVector bindings;
 
         IBuffer* indirectParams = nullptr;
+        IBuffer* indirectCountBuffer = nullptr;
 
         ComputeState& setPipeline(IComputePipeline* value) { pipeline = value; return *this; }
         ComputeState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         ComputeState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        ComputeState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
     };
     
     struct DispatchIndirectArguments
@@ -2759,6 +3126,7 @@ namespace nvrhi
         BindingSetVector bindings;
 
         IBuffer* indirectParams = nullptr;
+        IBuffer* indirectCountBuffer = nullptr;
 
         MeshletState& setPipeline(IMeshletPipeline* value) { pipeline = value; return *this; }
         MeshletState& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
@@ -2766,9 +3134,99 @@ namespace nvrhi
         MeshletState& setBlendColor(const Color& value) { blendConstantColor = value; return *this; }
         MeshletState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         MeshletState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        MeshletState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
         MeshletState& setDynamicStencilRefValue(uint8_t value) { dynamicStencilRefValue = value; return *this; }
     };
 
+    //////////////////////////////////////////////////////////////////////////
+    // Indirect Command Layouts
+    //////////////////////////////////////////////////////////////////////////
+
+    // Types of the arguments in an indirect command, with the structure that each argument occupies
+    // in the argument buffer.
+    enum class IndirectArgumentType : uint8_t
+    {
+        PushConstants,  // pushConstantsByteSize bytes that replace a range of the pipeline's push constants
+        VertexBuffer,   // IndirectVertexBufferView
+        IndexBuffer,    // IndirectIndexBufferView
+        Draw,           // DrawIndirectArguments
+        DrawIndexed,    // DrawIndexedIndirectArguments
+        Dispatch        // DispatchIndirectArguments
+    };
+
+    // Layout of a VertexBuffer argument, matches D3D12_VERTEX_BUFFER_VIEW and VkBindVertexBufferIndirectCommandEXT.
+    struct IndirectVertexBufferView
+    {
+        GpuVirtualAddress bufferAddress = 0;
+        uint32_t sizeInBytes = 0;
+        uint32_t strideInBytes = 0;
+    };
+
+    // Layout of an IndexBuffer argument, matches D3D12_INDEX_BUFFER_VIEW and VkBindIndexBufferIndirectCommandEXT
+    // with the DXGI index buffer input mode. The format is DXGI_FORMAT_R16_UINT (57) or DXGI_FORMAT_R32_UINT (42)
+    // on both APIs.
+    struct IndirectIndexBufferView
+    {
+        GpuVirtualAddress bufferAddress = 0;
+        uint32_t sizeInBytes = 0;
+        uint32_t dxgiFormat = 0;
+    };
+
+    struct IndirectArgumentDesc
+    {
+        IndirectArgumentType type = IndirectArgumentType::Draw;
+
+        // Input slot of a VertexBuffer argument, same as VertexBufferBinding::slot.
+        uint32_t vertexBufferSlot = 0;
+
+        // Range of the push constants written by a PushConstants argument, both must be multiples of 4.
+        uint32_t pushConstantsOffset = 0;
+        uint32_t pushConstantsByteSize = 0;
+
+        IndirectArgumentDesc& setType(IndirectArgumentType value) { type = value; return *this; }
+        IndirectArgumentDesc& setVertexBufferSlot(uint32_t value) { vertexBufferSlot = value; return *this; }
+        IndirectArgumentDesc& setPushConstantsOffset(uint32_t value) { pushConstantsOffset = value; return *this; }
+        IndirectArgumentDesc& setPushConstantsByteSize(uint32_t value) { pushConstantsByteSize = value; return *this; }
+    };
+
+    // Describes the commands written by the GPU into an argument buffer for ICommandList::executeIndirectCommands(...).
+    // Each command consists of the arguments in the order they are listed here, packed without padding,
+    // and the last argument must be the only Draw, DrawIndexed or Dispatch argument. The pipeline provides
+    // the root signature or pipeline layout that PushConstants arguments refer to, and it must be the pipeline
+    // that is set on the command list when the commands are executed. Changing pipelines per command is not
+    // supported: D3D12 command signatures cannot do that, and Vulkan would need indirect execution sets.
+    struct IndirectCommandLayoutDesc
+    {
+        std::vector<IndirectArgumentDesc> arguments;
+
+        // Distance between consecutive commands in the argument buffer, or 0 to use the packed size of the arguments.
+        uint32_t byteStride = 0;
+
+        // Exactly one of the pipelines must be set, depending on whether the commands are draws or dispatches.
+        IGraphicsPipeline* graphicsPipeline = nullptr;
+        IComputePipeline* computePipeline = nullptr;
+
+        std::string debugName;
+
+        IndirectCommandLayoutDesc& addArgument(const IndirectArgumentDesc& value) { arguments.push_back(value); return *this; }
+        IndirectCommandLayoutDesc& setByteStride(uint32_t value) { byteStride = value; return *this; }
+        IndirectCommandLayoutDesc& setGraphicsPipeline(IGraphicsPipeline* value) { graphicsPipeline = value; return *this; }
+        IndirectCommandLayoutDesc& setComputePipeline(IComputePipeline* value) { computePipeline = value; return *this; }
+        IndirectCommandLayoutDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    class IIndirectCommandLayout : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const IndirectCommandLayoutDesc& getDesc() const = 0;
+
+        // Returns the distance between consecutive commands, which is the packed size of the arguments
+        // unless IndirectCommandLayoutDesc::byteStride is set.
+        [[nodiscard]] virtual uint32_t getByteStride() const = 0;
+    };
+
+    typedef RefCountPtr<IIndirectCommandLayout> IndirectCommandLayoutHandle;
+
     //////////////////////////////////////////////////////////////////////////
     // Ray Tracing
     //////////////////////////////////////////////////////////////////////////
@@ -2814,6 +3272,11 @@ namespace nvrhi
             int32_t hlslExtensionsUAV = -1;
             bool allowOpacityMicromaps = false;
 
+            // Allows new shaders and hit groups to be linked into this pipeline later with
+            // IDevice::addToRayTracingPipeline(...). Requires Feature::RayTracingPipelineLibraries.
+            // On Vulkan, the pipeline is then created as a pipeline library that is linked into an executable pipeline.
+            bool allowAdditions = false;
+
             PipelineDesc& addShader(const PipelineShaderDesc& value) { shaders.push_back(value); return *this; }
             PipelineDesc& addHitGroup(const PipelineHitGroupDesc& value) { hitGroups.push_back(value); return *this; }
             PipelineDesc& addBindingLayout(IBindingLayout* value) { globalBindingLayouts.push_back(value); return *this; }
@@ -2822,6 +3285,7 @@ namespace nvrhi
             PipelineDesc& setMaxRecursionDepth(uint32_t value) { maxRecursionDepth = value; return *this; }
             PipelineDesc& setHlslExtensionsUAV(int32_t value) { hlslExtensionsUAV = value; return *this; }
             PipelineDesc& setAllowOpacityMicromaps(bool value) { allowOpacityMicromaps = value; return *this; }
+            PipelineDesc& setAllowAdditions(bool value) { allowAdditions = value; return *this; }
         };
 
         class IPipeline;
@@ -2845,14 +3309,28 @@ namespace nvrhi
             // Ignored when isCached == false.
             uint32_t maxEntries = 0;
 
+            // Creates the buffer of a cached shader table with UAV support, so that shaders can write
+            // records into it directly. See IShaderTable::getBuffer() and getRecordOffset(...).
+            // Ignored when isCached == false.
+            bool allowGpuWrites = false;
+
             std::string debugName;
 
             ShaderTableDesc& setIsCached(bool value) { isCached = value; return *this; }
             ShaderTableDesc& setMaxEntries(uint32_t value) { maxEntries = value; return *this; }
+            ShaderTableDesc& setAllowGpuWrites(bool value) { allowGpuWrites = value; return *this; }
             ShaderTableDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
             ShaderTableDesc& enableCaching(uint32_t _maxEntries) { isCached = true; maxEntries = _maxEntries; return *this; }
         };
 
+        enum class ShaderTableSection : uint8_t
+        {
+            RayGeneration,
+            Miss,
+            HitGroup,
+            Callable
+        };
+
         class IShaderTable : public IResource
         {
         public:
@@ -2866,6 +3344,27 @@ namespace nvrhi
             virtual void clearMissShaders() = 0;
             virtual void clearHitShaders() = 0;
             virtual void clearCallableShaders() = 0;
+
+            // Replace an existing record without changing the layout of the table.
+            // Returns false if the index is out of range or the export is invalid.
+            // For cached tables, setRayTracingState uploads only the records that were replaced since
+            // the previous upload, while adding or clearing records causes the whole table to be rebuilt.
+            // The same applies to setRayGenerationShader(...).
+            virtual bool setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            virtual bool setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            virtual bool setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
+
+            // Returns the buffer that holds a cached shader table on the GPU, or nullptr if the table is uncached.
+            // When the table was created with allowGpuWrites, shaders may write records into this buffer;
+            // such records are preserved until the CPU replaces them or the whole table is rebuilt.
+            // The buffer is returned to the ShaderResource state by every setRayTracingState call that uses the table.
+            virtual IBuffer* getBuffer() const = 0;
+
+            // Returns the size of one record, which is also the stride between consecutive records.
+            virtual uint32_t getRecordSize() const = 0;
+
+            // Returns the offset of a record within the table in bytes, using the current layout of the table.
+            virtual uint64_t getRecordOffset(ShaderTableSection section, uint32_t index) const = 0;
         };
 
         typedef RefCountPtr<IShaderTable> ShaderTableHandle;
@@ -3037,7 +3536,14 @@ namespace nvrhi
         VirtualResources,
         WaveLaneCountMinMax,
         CooperativeVectorInferencing,
-        CooperativeVectorTraining
+        CooperativeVectorTraining,
+        IndirectCommandLayouts,
+        PushDescriptors,
+        ExtendedDynamicState,
+        HostMemoryImport,
+        PipelineStatisticsQueries,
+        Predication,
+        RayTracingPipelineLibraries
     };
 
     enum class MessageSeverity : uint8_t
@@ -3062,12 +3568,96 @@ namespace nvrhi
         uint32_t shadingRateImageTileSize;
     };
 
+    struct DynamicRenderStateFeatureInfo
+    {
+        DynamicRenderState supportedStates = DynamicRenderState::None;
+    };
+
+    struct HostMemoryImportFeatureInfo
+    {
+        // Alignment of the host pointer and the buffer size for IDevice::createBufferFromHostMemory
+        uint64_t minPointerAlignment = 0;
+    };
+
     struct WaveLaneCountMinMaxFeatureInfo
     {
         uint32_t minWaveLaneCount;
         uint32_t maxWaveLaneCount;
     };
 
+    struct MemoryHeapStatistics
+    {
+        // Amount of memory that the process can use in the heap without degrading performance, as reported by the OS or driver.
+        uint64_t budget = 0;
+
+        // Amount of memory that the process currently uses in the heap, including memory not allocated by NVRHI.
+        uint64_t usage = 0;
+
+        bool isDeviceLocal = false;
+    };
+
+    struct MemoryStatistics
+    {
+        // Budget and usage of the memory heaps, empty if the information isn't available.
+        // - DX11, DX12: The local and non-local memory segment groups reported by IDXGIAdapter3, in that order.
+        // - Vulkan: The memory heaps of the physical device. Usage is only known with VK_EXT_memory_budget.
+        static_vector<MemoryHeapStatistics, c_MaxMemoryHeaps> heaps;
+
+        // Memory allocated by NVRHI, by resource type. Resources placed into heaps are included in heapBytes only.
+        // Upload chunks include the shared upload rings and scratch memory.
+        // DX11 reports estimated sizes for buffers and textures only.
+        uint64_t bufferBytes = 0;
+        uint64_t textureBytes = 0;
+        uint64_t accelStructBytes = 0;
+        uint64_t uploadChunkBytes = 0;
+        uint64_t descriptorHeapBytes = 0;
+        uint64_t heapBytes = 0;
+    };
+
+    enum class ResourceAllocationType : uint8_t
+    {
+        Buffer,
+        Texture,
+        AccelStruct,    // Reported with the buffer that stores the acceleration structure
+        Heap,
+        UploadChunk,
+        DescriptorHeap
+    };
+
+    // One live allocation reported by IDevice::enumerateResourceAllocations(...).
+    // The committed allocations add up to the totals in MemoryStatistics, the placed ones are contained in their heaps.
+    struct ResourceAllocationInfo
+    {
+        // The buffer, texture or heap, nullptr for the allocations made by NVRHI itself
+        IResource* resource = nullptr;
+        ResourceAllocationType type = ResourceAllocationType::Buffer;
+
+        // The debug name of the resource, or a name generated from its description if it has none.
+        // Only valid during the callback.
+        const char* debugName = "";
+
+        uint64_t sizeInBytes = 0;
+        HeapType memoryType = HeapType::DeviceLocal;
+
+        // Placed resources are bound to a range of a heap with bindBufferMemory or bindTextureMemory
+        bool isPlaced = false;
+        IHeap* heap = nullptr;
+        uint64_t heapOffset = 0;
+    };
+
+    // Limits the work done by one call to IDevice::runIncrementalGarbageCollection(...), zero means no limit.
+    // The limits are checked after every retired command list, so a call can go over them by one command list.
+    struct GarbageCollectionBudget
+    {
+        float maxMilliseconds = 0.f;
+
+        // The number of references to resources that are dropped by the retired command lists
+        uint32_t maxObjects = 0;
+
+        constexpr GarbageCollectionBudget& setMaxMilliseconds(float value) { maxMilliseconds = value; return *this; }
+        constexpr GarbageCollectionBudget& setMaxObjects(uint32_t value) { maxObjects = value; return *this; }
+    };
+
     // IMessageCallback should be implemented by the application.
     class IMessageCallback
     {
@@ -3080,11 +3670,124 @@ namespace nvrhi
         // The application is free to ignore the messages, show message boxes, or terminate.
         virtual void message(MessageSeverity severity, const char* messageText) = 0;
 
+        // NVRHI calls memoryBudgetExceeded(...) when the usage of a memory heap goes over its budget, which is
+        // checked in IDevice::getMemoryStatistics() and IDevice::runGarbageCollection(). The call is made once,
+        // and repeated only after usage drops back within the budget. The application may react by evicting
+        // resources before the OS starts paging.
+        virtual void memoryBudgetExceeded(uint32_t heapIndex, const MemoryHeapStatistics& heap) { (void)heapIndex; (void)heap; }
+
         IMessageCallback(const IMessageCallback&) = delete;
         IMessageCallback(const IMessageCallback&&) = delete;
         IMessageCallback& operator=(const IMessageCallback&) = delete;
         IMessageCallback& operator=(const IMessageCallback&&) = delete;
     };
+
+    // The expensive CPU-side operations of a device that are reported to IInstrumentationCallback
+    enum class InstrumentationZone : uint8_t
+    {
+        CreateGraphicsPipeline,
+        CreateComputePipeline,
+        CreateMeshletPipeline,
+        CreateRayTracingPipeline,
+        CreateBindingSet,       // Includes the transient binding sets of command lists
+        AllocateUploadChunk,    // Creation of new upload and scratch buffer chunks, not the sub-allocations from them
+        CommitBarriers,         // Only reported when there are pending barriers
+        ExecuteCommandLists,    // Includes executeSubmitGraph
+        GarbageCollection,      // Includes the background garbage collection thread
+
+        Count
+    };
+
+    enum class PipelineType : uint8_t
+    {
+        Graphics,
+        Compute,
+        Meshlet,
+        RayTracing
+    };
+
+    enum class PipelineCacheResult : uint8_t
+    {
+        // The backend cannot tell, e.g. on DX11, or when the pipeline cache or library is not used.
+        Unknown,
+        // The pipeline was found in the DX12 pipeline library or the Vulkan pipeline cache.
+        Hit,
+        // The pipeline had to be compiled by the driver.
+        Miss
+    };
+
+    // Describes one pipeline creation, see IInstrumentationCallback::pipelineCreated.
+    struct PipelineCreationInfo
+    {
+        PipelineType type = PipelineType::Graphics;
+
+        // The new pipeline, or nullptr if the creation failed.
+        IResource* pipeline = nullptr;
+
+        // Debug name of the first shader of the pipeline (CS, VS, MS or the first ray tracing shader), or "".
+        const char* shaderName = "";
+
+        // CPU time spent in the create call, including root signature or pipeline layout lookup.
+        float cpuMilliseconds = 0.f;
+
+        PipelineCacheResult cacheResult = PipelineCacheResult::Unknown;
+    };
+
+    // Totals of the pipeline creations on a device, see IDevice::getPipelineCreationStatistics.
+    struct PipelineCreationStatistics
+    {
+        uint64_t createdPipelines = 0;
+        uint64_t failedPipelines = 0;
+
+        // Creations with PipelineCacheResult::Hit and Miss. Unknown results are in neither counter.
+        uint64_t cacheHits = 0;
+        uint64_t cacheMisses = 0;
+
+        // CPU time of all creations, including the failed ones, and of the slowest one.
+        double totalMilliseconds = 0.0;
+        float maxMilliseconds = 0.f;
+    };
+
+    // IInstrumentationCallback can be implemented by the application to feed NVRHI's CPU zones into a profiler
+    // such as Tracy, Superluminal or ETW, see IDevice::setInstrumentationCallback. The calls are made on the
+    // thread that runs the operation, which may be any thread, and every beginZone is followed by an endZone
+    // with the same zone on that thread. Zones nest, e.g. AllocateUploadChunk inside of a command list call.
+    // utils::InstrumentationZoneToString returns static names for the zones.
+    class IInstrumentationCallback
+    {
+    protected:
+        IInstrumentationCallback() = default;
+        virtual ~IInstrumentationCallback() = default;
+
+    public:
+        virtual void beginZone(InstrumentationZone zone) = 0;
+        virtual void endZone(InstrumentationZone zone) = 0;
+
+        // Called at the end of every graphics, compute, meshlet and ray tracing pipeline creation, after
+        // the endZone of the creation zone. The info and the strings in it are only valid during the call.
+        virtual void pipelineCreated(const PipelineCreationInfo& info) { (void)info; }
+
+        IInstrumentationCallback(const IInstrumentationCallback&) = delete;
+        IInstrumentationCallback(const IInstrumentationCallback&&) = delete;
+        IInstrumentationCallback& operator=(const IInstrumentationCallback&) = delete;
+        IInstrumentationCallback& operator=(const IInstrumentationCallback&&) = delete;
+    };
+
+    // Receives the allocations from IDevice::enumerateResourceAllocations(...), one call per allocation
+    class IResourceAllocationCallback
+    {
+    protected:
+        IResourceAllocationCallback() = default;
+        virtual ~IResourceAllocationCallback() = default;
+
+    public:
+        virtual void onResourceAllocation(const ResourceAllocationInfo& allocation) = 0;
+
+        IResourceAllocationCallback(const IResourceAllocationCallback&) = delete;
+        IResourceAllocationCallback(const IResourceAllocationCallback&&) = delete;
+        IResourceAllocationCallback& operator=(const IResourceAllocationCallback&) = delete;
+        IResourceAllocationCallback& operator=(const IResourceAllocationCallback&&) = delete;
+    };
     
     class IDevice;
 
@@ -3092,6 +3795,8 @@ namespace nvrhi
     {
         // A command list with enableImmediateExecution = true maps to the immediate context on DX11.
         // Two immediate command lists cannot be open at the same time, which is checked by the validation layer.
+        // Other command lists are recorded on DX11 deferred contexts and run on the immediate context
+        // by executeCommandLists, see Feature::DeferredCommandLists.
         bool enableImmediateExecution = true;
 
         // Minimum size of memory chunks created to upload data to the device on DX12.
@@ -3107,11 +3812,159 @@ namespace nvrhi
         // COPY and COMPUTE queues have limited subsets of methods available.
         CommandQueue queueType = CommandQueue::Graphics;
 
+        // Enables sub-allocation of upload memory from the ring buffer shared by all command lists of the queue
+        // on DX12 and Vulkan, instead of chunks owned by this command list. Allocations that don't fit into the
+        // ring's chunks, or that are made while the ring is full, still use the command list's own chunks.
+        // The ring is configured with DeviceDesc::uploadRingSize and uploadRingChunkSize.
+        bool useSharedUploadRing = false;
+
+        // Makes the AS build scratch allocations of this command list come from a device-wide scratch pool of
+        // its queue on DX12 and Vulkan, so that command lists recorded on several threads share their peak scratch
+        // memory. Pool chunks are reclaimed once the submission that used them has finished. When the pool is at
+        // its budget, chunks still used by earlier submissions on the queue are reused after a barrier, which
+        // serializes the builds instead of failing them; only if no chunk can be reused at all does the command
+        // list fall back to its own chunks, limited by scratchMaxMemory.
+        // The pool is configured with DeviceDesc::scratchPoolMaxMemory and scratchPoolChunkSize.
+        bool useSharedScratchPool = false;
+
+        // Enables deferred resolution of initial resource states on DX12 and Vulkan. When the command list uses
+        // a resource whose state is not known, it assumes the resource is already in the required state and
+        // records that requirement instead of reporting an error. executeCommandLists then inserts a small
+        // command list with the necessary barriers before this one, based on the states that the resource is left
+        // in by the command lists executed before it. This allows recording multiple command lists in parallel
+        // without calling beginTrackingTextureState / beginTrackingBufferState.
+        // The states are resolved in the order of submission on each queue, so resources shared between queues
+        // still need explicit tracking. Textures whose subresources end up in different states are transitioned
+        // to a single state when the command list is closed.
+        bool deferInitialStates = false;
+
+        // Enables counting of the barriers placed by the command list, see ICommandList::getBarrierStatistics.
+        // When disabled, the counters cost one predictable branch per barrier batch and resource use.
+        bool enableBarrierStatistics = false;
+
         CommandListParameters& setEnableImmediateExecution(bool value) { enableImmediateExecution = value; return *this; }
         CommandListParameters& setUploadChunkSize(size_t value) { uploadChunkSize = value; return *this; }
         CommandListParameters& setScratchChunkSize(size_t value) { scratchChunkSize = value; return *this; }
         CommandListParameters& setScratchMaxMemory(size_t value) { scratchMaxMemory = value; return *this; }
         CommandListParameters& setQueueType(CommandQueue value) { queueType = value; return *this; }
+        CommandListParameters& setUseSharedUploadRing(bool value) { useSharedUploadRing = value; return *this; }
+        CommandListParameters& setUseSharedScratchPool(bool value) { useSharedScratchPool = value; return *this; }
+        CommandListParameters& setDeferInitialStates(bool value) { deferInitialStates = value; return *this; }
+        CommandListParameters& setEnableBarrierStatistics(bool value) { enableBarrierStatistics = value; return *this; }
+    };
+
+    // Counters of the barriers and render passes of a command list, see CommandListParameters::enableBarrierStatistics
+    struct BarrierStatistics
+    {
+        // Texture and buffer state transitions. Partial texture transitions are counted per subresource.
+        uint64_t textureBarriers = 0;
+        uint64_t bufferBarriers = 0;
+
+        // UAV barriers between uses of a resource in the UnorderedAccess state.
+        uint64_t uavBarriers = 0;
+
+        uint64_t aliasingBarriers = 0;
+
+        // Number of times the pending barriers were committed into the command list.
+        uint64_t barrierBatches = 0;
+
+        // Calls to setPermanentTextureState and setPermanentBufferState.
+        uint64_t permanentStateTransitions = 0;
+
+        // Resource uses that needed no barrier because the resource was already in the required state.
+        uint64_t redundantTransitionsSkipped = 0;
+
+        // Render passes started and ended by the command list. Only Vulkan has render passes.
+        uint64_t renderPassesBegun = 0;
+        uint64_t renderPassesEnded = 0;
+
+        // Render passes that setGraphicsState or setMeshletState had to end only to place barriers.
+        uint64_t renderPassSplits = 0;
+
+        BarrierStatistics& operator+=(const BarrierStatistics& other)
+        {
+            textureBarriers += other.textureBarriers;
+            bufferBarriers += other.bufferBarriers;
+            uavBarriers += other.uavBarriers;
+            aliasingBarriers += other.aliasingBarriers;
+            barrierBatches += other.barrierBatches;
+            permanentStateTransitions += other.permanentStateTransitions;
+            redundantTransitionsSkipped += other.redundantTransitionsSkipped;
+            renderPassesBegun += other.renderPassesBegun;
+            renderPassesEnded += other.renderPassesEnded;
+            renderPassSplits += other.renderPassSplits;
+            return *this;
+        }
+    };
+
+    // CPU-side counters of the work recorded into a command list, see ICommandList::getStatistics.
+    // The counters are only maintained when NVRHI is built with NVRHI_WITH_COMMAND_LIST_STATISTICS,
+    // otherwise they are compiled out and always zero.
+    struct CommandListStatistics
+    {
+        // Direct and indirect draw calls, including meshlet dispatches. Each indirect call counts once.
+        uint64_t drawCalls = 0;
+
+        // Compute dispatches and ray dispatches, direct and indirect.
+        uint64_t dispatches = 0;
+
+        // Native pipeline state changes. Setting a state with the same pipeline as before is not counted.
+        uint64_t pipelineBinds = 0;
+
+        // Binding sets and descriptor tables bound to the native command list.
+        uint64_t bindingSetBinds = 0;
+
+        // Descriptors written by the command list itself, such as root or push descriptors and the descriptors
+        // of transient binding sets.
+        uint64_t descriptorWrites = 0;
+
+        // Bytes sub-allocated from the upload buffers for writeBuffer, writeTexture and volatile constant buffers.
+        uint64_t uploadBytes = 0;
+
+        // Bytes sub-allocated from the scratch buffers for acceleration structure builds and similar operations.
+        uint64_t scratchBytes = 0;
+
+        // writeBuffer calls on volatile constant buffers.
+        uint64_t volatileConstantBufferWrites = 0;
+
+        // Native barriers emitted, including transitions, UAV and aliasing barriers.
+        uint64_t barriers = 0;
+
+        // Render passes or render target changes.
+        uint64_t renderPasses = 0;
+
+        CommandListStatistics& operator+=(const CommandListStatistics& other)
+        {
+            drawCalls += other.drawCalls;
+            dispatches += other.dispatches;
+            pipelineBinds += other.pipelineBinds;
+            bindingSetBinds += other.bindingSetBinds;
+            descriptorWrites += other.descriptorWrites;
+            uploadBytes += other.uploadBytes;
+            scratchBytes += other.scratchBytes;
+            volatileConstantBufferWrites += other.volatileConstantBufferWrites;
+            barriers += other.barriers;
+            renderPasses += other.renderPasses;
+            return *this;
+        }
+    };
+
+    struct UploadRingStatistics
+    {
+        // Total size of the ring buffer, 0 if the ring hasn't been used or is disabled.
+        uint64_t capacity = 0;
+
+        // Memory in the chunks that are claimed by command lists and haven't finished executing yet.
+        uint64_t bytesInUse = 0;
+
+        // Largest value of bytesInUse observed when claiming a chunk.
+        uint64_t peakBytesInUse = 0;
+
+        // Number of chunks claimed by command lists since the device was created.
+        uint64_t numChunksClaimed = 0;
+
+        // Number of times a command list found the ring full and fell back to its own upload chunks.
+        uint64_t numClaimFailures = 0;
     };
     
     //////////////////////////////////////////////////////////////////////////
@@ -3200,6 +4053,12 @@ namespace nvrhi
         virtual void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data,
             size_t rowPitch, size_t depthPitch = 0) = 0;
 
+        // Uploads multiple subresources, or boxes within them, of one texture from CPU memory.
+        // - DX11: Maps to one UpdateSubresource call per region.
+        // - DX12, Vulkan: All regions are packed into a single upload buffer allocation, the barriers for all of them
+        //   are committed at once, and the copies are recorded back to back (DX12) or as one vkCmdCopyBufferToImage (VK).
+        virtual void writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions) = 0;
+
         // Performs a resolve operation to combine samples from some or all subresources of a multisample texture 'src'
         // into matching subresources of a non-multisample texture 'dest'. Both textures' formats must be of color type.
         // - DX11/12: Maps to a sequence of ResolveSubresource calls, one per subresource.
@@ -3270,6 +4129,20 @@ namespace nvrhi
         // Note that NVRHI only supports one push constants binding in all layouts used in a pipeline.
         virtual void setPushConstants(const void* data, size_t byteSize) = 0;
 
+        // Creates a binding set whose lifetime is tied to the current recording of this command list.
+        // The descriptors are written into a per-command-list arena that is reclaimed in bulk when the
+        // command list instance finishes executing on the GPU, which makes this function suitable for
+        // per-draw dynamic bindings. The returned pointer is owned by the command list: it must not be
+        // stored in a BindingSetHandle past the current recording, and it can only be used in states set
+        // on this command list until it's closed and executed.
+        // - DX11: Creates a regular binding set that is kept alive until the command list is reopened.
+        // - DX12: Allocates the descriptor tables from chunks of the static descriptor heaps owned by
+        //   the command list instance.
+        // - Vulkan: Allocates the descriptor set from descriptor pools owned by the command buffer,
+        //   which are reset when the command buffer is retired.
+        // Returns nullptr if the binding set could not be created.
+        virtual IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) = 0;
+
         // Sets the specified graphics state on the command list.
         // The state includes the pipeline (or individual shaders on DX11) and all resources bound to it,
         // from input buffers to render targets. See the members of GraphicsState for more information.
@@ -3280,6 +4153,41 @@ namespace nvrhi
         // state. To avoid these issues, call clearState() when switching from direct command list access to NVRHI.
         virtual void setGraphicsState(const GraphicsState& state) = 0;
 
+        // Replace individual parts of the current graphics state without comparing and copying the entire
+        // GraphicsState. These functions can only be used after setGraphicsState(...) and before any other
+        // pipeline type is used; their changes are visible to the next setGraphicsState(...) call, which will
+        // only update what differs from the result.
+        // setGraphicsBindingSet(...) replaces the binding set in the given slot of GraphicsState::bindings.
+        // setVertexBuffers(...) replaces all vertex buffer bindings, setIndexBuffer(...) replaces the index buffer.
+        // The necessary barriers are placed immediately when automatic barriers are enabled.
+        virtual void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) = 0;
+        virtual void setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings) = 0;
+        virtual void setIndexBuffer(const IndexBufferBinding& binding) = 0;
+
+        // Transitions all resources listed in the scope into the states required by the draws and starts a render
+        // pass on the scope's framebuffer, so that the following setGraphicsState(...) or setMeshletState(...) calls
+        // with that framebuffer don't need to split the pass for barriers. If the pass is split anyway before
+        // endRenderPassScope(), for example because of a resource missing from the scope or a copy operation,
+        // a warning that names the cause is reported through the message callback.
+        // Has no effect when automatic barriers are disabled, except starting the render pass.
+        // - DX11: Has no effect.
+        // - DX12: Only places the barriers, there are no render passes to preserve.
+        // - Vulkan: Places the barriers and calls vkCmdBeginRendering.
+        virtual void beginRenderPassScope(const RenderPassScope& scope) = 0;
+
+        // Ends the scope started with beginRenderPassScope(...). The render pass itself ends at the next
+        // operation that cannot be recorded inside it, as usual.
+        virtual void endRenderPassScope() = 0;
+
+        // Replays the draws of a command bundle. The resources used by the bundle are transitioned into the
+        // required states first, using the state list that was computed when the bundle was created.
+        // The graphics state of the command list is undefined after this call, so setGraphicsState(...) must be
+        // called again before the following draws. Only available on graphics command lists.
+        // - DX11: Replays the draws with setGraphicsState(...) and draw(...).
+        // - DX12: Maps to ExecuteBundle.
+        // - Vulkan: Maps to vkCmdExecuteCommands with a secondary command buffer, in a separate render pass.
+        virtual void executeBundle(ICommandBundle* bundle) = 0;
+
         // Draws non-indexed primitives using the current graphics state.
         // setGraphicsState(...) must be called between opening the command list or using other types of pipelines
         // and calling draw(...) or any of its siblings. If the pipeline uses push constants, those must be set
@@ -3296,6 +4204,20 @@ namespace nvrhi
         // - Vulkan: Maps to vkCmdDrawIndexed.
         virtual void drawIndexed(const DrawArguments& args) = 0;
 
+        // Draws multiple sets of non-indexed primitives with the current graphics state, which is cheaper than
+        // calling draw(...) for each of them: the checks and bookkeeping of the layers are done once for the batch.
+        // See the comment to draw(...) for state information.
+        // - DX11/12: Maps to multiple calls to DrawInstanced.
+        // - Vulkan: Maps to vkCmdDrawMultiEXT when VK_EXT_multi_draw is enabled, with one call for each run of
+        //   consecutive draws that share instanceCount and startInstanceLocation. Maps to vkCmdDraw otherwise.
+        virtual void drawMulti(const DrawArguments* args, size_t numDraws) = 0;
+
+        // Draws multiple sets of indexed primitives with the current graphics state, see drawMulti(...).
+        // - DX11/12: Maps to multiple calls to DrawIndexedInstanced.
+        // - Vulkan: Maps to vkCmdDrawMultiIndexedEXT when VK_EXT_multi_draw is enabled, like drawMulti(...).
+        //   Maps to vkCmdDrawIndexed otherwise.
+        virtual void drawIndexedMulti(const DrawArguments* args, size_t numDraws) = 0;
+
         // Draws one or multiple sets of non-indexed primitives using the parameters provided in the indirect buffer
         // specified in the prior call to setGraphicsState(...). The memory layout in the buffer is the same for all
         // graphics APIs and is described by the DrawIndirectArguments structure. If drawCount is more than 1,
@@ -3349,6 +4271,18 @@ namespace nvrhi
         // - Vulkan: Maps to vkCmdDispatchIndirect.
         virtual void dispatchIndirect(uint32_t offsetBytes) = 0;
 
+        // Executes up to maxCommandCount commands written in the given layout into the indirectParams buffer
+        // of the current graphics or compute state, starting at paramOffsetBytes. If the state also has
+        // an indirectCountBuffer, the number of commands is the minimum of maxCommandCount and the uint32 value
+        // at countOffsetBytes in that buffer. The state must use the layout's pipeline. The vertex buffers,
+        // index buffer and push constants are undefined after this call, so the state must be set again before
+        // the following draws or dispatches. Requires Feature::IndirectCommandLayouts.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with the layout's command signature.
+        // - Vulkan: Maps to vkCmdExecuteGeneratedCommandsEXT, the preprocess memory is allocated by NVRHI.
+        virtual void executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+            uint32_t countOffsetBytes = 0) = 0;
+
         // Sets the specified meshlet rendering state on the command list.
         // The state includes the pipeline and all resources bound to it.
         // Not supported on DX11.
@@ -3365,6 +4299,23 @@ namespace nvrhi
         // - Vulkan: Maps to vkCmdDispatchMesh.
         virtual void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
 
+        // Draws meshlet primitives using the parameters provided in the indirect buffer specified in the prior
+        // call to setMeshletState(...). The memory layout in the buffer is the same for all graphics APIs and is
+        // described by the DispatchIndirectArguments structure. If drawCount is more than 1, the argument structures
+        // are tightly packed in the buffer one after another.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with a predefined signature.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksIndirectEXT.
+        virtual void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
+
+        // Draws meshlet primitives using the parameters provided in the indirect buffer at offset 'paramOffsetBytes'.
+        // The draw count is read from the indirectCountBuffer specified in setMeshletState(...)
+        //   at offset 'countOffsetBytes', and is limited to maxDrawCount.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with pCountBuffer parameter.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksIndirectCountEXT.
+        virtual void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
+
         // Sets the specified ray tracing state on the command list.
         // The state includes the shader table, which references the pipeline, and all bound resources.
         // Not supported on DX11.
@@ -3409,12 +4360,52 @@ namespace nvrhi
         // Note that RTXMU currently doesn't support OMM or LSS.
         virtual void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries,
             size_t numGeometries, rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
+        // Builds or updates several BLASes at once, with the same rules for each build as in buildBottomLevelAccelStruct(...).
+        // The state transitions for all builds are committed as one barrier batch, and their scratch memory is
+        // suballocated back to back, so the builds can overlap on the GPU. Each BLAS may appear only once in a batch.
+        // - DX11: Not supported.
+        // - DX12: Maps to consecutive BuildRaytracingAccelerationStructure calls with no barriers in between.
+        // - Vulkan: Maps to a single vkCmdBuildAccelerationStructuresKHR call.
+        // With RTXMU enabled, the builds are forwarded to buildBottomLevelAccelStruct(...) one by one.
+        virtual void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) = 0;
         
         // Compacts all bottom-level ray tracing acceleration structures (BLASes) that are currently available
-        // for compaction. This process is handled by the RTXMU library. If NVRHI is built without RTXMU,
-        // this function has no effect.
+        // for compaction. When NVRHI is built with RTXMU, this process is handled by that library.
+        // Otherwise, BLASes built with AllowCompaction have their compacted size recorded during the build,
+        // and once that build has finished executing on the GPU, this function copies them into shared
+        // storage buffers allocated from a pool owned by the device. Compaction changes the BLAS GPU address,
+        // so any TLAS that references a compacted BLAS must be rebuilt before it is used again.
         virtual void compactBottomLevelAccelStructs() = 0;
 
+        // Writes the size of the data that serializeAccelStruct(...) would produce for a built BLAS
+        // as an rt::AccelStructSerializedSizeInfo structure into the buffer at the given offset, aligned to 8 bytes.
+        // The buffer is transitioned into the UnorderedAccess state on DX12 and into CopyDest on Vulkan.
+        // - DX11: Not supported.
+        // - DX12: Maps to EmitRaytracingAccelerationStructurePostbuildInfo with the SERIALIZATION info type.
+        // - Vulkan: Maps to vkCmdWriteAccelerationStructuresPropertiesKHR and vkCmdCopyQueryPoolResults.
+        // Not supported when NVRHI is built with RTXMU.
+        virtual void writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) = 0;
+
+        // Serializes a built BLAS into the buffer at the given offset, aligned to 256 bytes. The data starts with
+        // an rt::AccelStructSerializedHeader and can be stored on disk to skip the build on later runs, see
+        // IDevice::isSerializedAccelStructCompatible(...). The buffer is transitioned into the UnorderedAccess state.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyRaytracingAccelerationStructure with the SERIALIZE copy mode.
+        // - Vulkan: Maps to vkCmdCopyAccelerationStructureToMemoryKHR.
+        // Not supported when NVRHI is built with RTXMU.
+        virtual void serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) = 0;
+
+        // Restores a BLAS from data written by serializeAccelStruct(...), replacing a build.
+        // The BLAS must be created with at least the header's deserializedSize bytes of memory, which is the case
+        // when it uses the same descriptor as the serialized BLAS. The buffer must be created with
+        // isAccelStructBuildInput = true and is transitioned into the AccelStructBuildInput state.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyRaytracingAccelerationStructure with the DESERIALIZE copy mode.
+        // - Vulkan: Maps to vkCmdCopyMemoryToAccelerationStructureKHR.
+        // Not supported when NVRHI is built with RTXMU.
+        virtual void deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) = 0;
+
         // Builds or updates a top-level ray tracing acceleration structure (TLAS).
         // A temporary memory region for the build is suballocated using the scratch buffer manager attached to the
         // command list. The size of this memory region is determined automatically inside this function.
@@ -3449,6 +4440,35 @@ namespace nvrhi
             uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
 
+        // Allocates upload memory for numInstances TLAS instances in the native layout and returns a CPU pointer to it.
+        // The application fills the instances directly, e.g. from several worker threads, which avoids the conversion
+        // done by buildTopLevelAccelStruct(...). Instances reference BLAS'es by device address, with no state
+        // or liveness tracking, like in buildTopLevelAccelStructFromBuffer(...).
+        // The memory is usually write-combined, so it should be written sequentially and never read. It stays valid
+        // until the command list is executed, and must be fully written by then.
+        // Returns nullptr if the upload memory cannot be allocated.
+        // - DX11: Not supported.
+        virtual rt::IndirectInstanceDesc* allocateTopLevelInstances(size_t numInstances) = 0;
+
+        // Builds or updates a TLAS using instances written into memory returned by allocateTopLevelInstances(...)
+        // on this command list since it was opened. The build can be recorded before the instances are written.
+        // See the comment to buildTopLevelAccelStruct(...) for more information.
+        // - DX11: Not supported.
+        // - DX12: Maps to BuildRaytracingAccelerationStructure.
+        // - Vulkan: Maps to vkCmdBuildAccelerationStructuresKHR.
+        virtual void buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances,
+            size_t numInstances, rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
+        // Converts numInstances instances into the native layout and writes them into the persistent instance buffer
+        // of the TLAS, starting at firstInstance. Only the written range is uploaded, so the other instances keep
+        // their previous contents. Referenced BLAS'es are state and liveness tracked like in buildTopLevelAccelStruct(...).
+        // After updating all dirty ranges, build or refit the TLAS with buildTopLevelAccelStructFromBuffer(...),
+        // passing as->getInstanceBuffer() as the instance buffer.
+        // The TLAS must be created with persistentInstanceBuffer = true.
+        // - DX11: Not supported.
+        virtual void updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance,
+            const rt::InstanceDesc* pInstances, size_t numInstances) = 0;
+
         // Converts one or several CoopVec compatible matrices between layouts in GPU memory.
         // Source and destination buffers must be different.
         // - DX11: Not supported.
@@ -3472,6 +4492,58 @@ namespace nvrhi
         // - Vulkan: Maps to vkCmdWriteTimestamp.
         virtual void endTimerQuery(ITimerQuery* query) = 0;
 
+        // Prepares a range of timestamps in the pool for writing. Must be called before the timestamps are written
+        // again, in a command list that executes before the ones writing them.
+        // - DX11: Not supported.
+        // - DX12: No-op.
+        // - Vulkan: Maps to vkCmdResetQueryPool.
+        virtual void resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) = 0;
+
+        // Writes the GPU timestamp at this point in the command list into the pool.
+        // - DX11: Not supported.
+        // - DX12: Maps to EndQuery.
+        // - Vulkan: Maps to vkCmdWriteTimestamp.
+        virtual void writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex) = 0;
+
+        // Copies a range of written timestamps into the pool's readback storage with a single command.
+        // Use IDevice::getTimestampResults(...) to read them after the command list has finished executing.
+        // - DX11: Not supported.
+        // - DX12: Maps to ResolveQueryData.
+        // - Vulkan: Maps to vkCmdCopyQueryPoolResults.
+        virtual void resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) = 0;
+
+        // Prepares a range of queries in the pool for use. Must be called outside of beginQuery/endQuery ranges,
+        // before the queries are used again.
+        // - DX11: Not supported.
+        // - DX12: No-op.
+        // - Vulkan: Maps to vkCmdResetQueryPool.
+        virtual void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) = 0;
+
+        // Starts and stops counting for one query of the pool. On Vulkan, a query that counts draws must begin and
+        // end within the same render pass, i.e. after setGraphicsState and without changing the framebuffer.
+        // - DX11: Not supported.
+        // - DX12: Maps to BeginQuery and EndQuery.
+        // - Vulkan: Maps to vkCmdBeginQuery and vkCmdEndQuery.
+        virtual void beginQuery(IQueryPool* pool, uint32_t queryIndex) = 0;
+        virtual void endQuery(IQueryPool* pool, uint32_t queryIndex) = 0;
+
+        // Writes the results of a range of finished queries into a buffer with a single command.
+        // destOffsetBytes must be a multiple of 8.
+        // - DX11: Not supported.
+        // - DX12: Maps to ResolveQueryData.
+        // - Vulkan: Maps to vkCmdCopyQueryPoolResults.
+        virtual void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes) = 0;
+
+        // Makes the following draw and dispatch commands conditional on a 64-bit value in the buffer, evaluated by
+        // the GPU, e.g. a resolved BinaryOcclusion query. The buffer must have the isPredicationBuffer flag.
+        // Predication ranges cannot be nested and must be closed with endPredication().
+        // Requires Feature::Predication.
+        // - DX11: Not supported.
+        // - DX12: Maps to SetPredication.
+        // - Vulkan: Maps to vkCmdBeginConditionalRenderingEXT, which only reads the lower 32 bits of the value.
+        virtual void beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op) = 0;
+        virtual void endPredication() = 0;
+
         // Places a debug marker denoting the beginning of a range of commands in the command list.
         // Use endMarker() to denote the end of the range. Ranges may be nested, i.e. calling beginMarker(...)
         // multiple times, followed by multiple endMarker(), is allowed.
@@ -3499,6 +4571,9 @@ namespace nvrhi
         // Sets the necessary resource states for all targets of the framebuffer.
         NVRHI_API void setResourceStatesForFramebuffer(IFramebuffer* framebuffer);
 
+        // Sets the necessary resource states for all resources listed in the render pass scope.
+        NVRHI_API void setResourceStatesForRenderPassScope(const RenderPassScope& scope);
+
         // Enables or disables the placement of UAV barriers for the given texture (DX12/VK) or all resources (DX11)
         // between draw or dispatch calls. Disabling UAV barriers may improve performance in cases when the same
         // resource is used by multiple draws or dispatches, but they don't depend on each other's results.
@@ -3540,6 +4615,54 @@ namespace nvrhi
         // Has no effect on DX11.
         virtual void setBufferState(IBuffer* buffer, ResourceStates stateBits) = 0;
 
+        // Starts a split transition of the texture or some of its subresources into the given state. The GPU may
+        // perform the transition in the background while it executes the commands recorded between this call and
+        // the end of the transition. The transition ends automatically when the texture is next used or its state
+        // is set, or when the command list is closed. The texture must not be used by any commands without automatic
+        // barriers while the transition is in progress.
+        // The begin barrier is placed to the pending list, see the comment to setTextureState(...).
+        // UAV barriers and transitions of textures in a permanent state are not split.
+        // - DX11: Has no effect.
+        // - DX12: Maps to a pair of transition barriers with D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY / END_ONLY.
+        // - Vulkan: Maps to vkCmdSetEvent2 and vkCmdWaitEvents2 with the same dependency info.
+        virtual void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources,
+            ResourceStates stateBits) = 0;
+
+        // Starts a split transition of the buffer into the given state.
+        // See the comment to beginTextureStateTransition(...) for more information.
+        virtual void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) = 0;
+
+        // Hands the texture or some of its subresources over from the queue that executes this command list
+        // to another queue, leaving it in the given state. The other queue must record a matching
+        // acquireTextureOwnership(...) call with the same subresources and state in a command list that executes
+        // after this one, and wait for this command list using IDevice::queueWaitForCommandList(...).
+        // The texture must not be used by this command list after the release.
+        // Only the queues that actually exchange the resource are synchronized, which allows work on different
+        // queues to overlap without waiting for whole queues and without sharing the resources between queues.
+        // - DX11: Has no effect.
+        // - DX12: Transitions the texture into the given state, which must be supported by the destination queue.
+        //   The fence wait provides the rest of the handoff.
+        // - Vulkan: Maps to a queue family ownership release barrier, which is only necessary when the queues
+        //   belong to different families; otherwise it is a regular barrier.
+        virtual void releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources,
+            CommandQueue destinationQueue, ResourceStates stateBits) = 0;
+
+        // Takes over the texture released by another queue with releaseTextureOwnership(...) and starts tracking
+        // it in the given state, which must be the same as in the release.
+        // - DX11: Has no effect.
+        // - DX12: Equivalent to beginTrackingTextureState(...).
+        // - Vulkan: Maps to a queue family ownership acquire barrier.
+        virtual void acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources,
+            CommandQueue sourceQueue, ResourceStates stateBits) = 0;
+
+        // Hands the buffer over to another queue.
+        // See the comment to releaseTextureOwnership(...) for more information.
+        virtual void releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits) = 0;
+
+        // Takes over the buffer released by another queue.
+        // See the comment to acquireTextureOwnership(...) for more information.
+        virtual void acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits) = 0;
+
         // Places the necessary barriers to make sure that the underlying buffer for the acceleration structure is
         // in the given state. See the comment to setTextureState(...) for more information.
         // Has no effect on DX11.
@@ -3563,6 +4686,19 @@ namespace nvrhi
         // Has no effect on DX11.
         virtual void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) = 0;
 
+        // Declares that 'resourceAfter' starts using memory that is shared with other placed resources, such as
+        // 'resourceBefore', and places an aliasing barrier between them. 'resourceBefore' may be null, which means
+        // that the barrier synchronizes with any resource that used the memory before.
+        // The tracked state of 'resourceAfter' is reset to Common and its contents become undefined. Render targets and
+        // depth-stencil textures must be cleared before their first use after the barrier, other resources must
+        // be completely overwritten.
+        // The barrier is placed to the pending list, see the comment to setTextureState(...).
+        // - DX11: Has no effect.
+        // - DX12: Maps to a D3D12_RESOURCE_BARRIER_TYPE_ALIASING barrier.
+        // - Vulkan: Maps to a global memory barrier, the next layout transition of the texture starts from
+        //   VK_IMAGE_LAYOUT_UNDEFINED and waits for all prior commands.
+        virtual void setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) = 0;
+
         // Flushes the barriers from the pending list into the graphics API command list.
         // Has no effect on DX11.
         virtual void commitBarriers() = 0;
@@ -3583,10 +4719,90 @@ namespace nvrhi
 
         // Returns the CommandListParameters structure that was used to create the command list. 
         virtual const CommandListParameters& getDesc() = 0;
+
+        // Returns the barrier counters of the current or last recording of the command list. The counters are
+        // reset by open(). All counters are zero unless CommandListParameters::enableBarrierStatistics is set.
+        virtual BarrierStatistics getBarrierStatistics() = 0;
+
+        // Returns the CPU-side counters of the current or last recording of the command list, reset by open().
+        virtual CommandListStatistics getStatistics() = 0;
     };
 
     typedef RefCountPtr<ICommandList> CommandListHandle;
 
+    //////////////////////////////////////////////////////////////////////////
+    // Asynchronous pipeline creation
+    //////////////////////////////////////////////////////////////////////////
+
+    // Result of one of the IDevice::create...PipelineAsync calls.
+    // The pipeline is created on one of the device's pipeline compile threads, and the object becomes ready
+    // once the creation has finished, successfully or not. Until then, the render code is expected to skip
+    // the draws that need this pipeline, or to substitute a different pipeline.
+    class IPendingPipeline : public IResource
+    {
+    public:
+        // Returns true when the pipeline creation has finished. Never blocks.
+        [[nodiscard]] virtual bool isReady() = 0;
+
+        // Blocks until the pipeline creation has finished.
+        virtual void wait() = 0;
+
+        // Return the created pipeline of the requested type, or nullptr if it's not ready yet
+        // or if the creation has failed. Only the function matching the create...Async call can return non-null.
+        virtual IGraphicsPipeline* getGraphicsPipeline() = 0;
+        virtual IComputePipeline* getComputePipeline() = 0;
+        virtual IMeshletPipeline* getMeshletPipeline() = 0;
+        virtual rt::IPipeline* getRayTracingPipeline() = 0;
+    };
+
+    typedef RefCountPtr<IPendingPipeline> PendingPipelineHandle;
+
+    //////////////////////////////////////////////////////////////////////////
+    // Submission Graph
+    //////////////////////////////////////////////////////////////////////////
+
+    // A value on the timeline of a queue, i.e. an instance returned by IDevice::executeCommandLists(...)
+    // or IDevice::executeSubmitGraph(...). The timeline is the queue's native fence (DX12) or timeline semaphore
+    // (Vulkan) that can be obtained with IDevice::getNativeQueue(ObjectTypes::D3D12_Fence or VK_Semaphore, queue),
+    // and the instance is the value that it is signaled with, so other devices, APIs or processes can wait for it.
+    struct TimelinePoint
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t instance = 0;
+
+        TimelinePoint() = default;
+        TimelinePoint(CommandQueue _queue, uint64_t _instance) : queue(_queue), instance(_instance) { }
+    };
+
+    // One node of a SubmitGraphDesc: a group of command lists executed on one queue, in order.
+    struct SubmitNode
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        std::vector<ICommandList*> commandLists;
+
+        // Indices of the nodes in the same graph that must finish before this node starts.
+        // Only the nodes that come before this one can be referenced, which keeps the graph acyclic.
+        // Dependencies on nodes on the same queue are satisfied by the submission order.
+        std::vector<uint32_t> dependencies;
+
+        // Instances of previous submissions that must finish before this node starts.
+        std::vector<TimelinePoint> waits;
+
+        SubmitNode& setQueue(CommandQueue value) { queue = value; return *this; }
+        SubmitNode& addCommandList(ICommandList* value) { commandLists.push_back(value); return *this; }
+        SubmitNode& addDependency(uint32_t nodeIndex) { dependencies.push_back(nodeIndex); return *this; }
+        SubmitNode& addWait(const TimelinePoint& value) { waits.push_back(value); return *this; }
+    };
+
+    // Describes the work for multiple queues together with the dependencies between them, so that it can be
+    // submitted with one call to IDevice::executeSubmitGraph(...).
+    struct SubmitGraphDesc
+    {
+        std::vector<SubmitNode> nodes;
+
+        SubmitGraphDesc& addNode(const SubmitNode& value) { nodes.push_back(value); return *this; }
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // IDevice
     //////////////////////////////////////////////////////////////////////////
@@ -3611,12 +4827,30 @@ namespace nvrhi
         virtual void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) = 0;
         virtual void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
 
+        // Updates the tile mappings of several textures at once. On Vulkan, all updates are submitted with one
+        // vkQueueBindSparse call; D3D12 needs one UpdateTileMappings call per texture and heap.
+        // The mappings of each texture are applied in order.
+        virtual void updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
+
         virtual SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) = 0;
         virtual SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) = 0;
 
         virtual BufferHandle createBuffer(const BufferDesc& d) = 0;
+        // Creates a buffer that aliases application-owned host memory, without copying it, see Feature::HostMemoryImport.
+        // The memory must outlive the buffer and any GPU work that uses it. hostMemory and d.byteSize must be multiples
+        // of HostMemoryImportFeatureInfo::minPointerAlignment; on D3D12, hostMemory must also be the base address of
+        // a VirtualAlloc or MapViewOfFile allocation. The buffer starts and stays in the Common state; d.initialState is ignored.
+        virtual BufferHandle createBufferFromHostMemory(const BufferDesc& d, void* hostMemory) = 0;
         virtual void* mapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess) = 0;
+        // Maps a byte range of the buffer and returns a pointer to the start of that range.
+        // Read mappings only make the mapped range visible to the CPU. Write mappings are not published to the GPU
+        // automatically when the memory is not coherent: use flushMappedRange on the ranges that were actually written.
+        virtual void* mapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess, uint64_t offset, size_t size) = 0;
         virtual void unmapBuffer(IBuffer* buffer) = 0;
+        // Make the CPU writes into a range of a mapped buffer visible to the GPU, or the GPU writes visible to the CPU.
+        // The offsets are relative to the start of the buffer. Both are no-ops on coherent memory.
+        virtual void flushMappedRange(IBuffer* buffer, uint64_t offset, size_t size) = 0;
+        virtual void invalidateMappedRange(IBuffer* buffer, uint64_t offset, size_t size) = 0;
         virtual MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) = 0;
         virtual bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) = 0;
 
@@ -3645,10 +4879,30 @@ namespace nvrhi
         virtual float getTimerQueryTime(ITimerQuery* query) = 0;
         virtual void resetTimerQuery(ITimerQuery* query) = 0;
 
+        // Timestamp query pools - see also resetTimestamps, writeTimestamp and resolveTimestamps in ICommandList.
+        // getTimestampResults copies resolved timestamps, in ticks, into outTimestamps without waiting for the GPU;
+        // the results are undefined if the command list that resolved them has not finished yet.
+        // getTimestampFrequency returns the number of ticks per second for timestamps written on the given queue.
+        // Not supported on DX11, where createTimestampQueryPool returns nullptr.
+        virtual TimestampQueryPoolHandle createTimestampQueryPool(const TimestampQueryPoolDesc& desc) = 0;
+        virtual bool getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) = 0;
+        virtual uint64_t getTimestampFrequency(CommandQueue queue) = 0;
+
+        // Query pools - see also resetQueries, beginQuery, endQuery and resolveQueries in ICommandList
+        virtual QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) = 0;
+
         // Returns the API kind that the RHI backend is running on top of.
         virtual GraphicsAPI getGraphicsAPI() = 0;
         
         virtual FramebufferHandle createFramebuffer(const FramebufferDesc& desc) = 0;
+
+        // Records the draws of the bundle into a D3D12 bundle or a Vulkan secondary command buffer.
+        // See the comment to CommandBundleDesc for the restrictions on the draws.
+        virtual CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) = 0;
+
+        // Creates a D3D12 command signature or a Vulkan indirect commands layout.
+        // Requires Feature::IndirectCommandLayouts, see the comment to IndirectCommandLayoutDesc.
+        virtual IndirectCommandLayoutHandle createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc) = 0;
         
         virtual GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) = 0;
 
@@ -3663,6 +4917,24 @@ namespace nvrhi
         virtual MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) = 0;
 
         virtual rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) = 0;
+
+        // Creates a new ray tracing pipeline that contains everything from 'pipeline' plus the shaders and hit groups
+        // from 'additions', compiling only the additions. Uses ID3D12Device7::AddToStateObject on D3D12 and
+        // VK_KHR_pipeline_library on Vulkan. Requires Feature::RayTracingPipelineLibraries, and 'pipeline' must have
+        // been created with allowAdditions. The global binding layouts, payload and attribute sizes, recursion depth
+        // and other settings are inherited from 'pipeline', and only 'shaders' and 'hitGroups' are used from 'additions'.
+        // The original pipeline and its shader tables remain valid; new shader tables must be created from the result
+        // to use the added exports. The result allows further additions.
+        virtual rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) = 0;
+
+        // Asynchronous versions of the pipeline creation functions above. The work is queued to a pool of
+        // compile threads owned by the device, see the backend DeviceDesc::numPipelineCompileThreads fields.
+        // The objects referenced by the desc (shaders, layouts) are kept alive until the creation has finished.
+        virtual PendingPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) = 0;
+        virtual PendingPipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc) = 0;
+        virtual PendingPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) = 0;
+        virtual PendingPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) = 0;
+        virtual PendingPipelineHandle addToRayTracingPipelineAsync(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) = 0;
         
         virtual BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) = 0;
         virtual BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) = 0;
@@ -3673,22 +4945,66 @@ namespace nvrhi
         virtual void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) = 0;
         virtual bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) = 0;
 
+        // Writes multiple descriptors into a descriptor table with a single update, which is much cheaper
+        // than calling writeDescriptorTable for each item when streaming large numbers of resources.
+        // Returns false if any of the items could not be written; the other items are still written.
+        // Descriptor table writes may be issued from multiple threads concurrently, including to the same table,
+        // as long as the written slots are not used by commands that are currently executing on the GPU.
+        virtual bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems) = 0;
+
         virtual rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) = 0;
         virtual rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) = 0;
         virtual MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) = 0;
+
+        // Returns the result and scratch memory sizes for building an acceleration structure with the given
+        // descriptor, without creating it. The scratch memory is suballocated by the command list during the build.
+        // - DX11: Not supported.
+        // - DX12: Maps to GetRaytracingAccelerationStructurePrebuildInfo.
+        // - Vulkan: Maps to vkGetAccelerationStructureBuildSizesKHR.
+        virtual rt::AccelStructBuildSizes getAccelStructBuildSizes(const rt::AccelStructDesc& desc) = 0;
+
+        // Tests if serialized acceleration structure data can be deserialized on this device. The data is only
+        // compatible with the same GPU and driver version, so the application must rebuild the BLAS when this
+        // returns false.
+        // - DX11: Always returns false.
+        // - DX12: Maps to CheckDriverMatchingIdentifier.
+        // - Vulkan: Maps to vkGetDeviceAccelerationStructureCompatibilityKHR.
+        virtual bool isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header) = 0;
         virtual rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) = 0;
         virtual bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) = 0;
         
         virtual CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) = 0;
         virtual uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
         virtual void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) = 0;
+
+        // Submits the nodes of the graph to their queues with as few native submissions as possible.
+        // Consecutive nodes on one queue are merged into one submission unless they wait for another queue,
+        // or another queue waits for them, and cross-queue dependencies become fence or timeline semaphore waits.
+        // The instance of each node is written into pInstances[nodeIndex] if pInstances is not NULL;
+        // nodes that were merged into one submission share the instance.
+        // The waits added with queueWaitForCommandList(...) apply to the first submission on their queue.
+        // - DX11: command lists are executed immediately, so this call does nothing and returns zero instances.
+        virtual void executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances = nullptr) = 0;
+
         // returns true if the wait completes successfully, false if detecting a problem (e.g. device removal)
         virtual bool waitForIdle() = 0;
 
         // Releases the resources that were referenced in the command lists that have finished executing.
-        // IMPORTANT: Call this method at least once per frame.
+        // IMPORTANT: Call this method at least once per frame, unless the background garbage collection is enabled.
         virtual void runGarbageCollection() = 0;
 
+        // Same as runGarbageCollection(), but stops when the budget is used up, to avoid frame time spikes
+        // after large unloads. The remaining command lists are retired by the next calls.
+        // Returns true if all command lists that have finished executing have been retired.
+        virtual bool runIncrementalGarbageCollection(const GarbageCollectionBudget& budget) = 0;
+
+        // Starts or stops a worker thread that polls the queues every intervalMilliseconds and retires the finished
+        // command lists, so that the native objects released by them are destroyed on that thread.
+        // The worker doesn't check the memory budget, see IMessageCallback::memoryBudgetExceeded,
+        // so runGarbageCollection() may still be called for that.
+        // - DX11: does nothing, DX11 doesn't track the command lists in flight.
+        virtual void setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds = 2) = 0;
+
         virtual bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) = 0;
 
         virtual FormatSupport queryFormatSupport(Format format) = 0;
@@ -3703,9 +5019,56 @@ namespace nvrhi
 
         virtual IMessageCallback* getMessageCallback() = 0;
 
+        // Registers a callback that receives the begin and end events of the zones listed in InstrumentationZone,
+        // or removes it when called with nullptr. Without a callback, an instrumented operation costs one branch.
+        // The callback may be replaced at any time, but the old one must stay alive until the operations that
+        // are running on other threads have finished.
+        // - DX11: there are no upload chunks, barriers or garbage collection to report.
+        virtual void setInstrumentationCallback(IInstrumentationCallback* callback) = 0;
+
         virtual bool isAftermathEnabled() = 0;
         virtual AftermathCrashDumpHelper& getAftermathCrashDumpHelper() = 0;
 
+        // Serializes the pipeline cache that the device has accumulated, so that it can be passed to
+        // the backend's DeviceDesc::pipelineCacheData on the next run, and pipelines that have been
+        // created before are loaded from the cache instead of being compiled by the driver again.
+        // Call with data == nullptr to query the required size. Returns false when the backend has no pipeline cache,
+        // or when *dataSize is too small.
+        // - DX11: not supported, the driver maintains its own shader cache
+        // - DX12: ID3D12PipelineLibrary::Serialize, pipelines are keyed by a hash of their translated desc
+        // - Vulkan: vkGetPipelineCacheData
+        virtual bool getPipelineCacheData(void* data, size_t* dataSize) = 0;
+
+        // Returns the usage statistics of the shared upload ring of the specified queue,
+        // see CommandListParameters::useSharedUploadRing. DX11 has no upload rings and returns empty statistics.
+        virtual UploadRingStatistics getUploadRingStatistics(CommandQueue queue) = 0;
+
+        // Returns the budget and usage of the memory heaps and the amounts of memory allocated by NVRHI.
+        // Also notifies the message callback if any heap is over budget, see IMessageCallback::memoryBudgetExceeded.
+        virtual MemoryStatistics getMemoryStatistics() = 0;
+
+        // Reports every live allocation of the device to the callback, for per-resource memory views.
+        // The registry of allocations is locked during the enumeration: the callback must not create or destroy
+        // resources on this device. DX11 reports estimated sizes and doesn't support placed resources.
+        virtual void enumerateResourceAllocations(IResourceAllocationCallback& callback) = 0;
+
+        // Returns the sum of the barrier counters of the command lists with enableBarrierStatistics
+        // that were executed on the queue since the device was created or resetBarrierStatistics was called.
+        virtual BarrierStatistics getBarrierStatistics(CommandQueue queue) = 0;
+        virtual void resetBarrierStatistics() = 0;
+
+        // Returns the sum of the statistics of the command lists that were executed on the queue since the device
+        // was created or resetCommandListStatistics was called. Call resetCommandListStatistics once per frame
+        // to get per-frame totals.
+        virtual CommandListStatistics getCommandListStatistics(CommandQueue queue) = 0;
+        virtual void resetCommandListStatistics() = 0;
+
+        // Returns the timing and cache hit counters of the pipelines created since the device was created
+        // or resetPipelineCreationStatistics was called. The per-pipeline values are reported to
+        // IInstrumentationCallback::pipelineCreated.
+        virtual PipelineCreationStatistics getPipelineCreationStatistics() = 0;
+        virtual void resetPipelineCreationStatistics() = 0;
+
         // Front-end for executeCommandLists(..., 1) for compatibility and convenience
         uint64_t executeCommandList(ICommandList* commandList, CommandQueue executionQueue = CommandQueue::Graphics)
         {
@@ -3787,6 +5150,75 @@ namespace std
         }
     };
 
+    template<> struct hash<nvrhi::VertexAttributeDesc>
+    {
+        std::size_t operator()(nvrhi::VertexAttributeDesc const& s) const noexcept
+        {
+            size_t value = 0;
+            nvrhi::hash_combine(value, s.name);
+            nvrhi::hash_combine(value, s.format);
+            nvrhi::hash_combine(value, s.arraySize);
+            nvrhi::hash_combine(value, s.bufferIndex);
+            nvrhi::hash_combine(value, s.offset);
+            nvrhi::hash_combine(value, s.elementStride);
+            nvrhi::hash_combine(value, s.isInstanced);
+            return value;
+        }
+    };
+
+    template<> struct hash<nvrhi::SamplerDesc>
+    {
+        std::size_t operator()(nvrhi::SamplerDesc const& s) const noexcept
+        {
+            size_t value = 0;
+            nvrhi::hash_combine(value, s.borderColor.r);
+            nvrhi::hash_combine(value, s.borderColor.g);
+            nvrhi::hash_combine(value, s.borderColor.b);
+            nvrhi::hash_combine(value, s.borderColor.a);
+            nvrhi::hash_combine(value, s.maxAnisotropy);
+            nvrhi::hash_combine(value, s.mipBias);
+            nvrhi::hash_combine(value, s.minFilter);
+            nvrhi::hash_combine(value, s.magFilter);
+            nvrhi::hash_combine(value, s.mipFilter);
+            nvrhi::hash_combine(value, s.addressU);
+            nvrhi::hash_combine(value, s.addressV);
+            nvrhi::hash_combine(value, s.addressW);
+            nvrhi::hash_combine(value, s.reductionType);
+            return value;
+        }
+    };
+
+    template<> struct hash<nvrhi::BindingLayoutItem>
+    {
+        std::size_t operator()(nvrhi::BindingLayoutItem const& s) const noexcept
+        {
+            size_t value = 0;
+            nvrhi::hash_combine(value, s.slot);
+            nvrhi::hash_combine(value, nvrhi::ResourceType(s.type));
+            nvrhi::hash_combine(value, uint16_t(s.size));
+            return value;
+        }
+    };
+
+    template<> struct hash<nvrhi::BindingLayoutDesc>
+    {
+        std::size_t operator()(nvrhi::BindingLayoutDesc const& s) const noexcept
+        {
+            size_t value = 0;
+            nvrhi::hash_combine(value, s.visibility);
+            nvrhi::hash_combine(value, s.registerSpace);
+            nvrhi::hash_combine(value, s.registerSpaceIsDescriptorSet);
+            nvrhi::hash_combine(value, s.usePushDescriptors);
+            for (const auto& item : s.bindings)
+                nvrhi::hash_combine(value, item);
+            nvrhi::hash_combine(value, s.bindingOffsets.shaderResource);
+            nvrhi::hash_combine(value, s.bindingOffsets.sampler);
+            nvrhi::hash_combine(value, s.bindingOffsets.constantBuffer);
+            nvrhi::hash_combine(value, s.bindingOffsets.unorderedAccess);
+            return value;
+        }
+    };
+
     template<> struct hash<nvrhi::FramebufferInfo>
     {
         std::size_t operator()(nvrhi::FramebufferInfo const& s) const noexcept
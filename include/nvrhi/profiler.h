@@ -0,0 +1,130 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <string>
+#include <vector>
+
+namespace nvrhi::profiler
+{
+    struct GpuProfilerDesc
+    {
+        // Number of frames whose timestamps can be in flight at once. Results become available this many frames
+        // later at the earliest; frames that would need more slots are not profiled, rather than waited for.
+        uint32_t maxFramesInFlight = 3;
+
+        // Scopes beyond this count in one frame are still marked, but not timed
+        uint32_t maxScopesPerFrame = 256;
+
+        // Queue that the profiled command lists are executed on
+        CommandQueue queue = CommandQueue::Graphics;
+
+        // Also place debug markers around the scopes, so that they appear in graphics debuggers
+        bool emitMarkers = true;
+
+        std::string debugName;
+
+        GpuProfilerDesc& setMaxFramesInFlight(uint32_t value) { maxFramesInFlight = value; return *this; }
+        GpuProfilerDesc& setMaxScopesPerFrame(uint32_t value) { maxScopesPerFrame = value; return *this; }
+        GpuProfilerDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        GpuProfilerDesc& setEmitMarkers(bool value) { emitMarkers = value; return *this; }
+        GpuProfilerDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    struct GpuProfilerScope
+    {
+        std::string name;
+
+        // Nesting depth, 0 for the outermost scopes
+        uint32_t depth = 0;
+
+        // Index of the enclosing scope in GpuProfilerFrame::scopes, or c_NoParent for the outermost scopes
+        uint32_t parentIndex = 0;
+
+        // GPU time of the scope boundaries in seconds, relative to the beginning of the frame
+        double beginTime = 0.0;
+        double endTime = 0.0;
+
+        static constexpr uint32_t c_NoParent = ~0u;
+
+        [[nodiscard]] double getDuration() const { return endTime - beginTime; }
+    };
+
+    struct GpuProfilerFrame
+    {
+        // Value returned by the beginFrame call of this frame
+        uint64_t frameIndex = 0;
+
+        // GPU time between the beginFrame and endFrame calls, in seconds
+        double frameTime = 0.0;
+
+        // The scope tree in depth-first order: every scope comes after its parent, and before its next sibling
+        std::vector<GpuProfilerScope> scopes;
+    };
+
+    // A frame-scoped GPU profiler. All timestamps of a frame come from one range of a timestamp query pool
+    // and are resolved with a single command, and the results are read back several frames later
+    // without waiting for the GPU. Usage:
+    //
+    //     profiler->beginFrame(commandList);
+    //     profiler->beginScope(commandList, "Shadows"); ... profiler->endScope(commandList);
+    //     profiler->endFrame(commandList);
+    //     device->executeCommandList(commandList);
+    //     profiler->markSubmitted();
+    //
+    //     GpuProfilerFrame frame;
+    //     if (profiler->getLatestFrame(frame)) ...
+    //
+    // A frame may span several command lists on the profiler's queue, as long as the one with beginFrame is
+    // executed first and the one with endFrame last. Not supported on DX11.
+    class IGpuProfiler : public IResource
+    {
+    public:
+        // Starts a new frame and returns its index. If all frame slots are still in flight, the frame is not
+        // profiled, and its scopes only emit markers.
+        virtual uint64_t beginFrame(ICommandList* commandList) = 0;
+
+        // Scopes nest like beginMarker/endMarker and may be opened and closed in different command lists.
+        virtual void beginScope(ICommandList* commandList, const char* name) = 0;
+        virtual void endScope(ICommandList* commandList) = 0;
+
+        // Closes the frame and records the resolve of all its timestamps.
+        virtual void endFrame(ICommandList* commandList) = 0;
+
+        // Marks the frame closed by the last endFrame call as submitted. Call it right after the command list
+        // with endFrame has been executed.
+        virtual void markSubmitted() = 0;
+
+        // Copies the results of the most recent frame that has finished on the GPU and returns true,
+        // or returns false if no frame has finished since the previous call.
+        virtual bool getLatestFrame(GpuProfilerFrame& outFrame) = 0;
+    };
+
+    typedef RefCountPtr<IGpuProfiler> GpuProfilerHandle;
+
+    NVRHI_API GpuProfilerHandle createGpuProfiler(IDevice* device, const GpuProfilerDesc& desc);
+}
@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::readback
+{
+    struct ReadbackRingDesc
+    {
+        // Number of staging resources in the ring, i.e. the number of readbacks that can be in flight at once
+        uint32_t numSlots = 3;
+
+        // Size of the staging buffers used by copyBuffer, 0 if buffer readbacks are not needed
+        uint64_t bufferSize = 0;
+
+        // Description of the staging textures used by copyTexture, which can read back regions up to its size.
+        // Leave the format as UNKNOWN if texture readbacks are not needed.
+        TextureDesc textureDesc;
+
+        // Queue that the command lists with the copies are executed on
+        CommandQueue queue = CommandQueue::Graphics;
+
+        std::string debugName;
+
+        ReadbackRingDesc& setNumSlots(uint32_t value) { numSlots = value; return *this; }
+        ReadbackRingDesc& setBufferSize(uint64_t value) { bufferSize = value; return *this; }
+        ReadbackRingDesc& setTextureDesc(const TextureDesc& value) { textureDesc = value; return *this; }
+        ReadbackRingDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        ReadbackRingDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Identifies one readback. A ticket stays valid until its slot is reused, which happens no earlier than
+    // numSlots copies later, and only after the ticket's data has been unmapped.
+    typedef uint64_t ReadbackTicket;
+    constexpr ReadbackTicket c_InvalidReadbackTicket = 0;
+
+    // A ring of staging buffers or textures for latency-tolerant readbacks, such as auto-exposure or GPU picking.
+    // Unlike mapping a staging resource directly, none of the functions wait for the GPU: readbacks that are
+    // not finished yet are reported as not ready, and copies are rejected when every slot is still in flight.
+    // The functions are thread-safe.
+    class IReadbackRing : public IResource
+    {
+    public:
+        // Record a copy into the next free slot of the ring. Return c_InvalidReadbackTicket if there is no free slot
+        // or the ring was not created for this kind of readback, in which case nothing is recorded.
+        virtual ReadbackTicket copyBuffer(ICommandList* commandList, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSize) = 0;
+        virtual ReadbackTicket copyTexture(ICommandList* commandList, ITexture* src, const TextureSlice& srcSlice) = 0;
+
+        // Marks the copies recorded since the previous call as submitted. Call it right after the command lists
+        // with the copies have been executed on ReadbackRingDesc::queue.
+        virtual void markSubmitted() = 0;
+
+        // Returns true when the GPU has finished the copy.
+        virtual bool isReady(ReadbackTicket ticket) = 0;
+
+        // Maps the data of a finished readback, or returns nullptr if it's not ready or the ticket is no longer valid.
+        // For texture readbacks, outRowPitch receives the row pitch of the data.
+        virtual const void* tryMap(ReadbackTicket ticket, size_t* outRowPitch = nullptr) = 0;
+        virtual void unmap(ReadbackTicket ticket) = 0;
+    };
+
+    typedef RefCountPtr<IReadbackRing> ReadbackRingHandle;
+
+    NVRHI_API ReadbackRingHandle createReadbackRing(IDevice* device, const ReadbackRingDesc& desc);
+}
@@ -0,0 +1,139 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::streaming
+{
+    // Identifies the encoding of a compressed payload, such as GDeflate. The values are defined by the decompressor,
+    // nvrhi only passes them through.
+    typedef uint32_t CompressionFormat;
+
+    struct DecompressionRequest
+    {
+        // GPU buffer with the compressed payload, in the ShaderResource state.
+        // It's owned by the streaming service and is reused once the submission has finished executing.
+        IBuffer* compressedBuffer = nullptr;
+        uint64_t compressedOffset = 0;
+        uint64_t compressedSize = 0;
+        CompressionFormat format = 0;
+        uint64_t uncompressedSize = 0;
+
+        // Destination, either a buffer range or an entire texture subresource.
+        // The uncompressed texture data is tightly packed rows of blocks in the texture format.
+        IBuffer* destBuffer = nullptr;
+        uint64_t destOffsetBytes = 0;
+        ITexture* destTexture = nullptr;
+        uint32_t arraySlice = 0;
+        uint32_t mipLevel = 0;
+    };
+
+    // Records GPU decompression of streamed payloads, implemented by the application: for example, a GDeflate
+    // compute shader, which works on both D3D12 and Vulkan. The decompressor writes the destination through
+    // binding sets or after setBufferState / setTextureState calls, so that the command list places the barriers.
+    class IGpuDecompressor
+    {
+    public:
+        virtual ~IGpuDecompressor() = default;
+
+        // Must be thread-safe, it's called from the threads that queue the requests.
+        virtual bool supportsFormat(CompressionFormat format, bool textureDestination) = 0;
+
+        // Returns false if the request could not be recorded, which is reported as an error.
+        virtual bool recordDecompression(ICommandList* commandList, const DecompressionRequest& request) = 0;
+    };
+
+    struct StreamingServiceDesc
+    {
+        // Queue that executes the uploads. Falls back to the graphics queue if the device doesn't have the requested queue.
+        CommandQueue queue = CommandQueue::Copy;
+
+        // Maximum amount of request data recorded into one submission by submitPendingUploads.
+        // A single request that is larger than the budget is still submitted, on its own.
+        uint64_t maxBytesPerSubmit = 32 * 1024 * 1024;
+
+        // Upload chunk size of the internal command list, see CommandListParameters::uploadChunkSize.
+        size_t uploadChunkSize = 4 * 1024 * 1024;
+
+        // Optional GPU decompressor for the writeCompressed... requests. It must outlive the service.
+        // Decompression needs a queue that can run compute work, so the copy queue is replaced with the compute queue,
+        // or with the graphics queue if there is no compute queue.
+        IGpuDecompressor* decompressor = nullptr;
+
+        StreamingServiceDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        StreamingServiceDesc& setMaxBytesPerSubmit(uint64_t value) { maxBytesPerSubmit = value; return *this; }
+        StreamingServiceDesc& setUploadChunkSize(size_t value) { uploadChunkSize = value; return *this; }
+        StreamingServiceDesc& setDecompressor(IGpuDecompressor* value) { decompressor = value; return *this; }
+    };
+
+    // Identifies an upload request. Tokens are issued in increasing order and requests are executed in the same order,
+    // so when a request is complete, all requests with smaller tokens are complete too.
+    typedef uint64_t UploadToken;
+    constexpr UploadToken c_InvalidUploadToken = 0;
+
+    // Batches texture and buffer uploads from any thread and executes them on a separate queue in per-frame budgets.
+    // The uploads are recorded through ICommandList::writeTexture and writeBuffer, so they use the regular upload
+    // memory and resource state tracking of the backend. Resources that are used on other queues after the upload
+    // should be created with keepInitialState = true.
+    class IStreamingService : public IResource
+    {
+    public:
+        // Queues a write of one texture subresource. The data is copied, so it can be released right after the call.
+        // Thread-safe. Returns c_InvalidUploadToken if the arguments are invalid.
+        virtual UploadToken writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data,
+            size_t rowPitch, size_t depthPitch = 0) = 0;
+
+        // Queues a write of a buffer range. The data is copied, so it can be released right after the call.
+        // Thread-safe. Returns c_InvalidUploadToken if the arguments are invalid.
+        virtual UploadToken writeBuffer(IBuffer* dest, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) = 0;
+
+        // Queue writes of compressed payloads that are uploaded as is and decompressed on the GPU into the destination,
+        // see StreamingServiceDesc::decompressor. The data is copied, so it can be released right after the call.
+        // Thread-safe. Return c_InvalidUploadToken if there is no decompressor, it doesn't support the format,
+        // or the arguments are invalid.
+        virtual UploadToken writeCompressedTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel,
+            const void* compressedData, size_t compressedSize, CompressionFormat format) = 0;
+        virtual UploadToken writeCompressedBuffer(IBuffer* dest, const void* compressedData, size_t compressedSize,
+            CompressionFormat format, uint64_t uncompressedSize, uint64_t destOffsetBytes = 0) = 0;
+
+        // Records the pending requests, up to StreamingServiceDesc::maxBytesPerSubmit, into a command list and executes it.
+        // Call this once per frame from a thread that is allowed to execute command lists.
+        // Returns the token of the last submitted request, or c_InvalidUploadToken if nothing was pending.
+        virtual UploadToken submitPendingUploads() = 0;
+
+        // Returns true when the request has finished executing on the GPU.
+        virtual bool isUploadComplete(UploadToken token) = 0;
+
+        // Makes 'waitQueue' wait on the GPU until the request has finished executing, without blocking the CPU.
+        // Returns false and doesn't insert a wait if the request hasn't been submitted yet.
+        virtual bool queueWaitForUpload(CommandQueue waitQueue, UploadToken token) = 0;
+
+        // Returns the total size of the data in queued requests that haven't been submitted yet.
+        virtual uint64_t getPendingBytes() = 0;
+    };
+
+    typedef RefCountPtr<IStreamingService> StreamingServiceHandle;
+
+    NVRHI_API StreamingServiceHandle createStreamingService(IDevice* device, const StreamingServiceDesc& desc = StreamingServiceDesc());
+}
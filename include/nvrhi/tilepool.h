@@ -0,0 +1,102 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::tiles
+{
+    // Size of a standard tile of tiled textures on D3D12, and of the sparse blocks of most Vulkan formats.
+    constexpr uint64_t c_TileSizeInBytes = 64 * 1024;
+
+    struct TilePoolDesc
+    {
+        // Number of tiles in each heap created by the pool, 64 MB heaps by default.
+        uint32_t tilesPerHeap = 1024;
+
+        // Maximum number of heaps, 0 means unlimited. allocateTile() fails when all the heaps are full.
+        uint32_t maxHeaps = 0;
+
+        // Queue that executes the tile mapping updates, for example a dedicated copy queue that the streaming system
+        // uses for uploading the tile contents. It must support tiled resources (sparse binding on Vulkan).
+        CommandQueue queue = CommandQueue::Graphics;
+
+        std::string debugName;
+
+        TilePoolDesc& setTilesPerHeap(uint32_t value) { tilesPerHeap = value; return *this; }
+        TilePoolDesc& setMaxHeaps(uint32_t value) { maxHeaps = value; return *this; }
+        TilePoolDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        TilePoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    struct TileAllocation
+    {
+        IHeap* heap = nullptr;
+        uint64_t byteOffset = 0;
+
+        [[nodiscard]] bool isValid() const { return heap != nullptr; }
+    };
+
+    struct TilePoolStatistics
+    {
+        uint32_t numHeaps = 0;
+        uint64_t heapBytes = 0;
+        uint32_t allocatedTiles = 0;
+        uint32_t freeTiles = 0;
+        // Tile mappings queued since the last flush()
+        uint32_t pendingMappings = 0;
+    };
+
+    // Sub-allocates tiles for tiled textures from a set of large heaps, and collects the tile mapping changes of
+    // all textures so that they are submitted with one IDevice::updateTextureTileMappingsBatch(...) call per flush.
+    // The pool is thread-safe. All the heaps are created with HeapType::DeviceLocal.
+    class ITilePool : public IResource
+    {
+    public:
+        // Takes a tile from the free lists, creating a new heap when all heaps are full.
+        // Returns an invalid allocation when maxHeaps is reached or the heap cannot be created.
+        virtual TileAllocation allocateTile() = 0;
+
+        // Returns a tile to the pool. The application is responsible for unmapping it from the textures that use it.
+        // The tile is not handed out again until the next flush(), which submits the unmapping before any new mapping.
+        virtual void freeTile(const TileAllocation& tile) = 0;
+
+        // Queues mapping one tile of a texture to 'tile', or unmapping it when 'tile' is invalid.
+        // If the same texture tile is mapped several times before the flush, only the last mapping is submitted.
+        // The packed mip tail is not a grid of standard tiles and must be mapped with IDevice::updateTextureTileMappings.
+        virtual void mapTile(ITexture* texture, const TiledTextureCoordinate& coordinate, const TileAllocation& tile) = 0;
+
+        // Submits all queued mappings on the pool's queue. Call this once per frame, before executing the command
+        // lists that use the newly mapped tiles.
+        virtual void flush() = 0;
+
+        // Releases the heaps that have no allocated tiles.
+        virtual void trim() = 0;
+
+        virtual TilePoolStatistics getStatistics() = 0;
+    };
+
+    typedef RefCountPtr<ITilePool> TilePoolHandle;
+
+    NVRHI_API TilePoolHandle createTilePool(IDevice* device, const TilePoolDesc& desc = TilePoolDesc());
+}
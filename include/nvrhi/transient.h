@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::transient
+{
+    struct TransientResourcePoolDesc
+    {
+        // Heap capacities are rounded up to this granularity, so that the heaps can be reused by later compilations
+        // when the set of declared resources changes slightly.
+        uint64_t heapSizeGranularity = 16 * 1024 * 1024;
+
+        std::string debugName;
+
+        TransientResourcePoolDesc& setHeapSizeGranularity(uint64_t value) { heapSizeGranularity = value; return *this; }
+        TransientResourcePoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Identifies a resource declared in the pool. Indices are valid until the pool is reset.
+    typedef uint32_t TransientResourceIndex;
+    constexpr TransientResourceIndex c_InvalidTransientResource = ~0u;
+
+    struct TransientPoolStatistics
+    {
+        // Total capacity of the heaps used by the compiled resources.
+        uint64_t heapBytes = 0;
+        // Total memory that the compiled resources would take without aliasing.
+        uint64_t unaliasedBytes = 0;
+        uint32_t numHeaps = 0;
+        uint32_t numResources = 0;
+    };
+
+    // Places textures and buffers with non-overlapping lifetimes into shared heaps, so that they use the same memory.
+    // Lifetimes are expressed in application-defined pass indices, such as the order of passes in a frame graph.
+    // The pool is meant to be compiled once per frame graph configuration, and the resources are reused in every frame.
+    // All command lists that use the resources must be executed on the same queue.
+    class ITransientResourcePool : public IResource
+    {
+    public:
+        // Declares a texture that is used from pass 'firstPass' to pass 'lastPass', inclusive.
+        // The isVirtual, keepInitialState and initialState members of the desc are overridden by the pool.
+        virtual TransientResourceIndex declareTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass) = 0;
+
+        // Declares a buffer that is used from pass 'firstPass' to pass 'lastPass', inclusive.
+        // The buffer must not be CPU-accessible or volatile. The isVirtual, keepInitialState and initialState members
+        // of the desc are overridden by the pool.
+        virtual TransientResourceIndex declareBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass) = 0;
+
+        // Creates the declared resources and binds them to heap memory so that resources whose lifetimes don't overlap
+        // share memory. Resources returned by a previous compilation are no longer managed by the pool.
+        // When the device doesn't support virtual resources, the resources are created without aliasing.
+        // Returns false if any resource or heap could not be created.
+        virtual bool compile() = 0;
+
+        // Returns the compiled texture, or nullptr if the index doesn't refer to a texture.
+        virtual ITexture* getTexture(TransientResourceIndex index) = 0;
+
+        // Returns the compiled buffer, or nullptr if the index doesn't refer to a buffer.
+        virtual IBuffer* getBuffer(TransientResourceIndex index) = 0;
+
+        // Places the aliasing barriers for the resources whose lifetime starts at 'passIndex', see
+        // ICommandList::setAliasingBarrier(...). Call this before recording each pass that uses transient resources.
+        // The contents of these resources are undefined at the beginning of their lifetime.
+        virtual void beginPass(ICommandList* commandList, uint32_t passIndex) = 0;
+
+        // Removes all declared resources. The heaps are kept for reuse by the next compilation.
+        virtual void reset() = 0;
+
+        virtual TransientPoolStatistics getStatistics() = 0;
+    };
+
+    typedef RefCountPtr<ITransientResourcePool> TransientResourcePoolHandle;
+
+    NVRHI_API TransientResourcePoolHandle createTransientResourcePool(IDevice* device,
+        const TransientResourcePoolDesc& desc = TransientResourcePoolDesc());
+}
@@ -94,6 +94,10 @@ namespace nvrhi::utils
         size_t requestedFormatCount);
     
     NVRHI_API const char* GraphicsAPIToString(GraphicsAPI api);
+    NVRHI_API const char* InstrumentationZoneToString(InstrumentationZone zone);
+    NVRHI_API const char* ResourceAllocationTypeToString(ResourceAllocationType type);
+    NVRHI_API const char* PipelineTypeToString(PipelineType type);
+    NVRHI_API const char* PipelineCacheResultToString(PipelineCacheResult result);
     NVRHI_API const char* TextureDimensionToString(TextureDimension dimension);
     NVRHI_API const char* DebugNameToString(const std::string& debugName);
     NVRHI_API const char* ShaderStageToString(ShaderType stage);
@@ -118,6 +122,9 @@ namespace nvrhi::utils
         void release(int index);
         [[nodiscard]] size_t getCapacity() const { return m_Allocated.size(); }
 
+        // Changes the capacity, keeping the allocations below it
+        void resize(size_t capacity);
+
     private:
         int m_NextAvailable = 0;
         std::vector<bool> m_Allocated;
@@ -125,6 +132,65 @@ namespace nvrhi::utils
         std::mutex m_Mutex;
     };
 
+    struct BindlessDescriptorManagerDesc
+    {
+        // Bindless layout that the descriptor table is created with, see IDevice::createBindlessLayout
+        BindingLayoutHandle layout;
+
+        // Number of slots in the table when it's created. The table grows geometrically when the slots run out,
+        // up to the maxCapacity of the layout.
+        uint32_t initialCapacity = 1024;
+
+        // Queue that the command lists using the table are executed on
+        CommandQueue queue = CommandQueue::Graphics;
+
+        std::string debugName;
+
+        BindlessDescriptorManagerDesc& setLayout(IBindingLayout* value) { layout = value; return *this; }
+        BindlessDescriptorManagerDesc& setInitialCapacity(uint32_t value) { initialCapacity = value; return *this; }
+        BindlessDescriptorManagerDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        BindlessDescriptorManagerDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    constexpr uint32_t c_InvalidBindlessIndex = ~0u;
+
+    // Hands out stable indices into a bindless descriptor table, for the resource types that the register spaces
+    // of its layout accept. Samplers go into a table of their own on DX12, which needs a separate manager.
+    // A released index is reused only when the GPU has finished the submissions that could still read it,
+    // and the descriptor table is resized and written in batches by flush().
+    // All functions can be called from multiple threads. The resources must stay alive while they are in the table.
+    class IBindlessDescriptorManager : public IResource
+    {
+    public:
+        // Allocates an index and queues the descriptor write, with the slot of the item ignored.
+        // Returns c_InvalidBindlessIndex when the table is at the maxCapacity of its layout.
+        virtual uint32_t allocate(const BindingSetItem& item) = 0;
+
+        // Queues a write of a different descriptor into an allocated index, for example after the resource was recreated
+        virtual void update(uint32_t index, const BindingSetItem& item) = 0;
+
+        // Releases the index. It becomes available again after the GPU has finished the submission
+        // marked by the next markSubmitted() call. Releasing an index that isn't allocated is reported as an error.
+        virtual void release(uint32_t index) = 0;
+
+        // Grows the descriptor table to fit the allocated indices and writes the queued descriptors.
+        // Call it before executing the command lists that use the new indices. Growing reallocates the table,
+        // like resizeDescriptorTable does, so it must be bound again after that.
+        // Returns false if the table could not be grown or some of the descriptors could not be written.
+        virtual bool flush() = 0;
+
+        // Marks the end of a submission on BindlessDescriptorManagerDesc::queue.
+        // Call it right after executing the command lists that use the table.
+        virtual void markSubmitted() = 0;
+
+        [[nodiscard]] virtual IDescriptorTable* getDescriptorTable() const = 0;
+        [[nodiscard]] virtual uint32_t getNumAllocatedIndices() = 0;
+    };
+
+    typedef RefCountPtr<IBindlessDescriptorManager> BindlessDescriptorManagerHandle;
+
+    NVRHI_API BindlessDescriptorManagerHandle CreateBindlessDescriptorManager(IDevice* device, const BindlessDescriptorManagerDesc& desc);
+
     // Automatic begin/end marker for command list
     class ScopedMarker
     {
@@ -26,5 +26,42 @@
 
 namespace nvrhi::validation
 {
+    enum class ValidationTier : uint8_t
+    {
+        // Only null checks, queue type checks and command list open/close state.
+        Cheap,
+
+        // Cheap checks on every call, plus the deep checks (binding sets against layouts and their contents,
+        // framebuffer and pipeline compatibility, acceleration structure build inputs) on a sample of calls.
+        Sampled,
+
+        // All checks on every call.
+        Full
+    };
+
+    enum class ValidationSamplingMode : uint8_t
+    {
+        // Deep checks run on every Nth call to a command list or device function that has them.
+        PerCall,
+
+        // Deep checks run on every call during every Nth frame.
+        // Frames are counted by calls to runGarbageCollection or runIncrementalGarbageCollection.
+        PerFrame
+    };
+
+    struct ValidationLayerDesc
+    {
+        ValidationTier tier = ValidationTier::Full;
+        ValidationSamplingMode samplingMode = ValidationSamplingMode::PerCall;
+
+        // The N in "every Nth call or frame" for the Sampled tier. 0 is treated as 1.
+        uint32_t samplingInterval = 16;
+
+        ValidationLayerDesc& setTier(ValidationTier value) { tier = value; return *this; }
+        ValidationLayerDesc& setSamplingMode(ValidationSamplingMode value) { samplingMode = value; return *this; }
+        ValidationLayerDesc& setSamplingInterval(uint32_t value) { samplingInterval = value; return *this; }
+    };
+
     NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice);
+    NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc);
 }
@@ -73,11 +73,57 @@ namespace nvrhi::vulkan
 
         uint32_t maxTimerQueries = 256;
 
+        // Number of threads used by the create...PipelineAsync functions, 0 means half of the CPU cores
+        uint32_t numPipelineCompileThreads = 0;
+
+        // Size of the VkDeviceMemory blocks that small buffers and textures are sub-allocated from.
+        // Large, exported, and dedicated-preferring resources always get their own allocations.
+        // Set to 0 to disable sub-allocation.
+        uint64_t deviceMemoryBlockSize = 256 * 1024 * 1024;
+
+        // Optional contents of the pipeline cache, as previously returned by IDevice::getPipelineCacheData.
+        // Data from a different device or driver is ignored.
+        const void* pipelineCacheData = nullptr;
+        size_t pipelineCacheDataSize = 0;
+
+        // Size of the upload ring buffer created for each queue when the first command list with
+        // CommandListParameters::useSharedUploadRing uploads data. This is the cap on the upload memory
+        // shared by those command lists; 0 disables the rings.
+        uint64_t uploadRingSize = 64 * 1024 * 1024;
+
+        // Size of the chunks that command lists claim from the upload ring and sub-allocate from without locking.
+        uint64_t uploadRingChunkSize = 256 * 1024;
+
+        // Budget for the AS build scratch pool created for each queue, used by the command lists with
+        // CommandListParameters::useSharedScratchPool. 0 disables the pools.
+        uint64_t scratchPoolMaxMemory = 256 * 1024 * 1024;
+
+        // Minimum size of the chunks in the scratch pools. Larger chunks are created for builds that need more.
+        uint64_t scratchPoolChunkSize = 4 * 1024 * 1024;
+
+        // Size of the device-wide ring that volatile constant buffer writes are sub-allocated from. When nonzero,
+        // every writeBuffer to a volatile buffer takes a new range from a ring chunk claimed by the command list
+        // and binds it through the dynamic offset of the descriptor, so BufferDesc::maxVersions is ignored.
+        // The ring is shared by all queues and must not exceed 4 GB. 0 keeps the per-buffer versions.
+        uint64_t volatileConstantRingSize = 0;
+
+        // Size of the chunks that command lists claim from the volatile constant ring.
+        uint64_t volatileConstantRingChunkSize = 64 * 1024;
+
         // Indicates if VkPhysicalDeviceVulkan12Features::bufferDeviceAddress was set to 'true' at device creation time
         bool bufferDeviceAddressSupported = false;
         bool aftermathEnabled = false;
+        bool aftermathCompactMarkers = false; // see AftermathCrashDumpHelper::setCompactMarkers
         bool logBufferLifetime = false;
 
+        // Shares the shader modules of createShader calls with identical SPIR-V and settings, and the shaders
+        // of identical createShaderSpecialization calls. Unreferenced shaders are released by runGarbageCollection.
+        bool enableShaderCache = false;
+
+        // Shares the samplers, input layouts and descriptor set layouts created from identical descriptions
+        // for as long as any of their handles is alive.
+        bool enableStateObjectInterning = false;
+
         std::string vulkanLibraryName; // if empty, use default
     };
 
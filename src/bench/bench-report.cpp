@@ -0,0 +1,84 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/bench.h>
+
+#include <iomanip>
+#include <sstream>
+
+namespace nvrhi::bench
+{
+    static void writeJsonString(std::ostream& os, const std::string& value)
+    {
+        os << '"';
+        for (char c : value)
+        {
+            switch (c)
+            {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\t': os << "\\t"; break;
+            default:
+                if (uint8_t(c) < 0x20)
+                    os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+                else
+                    os << c;
+            }
+        }
+        os << '"';
+    }
+
+    std::string writeReportJson(const BenchmarkReport& report)
+    {
+        std::stringstream ss;
+        ss << std::setprecision(6) << std::fixed;
+
+        ss << "{\n  \"suite\": ";
+        writeJsonString(ss, report.suite);
+        ss << ",\n  \"graphicsAPI\": ";
+        writeJsonString(ss, report.graphicsAPI);
+        ss << ",\n  \"results\": [";
+
+        for (size_t index = 0; index < report.results.size(); index++)
+        {
+            const BenchmarkResult& result = report.results[index];
+
+            ss << (index == 0 ? "\n" : ",\n") << "    {\n      \"name\": ";
+            writeJsonString(ss, result.name);
+            ss << ",\n      \"iterations\": " << result.iterations;
+            ss << ",\n      \"gpuMillisecondsMin\": " << result.gpuMillisecondsMin;
+            ss << ",\n      \"gpuMillisecondsAvg\": " << result.gpuMillisecondsAvg;
+            ss << ",\n      \"cpuMillisecondsMin\": " << result.cpuMillisecondsMin;
+            ss << ",\n      \"cpuMillisecondsAvg\": " << result.cpuMillisecondsAvg;
+            ss << ",\n      \"operationsPerIteration\": " << result.operationsPerIteration;
+            ss << ",\n      \"resultBytes\": " << result.resultBytes;
+            ss << ",\n      \"scratchBytes\": " << result.scratchBytes;
+            ss << ",\n      \"skipReason\": ";
+            writeJsonString(ss, result.skipReason);
+            ss << "\n    }";
+        }
+
+        ss << (report.results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+        return ss.str();
+    }
+}
@@ -0,0 +1,472 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/bench.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace nvrhi::bench
+{
+    class CpuBenchmark
+    {
+    public:
+        CpuBenchmark(IDevice* device, const CpuBenchmarkDesc& desc);
+
+        void run(BenchmarkReport& report);
+
+    private:
+        DeviceHandle m_Device;
+        CpuBenchmarkDesc m_Desc;
+        CommandListHandle m_CommandList;
+
+        // Runs 'prepare', 'body' and 'finish' for each iteration and fills the timing fields; only 'body' is timed
+        void measure(BenchmarkResult& result, uint64_t operationsPerIteration, const std::function<void()>& prepare,
+            const std::function<void()>& body, const std::function<void()>& finish);
+
+        // Wraps 'record' into open / close / execute of m_CommandList
+        void measureRecording(BenchmarkResult& result, uint64_t operationsPerIteration,
+            const std::function<void(ICommandList* commandList)>& record);
+
+        BenchmarkResult measureDraws(const char* name, bool changeState);
+        BenchmarkResult measureBindingSetCreation();
+        BenchmarkResult measureBufferWrites(const char* name, bool isVolatile);
+        BenchmarkResult measureTextureStates();
+        BenchmarkResult measureDescriptorTable();
+        BenchmarkResult measureExecuteCommandLists();
+    };
+
+    CpuBenchmark::CpuBenchmark(IDevice* device, const CpuBenchmarkDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        m_Desc.iterations = std::max(m_Desc.iterations, 1u);
+        m_Desc.textureArraySize = std::max(m_Desc.textureArraySize, 1u);
+    }
+
+    void CpuBenchmark::measure(BenchmarkResult& result, uint64_t operationsPerIteration, const std::function<void()>& prepare,
+        const std::function<void()>& body, const std::function<void()>& finish)
+    {
+        double cpuMin = std::numeric_limits<double>::max();
+        double cpuTotal = 0.0;
+
+        for (uint32_t iteration = 0; iteration < m_Desc.iterations; iteration++)
+        {
+            if (prepare)
+                prepare();
+
+            auto const start = std::chrono::high_resolution_clock::now();
+            body();
+            auto const end = std::chrono::high_resolution_clock::now();
+
+            double const cpuTime = std::chrono::duration<double, std::milli>(end - start).count();
+            cpuMin = std::min(cpuMin, cpuTime);
+            cpuTotal += cpuTime;
+
+            if (finish)
+                finish();
+
+            m_Device->waitForIdle();
+            m_Device->runGarbageCollection();
+        }
+
+        result.iterations = m_Desc.iterations;
+        result.operationsPerIteration = operationsPerIteration;
+        result.cpuMillisecondsMin = cpuMin;
+        result.cpuMillisecondsAvg = cpuTotal / double(m_Desc.iterations);
+    }
+
+    void CpuBenchmark::measureRecording(BenchmarkResult& result, uint64_t operationsPerIteration,
+        const std::function<void(ICommandList* commandList)>& record)
+    {
+        measure(result, operationsPerIteration,
+            [this]()
+            {
+                m_CommandList->open();
+            },
+            [this, &record]()
+            {
+                record(m_CommandList);
+            },
+            [this]()
+            {
+                m_CommandList->close();
+                m_Device->executeCommandList(m_CommandList);
+            });
+    }
+
+    BenchmarkResult CpuBenchmark::measureDraws(const char* name, bool changeState)
+    {
+        BenchmarkResult result;
+        result.name = name;
+
+        if (!m_Desc.graphicsState)
+        {
+            result.skipReason = "no graphics state provided";
+            return result;
+        }
+
+        // The second state differs from the first one in the viewport only, which is the cheapest change
+        // that still defeats the redundant state filtering in setGraphicsState
+        GraphicsState states[2] = { *m_Desc.graphicsState, *m_Desc.graphicsState };
+        if (states[0].viewport.viewports.empty() && states[0].framebuffer)
+            states[0].viewport.addViewportAndScissorRect(states[0].framebuffer->getFramebufferInfo().getViewport());
+        states[1].viewport = states[0].viewport;
+        for (Viewport& viewport : states[1].viewport.viewports)
+            viewport.maxX = viewport.minX + (viewport.maxX - viewport.minX) * 0.5f;
+
+        uint32_t const drawCount = m_Desc.drawsPerIteration;
+        DrawArguments const drawArguments = m_Desc.drawArguments;
+
+        measureRecording(result, uint64_t(drawCount) * 2, [&states, drawCount, drawArguments, changeState](ICommandList* commandList)
+        {
+            for (uint32_t index = 0; index < drawCount; index++)
+            {
+                commandList->setGraphicsState(states[changeState ? (index & 1) : 0]);
+                commandList->drawIndexed(drawArguments);
+            }
+        });
+
+        return result;
+    }
+
+    BenchmarkResult CpuBenchmark::measureBindingSetCreation()
+    {
+        BenchmarkResult result;
+        result.name = "create_binding_set";
+
+        // A typical material layout: a constant buffer, a few structured buffers and a sampler
+        uint32_t const srvCount = 4;
+
+        auto layoutDesc = BindingLayoutDesc()
+            .setVisibility(ShaderType::All)
+            .addItem(BindingLayoutItem::ConstantBuffer(0))
+            .addItem(BindingLayoutItem::Sampler(0));
+        for (uint32_t slot = 0; slot < srvCount; slot++)
+            layoutDesc.addItem(BindingLayoutItem::StructuredBuffer_SRV(slot));
+
+        BindingLayoutHandle layout = m_Device->createBindingLayout(layoutDesc);
+
+        BufferHandle constantBuffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(256)
+            .setIsConstantBuffer(true)
+            .setInitialState(ResourceStates::ConstantBuffer)
+            .setKeepInitialState(true)
+            .setDebugName("CpuBenchmark/ConstantBuffer"));
+
+        BufferHandle structuredBuffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(4096)
+            .setStructStride(16)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("CpuBenchmark/StructuredBuffer"));
+
+        SamplerHandle sampler = m_Device->createSampler(SamplerDesc());
+
+        if (!layout || !constantBuffer || !structuredBuffer || !sampler)
+        {
+            result.skipReason = "resource creation failed";
+            return result;
+        }
+
+        auto setDesc = BindingSetDesc()
+            .addItem(BindingSetItem::ConstantBuffer(0, constantBuffer))
+            .addItem(BindingSetItem::Sampler(0, sampler));
+        for (uint32_t slot = 0; slot < srvCount; slot++)
+            setDesc.addItem(BindingSetItem::StructuredBuffer_SRV(slot, structuredBuffer));
+
+        std::vector<BindingSetHandle> bindingSets;
+        bindingSets.reserve(m_Desc.bindingSetsPerIteration);
+
+        measure(result, m_Desc.bindingSetsPerIteration, nullptr,
+            [this, &bindingSets, &setDesc, &layout]()
+            {
+                for (uint32_t index = 0; index < m_Desc.bindingSetsPerIteration; index++)
+                    bindingSets.push_back(m_Device->createBindingSet(setDesc, layout));
+            },
+            [&bindingSets]()
+            {
+                // Releasing the sets returns their descriptors to the heaps, which is not part of the measurement
+                bindingSets.clear();
+            });
+
+        return result;
+    }
+
+    BenchmarkResult CpuBenchmark::measureBufferWrites(const char* name, bool isVolatile)
+    {
+        BenchmarkResult result;
+        result.name = name;
+
+        uint32_t const writeCount = m_Desc.bufferWritesPerIteration;
+        size_t const writeSize = 256;
+
+        auto bufferDesc = BufferDesc()
+            .setIsConstantBuffer(true)
+            .setDebugName(isVolatile ? "CpuBenchmark/VolatileBuffer" : "CpuBenchmark/StaticBuffer");
+
+        if (isVolatile)
+        {
+            // Every write creates a new version, and the device is idle at the start of each iteration
+            bufferDesc.setByteSize(writeSize)
+                .setIsVolatile(true)
+                .setMaxVersions(std::max(writeCount, 1u));
+        }
+        else
+        {
+            // Writes go to distinct ranges of a larger buffer so that they can't be merged
+            bufferDesc.setByteSize(writeSize * std::max(writeCount, 1u))
+                .setInitialState(ResourceStates::ConstantBuffer)
+                .setKeepInitialState(true);
+        }
+
+        BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+        if (!buffer)
+        {
+            result.skipReason = "resource creation failed";
+            return result;
+        }
+
+        std::vector<uint8_t> data(writeSize, 0x5a);
+
+        measureRecording(result, writeCount, [&buffer, &data, writeCount, writeSize, isVolatile](ICommandList* commandList)
+        {
+            for (uint32_t index = 0; index < writeCount; index++)
+                commandList->writeBuffer(buffer, data.data(), writeSize, isVolatile ? 0 : uint64_t(index) * writeSize);
+        });
+
+        return result;
+    }
+
+    BenchmarkResult CpuBenchmark::measureTextureStates()
+    {
+        BenchmarkResult result;
+        result.name = "set_texture_state";
+
+        uint32_t const mipLevels = 4;
+
+        auto textureDesc = TextureDesc()
+            .setWidth(64)
+            .setHeight(64)
+            .setMipLevels(mipLevels)
+            .setArraySize(m_Desc.textureArraySize)
+            .setDimension(TextureDimension::Texture2DArray)
+            .setFormat(Format::RGBA8_UNORM)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("CpuBenchmark/Texture");
+
+        std::vector<TextureHandle> textures;
+        for (uint32_t index = 0; index < m_Desc.textureCount; index++)
+        {
+            TextureHandle texture = m_Device->createTexture(textureDesc);
+            if (!texture)
+            {
+                result.skipReason = "resource creation failed";
+                return result;
+            }
+            textures.push_back(texture);
+        }
+
+        uint32_t const arraySize = m_Desc.textureArraySize;
+
+        // Each slice goes to CopyDest and back, with a commitBarriers after each pass
+        measureRecording(result, uint64_t(m_Desc.textureCount) * arraySize * 2,
+            [&textures, arraySize, mipLevels](ICommandList* commandList)
+            {
+                for (ResourceStates state : { ResourceStates::CopyDest, ResourceStates::ShaderResource })
+                {
+                    for (const TextureHandle& texture : textures)
+                    {
+                        for (uint32_t slice = 0; slice < arraySize; slice++)
+                            commandList->setTextureState(texture, TextureSubresourceSet(0, mipLevels, slice, 1), state);
+                    }
+                    commandList->commitBarriers();
+                }
+            });
+
+        return result;
+    }
+
+    BenchmarkResult CpuBenchmark::measureDescriptorTable()
+    {
+        BenchmarkResult result;
+        result.name = "descriptor_table";
+
+        uint32_t const tableSize = m_Desc.descriptorTableSize;
+
+        BindingLayoutHandle layout = m_Device->createBindlessLayout(BindlessLayoutDesc()
+            .setVisibility(ShaderType::All)
+            .setMaxCapacity(tableSize)
+            .addRegisterSpace(BindingLayoutItem::StructuredBuffer_SRV(1)));
+
+        if (!layout)
+        {
+            result.skipReason = "bindless layouts are not supported";
+            return result;
+        }
+
+        BufferHandle buffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(4096)
+            .setStructStride(16)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("CpuBenchmark/BindlessBuffer"));
+
+        if (!buffer)
+        {
+            result.skipReason = "resource creation failed";
+            return result;
+        }
+
+        std::vector<BindingSetItem> items;
+        items.reserve(tableSize);
+        for (uint32_t index = 0; index < tableSize; index++)
+            items.push_back(BindingSetItem::StructuredBuffer_SRV(index, buffer));
+
+        DescriptorTableHandle descriptorTable;
+
+        // One table allocation and resize, then one write per entry
+        measure(result, uint64_t(tableSize) + 2, nullptr,
+            [this, &descriptorTable, &layout, &items, tableSize]()
+            {
+                descriptorTable = m_Device->createDescriptorTable(layout);
+                if (!descriptorTable)
+                    return;
+
+                m_Device->resizeDescriptorTable(descriptorTable, tableSize, false);
+                for (const BindingSetItem& item : items)
+                    m_Device->writeDescriptorTable(descriptorTable, item);
+            },
+            [&descriptorTable]()
+            {
+                descriptorTable = nullptr;
+            });
+
+        return result;
+    }
+
+    BenchmarkResult CpuBenchmark::measureExecuteCommandLists()
+    {
+        BenchmarkResult result;
+        result.name = "execute_command_lists";
+
+        uint32_t const commandListCount = std::max(m_Desc.commandListsPerIteration, 1u);
+
+        BufferHandle buffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(256)
+            .setIsConstantBuffer(true)
+            .setInitialState(ResourceStates::ConstantBuffer)
+            .setKeepInitialState(true)
+            .setDebugName("CpuBenchmark/ExecuteBuffer"));
+
+        if (!buffer)
+        {
+            result.skipReason = "resource creation failed";
+            return result;
+        }
+
+        std::vector<CommandListHandle> commandLists;
+        std::vector<ICommandList*> commandListPointers;
+        for (uint32_t index = 0; index < commandListCount; index++)
+        {
+            CommandListHandle commandList = m_Device->createCommandList();
+            if (!commandList)
+            {
+                result.skipReason = "resource creation failed";
+                return result;
+            }
+            commandLists.push_back(commandList);
+            commandListPointers.push_back(commandList);
+        }
+
+        uint32_t const data[4] = {};
+
+        measure(result, commandListCount,
+            [&commandLists, &buffer, &data]()
+            {
+                // Each command list has a little work in it so that the submission isn't a no-op
+                for (const CommandListHandle& commandList : commandLists)
+                {
+                    commandList->open();
+                    commandList->writeBuffer(buffer, data, sizeof(data));
+                    commandList->close();
+                }
+            },
+            [this, &commandListPointers]()
+            {
+                m_Device->executeCommandLists(commandListPointers.data(), commandListPointers.size());
+            },
+            nullptr);
+
+        return result;
+    }
+
+    void CpuBenchmark::run(BenchmarkReport& report)
+    {
+        m_CommandList = m_Device->createCommandList();
+        if (!m_CommandList)
+        {
+            const char* const names[] = { "set_graphics_state_draw_indexed", "set_graphics_state_draw_indexed_dirty",
+                "create_binding_set", "write_buffer_volatile", "write_buffer_static", "set_texture_state",
+                "descriptor_table", "execute_command_lists" };
+
+            for (const char* name : names)
+            {
+                BenchmarkResult result;
+                result.name = name;
+                result.skipReason = "resource creation failed";
+                report.results.push_back(result);
+            }
+            return;
+        }
+
+        report.results.push_back(measureDraws("set_graphics_state_draw_indexed", false));
+        report.results.push_back(measureDraws("set_graphics_state_draw_indexed_dirty", true));
+        report.results.push_back(measureBindingSetCreation());
+        report.results.push_back(measureBufferWrites("write_buffer_volatile", true));
+        report.results.push_back(measureBufferWrites("write_buffer_static", false));
+        report.results.push_back(measureTextureStates());
+        report.results.push_back(measureDescriptorTable());
+        report.results.push_back(measureExecuteCommandLists());
+    }
+
+    BenchmarkReport runCpuBenchmarks(IDevice* device, const CpuBenchmarkDesc& desc)
+    {
+        BenchmarkReport report;
+        report.suite = "cpu";
+
+        if (!device)
+            return report;
+
+        report.graphicsAPI = utils::GraphicsAPIToString(device->getGraphicsAPI());
+
+        CpuBenchmark benchmark(device, desc);
+        benchmark.run(report);
+
+        return report;
+    }
+}
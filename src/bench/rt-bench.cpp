@@ -0,0 +1,564 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/bench.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace nvrhi::bench
+{
+    // Layout of NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_DESC and VkMicromapTriangleEXT
+    struct OpacityMicromapTriangle
+    {
+        uint32_t dataOffset;
+        uint16_t subdivisionLevel;
+        uint16_t format;
+    };
+
+    class RayTracingBenchmark
+    {
+    public:
+        RayTracingBenchmark(IDevice* device, const RayTracingBenchmarkDesc& desc);
+
+        void run(BenchmarkReport& report);
+
+    private:
+        DeviceHandle m_Device;
+        RayTracingBenchmarkDesc m_Desc;
+        CommandListHandle m_CommandList;
+        TimestampQueryPoolHandle m_TimestampPool;
+        uint64_t m_TimestampFrequency = 0;
+
+        BufferHandle m_VertexBuffer;
+        BufferHandle m_IndexBuffer;
+        rt::GeometryDesc m_Geometry;
+
+        bool createGeometry();
+        void uploadBuffer(IBuffer* buffer, const void* data, size_t size);
+        rt::AccelStructDesc getBlasDesc(rt::AccelStructBuildFlags buildFlags, const char* debugName) const;
+        std::vector<rt::AccelStructHandle> createBlases(const rt::AccelStructDesc& desc);
+        void buildBlases(const std::vector<rt::AccelStructHandle>& blases, rt::AccelStructBuildFlags buildFlags);
+
+        // Records and executes 'record' for each iteration, after 'prepare' if it's set, and fills the timing fields
+        void measure(BenchmarkResult& result, const std::function<void(uint32_t iteration)>& prepare,
+            const std::function<void(ICommandList* commandList)>& record);
+
+        BenchmarkResult measureBlasBuild(std::vector<rt::AccelStructHandle>& builtBlases);
+        BenchmarkResult measureBlasRefit();
+        BenchmarkResult measureBlasCompaction();
+        BenchmarkResult measureTlasBuild(const std::vector<rt::AccelStructHandle>& blases);
+        BenchmarkResult measureOpacityMicromapBuild();
+        BenchmarkResult measureClusterOperation();
+    };
+
+    RayTracingBenchmark::RayTracingBenchmark(IDevice* device, const RayTracingBenchmarkDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        m_Desc.iterations = std::max(m_Desc.iterations, 1u);
+        m_Desc.blasCount = std::max(m_Desc.blasCount, 1u);
+    }
+
+    void RayTracingBenchmark::uploadBuffer(IBuffer* buffer, const void* data, size_t size)
+    {
+        m_CommandList->open();
+        m_CommandList->writeBuffer(buffer, data, size);
+        m_CommandList->close();
+        m_Device->executeCommandList(m_CommandList);
+        m_Device->waitForIdle();
+    }
+
+    bool RayTracingBenchmark::createGeometry()
+    {
+        // A square grid of quads, two triangles each
+        uint32_t const gridSize = std::max(uint32_t(std::sqrt(double(m_Desc.trianglesPerBlas) / 2.0)), 1u);
+
+        std::vector<float> vertices;
+        vertices.reserve(size_t(gridSize + 1) * (gridSize + 1) * 3);
+        for (uint32_t y = 0; y <= gridSize; y++)
+        {
+            for (uint32_t x = 0; x <= gridSize; x++)
+            {
+                vertices.push_back(float(x) / float(gridSize));
+                vertices.push_back(float(y) / float(gridSize));
+                // A little height variation so that the builder has some work to do
+                vertices.push_back(0.05f * std::sin(float(x) * 0.7f) * std::cos(float(y) * 0.3f));
+            }
+        }
+
+        std::vector<uint32_t> indices;
+        indices.reserve(size_t(gridSize) * gridSize * 6);
+        for (uint32_t y = 0; y < gridSize; y++)
+        {
+            for (uint32_t x = 0; x < gridSize; x++)
+            {
+                uint32_t const i0 = y * (gridSize + 1) + x;
+                uint32_t const i1 = i0 + 1;
+                uint32_t const i2 = i0 + gridSize + 1;
+                uint32_t const i3 = i2 + 1;
+                indices.insert(indices.end(), { i0, i1, i2, i2, i1, i3 });
+            }
+        }
+
+        auto bufferDesc = BufferDesc()
+            .setIsAccelStructBuildInput(true)
+            .setInitialState(ResourceStates::AccelStructBuildInput)
+            .setKeepInitialState(true);
+
+        m_VertexBuffer = m_Device->createBuffer(bufferDesc
+            .setByteSize(vertices.size() * sizeof(float))
+            .setDebugName("RayTracingBenchmark/Vertices"));
+        m_IndexBuffer = m_Device->createBuffer(bufferDesc
+            .setByteSize(indices.size() * sizeof(uint32_t))
+            .setDebugName("RayTracingBenchmark/Indices"));
+
+        if (!m_VertexBuffer || !m_IndexBuffer)
+            return false;
+
+        uploadBuffer(m_VertexBuffer, vertices.data(), vertices.size() * sizeof(float));
+        uploadBuffer(m_IndexBuffer, indices.data(), indices.size() * sizeof(uint32_t));
+
+        m_Geometry.setTriangles(rt::GeometryTriangles()
+            .setVertexBuffer(m_VertexBuffer)
+            .setVertexFormat(Format::RGB32_FLOAT)
+            .setVertexStride(3 * sizeof(float))
+            .setVertexCount(uint32_t(vertices.size() / 3))
+            .setIndexBuffer(m_IndexBuffer)
+            .setIndexFormat(Format::R32_UINT)
+            .setIndexCount(uint32_t(indices.size())));
+        m_Geometry.setFlags(rt::GeometryFlags::Opaque);
+
+        return true;
+    }
+
+    rt::AccelStructDesc RayTracingBenchmark::getBlasDesc(rt::AccelStructBuildFlags buildFlags, const char* debugName) const
+    {
+        return rt::AccelStructDesc()
+            .addBottomLevelGeometry(m_Geometry)
+            .setBuildFlags(buildFlags)
+            .setDebugName(debugName);
+    }
+
+    std::vector<rt::AccelStructHandle> RayTracingBenchmark::createBlases(const rt::AccelStructDesc& desc)
+    {
+        std::vector<rt::AccelStructHandle> blases;
+        for (uint32_t index = 0; index < m_Desc.blasCount; index++)
+        {
+            rt::AccelStructHandle blas = m_Device->createAccelStruct(desc);
+            if (!blas)
+                return {};
+            blases.push_back(blas);
+        }
+        return blases;
+    }
+
+    void RayTracingBenchmark::buildBlases(const std::vector<rt::AccelStructHandle>& blases, rt::AccelStructBuildFlags buildFlags)
+    {
+        m_CommandList->open();
+        for (const auto& blas : blases)
+            m_CommandList->buildBottomLevelAccelStruct(blas, &m_Geometry, 1, buildFlags);
+        m_CommandList->close();
+        m_Device->executeCommandList(m_CommandList);
+        m_Device->waitForIdle();
+        m_Device->runGarbageCollection();
+    }
+
+    void RayTracingBenchmark::measure(BenchmarkResult& result, const std::function<void(uint32_t iteration)>& prepare,
+        const std::function<void(ICommandList* commandList)>& record)
+    {
+        double gpuMin = std::numeric_limits<double>::max();
+        double gpuTotal = 0.0;
+        double cpuMin = std::numeric_limits<double>::max();
+        double cpuTotal = 0.0;
+        uint32_t gpuSamples = 0;
+
+        for (uint32_t iteration = 0; iteration < m_Desc.iterations; iteration++)
+        {
+            if (prepare)
+                prepare(iteration);
+
+            if (m_TimestampPool)
+            {
+                m_CommandList->open();
+                m_CommandList->resetTimestamps(m_TimestampPool, 0, 2);
+                m_CommandList->close();
+                m_Device->executeCommandList(m_CommandList);
+            }
+
+            m_CommandList->open();
+
+            if (m_TimestampPool)
+                m_CommandList->writeTimestamp(m_TimestampPool, 0);
+
+            auto const start = std::chrono::high_resolution_clock::now();
+            record(m_CommandList);
+            auto const end = std::chrono::high_resolution_clock::now();
+            double const cpuTime = std::chrono::duration<double, std::milli>(end - start).count();
+            cpuMin = std::min(cpuMin, cpuTime);
+            cpuTotal += cpuTime;
+
+            if (m_TimestampPool)
+            {
+                m_CommandList->writeTimestamp(m_TimestampPool, 1);
+                m_CommandList->resolveTimestamps(m_TimestampPool, 0, 2);
+            }
+
+            m_CommandList->close();
+            m_Device->executeCommandList(m_CommandList);
+            m_Device->waitForIdle();
+            m_Device->runGarbageCollection();
+
+            uint64_t timestamps[2] = {};
+            if (m_TimestampPool && m_Device->getTimestampResults(m_TimestampPool, 0, 2, timestamps) && timestamps[1] >= timestamps[0])
+            {
+                double const gpuTime = double(timestamps[1] - timestamps[0]) * 1000.0 / double(m_TimestampFrequency);
+                gpuMin = std::min(gpuMin, gpuTime);
+                gpuTotal += gpuTime;
+                ++gpuSamples;
+            }
+        }
+
+        result.iterations = m_Desc.iterations;
+        result.cpuMillisecondsMin = cpuMin;
+        result.cpuMillisecondsAvg = cpuTotal / double(m_Desc.iterations);
+        if (gpuSamples != 0)
+        {
+            result.gpuMillisecondsMin = gpuMin;
+            result.gpuMillisecondsAvg = gpuTotal / double(gpuSamples);
+        }
+    }
+
+    BenchmarkResult RayTracingBenchmark::measureBlasBuild(std::vector<rt::AccelStructHandle>& builtBlases)
+    {
+        BenchmarkResult result;
+        result.name = "blas_build";
+
+        rt::AccelStructDesc const desc = getBlasDesc(rt::AccelStructBuildFlags::PreferFastTrace, "RayTracingBenchmark/Blas");
+        builtBlases = createBlases(desc);
+        if (builtBlases.empty())
+        {
+            result.skipReason = "BLAS creation failed";
+            return result;
+        }
+
+        rt::AccelStructBuildSizes const sizes = m_Device->getAccelStructBuildSizes(desc);
+        result.resultBytes = sizes.resultSize * m_Desc.blasCount;
+        result.scratchBytes = sizes.buildScratchSize * m_Desc.blasCount;
+
+        measure(result, nullptr, [this, &builtBlases](ICommandList* commandList)
+        {
+            for (const auto& blas : builtBlases)
+                commandList->buildBottomLevelAccelStruct(blas, &m_Geometry, 1, rt::AccelStructBuildFlags::PreferFastTrace);
+        });
+
+        return result;
+    }
+
+    BenchmarkResult RayTracingBenchmark::measureBlasRefit()
+    {
+        BenchmarkResult result;
+        result.name = "blas_refit";
+
+        rt::AccelStructBuildFlags const buildFlags = rt::AccelStructBuildFlags::AllowUpdate | rt::AccelStructBuildFlags::PreferFastBuild;
+        rt::AccelStructDesc const desc = getBlasDesc(buildFlags, "RayTracingBenchmark/RefitBlas");
+        std::vector<rt::AccelStructHandle> blases = createBlases(desc);
+        if (blases.empty())
+        {
+            result.skipReason = "BLAS creation failed";
+            return result;
+        }
+
+        rt::AccelStructBuildSizes const sizes = m_Device->getAccelStructBuildSizes(desc);
+        result.resultBytes = sizes.resultSize * m_Desc.blasCount;
+        result.scratchBytes = sizes.updateScratchSize * m_Desc.blasCount;
+
+        buildBlases(blases, buildFlags);
+
+        measure(result, nullptr, [this, &blases, buildFlags](ICommandList* commandList)
+        {
+            for (const auto& blas : blases)
+                commandList->buildBottomLevelAccelStruct(blas, &m_Geometry, 1, buildFlags | rt::AccelStructBuildFlags::PerformUpdate);
+        });
+
+        return result;
+    }
+
+    BenchmarkResult RayTracingBenchmark::measureBlasCompaction()
+    {
+        BenchmarkResult result;
+        result.name = "blas_compaction";
+
+        rt::AccelStructBuildFlags const buildFlags = rt::AccelStructBuildFlags::AllowCompaction | rt::AccelStructBuildFlags::PreferFastTrace;
+        rt::AccelStructDesc const desc = getBlasDesc(buildFlags, "RayTracingBenchmark/CompactedBlas");
+
+        // Compaction is one-time, so every iteration compacts a new set of BLASes.
+        // The result size is not reported because compacted BLASes share pooled storage.
+        std::vector<rt::AccelStructHandle> blases;
+        bool creationFailed = false;
+
+        measure(result, [this, &desc, &blases, &creationFailed, buildFlags](uint32_t)
+        {
+            blases = createBlases(desc);
+            creationFailed = creationFailed || blases.empty();
+
+            // The compacted sizes become known when the build has finished and its command list is retired
+            buildBlases(blases, buildFlags);
+        },
+        [](ICommandList* commandList)
+        {
+            commandList->compactBottomLevelAccelStructs();
+        });
+
+        if (creationFailed)
+            result.skipReason = "BLAS creation failed";
+
+        return result;
+    }
+
+    BenchmarkResult RayTracingBenchmark::measureTlasBuild(const std::vector<rt::AccelStructHandle>& blases)
+    {
+        BenchmarkResult result;
+        result.name = "tlas_build";
+
+        if (blases.empty())
+        {
+            result.skipReason = "no BLASes to instance";
+            return result;
+        }
+
+        auto desc = rt::AccelStructDesc()
+            .setTopLevelMaxInstances(m_Desc.instanceCount)
+            .setBuildFlags(rt::AccelStructBuildFlags::PreferFastBuild)
+            .setDebugName("RayTracingBenchmark/Tlas");
+
+        rt::AccelStructHandle tlas = m_Device->createAccelStruct(desc);
+        if (!tlas)
+        {
+            result.skipReason = "TLAS creation failed";
+            return result;
+        }
+
+        rt::AccelStructBuildSizes const sizes = m_Device->getAccelStructBuildSizes(desc);
+        result.resultBytes = sizes.resultSize;
+        result.scratchBytes = sizes.buildScratchSize;
+
+        // A square grid of instances, spaced by the size of the BLAS grid
+        uint32_t const gridSize = std::max(uint32_t(std::ceil(std::sqrt(double(m_Desc.instanceCount)))), 1u);
+
+        std::vector<rt::InstanceDesc> instances(m_Desc.instanceCount);
+        for (uint32_t index = 0; index < m_Desc.instanceCount; index++)
+        {
+            rt::AffineTransform transform;
+            memcpy(&transform, &rt::c_IdentityTransform, sizeof(transform));
+            transform[3] = float(index % gridSize);
+            transform[7] = float(index / gridSize);
+
+            instances[index]
+                .setBLAS(blases[index % blases.size()])
+                .setInstanceID(index)
+                .setInstanceMask(0xff)
+                .setTransform(transform);
+        }
+
+        // The CPU time of the TLAS build is mostly the conversion of the instances into the native layout
+        measure(result, nullptr, [&tlas, &instances](ICommandList* commandList)
+        {
+            commandList->buildTopLevelAccelStruct(tlas, instances.data(), instances.size(), rt::AccelStructBuildFlags::PreferFastBuild);
+        });
+
+        return result;
+    }
+
+    BenchmarkResult RayTracingBenchmark::measureOpacityMicromapBuild()
+    {
+        BenchmarkResult result;
+        result.name = "omm_build";
+
+        if (!m_Device->queryFeatureSupport(Feature::RayTracingOpacityMicromap))
+        {
+            result.skipReason = "opacity micromaps are not supported";
+            return result;
+        }
+
+        if (m_Desc.ommCount == 0)
+        {
+            result.skipReason = "ommCount is 0";
+            return result;
+        }
+
+        // 2 bits per micro-triangle in the 4-state format
+        uint64_t const microTriangles = 1ull << (2 * m_Desc.ommSubdivisionLevel);
+        uint32_t const bytesPerOmm = uint32_t(std::max(microTriangles / 4, uint64_t(1)));
+
+        std::vector<uint8_t> ommData(size_t(bytesPerOmm) * m_Desc.ommCount);
+        for (size_t index = 0; index < ommData.size(); index++)
+            ommData[index] = uint8_t(index * 0x9d);
+
+        std::vector<OpacityMicromapTriangle> ommTriangles(m_Desc.ommCount);
+        for (uint32_t index = 0; index < m_Desc.ommCount; index++)
+        {
+            ommTriangles[index].dataOffset = index * bytesPerOmm;
+            ommTriangles[index].subdivisionLevel = uint16_t(m_Desc.ommSubdivisionLevel);
+            ommTriangles[index].format = uint16_t(rt::OpacityMicromapFormat::OC1_4_State);
+        }
+
+        auto bufferDesc = BufferDesc()
+            .setIsAccelStructBuildInput(true)
+            .setInitialState(ResourceStates::OpacityMicromapBuildInput)
+            .setKeepInitialState(true);
+
+        BufferHandle dataBuffer = m_Device->createBuffer(bufferDesc
+            .setByteSize(ommData.size())
+            .setDebugName("RayTracingBenchmark/OmmData"));
+        BufferHandle descBuffer = m_Device->createBuffer(bufferDesc
+            .setByteSize(ommTriangles.size() * sizeof(OpacityMicromapTriangle))
+            .setDebugName("RayTracingBenchmark/OmmDescs"));
+
+        if (!dataBuffer || !descBuffer)
+        {
+            result.skipReason = "OMM input buffer creation failed";
+            return result;
+        }
+
+        uploadBuffer(dataBuffer, ommData.data(), ommData.size());
+        uploadBuffer(descBuffer, ommTriangles.data(), ommTriangles.size() * sizeof(OpacityMicromapTriangle));
+
+        rt::OpacityMicromapUsageCount usage{ m_Desc.ommCount, m_Desc.ommSubdivisionLevel, rt::OpacityMicromapFormat::OC1_4_State };
+
+        auto desc = rt::OpacityMicromapDesc()
+            .setDebugName("RayTracingBenchmark/Omm")
+            .setFlags(rt::OpacityMicromapBuildFlags::FastTrace)
+            .setCounts({ usage })
+            .setInputBuffer(dataBuffer)
+            .setPerOmmDescs(descBuffer);
+
+        rt::OpacityMicromapHandle omm = m_Device->createOpacityMicromap(desc);
+        if (!omm)
+        {
+            result.skipReason = "OMM creation failed";
+            return result;
+        }
+
+        measure(result, nullptr, [&omm, &desc](ICommandList* commandList)
+        {
+            commandList->buildOpacityMicromap(omm, desc);
+        });
+
+        return result;
+    }
+
+    BenchmarkResult RayTracingBenchmark::measureClusterOperation()
+    {
+        BenchmarkResult result;
+        result.name = "cluster_operation";
+
+        if (!m_Device->queryFeatureSupport(Feature::RayTracingClusters))
+        {
+            result.skipReason = "cluster acceleration structures are not supported";
+            return result;
+        }
+
+        if (!m_Desc.clusterOperation)
+        {
+            result.skipReason = "no cluster operation provided";
+            return result;
+        }
+
+        const rt::cluster::OperationDesc& operation = *m_Desc.clusterOperation;
+        result.resultBytes = m_Device->getClusterOperationSizeInfo(operation.params).resultMaxSizeInBytes;
+        result.scratchBytes = operation.scratchSizeInBytes;
+
+        measure(result, nullptr, [&operation](ICommandList* commandList)
+        {
+            commandList->executeMultiIndirectClusterOperation(operation);
+        });
+
+        return result;
+    }
+
+    void RayTracingBenchmark::run(BenchmarkReport& report)
+    {
+        const char* const names[] = { "blas_build", "blas_refit", "blas_compaction", "tlas_build", "omm_build", "cluster_operation" };
+
+        auto skipAll = [&report, &names](const char* reason)
+        {
+            for (const char* name : names)
+            {
+                BenchmarkResult result;
+                result.name = name;
+                result.skipReason = reason;
+                report.results.push_back(result);
+            }
+        };
+
+        if (!m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct))
+        {
+            skipAll("ray tracing acceleration structures are not supported");
+            return;
+        }
+
+        m_CommandList = m_Device->createCommandList();
+        if (!m_CommandList || !createGeometry())
+        {
+            skipAll("resource creation failed");
+            return;
+        }
+
+        m_TimestampPool = m_Device->createTimestampQueryPool(TimestampQueryPoolDesc()
+            .setQueryCount(2)
+            .setDebugName("RayTracingBenchmark/Timestamps"));
+        m_TimestampFrequency = m_Device->getTimestampFrequency(CommandQueue::Graphics);
+        if (m_TimestampFrequency == 0)
+            m_TimestampPool = nullptr;
+
+        std::vector<rt::AccelStructHandle> blases;
+        report.results.push_back(measureBlasBuild(blases));
+        report.results.push_back(measureBlasRefit());
+        report.results.push_back(measureBlasCompaction());
+        report.results.push_back(measureTlasBuild(blases));
+        report.results.push_back(measureOpacityMicromapBuild());
+        report.results.push_back(measureClusterOperation());
+    }
+
+    BenchmarkReport runRayTracingBenchmarks(IDevice* device, const RayTracingBenchmarkDesc& desc)
+    {
+        BenchmarkReport report;
+        report.suite = "raytracing";
+
+        if (!device)
+            return report;
+
+        report.graphicsAPI = utils::GraphicsAPIToString(device->getGraphicsAPI());
+
+        RayTracingBenchmark benchmark(device, desc);
+        benchmark.run(report);
+
+        return report;
+    }
+}
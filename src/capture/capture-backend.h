@@ -0,0 +1,725 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/capture.h>
+#include <nvrhi/common/misc.h>
+#include "../common/pipeline-compile-pool.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+
+namespace nvrhi::capture
+{
+    // Trace files start with a FileHeader, followed by a sequence of records. Each record is a RecordHeader and
+    // 'size' bytes of arguments. The command list calls are stored as nested records inside of a CommandList
+    // record, which is written when the command list is closed.
+    constexpr uint32_t c_FileMagic = 0x4352564E; // "NVRC"
+
+    struct FileHeader
+    {
+        uint32_t magic = c_FileMagic;
+        uint32_t headerVersion = c_HeaderVersion;
+    };
+
+    enum class Op : uint16_t
+    {
+        // Device records
+        CreateTexture,
+        CreateStagingTexture,
+        CreateBuffer,
+        WriteMappedBuffer,
+        CreateShader,
+        CreateSampler,
+        CreateInputLayout,
+        CreateBindingLayout,
+        CreateBindingSet,
+        CreateFramebuffer,
+        CreateGraphicsPipeline,
+        CreateComputePipeline,
+        CreateMeshletPipeline,
+        CreateCommandList,
+        CommandList,
+        ExecuteCommandLists,
+        EndFrame,
+        WaitForIdle,
+
+        // Command list records
+        Open,
+        Close,
+        ClearState,
+        ClearTextureFloat,
+        ClearDepthStencilTexture,
+        ClearTextureUInt,
+        CopyTexture,
+        CopyTextureToStaging,
+        CopyTextureFromStaging,
+        WriteTexture,
+        WriteTextureRegions,
+        ResolveTexture,
+        WriteBuffer,
+        ClearBufferUInt,
+        CopyBuffer,
+        SetPushConstants,
+        CreateTransientBindingSet,
+        SetGraphicsState,
+        SetGraphicsBindingSet,
+        SetVertexBuffers,
+        SetIndexBuffer,
+        BeginRenderPassScope,
+        EndRenderPassScope,
+        Draw,
+        DrawIndexed,
+        DrawMulti,
+        DrawIndexedMulti,
+        DrawIndirect,
+        DrawIndexedIndirect,
+        DrawIndexedIndirectCount,
+        SetComputeState,
+        Dispatch,
+        DispatchIndirect,
+        SetMeshletState,
+        DispatchMesh,
+        DispatchMeshIndirect,
+        DispatchMeshIndirectCount,
+        BeginMarker,
+        EndMarker,
+        SetEnableAutomaticBarriers,
+        SetResourceStatesForBindingSet,
+        SetEnableUavBarriersForTexture,
+        SetEnableUavBarriersForBuffer,
+        BeginTrackingTextureState,
+        BeginTrackingBufferState,
+        SetTextureState,
+        SetBufferState,
+        SetPermanentTextureState,
+        SetPermanentBufferState,
+        CommitBarriers,
+
+        // A device or command list call that is not captured, stored with the function name
+        Unsupported
+    };
+
+    struct RecordHeader
+    {
+        Op op = Op::Unsupported;
+        uint16_t reserved = 0;
+        uint32_t size = 0;
+    };
+
+    // Implemented by the DeviceWrapper, 0 stands for nullptr and for objects that were not created through the layer
+    class IObjectIdSource
+    {
+    public:
+        virtual uint32_t getObjectId(IResource* object) = 0;
+    protected:
+        ~IObjectIdSource() = default;
+    };
+
+    // Serializes the NVRHI structures used by the captured calls through the primitives of the derived
+    // RecordWriter or RecordReader, so that both directions share one description of every structure.
+    // Object pointers and handles are stored as object IDs.
+    template<typename Archive>
+    class Serializer
+    {
+    public:
+        template<typename... Args>
+        void operator()(Args&... args) { (item(args), ...); }
+
+        template<typename T>
+        void item(T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Structures with strings, containers or objects need an explicit item(...) overload");
+            self().pod(value);
+        }
+
+        template<typename T>
+        void item(T*& object)
+        {
+            static_assert(std::is_base_of_v<IResource, T>, "Only object pointers can be serialized");
+            self().object(object);
+        }
+
+        template<typename T>
+        void item(RefCountPtr<T>& handle)
+        {
+            T* object = handle.Get();
+            item(object);
+            if constexpr (Archive::IsReading)
+                handle = object;
+        }
+
+        void item(std::string& value) { self().string(value); }
+
+        template<typename T>
+        void item(std::vector<T>& values)
+        {
+            uint32_t count = uint32_t(values.size());
+            item(count);
+            if constexpr (Archive::IsReading)
+                values.resize(self().checkCount(count));
+            for (T& value : values)
+                item(value);
+        }
+
+        template<typename T, uint32_t N>
+        void item(static_vector<T, N>& values)
+        {
+            uint32_t count = uint32_t(values.size());
+            item(count);
+            if constexpr (Archive::IsReading)
+                values.resize(uint32_t(std::min(self().checkCount(count), size_t(N))));
+            for (T& value : values)
+                item(value);
+        }
+
+        void item(TextureDesc& d)
+        {
+            (*this)(d.width, d.height, d.depth, d.arraySize, d.mipLevels, d.sampleCount, d.sampleQuality, d.format,
+                d.dimension, d.debugName, d.isShaderResource, d.isRenderTarget, d.isUAV, d.isTypeless,
+                d.isShadingRateSurface, d.sharedResourceFlags, d.isVirtual, d.isTiled, d.clearValue, d.useClearValue,
+                d.initialState, d.keepInitialState);
+        }
+
+        void item(BufferDesc& d)
+        {
+            (*this)(d.byteSize, d.structStride, d.maxVersions, d.debugName, d.format, d.canHaveUAVs, d.canHaveTypedViews,
+                d.canHaveRawViews, d.isVertexBuffer, d.isIndexBuffer, d.isConstantBuffer, d.isDrawIndirectArgs,
+                d.isAccelStructBuildInput, d.isAccelStructStorage, d.isShaderBindingTable, d.isPredicationBuffer,
+                d.isVolatile, d.isVirtual, d.initialState, d.keepInitialState, d.cpuAccess, d.sharedResourceFlags);
+        }
+
+        // The custom semantics and coordinate swizzling of fast geometry shaders are not captured
+        void item(ShaderDesc& d)
+        {
+            (*this)(d.shaderType, d.debugName, d.entryName, d.hlslExtensionsUAV, d.useSpecificShaderExt, d.fastGSFlags);
+        }
+
+        void item(VertexAttributeDesc& d)
+        {
+            (*this)(d.name, d.format, d.arraySize, d.bufferIndex, d.offset, d.elementStride, d.isInstanced);
+        }
+
+        void item(BindingLayoutDesc& d)
+        {
+            (*this)(d.visibility, d.registerSpace, d.registerSpaceIsDescriptorSet, d.usePushDescriptors, d.bindings,
+                d.bindingOffsets);
+        }
+
+        void item(BindingSetItem& d) { podWithObject(d, &BindingSetItem::resourceHandle); }
+        void item(BindingSetDesc& d) { (*this)(d.bindings, d.trackLiveness); }
+        void item(FramebufferAttachment& d) { podWithObject(d, &FramebufferAttachment::texture); }
+        void item(FramebufferDesc& d) { (*this)(d.colorAttachments, d.depthAttachment, d.shadingRateAttachment); }
+
+        void item(GraphicsPipelineDesc& d)
+        {
+            (*this)(d.primType, d.patchControlPoints, d.inputLayout, d.VS, d.HS, d.DS, d.GS, d.PS, d.renderState,
+                d.shadingRateState, d.dynamicRenderState, d.bindingLayouts);
+        }
+
+        void item(ComputePipelineDesc& d) { (*this)(d.CS, d.bindingLayouts); }
+        void item(MeshletPipelineDesc& d) { (*this)(d.primType, d.AS, d.MS, d.PS, d.renderState, d.bindingLayouts); }
+        void item(ViewportState& d) { (*this)(d.viewports, d.scissorRects); }
+        void item(VertexBufferBinding& d) { podWithObject(d, &VertexBufferBinding::buffer); }
+        void item(IndexBufferBinding& d) { podWithObject(d, &IndexBufferBinding::buffer); }
+
+        void item(GraphicsState& d)
+        {
+            (*this)(d.pipeline, d.framebuffer, d.viewport, d.shadingRateState, d.blendConstantColor,
+                d.dynamicStencilRefValue, d.dynamicRenderState, d.bindings, d.vertexBuffers, d.indexBuffer,
+                d.indirectParams, d.indirectCountBuffer);
+        }
+
+        void item(ComputeState& d) { (*this)(d.pipeline, d.bindings, d.indirectParams, d.indirectCountBuffer); }
+
+        void item(MeshletState& d)
+        {
+            (*this)(d.pipeline, d.framebuffer, d.viewport, d.blendConstantColor, d.dynamicStencilRefValue, d.bindings,
+                d.indirectParams, d.indirectCountBuffer);
+        }
+
+        void item(RenderPassScope& d) { (*this)(d.framebuffer, d.bindingSets, d.vertexBuffers, d.indexBuffers, d.indirectBuffers); }
+
+    private:
+        Archive& self() { return static_cast<Archive&>(*this); }
+
+        // Stores a plain structure that has one object pointer in it
+        template<typename T, typename R>
+        void podWithObject(T& value, R* T::* member)
+        {
+            T data = value;
+            data.*member = nullptr;
+            self().pod(data);
+            R* object = value.*member;
+            item(object);
+            if constexpr (Archive::IsReading)
+            {
+                value = data;
+                value.*member = object;
+            }
+        }
+    };
+
+    class RecordWriter : public Serializer<RecordWriter>
+    {
+    public:
+        static constexpr bool IsReading = false;
+
+        RecordWriter(std::vector<uint8_t>& output, IObjectIdSource& objects)
+            : m_Output(output)
+            , m_Objects(objects)
+        { }
+
+        void begin(Op op);
+        void end();
+
+        // Nothing is modified when writing, so the arguments can be const
+        template<typename... Args>
+        void operator()(const Args&... args) { (item(const_cast<Args&>(args)), ...); }
+
+        // Writes a complete record with the given arguments
+        template<typename... Args>
+        void record(Op op, const Args&... args)
+        {
+            begin(op);
+            (*this)(args...);
+            end();
+        }
+
+        template<typename T>
+        void pod(const T& value) { bytes(&value, sizeof(T)); }
+        void string(const std::string& value);
+        void object(IResource* object);
+        void blob(const void* data, size_t size);
+        size_t checkCount(uint32_t count) const { return count; }
+
+    private:
+        void bytes(const void* data, size_t size);
+
+        std::vector<uint8_t>& m_Output;
+        IObjectIdSource& m_Objects;
+        size_t m_RecordStart = 0;
+    };
+
+    class RecordReader : public Serializer<RecordReader>
+    {
+    public:
+        static constexpr bool IsReading = true;
+
+        RecordReader(const uint8_t* data, size_t size, const std::vector<IResource*>& objects, uint64_t& missingObjects)
+            : m_Data(data)
+            , m_End(data + size)
+            , m_Objects(objects)
+            , m_MissingObjects(missingObjects)
+        { }
+
+        // Reads the header of the next record and returns the location of its arguments
+        bool next(Op& outOp, const uint8_t*& outData, uint32_t& outSize);
+        [[nodiscard]] bool atEnd() const { return m_Data == m_End; }
+        [[nodiscard]] bool failed() const { return m_Failed; }
+
+        template<typename T>
+        void pod(T& value) { bytes(&value, sizeof(T)); }
+        void string(std::string& value);
+        void blob(const void*& outData, size_t& outSize);
+        size_t checkCount(uint32_t count);
+
+        template<typename T>
+        void object(T*& object)
+        {
+            uint32_t id = 0;
+            pod(id);
+            IResource* resource = id < m_Objects.size() ? m_Objects[id] : nullptr;
+            object = dynamic_cast<T*>(resource);
+            if (id != 0 && !object)
+                ++m_MissingObjects;
+        }
+
+        // Returns the ID without resolving it, for the records that create objects
+        uint32_t objectId() { uint32_t id = 0; pod(id); return id; }
+
+    private:
+        void bytes(void* data, size_t size);
+
+        const uint8_t* m_Data;
+        const uint8_t* m_End;
+        const std::vector<IResource*>& m_Objects;
+        uint64_t& m_MissingObjects;
+        bool m_Failed = false;
+    };
+
+    class DeviceWrapper;
+
+    class CommandListWrapper : public RefCounter<ICommandList>
+    {
+    public:
+        friend class DeviceWrapper;
+
+        CommandListWrapper(DeviceWrapper* device, ICommandList* commandList, uint32_t objectId);
+
+        [[nodiscard]] ICommandList* getUnderlyingCommandList() const { return m_CommandList; }
+        [[nodiscard]] uint32_t getObjectId() const { return m_ObjectId; }
+
+    protected:
+        CommandListHandle m_CommandList;
+        RefCountPtr<DeviceWrapper> m_Device;
+        uint32_t m_ObjectId;
+
+        // Records of the current recording, written to the trace file on close
+        std::vector<uint8_t> m_Records;
+
+        template<typename... Args>
+        void record(Op op, const Args&... args);
+        void unsupported(const char* function);
+
+        // Returns nullptr when resource contents are not captured, so that only the data size is recorded
+        [[nodiscard]] const void* contents(const void* data) const;
+
+    public:
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override { return m_CommandList->getNativeObject(objectType); }
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor) override;
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+
+        void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+
+        void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
+        void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format) override;
+        void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void beginRenderPassScope(const RenderPassScope& scope) override;
+        void endRenderPassScope() override;
+        void executeBundle(ICommandBundle* bundle) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndexedMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes)  override;
+        void executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+            uint32_t countOffsetBytes) override;
+
+        void setMeshletState(const MeshletState& state) override;
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void setRayTracingState(const rt::State& state) override;
+        void dispatchRays(const rt::DispatchRaysArguments& args) override;
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
+        void compactBottomLevelAccelStructs() override;
+        void writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        rt::IndirectInstanceDesc* allocateTopLevelInstances(size_t numInstances) override;
+        void buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
+        void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
+
+        void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+        void resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes) override;
+        void beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op) override;
+        void endPredication() override;
+
+        void beginMarker(const char* name) override;
+        void endMarker() override;
+
+        void setEnableAutomaticBarriers(bool enable) override;
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override;
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
+        void commitBarriers() override;
+
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override { return m_CommandList->getTextureSubresourceState(texture, arraySlice, mipLevel); }
+        ResourceStates getBufferState(IBuffer* buffer) override { return m_CommandList->getBufferState(buffer); }
+
+        IDevice* getDevice() override;
+        const CommandListParameters& getDesc() override { return m_CommandList->getDesc(); }
+        BarrierStatistics getBarrierStatistics() override { return m_CommandList->getBarrierStatistics(); }
+        CommandListStatistics getStatistics() override { return m_CommandList->getStatistics(); }
+    };
+
+    class DeviceWrapper : public RefCounter<IDevice>, public IObjectIdSource
+    {
+    public:
+        friend class CommandListWrapper;
+
+        DeviceWrapper(IDevice* device, const CaptureLayerDesc& desc, std::ofstream&& file);
+        ~DeviceWrapper() override;
+
+        uint32_t getObjectId(IResource* object) override;
+
+    protected:
+        DeviceHandle m_Device;
+        CaptureLayerDesc m_Desc;
+
+        std::mutex m_FileMutex;
+        std::ofstream m_File;
+        std::vector<uint8_t> m_RecordBuffer;
+
+        std::mutex m_ObjectMutex;
+        std::unordered_map<IResource*, uint32_t> m_ObjectIds;
+        uint32_t m_NextObjectId = 1;
+
+        struct MappedBuffer
+        {
+            uint8_t* data = nullptr;
+            uint64_t offset = 0;
+            size_t size = 0;
+            bool flushed = false;
+        };
+
+        // Buffers that are mapped for writing, whose contents are recorded on unmap
+        std::mutex m_MappedBufferMutex;
+        std::unordered_map<IBuffer*, MappedBuffer> m_MappedBuffers;
+
+        // Runs the create...Pipeline functions of this wrapper, so that the async versions are captured too
+        PipelineCompilePool m_PipelineCompilePool;
+
+        uint32_t registerObject(IResource* object);
+
+        // Writes one record to the trace file, the body writes the arguments of the record
+        template<typename Body>
+        void writeRecord(Op op, Body&& body)
+        {
+            std::lock_guard lockGuard(m_FileMutex);
+            RecordWriter writer(m_RecordBuffer, *this);
+            writer.begin(op);
+            body(writer);
+            writer.end();
+            m_File.write(reinterpret_cast<const char*>(m_RecordBuffer.data()), std::streamsize(m_RecordBuffer.size()));
+            m_RecordBuffer.clear();
+        }
+
+        void unsupported(const char* function);
+        void writeCommandList(uint32_t commandListId, const std::vector<uint8_t>& records);
+        void recordMappedRange(IBuffer* buffer, uint64_t offset, size_t size);
+        static ICommandList* unwrapCommandList(ICommandList* commandList);
+
+    public:
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override { return m_Device->getNativeObject(objectType); }
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override { return m_Device->getTextureMemoryRequirements(texture); }
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override { return m_Device->bindTextureMemory(texture, heap, offset); }
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override { return m_Device->mapStagingTexture(tex, slice, cpuAccess, outRowPitch); }
+        void unmapStagingTexture(IStagingTexture* tex) override { m_Device->unmapStagingTexture(tex); }
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override { m_Device->getTextureTiling(texture, numTiles, desc, tileShape, subresourceTilingsNum, subresourceTilings); }
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue = CommandQueue::Graphics) override;
+
+        SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+        SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        BufferHandle createBufferFromHostMemory(const BufferDesc& d, void* hostMemory) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, uint64_t offset, size_t size) override;
+        void unmapBuffer(IBuffer* b) override;
+        void flushMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
+        void invalidateMappedRange(IBuffer* b, uint64_t offset, size_t size) override { m_Device->invalidateMappedRange(b, offset, size); }
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override { return m_Device->getBufferMemoryRequirements(buffer); }
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override { return m_Device->bindBufferMemory(buffer, heap, offset); }
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        // event queries
+        EventQueryHandle createEventQuery() override { return m_Device->createEventQuery(); }
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override { m_Device->setEventQuery(query, queue); }
+        bool pollEventQuery(IEventQuery* query) override { return m_Device->pollEventQuery(query); }
+        void waitEventQuery(IEventQuery* query) override { m_Device->waitEventQuery(query); }
+        void resetEventQuery(IEventQuery* query) override { m_Device->resetEventQuery(query); }
+
+        // timer queries
+        TimerQueryHandle createTimerQuery() override { return m_Device->createTimerQuery(); }
+        bool pollTimerQuery(ITimerQuery* query) override { return m_Device->pollTimerQuery(query); }
+        float getTimerQueryTime(ITimerQuery* query) override { return m_Device->getTimerQueryTime(query); }
+        void resetTimerQuery(ITimerQuery* query) override { m_Device->resetTimerQuery(query); }
+        TimestampQueryPoolHandle createTimestampQueryPool(const TimestampQueryPoolDesc& desc) override { return m_Device->createTimestampQueryPool(desc); }
+        bool getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) override { return m_Device->getTimestampResults(pool, firstQuery, queryCount, outTimestamps); }
+        uint64_t getTimestampFrequency(CommandQueue queue) override { return m_Device->getTimestampFrequency(queue); }
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override { return m_Device->createQueryPool(desc); }
+
+        GraphicsAPI getGraphicsAPI() override { return m_Device->getGraphicsAPI(); }
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+        IndirectCommandLayoutHandle createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override;
+        PendingPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createGraphicsPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override { return m_PipelineCompilePool.createComputePipeline(this, desc); }
+        PendingPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createMeshletPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override { return m_PipelineCompilePool.createRayTracingPipeline(this, desc); }
+        PendingPipelineHandle addToRayTracingPipelineAsync(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override { return m_PipelineCompilePool.addToRayTracingPipeline(this, pipeline, additions); }
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override { return m_Device->getAccelStructMemoryRequirements(as); }
+        rt::AccelStructBuildSizes getAccelStructBuildSizes(const rt::AccelStructDesc& desc) override { return m_Device->getAccelStructBuildSizes(desc); }
+        bool isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header) override { return m_Device->isSerializedAccelStructCompatible(header); }
+        rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override { return m_Device->getClusterOperationSizeInfo(params); }
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override { return m_Device->bindAccelStructMemory(as, heap, offset); }
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override { m_Device->queueWaitForCommandList(waitQueue, executionQueue, instance); }
+        void executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances = nullptr) override;
+        bool waitForIdle() override;
+        void runGarbageCollection() override;
+        bool runIncrementalGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds = 2) override { m_Device->setBackgroundGarbageCollection(enable, intervalMilliseconds); }
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override { return m_Device->queryFeatureSupport(feature, pInfo, infoSize); }
+        FormatSupport queryFormatSupport(Format format) override { return m_Device->queryFormatSupport(format); }
+        coopvec::DeviceFeatures queryCoopVecFeatures() override { return m_Device->queryCoopVecFeatures(); }
+        size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override { return m_Device->getCoopVecMatrixSize(type, layout, rows, columns); }
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { return m_Device->getNativeQueue(objectType, queue); }
+        IMessageCallback* getMessageCallback() override { return m_Device->getMessageCallback(); }
+        void setInstrumentationCallback(IInstrumentationCallback* callback) override { m_Device->setInstrumentationCallback(callback); }
+        bool isAftermathEnabled() override { return m_Device->isAftermathEnabled(); }
+        AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_Device->getAftermathCrashDumpHelper(); }
+        bool getPipelineCacheData(void* data, size_t* dataSize) override { return m_Device->getPipelineCacheData(data, dataSize); }
+        UploadRingStatistics getUploadRingStatistics(CommandQueue queue) override { return m_Device->getUploadRingStatistics(queue); }
+        MemoryStatistics getMemoryStatistics() override { return m_Device->getMemoryStatistics(); }
+        void enumerateResourceAllocations(IResourceAllocationCallback& callback) override { m_Device->enumerateResourceAllocations(callback); }
+        BarrierStatistics getBarrierStatistics(CommandQueue queue) override { return m_Device->getBarrierStatistics(queue); }
+        void resetBarrierStatistics() override { m_Device->resetBarrierStatistics(); }
+        CommandListStatistics getCommandListStatistics(CommandQueue queue) override { return m_Device->getCommandListStatistics(queue); }
+        void resetCommandListStatistics() override { m_Device->resetCommandListStatistics(); }
+        PipelineCreationStatistics getPipelineCreationStatistics() override { return m_Device->getPipelineCreationStatistics(); }
+        void resetPipelineCreationStatistics() override { m_Device->resetPipelineCreationStatistics(); }
+    };
+
+    template<typename... Args>
+    void CommandListWrapper::record(Op op, const Args&... args)
+    {
+        RecordWriter writer(m_Records, *m_Device);
+        writer.record(op, args...);
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,666 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+namespace nvrhi::capture
+{
+    // Number of bytes that writeTexture reads for a slice, the last row and slice may be shorter than the pitch
+    static size_t GetTextureDataSize(const TextureDesc& desc, const TextureSlice& slice, size_t rowPitch, size_t depthPitch)
+    {
+        const TextureSlice resolved = slice.resolve(desc);
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max(uint32_t(formatInfo.blockSize), 1u);
+        const size_t widthInBlocks = (resolved.width + blockSize - 1) / blockSize;
+        const size_t heightInBlocks = (resolved.height + blockSize - 1) / blockSize;
+
+        if (widthInBlocks == 0 || heightInBlocks == 0 || resolved.depth == 0)
+            return 0;
+
+        return depthPitch * (resolved.depth - 1) + rowPitch * (heightInBlocks - 1) + widthInBlocks * formatInfo.bytesPerBlock;
+    }
+
+    CommandListWrapper::CommandListWrapper(DeviceWrapper* device, ICommandList* commandList, uint32_t objectId)
+        : m_CommandList(commandList)
+        , m_Device(device)
+        , m_ObjectId(objectId)
+    { }
+
+    void CommandListWrapper::unsupported(const char* function)
+    {
+        std::string name = function;
+        record(Op::Unsupported, name);
+    }
+
+    const void* CommandListWrapper::contents(const void* data) const
+    {
+        return m_Device->m_Desc.captureResourceContents ? data : nullptr;
+    }
+
+    IDevice* CommandListWrapper::getDevice()
+    {
+        return m_Device;
+    }
+
+    void CommandListWrapper::open()
+    {
+        m_Records.clear();
+        record(Op::Open);
+        m_CommandList->open();
+    }
+
+    void CommandListWrapper::close()
+    {
+        record(Op::Close);
+        m_CommandList->close();
+
+        m_Device->writeCommandList(m_ObjectId, m_Records);
+        m_Records.clear();
+    }
+
+    void CommandListWrapper::clearState()
+    {
+        record(Op::ClearState);
+        m_CommandList->clearState();
+    }
+
+    void CommandListWrapper::clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        record(Op::ClearTextureFloat, t, subresources, clearColor);
+        m_CommandList->clearTextureFloat(t, subresources, clearColor);
+    }
+
+    void CommandListWrapper::clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        record(Op::ClearDepthStencilTexture, t, subresources, clearDepth, depth, clearStencil, stencil);
+        m_CommandList->clearDepthStencilTexture(t, subresources, clearDepth, depth, clearStencil, stencil);
+    }
+
+    void CommandListWrapper::clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        record(Op::ClearTextureUInt, t, subresources, clearColor);
+        m_CommandList->clearTextureUInt(t, subresources, clearColor);
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        record(Op::CopyTexture, dest, destSlice, src, srcSlice);
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        record(Op::CopyTextureToStaging, dest, destSlice, src, srcSlice);
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice)
+    {
+        record(Op::CopyTextureFromStaging, dest, destSlice, src, srcSlice);
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        if (dest)
+        {
+            const TextureSlice slice = TextureSlice().setArraySlice(arraySlice).setMipLevel(mipLevel);
+            const size_t dataSize = GetTextureDataSize(dest->getDesc(), slice, rowPitch, depthPitch);
+
+            RecordWriter writer(m_Records, *m_Device);
+            writer.begin(Op::WriteTexture);
+            writer(dest, arraySlice, mipLevel, rowPitch, depthPitch);
+            writer.blob(contents(data), dataSize);
+            writer.end();
+        }
+
+        m_CommandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+    }
+
+    void CommandListWrapper::writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions)
+    {
+        if (dest && regions)
+        {
+            const TextureDesc& desc = dest->getDesc();
+            const uint32_t count = uint32_t(numRegions);
+
+            RecordWriter writer(m_Records, *m_Device);
+            writer.begin(Op::WriteTextureRegions);
+            writer(dest, count);
+            for (size_t i = 0; i < numRegions; i++)
+            {
+                const TextureUploadRegion& region = regions[i];
+                const size_t dataSize = GetTextureDataSize(desc, region.slice, region.rowPitch, region.depthPitch);
+                writer(region.slice, region.rowPitch, region.depthPitch);
+                writer.blob(contents(region.data), dataSize);
+            }
+            writer.end();
+        }
+
+        m_CommandList->writeTextureRegions(dest, regions, numRegions);
+    }
+
+    void CommandListWrapper::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
+    {
+        record(Op::ResolveTexture, dest, dstSubresources, src, srcSubresources);
+        m_CommandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
+    }
+
+    void CommandListWrapper::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        RecordWriter writer(m_Records, *m_Device);
+        writer.begin(Op::WriteBuffer);
+        writer(b, destOffsetBytes);
+        writer.blob(contents(data), dataSize);
+        writer.end();
+
+        m_CommandList->writeBuffer(b, data, dataSize, destOffsetBytes);
+    }
+
+    void CommandListWrapper::clearBufferUInt(IBuffer* b, uint32_t clearValue)
+    {
+        record(Op::ClearBufferUInt, b, clearValue);
+        m_CommandList->clearBufferUInt(b, clearValue);
+    }
+
+    void CommandListWrapper::copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        record(Op::CopyBuffer, dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+        m_CommandList->copyBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+    }
+
+    void CommandListWrapper::clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture)
+    {
+        unsupported("clearSamplerFeedbackTexture");
+        m_CommandList->clearSamplerFeedbackTexture(texture);
+    }
+
+    void CommandListWrapper::decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format)
+    {
+        unsupported("decodeSamplerFeedbackTexture");
+        m_CommandList->decodeSamplerFeedbackTexture(buffer, texture, format);
+    }
+
+    void CommandListWrapper::setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits)
+    {
+        unsupported("setSamplerFeedbackTextureState");
+        m_CommandList->setSamplerFeedbackTextureState(texture, stateBits);
+    }
+
+    void CommandListWrapper::setPushConstants(const void* data, size_t byteSize)
+    {
+        // Push constants are a part of the command stream, so they are recorded even without the resource contents
+        RecordWriter writer(m_Records, *m_Device);
+        writer.begin(Op::SetPushConstants);
+        writer.blob(data, byteSize);
+        writer.end();
+
+        m_CommandList->setPushConstants(data, byteSize);
+    }
+
+    IBindingSet* CommandListWrapper::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        IBindingSet* bindingSet = m_CommandList->createTransientBindingSet(desc, layout);
+        if (bindingSet)
+        {
+            const uint32_t id = m_Device->registerObject(bindingSet);
+            record(Op::CreateTransientBindingSet, id, desc, layout);
+        }
+        return bindingSet;
+    }
+
+    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        record(Op::SetGraphicsState, state);
+        m_CommandList->setGraphicsState(state);
+    }
+
+    void CommandListWrapper::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        record(Op::SetGraphicsBindingSet, slot, bindingSet);
+        m_CommandList->setGraphicsBindingSet(slot, bindingSet);
+    }
+
+    void CommandListWrapper::setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings)
+    {
+        std::vector<VertexBufferBinding> bindingVector;
+        if (bindings)
+            bindingVector.assign(bindings, bindings + numBindings);
+
+        record(Op::SetVertexBuffers, bindingVector);
+        m_CommandList->setVertexBuffers(bindings, numBindings);
+    }
+
+    void CommandListWrapper::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        record(Op::SetIndexBuffer, binding);
+        m_CommandList->setIndexBuffer(binding);
+    }
+
+    void CommandListWrapper::beginRenderPassScope(const RenderPassScope& scope)
+    {
+        record(Op::BeginRenderPassScope, scope);
+        m_CommandList->beginRenderPassScope(scope);
+    }
+
+    void CommandListWrapper::endRenderPassScope()
+    {
+        record(Op::EndRenderPassScope);
+        m_CommandList->endRenderPassScope();
+    }
+
+    void CommandListWrapper::executeBundle(ICommandBundle* bundle)
+    {
+        unsupported("executeBundle");
+        m_CommandList->executeBundle(bundle);
+    }
+
+    void CommandListWrapper::draw(const DrawArguments& args)
+    {
+        record(Op::Draw, args);
+        m_CommandList->draw(args);
+    }
+
+    void CommandListWrapper::drawIndexed(const DrawArguments& args)
+    {
+        record(Op::DrawIndexed, args);
+        m_CommandList->drawIndexed(args);
+    }
+
+    void CommandListWrapper::drawMulti(const DrawArguments* args, size_t numDraws)
+    {
+        std::vector<DrawArguments> argsVector;
+        if (args)
+            argsVector.assign(args, args + numDraws);
+
+        record(Op::DrawMulti, argsVector);
+        m_CommandList->drawMulti(args, numDraws);
+    }
+
+    void CommandListWrapper::drawIndexedMulti(const DrawArguments* args, size_t numDraws)
+    {
+        std::vector<DrawArguments> argsVector;
+        if (args)
+            argsVector.assign(args, args + numDraws);
+
+        record(Op::DrawIndexedMulti, argsVector);
+        m_CommandList->drawIndexedMulti(args, numDraws);
+    }
+
+    void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        record(Op::DrawIndirect, offsetBytes, drawCount);
+        m_CommandList->drawIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        record(Op::DrawIndexedIndirect, offsetBytes, drawCount);
+        m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        record(Op::DrawIndexedIndirectCount, paramOffsetBytes, countOffsetBytes, maxDrawCount);
+        m_CommandList->drawIndexedIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::setComputeState(const ComputeState& state)
+    {
+        record(Op::SetComputeState, state);
+        m_CommandList->setComputeState(state);
+    }
+
+    void CommandListWrapper::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        record(Op::Dispatch, groupsX, groupsY, groupsZ);
+        m_CommandList->dispatch(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchIndirect(uint32_t offsetBytes)
+    {
+        record(Op::DispatchIndirect, offsetBytes);
+        m_CommandList->dispatchIndirect(offsetBytes);
+    }
+
+    void CommandListWrapper::executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+        uint32_t countOffsetBytes)
+    {
+        unsupported("executeIndirectCommands");
+        m_CommandList->executeIndirectCommands(layout, paramOffsetBytes, maxCommandCount, countOffsetBytes);
+    }
+
+    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    {
+        record(Op::SetMeshletState, state);
+        m_CommandList->setMeshletState(state);
+    }
+
+    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        record(Op::DispatchMesh, groupsX, groupsY, groupsZ);
+        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        record(Op::DispatchMeshIndirect, offsetBytes, drawCount);
+        m_CommandList->dispatchMeshIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        record(Op::DispatchMeshIndirectCount, paramOffsetBytes, countOffsetBytes, maxDrawCount);
+        m_CommandList->dispatchMeshIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::setRayTracingState(const rt::State& state)
+    {
+        unsupported("setRayTracingState");
+        m_CommandList->setRayTracingState(state);
+    }
+
+    void CommandListWrapper::dispatchRays(const rt::DispatchRaysArguments& args)
+    {
+        unsupported("dispatchRays");
+        m_CommandList->dispatchRays(args);
+    }
+
+    void CommandListWrapper::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
+    {
+        unsupported("buildOpacityMicromap");
+        m_CommandList->buildOpacityMicromap(omm, desc);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildBottomLevelAccelStruct");
+        m_CommandList->buildBottomLevelAccelStruct(as, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        unsupported("buildBottomLevelAccelStructs");
+        m_CommandList->buildBottomLevelAccelStructs(pBuilds, numBuilds);
+    }
+
+    void CommandListWrapper::compactBottomLevelAccelStructs()
+    {
+        unsupported("compactBottomLevelAccelStructs");
+        m_CommandList->compactBottomLevelAccelStructs();
+    }
+
+    void CommandListWrapper::writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset)
+    {
+        unsupported("writeAccelStructSerializedSize");
+        m_CommandList->writeAccelStructSerializedSize(as, buffer, offset);
+    }
+
+    void CommandListWrapper::serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset)
+    {
+        unsupported("serializeAccelStruct");
+        m_CommandList->serializeAccelStruct(as, buffer, offset);
+    }
+
+    void CommandListWrapper::deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset)
+    {
+        unsupported("deserializeAccelStruct");
+        m_CommandList->deserializeAccelStruct(as, buffer, offset);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildTopLevelAccelStruct");
+        m_CommandList->buildTopLevelAccelStruct(as, pInstances, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildTopLevelAccelStructFromBuffer");
+        m_CommandList->buildTopLevelAccelStructFromBuffer(as, instanceBuffer, instanceBufferOffset, numInstances, buildFlags);
+    }
+
+    rt::IndirectInstanceDesc* CommandListWrapper::allocateTopLevelInstances(size_t numInstances)
+    {
+        return m_CommandList->allocateTopLevelInstances(numInstances);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        unsupported("buildTopLevelAccelStructFromAllocatedInstances");
+        m_CommandList->buildTopLevelAccelStructFromAllocatedInstances(as, pInstances, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        unsupported("updateTopLevelInstances");
+        m_CommandList->updateTopLevelInstances(as, firstInstance, pInstances, numInstances);
+    }
+
+    void CommandListWrapper::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
+    {
+        unsupported("executeMultiIndirectClusterOperation");
+        m_CommandList->executeMultiIndirectClusterOperation(desc);
+    }
+
+    void CommandListWrapper::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
+    {
+        unsupported("convertCoopVecMatrices");
+        m_CommandList->convertCoopVecMatrices(convertDescs, numDescs);
+    }
+
+    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    {
+        unsupported("beginTimerQuery");
+        m_CommandList->beginTimerQuery(query);
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
+    {
+        unsupported("endTimerQuery");
+        m_CommandList->endTimerQuery(query);
+    }
+
+    void CommandListWrapper::resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        unsupported("resetTimestamps");
+        m_CommandList->resetTimestamps(pool, firstQuery, queryCount);
+    }
+
+    void CommandListWrapper::writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex)
+    {
+        unsupported("writeTimestamp");
+        m_CommandList->writeTimestamp(pool, queryIndex);
+    }
+
+    void CommandListWrapper::resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        unsupported("resolveTimestamps");
+        m_CommandList->resolveTimestamps(pool, firstQuery, queryCount);
+    }
+
+    void CommandListWrapper::resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        unsupported("resetQueries");
+        m_CommandList->resetQueries(pool, firstQuery, queryCount);
+    }
+
+    void CommandListWrapper::beginQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        unsupported("beginQuery");
+        m_CommandList->beginQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::endQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        unsupported("endQuery");
+        m_CommandList->endQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes)
+    {
+        unsupported("resolveQueries");
+        m_CommandList->resolveQueries(pool, firstQuery, queryCount, dest, destOffsetBytes);
+    }
+
+    void CommandListWrapper::beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        unsupported("beginPredication");
+        m_CommandList->beginPredication(buffer, offsetBytes, op);
+    }
+
+    void CommandListWrapper::endPredication()
+    {
+        unsupported("endPredication");
+        m_CommandList->endPredication();
+    }
+
+    void CommandListWrapper::beginMarker(const char* name)
+    {
+        std::string markerName = name ? name : "";
+        record(Op::BeginMarker, markerName);
+        m_CommandList->beginMarker(name);
+    }
+
+    void CommandListWrapper::endMarker()
+    {
+        record(Op::EndMarker);
+        m_CommandList->endMarker();
+    }
+
+    void CommandListWrapper::setEnableAutomaticBarriers(bool enable)
+    {
+        record(Op::SetEnableAutomaticBarriers, enable);
+        m_CommandList->setEnableAutomaticBarriers(enable);
+    }
+
+    void CommandListWrapper::setResourceStatesForBindingSet(IBindingSet* bindingSet)
+    {
+        record(Op::SetResourceStatesForBindingSet, bindingSet);
+        m_CommandList->setResourceStatesForBindingSet(bindingSet);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
+    {
+        record(Op::SetEnableUavBarriersForTexture, texture, enableBarriers);
+        m_CommandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers)
+    {
+        record(Op::SetEnableUavBarriersForBuffer, buffer, enableBarriers);
+        m_CommandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandListWrapper::beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        record(Op::BeginTrackingTextureState, texture, subresources, stateBits);
+        m_CommandList->beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        record(Op::BeginTrackingBufferState, buffer, stateBits);
+        m_CommandList->beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        record(Op::SetTextureState, texture, subresources, stateBits);
+        m_CommandList->setTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::setBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        record(Op::SetBufferState, buffer, stateBits);
+        m_CommandList->setBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits)
+    {
+        unsupported("setAccelStructState");
+        m_CommandList->setAccelStructState(as, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentTextureState(ITexture* texture, ResourceStates stateBits)
+    {
+        record(Op::SetPermanentTextureState, texture, stateBits);
+        m_CommandList->setPermanentTextureState(texture, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        record(Op::SetPermanentBufferState, buffer, stateBits);
+        m_CommandList->setPermanentBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        unsupported("beginTextureStateTransition");
+        m_CommandList->beginTextureStateTransition(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits)
+    {
+        unsupported("beginBufferStateTransition");
+        m_CommandList->beginBufferStateTransition(buffer, stateBits);
+    }
+
+    void CommandListWrapper::releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        unsupported("releaseTextureOwnership");
+        m_CommandList->releaseTextureOwnership(texture, subresources, destinationQueue, stateBits);
+    }
+
+    void CommandListWrapper::acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        unsupported("acquireTextureOwnership");
+        m_CommandList->acquireTextureOwnership(texture, subresources, sourceQueue, stateBits);
+    }
+
+    void CommandListWrapper::releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        unsupported("releaseBufferOwnership");
+        m_CommandList->releaseBufferOwnership(buffer, destinationQueue, stateBits);
+    }
+
+    void CommandListWrapper::acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        unsupported("acquireBufferOwnership");
+        m_CommandList->acquireBufferOwnership(buffer, sourceQueue, stateBits);
+    }
+
+    void CommandListWrapper::setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        unsupported("setAliasingBarrier");
+        m_CommandList->setAliasingBarrier(resourceBefore, resourceAfter);
+    }
+
+    void CommandListWrapper::commitBarriers()
+    {
+        record(Op::CommitBarriers);
+        m_CommandList->commitBarriers();
+    }
+
+} // namespace nvrhi::capture
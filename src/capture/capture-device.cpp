@@ -0,0 +1,586 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+namespace nvrhi::capture
+{
+    DeviceHandle createCaptureLayer(IDevice* underlyingDevice, const CaptureLayerDesc& desc)
+    {
+        std::ofstream file(desc.fileName, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            underlyingDevice->getMessageCallback()->message(MessageSeverity::Error,
+                ("Capture layer: cannot create the trace file " + desc.fileName).c_str());
+            return nullptr;
+        }
+
+        FileHeader header;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice, desc, std::move(file));
+        return DeviceHandle::Create(wrapper);
+    }
+
+    void RecordWriter::begin(Op op)
+    {
+        m_RecordStart = m_Output.size();
+        RecordHeader header;
+        header.op = op;
+        pod(header);
+    }
+
+    void RecordWriter::end()
+    {
+        RecordHeader header;
+        memcpy(&header, m_Output.data() + m_RecordStart, sizeof(header));
+        header.size = uint32_t(m_Output.size() - m_RecordStart - sizeof(header));
+        memcpy(m_Output.data() + m_RecordStart, &header, sizeof(header));
+    }
+
+    void RecordWriter::string(const std::string& value)
+    {
+        uint32_t length = uint32_t(value.size());
+        pod(length);
+        bytes(value.data(), length);
+    }
+
+    void RecordWriter::object(IResource* object)
+    {
+        uint32_t id = object ? m_Objects.getObjectId(object) : 0;
+        pod(id);
+    }
+
+    void RecordWriter::blob(const void* data, size_t size)
+    {
+        uint64_t length = size;
+        uint8_t present = data != nullptr;
+        pod(length);
+        pod(present);
+        if (present)
+            bytes(data, size);
+    }
+
+    void RecordWriter::bytes(const void* data, size_t size)
+    {
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        m_Output.insert(m_Output.end(), begin, begin + size);
+    }
+
+    DeviceWrapper::DeviceWrapper(IDevice* device, const CaptureLayerDesc& desc, std::ofstream&& file)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_File(std::move(file))
+    { }
+
+    DeviceWrapper::~DeviceWrapper()
+    {
+        m_PipelineCompilePool.shutdown();
+        m_File.flush();
+    }
+
+    uint32_t DeviceWrapper::getObjectId(IResource* object)
+    {
+        std::lock_guard lockGuard(m_ObjectMutex);
+        auto it = m_ObjectIds.find(object);
+        return it != m_ObjectIds.end() ? it->second : 0;
+    }
+
+    uint32_t DeviceWrapper::registerObject(IResource* object)
+    {
+        if (!object)
+            return 0;
+
+        // Object destruction is not tracked, so a new object at the address of a destroyed one simply gets a new ID
+        std::lock_guard lockGuard(m_ObjectMutex);
+        uint32_t id = m_NextObjectId++;
+        m_ObjectIds[object] = id;
+        return id;
+    }
+
+    void DeviceWrapper::unsupported(const char* function)
+    {
+        std::string name = function;
+        writeRecord(Op::Unsupported, [&](RecordWriter& w) { w(name); });
+    }
+
+    void DeviceWrapper::writeCommandList(uint32_t commandListId, const std::vector<uint8_t>& records)
+    {
+        writeRecord(Op::CommandList, [&](RecordWriter& w)
+        {
+            w(commandListId);
+            w.blob(records.data(), records.size());
+        });
+    }
+
+    ICommandList* DeviceWrapper::unwrapCommandList(ICommandList* commandList)
+    {
+        CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(commandList);
+        return wrapper ? wrapper->getUnderlyingCommandList() : commandList;
+    }
+
+    HeapHandle DeviceWrapper::createHeap(const HeapDesc& d)
+    {
+        unsupported("createHeap");
+        return m_Device->createHeap(d);
+    }
+
+    TextureHandle DeviceWrapper::createTexture(const TextureDesc& d)
+    {
+        TextureHandle texture = m_Device->createTexture(d);
+        if (!texture)
+            return nullptr;
+
+        uint32_t id = registerObject(texture);
+        writeRecord(Op::CreateTexture, [&](RecordWriter& w) { w(id, d); });
+        return texture;
+    }
+
+    TextureHandle DeviceWrapper::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        TextureHandle handle = m_Device->createHandleForNativeTexture(objectType, texture, desc);
+        if (!handle)
+            return nullptr;
+
+        // Replayed as a regular texture with the same description
+        uint32_t id = registerObject(handle);
+        writeRecord(Op::CreateTexture, [&](RecordWriter& w) { w(id, desc); });
+        return handle;
+    }
+
+    StagingTextureHandle DeviceWrapper::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        StagingTextureHandle texture = m_Device->createStagingTexture(d, cpuAccess);
+        if (!texture)
+            return nullptr;
+
+        uint32_t id = registerObject(texture);
+        writeRecord(Op::CreateStagingTexture, [&](RecordWriter& w) { w(id, d, cpuAccess); });
+        return texture;
+    }
+
+    void DeviceWrapper::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        unsupported("updateTextureTileMappings");
+        m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
+    }
+
+    void DeviceWrapper::updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue)
+    {
+        unsupported("updateTextureTileMappingsBatch");
+        m_Device->updateTextureTileMappingsBatch(updates, numUpdates, executionQueue);
+    }
+
+    SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        unsupported("createSamplerFeedbackTexture");
+        return m_Device->createSamplerFeedbackTexture(pairedTexture, desc);
+    }
+
+    SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture)
+    {
+        unsupported("createSamplerFeedbackForNativeTexture");
+        return m_Device->createSamplerFeedbackForNativeTexture(objectType, texture, pairedTexture);
+    }
+
+    BufferHandle DeviceWrapper::createBuffer(const BufferDesc& d)
+    {
+        BufferHandle buffer = m_Device->createBuffer(d);
+        if (!buffer)
+            return nullptr;
+
+        uint32_t id = registerObject(buffer);
+        writeRecord(Op::CreateBuffer, [&](RecordWriter& w) { w(id, d); });
+        return buffer;
+    }
+
+    BufferHandle DeviceWrapper::createBufferFromHostMemory(const BufferDesc& d, void* hostMemory)
+    {
+        BufferHandle buffer = m_Device->createBufferFromHostMemory(d, hostMemory);
+        if (!buffer)
+            return nullptr;
+
+        // Replayed as a regular buffer, the host memory contents are not captured
+        uint32_t id = registerObject(buffer);
+        writeRecord(Op::CreateBuffer, [&](RecordWriter& w) { w(id, d); });
+        return buffer;
+    }
+
+    BufferHandle DeviceWrapper::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
+    {
+        BufferHandle handle = m_Device->createHandleForNativeBuffer(objectType, buffer, desc);
+        if (!handle)
+            return nullptr;
+
+        uint32_t id = registerObject(handle);
+        writeRecord(Op::CreateBuffer, [&](RecordWriter& w) { w(id, desc); });
+        return handle;
+    }
+
+    void* DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags)
+    {
+        void* data = m_Device->mapBuffer(b, mapFlags);
+        if (data && mapFlags == CpuAccessMode::Write && m_Desc.captureResourceContents)
+        {
+            std::lock_guard lockGuard(m_MappedBufferMutex);
+            m_MappedBuffers[b] = MappedBuffer{ static_cast<uint8_t*>(data), 0, size_t(b->getDesc().byteSize) };
+        }
+        return data;
+    }
+
+    void* DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags, uint64_t offset, size_t size)
+    {
+        void* data = m_Device->mapBuffer(b, mapFlags, offset, size);
+        if (data && mapFlags == CpuAccessMode::Write && m_Desc.captureResourceContents)
+        {
+            std::lock_guard lockGuard(m_MappedBufferMutex);
+            m_MappedBuffers[b] = MappedBuffer{ static_cast<uint8_t*>(data), offset, size };
+        }
+        return data;
+    }
+
+    void DeviceWrapper::recordMappedRange(IBuffer* buffer, uint64_t offset, size_t size)
+    {
+        std::lock_guard lockGuard(m_MappedBufferMutex);
+        auto it = m_MappedBuffers.find(buffer);
+        if (it == m_MappedBuffers.end())
+            return;
+
+        MappedBuffer& mapping = it->second;
+        if (offset < mapping.offset || offset - mapping.offset >= mapping.size)
+            return;
+
+        size = std::min(size, size_t(mapping.size - (offset - mapping.offset)));
+        const uint8_t* data = mapping.data + (offset - mapping.offset);
+        writeRecord(Op::WriteMappedBuffer, [&](RecordWriter& w)
+        {
+            w(buffer, offset);
+            w.blob(data, size);
+        });
+        mapping.flushed = true;
+    }
+
+    void DeviceWrapper::unmapBuffer(IBuffer* b)
+    {
+        MappedBuffer mapping;
+        {
+            std::lock_guard lockGuard(m_MappedBufferMutex);
+            auto it = m_MappedBuffers.find(b);
+            if (it != m_MappedBuffers.end())
+            {
+                mapping = it->second;
+                m_MappedBuffers.erase(it);
+            }
+        }
+
+        // Without explicit flushes, the whole mapped range is considered written
+        if (mapping.data && !mapping.flushed)
+        {
+            writeRecord(Op::WriteMappedBuffer, [&](RecordWriter& w)
+            {
+                w(b, mapping.offset);
+                w.blob(mapping.data, mapping.size);
+            });
+        }
+
+        m_Device->unmapBuffer(b);
+    }
+
+    void DeviceWrapper::flushMappedRange(IBuffer* b, uint64_t offset, size_t size)
+    {
+        recordMappedRange(b, offset, size);
+        m_Device->flushMappedRange(b, offset, size);
+    }
+
+    ShaderHandle DeviceWrapper::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        ShaderHandle shader = m_Device->createShader(d, binary, binarySize);
+        if (!shader)
+            return nullptr;
+
+        uint32_t id = registerObject(shader);
+        writeRecord(Op::CreateShader, [&](RecordWriter& w)
+        {
+            w(id, d);
+            w.blob(binary, binarySize);
+        });
+        return shader;
+    }
+
+    ShaderHandle DeviceWrapper::createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        unsupported("createShaderSpecialization");
+        return m_Device->createShaderSpecialization(baseShader, constants, numConstants);
+    }
+
+    ShaderLibraryHandle DeviceWrapper::createShaderLibrary(const void* binary, size_t binarySize)
+    {
+        unsupported("createShaderLibrary");
+        return m_Device->createShaderLibrary(binary, binarySize);
+    }
+
+    SamplerHandle DeviceWrapper::createSampler(const SamplerDesc& d)
+    {
+        SamplerHandle sampler = m_Device->createSampler(d);
+        if (!sampler)
+            return nullptr;
+
+        uint32_t id = registerObject(sampler);
+        writeRecord(Op::CreateSampler, [&](RecordWriter& w) { w(id, d); });
+        return sampler;
+    }
+
+    InputLayoutHandle DeviceWrapper::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        InputLayoutHandle inputLayout = m_Device->createInputLayout(d, attributeCount, vertexShader);
+        if (!inputLayout)
+            return nullptr;
+
+        uint32_t id = registerObject(inputLayout);
+        std::vector<VertexAttributeDesc> attributes(d, d + attributeCount);
+        writeRecord(Op::CreateInputLayout, [&](RecordWriter& w) { w(id, attributes, vertexShader); });
+        return inputLayout;
+    }
+
+    FramebufferHandle DeviceWrapper::createFramebuffer(const FramebufferDesc& desc)
+    {
+        FramebufferHandle framebuffer = m_Device->createFramebuffer(desc);
+        if (!framebuffer)
+            return nullptr;
+
+        uint32_t id = registerObject(framebuffer);
+        writeRecord(Op::CreateFramebuffer, [&](RecordWriter& w) { w(id, desc); });
+        return framebuffer;
+    }
+
+    CommandBundleHandle DeviceWrapper::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        unsupported("createCommandBundle");
+        return m_Device->createCommandBundle(desc);
+    }
+
+    IndirectCommandLayoutHandle DeviceWrapper::createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc)
+    {
+        unsupported("createIndirectCommandLayout");
+        return m_Device->createIndirectCommandLayout(desc);
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        GraphicsPipelineHandle pipeline = m_Device->createGraphicsPipeline(desc, fbinfo);
+        if (!pipeline)
+            return nullptr;
+
+        uint32_t id = registerObject(pipeline);
+        writeRecord(Op::CreateGraphicsPipeline, [&](RecordWriter& w)
+        {
+            w(id, desc, fbinfo);
+        });
+        return pipeline;
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        // Both overloads are replayed with the framebuffer info, which avoids a dependency on the framebuffer object
+        if (!fb)
+            return nullptr;
+
+        return createGraphicsPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        ComputePipelineHandle pipeline = m_Device->createComputePipeline(desc);
+        if (!pipeline)
+            return nullptr;
+
+        uint32_t id = registerObject(pipeline);
+        writeRecord(Op::CreateComputePipeline, [&](RecordWriter& w) { w(id, desc); });
+        return pipeline;
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        MeshletPipelineHandle pipeline = m_Device->createMeshletPipeline(desc, fbinfo);
+        if (!pipeline)
+            return nullptr;
+
+        uint32_t id = registerObject(pipeline);
+        writeRecord(Op::CreateMeshletPipeline, [&](RecordWriter& w)
+        {
+            w(id, desc, fbinfo);
+        });
+        return pipeline;
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+            return nullptr;
+
+        return createMeshletPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    rt::PipelineHandle DeviceWrapper::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        unsupported("createRayTracingPipeline");
+        return m_Device->createRayTracingPipeline(desc);
+    }
+
+    rt::PipelineHandle DeviceWrapper::addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions)
+    {
+        unsupported("addToRayTracingPipeline");
+        return m_Device->addToRayTracingPipeline(pipeline, additions);
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        BindingLayoutHandle layout = m_Device->createBindingLayout(desc);
+        if (!layout)
+            return nullptr;
+
+        uint32_t id = registerObject(layout);
+        writeRecord(Op::CreateBindingLayout, [&](RecordWriter& w) { w(id, desc); });
+        return layout;
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        unsupported("createBindlessLayout");
+        return m_Device->createBindlessLayout(desc);
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+        if (!bindingSet)
+            return nullptr;
+
+        uint32_t id = registerObject(bindingSet);
+        writeRecord(Op::CreateBindingSet, [&](RecordWriter& w) { w(id, desc, layout); });
+        return bindingSet;
+    }
+
+    DescriptorTableHandle DeviceWrapper::createDescriptorTable(IBindingLayout* layout)
+    {
+        unsupported("createDescriptorTable");
+        return m_Device->createDescriptorTable(layout);
+    }
+
+    void DeviceWrapper::resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        unsupported("resizeDescriptorTable");
+        m_Device->resizeDescriptorTable(descriptorTable, newSize, keepContents);
+    }
+
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item)
+    {
+        unsupported("writeDescriptorTable");
+        return m_Device->writeDescriptorTable(descriptorTable, item);
+    }
+
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems)
+    {
+        unsupported("writeDescriptorTable");
+        return m_Device->writeDescriptorTable(descriptorTable, items, numItems);
+    }
+
+    rt::OpacityMicromapHandle DeviceWrapper::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
+    {
+        unsupported("createOpacityMicromap");
+        return m_Device->createOpacityMicromap(desc);
+    }
+
+    rt::AccelStructHandle DeviceWrapper::createAccelStruct(const rt::AccelStructDesc& desc)
+    {
+        unsupported("createAccelStruct");
+        return m_Device->createAccelStruct(desc);
+    }
+
+    CommandListHandle DeviceWrapper::createCommandList(const CommandListParameters& params)
+    {
+        CommandListHandle commandList = m_Device->createCommandList(params);
+        if (!commandList)
+            return nullptr;
+
+        CommandListWrapper* wrapper = new CommandListWrapper(this, commandList, 0);
+        CommandListHandle wrapperHandle = CommandListHandle::Create(wrapper);
+        uint32_t id = registerObject(wrapper);
+        wrapper->m_ObjectId = id;
+
+        writeRecord(Op::CreateCommandList, [&](RecordWriter& w) { w(id, params); });
+        return wrapperHandle;
+    }
+
+    uint64_t DeviceWrapper::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        std::vector<ICommandList*> commandLists(pCommandLists, pCommandLists + numCommandLists);
+        writeRecord(Op::ExecuteCommandLists, [&](RecordWriter& w) { w(executionQueue, commandLists); });
+
+        for (ICommandList*& commandList : commandLists)
+            commandList = unwrapCommandList(commandList);
+
+        return m_Device->executeCommandLists(commandLists.data(), commandLists.size(), executionQueue);
+    }
+
+    void DeviceWrapper::executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances)
+    {
+        // The replay submits the nodes in graph order, which satisfies all dependencies
+        SubmitGraphDesc unwrappedGraph = graph;
+        for (SubmitNode& node : unwrappedGraph.nodes)
+        {
+            writeRecord(Op::ExecuteCommandLists, [&](RecordWriter& w) { w(node.queue, node.commandLists); });
+
+            for (ICommandList*& commandList : node.commandLists)
+                commandList = unwrapCommandList(commandList);
+        }
+
+        m_Device->executeSubmitGraph(unwrappedGraph, pInstances);
+    }
+
+    bool DeviceWrapper::waitForIdle()
+    {
+        writeRecord(Op::WaitForIdle, [](RecordWriter&) { });
+        return m_Device->waitForIdle();
+    }
+
+    void DeviceWrapper::runGarbageCollection()
+    {
+        writeRecord(Op::EndFrame, [](RecordWriter&) { });
+        {
+            std::lock_guard lockGuard(m_FileMutex);
+            m_File.flush();
+        }
+        m_Device->runGarbageCollection();
+    }
+
+    bool DeviceWrapper::runIncrementalGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        writeRecord(Op::EndFrame, [](RecordWriter&) { });
+        {
+            std::lock_guard lockGuard(m_FileMutex);
+            m_File.flush();
+        }
+        return m_Device->runIncrementalGarbageCollection(budget);
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,944 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace nvrhi::capture
+{
+    bool RecordReader::next(Op& outOp, const uint8_t*& outData, uint32_t& outSize)
+    {
+        RecordHeader header;
+        pod(header);
+        if (m_Failed || size_t(m_End - m_Data) < header.size)
+        {
+            m_Failed = true;
+            return false;
+        }
+
+        outOp = header.op;
+        outData = m_Data;
+        outSize = header.size;
+        m_Data += header.size;
+        return true;
+    }
+
+    void RecordReader::string(std::string& value)
+    {
+        uint32_t length = 0;
+        pod(length);
+        if (m_Failed || size_t(m_End - m_Data) < length)
+        {
+            m_Failed = true;
+            return;
+        }
+
+        value.assign(reinterpret_cast<const char*>(m_Data), length);
+        m_Data += length;
+    }
+
+    void RecordReader::blob(const void*& outData, size_t& outSize)
+    {
+        uint64_t length = 0;
+        uint8_t present = 0;
+        pod(length);
+        pod(present);
+        outData = nullptr;
+        outSize = m_Failed ? 0 : size_t(length);
+
+        if (m_Failed || !present)
+            return;
+
+        if (uint64_t(m_End - m_Data) < length)
+        {
+            m_Failed = true;
+            outSize = 0;
+            return;
+        }
+
+        outData = m_Data;
+        m_Data += length;
+    }
+
+    size_t RecordReader::checkCount(uint32_t count)
+    {
+        // Every element takes at least one byte, which limits the allocations made for corrupted counts
+        if (m_Failed || uint64_t(count) > uint64_t(m_End - m_Data))
+        {
+            m_Failed = true;
+            return 0;
+        }
+        return count;
+    }
+
+    void RecordReader::bytes(void* data, size_t size)
+    {
+        if (m_Failed || size_t(m_End - m_Data) < size)
+        {
+            m_Failed = true;
+            memset(data, 0, size);
+            return;
+        }
+
+        memcpy(data, m_Data, size);
+        m_Data += size;
+    }
+
+    class Replayer
+    {
+    public:
+        Replayer(IDevice* device, const ReplayDesc& desc, ReplayStatistics& statistics)
+            : m_Device(device)
+            , m_Desc(desc)
+            , m_Statistics(statistics)
+            , m_Objects(1, nullptr)
+        { }
+
+        bool replay(const std::vector<uint8_t>& trace);
+
+    private:
+        IDevice* m_Device;
+        ReplayDesc m_Desc;
+        ReplayStatistics& m_Statistics;
+
+        // Objects by their capture ID. Transient binding sets are owned by their command lists,
+        // all other objects are also referenced from m_OwnedObjects.
+        std::vector<IResource*> m_Objects;
+        std::vector<RefCountPtr<IResource>> m_OwnedObjects;
+
+        // Stands in for the data of uploads whose contents were not captured
+        std::vector<uint8_t> m_ZeroData;
+
+        // False after a state setup call was skipped, until the next one succeeds
+        bool m_StateValid = true;
+        bool m_Truncated = false;
+
+        void error(const std::string& message) const
+        {
+            m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+        }
+
+        RecordReader reader(const void* data, size_t size)
+        {
+            return RecordReader(static_cast<const uint8_t*>(data), size, m_Objects, m_Statistics.missingObjects);
+        }
+
+        void setObject(uint32_t id, IResource* object);
+        void setOwnedObject(uint32_t id, IResource* object);
+        const void* uploadData(const void* data, size_t size);
+
+        bool replayDeviceRecord(Op op, RecordReader& args);
+        bool replayCommandListRecord(ICommandList* commandList, Op op, RecordReader& args);
+        bool replayCommandList(ICommandList* commandList, const void* records, size_t size);
+    };
+
+    void Replayer::setObject(uint32_t id, IResource* object)
+    {
+        // IDs are allocated sequentially by the capture layer, so this only grows by one entry at a time
+        if (id == 0 || id > m_Objects.size() + (1u << 20))
+            return;
+
+        if (id >= m_Objects.size())
+            m_Objects.resize(id + 1, nullptr);
+        m_Objects[id] = object;
+    }
+
+    void Replayer::setOwnedObject(uint32_t id, IResource* object)
+    {
+        if (object)
+            m_OwnedObjects.push_back(object);
+        setObject(id, object);
+    }
+
+    const void* Replayer::uploadData(const void* data, size_t size)
+    {
+        if (data)
+            return data;
+
+        if (m_ZeroData.size() < size)
+            m_ZeroData.resize(size, 0);
+        return m_ZeroData.data();
+    }
+
+    bool Replayer::replayDeviceRecord(Op op, RecordReader& args)
+    {
+        const uint64_t missingObjects = m_Statistics.missingObjects;
+        auto valid = [&]() { return !args.failed() && m_Statistics.missingObjects == missingObjects; };
+
+        switch (op)
+        {
+        case Op::CreateTexture: {
+            uint32_t id = args.objectId();
+            TextureDesc desc;
+            args(desc);
+            // Native, shared, virtual and tiled textures are replayed as regular committed textures
+            desc.isVirtual = false;
+            desc.isTiled = false;
+            desc.sharedResourceFlags = SharedResourceFlags::None;
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createTexture(desc));
+            break;
+        }
+
+        case Op::CreateStagingTexture: {
+            uint32_t id = args.objectId();
+            TextureDesc desc;
+            CpuAccessMode cpuAccess = CpuAccessMode::None;
+            args(desc, cpuAccess);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createStagingTexture(desc, cpuAccess));
+            break;
+        }
+
+        case Op::CreateBuffer: {
+            uint32_t id = args.objectId();
+            BufferDesc desc;
+            args(desc);
+            desc.isVirtual = false;
+            desc.sharedResourceFlags = SharedResourceFlags::None;
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createBuffer(desc));
+            break;
+        }
+
+        case Op::WriteMappedBuffer: {
+            IBuffer* buffer = nullptr;
+            uint64_t offset = 0;
+            const void* data = nullptr;
+            size_t size = 0;
+            args(buffer, offset);
+            args.blob(data, size);
+            if (!valid() || !data) return false;
+
+            void* mapped = m_Device->mapBuffer(buffer, CpuAccessMode::Write, offset, size);
+            if (!mapped) return false;
+            memcpy(mapped, data, size);
+            m_Device->flushMappedRange(buffer, offset, size);
+            m_Device->unmapBuffer(buffer);
+            break;
+        }
+
+        case Op::CreateShader: {
+            uint32_t id = args.objectId();
+            ShaderDesc desc;
+            const void* binary = nullptr;
+            size_t binarySize = 0;
+            args(desc);
+            args.blob(binary, binarySize);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createShader(desc, binary, binarySize));
+            break;
+        }
+
+        case Op::CreateSampler: {
+            uint32_t id = args.objectId();
+            SamplerDesc desc;
+            args(desc);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createSampler(desc));
+            break;
+        }
+
+        case Op::CreateInputLayout: {
+            uint32_t id = args.objectId();
+            std::vector<VertexAttributeDesc> attributes;
+            IShader* vertexShader = nullptr;
+            args(attributes, vertexShader);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createInputLayout(attributes.data(), uint32_t(attributes.size()), vertexShader));
+            break;
+        }
+
+        case Op::CreateBindingLayout: {
+            uint32_t id = args.objectId();
+            BindingLayoutDesc desc;
+            args(desc);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createBindingLayout(desc));
+            break;
+        }
+
+        case Op::CreateBindingSet: {
+            uint32_t id = args.objectId();
+            BindingSetDesc desc;
+            IBindingLayout* layout = nullptr;
+            args(desc, layout);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createBindingSet(desc, layout));
+            break;
+        }
+
+        case Op::CreateFramebuffer: {
+            uint32_t id = args.objectId();
+            FramebufferDesc desc;
+            args(desc);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createFramebuffer(desc));
+            break;
+        }
+
+        case Op::CreateGraphicsPipeline: {
+            uint32_t id = args.objectId();
+            GraphicsPipelineDesc desc;
+            FramebufferInfo fbinfo;
+            args(desc, fbinfo);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createGraphicsPipeline(desc, fbinfo));
+            break;
+        }
+
+        case Op::CreateComputePipeline: {
+            uint32_t id = args.objectId();
+            ComputePipelineDesc desc;
+            args(desc);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createComputePipeline(desc));
+            break;
+        }
+
+        case Op::CreateMeshletPipeline: {
+            uint32_t id = args.objectId();
+            MeshletPipelineDesc desc;
+            FramebufferInfo fbinfo;
+            args(desc, fbinfo);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createMeshletPipeline(desc, fbinfo));
+            break;
+        }
+
+        case Op::CreateCommandList: {
+            uint32_t id = args.objectId();
+            CommandListParameters params;
+            args(params);
+            if (!valid()) return false;
+            setOwnedObject(id, m_Device->createCommandList(params));
+            break;
+        }
+
+        case Op::CommandList: {
+            ICommandList* commandList = nullptr;
+            const void* records = nullptr;
+            size_t size = 0;
+            args(commandList);
+            args.blob(records, size);
+            if (!valid() || !records) return false;
+            return replayCommandList(commandList, records, size);
+        }
+
+        case Op::ExecuteCommandLists: {
+            CommandQueue queue = CommandQueue::Graphics;
+            std::vector<ICommandList*> commandLists;
+            args(queue, commandLists);
+            if (args.failed()) return false;
+
+            // Submit the command lists that exist, so that a missing one doesn't stall the whole frame
+            commandLists.erase(std::remove(commandLists.begin(), commandLists.end(), nullptr), commandLists.end());
+            if (commandLists.empty()) return false;
+
+            m_Device->executeCommandLists(commandLists.data(), commandLists.size(), queue);
+            m_Statistics.executedCommandLists += commandLists.size();
+            break;
+        }
+
+        case Op::WaitForIdle:
+            m_Device->waitForIdle();
+            break;
+
+        default:
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Replayer::replayCommandList(ICommandList* commandList, const void* records, size_t size)
+    {
+        RecordReader commandReader = reader(records, size);
+        m_StateValid = true;
+
+        while (!commandReader.atEnd())
+        {
+            Op op;
+            const uint8_t* data = nullptr;
+            uint32_t dataSize = 0;
+            if (!commandReader.next(op, data, dataSize))
+            {
+                error("Capture replay: a command list record is truncated");
+                m_Truncated = true;
+                return false;
+            }
+
+            RecordReader args = reader(data, dataSize);
+            if (replayCommandListRecord(commandList, op, args))
+                ++m_Statistics.replayedCalls;
+            else
+                ++m_Statistics.skippedCalls;
+        }
+
+        return true;
+    }
+
+    bool Replayer::replayCommandListRecord(ICommandList* cl, Op op, RecordReader& args)
+    {
+        const uint64_t missingObjects = m_Statistics.missingObjects;
+        auto valid = [&]() { return !args.failed() && m_Statistics.missingObjects == missingObjects; };
+
+        // Records that set up the pipeline state also decide whether the following draws or dispatches can run
+        auto setState = [&]() { m_StateValid = valid(); return m_StateValid; };
+
+        switch (op)
+        {
+        case Op::Open:
+            cl->open();
+            break;
+
+        case Op::Close:
+            cl->close();
+            break;
+
+        case Op::ClearState:
+            cl->clearState();
+            break;
+
+        case Op::ClearTextureFloat: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            Color color;
+            args(texture, subresources, color);
+            if (!valid()) return false;
+            cl->clearTextureFloat(texture, subresources, color);
+            break;
+        }
+
+        case Op::ClearDepthStencilTexture: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            bool clearDepth = false;
+            float depth = 0.f;
+            bool clearStencil = false;
+            uint8_t stencil = 0;
+            args(texture, subresources, clearDepth, depth, clearStencil, stencil);
+            if (!valid()) return false;
+            cl->clearDepthStencilTexture(texture, subresources, clearDepth, depth, clearStencil, stencil);
+            break;
+        }
+
+        case Op::ClearTextureUInt: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            uint32_t color = 0;
+            args(texture, subresources, color);
+            if (!valid()) return false;
+            cl->clearTextureUInt(texture, subresources, color);
+            break;
+        }
+
+        case Op::CopyTexture: {
+            ITexture* dest = nullptr;
+            ITexture* src = nullptr;
+            TextureSlice destSlice, srcSlice;
+            args(dest, destSlice, src, srcSlice);
+            if (!valid()) return false;
+            cl->copyTexture(dest, destSlice, src, srcSlice);
+            break;
+        }
+
+        case Op::CopyTextureToStaging: {
+            IStagingTexture* dest = nullptr;
+            ITexture* src = nullptr;
+            TextureSlice destSlice, srcSlice;
+            args(dest, destSlice, src, srcSlice);
+            if (!valid()) return false;
+            cl->copyTexture(dest, destSlice, src, srcSlice);
+            break;
+        }
+
+        case Op::CopyTextureFromStaging: {
+            ITexture* dest = nullptr;
+            IStagingTexture* src = nullptr;
+            TextureSlice destSlice, srcSlice;
+            args(dest, destSlice, src, srcSlice);
+            if (!valid()) return false;
+            cl->copyTexture(dest, destSlice, src, srcSlice);
+            break;
+        }
+
+        case Op::WriteTexture: {
+            ITexture* dest = nullptr;
+            uint32_t arraySlice = 0, mipLevel = 0;
+            size_t rowPitch = 0, depthPitch = 0;
+            const void* data = nullptr;
+            size_t dataSize = 0;
+            args(dest, arraySlice, mipLevel, rowPitch, depthPitch);
+            args.blob(data, dataSize);
+            if (!valid()) return false;
+            cl->writeTexture(dest, arraySlice, mipLevel, uploadData(data, dataSize), rowPitch, depthPitch);
+            break;
+        }
+
+        case Op::WriteTextureRegions: {
+            ITexture* dest = nullptr;
+            uint32_t count = 0;
+            args(dest, count);
+
+            std::vector<TextureUploadRegion> regions(args.checkCount(count));
+            std::vector<size_t> dataSizes(regions.size());
+            for (size_t i = 0; i < regions.size(); i++)
+            {
+                TextureUploadRegion& region = regions[i];
+                args(region.slice, region.rowPitch, region.depthPitch);
+                args.blob(region.data, dataSizes[i]);
+            }
+            if (!valid()) return false;
+
+            // The scratch data is resized only once, so that the region pointers stay valid
+            size_t maxDataSize = 0;
+            for (size_t dataSize : dataSizes)
+                maxDataSize = std::max(maxDataSize, dataSize);
+            for (TextureUploadRegion& region : regions)
+                region.data = uploadData(region.data, maxDataSize);
+
+            cl->writeTextureRegions(dest, regions.data(), regions.size());
+            break;
+        }
+
+        case Op::ResolveTexture: {
+            ITexture* dest = nullptr;
+            ITexture* src = nullptr;
+            TextureSubresourceSet destSubresources, srcSubresources;
+            args(dest, destSubresources, src, srcSubresources);
+            if (!valid()) return false;
+            cl->resolveTexture(dest, destSubresources, src, srcSubresources);
+            break;
+        }
+
+        case Op::WriteBuffer: {
+            IBuffer* buffer = nullptr;
+            uint64_t offset = 0;
+            const void* data = nullptr;
+            size_t dataSize = 0;
+            args(buffer, offset);
+            args.blob(data, dataSize);
+            if (!valid()) return false;
+            cl->writeBuffer(buffer, uploadData(data, dataSize), dataSize, offset);
+            break;
+        }
+
+        case Op::ClearBufferUInt: {
+            IBuffer* buffer = nullptr;
+            uint32_t value = 0;
+            args(buffer, value);
+            if (!valid()) return false;
+            cl->clearBufferUInt(buffer, value);
+            break;
+        }
+
+        case Op::CopyBuffer: {
+            IBuffer* dest = nullptr;
+            IBuffer* src = nullptr;
+            uint64_t destOffset = 0, srcOffset = 0, size = 0;
+            args(dest, destOffset, src, srcOffset, size);
+            if (!valid()) return false;
+            cl->copyBuffer(dest, destOffset, src, srcOffset, size);
+            break;
+        }
+
+        case Op::SetPushConstants: {
+            const void* data = nullptr;
+            size_t size = 0;
+            args.blob(data, size);
+            if (!valid()) return false;
+            cl->setPushConstants(uploadData(data, size), size);
+            break;
+        }
+
+        case Op::CreateTransientBindingSet: {
+            uint32_t id = args.objectId();
+            BindingSetDesc desc;
+            IBindingLayout* layout = nullptr;
+            args(desc, layout);
+            if (!valid()) return false;
+            setObject(id, cl->createTransientBindingSet(desc, layout));
+            break;
+        }
+
+        case Op::SetGraphicsState: {
+            GraphicsState state;
+            args(state);
+            if (!setState()) return false;
+            cl->setGraphicsState(state);
+            break;
+        }
+
+        case Op::SetGraphicsBindingSet: {
+            uint32_t slot = 0;
+            IBindingSet* bindingSet = nullptr;
+            args(slot, bindingSet);
+            if (!setState()) return false;
+            cl->setGraphicsBindingSet(slot, bindingSet);
+            break;
+        }
+
+        case Op::SetVertexBuffers: {
+            std::vector<VertexBufferBinding> bindings;
+            args(bindings);
+            if (!setState()) return false;
+            cl->setVertexBuffers(bindings.data(), bindings.size());
+            break;
+        }
+
+        case Op::SetIndexBuffer: {
+            IndexBufferBinding binding;
+            args(binding);
+            if (!setState()) return false;
+            cl->setIndexBuffer(binding);
+            break;
+        }
+
+        case Op::BeginRenderPassScope: {
+            RenderPassScope scope;
+            args(scope);
+            if (args.failed()) return false;
+            // Missing objects only make the scope less complete, which is still valid
+            scope.bindingSets.erase(std::remove(scope.bindingSets.begin(), scope.bindingSets.end(), nullptr), scope.bindingSets.end());
+            scope.vertexBuffers.erase(std::remove(scope.vertexBuffers.begin(), scope.vertexBuffers.end(), nullptr), scope.vertexBuffers.end());
+            scope.indexBuffers.erase(std::remove(scope.indexBuffers.begin(), scope.indexBuffers.end(), nullptr), scope.indexBuffers.end());
+            scope.indirectBuffers.erase(std::remove(scope.indirectBuffers.begin(), scope.indirectBuffers.end(), nullptr), scope.indirectBuffers.end());
+            cl->beginRenderPassScope(scope);
+            break;
+        }
+
+        case Op::EndRenderPassScope:
+            cl->endRenderPassScope();
+            break;
+
+        case Op::Draw:
+        case Op::DrawIndexed: {
+            DrawArguments drawArgs;
+            args(drawArgs);
+            if (!valid() || !m_StateValid) return false;
+            if (op == Op::Draw)
+                cl->draw(drawArgs);
+            else
+                cl->drawIndexed(drawArgs);
+            break;
+        }
+
+        case Op::DrawMulti:
+        case Op::DrawIndexedMulti: {
+            std::vector<DrawArguments> drawArgs;
+            args(drawArgs);
+            if (!valid() || !m_StateValid) return false;
+            if (op == Op::DrawMulti)
+                cl->drawMulti(drawArgs.data(), drawArgs.size());
+            else
+                cl->drawIndexedMulti(drawArgs.data(), drawArgs.size());
+            break;
+        }
+
+        case Op::DrawIndirect:
+        case Op::DrawIndexedIndirect: {
+            uint32_t offset = 0, count = 0;
+            args(offset, count);
+            if (!valid() || !m_StateValid) return false;
+            if (op == Op::DrawIndirect)
+                cl->drawIndirect(offset, count);
+            else
+                cl->drawIndexedIndirect(offset, count);
+            break;
+        }
+
+        case Op::DrawIndexedIndirectCount: {
+            uint32_t paramOffset = 0, countOffset = 0, maxCount = 0;
+            args(paramOffset, countOffset, maxCount);
+            if (!valid() || !m_StateValid) return false;
+            cl->drawIndexedIndirectCount(paramOffset, countOffset, maxCount);
+            break;
+        }
+
+        case Op::SetComputeState: {
+            ComputeState state;
+            args(state);
+            if (!setState()) return false;
+            cl->setComputeState(state);
+            break;
+        }
+
+        case Op::Dispatch:
+        case Op::DispatchMesh: {
+            uint32_t x = 0, y = 0, z = 0;
+            args(x, y, z);
+            if (!valid() || !m_StateValid) return false;
+            if (op == Op::Dispatch)
+                cl->dispatch(x, y, z);
+            else
+                cl->dispatchMesh(x, y, z);
+            break;
+        }
+
+        case Op::DispatchMeshIndirect: {
+            uint32_t offset = 0, count = 0;
+            args(offset, count);
+            if (!valid() || !m_StateValid) return false;
+            cl->dispatchMeshIndirect(offset, count);
+            break;
+        }
+
+        case Op::DispatchMeshIndirectCount: {
+            uint32_t paramOffset = 0, countOffset = 0, maxCount = 0;
+            args(paramOffset, countOffset, maxCount);
+            if (!valid() || !m_StateValid) return false;
+            cl->dispatchMeshIndirectCount(paramOffset, countOffset, maxCount);
+            break;
+        }
+
+        case Op::DispatchIndirect: {
+            uint32_t offset = 0;
+            args(offset);
+            if (!valid() || !m_StateValid) return false;
+            cl->dispatchIndirect(offset);
+            break;
+        }
+
+        case Op::SetMeshletState: {
+            MeshletState state;
+            args(state);
+            if (!setState()) return false;
+            cl->setMeshletState(state);
+            break;
+        }
+
+        case Op::BeginMarker: {
+            std::string name;
+            args(name);
+            if (!valid()) return false;
+            cl->beginMarker(name.c_str());
+            break;
+        }
+
+        case Op::EndMarker:
+            cl->endMarker();
+            break;
+
+        case Op::SetEnableAutomaticBarriers: {
+            bool enable = true;
+            args(enable);
+            if (!valid()) return false;
+            cl->setEnableAutomaticBarriers(enable);
+            break;
+        }
+
+        case Op::SetResourceStatesForBindingSet: {
+            IBindingSet* bindingSet = nullptr;
+            args(bindingSet);
+            if (!valid()) return false;
+            cl->setResourceStatesForBindingSet(bindingSet);
+            break;
+        }
+
+        case Op::SetEnableUavBarriersForTexture: {
+            ITexture* texture = nullptr;
+            bool enable = true;
+            args(texture, enable);
+            if (!valid()) return false;
+            cl->setEnableUavBarriersForTexture(texture, enable);
+            break;
+        }
+
+        case Op::SetEnableUavBarriersForBuffer: {
+            IBuffer* buffer = nullptr;
+            bool enable = true;
+            args(buffer, enable);
+            if (!valid()) return false;
+            cl->setEnableUavBarriersForBuffer(buffer, enable);
+            break;
+        }
+
+        case Op::BeginTrackingTextureState:
+        case Op::SetTextureState: {
+            ITexture* texture = nullptr;
+            TextureSubresourceSet subresources;
+            ResourceStates states = ResourceStates::Unknown;
+            args(texture, subresources, states);
+            if (!valid()) return false;
+            if (op == Op::BeginTrackingTextureState)
+                cl->beginTrackingTextureState(texture, subresources, states);
+            else
+                cl->setTextureState(texture, subresources, states);
+            break;
+        }
+
+        case Op::BeginTrackingBufferState:
+        case Op::SetBufferState: {
+            IBuffer* buffer = nullptr;
+            ResourceStates states = ResourceStates::Unknown;
+            args(buffer, states);
+            if (!valid()) return false;
+            if (op == Op::BeginTrackingBufferState)
+                cl->beginTrackingBufferState(buffer, states);
+            else
+                cl->setBufferState(buffer, states);
+            break;
+        }
+
+        case Op::SetPermanentTextureState: {
+            ITexture* texture = nullptr;
+            ResourceStates states = ResourceStates::Unknown;
+            args(texture, states);
+            if (!valid()) return false;
+            cl->setPermanentTextureState(texture, states);
+            break;
+        }
+
+        case Op::SetPermanentBufferState: {
+            IBuffer* buffer = nullptr;
+            ResourceStates states = ResourceStates::Unknown;
+            args(buffer, states);
+            if (!valid()) return false;
+            cl->setPermanentBufferState(buffer, states);
+            break;
+        }
+
+        case Op::CommitBarriers:
+            cl->commitBarriers();
+            break;
+
+        default:
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Replayer::replay(const std::vector<uint8_t>& trace)
+    {
+        typedef std::chrono::steady_clock clock;
+        auto milliseconds = [](clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+        const clock::time_point replayStart = clock::now();
+        clock::time_point frameStart = replayStart;
+
+        RecordReader records = reader(trace.data() + sizeof(FileHeader), trace.size() - sizeof(FileHeader));
+        bool result = true;
+
+        while (!records.atEnd())
+        {
+            Op op;
+            const uint8_t* data = nullptr;
+            uint32_t size = 0;
+            if (!records.next(op, data, size))
+            {
+                error("Capture replay: the trace file is truncated");
+                result = false;
+                break;
+            }
+
+            if (op == Op::EndFrame)
+            {
+                if (m_Desc.waitForIdleEveryFrame)
+                    m_Device->waitForIdle();
+                m_Device->runGarbageCollection();
+
+                const clock::time_point now = clock::now();
+                m_Statistics.frameMilliseconds.push_back(milliseconds(now - frameStart));
+                frameStart = now;
+                continue;
+            }
+
+            if (op == Op::Unsupported)
+            {
+                ++m_Statistics.skippedCalls;
+                continue;
+            }
+
+            RecordReader args = reader(data, size);
+            const bool replayed = replayDeviceRecord(op, args);
+
+            // The command list records count their calls individually
+            if (op != Op::CommandList)
+            {
+                if (replayed)
+                    ++m_Statistics.replayedCalls;
+                else
+                    ++m_Statistics.skippedCalls;
+            }
+            else if (m_Truncated || args.failed())
+            {
+                error("Capture replay: the trace file is truncated");
+                result = false;
+                break;
+            }
+        }
+
+        m_Device->waitForIdle();
+        m_Statistics.totalMilliseconds = milliseconds(clock::now() - replayStart);
+        return result;
+    }
+
+    bool replayCapture(IDevice* device, const char* fileName, const ReplayDesc& desc, ReplayStatistics* outStatistics)
+    {
+        ReplayStatistics statistics;
+        if (!outStatistics)
+            outStatistics = &statistics;
+        *outStatistics = ReplayStatistics();
+
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            std::stringstream ss;
+            ss << "Capture replay: cannot open the trace file " << fileName;
+            device->getMessageCallback()->message(MessageSeverity::Error, ss.str().c_str());
+            return false;
+        }
+
+        // The trace is read into memory at once, the replay resolves all arguments right from that copy
+        std::vector<uint8_t> trace(size_t(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(trace.data()), std::streamsize(trace.size()));
+
+        FileHeader header;
+        if (!file || trace.size() < sizeof(header))
+        {
+            std::stringstream ss;
+            ss << "Capture replay: cannot read the trace file " << fileName;
+            device->getMessageCallback()->message(MessageSeverity::Error, ss.str().c_str());
+            return false;
+        }
+
+        memcpy(&header, trace.data(), sizeof(header));
+        if (header.magic != c_FileMagic || header.headerVersion != c_HeaderVersion)
+        {
+            std::stringstream ss;
+            ss << "Capture replay: " << fileName << " is not a trace file of this NVRHI version (file version "
+                << header.headerVersion << ", expected " << c_HeaderVersion << ")";
+            device->getMessageCallback()->message(MessageSeverity::Error, ss.str().c_str());
+            return false;
+        }
+
+        Replayer replayer(device, desc, *outStatistics);
+        return replayer.replay(trace);
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,130 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "accel-struct-storage.h"
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <iterator>
+
+namespace nvrhi
+{
+    bool AccelStructStoragePool::allocateFromChunk(Chunk& chunk, uint64_t size, uint64_t& outOffset)
+    {
+        // First fit, the sizes are already aligned so every free range starts at an aligned offset
+        for (auto it = chunk.freeRanges.begin(); it != chunk.freeRanges.end(); ++it)
+        {
+            if (it->second < size)
+                continue;
+
+            outOffset = it->first;
+            const uint64_t remaining = it->second - size;
+            chunk.freeRanges.erase(it);
+
+            if (remaining > 0)
+                chunk.freeRanges[outOffset + size] = remaining;
+
+            chunk.allocatedBytes += size;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool AccelStructStoragePool::allocate(uint64_t size, BufferHandle& outBuffer, uint64_t& outOffset)
+    {
+        size = align(size, m_Alignment);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (Chunk& chunk : m_Chunks)
+        {
+            if (allocateFromChunk(chunk, size, outOffset))
+            {
+                outBuffer = chunk.buffer;
+                return true;
+            }
+        }
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = std::max(m_ChunkSize, size);
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.isAccelStructStorage = true;
+        bufferDesc.initialState = ResourceStates::AccelStructBuildBlas;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.debugName = "Compacted BLAS storage";
+
+        Chunk chunk;
+        chunk.buffer = m_Device->createBuffer(bufferDesc);
+        if (!chunk.buffer)
+            return false;
+
+        chunk.freeRanges[0] = bufferDesc.byteSize;
+        allocateFromChunk(chunk, size, outOffset);
+        outBuffer = chunk.buffer;
+
+        m_Chunks.push_back(std::move(chunk));
+        return true;
+    }
+
+    void AccelStructStoragePool::release(IBuffer* buffer, uint64_t offset, uint64_t size)
+    {
+        size = align(size, m_Alignment);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto chunkIt = std::find_if(m_Chunks.begin(), m_Chunks.end(),
+            [buffer](const Chunk& chunk) { return chunk.buffer == buffer; });
+
+        if (chunkIt == m_Chunks.end())
+            return;
+
+        Chunk& chunk = *chunkIt;
+        chunk.allocatedBytes -= size;
+
+        // Insert the range and merge it with its neighbors
+        auto next = chunk.freeRanges.lower_bound(offset);
+        if (next != chunk.freeRanges.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = chunk.freeRanges.erase(next);
+        }
+
+        if (next != chunk.freeRanges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                prev->second += size;
+                size = 0;
+            }
+        }
+
+        if (size > 0)
+            chunk.freeRanges[offset] = size;
+
+        // Keep one empty chunk around to avoid recreating it for the next compaction
+        if (chunk.allocatedBytes == 0 && m_Chunks.size() > 1)
+            m_Chunks.erase(chunkIt);
+    }
+
+} // namespace nvrhi
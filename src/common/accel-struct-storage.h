@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // Suballocates storage for compacted acceleration structures out of large shared buffers,
+    // so that compacted BLASes don't need a resource each. Owned by the device.
+    class AccelStructStoragePool
+    {
+    public:
+        AccelStructStoragePool(IDevice* device, uint64_t chunkSize, uint64_t alignment)
+            : m_Device(device)
+            , m_ChunkSize(chunkSize)
+            , m_Alignment(alignment)
+        { }
+
+        // Returns false if a new chunk is needed and cannot be created
+        bool allocate(uint64_t size, BufferHandle& outBuffer, uint64_t& outOffset);
+
+        // Returns a range to the pool. The caller makes sure that the GPU no longer uses it.
+        void release(IBuffer* buffer, uint64_t offset, uint64_t size);
+
+    private:
+        struct Chunk
+        {
+            BufferHandle buffer;
+            std::map<uint64_t, uint64_t> freeRanges; // offset -> size, adjacent ranges are merged
+            uint64_t allocatedBytes = 0;
+        };
+
+        IDevice* m_Device; // not a handle to avoid a reference cycle with the device
+        uint64_t m_ChunkSize;
+        uint64_t m_Alignment;
+        std::vector<Chunk> m_Chunks;
+        std::mutex m_Mutex;
+
+        static bool allocateFromChunk(Chunk& chunk, uint64_t size, uint64_t& outOffset);
+    };
+
+} // namespace nvrhi
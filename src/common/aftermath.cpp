@@ -21,6 +21,7 @@
 */
 
 #include <nvrhi/common/aftermath.h>
+#include <algorithm>
 
 namespace nvrhi
 {
@@ -32,8 +33,75 @@ namespace nvrhi
     {
     }
 
+    uint32_t AftermathMarkerNameRegistry::intern(std::string_view name, size_t nameHash)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto found = m_IdsByHash.find(nameHash);
+        if (found != m_IdsByHash.end())
+            return found->second;
+
+        const uint32_t id = uint32_t(m_Names.size());
+        m_Names.emplace_back(name);
+        m_IdsByHash[nameHash] = id;
+        return id;
+    }
+
+    bool AftermathMarkerNameRegistry::getName(uint32_t id, std::string& outName) const
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (id >= m_Names.size())
+            return false;
+
+        outName = m_Names[id];
+        return true;
+    }
+
+    void AftermathMarkerTracker::setNameRegistry(AftermathMarkerNameRegistry* registry)
+    {
+        m_NameRegistry = registry;
+    }
+
+    size_t AftermathMarkerTracker::pushCompactEvent(const char* name)
+    {
+        const std::string_view nameView(name);
+        const size_t nameHash = std::hash<std::string_view>{}(nameView);
+
+        CachedName& cachedName = m_NameCache[nameHash % NameCacheSize];
+        if (!cachedName.valid || cachedName.nameHash != nameHash)
+        {
+            cachedName.nameId = m_NameRegistry->intern(nameView, nameHash);
+            cachedName.nameHash = nameHash;
+            cachedName.valid = true;
+        }
+
+        const size_t parentPayload = m_StackDepth ? m_PayloadStack[std::min(m_StackDepth, MaxCompactStackDepth) - 1] : 0;
+
+        // Markers nested deeper than the stack can hold report the payload of the deepest tracked marker
+        if (m_StackDepth++ >= MaxCompactStackDepth)
+            return parentPayload;
+
+        size_t payload = parentPayload;
+        hash_combine(payload, cachedName.nameId);
+        m_PayloadStack[m_StackDepth - 1] = payload;
+
+        CompactRecord& record = m_CompactRecords[payload % MaxCompactRecords];
+        if (record.payload != payload)
+        {
+            record.payload = payload;
+            record.parentPayload = parentPayload;
+            record.nameId = cachedName.nameId;
+        }
+
+        return payload;
+    }
+
     size_t AftermathMarkerTracker::pushEvent(const char* name)
     {
+        if (m_NameRegistry)
+            return pushCompactEvent(name);
+
         m_EventStack.append(name);
         std::string eventString = m_EventStack.generic_string();
         size_t hash = std::hash<std::string>{}(eventString);
@@ -49,6 +117,13 @@ namespace nvrhi
 
     void AftermathMarkerTracker::popEvent()
     {
+        if (m_NameRegistry)
+        {
+            if (m_StackDepth > 0)
+                --m_StackDepth;
+            return;
+        }
+
         m_EventStack = m_EventStack.parent_path();
     }
 
@@ -56,6 +131,45 @@ namespace nvrhi
 
     std::pair<bool, std::reference_wrapper<const std::string>> AftermathMarkerTracker::getEventString(size_t hash)
     {
+        if (m_NameRegistry)
+        {
+            // Walk the parent links to rebuild the path, parents that were overwritten in the table are shown as "?"
+            constexpr uint32_t unknownNameId = UINT32_MAX;
+            std::vector<uint32_t> nameIds;
+            size_t payload = hash;
+            while (payload != 0 && nameIds.size() < MaxCompactStackDepth)
+            {
+                const CompactRecord& record = m_CompactRecords[payload % MaxCompactRecords];
+                if (record.payload != payload)
+                {
+                    // Either the marker does not come from this tracker, or one of its parents was overwritten
+                    if (nameIds.empty())
+                        return ResolvedMarker(false, NotFoundMarkerString);
+
+                    nameIds.push_back(unknownNameId);
+                    break;
+                }
+
+                nameIds.push_back(record.nameId);
+                payload = record.parentPayload;
+            }
+
+            if (nameIds.empty())
+                return ResolvedMarker(false, NotFoundMarkerString);
+
+            std::filesystem::path eventStack;
+            std::string name;
+            for (auto it = nameIds.rbegin(); it != nameIds.rend(); ++it)
+            {
+                if (*it == unknownNameId || !m_NameRegistry->getName(*it, name))
+                    name = "?";
+                eventStack.append(name);
+            }
+
+            m_ResolvedString = eventStack.generic_string();
+            return std::make_pair<bool, std::reference_wrapper<const std::string>>(true, m_ResolvedString);
+        }
+
         auto const& found = m_EventStrings.find(hash);
         if (found != m_EventStrings.end())
         {
@@ -64,7 +178,7 @@ namespace nvrhi
         else
         {
             // could technically return a string literal according to the spec, but compiler complains, so using static
-            return std::make_pair(false, NotFoundMarkerString);
+            return ResolvedMarker(false, NotFoundMarkerString);
         }
     }
 
@@ -76,6 +190,8 @@ namespace nvrhi
 
     void AftermathCrashDumpHelper::registerAftermathMarkerTracker(AftermathMarkerTracker* tracker)
     {
+        if (m_CompactMarkers)
+            tracker->setNameRegistry(&m_MarkerNames);
         m_MarkerTrackers.insert(tracker);
     }
 
@@ -105,19 +221,20 @@ namespace nvrhi
 
     ResolvedMarker AftermathCrashDumpHelper::ResolveMarker(size_t markerHash)
     {
+        // The resolved strings are owned by the trackers, so the trackers must not be copied here
         for (auto markerTracker : m_MarkerTrackers)
         {
-            auto [found, markerString] = markerTracker->getEventString(markerHash);
-            if (found)
-                return std::make_pair(found, markerString);
+            ResolvedMarker resolved = markerTracker->getEventString(markerHash);
+            if (resolved.first)
+                return resolved;
         }
-        for (auto markerTracker : m_DestroyedMarkerTrackers)
+        for (auto& markerTracker : m_DestroyedMarkerTrackers)
         {
-            auto [found, markerString] = markerTracker.getEventString(markerHash);
-            if (found)
-                return std::make_pair(found, markerString);
+            ResolvedMarker resolved = markerTracker.getEventString(markerHash);
+            if (resolved.first)
+                return resolved;
         }
-        return std::make_pair(false, NotFoundMarkerString);
+        return ResolvedMarker(false, NotFoundMarkerString);
     }
 
     BinaryBlob AftermathCrashDumpHelper::findShaderBinary(uint64_t shaderHash, ShaderHashGeneratorFunction hashGenerator)
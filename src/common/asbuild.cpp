@@ -0,0 +1,336 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/asbuild.h>
+#include <nvrhi/utils.h>
+
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+namespace nvrhi::asbuild
+{
+    class BlasBuildQueue : public RefCounter<IBlasBuildQueue>
+    {
+    public:
+        BlasBuildQueue(IDevice* device, const BlasBuildQueueDesc& desc, CommandQueue queue);
+
+        BuildToken build(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+            rt::AccelStructBuildFlags buildFlags) override;
+        BuildToken refit(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+            rt::AccelStructBuildFlags buildFlags) override;
+        BuildToken submitPendingBuilds() override;
+        bool isBuildComplete(BuildToken token) override;
+        bool queueWaitForBuilds(CommandQueue waitQueue, BuildToken token) override;
+        size_t getPendingBuildCount() override;
+
+    private:
+        struct Request
+        {
+            BuildToken token = c_InvalidBuildToken;
+            rt::AccelStructHandle accelStruct;
+            std::vector<rt::GeometryDesc> geometries;
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None;
+        };
+
+        struct Submission
+        {
+            BuildToken lastToken = c_InvalidBuildToken;
+            uint64_t instance = 0;
+            EventQueryHandle query;
+
+            // The geometry buffers of the builds, the BLASes are kept alive by the command list
+            std::vector<BufferHandle> geometryBuffers;
+        };
+
+        DeviceHandle m_Device;
+        BlasBuildQueueDesc m_Desc;
+        CommandQueue m_Queue;
+
+        // Guards the pending requests, which can be added from any thread
+        std::mutex m_RequestMutex;
+        std::deque<Request> m_PendingRequests;
+        BuildToken m_LastIssuedToken = c_InvalidBuildToken;
+
+        // Guards the command list and the submissions
+        std::mutex m_SubmitMutex;
+        CommandListHandle m_CommandList;
+        std::deque<Submission> m_Submissions;
+        std::vector<EventQueryHandle> m_FreeQueries;
+        BuildToken m_LastSubmittedToken = c_InvalidBuildToken;
+        BuildToken m_LastCompletedToken = c_InvalidBuildToken;
+
+        void error(const std::string& message) const;
+        BuildToken enqueue(const char* function, rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries,
+            size_t numGeometries, rt::AccelStructBuildFlags buildFlags);
+        void recordBuilds(const std::vector<Request>& requests, std::vector<BufferHandle>& geometryBuffers);
+        void retireSubmissions();
+    };
+
+    BlasBuildQueue::BlasBuildQueue(IDevice* device, const BlasBuildQueueDesc& desc, CommandQueue queue)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_Queue(queue)
+    {
+    }
+
+    void BlasBuildQueue::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    BuildToken BlasBuildQueue::enqueue(const char* function, rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries,
+        size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!as || !pGeometries || numGeometries == 0)
+        {
+            std::stringstream ss;
+            ss << "BlasBuildQueue::" << function << ": as and pGeometries must not be NULL, and numGeometries must not be 0";
+            error(ss.str());
+            return c_InvalidBuildToken;
+        }
+
+        if (as->getDesc().isTopLevel)
+        {
+            std::stringstream ss;
+            ss << "BlasBuildQueue::" << function << ": " << utils::DebugNameToString(as->getDesc().debugName)
+                << " is a top-level acceleration structure";
+            error(ss.str());
+            return c_InvalidBuildToken;
+        }
+
+        Request request;
+        request.accelStruct = as;
+        request.geometries.assign(pGeometries, pGeometries + numGeometries);
+        request.buildFlags = buildFlags;
+
+        std::lock_guard lockGuard(m_RequestMutex);
+
+        request.token = ++m_LastIssuedToken;
+
+        BuildToken const token = request.token;
+        m_PendingRequests.push_back(std::move(request));
+        return token;
+    }
+
+    BuildToken BlasBuildQueue::build(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        return enqueue("build", as, pGeometries, numGeometries, buildFlags);
+    }
+
+    BuildToken BlasBuildQueue::refit(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        return enqueue("refit", as, pGeometries, numGeometries, buildFlags | rt::AccelStructBuildFlags::PerformUpdate);
+    }
+
+    void BlasBuildQueue::recordBuilds(const std::vector<Request>& requests, std::vector<BufferHandle>& geometryBuffers)
+    {
+        // A BLAS may appear only once in a buildBottomLevelAccelStructs batch, so a second request for the same BLAS,
+        // such as a build followed by a refit, starts the next batch
+        std::vector<rt::BlasBuildDesc> batch;
+        std::unordered_set<rt::IAccelStruct*> batchAccelStructs;
+
+        auto flushBatch = [this, &batch, &batchAccelStructs]()
+        {
+            if (batch.empty())
+                return;
+
+            m_CommandList->buildBottomLevelAccelStructs(batch.data(), batch.size());
+            batch.clear();
+            batchAccelStructs.clear();
+        };
+
+        for (const Request& request : requests)
+        {
+            if (!batchAccelStructs.insert(request.accelStruct).second)
+            {
+                flushBatch();
+                batchAccelStructs.insert(request.accelStruct);
+            }
+
+            batch.push_back(rt::BlasBuildDesc()
+                .setAccelStruct(request.accelStruct)
+                .setGeometries(request.geometries.data(), request.geometries.size())
+                .setBuildFlags(request.buildFlags));
+
+            // The first two fields of all geometry types are buffers, see rt::GeometryTriangles
+            for (const rt::GeometryDesc& geometry : request.geometries)
+            {
+                if (geometry.geometryData.triangles.indexBuffer)
+                    geometryBuffers.push_back(geometry.geometryData.triangles.indexBuffer);
+                if (geometry.geometryData.triangles.vertexBuffer)
+                    geometryBuffers.push_back(geometry.geometryData.triangles.vertexBuffer);
+            }
+        }
+
+        flushBatch();
+
+        // Hand the BLASes over to the queue that builds the TLAS in the state that TLAS builds expect
+        for (const Request& request : requests)
+            m_CommandList->setAccelStructState(request.accelStruct, ResourceStates::AccelStructBuildBlas);
+        m_CommandList->commitBarriers();
+    }
+
+    BuildToken BlasBuildQueue::submitPendingBuilds()
+    {
+        std::lock_guard submitLockGuard(m_SubmitMutex);
+
+        // Recycle the event queries of finished submissions
+        retireSubmissions();
+
+        std::vector<Request> requests;
+        {
+            std::lock_guard requestLockGuard(m_RequestMutex);
+
+            while (!m_PendingRequests.empty())
+            {
+                if (m_Desc.maxBuildsPerSubmit != 0 && requests.size() >= m_Desc.maxBuildsPerSubmit)
+                    break;
+
+                requests.push_back(std::move(m_PendingRequests.front()));
+                m_PendingRequests.pop_front();
+            }
+        }
+
+        if (requests.empty())
+            return c_InvalidBuildToken;
+
+        if (!m_CommandList)
+        {
+            m_CommandList = m_Device->createCommandList(CommandListParameters()
+                .setQueueType(m_Queue)
+                .setScratchChunkSize(m_Desc.scratchChunkSize)
+                .setUseSharedScratchPool(m_Desc.useSharedScratchPool));
+
+            if (!m_CommandList)
+            {
+                error("BlasBuildQueue: failed to create the build command list");
+                return c_InvalidBuildToken;
+            }
+        }
+
+        Submission submission;
+
+        m_CommandList->open();
+        recordBuilds(requests, submission.geometryBuffers);
+        m_CommandList->close();
+
+        submission.lastToken = requests.back().token;
+        submission.instance = m_Device->executeCommandList(m_CommandList, m_Queue);
+
+        if (!m_FreeQueries.empty())
+        {
+            submission.query = m_FreeQueries.back();
+            m_FreeQueries.pop_back();
+            m_Device->resetEventQuery(submission.query);
+        }
+        else
+        {
+            submission.query = m_Device->createEventQuery();
+        }
+        m_Device->setEventQuery(submission.query, m_Queue);
+
+        m_Submissions.push_back(std::move(submission));
+        m_LastSubmittedToken = requests.back().token;
+
+        return m_LastSubmittedToken;
+    }
+
+    void BlasBuildQueue::retireSubmissions()
+    {
+        while (!m_Submissions.empty() && m_Device->pollEventQuery(m_Submissions.front().query))
+        {
+            m_LastCompletedToken = m_Submissions.front().lastToken;
+            m_FreeQueries.push_back(std::move(m_Submissions.front().query));
+            m_Submissions.pop_front();
+        }
+    }
+
+    bool BlasBuildQueue::isBuildComplete(BuildToken token)
+    {
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        if (token <= m_LastCompletedToken)
+            return true;
+
+        retireSubmissions();
+
+        return token <= m_LastCompletedToken;
+    }
+
+    bool BlasBuildQueue::queueWaitForBuilds(CommandQueue waitQueue, BuildToken token)
+    {
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        if (token == c_InvalidBuildToken || token > m_LastSubmittedToken)
+            return false;
+
+        if (token <= m_LastCompletedToken)
+            return true;
+
+        // Wait for the first submission that contains the request, submissions are ordered by token
+        for (const Submission& submission : m_Submissions)
+        {
+            if (submission.lastToken >= token)
+            {
+                if (waitQueue != m_Queue)
+                    m_Device->queueWaitForCommandList(waitQueue, m_Queue, submission.instance);
+                return true;
+            }
+        }
+
+        return true;
+    }
+
+    size_t BlasBuildQueue::getPendingBuildCount()
+    {
+        std::lock_guard lockGuard(m_RequestMutex);
+        return m_PendingRequests.size();
+    }
+
+    BlasBuildQueueHandle createBlasBuildQueue(IDevice* device, const BlasBuildQueueDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        if (!device->queryFeatureSupport(Feature::RayTracingAccelStruct))
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createBlasBuildQueue: the device doesn't support ray tracing acceleration structures");
+            return nullptr;
+        }
+
+        CommandQueue queue = desc.queue;
+        if (queue == CommandQueue::Copy ||
+            (queue == CommandQueue::Compute && !device->queryFeatureSupport(Feature::ComputeQueue)))
+        {
+            queue = CommandQueue::Graphics;
+        }
+
+        BlasBuildQueue* buildQueue = new BlasBuildQueue(device, desc, queue);
+        return BlasBuildQueueHandle::Create(buildQueue);
+    }
+}
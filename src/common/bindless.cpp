@@ -0,0 +1,278 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi::utils
+{
+    class BindlessDescriptorManager : public RefCounter<IBindlessDescriptorManager>
+    {
+    public:
+        BindlessDescriptorManager(IDevice* device, const BindlessDescriptorManagerDesc& desc, IDescriptorTable* table,
+            uint32_t initialCapacity, uint32_t maxCapacity);
+
+        uint32_t allocate(const BindingSetItem& item) override;
+        void update(uint32_t index, const BindingSetItem& item) override;
+        void release(uint32_t index) override;
+        bool flush() override;
+        void markSubmitted() override;
+        IDescriptorTable* getDescriptorTable() const override { return m_Table; }
+        uint32_t getNumAllocatedIndices() override;
+
+    private:
+        // Indices released before a submission, which become free when its query is signaled
+        struct RetiringIndices
+        {
+            EventQueryHandle query;
+            std::vector<uint32_t> indices;
+        };
+
+        DeviceHandle m_Device;
+        BindlessDescriptorManagerDesc m_Desc;
+        DescriptorTableHandle m_Table;
+        uint32_t m_MaxCapacity;
+
+        std::mutex m_Mutex;
+        BitSetAllocator m_Allocator; // capacity can be ahead of the table's until the next flush()
+        std::vector<bool> m_LiveIndices; // allocated and not released yet, to catch double releases
+        uint32_t m_NumAllocated = 0;
+        std::vector<BindingSetItem> m_PendingWrites;
+        std::vector<uint32_t> m_ReleasedIndices;
+        std::deque<RetiringIndices> m_RetiringIndices; // in the order of submission
+        std::vector<EventQueryHandle> m_FreeQueries;
+
+        void error(const std::string& message) const;
+        bool isValidIndex(uint32_t index, const char* function) const;
+        void retireFinishedIndices();
+    };
+
+    BindlessDescriptorManager::BindlessDescriptorManager(IDevice* device, const BindlessDescriptorManagerDesc& desc,
+        IDescriptorTable* table, uint32_t initialCapacity, uint32_t maxCapacity)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_Table(table)
+        , m_MaxCapacity(maxCapacity)
+        , m_Allocator(initialCapacity, false) // guarded by m_Mutex together with the rest of the state
+    { }
+
+    void BindlessDescriptorManager::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    bool BindlessDescriptorManager::isValidIndex(uint32_t index, const char* function) const
+    {
+        if (index < m_LiveIndices.size() && m_LiveIndices[index])
+            return true;
+
+        std::stringstream ss;
+        ss << "IBindlessDescriptorManager::" << function << ": index " << index;
+        if (index < m_Allocator.getCapacity())
+            ss << " is not allocated or has already been released";
+        else
+            ss << " is out of range";
+        ss << " in bindless descriptor manager " << DebugNameToString(m_Desc.debugName);
+        error(ss.str());
+        return false;
+    }
+
+    void BindlessDescriptorManager::retireFinishedIndices()
+    {
+        while (!m_RetiringIndices.empty() && m_Device->pollEventQuery(m_RetiringIndices.front().query))
+        {
+            RetiringIndices& retiring = m_RetiringIndices.front();
+
+            for (uint32_t index : retiring.indices)
+                m_Allocator.release(int(index));
+
+            m_Device->resetEventQuery(retiring.query);
+            m_FreeQueries.push_back(retiring.query);
+            m_RetiringIndices.pop_front();
+        }
+    }
+
+    uint32_t BindlessDescriptorManager::allocate(const BindingSetItem& item)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        int index = m_Allocator.allocate();
+
+        if (index < 0)
+        {
+            // Prefer the indices that the GPU is done with over growing the table
+            retireFinishedIndices();
+            index = m_Allocator.allocate();
+        }
+
+        if (index < 0)
+        {
+            const size_t capacity = m_Allocator.getCapacity();
+            if (capacity >= m_MaxCapacity)
+            {
+                std::stringstream ss;
+                ss << "Bindless descriptor manager " << DebugNameToString(m_Desc.debugName)
+                    << " is full, all " << m_MaxCapacity << " indices allowed by its layout are either allocated"
+                    " or released and still in use by the GPU";
+                error(ss.str());
+                return c_InvalidBindlessIndex;
+            }
+
+            // The table itself is resized by the next flush(), once for all the allocations made until then
+            m_Allocator.resize(std::min(std::max(capacity * 2, size_t(1)), size_t(m_MaxCapacity)));
+            index = m_Allocator.allocate();
+        }
+
+        if (size_t(index) >= m_LiveIndices.size())
+            m_LiveIndices.resize(m_Allocator.getCapacity(), false);
+        m_LiveIndices[index] = true;
+        ++m_NumAllocated;
+
+        BindingSetItem write = item;
+        write.slot = uint32_t(index);
+        m_PendingWrites.push_back(write);
+
+        return uint32_t(index);
+    }
+
+    void BindlessDescriptorManager::update(uint32_t index, const BindingSetItem& item)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!isValidIndex(index, "update"))
+            return;
+
+        // The writes are made in order, so this one replaces any earlier write that is still queued
+        BindingSetItem write = item;
+        write.slot = index;
+        m_PendingWrites.push_back(write);
+    }
+
+    void BindlessDescriptorManager::release(uint32_t index)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!isValidIndex(index, "release"))
+            return;
+
+        // The resources of the queued writes can be destroyed before the next flush()
+        m_PendingWrites.erase(std::remove_if(m_PendingWrites.begin(), m_PendingWrites.end(),
+            [index](const BindingSetItem& write) { return write.slot == index; }), m_PendingWrites.end());
+
+        m_LiveIndices[index] = false;
+        m_ReleasedIndices.push_back(index);
+        --m_NumAllocated;
+    }
+
+    bool BindlessDescriptorManager::flush()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        bool success = true;
+
+        const uint32_t capacity = uint32_t(m_Allocator.getCapacity());
+        if (capacity > m_Table->getCapacity())
+        {
+            m_Device->resizeDescriptorTable(m_Table, capacity, true);
+
+            if (m_Table->getCapacity() < capacity)
+            {
+                std::stringstream ss;
+                ss << "Failed to grow the descriptor table of bindless descriptor manager "
+                    << DebugNameToString(m_Desc.debugName) << " to " << capacity << " entries";
+                error(ss.str());
+                success = false;
+            }
+        }
+
+        if (!m_PendingWrites.empty())
+        {
+            if (!m_Device->writeDescriptorTable(m_Table, m_PendingWrites.data(), uint32_t(m_PendingWrites.size())))
+                success = false;
+
+            m_PendingWrites.clear();
+        }
+
+        return success;
+    }
+
+    void BindlessDescriptorManager::markSubmitted()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        retireFinishedIndices();
+
+        if (m_ReleasedIndices.empty())
+            return;
+
+        RetiringIndices retiring;
+        if (!m_FreeQueries.empty())
+        {
+            retiring.query = m_FreeQueries.back();
+            m_FreeQueries.pop_back();
+        }
+        else
+        {
+            retiring.query = m_Device->createEventQuery();
+        }
+
+        m_Device->setEventQuery(retiring.query, m_Desc.queue);
+        retiring.indices.swap(m_ReleasedIndices);
+        m_RetiringIndices.push_back(std::move(retiring));
+    }
+
+    uint32_t BindlessDescriptorManager::getNumAllocatedIndices()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_NumAllocated;
+    }
+
+    BindlessDescriptorManagerHandle CreateBindlessDescriptorManager(IDevice* device, const BindlessDescriptorManagerDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        const BindlessLayoutDesc* bindlessDesc = desc.layout ? desc.layout->getBindlessDesc() : nullptr;
+        if (!bindlessDesc)
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "CreateBindlessDescriptorManager: the layout must be created with createBindlessLayout");
+            return nullptr;
+        }
+
+        DescriptorTableHandle table = device->createDescriptorTable(desc.layout);
+        if (!table)
+            return nullptr;
+
+        const uint32_t initialCapacity = std::min(std::max(desc.initialCapacity, 1u), bindlessDesc->maxCapacity);
+        device->resizeDescriptorTable(table, initialCapacity, false);
+
+        BindlessDescriptorManager* manager = new BindlessDescriptorManager(device, desc, table, initialCapacity, bindlessDesc->maxCapacity);
+        return BindlessDescriptorManagerHandle::Create(manager);
+    }
+}
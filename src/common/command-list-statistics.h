@@ -0,0 +1,37 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#ifndef NVRHI_WITH_COMMAND_LIST_STATISTICS
+#define NVRHI_WITH_COMMAND_LIST_STATISTICS 0
+#endif
+
+// Adds 'value' to the 'counter' field of a CommandListStatistics structure.
+// Compiles into nothing when NVRHI_WITH_COMMAND_LIST_STATISTICS is disabled, including the evaluation of 'value'.
+#if NVRHI_WITH_COMMAND_LIST_STATISTICS
+#define NVRHI_COUNT_STATISTIC(statistics, counter, value) ((statistics).counter += uint64_t(value))
+#else
+#define NVRHI_COUNT_STATISTIC(statistics, counter, value) ((void)0)
+#endif
@@ -0,0 +1,356 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/feedback.h>
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi::feedback
+{
+    // Row alignment of the decoded data, same as D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    constexpr size_t c_DecodedRowAlignment = 256;
+
+    class SamplerFeedbackReader : public RefCounter<ISamplerFeedbackReader>
+    {
+    public:
+        SamplerFeedbackReader(IDevice* device, const FeedbackReaderDesc& desc);
+
+        FeedbackTextureId addTexture(ISamplerFeedbackTexture* feedbackTexture) override;
+        void removeTexture(FeedbackTextureId id) override;
+        uint32_t recordDecode(ICommandList* commandList) override;
+        void markSubmitted() override;
+        uint32_t processResults(IFeedbackListener& listener) override;
+
+    private:
+        struct Texture
+        {
+            SamplerFeedbackTextureHandle feedbackTexture;
+            // The decode always writes to the beginning of a buffer, so each texture has its own decode target
+            // that is then copied into the packed readback buffer.
+            BufferHandle decodeBuffer;
+            uint32_t widthInRegions = 0;
+            uint32_t heightInRegions = 0;
+            size_t rowPitch = 0;
+            uint64_t dataSize = 0;
+        };
+
+        enum class SlotState : uint8_t
+        {
+            Free,
+            Recorded,
+            Submitted,
+            Processing
+        };
+
+        struct SlotEntry
+        {
+            FeedbackTextureId id = c_InvalidFeedbackTexture;
+            SamplerFeedbackTextureHandle feedbackTexture;
+            uint64_t offset = 0;
+            uint32_t widthInRegions = 0;
+            uint32_t heightInRegions = 0;
+            size_t rowPitch = 0;
+        };
+
+        struct Slot
+        {
+            BufferHandle buffer;
+            EventQueryHandle query;
+            SlotState state = SlotState::Free;
+            uint64_t batchIndex = 0;
+            uint64_t dataSize = 0;
+            std::vector<SlotEntry> entries;
+        };
+
+        DeviceHandle m_Device;
+        FeedbackReaderDesc m_Desc;
+
+        std::mutex m_Mutex;
+        std::map<FeedbackTextureId, Texture> m_Textures;
+        std::vector<Slot> m_Slots;
+        FeedbackTextureId m_LastTextureId = c_InvalidFeedbackTexture;
+        // The rotation continues after this texture in the next batch
+        FeedbackTextureId m_LastDecodedId = c_InvalidFeedbackTexture;
+        uint64_t m_LastBatchIndex = 0;
+
+        void error(const std::string& message) const;
+    };
+
+    SamplerFeedbackReader::SamplerFeedbackReader(IDevice* device, const FeedbackReaderDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        m_Slots.resize(std::max(desc.numSlots, 1u));
+    }
+
+    void SamplerFeedbackReader::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    FeedbackTextureId SamplerFeedbackReader::addTexture(ISamplerFeedbackTexture* feedbackTexture)
+    {
+        if (!feedbackTexture)
+            return c_InvalidFeedbackTexture;
+
+        const SamplerFeedbackTextureDesc& feedbackDesc = feedbackTexture->getDesc();
+        TextureHandle pairedTexture = feedbackTexture->getPairedTexture();
+
+        if (feedbackDesc.samplerFeedbackFormat != SamplerFeedbackFormat::MinMipOpaque || !pairedTexture ||
+            feedbackDesc.samplerFeedbackMipRegionX == 0 || feedbackDesc.samplerFeedbackMipRegionY == 0)
+        {
+            std::stringstream ss;
+            ss << "SamplerFeedbackReader " << utils::DebugNameToString(m_Desc.debugName)
+                << ": only MinMipOpaque feedback textures with a paired texture and a mip region can be decoded";
+            error(ss.str());
+            return c_InvalidFeedbackTexture;
+        }
+
+        const TextureDesc& pairedDesc = pairedTexture->getDesc();
+
+        Texture texture;
+        texture.feedbackTexture = feedbackTexture;
+        texture.widthInRegions = (pairedDesc.width + feedbackDesc.samplerFeedbackMipRegionX - 1) / feedbackDesc.samplerFeedbackMipRegionX;
+        texture.heightInRegions = (pairedDesc.height + feedbackDesc.samplerFeedbackMipRegionY - 1) / feedbackDesc.samplerFeedbackMipRegionY;
+        texture.rowPitch = align(size_t(texture.widthInRegions), c_DecodedRowAlignment);
+        texture.dataSize = uint64_t(texture.rowPitch) * texture.heightInRegions;
+
+        if (texture.dataSize > m_Desc.readbackBufferSize)
+        {
+            std::stringstream ss;
+            ss << "SamplerFeedbackReader " << utils::DebugNameToString(m_Desc.debugName) << ": the decoded feedback of texture "
+                << utils::DebugNameToString(pairedDesc.debugName) << " takes " << texture.dataSize
+                << " bytes, which doesn't fit into the readback buffers of " << m_Desc.readbackBufferSize << " bytes";
+            error(ss.str());
+            return c_InvalidFeedbackTexture;
+        }
+
+        texture.decodeBuffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(texture.dataSize)
+            .setInitialState(ResourceStates::CopySource)
+            .setKeepInitialState(true)
+            .setDebugName(m_Desc.debugName + "/" + pairedDesc.debugName));
+
+        if (!texture.decodeBuffer)
+            return c_InvalidFeedbackTexture;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        const FeedbackTextureId id = ++m_LastTextureId;
+        m_Textures[id] = std::move(texture);
+        return id;
+    }
+
+    void SamplerFeedbackReader::removeTexture(FeedbackTextureId id)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Textures.erase(id);
+    }
+
+    uint32_t SamplerFeedbackReader::recordDecode(ICommandList* commandList)
+    {
+        if (!commandList)
+            return 0;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_Textures.empty())
+            return 0;
+
+        Slot* slot = nullptr;
+        for (Slot& candidate : m_Slots)
+        {
+            if (candidate.state == SlotState::Free)
+            {
+                slot = &candidate;
+                break;
+            }
+        }
+
+        if (!slot)
+            return 0;
+
+        if (!slot->buffer)
+        {
+            slot->buffer = m_Device->createBuffer(BufferDesc()
+                .setByteSize(m_Desc.readbackBufferSize)
+                .setCpuAccess(CpuAccessMode::Read)
+                .setInitialState(ResourceStates::CopyDest)
+                .setKeepInitialState(true)
+                .setDebugName(m_Desc.debugName));
+
+            if (!slot->buffer)
+                return 0;
+        }
+
+        slot->entries.clear();
+        slot->dataSize = 0;
+
+        const size_t maxTextures = std::min(size_t(std::max(m_Desc.maxTexturesPerBatch, 1u)), m_Textures.size());
+
+        auto it = m_Textures.upper_bound(m_LastDecodedId);
+        while (slot->entries.size() < maxTextures)
+        {
+            if (it == m_Textures.end())
+                it = m_Textures.begin();
+
+            const Texture& texture = it->second;
+            if (slot->dataSize + texture.dataSize > m_Desc.readbackBufferSize)
+                break;
+
+            commandList->decodeSamplerFeedbackTexture(texture.decodeBuffer, texture.feedbackTexture, Format::R8_UINT);
+            commandList->copyBuffer(slot->buffer, slot->dataSize, texture.decodeBuffer, 0, texture.dataSize);
+            commandList->clearSamplerFeedbackTexture(texture.feedbackTexture);
+
+            SlotEntry& entry = slot->entries.emplace_back();
+            entry.id = it->first;
+            entry.feedbackTexture = texture.feedbackTexture;
+            entry.offset = slot->dataSize;
+            entry.widthInRegions = texture.widthInRegions;
+            entry.heightInRegions = texture.heightInRegions;
+            entry.rowPitch = texture.rowPitch;
+
+            slot->dataSize += texture.dataSize;
+            m_LastDecodedId = it->first;
+            ++it;
+        }
+
+        slot->state = SlotState::Recorded;
+        slot->batchIndex = ++m_LastBatchIndex;
+        return uint32_t(slot->entries.size());
+    }
+
+    void SamplerFeedbackReader::markSubmitted()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (Slot& slot : m_Slots)
+        {
+            if (slot.state != SlotState::Recorded)
+                continue;
+
+            if (slot.query)
+                m_Device->resetEventQuery(slot.query);
+            else
+                slot.query = m_Device->createEventQuery();
+
+            m_Device->setEventQuery(slot.query, m_Desc.queue);
+            slot.state = SlotState::Submitted;
+        }
+    }
+
+    uint32_t SamplerFeedbackReader::processResults(IFeedbackListener& listener)
+    {
+        std::vector<Slot*> finishedSlots;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            for (Slot& slot : m_Slots)
+            {
+                if (slot.state == SlotState::Submitted && m_Device->pollEventQuery(slot.query))
+                {
+                    // Drop the results of the textures that were removed after the batch was recorded
+                    slot.entries.erase(std::remove_if(slot.entries.begin(), slot.entries.end(), [this](const SlotEntry& entry)
+                    {
+                        auto it = m_Textures.find(entry.id);
+                        return it == m_Textures.end() || it->second.feedbackTexture != entry.feedbackTexture;
+                    }), slot.entries.end());
+
+                    slot.state = SlotState::Processing;
+                    finishedSlots.push_back(&slot);
+                }
+            }
+        }
+
+        std::sort(finishedSlots.begin(), finishedSlots.end(), [](const Slot* a, const Slot* b)
+            { return a->batchIndex < b->batchIndex; });
+
+        // The listener is called without holding the lock; slots in the Processing state are not touched by other calls
+        uint32_t numResults = 0;
+        for (Slot* slot : finishedSlots)
+        {
+            if (slot->entries.empty())
+                continue;
+
+            // The batch has finished, so mapping doesn't wait for the GPU
+            const uint8_t* data = static_cast<const uint8_t*>(m_Device->mapBuffer(slot->buffer, CpuAccessMode::Read, 0, size_t(slot->dataSize)));
+            if (!data)
+                continue;
+
+            for (const SlotEntry& entry : slot->entries)
+            {
+                FeedbackResult result;
+                result.id = entry.id;
+                result.feedbackTexture = entry.feedbackTexture;
+                result.minMips = data + entry.offset;
+                result.widthInRegions = entry.widthInRegions;
+                result.heightInRegions = entry.heightInRegions;
+                result.rowPitch = entry.rowPitch;
+                result.batchIndex = slot->batchIndex;
+
+                listener.onFeedback(result);
+                ++numResults;
+            }
+
+            m_Device->unmapBuffer(slot->buffer);
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (Slot* slot : finishedSlots)
+        {
+            slot->entries.clear();
+            slot->state = SlotState::Free;
+        }
+
+        return numResults;
+    }
+
+    SamplerFeedbackReaderHandle createSamplerFeedbackReader(IDevice* device, const FeedbackReaderDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        if (!device->queryFeatureSupport(Feature::SamplerFeedback))
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createSamplerFeedbackReader: the device doesn't support sampler feedback");
+            return nullptr;
+        }
+
+        if (desc.readbackBufferSize == 0)
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createSamplerFeedbackReader: readbackBufferSize must not be 0");
+            return nullptr;
+        }
+
+        return SamplerFeedbackReaderHandle::Create(new SamplerFeedbackReader(device, desc));
+    }
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "garbage-collection.h"
+#include <algorithm>
+
+namespace nvrhi
+{
+    bool GarbageCollectionBudgetTracker::isExhausted() const
+    {
+        if (m_Budget.maxObjects != 0 && m_ReleasedObjects >= m_Budget.maxObjects)
+            return true;
+
+        if (m_Budget.maxMilliseconds > 0.f)
+        {
+            std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_StartTime;
+            if (elapsed.count() >= m_Budget.maxMilliseconds)
+                return true;
+        }
+
+        return false;
+    }
+
+    BackgroundGarbageCollector::~BackgroundGarbageCollector()
+    {
+        stop();
+    }
+
+    void BackgroundGarbageCollector::start(CollectFunction collect, uint32_t intervalMilliseconds)
+    {
+        stop();
+
+        m_Terminate = false;
+        m_Thread = std::thread(&BackgroundGarbageCollector::workerThreadProc, this, std::move(collect),
+            std::chrono::milliseconds(std::max(intervalMilliseconds, 1u)));
+    }
+
+    void BackgroundGarbageCollector::stop()
+    {
+        if (!m_Thread.joinable())
+            return;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_Terminate = true;
+        }
+
+        m_Condition.notify_all();
+        m_Thread.join();
+    }
+
+    void BackgroundGarbageCollector::workerThreadProc(CollectFunction collect, std::chrono::milliseconds interval)
+    {
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_Mutex);
+                if (m_Condition.wait_for(lock, interval, [this]() { return m_Terminate; }))
+                    return;
+            }
+
+            collect();
+        }
+    }
+
+} // namespace nvrhi
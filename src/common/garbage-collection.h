@@ -0,0 +1,82 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace nvrhi
+{
+    // Tracks the elapsed time and the number of released objects of one garbage collection pass.
+    class GarbageCollectionBudgetTracker
+    {
+    public:
+        explicit GarbageCollectionBudgetTracker(const GarbageCollectionBudget& budget)
+            : m_Budget(budget)
+            , m_StartTime(std::chrono::steady_clock::now())
+        { }
+
+        void objectsReleased(size_t count) { m_ReleasedObjects += count; }
+
+        [[nodiscard]] bool isExhausted() const;
+
+    private:
+        GarbageCollectionBudget m_Budget;
+        std::chrono::steady_clock::time_point m_StartTime;
+        size_t m_ReleasedObjects = 0;
+    };
+
+    // Calls the collection function on a worker thread at a fixed interval until stopped.
+    class BackgroundGarbageCollector
+    {
+    public:
+        typedef std::function<void()> CollectFunction;
+
+        BackgroundGarbageCollector() = default;
+        ~BackgroundGarbageCollector();
+
+        BackgroundGarbageCollector(const BackgroundGarbageCollector&) = delete;
+        BackgroundGarbageCollector& operator=(const BackgroundGarbageCollector&) = delete;
+
+        // Restarts the worker if it's already running
+        void start(CollectFunction collect, uint32_t intervalMilliseconds);
+
+        // Waits for the current collection to finish. Must be called by the device before it starts
+        // destroying the objects that the collection function uses.
+        void stop();
+
+    private:
+        std::thread m_Thread;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Terminate = false;
+
+        void workerThreadProc(CollectFunction collect, std::chrono::milliseconds interval);
+    };
+
+} // namespace nvrhi
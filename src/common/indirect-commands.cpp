@@ -0,0 +1,61 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "indirect-commands.h"
+
+namespace nvrhi
+{
+    uint32_t getIndirectArgumentByteSize(const IndirectArgumentDesc& argument)
+    {
+        switch (argument.type)
+        {
+        case IndirectArgumentType::PushConstants:
+            return argument.pushConstantsByteSize;
+        case IndirectArgumentType::VertexBuffer:
+            return uint32_t(sizeof(IndirectVertexBufferView));
+        case IndirectArgumentType::IndexBuffer:
+            return uint32_t(sizeof(IndirectIndexBufferView));
+        case IndirectArgumentType::Draw:
+            return uint32_t(sizeof(DrawIndirectArguments));
+        case IndirectArgumentType::DrawIndexed:
+            return uint32_t(sizeof(DrawIndexedIndirectArguments));
+        case IndirectArgumentType::Dispatch:
+            return uint32_t(sizeof(DispatchIndirectArguments));
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t getIndirectCommandStride(const IndirectCommandLayoutDesc& desc)
+    {
+        if (desc.byteStride != 0)
+            return desc.byteStride;
+
+        uint32_t stride = 0;
+        for (const IndirectArgumentDesc& argument : desc.arguments)
+            stride += getIndirectArgumentByteSize(argument);
+
+        return stride;
+    }
+}
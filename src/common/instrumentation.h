@@ -0,0 +1,69 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+
+namespace nvrhi
+{
+    // Holds the callback registered with IDevice::setInstrumentationCallback. Instrumented operations read it
+    // with one relaxed load, so that their cost without a callback is a single predictable branch.
+    class InstrumentationHook
+    {
+    public:
+        void set(IInstrumentationCallback* callback) { m_Callback.store(callback, std::memory_order_relaxed); }
+        [[nodiscard]] IInstrumentationCallback* get() const { return m_Callback.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<IInstrumentationCallback*> m_Callback { nullptr };
+    };
+
+    // Reports a zone for the lifetime of the object. The callback is read once, so that the end event goes to
+    // the same callback as the begin event even if the callback is replaced in between.
+    class InstrumentationScope
+    {
+    public:
+        InstrumentationScope(const InstrumentationHook& hook, InstrumentationZone zone)
+            : m_Callback(hook.get())
+            , m_Zone(zone)
+        {
+            if (m_Callback)
+                m_Callback->beginZone(m_Zone);
+        }
+
+        ~InstrumentationScope()
+        {
+            if (m_Callback)
+                m_Callback->endZone(m_Zone);
+        }
+
+        InstrumentationScope(const InstrumentationScope&) = delete;
+        InstrumentationScope& operator=(const InstrumentationScope&) = delete;
+
+    private:
+        IInstrumentationCallback* m_Callback;
+        InstrumentationZone m_Zone;
+    };
+
+} // namespace nvrhi
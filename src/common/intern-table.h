@@ -0,0 +1,159 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Returns the live object created from an identical description instead of creating a new one, see
+    // DeviceDesc::enableStateObjectInterning in the backends. The table doesn't own the objects: each interned
+    // object has an Entry member that removes it from the table when the object is destroyed, like the
+    // entries of the D3D12 root signature cache.
+    template<typename Object, typename Key, typename Hasher = std::hash<Key>>
+    class InternTable
+    {
+    public:
+        // A member of the interned object. The key is stored in the entry, so the other members of the object
+        // are never accessed by the table.
+        class Entry
+        {
+        public:
+            Entry() = default;
+            ~Entry() { if (m_Table) m_Table->remove(this); }
+
+            Entry(const Entry&) = delete;
+            Entry& operator=(const Entry&) = delete;
+
+        private:
+            friend class InternTable;
+
+            InternTable* m_Table = nullptr;
+            Object* m_Object = nullptr;
+            Key m_Key;
+            size_t m_Hash = 0;
+        };
+
+        [[nodiscard]] RefCountPtr<Object> find(const Key& key)
+        {
+            const size_t hash = Hasher()(key);
+
+            std::lock_guard lockGuard(m_Mutex);
+            return findLocked(key, hash);
+        }
+
+        // Registers a newly created object unless another thread has interned an identical one in the meantime,
+        // and returns the object that should be used. 'entry' is the Entry member of 'object'.
+        RefCountPtr<Object> insert(const Key& key, Object* object, Entry& entry)
+        {
+            const size_t hash = Hasher()(key);
+
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (RefCountPtr<Object> existing = findLocked(key, hash))
+                return existing;
+
+            entry.m_Table = this;
+            entry.m_Object = object;
+            entry.m_Key = key;
+            entry.m_Hash = hash;
+            m_Entries.emplace(hash, &entry);
+
+            return object;
+        }
+
+    private:
+        std::mutex m_Mutex;
+        std::unordered_multimap<size_t, Entry*> m_Entries;
+
+        RefCountPtr<Object> findLocked(const Key& key, size_t hash)
+        {
+            auto [it, end] = m_Entries.equal_range(hash);
+            while (it != end)
+            {
+                Entry* entry = it->second;
+                if (!(entry->m_Key == key))
+                {
+                    ++it;
+                    continue;
+                }
+
+                // An object whose last reference has just been released stays in the table until its Entry is
+                // destroyed, which waits for the mutex. Its counter goes from 0 to 1 here, which is harmless
+                // because the releasing thread deletes it regardless. Drop it from the table right away so that
+                // the next lookup doesn't take it for a live object.
+                if (entry->m_Object->AddRef() == 1)
+                {
+                    it = m_Entries.erase(it);
+                    continue;
+                }
+
+                return RefCountPtr<Object>::Create(entry->m_Object);
+            }
+
+            return nullptr;
+        }
+
+        void remove(Entry* entry)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            const auto range = m_Entries.equal_range(entry->m_Hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == entry)
+                {
+                    m_Entries.erase(it);
+                    return;
+                }
+            }
+        }
+    };
+
+    struct VertexAttributeArrayHash
+    {
+        size_t operator()(const std::vector<VertexAttributeDesc>& attributes) const noexcept
+        {
+            size_t value = 0;
+            for (const VertexAttributeDesc& attribute : attributes)
+                hash_combine(value, attribute);
+            return value;
+        }
+    };
+
+    // The tables of a device with DeviceDesc::enableStateObjectInterning. Bindless layouts are not interned.
+    struct StateObjectTables
+    {
+        typedef InternTable<ISampler, SamplerDesc> SamplerTable;
+        typedef InternTable<IInputLayout, std::vector<VertexAttributeDesc>, VertexAttributeArrayHash> InputLayoutTable;
+        typedef InternTable<IBindingLayout, BindingLayoutDesc> BindingLayoutTable;
+
+        SamplerTable samplers;
+        InputLayoutTable inputLayouts;
+        BindingLayoutTable bindingLayouts;
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,397 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/matrixcache.h>
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi::coopvec
+{
+    // Offset alignment of the converted matrices, which covers the destination alignment required by DX12 and Vulkan
+    constexpr uint64_t c_MatrixAlignment = 128;
+
+    // Identifies a source range and its conversion. The content version is not part of the key, so that a new version
+    // of the same range finds the entry of the previous one and replaces it.
+    struct MatrixKey
+    {
+        IBuffer* srcBuffer = nullptr;
+        uint64_t srcOffset = 0;
+        size_t srcSize = 0;
+        size_t srcStride = 0;
+        DataType srcType = DataType::UInt8;
+        MatrixLayout srcLayout = MatrixLayout::RowMajor;
+        DataType dstType = DataType::UInt8;
+        MatrixLayout dstLayout = MatrixLayout::RowMajor;
+        uint32_t numRows = 0;
+        uint32_t numColumns = 0;
+
+        bool operator==(const MatrixKey& other) const
+        {
+            return srcBuffer == other.srcBuffer
+                && srcOffset == other.srcOffset
+                && srcSize == other.srcSize
+                && srcStride == other.srcStride
+                && srcType == other.srcType
+                && srcLayout == other.srcLayout
+                && dstType == other.dstType
+                && dstLayout == other.dstLayout
+                && numRows == other.numRows
+                && numColumns == other.numColumns;
+        }
+    };
+
+    struct MatrixKeyHash
+    {
+        size_t operator()(const MatrixKey& key) const
+        {
+            size_t hash = 0;
+            hash_combine(hash, key.srcBuffer);
+            hash_combine(hash, key.srcOffset);
+            hash_combine(hash, key.srcSize);
+            hash_combine(hash, key.srcStride);
+            hash_combine(hash, key.srcType);
+            hash_combine(hash, key.srcLayout);
+            hash_combine(hash, key.dstType);
+            hash_combine(hash, key.dstLayout);
+            hash_combine(hash, key.numRows);
+            hash_combine(hash, key.numColumns);
+            return hash;
+        }
+    };
+
+    class MatrixCache : public RefCounter<IMatrixCache>
+    {
+    public:
+        MatrixCache(IDevice* device, const MatrixCacheDesc& desc);
+
+        CachedMatrix getConvertedMatrix(const MatrixLayoutDesc& src, uint32_t numRows, uint32_t numColumns,
+            DataType dstType, MatrixLayout dstLayout, uint64_t contentVersion) override;
+        uint32_t recordPendingConversions(ICommandList* commandList) override;
+        void evict(IBuffer* sourceBuffer) override;
+        MatrixCacheStatistics getStatistics() override;
+
+    private:
+        struct FreeRange
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+
+        struct PoolBuffer
+        {
+            BufferHandle buffer;
+            std::vector<FreeRange> freeRanges; // sorted by offset, adjacent ranges are merged
+        };
+
+        struct Entry
+        {
+            BufferHandle srcBuffer; // keeps the key's pointer from being reused by another buffer
+            CachedMatrix matrix;
+            uint64_t allocatedSize = 0;
+            uint64_t contentVersion = 0;
+        };
+
+        DeviceHandle m_Device;
+        MatrixCacheDesc m_Desc;
+
+        std::mutex m_Mutex;
+        std::vector<PoolBuffer> m_PoolBuffers;
+        std::unordered_map<MatrixKey, Entry, MatrixKeyHash> m_Entries;
+        std::vector<ConvertMatrixLayoutDesc> m_PendingConversions;
+        uint64_t m_CacheHits = 0;
+        uint64_t m_CacheMisses = 0;
+        uint64_t m_UsedBytes = 0;
+
+        void error(const std::string& message) const;
+        bool allocate(uint64_t size, CachedMatrix& outMatrix);
+        void release(const CachedMatrix& matrix, uint64_t allocatedSize);
+        void queueConversion(const MatrixLayoutDesc& src, uint32_t numRows, uint32_t numColumns, const CachedMatrix& dst,
+            DataType dstType, MatrixLayout dstLayout);
+        void dropPendingConversion(const CachedMatrix& dst);
+    };
+
+    MatrixCache::MatrixCache(IDevice* device, const MatrixCacheDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+    }
+
+    void MatrixCache::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    bool MatrixCache::allocate(uint64_t size, CachedMatrix& outMatrix)
+    {
+        // First fit over the existing buffers
+        for (PoolBuffer& pool : m_PoolBuffers)
+        {
+            for (size_t i = 0; i < pool.freeRanges.size(); i++)
+            {
+                FreeRange& range = pool.freeRanges[i];
+                if (range.size < size)
+                    continue;
+
+                outMatrix.buffer = pool.buffer;
+                outMatrix.offset = range.offset;
+
+                range.offset += size;
+                range.size -= size;
+                if (range.size == 0)
+                    pool.freeRanges.erase(pool.freeRanges.begin() + ptrdiff_t(i));
+
+                return true;
+            }
+        }
+
+        const uint64_t bufferSize = std::max(align(m_Desc.poolBufferSize, c_MatrixAlignment), size);
+
+        BufferHandle buffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(bufferSize)
+            .setCanHaveRawViews(true)
+            .setCanHaveUAVs(true)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName(m_Desc.debugName + "/Pool" + std::to_string(m_PoolBuffers.size())));
+
+        if (!buffer)
+        {
+            std::stringstream ss;
+            ss << "MatrixCache " << utils::DebugNameToString(m_Desc.debugName)
+                << ": failed to create a pool buffer of " << bufferSize << " bytes";
+            error(ss.str());
+            return false;
+        }
+
+        PoolBuffer& pool = m_PoolBuffers.emplace_back();
+        pool.buffer = buffer;
+        if (bufferSize > size)
+            pool.freeRanges.push_back(FreeRange{ size, bufferSize - size });
+
+        outMatrix.buffer = buffer;
+        outMatrix.offset = 0;
+        return true;
+    }
+
+    void MatrixCache::release(const CachedMatrix& matrix, uint64_t allocatedSize)
+    {
+        for (PoolBuffer& pool : m_PoolBuffers)
+        {
+            if (pool.buffer != matrix.buffer)
+                continue;
+
+            std::vector<FreeRange>& ranges = pool.freeRanges;
+            auto it = std::lower_bound(ranges.begin(), ranges.end(), matrix.offset,
+                [](const FreeRange& range, uint64_t offset) { return range.offset < offset; });
+            it = ranges.insert(it, FreeRange{ matrix.offset, allocatedSize });
+
+            // Merge with the following and the preceding ranges
+            if (it + 1 != ranges.end() && it->offset + it->size == (it + 1)->offset)
+            {
+                it->size += (it + 1)->size;
+                ranges.erase(it + 1);
+            }
+            if (it != ranges.begin() && (it - 1)->offset + (it - 1)->size == it->offset)
+            {
+                (it - 1)->size += it->size;
+                ranges.erase(it);
+            }
+            return;
+        }
+    }
+
+    void MatrixCache::queueConversion(const MatrixLayoutDesc& src, uint32_t numRows, uint32_t numColumns, const CachedMatrix& dst,
+        DataType dstType, MatrixLayout dstLayout)
+    {
+        ConvertMatrixLayoutDesc& conversion = m_PendingConversions.emplace_back();
+        conversion.src = src;
+        conversion.dst.buffer = dst.buffer;
+        conversion.dst.offset = dst.offset;
+        conversion.dst.type = dstType;
+        conversion.dst.layout = dstLayout;
+        conversion.dst.size = dst.size;
+        conversion.numRows = numRows;
+        conversion.numColumns = numColumns;
+    }
+
+    void MatrixCache::dropPendingConversion(const CachedMatrix& dst)
+    {
+        m_PendingConversions.erase(std::remove_if(m_PendingConversions.begin(), m_PendingConversions.end(),
+            [&dst](const ConvertMatrixLayoutDesc& conversion)
+            { return conversion.dst.buffer == dst.buffer && conversion.dst.offset == dst.offset; }),
+            m_PendingConversions.end());
+    }
+
+    CachedMatrix MatrixCache::getConvertedMatrix(const MatrixLayoutDesc& src, uint32_t numRows, uint32_t numColumns,
+        DataType dstType, MatrixLayout dstLayout, uint64_t contentVersion)
+    {
+        if (!src.buffer || src.size == 0 || numRows == 0 || numColumns == 0)
+        {
+            std::stringstream ss;
+            ss << "MatrixCache " << utils::DebugNameToString(m_Desc.debugName)
+                << ": getConvertedMatrix needs a source buffer, src.size and non-zero dimensions";
+            error(ss.str());
+            return CachedMatrix();
+        }
+
+        MatrixKey key;
+        key.srcBuffer = src.buffer;
+        key.srcOffset = src.offset;
+        key.srcSize = src.size;
+        key.srcStride = src.stride;
+        key.srcType = src.type;
+        key.srcLayout = src.layout;
+        key.dstType = dstType;
+        key.dstLayout = dstLayout;
+        key.numRows = numRows;
+        key.numColumns = numColumns;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto it = m_Entries.find(key);
+        if (it != m_Entries.end() && it->second.contentVersion == contentVersion)
+        {
+            ++m_CacheHits;
+            return it->second.matrix;
+        }
+
+        ++m_CacheMisses;
+
+        const size_t dstSize = m_Device->getCoopVecMatrixSize(dstType, dstLayout, int(numRows), int(numColumns));
+        if (dstSize == 0)
+            return CachedMatrix();
+
+        const uint64_t allocatedSize = align(uint64_t(dstSize), c_MatrixAlignment);
+
+        if (it != m_Entries.end())
+        {
+            // The source range holds a different version now: convert it into the memory of the previous version,
+            // replacing its conversion if that hasn't been recorded yet
+            Entry& staleEntry = it->second;
+            dropPendingConversion(staleEntry.matrix);
+
+            if (staleEntry.allocatedSize == allocatedSize)
+            {
+                staleEntry.contentVersion = contentVersion;
+                staleEntry.matrix.size = dstSize;
+                queueConversion(src, numRows, numColumns, staleEntry.matrix, dstType, dstLayout);
+                return staleEntry.matrix;
+            }
+
+            release(staleEntry.matrix, staleEntry.allocatedSize);
+            m_UsedBytes -= staleEntry.allocatedSize;
+            m_Entries.erase(it);
+        }
+
+        Entry entry;
+        entry.srcBuffer = src.buffer;
+        entry.allocatedSize = allocatedSize;
+        entry.contentVersion = contentVersion;
+        if (!allocate(entry.allocatedSize, entry.matrix))
+            return CachedMatrix();
+        entry.matrix.size = dstSize;
+        m_UsedBytes += entry.allocatedSize;
+
+        queueConversion(src, numRows, numColumns, entry.matrix, dstType, dstLayout);
+
+        const CachedMatrix matrix = entry.matrix;
+        m_Entries.emplace(key, std::move(entry));
+        return matrix;
+    }
+
+    uint32_t MatrixCache::recordPendingConversions(ICommandList* commandList)
+    {
+        if (!commandList)
+            return 0;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_PendingConversions.empty())
+            return 0;
+
+        commandList->convertCoopVecMatrices(m_PendingConversions.data(), m_PendingConversions.size());
+
+        const uint32_t numConversions = uint32_t(m_PendingConversions.size());
+        m_PendingConversions.clear();
+        return numConversions;
+    }
+
+    void MatrixCache::evict(IBuffer* sourceBuffer)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+        {
+            if (sourceBuffer && it->first.srcBuffer != sourceBuffer)
+            {
+                ++it;
+                continue;
+            }
+
+            const CachedMatrix& matrix = it->second.matrix;
+
+            // Drop the queued conversion into the memory that is released
+            dropPendingConversion(matrix);
+
+            release(matrix, it->second.allocatedSize);
+            m_UsedBytes -= it->second.allocatedSize;
+            it = m_Entries.erase(it);
+        }
+    }
+
+    MatrixCacheStatistics MatrixCache::getStatistics()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        MatrixCacheStatistics statistics;
+        statistics.numMatrices = uint32_t(m_Entries.size());
+        statistics.pendingConversions = uint32_t(m_PendingConversions.size());
+        statistics.cacheHits = m_CacheHits;
+        statistics.cacheMisses = m_CacheMisses;
+        statistics.usedBytes = m_UsedBytes;
+        for (const PoolBuffer& pool : m_PoolBuffers)
+            statistics.poolBytes += pool.buffer->getDesc().byteSize;
+        return statistics;
+    }
+
+    MatrixCacheHandle createMatrixCache(IDevice* device, const MatrixCacheDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        if (!device->queryFeatureSupport(Feature::CooperativeVectorInferencing) &&
+            !device->queryFeatureSupport(Feature::CooperativeVectorTraining))
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createMatrixCache: the device doesn't support Cooperative Vectors");
+            return nullptr;
+        }
+
+        return MatrixCacheHandle::Create(new MatrixCache(device, desc));
+    }
+}
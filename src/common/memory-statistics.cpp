@@ -0,0 +1,224 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "memory-statistics.h"
+#include <nvrhi/utils.h>
+
+namespace nvrhi
+{
+    static HeapType GetMemoryType(CpuAccessMode cpuAccess)
+    {
+        switch (cpuAccess)
+        {
+        case CpuAccessMode::Write: return HeapType::Upload;
+        case CpuAccessMode::Read: return HeapType::Readback;
+        default: return HeapType::DeviceLocal;
+        }
+    }
+
+    static ResourceAllocationType GetAllocationType(MemoryCategory category)
+    {
+        switch (category)
+        {
+        case MemoryCategory::Textures: return ResourceAllocationType::Texture;
+        case MemoryCategory::AccelStructs: return ResourceAllocationType::AccelStruct;
+        case MemoryCategory::UploadChunks: return ResourceAllocationType::UploadChunk;
+        case MemoryCategory::DescriptorHeaps: return ResourceAllocationType::DescriptorHeap;
+        case MemoryCategory::Heaps: return ResourceAllocationType::Heap;
+        default: return ResourceAllocationType::Buffer;
+        }
+    }
+
+    void MemoryCounters::link(TrackedMemory* allocation)
+    {
+        std::lock_guard lockGuard(m_AllocationsMutex);
+        // Appended, so that the enumeration goes from the oldest allocation to the newest
+        allocation->m_Prev = m_LastAllocation;
+        allocation->m_Next = nullptr;
+        if (m_LastAllocation)
+            m_LastAllocation->m_Next = allocation;
+        else
+            m_FirstAllocation = allocation;
+        m_LastAllocation = allocation;
+    }
+
+    void MemoryCounters::unlink(TrackedMemory* allocation)
+    {
+        std::lock_guard lockGuard(m_AllocationsMutex);
+        if (allocation->m_Prev)
+            allocation->m_Prev->m_Next = allocation->m_Next;
+        else
+            m_FirstAllocation = allocation->m_Next;
+        if (allocation->m_Next)
+            allocation->m_Next->m_Prev = allocation->m_Prev;
+        else
+            m_LastAllocation = allocation->m_Prev;
+        allocation->m_Prev = nullptr;
+        allocation->m_Next = nullptr;
+    }
+
+    void MemoryCounters::enumerateAllocations(IResourceAllocationCallback& callback)
+    {
+        std::lock_guard lockGuard(m_AllocationsMutex);
+
+        for (TrackedMemory* allocation = m_FirstAllocation; allocation; allocation = allocation->m_Next)
+        {
+            ResourceAllocationInfo info;
+            info.resource = allocation->m_Resource;
+            info.type = GetAllocationType(allocation->m_Category);
+            info.debugName = allocation->m_DebugName.c_str();
+            info.sizeInBytes = allocation->m_Bytes;
+            info.memoryType = allocation->m_MemoryType;
+            info.isPlaced = allocation->m_Heap != nullptr;
+            info.heap = allocation->m_Heap;
+            info.heapOffset = allocation->m_HeapOffset;
+            callback.onResourceAllocation(info);
+        }
+    }
+
+    void TrackedMemory::track(MemoryCounters& counters, MemoryCategory category, uint64_t bytes, IResource* resource,
+        std::string debugName, HeapType memoryType, IHeap* heap, uint64_t heapOffset)
+    {
+        reset();
+        m_Counters = &counters;
+        m_Category = category;
+        m_Bytes = bytes;
+        m_Resource = resource;
+        m_DebugName = std::move(debugName);
+        m_MemoryType = memoryType;
+        m_Heap = heap;
+        m_HeapOffset = heapOffset;
+
+        if (!m_Heap)
+            m_Counters->add(m_Category, m_Bytes);
+        m_Counters->link(this);
+    }
+
+    void TrackedMemory::set(MemoryCounters& counters, MemoryCategory category, uint64_t bytes)
+    {
+        const char* name = category == MemoryCategory::UploadChunks ? "NVRHI Upload Chunk"
+            : category == MemoryCategory::DescriptorHeaps ? "NVRHI Descriptor Heap"
+            : "NVRHI Internal Allocation";
+        const HeapType memoryType = category == MemoryCategory::UploadChunks ? HeapType::Upload : HeapType::DeviceLocal;
+        track(counters, category, bytes, nullptr, name, memoryType, nullptr, 0);
+    }
+
+    void TrackedMemory::set(MemoryCounters& counters, IBuffer* buffer, uint64_t bytes)
+    {
+        const BufferDesc& desc = buffer->getDesc();
+        track(counters, desc.isAccelStructStorage ? MemoryCategory::AccelStructs : MemoryCategory::Buffers, bytes, buffer,
+            desc.debugName.empty() ? utils::GenerateBufferDebugName(desc) : desc.debugName, GetMemoryType(desc.cpuAccess), nullptr, 0);
+    }
+
+    void TrackedMemory::set(MemoryCounters& counters, ITexture* texture, uint64_t bytes)
+    {
+        const TextureDesc& desc = texture->getDesc();
+        track(counters, MemoryCategory::Textures, bytes, texture,
+            desc.debugName.empty() ? utils::GenerateTextureDebugName(desc) : desc.debugName, HeapType::DeviceLocal, nullptr, 0);
+    }
+
+    void TrackedMemory::set(MemoryCounters& counters, IStagingTexture* texture, CpuAccessMode cpuAccess, uint64_t bytes)
+    {
+        const TextureDesc& desc = texture->getDesc();
+        track(counters, MemoryCategory::Textures, bytes, texture,
+            desc.debugName.empty() ? utils::GenerateTextureDebugName(desc) : desc.debugName, GetMemoryType(cpuAccess), nullptr, 0);
+    }
+
+    void TrackedMemory::set(MemoryCounters& counters, IHeap* heap)
+    {
+        const HeapDesc& desc = heap->getDesc();
+        track(counters, MemoryCategory::Heaps, desc.capacity, heap,
+            desc.debugName.empty() ? "Unnamed Heap (Capacity = " + std::to_string(desc.capacity) + ")" : desc.debugName,
+            desc.type, nullptr, 0);
+    }
+
+    void TrackedMemory::setPlaced(MemoryCounters& counters, IBuffer* buffer, uint64_t bytes, IHeap* heap, uint64_t heapOffset)
+    {
+        const BufferDesc& desc = buffer->getDesc();
+        track(counters, desc.isAccelStructStorage ? MemoryCategory::AccelStructs : MemoryCategory::Buffers, bytes, buffer,
+            desc.debugName.empty() ? utils::GenerateBufferDebugName(desc) : desc.debugName, heap->getDesc().type, heap, heapOffset);
+    }
+
+    void TrackedMemory::setPlaced(MemoryCounters& counters, ITexture* texture, uint64_t bytes, IHeap* heap, uint64_t heapOffset)
+    {
+        const TextureDesc& desc = texture->getDesc();
+        track(counters, MemoryCategory::Textures, bytes, texture,
+            desc.debugName.empty() ? utils::GenerateTextureDebugName(desc) : desc.debugName, heap->getDesc().type, heap, heapOffset);
+    }
+
+    void TrackedMemory::setCategory(MemoryCategory category)
+    {
+        if (m_Counters)
+        {
+            std::lock_guard lockGuard(m_Counters->m_AllocationsMutex);
+            if (!m_Heap)
+            {
+                m_Counters->remove(m_Category, m_Bytes);
+                m_Counters->add(category, m_Bytes);
+            }
+            m_Category = category;
+        }
+        else
+            m_Category = category;
+    }
+
+    void TrackedMemory::reset()
+    {
+        if (m_Counters)
+        {
+            m_Counters->unlink(this);
+            if (!m_Heap)
+                m_Counters->remove(m_Category, m_Bytes);
+        }
+        m_Counters = nullptr;
+        m_Bytes = 0;
+        m_Resource = nullptr;
+        m_Heap = nullptr;
+    }
+    void MemoryCounters::fillStatistics(MemoryStatistics& statistics) const
+    {
+        statistics.bufferBytes = m_Bytes[size_t(MemoryCategory::Buffers)].load(std::memory_order_relaxed);
+        statistics.textureBytes = m_Bytes[size_t(MemoryCategory::Textures)].load(std::memory_order_relaxed);
+        statistics.accelStructBytes = m_Bytes[size_t(MemoryCategory::AccelStructs)].load(std::memory_order_relaxed);
+        statistics.uploadChunkBytes = m_Bytes[size_t(MemoryCategory::UploadChunks)].load(std::memory_order_relaxed);
+        statistics.descriptorHeapBytes = m_Bytes[size_t(MemoryCategory::DescriptorHeaps)].load(std::memory_order_relaxed);
+        statistics.heapBytes = m_Bytes[size_t(MemoryCategory::Heaps)].load(std::memory_order_relaxed);
+    }
+
+    void MemoryBudgetMonitor::update(const MemoryStatistics& statistics, IMessageCallback* messageCallback)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (uint32_t heapIndex = 0; heapIndex < uint32_t(statistics.heaps.size()); heapIndex++)
+        {
+            const MemoryHeapStatistics& heap = statistics.heaps[heapIndex];
+            const bool exceeded = heap.budget != 0 && heap.usage > heap.budget;
+
+            if (exceeded && !m_BudgetExceeded[heapIndex] && messageCallback)
+                messageCallback->memoryBudgetExceeded(heapIndex, heap);
+
+            m_BudgetExceeded[heapIndex] = exceeded;
+        }
+    }
+
+} // namespace nvrhi
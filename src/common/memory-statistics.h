@@ -0,0 +1,134 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace nvrhi
+{
+    enum class MemoryCategory : uint8_t
+    {
+        Buffers,
+        Textures,
+        AccelStructs,
+        UploadChunks,
+        DescriptorHeaps,
+        Heaps,
+
+        Count
+    };
+
+    class TrackedMemory;
+
+    // Byte counts of the memory allocated by a backend, updated on resource creation and destruction from any thread.
+    // Also keeps the list of the live TrackedMemory objects for IDevice::enumerateResourceAllocations(...).
+    class MemoryCounters
+    {
+    public:
+        void add(MemoryCategory category, uint64_t bytes) { m_Bytes[size_t(category)].fetch_add(bytes, std::memory_order_relaxed); }
+        void remove(MemoryCategory category, uint64_t bytes) { m_Bytes[size_t(category)].fetch_sub(bytes, std::memory_order_relaxed); }
+
+        void fillStatistics(MemoryStatistics& statistics) const;
+        void enumerateAllocations(IResourceAllocationCallback& callback);
+
+    private:
+        friend class TrackedMemory;
+
+        std::atomic<uint64_t> m_Bytes[size_t(MemoryCategory::Count)] {};
+
+        std::mutex m_AllocationsMutex;
+        TrackedMemory* m_FirstAllocation = nullptr;
+        TrackedMemory* m_LastAllocation = nullptr;
+
+        void link(TrackedMemory* allocation);
+        void unlink(TrackedMemory* allocation);
+    };
+
+    // Keeps an allocation counted in MemoryCounters and listed in its registry for the lifetime of the owning object.
+    // The overloads that take a resource record its name and memory type once, so that enumerating is cheap.
+    class TrackedMemory
+    {
+    public:
+        TrackedMemory() = default;
+        ~TrackedMemory() { reset(); }
+
+        TrackedMemory(const TrackedMemory&) = delete;
+        TrackedMemory& operator=(const TrackedMemory&) = delete;
+
+        // Internal allocations that don't belong to an API object, such as upload chunks
+        void set(MemoryCounters& counters, MemoryCategory category, uint64_t bytes);
+
+        // Committed resources, the buffer category is picked from the buffer's description
+        void set(MemoryCounters& counters, IBuffer* buffer, uint64_t bytes);
+        void set(MemoryCounters& counters, ITexture* texture, uint64_t bytes);
+        void set(MemoryCounters& counters, IStagingTexture* texture, CpuAccessMode cpuAccess, uint64_t bytes);
+        void set(MemoryCounters& counters, IHeap* heap);
+
+        // Resources placed into a heap are listed, but not counted, because the heap is counted already
+        void setPlaced(MemoryCounters& counters, IBuffer* buffer, uint64_t bytes, IHeap* heap, uint64_t heapOffset);
+        void setPlaced(MemoryCounters& counters, ITexture* texture, uint64_t bytes, IHeap* heap, uint64_t heapOffset);
+
+        // Moves the allocation into a different category, for resources that are created through the generic paths
+        void setCategory(MemoryCategory category);
+
+        void reset();
+
+        [[nodiscard]] uint64_t getBytes() const { return m_Bytes; }
+
+    private:
+        friend class MemoryCounters;
+
+        MemoryCounters* m_Counters = nullptr;
+        MemoryCategory m_Category = MemoryCategory::Buffers;
+        uint64_t m_Bytes = 0;
+
+        IResource* m_Resource = nullptr;
+        std::string m_DebugName;
+        HeapType m_MemoryType = HeapType::DeviceLocal;
+        IHeap* m_Heap = nullptr;
+        uint64_t m_HeapOffset = 0;
+
+        // Links for the registry in MemoryCounters, protected by its mutex
+        TrackedMemory* m_Prev = nullptr;
+        TrackedMemory* m_Next = nullptr;
+
+        void track(MemoryCounters& counters, MemoryCategory category, uint64_t bytes, IResource* resource,
+            std::string debugName, HeapType memoryType, IHeap* heap, uint64_t heapOffset);
+    };
+
+    // Calls IMessageCallback::memoryBudgetExceeded when a heap goes over its budget, once until it's back within the budget.
+    class MemoryBudgetMonitor
+    {
+    public:
+        void update(const MemoryStatistics& statistics, IMessageCallback* messageCallback);
+
+    private:
+        std::mutex m_Mutex;
+        bool m_BudgetExceeded[c_MaxMemoryHeaps] = {};
+    };
+
+} // namespace nvrhi
@@ -206,6 +206,24 @@ namespace nvrhi
                 nvrhi::ResourceStates::ShadingRateSurface);
         }
     }
+
+    void ICommandList::setResourceStatesForRenderPassScope(const RenderPassScope& scope)
+    {
+        for (IBindingSet* bindingSet : scope.bindingSets)
+            setResourceStatesForBindingSet(bindingSet);
+
+        for (IBuffer* buffer : scope.vertexBuffers)
+            setBufferState(buffer, ResourceStates::VertexBuffer);
+
+        for (IBuffer* buffer : scope.indexBuffers)
+            setBufferState(buffer, ResourceStates::IndexBuffer);
+
+        for (IBuffer* buffer : scope.indirectBuffers)
+            setBufferState(buffer, ResourceStates::IndirectArgument);
+
+        if (scope.framebuffer)
+            setResourceStatesForFramebuffer(scope.framebuffer);
+    }
     
     size_t coopvec::getDataTypeSize(coopvec::DataType type)
     {
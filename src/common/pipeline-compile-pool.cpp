@@ -0,0 +1,179 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "pipeline-compile-pool.h"
+
+namespace nvrhi
+{
+    void PendingPipeline::markReady()
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_Ready.store(true);
+        }
+        m_Condition.notify_all();
+    }
+
+    void PendingPipeline::wait()
+    {
+        if (m_Ready.load())
+            return;
+
+        std::unique_lock lock(m_Mutex);
+        m_Condition.wait(lock, [this]() { return m_Ready.load(); });
+    }
+
+    PipelineCompilePool::PipelineCompilePool(uint32_t numThreads)
+        : m_NumThreads(numThreads)
+    {
+        if (m_NumThreads == 0)
+        {
+            // Leave the other half of the cores to the render and game threads
+            m_NumThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+        }
+    }
+
+    PipelineCompilePool::~PipelineCompilePool()
+    {
+        shutdown();
+    }
+
+    PendingPipelineHandle PipelineCompilePool::enqueue(Task task)
+    {
+        RefCountPtr<PendingPipeline> pipeline = RefCountPtr<PendingPipeline>::Create(new PendingPipeline());
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (m_Terminate)
+            {
+                pipeline->markReady();
+                return pipeline;
+            }
+
+            if (m_Threads.empty())
+            {
+                m_Threads.reserve(m_NumThreads);
+                for (uint32_t i = 0; i < m_NumThreads; i++)
+                    m_Threads.emplace_back(&PipelineCompilePool::workerThreadProc, this);
+            }
+
+            m_Queue.push({ pipeline, std::move(task) });
+        }
+
+        m_Condition.notify_one();
+
+        return pipeline;
+    }
+
+    void PipelineCompilePool::shutdown()
+    {
+        std::queue<QueueItem> abandonedItems;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_Terminate = true;
+            std::swap(abandonedItems, m_Queue);
+        }
+
+        m_Condition.notify_all();
+
+        for (auto& thread : m_Threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+        m_Threads.clear();
+
+        // Anyone waiting on the pipelines that never got to run should not hang
+        while (!abandonedItems.empty())
+        {
+            abandonedItems.front().pipeline->markReady();
+            abandonedItems.pop();
+        }
+    }
+
+    void PipelineCompilePool::workerThreadProc()
+    {
+        while (true)
+        {
+            QueueItem item;
+
+            {
+                std::unique_lock lock(m_Mutex);
+                m_Condition.wait(lock, [this]() { return m_Terminate || !m_Queue.empty(); });
+
+                if (m_Terminate)
+                    return;
+
+                item = std::move(m_Queue.front());
+                m_Queue.pop();
+            }
+
+            item.task(*item.pipeline);
+            item.pipeline->markReady();
+        }
+    }
+
+    PendingPipelineHandle PipelineCompilePool::createGraphicsPipeline(IDevice* device, const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo)
+    {
+        return enqueue([device, desc, fbinfo](PendingPipeline& pipeline)
+        {
+            pipeline.graphicsPipeline = device->createGraphicsPipeline(desc, fbinfo);
+        });
+    }
+
+    PendingPipelineHandle PipelineCompilePool::createComputePipeline(IDevice* device, const ComputePipelineDesc& desc)
+    {
+        return enqueue([device, desc](PendingPipeline& pipeline)
+        {
+            pipeline.computePipeline = device->createComputePipeline(desc);
+        });
+    }
+
+    PendingPipelineHandle PipelineCompilePool::createMeshletPipeline(IDevice* device, const MeshletPipelineDesc& desc, const FramebufferInfo& fbinfo)
+    {
+        return enqueue([device, desc, fbinfo](PendingPipeline& pipeline)
+        {
+            pipeline.meshletPipeline = device->createMeshletPipeline(desc, fbinfo);
+        });
+    }
+
+    PendingPipelineHandle PipelineCompilePool::createRayTracingPipeline(IDevice* device, const rt::PipelineDesc& desc)
+    {
+        return enqueue([device, desc](PendingPipeline& pipeline)
+        {
+            pipeline.rayTracingPipeline = device->createRayTracingPipeline(desc);
+        });
+    }
+
+    PendingPipelineHandle PipelineCompilePool::addToRayTracingPipeline(IDevice* device, rt::IPipeline* pipeline, const rt::PipelineDesc& additions)
+    {
+        rt::PipelineHandle basePipeline = pipeline;
+        return enqueue([device, basePipeline, additions](PendingPipeline& pendingPipeline)
+        {
+            pendingPipeline.rayTracingPipeline = device->addToRayTracingPipeline(basePipeline, additions);
+        });
+    }
+
+} // namespace nvrhi
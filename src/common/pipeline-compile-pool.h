@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace nvrhi
+{
+    class PendingPipeline : public RefCounter<IPendingPipeline>
+    {
+    public:
+        GraphicsPipelineHandle graphicsPipeline;
+        ComputePipelineHandle computePipeline;
+        MeshletPipelineHandle meshletPipeline;
+        rt::PipelineHandle rayTracingPipeline;
+
+        // Called by the compile thread after it has stored one of the pipelines above
+        void markReady();
+
+        bool isReady() override { return m_Ready.load(); }
+        void wait() override;
+        IGraphicsPipeline* getGraphicsPipeline() override { return isReady() ? graphicsPipeline.Get() : nullptr; }
+        IComputePipeline* getComputePipeline() override { return isReady() ? computePipeline.Get() : nullptr; }
+        IMeshletPipeline* getMeshletPipeline() override { return isReady() ? meshletPipeline.Get() : nullptr; }
+        rt::IPipeline* getRayTracingPipeline() override { return isReady() ? rayTracingPipeline.Get() : nullptr; }
+
+    private:
+        std::atomic<bool> m_Ready = false;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+    };
+
+    // A set of worker threads that run pipeline creation tasks for the create...PipelineAsync functions.
+    // The threads are only started when the first task is enqueued.
+    class PipelineCompilePool
+    {
+    public:
+        typedef std::function<void(PendingPipeline&)> Task;
+
+        // numThreads == 0 picks a number based on the CPU core count
+        explicit PipelineCompilePool(uint32_t numThreads = 0);
+        ~PipelineCompilePool();
+
+        PendingPipelineHandle enqueue(Task task);
+
+        // Waits for the tasks that are currently running, and completes the queued tasks without running them.
+        // Must be called by the device before it starts destroying the objects that the tasks might use.
+        void shutdown();
+
+        // Convenience functions that route the creation to the given device's synchronous create functions
+        PendingPipelineHandle createGraphicsPipeline(IDevice* device, const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo);
+        PendingPipelineHandle createComputePipeline(IDevice* device, const ComputePipelineDesc& desc);
+        PendingPipelineHandle createMeshletPipeline(IDevice* device, const MeshletPipelineDesc& desc, const FramebufferInfo& fbinfo);
+        PendingPipelineHandle createRayTracingPipeline(IDevice* device, const rt::PipelineDesc& desc);
+        PendingPipelineHandle addToRayTracingPipeline(IDevice* device, rt::IPipeline* pipeline, const rt::PipelineDesc& additions);
+
+    private:
+        struct QueueItem
+        {
+            RefCountPtr<PendingPipeline> pipeline;
+            Task task;
+        };
+
+        uint32_t m_NumThreads;
+        std::vector<std::thread> m_Threads;
+        std::queue<QueueItem> m_Queue;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Terminate = false;
+
+        void workerThreadProc();
+    };
+
+} // namespace nvrhi
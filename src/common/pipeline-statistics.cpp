@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pipeline-statistics.h"
+#include <algorithm>
+
+namespace nvrhi
+{
+    void PipelineCreationCounters::add(const PipelineCreationInfo& info)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (info.pipeline)
+            ++m_Statistics.createdPipelines;
+        else
+            ++m_Statistics.failedPipelines;
+
+        if (info.cacheResult == PipelineCacheResult::Hit)
+            ++m_Statistics.cacheHits;
+        else if (info.cacheResult == PipelineCacheResult::Miss)
+            ++m_Statistics.cacheMisses;
+
+        m_Statistics.totalMilliseconds += double(info.cpuMilliseconds);
+        m_Statistics.maxMilliseconds = std::max(m_Statistics.maxMilliseconds, info.cpuMilliseconds);
+    }
+
+    PipelineCreationStatistics PipelineCreationCounters::get() const
+    {
+        std::lock_guard lockGuard(m_Mutex);
+        return m_Statistics;
+    }
+
+    void PipelineCreationCounters::reset()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+        m_Statistics = PipelineCreationStatistics();
+    }
+
+    static const char* GetShaderName(IShader* shader)
+    {
+        return shader ? shader->getDesc().debugName.c_str() : "";
+    }
+
+    const char* GetPipelineShaderName(const GraphicsPipelineDesc& desc)
+    {
+        return GetShaderName(desc.VS);
+    }
+
+    const char* GetPipelineShaderName(const ComputePipelineDesc& desc)
+    {
+        return GetShaderName(desc.CS);
+    }
+
+    const char* GetPipelineShaderName(const MeshletPipelineDesc& desc)
+    {
+        return GetShaderName(desc.MS);
+    }
+
+    const char* GetPipelineShaderName(const rt::PipelineDesc& desc)
+    {
+        return desc.shaders.empty() ? "" : GetShaderName(desc.shaders[0].shader);
+    }
+
+    PipelineCreationScope::~PipelineCreationScope()
+    {
+        const auto duration = std::chrono::steady_clock::now() - m_StartTime;
+        m_Info.cpuMilliseconds = std::chrono::duration<float, std::milli>(duration).count();
+
+        m_Counters.add(m_Info);
+
+        if (m_Callback)
+        {
+            m_Callback->endZone(getZone());
+            m_Callback->pipelineCreated(m_Info);
+        }
+    }
+
+    InstrumentationZone PipelineCreationScope::getZone() const
+    {
+        switch (m_Info.type)
+        {
+        case PipelineType::Compute: return InstrumentationZone::CreateComputePipeline;
+        case PipelineType::Meshlet: return InstrumentationZone::CreateMeshletPipeline;
+        case PipelineType::RayTracing: return InstrumentationZone::CreateRayTracingPipeline;
+        case PipelineType::Graphics:
+        default: return InstrumentationZone::CreateGraphicsPipeline;
+        }
+    }
+
+} // namespace nvrhi
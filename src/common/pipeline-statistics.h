@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "instrumentation.h"
+#include <chrono>
+#include <mutex>
+
+namespace nvrhi
+{
+    // Totals of the pipeline creations of a backend, updated from any thread that creates pipelines.
+    class PipelineCreationCounters
+    {
+    public:
+        void add(const PipelineCreationInfo& info);
+        [[nodiscard]] PipelineCreationStatistics get() const;
+        void reset();
+
+    private:
+        mutable std::mutex m_Mutex;
+        PipelineCreationStatistics m_Statistics;
+    };
+
+    [[nodiscard]] const char* GetPipelineShaderName(const GraphicsPipelineDesc& desc);
+    [[nodiscard]] const char* GetPipelineShaderName(const ComputePipelineDesc& desc);
+    [[nodiscard]] const char* GetPipelineShaderName(const MeshletPipelineDesc& desc);
+    [[nodiscard]] const char* GetPipelineShaderName(const rt::PipelineDesc& desc);
+
+    // Times a pipeline creation for the lifetime of the object: reports the creation zone, adds the creation to
+    // the counters and, if set, calls IInstrumentationCallback::pipelineCreated with the pipeline passed to
+    // setPipeline. A pipeline that is never set is counted as a failed creation.
+    class PipelineCreationScope
+    {
+    public:
+        template<typename PipelineDesc>
+        PipelineCreationScope(const InstrumentationHook& hook, PipelineCreationCounters& counters, PipelineType type, const PipelineDesc& desc)
+            : m_Callback(hook.get())
+            , m_Counters(counters)
+            , m_StartTime(std::chrono::steady_clock::now())
+        {
+            m_Info.type = type;
+            if (m_Callback)
+            {
+                m_Info.shaderName = GetPipelineShaderName(desc);
+                m_Callback->beginZone(getZone());
+            }
+        }
+
+        ~PipelineCreationScope();
+
+        PipelineCreationScope(const PipelineCreationScope&) = delete;
+        PipelineCreationScope& operator=(const PipelineCreationScope&) = delete;
+
+        void setPipeline(IResource* pipeline) { m_Info.pipeline = pipeline; }
+        void setCacheResult(PipelineCacheResult result) { m_Info.cacheResult = result; }
+
+    private:
+        IInstrumentationCallback* m_Callback;
+        PipelineCreationCounters& m_Counters;
+        std::chrono::steady_clock::time_point m_StartTime;
+        PipelineCreationInfo m_Info;
+
+        [[nodiscard]] InstrumentationZone getZone() const;
+    };
+
+} // namespace nvrhi
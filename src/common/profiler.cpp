@@ -0,0 +1,368 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/profiler.h>
+#include <nvrhi/utils.h>
+
+#include <mutex>
+#include <sstream>
+
+namespace nvrhi::profiler
+{
+    // Query layout of each frame slot: the frame begin and end timestamps, then a begin/end pair per scope
+    static constexpr uint32_t c_FrameBeginQuery = 0;
+    static constexpr uint32_t c_FrameEndQuery = 1;
+    static constexpr uint32_t c_FirstScopeQuery = 2;
+
+    class GpuProfiler : public RefCounter<IGpuProfiler>
+    {
+    public:
+        GpuProfiler(IDevice* device, const GpuProfilerDesc& desc, ITimestampQueryPool* pool);
+
+        uint64_t beginFrame(ICommandList* commandList) override;
+        void beginScope(ICommandList* commandList, const char* name) override;
+        void endScope(ICommandList* commandList) override;
+        void endFrame(ICommandList* commandList) override;
+        void markSubmitted() override;
+        bool getLatestFrame(GpuProfilerFrame& outFrame) override;
+
+    private:
+        enum class FrameState : uint8_t
+        {
+            Free,
+            Recording,
+            Recorded,
+            Submitted
+        };
+
+        struct ScopeRecord
+        {
+            std::string name;
+            uint32_t depth = 0;
+            uint32_t parentIndex = GpuProfilerScope::c_NoParent;
+        };
+
+        struct FrameSlot
+        {
+            uint64_t frameIndex = 0;
+            FrameState state = FrameState::Free;
+            uint32_t firstQuery = 0;
+            std::vector<ScopeRecord> scopes;
+            EventQueryHandle query;
+        };
+
+        // Marks a scope on the stack that is not timed: it's outside of a profiled frame, or over the scope limit
+        static constexpr uint32_t c_UntimedScope = ~0u;
+
+        DeviceHandle m_Device;
+        GpuProfilerDesc m_Desc;
+        TimestampQueryPoolHandle m_Pool;
+        double m_SecondsPerTick = 0.0;
+
+        std::mutex m_Mutex;
+        std::vector<FrameSlot> m_Slots;
+        FrameSlot* m_CurrentSlot = nullptr;
+        bool m_InFrame = false;
+        std::vector<uint32_t> m_ScopeStack;
+        uint64_t m_NextFrameIndex = 0;
+
+        GpuProfilerFrame m_LatestFrame;
+        bool m_HasNewFrame = false;
+        std::vector<uint64_t> m_Timestamps;
+
+        void error(const std::string& message) const;
+        void collectFinishedFrames();
+        void readFrameResults(const FrameSlot& slot);
+        [[nodiscard]] uint32_t getScopeQuery(uint32_t scopeIndex, bool end) const;
+        void closeScope(ICommandList* commandList);
+    };
+
+    GpuProfiler::GpuProfiler(IDevice* device, const GpuProfilerDesc& desc, ITimestampQueryPool* pool)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_Pool(pool)
+    {
+        const uint64_t frequency = device->getTimestampFrequency(desc.queue);
+        m_SecondsPerTick = frequency ? 1.0 / double(frequency) : 0.0;
+
+        const uint32_t queriesPerFrame = c_FirstScopeQuery + desc.maxScopesPerFrame * 2;
+
+        m_Slots.resize(desc.maxFramesInFlight);
+        for (uint32_t index = 0; index < desc.maxFramesInFlight; ++index)
+        {
+            m_Slots[index].firstQuery = index * queriesPerFrame;
+            m_Slots[index].scopes.reserve(desc.maxScopesPerFrame);
+        }
+
+        m_Timestamps.resize(queriesPerFrame);
+    }
+
+    void GpuProfiler::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    uint32_t GpuProfiler::getScopeQuery(uint32_t scopeIndex, bool end) const
+    {
+        return m_CurrentSlot->firstQuery + c_FirstScopeQuery + scopeIndex * 2 + (end ? 1 : 0);
+    }
+
+    void GpuProfiler::collectFinishedFrames()
+    {
+        // Only the newest finished frame is read back, older ones are just recycled
+        FrameSlot* newest = nullptr;
+        for (FrameSlot& slot : m_Slots)
+        {
+            if (slot.state != FrameState::Submitted || !m_Device->pollEventQuery(slot.query))
+                continue;
+
+            slot.state = FrameState::Free;
+
+            if (!newest || slot.frameIndex > newest->frameIndex)
+                newest = &slot;
+        }
+
+        // The slot is free now, but its timestamps are only overwritten by the next beginFrame
+        if (newest)
+            readFrameResults(*newest);
+    }
+
+    void GpuProfiler::readFrameResults(const FrameSlot& slot)
+    {
+        if (m_HasNewFrame && m_LatestFrame.frameIndex > slot.frameIndex)
+            return;
+
+        const uint32_t queryCount = c_FirstScopeQuery + uint32_t(slot.scopes.size()) * 2;
+        if (!m_Device->getTimestampResults(m_Pool, slot.firstQuery, queryCount, m_Timestamps.data()))
+            return;
+
+        // Timestamps from different command lists on one queue are comparable, but not necessarily monotonic
+        const uint64_t frameBegin = m_Timestamps[c_FrameBeginQuery];
+        auto toSeconds = [this, frameBegin](uint64_t timestamp)
+        {
+            return double(int64_t(timestamp - frameBegin)) * m_SecondsPerTick;
+        };
+
+        m_LatestFrame.frameIndex = slot.frameIndex;
+        m_LatestFrame.frameTime = toSeconds(m_Timestamps[c_FrameEndQuery]);
+        m_LatestFrame.scopes.resize(slot.scopes.size());
+
+        for (size_t index = 0; index < slot.scopes.size(); ++index)
+        {
+            const ScopeRecord& record = slot.scopes[index];
+            GpuProfilerScope& scope = m_LatestFrame.scopes[index];
+
+            scope.name = record.name;
+            scope.depth = record.depth;
+            scope.parentIndex = record.parentIndex;
+            scope.beginTime = toSeconds(m_Timestamps[c_FirstScopeQuery + index * 2]);
+            scope.endTime = toSeconds(m_Timestamps[c_FirstScopeQuery + index * 2 + 1]);
+        }
+
+        m_HasNewFrame = true;
+    }
+
+    uint64_t GpuProfiler::beginFrame(ICommandList* commandList)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_InFrame)
+        {
+            error("GpuProfiler::beginFrame: the previous frame has not been ended with endFrame");
+            return m_NextFrameIndex - 1;
+        }
+
+        collectFinishedFrames();
+
+        const uint64_t frameIndex = m_NextFrameIndex++;
+        m_InFrame = true;
+        m_CurrentSlot = nullptr;
+
+        for (FrameSlot& slot : m_Slots)
+        {
+            if (slot.state == FrameState::Free)
+            {
+                m_CurrentSlot = &slot;
+                break;
+            }
+        }
+
+        // All slots are in flight: the frame is not profiled rather than waiting for the GPU
+        if (!m_CurrentSlot)
+            return frameIndex;
+
+        m_CurrentSlot->frameIndex = frameIndex;
+        m_CurrentSlot->state = FrameState::Recording;
+        m_CurrentSlot->scopes.clear();
+
+        commandList->resetTimestamps(m_Pool, m_CurrentSlot->firstQuery, uint32_t(m_Timestamps.size()));
+        commandList->writeTimestamp(m_Pool, m_CurrentSlot->firstQuery + c_FrameBeginQuery);
+
+        return frameIndex;
+    }
+
+    void GpuProfiler::beginScope(ICommandList* commandList, const char* name)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_Desc.emitMarkers)
+            commandList->beginMarker(name);
+
+        if (!m_CurrentSlot || m_CurrentSlot->scopes.size() >= m_Desc.maxScopesPerFrame)
+        {
+            m_ScopeStack.push_back(c_UntimedScope);
+            return;
+        }
+
+        const uint32_t scopeIndex = uint32_t(m_CurrentSlot->scopes.size());
+        const uint32_t parentIndex = m_ScopeStack.empty() ? c_UntimedScope : m_ScopeStack.back();
+
+        // Scopes opened before beginFrame are not part of the frame's tree
+        ScopeRecord& record = m_CurrentSlot->scopes.emplace_back();
+        record.name = name ? name : "";
+        record.parentIndex = parentIndex == c_UntimedScope ? GpuProfilerScope::c_NoParent : parentIndex;
+        record.depth = record.parentIndex == GpuProfilerScope::c_NoParent ? 0 : m_CurrentSlot->scopes[parentIndex].depth + 1;
+
+        commandList->writeTimestamp(m_Pool, getScopeQuery(scopeIndex, false));
+
+        m_ScopeStack.push_back(scopeIndex);
+    }
+
+    void GpuProfiler::closeScope(ICommandList* commandList)
+    {
+        const uint32_t scopeIndex = m_ScopeStack.back();
+        m_ScopeStack.pop_back();
+
+        if (scopeIndex != c_UntimedScope && m_CurrentSlot)
+            commandList->writeTimestamp(m_Pool, getScopeQuery(scopeIndex, true));
+
+        if (m_Desc.emitMarkers)
+            commandList->endMarker();
+    }
+
+    void GpuProfiler::endScope(ICommandList* commandList)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_ScopeStack.empty())
+        {
+            error("GpuProfiler::endScope: no scope is open");
+            return;
+        }
+
+        closeScope(commandList);
+    }
+
+    void GpuProfiler::endFrame(ICommandList* commandList)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_InFrame)
+        {
+            error("GpuProfiler::endFrame: no frame has been started with beginFrame");
+            return;
+        }
+
+        if (!m_ScopeStack.empty())
+        {
+            std::stringstream ss;
+            ss << "GpuProfiler " << utils::DebugNameToString(m_Desc.debugName) << ": " << m_ScopeStack.size()
+                << " scope(s) are still open at the end of the frame";
+            error(ss.str());
+
+            while (!m_ScopeStack.empty())
+                closeScope(commandList);
+        }
+
+        if (m_CurrentSlot)
+        {
+            commandList->writeTimestamp(m_Pool, m_CurrentSlot->firstQuery + c_FrameEndQuery);
+
+            const uint32_t queryCount = c_FirstScopeQuery + uint32_t(m_CurrentSlot->scopes.size()) * 2;
+            commandList->resolveTimestamps(m_Pool, m_CurrentSlot->firstQuery, queryCount);
+
+            m_CurrentSlot->state = FrameState::Recorded;
+            m_CurrentSlot = nullptr;
+        }
+
+        m_InFrame = false;
+    }
+
+    void GpuProfiler::markSubmitted()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (FrameSlot& slot : m_Slots)
+        {
+            if (slot.state != FrameState::Recorded)
+                continue;
+
+            if (slot.query)
+                m_Device->resetEventQuery(slot.query);
+            else
+                slot.query = m_Device->createEventQuery();
+
+            m_Device->setEventQuery(slot.query, m_Desc.queue);
+            slot.state = FrameState::Submitted;
+        }
+    }
+
+    bool GpuProfiler::getLatestFrame(GpuProfilerFrame& outFrame)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        collectFinishedFrames();
+
+        if (!m_HasNewFrame)
+            return false;
+
+        outFrame = m_LatestFrame;
+        m_HasNewFrame = false;
+        return true;
+    }
+
+    GpuProfilerHandle createGpuProfiler(IDevice* device, const GpuProfilerDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        if (desc.maxFramesInFlight == 0 || desc.maxScopesPerFrame == 0)
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createGpuProfiler: maxFramesInFlight and maxScopesPerFrame must be positive");
+            return nullptr;
+        }
+
+        const uint32_t queriesPerFrame = c_FirstScopeQuery + desc.maxScopesPerFrame * 2;
+
+        TimestampQueryPoolHandle pool = device->createTimestampQueryPool(TimestampQueryPoolDesc()
+            .setQueryCount(queriesPerFrame * desc.maxFramesInFlight)
+            .setDebugName(desc.debugName));
+
+        if (!pool)
+            return nullptr;
+
+        GpuProfiler* profiler = new GpuProfiler(device, desc, pool);
+        return GpuProfilerHandle::Create(profiler);
+    }
+}
@@ -0,0 +1,309 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/readback.h>
+#include <nvrhi/utils.h>
+
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi::readback
+{
+    class ReadbackRing : public RefCounter<IReadbackRing>
+    {
+    public:
+        ReadbackRing(IDevice* device, const ReadbackRingDesc& desc);
+
+        ReadbackTicket copyBuffer(ICommandList* commandList, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSize) override;
+        ReadbackTicket copyTexture(ICommandList* commandList, ITexture* src, const TextureSlice& srcSlice) override;
+        void markSubmitted() override;
+        bool isReady(ReadbackTicket ticket) override;
+        const void* tryMap(ReadbackTicket ticket, size_t* outRowPitch) override;
+        void unmap(ReadbackTicket ticket) override;
+
+    private:
+        enum class SlotState : uint8_t
+        {
+            Free,
+            Recorded,
+            Submitted,
+            Ready
+        };
+
+        struct Slot
+        {
+            BufferHandle buffer;
+            StagingTextureHandle texture;
+            EventQueryHandle query;
+            ReadbackTicket ticket = c_InvalidReadbackTicket;
+            SlotState state = SlotState::Free;
+            bool mapped = false;
+
+            // Size of the data read back into the buffer, or the region of the staging texture
+            uint64_t dataSize = 0;
+            TextureSlice textureSlice;
+        };
+
+        DeviceHandle m_Device;
+        ReadbackRingDesc m_Desc;
+
+        std::mutex m_Mutex;
+        std::vector<Slot> m_Slots;
+        ReadbackTicket m_LastTicket = c_InvalidReadbackTicket;
+
+        void error(const std::string& message) const;
+        bool pollSlot(Slot& slot) const;
+        Slot* allocateSlot();
+        Slot* findSlot(ReadbackTicket ticket);
+    };
+
+    ReadbackRing::ReadbackRing(IDevice* device, const ReadbackRingDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+        m_Slots.resize(std::max(desc.numSlots, 1u));
+    }
+
+    void ReadbackRing::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    bool ReadbackRing::pollSlot(Slot& slot) const
+    {
+        if (slot.state == SlotState::Submitted && m_Device->pollEventQuery(slot.query))
+            slot.state = SlotState::Ready;
+
+        return slot.state == SlotState::Ready;
+    }
+
+    ReadbackRing::Slot* ReadbackRing::allocateSlot()
+    {
+        // Reuse the slot with the oldest finished or never used readback, so that recent results stay available
+        Slot* oldest = nullptr;
+        for (Slot& slot : m_Slots)
+        {
+            if (slot.mapped)
+                continue;
+
+            if (slot.state != SlotState::Free && !pollSlot(slot))
+                continue;
+
+            if (!oldest || slot.ticket < oldest->ticket)
+                oldest = &slot;
+        }
+
+        return oldest;
+    }
+
+    ReadbackRing::Slot* ReadbackRing::findSlot(ReadbackTicket ticket)
+    {
+        if (ticket == c_InvalidReadbackTicket)
+            return nullptr;
+
+        for (Slot& slot : m_Slots)
+        {
+            if (slot.ticket == ticket)
+                return &slot;
+        }
+
+        return nullptr;
+    }
+
+    ReadbackTicket ReadbackRing::copyBuffer(ICommandList* commandList, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSize)
+    {
+        if (!commandList || !src || dataSize == 0 || dataSize > m_Desc.bufferSize)
+        {
+            std::stringstream ss;
+            ss << "ReadbackRing " << utils::DebugNameToString(m_Desc.debugName) << ": cannot read back " << dataSize
+                << " bytes with staging buffers of " << m_Desc.bufferSize << " bytes";
+            error(ss.str());
+            return c_InvalidReadbackTicket;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        Slot* slot = allocateSlot();
+        if (!slot)
+            return c_InvalidReadbackTicket;
+
+        if (!slot->buffer)
+        {
+            slot->buffer = m_Device->createBuffer(BufferDesc()
+                .setByteSize(m_Desc.bufferSize)
+                .setCpuAccess(CpuAccessMode::Read)
+                .setInitialState(ResourceStates::CopyDest)
+                .setKeepInitialState(true)
+                .setDebugName(m_Desc.debugName));
+
+            if (!slot->buffer)
+                return c_InvalidReadbackTicket;
+        }
+
+        commandList->copyBuffer(slot->buffer, 0, src, srcOffsetBytes, dataSize);
+
+        slot->ticket = ++m_LastTicket;
+        slot->state = SlotState::Recorded;
+        slot->dataSize = dataSize;
+        return slot->ticket;
+    }
+
+    ReadbackTicket ReadbackRing::copyTexture(ICommandList* commandList, ITexture* src, const TextureSlice& srcSlice)
+    {
+        if (!commandList || !src || m_Desc.textureDesc.format == Format::UNKNOWN)
+        {
+            std::stringstream ss;
+            ss << "ReadbackRing " << utils::DebugNameToString(m_Desc.debugName) << ": texture readbacks need a command list, "
+                "a source texture, and ReadbackRingDesc::textureDesc";
+            error(ss.str());
+            return c_InvalidReadbackTicket;
+        }
+
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->getDesc());
+        if (resolvedSrcSlice.width > m_Desc.textureDesc.width || resolvedSrcSlice.height > m_Desc.textureDesc.height ||
+            resolvedSrcSlice.depth > m_Desc.textureDesc.depth)
+        {
+            std::stringstream ss;
+            ss << "ReadbackRing " << utils::DebugNameToString(m_Desc.debugName) << ": the region of texture "
+                << utils::DebugNameToString(src->getDesc().debugName) << " is larger than the staging textures";
+            error(ss.str());
+            return c_InvalidReadbackTicket;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        Slot* slot = allocateSlot();
+        if (!slot)
+            return c_InvalidReadbackTicket;
+
+        if (!slot->texture)
+        {
+            TextureDesc textureDesc = m_Desc.textureDesc;
+            if (textureDesc.debugName.empty())
+                textureDesc.debugName = m_Desc.debugName;
+
+            slot->texture = m_Device->createStagingTexture(textureDesc, CpuAccessMode::Read);
+
+            if (!slot->texture)
+                return c_InvalidReadbackTicket;
+        }
+
+        slot->textureSlice = TextureSlice()
+            .setSize(resolvedSrcSlice.width, resolvedSrcSlice.height, resolvedSrcSlice.depth);
+
+        commandList->copyTexture(slot->texture, slot->textureSlice, src, resolvedSrcSlice);
+
+        slot->ticket = ++m_LastTicket;
+        slot->state = SlotState::Recorded;
+        slot->dataSize = 0;
+        return slot->ticket;
+    }
+
+    void ReadbackRing::markSubmitted()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (Slot& slot : m_Slots)
+        {
+            if (slot.state != SlotState::Recorded)
+                continue;
+
+            if (slot.query)
+                m_Device->resetEventQuery(slot.query);
+            else
+                slot.query = m_Device->createEventQuery();
+
+            m_Device->setEventQuery(slot.query, m_Desc.queue);
+            slot.state = SlotState::Submitted;
+        }
+    }
+
+    bool ReadbackRing::isReady(ReadbackTicket ticket)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        Slot* slot = findSlot(ticket);
+        return slot && pollSlot(*slot);
+    }
+
+    const void* ReadbackRing::tryMap(ReadbackTicket ticket, size_t* outRowPitch)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        Slot* slot = findSlot(ticket);
+        if (!slot || slot->mapped || !pollSlot(*slot))
+            return nullptr;
+
+        // The copy has finished, so the map calls don't wait for the GPU
+        const void* data = nullptr;
+        if (slot->buffer && slot->dataSize != 0)
+        {
+            data = m_Device->mapBuffer(slot->buffer, CpuAccessMode::Read, 0, size_t(slot->dataSize));
+            if (outRowPitch)
+                *outRowPitch = size_t(slot->dataSize);
+        }
+        else if (slot->texture)
+        {
+            size_t rowPitch = 0;
+            data = m_Device->mapStagingTexture(slot->texture, slot->textureSlice, CpuAccessMode::Read, &rowPitch);
+            if (outRowPitch)
+                *outRowPitch = rowPitch;
+        }
+
+        slot->mapped = data != nullptr;
+        return data;
+    }
+
+    void ReadbackRing::unmap(ReadbackTicket ticket)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        Slot* slot = findSlot(ticket);
+        if (!slot || !slot->mapped)
+            return;
+
+        if (slot->dataSize != 0)
+            m_Device->unmapBuffer(slot->buffer);
+        else
+            m_Device->unmapStagingTexture(slot->texture);
+
+        slot->mapped = false;
+    }
+
+    ReadbackRingHandle createReadbackRing(IDevice* device, const ReadbackRingDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        if (desc.bufferSize == 0 && desc.textureDesc.format == Format::UNKNOWN)
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createReadbackRing: either bufferSize or textureDesc must be specified");
+            return nullptr;
+        }
+
+        ReadbackRing* ring = new ReadbackRing(device, desc);
+        return ReadbackRingHandle::Create(ring);
+    }
+}
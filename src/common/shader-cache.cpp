@@ -0,0 +1,178 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "shader-cache.h"
+#include <nvrhi/common/misc.h>
+#include <cstring>
+
+namespace nvrhi
+{
+    bool ShaderCache::isCacheable(const ShaderDesc& desc)
+    {
+        return desc.pCustomSemantics == nullptr && desc.pCoordinateSwizzling == nullptr;
+    }
+
+    uint64_t ShaderCache::getKey(const ShaderDesc& desc, const void* binary, size_t binarySize)
+    {
+        // The debug name is not part of the key: the same permutation loaded under different names is shared,
+        // and the shader keeps the name it was first created with.
+        uint64_t key = hash_bytes(binary, binarySize);
+        key = hash_bytes(&binarySize, sizeof(binarySize), key);
+        key = hash_bytes(desc.entryName.data(), desc.entryName.size(), key);
+        key = hash_bytes(&desc.shaderType, sizeof(desc.shaderType), key);
+        key = hash_bytes(&desc.hlslExtensionsUAV, sizeof(desc.hlslExtensionsUAV), key);
+        key = hash_bytes(&desc.useSpecificShaderExt, sizeof(desc.useSpecificShaderExt), key);
+        key = hash_bytes(&desc.fastGSFlags, sizeof(desc.fastGSFlags), key);
+        return key;
+    }
+
+    uint64_t ShaderCache::getKey(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        // A different seed keeps the specialization keys apart from the bytecode keys
+        uint64_t key = hash_bytes(&baseShader, sizeof(baseShader), 0x84222325cbf29ce4ull);
+        key = hash_bytes(constants, sizeof(ShaderSpecialization) * numConstants, key);
+        return key;
+    }
+
+    bool ShaderCache::matches(const Entry& entry, const ShaderDesc& desc, const void* binary, size_t binarySize)
+    {
+        // Specialization entries are the ones with a base shader, they never match a bytecode lookup
+        return entry.binary.size() == binarySize
+            && !entry.baseShader
+            && entry.desc.entryName == desc.entryName
+            && entry.desc.shaderType == desc.shaderType
+            && entry.desc.hlslExtensionsUAV == desc.hlslExtensionsUAV
+            && entry.desc.useSpecificShaderExt == desc.useSpecificShaderExt
+            && entry.desc.fastGSFlags == desc.fastGSFlags
+            && (binarySize == 0 || memcmp(entry.binary.data(), binary, binarySize) == 0);
+    }
+
+    bool ShaderCache::matches(const Entry& entry, IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        if (entry.baseShader != baseShader || entry.constants.size() != numConstants)
+            return false;
+
+        for (uint32_t i = 0; i < numConstants; ++i)
+        {
+            if (entry.constants[i].constantID != constants[i].constantID || entry.constants[i].value.u != constants[i].value.u)
+                return false;
+        }
+
+        return true;
+    }
+
+    ShaderHandle ShaderCache::find(uint64_t key, const ShaderDesc& desc, const void* binary, size_t binarySize)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        const auto [first, last] = m_Shaders.equal_range(key);
+        for (auto it = first; it != last; ++it)
+        {
+            if (matches(it->second, desc, binary, binarySize))
+                return it->second.shader;
+        }
+
+        return nullptr;
+    }
+
+    ShaderHandle ShaderCache::find(uint64_t key, IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        const auto [first, last] = m_Shaders.equal_range(key);
+        for (auto it = first; it != last; ++it)
+        {
+            if (matches(it->second, baseShader, constants, numConstants))
+                return it->second.shader;
+        }
+
+        return nullptr;
+    }
+
+    ShaderHandle ShaderCache::insert(uint64_t key, const ShaderDesc& desc, const void* binary, size_t binarySize, IShader* shader)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        const auto [first, last] = m_Shaders.equal_range(key);
+        for (auto it = first; it != last; ++it)
+        {
+            if (matches(it->second, desc, binary, binarySize))
+                return it->second.shader;
+        }
+
+        Entry entry;
+        entry.shader = shader;
+        entry.binary.assign(static_cast<const uint8_t*>(binary), static_cast<const uint8_t*>(binary) + binarySize);
+        entry.desc.entryName = desc.entryName;
+        entry.desc.shaderType = desc.shaderType;
+        entry.desc.hlslExtensionsUAV = desc.hlslExtensionsUAV;
+        entry.desc.useSpecificShaderExt = desc.useSpecificShaderExt;
+        entry.desc.fastGSFlags = desc.fastGSFlags;
+        m_Shaders.emplace(key, std::move(entry));
+
+        return shader;
+    }
+
+    ShaderHandle ShaderCache::insert(uint64_t key, IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants, IShader* shader)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        const auto [first, last] = m_Shaders.equal_range(key);
+        for (auto it = first; it != last; ++it)
+        {
+            if (matches(it->second, baseShader, constants, numConstants))
+                return it->second.shader;
+        }
+
+        Entry entry;
+        entry.shader = shader;
+        entry.baseShader = baseShader;
+        entry.constants.assign(constants, constants + numConstants);
+        m_Shaders.emplace(key, std::move(entry));
+
+        return shader;
+    }
+
+    void ShaderCache::prune()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // A shader with one reference can't be returned by find() concurrently, the mutex is held.
+        // Releasing a specialization can leave its base shader unreferenced, so repeat until nothing changes.
+        bool erased = true;
+        while (erased)
+        {
+            erased = false;
+            for (auto it = m_Shaders.begin(); it != m_Shaders.end(); )
+            {
+                if (it->second.shader->GetRefCount() == 1)
+                {
+                    it = m_Shaders.erase(it);
+                    erased = true;
+                }
+                else
+                    ++it;
+            }
+        }
+    }
+
+} // namespace nvrhi
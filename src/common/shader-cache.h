@@ -0,0 +1,80 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Shares the shaders created from identical bytecode, see DeviceDesc::enableShaderCache in the backends.
+    // Shaders are looked up by a hash of their bytecode and of the ShaderDesc fields that affect the native object,
+    // and specializations by a hash of their base shader and constants. The hash only selects the bucket: every
+    // entry keeps a copy of the data it was created from, and find() compares that before returning a shader.
+    // The cache holds a reference to every shader, and to the base shader of a specialization so that its address
+    // can't be reused, until prune() finds that nothing else references the shader.
+    class ShaderCache
+    {
+    public:
+        // Shaders with custom semantics or coordinate swizzling are never cached because those are
+        // passed as pointers to application memory.
+        [[nodiscard]] static bool isCacheable(const ShaderDesc& desc);
+
+        [[nodiscard]] static uint64_t getKey(const ShaderDesc& desc, const void* binary, size_t binarySize);
+        [[nodiscard]] static uint64_t getKey(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants);
+
+        [[nodiscard]] ShaderHandle find(uint64_t key, const ShaderDesc& desc, const void* binary, size_t binarySize);
+        [[nodiscard]] ShaderHandle find(uint64_t key, IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants);
+
+        // Adds the shader unless another thread has added an identical one in the meantime.
+        // Returns the shader that ends up in the cache.
+        ShaderHandle insert(uint64_t key, const ShaderDesc& desc, const void* binary, size_t binarySize, IShader* shader);
+        ShaderHandle insert(uint64_t key, IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants, IShader* shader);
+
+        // Releases the shaders that are only referenced by the cache.
+        void prune();
+
+    private:
+        struct Entry
+        {
+            ShaderHandle shader;
+
+            // Source of a shader created from bytecode, only the ShaderDesc fields that are hashed by getKey are used
+            std::vector<uint8_t> binary;
+            ShaderDesc desc;
+
+            // Source of a specialization
+            ShaderHandle baseShader;
+            std::vector<ShaderSpecialization> constants;
+        };
+
+        [[nodiscard]] static bool matches(const Entry& entry, const ShaderDesc& desc, const void* binary, size_t binarySize);
+        [[nodiscard]] static bool matches(const Entry& entry, IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants);
+
+        std::mutex m_Mutex;
+        std::unordered_multimap<uint64_t, Entry> m_Shaders;
+    };
+
+} // namespace nvrhi
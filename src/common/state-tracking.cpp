@@ -24,6 +24,7 @@
 
 #include <nvrhi/utils.h>
 
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi
@@ -43,11 +44,80 @@ namespace nvrhi
         return true;
     }
 
+    // Switches the tracking from per-subresource back to whole-texture if all subresources are in the same known state.
+    static bool collapseUniformSubresourceStates(TextureState* tracking)
+    {
+        const ResourceStates first = tracking->subresourceStates[0];
+        if (first == ResourceStates::Unknown)
+            return false;
+
+        for (ResourceStates subresourceState : tracking->subresourceStates)
+        {
+            if (subresourceState != first)
+                return false;
+        }
+
+        tracking->subresourceStates.clear();
+        tracking->state = first;
+        return true;
+    }
+
+    static std::atomic<uint32_t> g_NextTrackerId { 1 };
+
+    CommandListResourceStateTracker::CommandListResourceStateTracker(IMessageCallback* messageCallback)
+        : m_MessageCallback(messageCallback)
+        , m_TrackerId(g_NextTrackerId.fetch_add(1, std::memory_order_relaxed))
+    { }
+
     static uint32_t calcSubresource(MipLevel mipLevel, ArraySlice arraySlice, const TextureDesc& desc)
     {
         return mipLevel + arraySlice * desc.mipLevels;
     }
 
+    template<typename Extension, typename State>
+    static State* findOrCreateStateTracking(Extension* resource, bool allowCreate, uint64_t trackerId,
+        std::vector<Extension*>& trackedResources, std::deque<State>& arena,
+        std::unordered_map<Extension*, uint32_t>& overflow)
+    {
+        uint64_t slot = resource->trackerSlot.load(std::memory_order_relaxed);
+
+        if ((slot >> 32) == trackerId)
+            return &arena[uint32_t(slot)];
+
+        if (!overflow.empty())
+        {
+            auto it = overflow.find(resource);
+            if (it != overflow.end())
+                return &arena[it->second];
+        }
+
+        if (!allowCreate)
+            return nullptr;
+
+        const uint32_t index = uint32_t(trackedResources.size());
+        trackedResources.push_back(resource);
+
+        if (index == arena.size())
+            arena.emplace_back();
+
+        uint64_t expected = 0;
+        if (!resource->trackerSlot.compare_exchange_strong(expected, (trackerId << 32) | index, std::memory_order_relaxed))
+            overflow[resource] = index;
+
+        return &arena[index];
+    }
+
+    template<typename Extension>
+    static void releaseTrackerSlots(const std::vector<Extension*>& trackedResources, uint64_t trackerId)
+    {
+        for (uint32_t index = 0; index < uint32_t(trackedResources.size()); index++)
+        {
+            // Fails harmlessly for resources that were placed into the overflow map.
+            uint64_t expected = (trackerId << 32) | index;
+            trackedResources[index]->trackerSlot.compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+        }
+    }
+
     void CommandListResourceStateTracker::setEnableUavBarriersForTexture(TextureStateExtension* texture, bool enableBarriers)
     {
         TextureState* tracking = getTextureStateTracking(texture, true);
@@ -69,6 +139,13 @@ namespace nvrhi
         const TextureDesc& desc = texture->descRef;
 
         TextureState* tracking = getTextureStateTracking(texture, true);
+        tracking->aliased = false;
+        tracking->ownershipReleased = false;
+
+        if (tracking->pendingSplitTransition)
+            endSplitTransition(tracking->pendingSplitTransition);
+
+        ++m_StateGeneration;
         
         subresources = subresources.resolve(desc, false);
 
@@ -96,7 +173,12 @@ namespace nvrhi
     void CommandListResourceStateTracker::beginTrackingBufferState(BufferStateExtension* buffer, ResourceStates stateBits)
     {
         BufferState* tracking = getBufferStateTracking(buffer, true);
+        tracking->ownershipReleased = false;
+
+        if (tracking->pendingSplitTransition)
+            endSplitTransition(tracking->pendingSplitTransition);
 
+        ++m_StateGeneration;
         tracking->state = stateBits;
     }
 
@@ -118,6 +200,9 @@ namespace nvrhi
 
         requireTextureState(texture, subresources, stateBits);
 
+        if (m_StatisticsEnabled)
+            ++m_Statistics.permanentStateTransitions;
+
         if (permanent)
         {
             m_PermanentTextureStates.push_back(std::make_pair(texture, stateBits));
@@ -129,6 +214,9 @@ namespace nvrhi
     {
         requireBufferState(buffer, stateBits);
 
+        if (m_StatisticsEnabled)
+            ++m_Statistics.permanentStateTransitions;
+
         m_PermanentBufferStates.push_back(std::make_pair(buffer, stateBits));
     }
 
@@ -160,6 +248,295 @@ namespace nvrhi
         return tracking->state;
     }
     
+    void CommandListResourceStateTracker::addAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        AliasingBarrier barrier;
+        barrier.resourceBefore = resourceBefore;
+        barrier.resourceAfter = resourceAfter;
+        m_AliasingBarriers.push_back(barrier);
+    }
+
+    void CommandListResourceStateTracker::discardTextureState(TextureStateExtension* texture)
+    {
+        if (texture->permanentState != 0)
+        {
+            std::stringstream ss;
+            ss << "Texture " << utils::DebugNameToString(texture->descRef.debugName)
+                << " is in a permanent state and cannot be aliased";
+            m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+            return;
+        }
+
+        TextureState* tracking = getTextureStateTracking(texture, true);
+
+        if (tracking->pendingSplitTransition)
+            endSplitTransition(tracking->pendingSplitTransition);
+
+        ++m_StateGeneration;
+        tracking->state = ResourceStates::Common;
+        tracking->subresourceStates.clear();
+        tracking->firstUavBarrierPlaced = false;
+        tracking->aliased = true;
+    }
+
+    void CommandListResourceStateTracker::discardBufferState(BufferStateExtension* buffer)
+    {
+        if (buffer->permanentState != 0)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << utils::DebugNameToString(buffer->descRef.debugName)
+                << " is in a permanent state and cannot be aliased";
+            m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+            return;
+        }
+
+        BufferState* tracking = getBufferStateTracking(buffer, true);
+
+        if (tracking->pendingSplitTransition)
+            endSplitTransition(tracking->pendingSplitTransition);
+
+        ++m_StateGeneration;
+        tracking->state = ResourceStates::Common;
+        tracking->firstUavBarrierPlaced = false;
+    }
+
+    void CommandListResourceStateTracker::beginTextureStateTransition(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        const size_t firstBarrier = m_TextureBarriers.size();
+
+        // Ends the previous split transition of this texture, if any, and places the barriers as usual
+        requireTextureState(texture, subresources, stateBits);
+
+        SplitTransition split;
+
+        for (size_t index = firstBarrier; index < m_TextureBarriers.size(); index++)
+        {
+            TextureBarrier& barrier = m_TextureBarriers[index];
+
+            // UAV barriers can't be split
+            if (barrier.texture != texture || barrier.stateBefore == barrier.stateAfter || barrier.splitPhase != SplitBarrierPhase::None)
+                continue;
+
+            if (split.id == 0)
+                split.id = m_NextSplitTransitionId++;
+
+            barrier.splitPhase = SplitBarrierPhase::Begin;
+            barrier.splitId = split.id;
+            split.textureBarriers.push_back(barrier);
+        }
+
+        if (split.id == 0)
+            return;
+
+        split.texture = texture;
+        getTextureStateTracking(texture, false)->pendingSplitTransition = split.id;
+        m_SplitTransitions.push_back(std::move(split));
+    }
+
+    void CommandListResourceStateTracker::beginBufferStateTransition(BufferStateExtension* buffer, ResourceStates stateBits)
+    {
+        const size_t firstBarrier = m_BufferBarriers.size();
+
+        requireBufferState(buffer, stateBits);
+
+        // Only a new barrier can become a split barrier, the state bits of a barrier that was merged
+        // with an earlier use of the buffer in this batch are not ready yet.
+        if (m_BufferBarriers.size() == firstBarrier)
+            return;
+
+        BufferBarrier& barrier = m_BufferBarriers.back();
+        if (barrier.stateBefore == barrier.stateAfter)
+            return;
+
+        SplitTransition split;
+        split.id = m_NextSplitTransitionId++;
+        split.buffer = buffer;
+
+        barrier.splitPhase = SplitBarrierPhase::Begin;
+        barrier.splitId = split.id;
+        split.bufferBarriers.push_back(barrier);
+
+        getBufferStateTracking(buffer, false)->pendingSplitTransition = split.id;
+        m_SplitTransitions.push_back(std::move(split));
+    }
+
+    void CommandListResourceStateTracker::addTextureOwnershipBarriers(TextureStateExtension* texture, TextureSubresourceSet subresources,
+        QueueOwnershipTransfer transfer, CommandQueue otherQueue, ResourceStates stateBits)
+    {
+        subresources = subresources.resolve(texture->descRef, false);
+
+        TextureBarrier barrier;
+        barrier.texture = texture;
+        barrier.ownershipTransfer = transfer;
+        barrier.otherQueue = otherQueue;
+        barrier.stateBefore = stateBits;
+        barrier.stateAfter = stateBits;
+
+        if (subresources.isEntireTexture(texture->descRef))
+        {
+            barrier.entireTexture = true;
+            m_TextureBarriers.push_back(barrier);
+        }
+        else
+        {
+            for (ArraySlice arraySlice = subresources.baseArraySlice; arraySlice < subresources.baseArraySlice + subresources.numArraySlices; arraySlice++)
+            {
+                for (MipLevel mipLevel = subresources.baseMipLevel; mipLevel < subresources.baseMipLevel + subresources.numMipLevels; mipLevel++)
+                {
+                    barrier.mipLevel = mipLevel;
+                    barrier.arraySlice = arraySlice;
+                    m_TextureBarriers.push_back(barrier);
+                }
+            }
+        }
+
+        ++m_StateGeneration;
+    }
+
+    void CommandListResourceStateTracker::addBufferOwnershipBarrier(BufferStateExtension* buffer, QueueOwnershipTransfer transfer,
+        CommandQueue otherQueue, ResourceStates stateBits)
+    {
+        BufferBarrier barrier;
+        barrier.buffer = buffer;
+        barrier.ownershipTransfer = transfer;
+        barrier.otherQueue = otherQueue;
+        barrier.stateBefore = stateBits;
+        barrier.stateAfter = stateBits;
+        m_BufferBarriers.push_back(barrier);
+
+        ++m_StateGeneration;
+    }
+
+    void CommandListResourceStateTracker::releaseTextureOwnership(TextureStateExtension* texture, TextureSubresourceSet subresources,
+        CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        // Transition on this queue first, then hand the subresources over in their final state
+        requireTextureState(texture, subresources, stateBits);
+        addTextureOwnershipBarriers(texture, subresources, QueueOwnershipTransfer::Release, destinationQueue, stateBits);
+
+        if (TextureState* tracking = getTextureStateTracking(texture, false))
+            tracking->ownershipReleased = true;
+    }
+
+    void CommandListResourceStateTracker::acquireTextureOwnership(TextureStateExtension* texture, TextureSubresourceSet subresources,
+        CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        if (texture->permanentState == 0)
+            beginTrackingTextureState(texture, subresources, stateBits);
+
+        addTextureOwnershipBarriers(texture, subresources, QueueOwnershipTransfer::Acquire, sourceQueue, stateBits);
+    }
+
+    void CommandListResourceStateTracker::releaseBufferOwnership(BufferStateExtension* buffer, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        requireBufferState(buffer, stateBits);
+        addBufferOwnershipBarrier(buffer, QueueOwnershipTransfer::Release, destinationQueue, stateBits);
+
+        if (BufferState* tracking = getBufferStateTracking(buffer, false))
+            tracking->ownershipReleased = true;
+    }
+
+    void CommandListResourceStateTracker::acquireBufferOwnership(BufferStateExtension* buffer, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        if (buffer->permanentState == 0)
+            beginTrackingBufferState(buffer, stateBits);
+
+        addBufferOwnershipBarrier(buffer, QueueOwnershipTransfer::Acquire, sourceQueue, stateBits);
+    }
+
+    void CommandListResourceStateTracker::endSplitTransition(uint32_t id)
+    {
+        auto it = std::find_if(m_SplitTransitions.begin(), m_SplitTransitions.end(),
+            [id](const SplitTransition& split) { return split.id == id; });
+
+        if (it == m_SplitTransitions.end())
+            return;
+
+        if (it->committed)
+        {
+            for (TextureBarrier barrier : it->textureBarriers)
+            {
+                barrier.splitPhase = SplitBarrierPhase::End;
+                m_TextureBarriers.push_back(barrier);
+            }
+
+            for (BufferBarrier barrier : it->bufferBarriers)
+            {
+                barrier.splitPhase = SplitBarrierPhase::End;
+                m_BufferBarriers.push_back(barrier);
+            }
+        }
+        else
+        {
+            // The Begin barriers are still pending, so there is nothing to overlap with: make them regular barriers.
+            for (TextureBarrier& barrier : m_TextureBarriers)
+            {
+                if (barrier.splitId == id)
+                {
+                    barrier.splitPhase = SplitBarrierPhase::None;
+                    barrier.splitId = 0;
+                }
+            }
+
+            for (BufferBarrier& barrier : m_BufferBarriers)
+            {
+                if (barrier.splitId == id)
+                {
+                    barrier.splitPhase = SplitBarrierPhase::None;
+                    barrier.splitId = 0;
+                }
+            }
+        }
+
+        if (it->texture)
+            getTextureStateTracking(it->texture, false)->pendingSplitTransition = 0;
+        if (it->buffer)
+            getBufferStateTracking(it->buffer, false)->pendingSplitTransition = 0;
+
+        m_SplitTransitions.erase(it);
+        ++m_StateGeneration;
+    }
+
+    void CommandListResourceStateTracker::endSplitTransitions()
+    {
+        while (!m_SplitTransitions.empty())
+        {
+            endSplitTransition(m_SplitTransitions.back().id);
+        }
+    }
+
+    void CommandListResourceStateTracker::clearBarriers()
+    {
+        if (m_StatisticsEnabled && hasPendingBarriers())
+        {
+            for (const TextureBarrier& barrier : m_TextureBarriers)
+            {
+                if (barrier.ownershipTransfer != QueueOwnershipTransfer::None || barrier.stateBefore != barrier.stateAfter)
+                    ++m_Statistics.textureBarriers;
+                else
+                    ++m_Statistics.uavBarriers;
+            }
+
+            for (const BufferBarrier& barrier : m_BufferBarriers)
+            {
+                if (barrier.ownershipTransfer != QueueOwnershipTransfer::None || barrier.stateBefore != barrier.stateAfter)
+                    ++m_Statistics.bufferBarriers;
+                else
+                    ++m_Statistics.uavBarriers;
+            }
+
+            m_Statistics.aliasingBarriers += m_AliasingBarriers.size();
+            ++m_Statistics.barrierBatches;
+        }
+
+        m_TextureBarriers.clear();
+        m_BufferBarriers.clear();
+        m_AliasingBarriers.clear();
+
+        for (SplitTransition& split : m_SplitTransitions)
+            split.committed = true;
+    }
+
     void CommandListResourceStateTracker::requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state)
     {
         if (texture->permanentState != 0)
@@ -172,16 +549,41 @@ namespace nvrhi
 
         TextureState* tracking = getTextureStateTracking(texture, true);
 
+        if (tracking->pendingSplitTransition)
+            endSplitTransition(tracking->pendingSplitTransition);
+
+        const size_t numBarriers = m_TextureBarriers.size();
+
         if (tracking->subresourceStates.empty() && tracking->state == ResourceStates::Unknown)
         {
-            std::stringstream ss;
-            ss << "Unknown prior state of texture " << utils::DebugNameToString(texture->descRef.debugName) << ". "
-                "Call CommandList::beginTrackingTextureState(...) before using the texture or use the "
-                "keepInitialState and initialState members of TextureDesc.";
-            m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+            if (m_DeferInitialStates)
+            {
+                // Assume that the entire texture is in the required state, executeCommandLists will make it so
+                StateFixup deferred;
+                deferred.texture = texture;
+                deferred.stateAfter = state;
+                m_DeferredInitialStates.push_back(deferred);
+                tracking->state = state;
+                ++m_StateGeneration;
+            }
+            else
+            {
+                std::stringstream ss;
+                ss << "Unknown prior state of texture " << utils::DebugNameToString(texture->descRef.debugName) << ". "
+                    "Call CommandList::beginTrackingTextureState(...) before using the texture or use the "
+                    "keepInitialState and initialState members of TextureDesc.";
+                m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+            }
         }
         
-        if (subresources.isEntireTexture(texture->descRef) && tracking->subresourceStates.empty())
+        const bool entireTexture = subresources.isEntireTexture(texture->descRef);
+
+        // If the subresources have converged to the same state, go back to tracking the texture as a whole,
+        // so that the transition below is a single barrier and not one per subresource.
+        if (entireTexture && !tracking->subresourceStates.empty())
+            collapseUniformSubresourceStates(tracking);
+
+        if (entireTexture && tracking->subresourceStates.empty())
         {
             // We're requiring state for the entire texture, and it's been tracked as entire texture too
 
@@ -194,10 +596,13 @@ namespace nvrhi
                 TextureBarrier barrier;
                 barrier.texture = texture;
                 barrier.entireTexture = true;
+                barrier.aliased = tracking->aliased && tracking->state == ResourceStates::Common;
                 barrier.stateBefore = tracking->state;
                 barrier.stateAfter = state;
                 m_TextureBarriers.push_back(barrier);
             }
+            else if (m_StatisticsEnabled)
+                ++m_Statistics.redundantTransitionsSkipped;
 
             tracking->state = state;
 
@@ -250,10 +655,13 @@ namespace nvrhi
                         barrier.entireTexture = false;
                         barrier.mipLevel = mipLevel;
                         barrier.arraySlice = arraySlice;
+                        barrier.aliased = tracking->aliased && priorState == ResourceStates::Common;
                         barrier.stateBefore = priorState;
                         barrier.stateAfter = state;
                         m_TextureBarriers.push_back(barrier);
                     }
+                    else if (m_StatisticsEnabled)
+                        ++m_Statistics.redundantTransitionsSkipped;
 
                     tracking->subresourceStates[subresourceIndex] = state;
 
@@ -264,7 +672,18 @@ namespace nvrhi
                     }
                 }
             }
+
+            // All subresources are now in the same state.
+            // Keep the vector's storage for when the subresources diverge again.
+            if (entireTexture)
+            {
+                tracking->subresourceStates.clear();
+                tracking->state = state;
+            }
         }
+
+        if (m_TextureBarriers.size() != numBarriers)
+            ++m_StateGeneration;
     }
 
     void CommandListResourceStateTracker::requireBufferState(BufferStateExtension* buffer, ResourceStates state)
@@ -287,13 +706,28 @@ namespace nvrhi
 
         BufferState* tracking = getBufferStateTracking(buffer, true);
 
+        if (tracking->pendingSplitTransition)
+            endSplitTransition(tracking->pendingSplitTransition);
+
         if (tracking->state == ResourceStates::Unknown)
         {
-            std::stringstream ss;
-            ss << "Unknown prior state of buffer " << utils::DebugNameToString(buffer->descRef.debugName) << ". "
-                "Call CommandList::beginTrackingBufferState(...) before using the buffer or use the "
-                "keepInitialState and initialState members of BufferDesc.";
-            m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+            if (m_DeferInitialStates)
+            {
+                StateFixup deferred;
+                deferred.buffer = buffer;
+                deferred.stateAfter = state;
+                m_DeferredInitialStates.push_back(deferred);
+                tracking->state = state;
+                ++m_StateGeneration;
+            }
+            else
+            {
+                std::stringstream ss;
+                ss << "Unknown prior state of buffer " << utils::DebugNameToString(buffer->descRef.debugName) << ". "
+                    "Call CommandList::beginTrackingBufferState(...) before using the buffer or use the "
+                    "keepInitialState and initialState members of BufferDesc.";
+                m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+            }
         }
 
         bool transitionNecessary = tracking->state != state;
@@ -307,10 +741,13 @@ namespace nvrhi
             // Example: same buffer used as index and vertex buffer, or as SRV and indirect arguments.
             for (BufferBarrier& barrier : m_BufferBarriers)
             {
-                if (barrier.buffer == buffer)
+                // The Begin and End barriers of split transitions must stay identical
+                if (barrier.buffer == buffer && barrier.splitPhase == SplitBarrierPhase::None &&
+                    barrier.ownershipTransfer == QueueOwnershipTransfer::None)
                 {
                     barrier.stateAfter = ResourceStates(barrier.stateAfter | state);
                     tracking->state = barrier.stateAfter;
+                    ++m_StateGeneration;
                     return;
                 }
             }
@@ -323,7 +760,10 @@ namespace nvrhi
             barrier.stateBefore = tracking->state;
             barrier.stateAfter = state;
             m_BufferBarriers.push_back(barrier);
+            ++m_StateGeneration;
         }
+        else if (m_StatisticsEnabled)
+            ++m_Statistics.redundantTransitionsSkipped;
 
         if (uavNecessary && !transitionNecessary)
         {
@@ -333,14 +773,47 @@ namespace nvrhi
         tracking->state = state;
     }
 
+    void CommandListResourceStateTracker::requireResourceStates(const std::vector<RequiredResourceState>& states, const void* cacheKey)
+    {
+        SatisfiedStateList* cacheEntry = nullptr;
+        if (cacheKey)
+        {
+            cacheEntry = &m_SatisfiedStateLists[(reinterpret_cast<uintptr_t>(cacheKey) >> 4) % c_SatisfiedStateListCacheSize];
+            if (cacheEntry->key == cacheKey && cacheEntry->generation == m_StateGeneration)
+            {
+                if (m_StatisticsEnabled)
+                    m_Statistics.redundantTransitionsSkipped += states.size();
+                return;
+            }
+        }
+
+        for (const RequiredResourceState& required : states)
+        {
+            if (required.texture)
+                requireTextureState(required.texture, required.subresources, required.state);
+            else if (required.buffer)
+                requireBufferState(required.buffer, required.state);
+        }
+
+        if (cacheEntry)
+        {
+            cacheEntry->key = cacheKey;
+            cacheEntry->generation = m_StateGeneration;
+        }
+    }
+
     void CommandListResourceStateTracker::keepBufferInitialStates()
     {
-        for (auto& [buffer, tracking] : m_BufferStates)
+        for (size_t index = 0; index < m_TrackedBuffers.size(); index++)
         {
+            BufferStateExtension* buffer = m_TrackedBuffers[index];
+            const BufferState* tracking = &m_BufferStateArena[index];
+
             if (buffer->descRef.keepInitialState && 
                 !buffer->permanentState &&
                 !buffer->descRef.isVolatile &&
-                !tracking->permanentTransition)
+                !tracking->permanentTransition &&
+                !tracking->ownershipReleased)
             {
                 requireBufferState(buffer, buffer->descRef.initialState);
             }
@@ -349,19 +822,108 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepTextureInitialStates()
     {
-        for (auto& [texture, tracking] : m_TextureStates)
+        // Also makes sure that the cached state lists don't survive into the next recording
+        ++m_StateGeneration;
+
+        if (m_DeferInitialStates)
+        {
+            // The submitted state of a texture is tracked as a whole, so bring diverged subresources together
+            for (size_t index = 0; index < m_TrackedTextures.size(); index++)
+            {
+                TextureStateExtension* texture = m_TrackedTextures[index];
+                const TextureState& tracking = m_TextureStateArena[index];
+
+                if (texture->permanentState != 0 || texture->descRef.keepInitialState || tracking.ownershipReleased ||
+                    tracking.subresourceStates.empty())
+                    continue;
+
+                auto known = std::find_if(tracking.subresourceStates.begin(), tracking.subresourceStates.end(),
+                    [](ResourceStates state) { return state != ResourceStates::Unknown; });
+
+                if (known != tracking.subresourceStates.end())
+                    requireTextureState(texture, AllSubresources, *known);
+            }
+        }
+
+        for (size_t index = 0; index < m_TrackedTextures.size(); index++)
         {
+            TextureStateExtension* texture = m_TrackedTextures[index];
+            const TextureState* tracking = &m_TextureStateArena[index];
+
             if (texture->descRef.keepInitialState && 
                 !texture->permanentState && 
-                !tracking->permanentTransition)
+                !tracking->permanentTransition &&
+                !tracking->ownershipReleased)
             {
                 requireTextureState(texture, AllSubresources, texture->descRef.initialState);
             }
         }
     }
 
+    static ResourceStates getSubmittedOrInitialState(const std::atomic<ResourceStates>& submittedState, ResourceStates initialState)
+    {
+        const ResourceStates state = submittedState.load(std::memory_order_relaxed);
+        if (state != ResourceStates::Unknown)
+            return state;
+
+        // Never used by an executed command list: the resource is still in the state it was created in
+        return initialState != ResourceStates::Unknown ? initialState : ResourceStates::Common;
+    }
+
+    bool CommandListResourceStateTracker::resolveDeferredInitialStates(std::vector<StateFixup>& outFixups) const
+    {
+        for (const StateFixup& deferred : m_DeferredInitialStates)
+        {
+            StateFixup fixup = deferred;
+
+            if (deferred.texture)
+            {
+                if (deferred.texture->permanentState != 0)
+                    continue;
+
+                fixup.stateBefore = getSubmittedOrInitialState(deferred.texture->submittedState, deferred.texture->descRef.initialState);
+            }
+            else
+            {
+                if (deferred.buffer->permanentState != 0)
+                    continue;
+
+                fixup.stateBefore = getSubmittedOrInitialState(deferred.buffer->submittedState, deferred.buffer->descRef.initialState);
+            }
+
+            // UAV writes from the previous command list need a barrier even without a transition
+            if (fixup.stateBefore != fixup.stateAfter || (fixup.stateAfter & ResourceStates::UnorderedAccess) != 0)
+                outFixups.push_back(fixup);
+        }
+
+        return !outFixups.empty();
+    }
+
+    void CommandListResourceStateTracker::publishSubmittedStates()
+    {
+        for (size_t index = 0; index < m_TrackedTextures.size(); index++)
+        {
+            TextureStateExtension* texture = m_TrackedTextures[index];
+            const TextureState& tracking = m_TextureStateArena[index];
+
+            if (!texture->permanentState)
+                texture->submittedState.store(tracking.subresourceStates.empty() ? tracking.state : ResourceStates::Unknown, std::memory_order_relaxed);
+        }
+
+        for (size_t index = 0; index < m_TrackedBuffers.size(); index++)
+        {
+            BufferStateExtension* buffer = m_TrackedBuffers[index];
+
+            if (!buffer->permanentState)
+                buffer->submittedState.store(m_BufferStateArena[index].state, std::memory_order_relaxed);
+        }
+    }
+
     void CommandListResourceStateTracker::commandListSubmitted()
     {
+        publishSubmittedStates();
+        m_DeferredInitialStates.clear();
+
         for (auto [texture, state] : m_PermanentTextureStates)
         {
             if (texture->permanentState != 0 && texture->permanentState != state)
@@ -392,36 +954,46 @@ namespace nvrhi
         }
         m_PermanentBufferStates.clear();
 
-        for (const auto& [texture, stateTracking] : m_TextureStates)
+        for (TextureStateExtension* texture : m_TrackedTextures)
         {
             if (texture->descRef.keepInitialState && !texture->stateInitialized)
                 texture->stateInitialized = true;
         }
 
-        m_TextureStates.clear();
-        m_BufferStates.clear();
+        releaseTrackerSlots(m_TrackedTextures, m_TrackerId);
+        releaseTrackerSlots(m_TrackedBuffers, m_TrackerId);
+
+        // The arena entries are reinitialized when they are handed out again.
+        m_TrackedTextures.clear();
+        m_TrackedBuffers.clear();
+        m_TextureSlotOverflow.clear();
+        m_BufferSlotOverflow.clear();
+        ++m_StateGeneration;
     }
 
     TextureState* CommandListResourceStateTracker::getTextureStateTracking(TextureStateExtension* texture, bool allowCreate)
     {
-        auto it = m_TextureStates.find(texture);
-
-        if (it != m_TextureStates.end())
-        {
-            return it->second.get();
-        }
+        const size_t numTracked = m_TrackedTextures.size();
 
-        if (!allowCreate)
-            return nullptr;
-        
-        std::unique_ptr<TextureState> trackingRef = std::make_unique<TextureState>();
+        TextureState* tracking = findOrCreateStateTracking(texture, allowCreate, m_TrackerId,
+            m_TrackedTextures, m_TextureStateArena, m_TextureSlotOverflow);
 
-        TextureState* tracking = trackingRef.get();
-        m_TextureStates.insert(std::make_pair(texture, std::move(trackingRef)));
-        
-        if (texture->descRef.keepInitialState)
+        if (tracking && m_TrackedTextures.size() != numTracked)
         {
-            tracking->state = texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
+            // New entry: reset the reused arena slot, keeping the capacity of its subresource state vector.
+            tracking->subresourceStates.clear();
+            tracking->state = ResourceStates::Unknown;
+            tracking->enableUavBarriers = true;
+            tracking->firstUavBarrierPlaced = false;
+            tracking->permanentTransition = false;
+            tracking->aliased = false;
+            tracking->pendingSplitTransition = 0;
+            tracking->ownershipReleased = false;
+
+            if (texture->descRef.keepInitialState)
+            {
+                tracking->state = texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
+            }
         }
 
         return tracking;
@@ -429,24 +1001,19 @@ namespace nvrhi
 
     BufferState* CommandListResourceStateTracker::getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate)
     {
-        auto it = m_BufferStates.find(buffer);
+        const size_t numTracked = m_TrackedBuffers.size();
 
-        if (it != m_BufferStates.end())
-        {
-            return it->second.get();
-        }
-
-        if (!allowCreate)
-            return nullptr;
+        BufferState* tracking = findOrCreateStateTracking(buffer, allowCreate, m_TrackerId,
+            m_TrackedBuffers, m_BufferStateArena, m_BufferSlotOverflow);
 
-        std::unique_ptr<BufferState> trackingRef = std::make_unique<BufferState>();
-
-        BufferState* tracking = trackingRef.get();
-        m_BufferStates.insert(std::make_pair(buffer, std::move(trackingRef)));
-                                                   
-        if (buffer->descRef.keepInitialState)
+        if (tracking && m_TrackedBuffers.size() != numTracked)
         {
-            tracking->state = buffer->descRef.initialState;
+            *tracking = BufferState();
+
+            if (buffer->descRef.keepInitialState)
+            {
+                tracking->state = buffer->descRef.initialState;
+            }
         }
 
         return tracking;
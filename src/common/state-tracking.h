@@ -23,15 +23,26 @@
 #pragma once
 
 #include <nvrhi/nvrhi.h>
+#include <array>
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 
 namespace nvrhi
 {
+    // Packed (tracker ID << 32 | slot index) of the command list tracker that currently owns
+    // the fast lookup slot of a resource, or 0 if the slot is free. See CommandListResourceStateTracker.
+    typedef std::atomic<uint64_t> TrackerSlot;
+
     struct BufferStateExtension
     {
         const BufferDesc& descRef;
         ResourceStates permanentState = ResourceStates::Unknown;
+        TrackerSlot trackerSlot { 0 };
+        // State of the buffer after the last executed command list that used it, Unknown if not known.
+        // Used to resolve the initial states of command lists with deferInitialStates.
+        std::atomic<ResourceStates> submittedState { ResourceStates::Unknown };
 
         explicit BufferStateExtension(const BufferDesc& desc)
             : descRef(desc)
@@ -44,6 +55,8 @@ namespace nvrhi
         ResourceStates permanentState = ResourceStates::Unknown;
         bool stateInitialized = false;
         bool isSamplerFeedback = false;
+        TrackerSlot trackerSlot { 0 };
+        std::atomic<ResourceStates> submittedState { ResourceStates::Unknown };
 
         explicit TextureStateExtension(const TextureDesc& desc)
             : descRef(desc)
@@ -57,6 +70,11 @@ namespace nvrhi
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
         bool permanentTransition = false;
+        bool aliased = false;
+        // ID of the split transition that was started for this texture and not ended yet, or 0.
+        uint32_t pendingSplitTransition = 0;
+        // True after the texture was handed over to another queue with releaseTextureOwnership.
+        bool ownershipReleased = false;
     };
 
     struct BufferState
@@ -65,6 +83,22 @@ namespace nvrhi
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
         bool permanentTransition = false;
+        uint32_t pendingSplitTransition = 0;
+        bool ownershipReleased = false;
+    };
+
+    enum class SplitBarrierPhase : uint8_t
+    {
+        None,
+        Begin,
+        End
+    };
+
+    enum class QueueOwnershipTransfer : uint8_t
+    {
+        None,
+        Release,
+        Acquire
     };
 
     struct TextureBarrier
@@ -73,6 +107,17 @@ namespace nvrhi
         MipLevel mipLevel = 0;
         ArraySlice arraySlice = 0;
         bool entireTexture = false;
+        // True when the transition starts from the Common state that was set by discardTextureState,
+        // i.e. the previous contents of the memory belonged to a different, aliased resource.
+        bool aliased = false;
+        // Begin and End barriers of the same split transition have the same nonzero splitId.
+        SplitBarrierPhase splitPhase = SplitBarrierPhase::None;
+        uint32_t splitId = 0;
+        // Ownership transfer barriers have equal stateBefore and stateAfter, the transition into that state
+        // is a separate barrier that precedes the release or follows the acquire.
+        QueueOwnershipTransfer ownershipTransfer = QueueOwnershipTransfer::None;
+        // Destination queue of a release, source queue of an acquire.
+        CommandQueue otherQueue = CommandQueue::Graphics;
         ResourceStates stateBefore = ResourceStates::Unknown;
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
@@ -80,16 +125,48 @@ namespace nvrhi
     struct BufferBarrier
     {
         BufferStateExtension* buffer = nullptr;
+        SplitBarrierPhase splitPhase = SplitBarrierPhase::None;
+        uint32_t splitId = 0;
+        QueueOwnershipTransfer ownershipTransfer = QueueOwnershipTransfer::None;
+        CommandQueue otherQueue = CommandQueue::Graphics;
         ResourceStates stateBefore = ResourceStates::Unknown;
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
 
+    struct AliasingBarrier
+    {
+        IResource* resourceBefore = nullptr;
+        IResource* resourceAfter = nullptr;
+    };
+
+    // A transition that a command list with deferred initial states needs before it executes
+    struct StateFixup
+    {
+        TextureStateExtension* texture = nullptr;
+        BufferStateExtension* buffer = nullptr;
+        ResourceStates stateBefore = ResourceStates::Unknown;
+        ResourceStates stateAfter = ResourceStates::Unknown;
+    };
+
+    // An entry in the precomputed list of states that the resources of a binding set must be in
+    struct RequiredResourceState
+    {
+        TextureStateExtension* texture = nullptr;
+        BufferStateExtension* buffer = nullptr;
+        TextureSubresourceSet subresources;
+        ResourceStates state = ResourceStates::Unknown;
+    };
+
+    // Tracks the states of resources used by one command list.
+    // The per-resource tracking entries live in arenas that are reused between recordings, so no memory is
+    // allocated for the resources in steady state. The first command list that touches a resource claims the
+    // resource's trackerSlot and stores the index of its entry there, which makes lookups a single atomic load.
+    // If the slot is already claimed by another command list that is recording concurrently, the entry index
+    // is stored in a small overflow map instead. The claims are released in commandListSubmitted.
     class CommandListResourceStateTracker
     {
     public:
-        explicit CommandListResourceStateTracker(IMessageCallback* messageCallback)
-            : m_MessageCallback(messageCallback)
-        { }
+        explicit CommandListResourceStateTracker(IMessageCallback* messageCallback);
 
         // ICommandList-like interface
 
@@ -105,24 +182,72 @@ namespace nvrhi
         ResourceStates getTextureSubresourceState(TextureStateExtension* texture, ArraySlice arraySlice, MipLevel mipLevel);
         ResourceStates getBufferState(BufferStateExtension* buffer);
 
+        void beginTextureStateTransition(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates stateBits);
+        void beginBufferStateTransition(BufferStateExtension* buffer, ResourceStates stateBits);
+
+        void releaseTextureOwnership(TextureStateExtension* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits);
+        void acquireTextureOwnership(TextureStateExtension* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits);
+        void releaseBufferOwnership(BufferStateExtension* buffer, CommandQueue destinationQueue, ResourceStates stateBits);
+        void acquireBufferOwnership(BufferStateExtension* buffer, CommandQueue sourceQueue, ResourceStates stateBits);
+
+        void addAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter);
+        void discardTextureState(TextureStateExtension* texture);
+        void discardBufferState(BufferStateExtension* buffer);
+
         // Internal interface
         
         void requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state);
         void requireBufferState(BufferStateExtension* buffer, ResourceStates state);
 
+        // Requires the states of all resources in the list. If the list was fully satisfied for the same nonzero
+        // cacheKey and no tracked state has changed since then, returns without looking at the resources.
+        // Pass a null cacheKey for lists that need UAV barriers every time they are used.
+        void requireResourceStates(const std::vector<RequiredResourceState>& states, const void* cacheKey);
+
+        void setDeferInitialStates(bool enable) { m_DeferInitialStates = enable; }
+
+        // The barriers are counted in clearBarriers, so the backends must call it after committing every batch.
+        void setEnableStatistics(bool enable) { m_StatisticsEnabled = enable; }
+        [[nodiscard]] bool statisticsEnabled() const { return m_StatisticsEnabled; }
+        [[nodiscard]] BarrierStatistics& getStatistics() { return m_Statistics; }
+        void resetStatistics() { m_Statistics = BarrierStatistics(); }
+
+        [[nodiscard]] bool hasDeferredInitialStates() const { return !m_DeferredInitialStates.empty(); }
+        // Computes the transitions from the last submitted states of the resources into the states assumed by
+        // this command list. Returns false if there are none.
+        bool resolveDeferredInitialStates(std::vector<StateFixup>& outFixups) const;
+        // Stores the current tracked states as the submitted states of the resources, to be used by
+        // resolveDeferredInitialStates of command lists executed later.
+        void publishSubmittedStates();
+
+        void endSplitTransitions();
         void keepBufferInitialStates();
         void keepTextureInitialStates();
         void commandListSubmitted();
 
         [[nodiscard]] const std::vector<TextureBarrier>& getTextureBarriers() const { return m_TextureBarriers; }
         [[nodiscard]] const std::vector<BufferBarrier>& getBufferBarriers() const { return m_BufferBarriers; }
-        void clearBarriers() { m_TextureBarriers.clear(); m_BufferBarriers.clear(); }
+        [[nodiscard]] const std::vector<AliasingBarrier>& getAliasingBarriers() const { return m_AliasingBarriers; }
+        [[nodiscard]] bool hasPendingBarriers() const { return !m_TextureBarriers.empty() || !m_BufferBarriers.empty() || !m_AliasingBarriers.empty(); }
+        void clearBarriers();
 
     private:
         IMessageCallback* m_MessageCallback;
 
-        std::unordered_map<TextureStateExtension*, std::unique_ptr<TextureState>> m_TextureStates;
-        std::unordered_map<BufferStateExtension*, std::unique_ptr<BufferState>> m_BufferStates;
+        // Unique nonzero ID of this tracker, stored in the upper half of the TrackerSlot values.
+        uint64_t m_TrackerId;
+
+        // Resources tracked in the current recording, in the order of first use.
+        // The state of m_TrackedTextures[i] is m_TextureStateArena[i]; the arenas are never shrunk,
+        // and std::deque keeps the addresses of the entries stable when it grows.
+        std::vector<TextureStateExtension*> m_TrackedTextures;
+        std::vector<BufferStateExtension*> m_TrackedBuffers;
+        std::deque<TextureState> m_TextureStateArena;
+        std::deque<BufferState> m_BufferStateArena;
+
+        // Slot indices of the resources whose trackerSlot was claimed by another tracker.
+        std::unordered_map<TextureStateExtension*, uint32_t> m_TextureSlotOverflow;
+        std::unordered_map<BufferStateExtension*, uint32_t> m_BufferSlotOverflow;
 
         // Deferred transitions of textures and buffers to permanent states.
         // They are executed only when the command list is executed, not when the app calls setPermanentTextureState or setPermanentBufferState.
@@ -131,6 +256,48 @@ namespace nvrhi
 
         std::vector<TextureBarrier> m_TextureBarriers;
         std::vector<BufferBarrier> m_BufferBarriers;
+        std::vector<AliasingBarrier> m_AliasingBarriers;
+
+        // Split transitions that were started and not ended yet.
+        // The End barriers are copies of the Begin barriers, which the backends require to match exactly.
+        struct SplitTransition
+        {
+            uint32_t id = 0;
+            // True when the Begin barriers have been committed into the command list.
+            bool committed = false;
+            TextureStateExtension* texture = nullptr;
+            BufferStateExtension* buffer = nullptr;
+            std::vector<TextureBarrier> textureBarriers;
+            std::vector<BufferBarrier> bufferBarriers;
+        };
+
+        bool m_DeferInitialStates = false;
+        bool m_StatisticsEnabled = false;
+        BarrierStatistics m_Statistics;
+
+        // First-use states of resources with unknown states, assumed by this command list (stateBefore is unused)
+        std::vector<StateFixup> m_DeferredInitialStates;
+
+        // Incremented whenever any tracked state changes, which invalidates m_SatisfiedStateLists.
+        uint64_t m_StateGeneration = 1;
+
+        // Direct-mapped cache of the lists passed to requireResourceStates and the generation after they were applied.
+        struct SatisfiedStateList
+        {
+            const void* key = nullptr;
+            uint64_t generation = 0;
+        };
+        static constexpr uint32_t c_SatisfiedStateListCacheSize = 64;
+        std::array<SatisfiedStateList, c_SatisfiedStateListCacheSize> m_SatisfiedStateLists;
+
+        std::vector<SplitTransition> m_SplitTransitions;
+        uint32_t m_NextSplitTransitionId = 1;
+
+        void endSplitTransition(uint32_t id);
+
+        void addTextureOwnershipBarriers(TextureStateExtension* texture, TextureSubresourceSet subresources,
+            QueueOwnershipTransfer transfer, CommandQueue otherQueue, ResourceStates stateBits);
+        void addBufferOwnershipBarrier(BufferStateExtension* buffer, QueueOwnershipTransfer transfer, CommandQueue otherQueue, ResourceStates stateBits);
 
         TextureState* getTextureStateTracking(TextureStateExtension* texture, bool allowCreate);
         BufferState* getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate);
@@ -0,0 +1,553 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/streaming.h>
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi::streaming
+{
+    class StreamingService : public RefCounter<IStreamingService>
+    {
+    public:
+        StreamingService(IDevice* device, const StreamingServiceDesc& desc, CommandQueue queue);
+
+        UploadToken writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data,
+            size_t rowPitch, size_t depthPitch) override;
+        UploadToken writeBuffer(IBuffer* dest, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        UploadToken writeCompressedTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel,
+            const void* compressedData, size_t compressedSize, CompressionFormat format) override;
+        UploadToken writeCompressedBuffer(IBuffer* dest, const void* compressedData, size_t compressedSize,
+            CompressionFormat format, uint64_t uncompressedSize, uint64_t destOffsetBytes) override;
+        UploadToken submitPendingUploads() override;
+        bool isUploadComplete(UploadToken token) override;
+        bool queueWaitForUpload(CommandQueue waitQueue, UploadToken token) override;
+        uint64_t getPendingBytes() override;
+
+    private:
+        struct Request
+        {
+            UploadToken token = c_InvalidUploadToken;
+            TextureHandle texture;
+            BufferHandle buffer;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            size_t rowPitch = 0;
+            size_t depthPitch = 0;
+            uint64_t destOffsetBytes = 0;
+            std::vector<uint8_t> data;
+
+            // For compressed requests, 'data' is the compressed payload
+            bool compressed = false;
+            CompressionFormat format = 0;
+            uint64_t uncompressedSize = 0;
+        };
+
+        struct Submission
+        {
+            UploadToken lastToken = c_InvalidUploadToken;
+            uint64_t instance = 0;
+            EventQueryHandle query;
+            BufferHandle payloadBuffer;
+        };
+
+        DeviceHandle m_Device;
+        StreamingServiceDesc m_Desc;
+        CommandQueue m_Queue;
+
+        // Guards the pending requests, which can be added from any thread
+        std::mutex m_RequestMutex;
+        std::deque<Request> m_PendingRequests;
+        UploadToken m_LastIssuedToken = c_InvalidUploadToken;
+        uint64_t m_PendingBytes = 0;
+
+        // Guards the command list and the submissions
+        std::mutex m_SubmitMutex;
+        CommandListHandle m_CommandList;
+        std::deque<Submission> m_Submissions;
+        std::vector<EventQueryHandle> m_FreeQueries;
+        UploadToken m_LastSubmittedToken = c_InvalidUploadToken;
+        UploadToken m_LastCompletedToken = c_InvalidUploadToken;
+
+        // Buffers for the compressed payloads of finished submissions, ready for reuse
+        std::vector<BufferHandle> m_FreePayloadBuffers;
+
+        void error(const std::string& message) const;
+        UploadToken enqueue(Request&& request);
+        void requeue(std::vector<Request>& requests);
+        void retireSubmissions();
+        BufferHandle getPayloadBuffer(uint64_t size);
+        void recordCompressedRequests(const std::vector<Request>& requests, IBuffer* payloadBuffer);
+    };
+
+    StreamingService::StreamingService(IDevice* device, const StreamingServiceDesc& desc, CommandQueue queue)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_Queue(queue)
+    {
+    }
+
+    void StreamingService::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    UploadToken StreamingService::enqueue(Request&& request)
+    {
+        std::lock_guard lockGuard(m_RequestMutex);
+
+        request.token = ++m_LastIssuedToken;
+        m_PendingBytes += request.data.size();
+
+        UploadToken const token = request.token;
+        m_PendingRequests.push_back(std::move(request));
+        return token;
+    }
+
+    void StreamingService::requeue(std::vector<Request>& requests)
+    {
+        std::lock_guard lockGuard(m_RequestMutex);
+
+        // The requests were taken from the front of the queue, put them back there in the same order
+        for (auto it = requests.rbegin(); it != requests.rend(); ++it)
+        {
+            m_PendingBytes += it->data.size();
+            m_PendingRequests.push_front(std::move(*it));
+        }
+
+        requests.clear();
+    }
+
+    UploadToken StreamingService::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data,
+        size_t rowPitch, size_t depthPitch)
+    {
+        if (!dest || !data)
+        {
+            error("StreamingService::writeTexture: dest and data must not be NULL");
+            return c_InvalidUploadToken;
+        }
+
+        const TextureDesc& desc = dest->getDesc();
+        if (mipLevel >= desc.mipLevels || arraySlice >= desc.arraySize)
+        {
+            std::stringstream ss;
+            ss << "StreamingService::writeTexture: subresource (mip " << mipLevel << ", slice " << arraySlice
+                << ") is out of bounds for texture " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return c_InvalidUploadToken;
+        }
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        uint32_t const mipHeight = std::max(desc.height >> mipLevel, 1u);
+        uint32_t const mipDepth = (desc.dimension == TextureDimension::Texture3D) ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+        size_t const numRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        if (depthPitch == 0)
+            depthPitch = rowPitch * numRows;
+
+        Request request;
+        request.texture = dest;
+        request.arraySlice = arraySlice;
+        request.mipLevel = mipLevel;
+        request.rowPitch = rowPitch;
+        request.depthPitch = depthPitch;
+        request.data.resize(depthPitch * mipDepth);
+        memcpy(request.data.data(), data, request.data.size());
+
+        return enqueue(std::move(request));
+    }
+
+    UploadToken StreamingService::writeBuffer(IBuffer* dest, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        if (!dest || !data || dataSize == 0)
+        {
+            error("StreamingService::writeBuffer: dest and data must not be NULL, and dataSize must not be 0");
+            return c_InvalidUploadToken;
+        }
+
+        if (destOffsetBytes + dataSize > dest->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "StreamingService::writeBuffer: range [" << destOffsetBytes << ", " << destOffsetBytes + dataSize
+                << ") is out of bounds for buffer " << utils::DebugNameToString(dest->getDesc().debugName);
+            error(ss.str());
+            return c_InvalidUploadToken;
+        }
+
+        Request request;
+        request.buffer = dest;
+        request.destOffsetBytes = destOffsetBytes;
+        request.data.resize(dataSize);
+        memcpy(request.data.data(), data, dataSize);
+
+        return enqueue(std::move(request));
+    }
+
+    UploadToken StreamingService::writeCompressedTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel,
+        const void* compressedData, size_t compressedSize, CompressionFormat format)
+    {
+        if (!dest || !compressedData || compressedSize == 0)
+        {
+            error("StreamingService::writeCompressedTexture: dest and compressedData must not be NULL, and compressedSize must not be 0");
+            return c_InvalidUploadToken;
+        }
+
+        if (!m_Desc.decompressor || !m_Desc.decompressor->supportsFormat(format, true))
+        {
+            std::stringstream ss;
+            ss << "StreamingService::writeCompressedTexture: compression format " << format
+                << " is not supported by the decompressor, or there is no decompressor";
+            error(ss.str());
+            return c_InvalidUploadToken;
+        }
+
+        const TextureDesc& desc = dest->getDesc();
+        if (mipLevel >= desc.mipLevels || arraySlice >= desc.arraySize)
+        {
+            std::stringstream ss;
+            ss << "StreamingService::writeCompressedTexture: subresource (mip " << mipLevel << ", slice " << arraySlice
+                << ") is out of bounds for texture " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return c_InvalidUploadToken;
+        }
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        uint32_t const mipWidth = std::max(desc.width >> mipLevel, 1u);
+        uint32_t const mipHeight = std::max(desc.height >> mipLevel, 1u);
+        uint32_t const mipDepth = (desc.dimension == TextureDimension::Texture3D) ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+        uint64_t const numCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        uint64_t const numRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        Request request;
+        request.texture = dest;
+        request.arraySlice = arraySlice;
+        request.mipLevel = mipLevel;
+        request.compressed = true;
+        request.format = format;
+        request.uncompressedSize = numCols * formatInfo.bytesPerBlock * numRows * mipDepth;
+        request.data.resize(compressedSize);
+        memcpy(request.data.data(), compressedData, compressedSize);
+
+        return enqueue(std::move(request));
+    }
+
+    UploadToken StreamingService::writeCompressedBuffer(IBuffer* dest, const void* compressedData, size_t compressedSize,
+        CompressionFormat format, uint64_t uncompressedSize, uint64_t destOffsetBytes)
+    {
+        if (!dest || !compressedData || compressedSize == 0 || uncompressedSize == 0)
+        {
+            error("StreamingService::writeCompressedBuffer: dest and compressedData must not be NULL, and the sizes must not be 0");
+            return c_InvalidUploadToken;
+        }
+
+        if (!m_Desc.decompressor || !m_Desc.decompressor->supportsFormat(format, false))
+        {
+            std::stringstream ss;
+            ss << "StreamingService::writeCompressedBuffer: compression format " << format
+                << " is not supported by the decompressor, or there is no decompressor";
+            error(ss.str());
+            return c_InvalidUploadToken;
+        }
+
+        if (destOffsetBytes + uncompressedSize > dest->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "StreamingService::writeCompressedBuffer: range [" << destOffsetBytes << ", " << destOffsetBytes + uncompressedSize
+                << ") is out of bounds for buffer " << utils::DebugNameToString(dest->getDesc().debugName);
+            error(ss.str());
+            return c_InvalidUploadToken;
+        }
+
+        Request request;
+        request.buffer = dest;
+        request.destOffsetBytes = destOffsetBytes;
+        request.compressed = true;
+        request.format = format;
+        request.uncompressedSize = uncompressedSize;
+        request.data.resize(compressedSize);
+        memcpy(request.data.data(), compressedData, compressedSize);
+
+        return enqueue(std::move(request));
+    }
+
+    BufferHandle StreamingService::getPayloadBuffer(uint64_t size)
+    {
+        for (auto it = m_FreePayloadBuffers.begin(); it != m_FreePayloadBuffers.end(); ++it)
+        {
+            if ((*it)->getDesc().byteSize >= size)
+            {
+                BufferHandle buffer = *it;
+                m_FreePayloadBuffers.erase(it);
+                return buffer;
+            }
+        }
+
+        // Round up to reduce the number of distinct sizes, the budget limits how large the payloads get
+        uint64_t bufferSize = 64 * 1024;
+        while (bufferSize < size)
+            bufferSize *= 2;
+
+        return m_Device->createBuffer(BufferDesc()
+            .setByteSize(bufferSize)
+            .setCanHaveRawViews(true)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setDebugName("StreamingService/CompressedPayload"));
+    }
+
+    void StreamingService::recordCompressedRequests(const std::vector<Request>& requests, IBuffer* payloadBuffer)
+    {
+        // Upload all payloads first, so that the decompression work is not interleaved with copy barriers
+        constexpr uint64_t payloadAlignment = 256;
+        std::vector<uint64_t> payloadOffsets;
+        uint64_t payloadOffset = 0;
+
+        for (const Request& request : requests)
+        {
+            if (!request.compressed)
+                continue;
+
+            payloadOffsets.push_back(payloadOffset);
+            m_CommandList->writeBuffer(payloadBuffer, request.data.data(), request.data.size(), payloadOffset);
+            payloadOffset = align(payloadOffset + request.data.size(), payloadAlignment);
+        }
+
+        m_CommandList->setBufferState(payloadBuffer, ResourceStates::ShaderResource);
+        m_CommandList->commitBarriers();
+
+        size_t payloadIndex = 0;
+        for (const Request& request : requests)
+        {
+            if (!request.compressed)
+                continue;
+
+            DecompressionRequest decompression;
+            decompression.compressedBuffer = payloadBuffer;
+            decompression.compressedOffset = payloadOffsets[payloadIndex++];
+            decompression.compressedSize = request.data.size();
+            decompression.format = request.format;
+            decompression.uncompressedSize = request.uncompressedSize;
+            decompression.destBuffer = request.buffer;
+            decompression.destOffsetBytes = request.destOffsetBytes;
+            decompression.destTexture = request.texture;
+            decompression.arraySlice = request.arraySlice;
+            decompression.mipLevel = request.mipLevel;
+
+            if (!m_Desc.decompressor->recordDecompression(m_CommandList, decompression))
+            {
+                std::stringstream ss;
+                ss << "StreamingService: failed to record the decompression of request " << request.token;
+                error(ss.str());
+            }
+        }
+    }
+
+    UploadToken StreamingService::submitPendingUploads()
+    {
+        std::lock_guard submitLockGuard(m_SubmitMutex);
+
+        // Recycle the event queries of finished submissions
+        retireSubmissions();
+
+        // Create the command list before taking any requests, so that a failure leaves them pending
+        if (!m_CommandList)
+        {
+            m_CommandList = m_Device->createCommandList(CommandListParameters()
+                .setQueueType(m_Queue)
+                .setUploadChunkSize(m_Desc.uploadChunkSize));
+
+            if (!m_CommandList)
+            {
+                error("StreamingService: failed to create the upload command list");
+                return c_InvalidUploadToken;
+            }
+        }
+
+        // Take the requests that fit into the budget, but always at least one so that large requests make progress
+        std::vector<Request> requests;
+        {
+            std::lock_guard requestLockGuard(m_RequestMutex);
+
+            uint64_t batchBytes = 0;
+            while (!m_PendingRequests.empty())
+            {
+                Request& request = m_PendingRequests.front();
+                if (!requests.empty() && batchBytes + request.data.size() > m_Desc.maxBytesPerSubmit)
+                    break;
+
+                batchBytes += request.data.size();
+                requests.push_back(std::move(request));
+                m_PendingRequests.pop_front();
+            }
+
+            m_PendingBytes -= batchBytes;
+        }
+
+        if (requests.empty())
+            return c_InvalidUploadToken;
+
+        // All compressed payloads of the batch go into one GPU buffer that the decompressor reads from
+        uint64_t payloadBytes = 0;
+        for (const Request& request : requests)
+        {
+            if (request.compressed)
+                payloadBytes = align(payloadBytes + request.data.size(), uint64_t(256));
+        }
+
+        BufferHandle payloadBuffer;
+        if (payloadBytes != 0)
+        {
+            payloadBuffer = getPayloadBuffer(payloadBytes);
+            if (!payloadBuffer)
+            {
+                // Put the batch back so that its tokens are not reported as complete by later submissions
+                requeue(requests);
+                error("StreamingService: failed to create the compressed payload buffer");
+                return c_InvalidUploadToken;
+            }
+        }
+
+        m_CommandList->open();
+
+        if (payloadBuffer)
+            recordCompressedRequests(requests, payloadBuffer);
+
+        for (const Request& request : requests)
+        {
+            if (request.compressed)
+                continue;
+
+            if (request.texture)
+            {
+                m_CommandList->writeTexture(request.texture, request.arraySlice, request.mipLevel,
+                    request.data.data(), request.rowPitch, request.depthPitch);
+            }
+            else
+            {
+                m_CommandList->writeBuffer(request.buffer, request.data.data(), request.data.size(), request.destOffsetBytes);
+            }
+        }
+
+        m_CommandList->close();
+
+        Submission submission;
+        submission.lastToken = requests.back().token;
+        submission.instance = m_Device->executeCommandList(m_CommandList, m_Queue);
+        submission.payloadBuffer = std::move(payloadBuffer);
+
+        if (!m_FreeQueries.empty())
+        {
+            submission.query = m_FreeQueries.back();
+            m_FreeQueries.pop_back();
+            m_Device->resetEventQuery(submission.query);
+        }
+        else
+        {
+            submission.query = m_Device->createEventQuery();
+        }
+        m_Device->setEventQuery(submission.query, m_Queue);
+
+        m_Submissions.push_back(std::move(submission));
+        m_LastSubmittedToken = requests.back().token;
+
+        return m_LastSubmittedToken;
+    }
+
+    void StreamingService::retireSubmissions()
+    {
+        while (!m_Submissions.empty() && m_Device->pollEventQuery(m_Submissions.front().query))
+        {
+            m_LastCompletedToken = m_Submissions.front().lastToken;
+            m_FreeQueries.push_back(std::move(m_Submissions.front().query));
+            if (m_Submissions.front().payloadBuffer)
+                m_FreePayloadBuffers.push_back(std::move(m_Submissions.front().payloadBuffer));
+            m_Submissions.pop_front();
+        }
+    }
+
+    bool StreamingService::isUploadComplete(UploadToken token)
+    {
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        if (token <= m_LastCompletedToken)
+            return true;
+
+        retireSubmissions();
+
+        return token <= m_LastCompletedToken;
+    }
+
+    bool StreamingService::queueWaitForUpload(CommandQueue waitQueue, UploadToken token)
+    {
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        if (token == c_InvalidUploadToken || token > m_LastSubmittedToken)
+            return false;
+
+        if (token <= m_LastCompletedToken)
+            return true;
+
+        // Wait for the first submission that contains the request, submissions are ordered by token
+        for (const Submission& submission : m_Submissions)
+        {
+            if (submission.lastToken >= token)
+            {
+                if (waitQueue != m_Queue)
+                    m_Device->queueWaitForCommandList(waitQueue, m_Queue, submission.instance);
+                return true;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t StreamingService::getPendingBytes()
+    {
+        std::lock_guard lockGuard(m_RequestMutex);
+        return m_PendingBytes;
+    }
+
+    StreamingServiceHandle createStreamingService(IDevice* device, const StreamingServiceDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        CommandQueue queue = desc.queue;
+        if (desc.decompressor && queue == CommandQueue::Copy)
+            queue = CommandQueue::Compute;
+
+        if ((queue == CommandQueue::Copy && !device->queryFeatureSupport(Feature::CopyQueue)) ||
+            (queue == CommandQueue::Compute && !device->queryFeatureSupport(Feature::ComputeQueue)))
+        {
+            queue = CommandQueue::Graphics;
+        }
+
+        StreamingService* service = new StreamingService(device, desc, queue);
+        return StreamingServiceHandle::Create(service);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "submit-graph.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace nvrhi
+{
+    void buildSubmitBatches(const SubmitGraphDesc& graph, std::vector<SubmitBatch>& batches, std::vector<uint32_t>& nodeToBatch)
+    {
+        constexpr uint32_t c_NoBatch = ~0u;
+
+        batches.clear();
+        nodeToBatch.assign(graph.nodes.size(), c_NoBatch);
+
+        // The batch that the next dependency-free node on each queue can be appended to
+        std::array<uint32_t, size_t(CommandQueue::Count)> openBatches;
+        openBatches.fill(c_NoBatch);
+
+        std::vector<uint32_t> crossQueueDependencies;
+
+        for (size_t nodeIndex = 0; nodeIndex < graph.nodes.size(); nodeIndex++)
+        {
+            const SubmitNode& node = graph.nodes[nodeIndex];
+            assert(node.queue < CommandQueue::Count);
+
+            crossQueueDependencies.clear();
+            for (uint32_t dependency : node.dependencies)
+            {
+                assert(dependency < nodeIndex);
+                if (dependency >= nodeIndex)
+                    continue;
+
+                uint32_t dependencyBatch = nodeToBatch[dependency];
+                if (batches[dependencyBatch].queue == node.queue)
+                    continue;
+
+                if (std::find(crossQueueDependencies.begin(), crossQueueDependencies.end(), dependencyBatch) == crossQueueDependencies.end())
+                    crossQueueDependencies.push_back(dependencyBatch);
+            }
+
+            uint32_t& openBatch = openBatches[size_t(node.queue)];
+
+            if (openBatch != c_NoBatch && batches[openBatch].sealed)
+                openBatch = c_NoBatch;
+
+            // A node that waits for something has to start a new batch because the wait applies to the whole batch
+            if (openBatch == c_NoBatch || !crossQueueDependencies.empty() || !node.waits.empty())
+            {
+                openBatch = uint32_t(batches.size());
+
+                SubmitBatch& batch = batches.emplace_back();
+                batch.queue = node.queue;
+                batch.batchDependencies = crossQueueDependencies;
+                batch.waits = node.waits;
+
+                for (uint32_t dependencyBatch : crossQueueDependencies)
+                    batches[dependencyBatch].sealed = true;
+            }
+
+            SubmitBatch& batch = batches[openBatch];
+            batch.commandLists.insert(batch.commandLists.end(), node.commandLists.begin(), node.commandLists.end());
+            nodeToBatch[nodeIndex] = openBatch;
+        }
+    }
+}
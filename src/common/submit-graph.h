@@ -0,0 +1,50 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <vector>
+
+namespace nvrhi
+{
+    // A group of consecutive SubmitGraphDesc nodes on one queue that is submitted with one native submission.
+    struct SubmitBatch
+    {
+        CommandQueue queue = CommandQueue::Graphics;
+        std::vector<ICommandList*> commandLists;
+
+        // Indices of the earlier batches on other queues that this batch waits for
+        std::vector<uint32_t> batchDependencies;
+
+        // Instances from previous submissions that this batch waits for
+        std::vector<TimelinePoint> waits;
+
+        // Set when a batch on another queue depends on this one, so that no more nodes are appended to it
+        bool sealed = false;
+    };
+
+    // Splits the graph into batches, listed in an order where every batch comes after its dependencies.
+    // nodeToBatch receives the index of the batch for every node of the graph.
+    void buildSubmitBatches(const SubmitGraphDesc& graph, std::vector<SubmitBatch>& batches, std::vector<uint32_t>& nodeToBatch);
+}
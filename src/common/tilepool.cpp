@@ -0,0 +1,338 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/tilepool.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi::tiles
+{
+    class TilePool : public RefCounter<ITilePool>
+    {
+    public:
+        TilePool(IDevice* device, const TilePoolDesc& desc);
+
+        TileAllocation allocateTile() override;
+        void freeTile(const TileAllocation& tile) override;
+        void mapTile(ITexture* texture, const TiledTextureCoordinate& coordinate, const TileAllocation& tile) override;
+        void flush() override;
+        void trim() override;
+        TilePoolStatistics getStatistics() override;
+
+    private:
+        struct HeapEntry
+        {
+            HeapHandle heap;
+            std::vector<uint32_t> freeTiles;
+        };
+
+        struct PendingMapping
+        {
+            TiledTextureCoordinate coordinate;
+            IHeap* heap = nullptr;
+            uint64_t byteOffset = 0;
+        };
+
+        struct PendingTexture
+        {
+            TextureHandle texture;
+            std::vector<PendingMapping> mappings;
+        };
+
+        DeviceHandle m_Device;
+        TilePoolDesc m_Desc;
+        std::mutex m_Mutex;
+
+        std::vector<HeapEntry> m_Heaps;
+        std::vector<TileAllocation> m_FreedTiles; // returned to the free lists by the next flush
+        uint32_t m_AllocatedTiles = 0;
+
+        std::vector<PendingTexture> m_PendingTextures;
+        std::unordered_map<ITexture*, size_t> m_PendingTextureIndices;
+        uint32_t m_NumPendingMappings = 0;
+
+        void error(const std::string& message) const;
+        [[nodiscard]] HeapEntry* findHeap(const IHeap* heap);
+        void releaseFreedTiles();
+    };
+
+    static auto getCoordinateKey(const TiledTextureCoordinate& coordinate)
+    {
+        return std::make_tuple(coordinate.mipLevel, coordinate.arrayLevel, coordinate.z, coordinate.y, coordinate.x);
+    }
+
+    TilePool::TilePool(IDevice* device, const TilePoolDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+    }
+
+    void TilePool::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    TilePool::HeapEntry* TilePool::findHeap(const IHeap* heap)
+    {
+        for (HeapEntry& entry : m_Heaps)
+        {
+            if (entry.heap == heap)
+                return &entry;
+        }
+
+        return nullptr;
+    }
+
+    TileAllocation TilePool::allocateTile()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Fill the heaps in order, which keeps the later heaps empty for trim()
+        HeapEntry* heapEntry = nullptr;
+        for (HeapEntry& entry : m_Heaps)
+        {
+            if (!entry.freeTiles.empty())
+            {
+                heapEntry = &entry;
+                break;
+            }
+        }
+
+        if (!heapEntry)
+        {
+            if (m_Desc.tilesPerHeap == 0 || (m_Desc.maxHeaps != 0 && m_Heaps.size() >= m_Desc.maxHeaps))
+                return TileAllocation();
+
+            HeapDesc heapDesc;
+            heapDesc.capacity = c_TileSizeInBytes * m_Desc.tilesPerHeap;
+            heapDesc.type = HeapType::DeviceLocal;
+            heapDesc.debugName = m_Desc.debugName + "/Heap" + std::to_string(m_Heaps.size());
+
+            HeapHandle heap = m_Device->createHeap(heapDesc);
+            if (!heap)
+            {
+                std::stringstream ss;
+                ss << "TilePool " << utils::DebugNameToString(m_Desc.debugName)
+                    << ": failed to create a heap with capacity " << heapDesc.capacity;
+                error(ss.str());
+                return TileAllocation();
+            }
+
+            HeapEntry& entry = m_Heaps.emplace_back();
+            entry.heap = heap;
+
+            // Reversed so that the tiles are handed out from the beginning of the heap
+            entry.freeTiles.resize(m_Desc.tilesPerHeap);
+            for (uint32_t i = 0; i < m_Desc.tilesPerHeap; i++)
+                entry.freeTiles[i] = m_Desc.tilesPerHeap - 1 - i;
+
+            heapEntry = &entry;
+        }
+
+        const uint32_t tileIndex = heapEntry->freeTiles.back();
+        heapEntry->freeTiles.pop_back();
+        ++m_AllocatedTiles;
+
+        TileAllocation tile;
+        tile.heap = heapEntry->heap;
+        tile.byteOffset = tileIndex * c_TileSizeInBytes;
+        return tile;
+    }
+
+    void TilePool::freeTile(const TileAllocation& tile)
+    {
+        if (!tile.isValid())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!findHeap(tile.heap))
+        {
+            std::stringstream ss;
+            ss << "TilePool " << utils::DebugNameToString(m_Desc.debugName)
+                << ": freeTile called with a tile that doesn't belong to the pool";
+            error(ss.str());
+            return;
+        }
+
+        m_FreedTiles.push_back(tile);
+    }
+
+    void TilePool::mapTile(ITexture* texture, const TiledTextureCoordinate& coordinate, const TileAllocation& tile)
+    {
+        if (!texture)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto [it, inserted] = m_PendingTextureIndices.try_emplace(texture, m_PendingTextures.size());
+        if (inserted)
+            m_PendingTextures.emplace_back().texture = texture;
+
+        PendingMapping& mapping = m_PendingTextures[it->second].mappings.emplace_back();
+        mapping.coordinate = coordinate;
+        mapping.heap = tile.heap;
+        mapping.byteOffset = tile.byteOffset;
+
+        ++m_NumPendingMappings;
+    }
+
+    void TilePool::releaseFreedTiles()
+    {
+        for (const TileAllocation& tile : m_FreedTiles)
+        {
+            HeapEntry* heapEntry = findHeap(tile.heap);
+            if (heapEntry)
+            {
+                heapEntry->freeTiles.push_back(uint32_t(tile.byteOffset / c_TileSizeInBytes));
+                --m_AllocatedTiles;
+            }
+        }
+
+        m_FreedTiles.clear();
+    }
+
+    void TilePool::flush()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_PendingTextures.empty())
+        {
+            releaseFreedTiles();
+            return;
+        }
+
+        // Keep only the last mapping of every tile, then group the mappings by heap:
+        // a TextureTilesMapping refers to a single heap, or to no heap for the unmapped tiles.
+        size_t numMappings = 0;
+        for (PendingTexture& pending : m_PendingTextures)
+        {
+            std::vector<PendingMapping>& mappings = pending.mappings;
+
+            std::stable_sort(mappings.begin(), mappings.end(), [](const PendingMapping& a, const PendingMapping& b)
+                { return getCoordinateKey(a.coordinate) < getCoordinateKey(b.coordinate); });
+
+            size_t numUnique = 0;
+            for (size_t i = 0; i < mappings.size(); i++)
+            {
+                const bool supersededByNext = i + 1 < mappings.size()
+                    && getCoordinateKey(mappings[i].coordinate) == getCoordinateKey(mappings[i + 1].coordinate);
+
+                if (!supersededByNext)
+                    mappings[numUnique++] = mappings[i];
+            }
+            mappings.resize(numUnique);
+
+            std::stable_sort(mappings.begin(), mappings.end(), [](const PendingMapping& a, const PendingMapping& b)
+                { return std::less<IHeap*>()(a.heap, b.heap); });
+
+            numMappings += mappings.size();
+        }
+
+        // Sized up front because the TextureTilesMapping structures point into these arrays
+        std::vector<TiledTextureCoordinate> coordinates(numMappings);
+        std::vector<TiledTextureRegion> regions(numMappings);
+        std::vector<uint64_t> byteOffsets(numMappings);
+        std::vector<TextureTilesMapping> tileMappings;
+        std::vector<TextureTilesMappingUpdate> updates;
+        tileMappings.reserve(numMappings);
+        updates.reserve(m_PendingTextures.size());
+
+        size_t mappingIndex = 0;
+        for (const PendingTexture& pending : m_PendingTextures)
+        {
+            TextureTilesMappingUpdate& update = updates.emplace_back();
+            update.texture = pending.texture;
+            update.tileMappings = tileMappings.data() + tileMappings.size();
+
+            for (size_t i = 0; i < pending.mappings.size(); i++)
+            {
+                const PendingMapping& mapping = pending.mappings[i];
+
+                if (i == 0 || mapping.heap != pending.mappings[i - 1].heap)
+                {
+                    TextureTilesMapping& tileMapping = tileMappings.emplace_back();
+                    tileMapping.tiledTextureCoordinates = coordinates.data() + mappingIndex;
+                    tileMapping.tiledTextureRegions = regions.data() + mappingIndex;
+                    tileMapping.byteOffsets = byteOffsets.data() + mappingIndex;
+                    tileMapping.heap = mapping.heap;
+                    ++update.numTileMappings;
+                }
+
+                coordinates[mappingIndex] = mapping.coordinate;
+
+                // A box of one tile, which the backends convert to a single tile on both D3D12 and Vulkan
+                regions[mappingIndex].width = 1;
+                regions[mappingIndex].height = 1;
+                regions[mappingIndex].depth = 1;
+
+                byteOffsets[mappingIndex] = mapping.byteOffset;
+
+                ++tileMappings.back().numTextureRegions;
+                ++mappingIndex;
+            }
+        }
+
+        m_Device->updateTextureTileMappingsBatch(updates.data(), uint32_t(updates.size()), m_Desc.queue);
+
+        m_PendingTextures.clear();
+        m_PendingTextureIndices.clear();
+        m_NumPendingMappings = 0;
+
+        releaseFreedTiles();
+    }
+
+    void TilePool::trim()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Heaps.erase(std::remove_if(m_Heaps.begin(), m_Heaps.end(), [this](const HeapEntry& entry)
+            { return entry.freeTiles.size() == m_Desc.tilesPerHeap; }), m_Heaps.end());
+    }
+
+    TilePoolStatistics TilePool::getStatistics()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        TilePoolStatistics statistics;
+        statistics.numHeaps = uint32_t(m_Heaps.size());
+        statistics.heapBytes = uint64_t(m_Heaps.size()) * m_Desc.tilesPerHeap * c_TileSizeInBytes;
+        statistics.allocatedTiles = m_AllocatedTiles;
+        statistics.freeTiles = uint32_t(m_Heaps.size()) * m_Desc.tilesPerHeap - m_AllocatedTiles;
+        statistics.pendingMappings = m_NumPendingMappings;
+        return statistics;
+    }
+
+    TilePoolHandle createTilePool(IDevice* device, const TilePoolDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        return TilePoolHandle::Create(new TilePool(device, desc));
+    }
+}
@@ -0,0 +1,479 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/transient.h>
+#include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi::transient
+{
+    // Resources of different classes are placed into separate heaps because some devices,
+    // such as D3D12 resource heap tier 1 devices, don't allow mixing them in one heap.
+    enum class HeapClass : uint8_t
+    {
+        Buffers,
+        RenderTargets,
+        Textures,
+
+        Count
+    };
+
+    static const char* c_HeapClassNames[] = { "Buffers", "RenderTargets", "Textures" };
+
+    class TransientResourcePool : public RefCounter<ITransientResourcePool>
+    {
+    public:
+        TransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc);
+
+        TransientResourceIndex declareTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass) override;
+        TransientResourceIndex declareBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass) override;
+        bool compile() override;
+        ITexture* getTexture(TransientResourceIndex index) override;
+        IBuffer* getBuffer(TransientResourceIndex index) override;
+        void beginPass(ICommandList* commandList, uint32_t passIndex) override;
+        void reset() override;
+        TransientPoolStatistics getStatistics() override;
+
+    private:
+        struct Resource
+        {
+            TextureDesc textureDesc;
+            BufferDesc bufferDesc;
+            bool isTexture = false;
+            uint32_t firstPass = 0;
+            uint32_t lastPass = 0;
+            HeapClass heapClass = HeapClass::Buffers;
+
+            TextureHandle texture;
+            BufferHandle buffer;
+            MemoryRequirements memoryRequirements;
+            uint64_t offset = 0;
+            bool placed = false;
+
+            // The only other resource that shares memory with this one, used as the 'before' resource of the
+            // aliasing barrier. If there are several such resources, the barrier synchronizes with all of them.
+            TransientResourceIndex aliasedResource = c_InvalidTransientResource;
+        };
+
+        DeviceHandle m_Device;
+        TransientResourcePoolDesc m_Desc;
+        std::vector<Resource> m_Resources;
+        std::vector<TransientResourceIndex> m_ResourcesByFirstPass;
+        HeapHandle m_Heaps[size_t(HeapClass::Count)];
+
+        void error(const std::string& message) const;
+        [[nodiscard]] IResource* getResource(const Resource& resource) const;
+        bool createResource(Resource& resource, bool isVirtual);
+        uint64_t placeResources(HeapClass heapClass);
+        void findAliasedResources(HeapClass heapClass);
+    };
+
+    static bool lifetimesOverlap(uint32_t firstPassA, uint32_t lastPassA, uint32_t firstPassB, uint32_t lastPassB)
+    {
+        return firstPassA <= lastPassB && firstPassB <= lastPassA;
+    }
+
+    static bool rangesOverlap(uint64_t offsetA, uint64_t sizeA, uint64_t offsetB, uint64_t sizeB)
+    {
+        return offsetA < offsetB + sizeB && offsetB < offsetA + sizeA;
+    }
+
+    // Returns a state that the texture can be kept in between command lists when it's not aliased
+    static ResourceStates getDefaultTextureState(const TextureDesc& desc)
+    {
+        if (desc.isRenderTarget)
+            return getFormatInfo(desc.format).hasDepth ? ResourceStates::DepthWrite : ResourceStates::RenderTarget;
+        if (desc.isUAV)
+            return ResourceStates::UnorderedAccess;
+        return ResourceStates::ShaderResource;
+    }
+
+    TransientResourcePool::TransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    {
+    }
+
+    void TransientResourcePool::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    IResource* TransientResourcePool::getResource(const Resource& resource) const
+    {
+        if (resource.isTexture)
+            return resource.texture.Get();
+
+        return resource.buffer.Get();
+    }
+
+    TransientResourceIndex TransientResourcePool::declareTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass)
+    {
+        if (firstPass > lastPass)
+        {
+            std::stringstream ss;
+            ss << "TransientResourcePool::declareTexture: firstPass (" << firstPass << ") is greater than lastPass ("
+                << lastPass << ") for texture " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return c_InvalidTransientResource;
+        }
+
+        Resource resource;
+        resource.textureDesc = desc;
+        resource.isTexture = true;
+        resource.firstPass = firstPass;
+        resource.lastPass = lastPass;
+        resource.heapClass = desc.isRenderTarget ? HeapClass::RenderTargets : HeapClass::Textures;
+        m_Resources.push_back(std::move(resource));
+
+        return TransientResourceIndex(m_Resources.size() - 1);
+    }
+
+    TransientResourceIndex TransientResourcePool::declareBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass)
+    {
+        if (firstPass > lastPass)
+        {
+            std::stringstream ss;
+            ss << "TransientResourcePool::declareBuffer: firstPass (" << firstPass << ") is greater than lastPass ("
+                << lastPass << ") for buffer " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return c_InvalidTransientResource;
+        }
+
+        if (desc.cpuAccess != CpuAccessMode::None || desc.isVolatile)
+        {
+            std::stringstream ss;
+            ss << "TransientResourcePool::declareBuffer: buffer " << utils::DebugNameToString(desc.debugName)
+                << " is CPU-accessible or volatile, which is not supported for transient buffers";
+            error(ss.str());
+            return c_InvalidTransientResource;
+        }
+
+        Resource resource;
+        resource.bufferDesc = desc;
+        resource.isTexture = false;
+        resource.firstPass = firstPass;
+        resource.lastPass = lastPass;
+        resource.heapClass = HeapClass::Buffers;
+        m_Resources.push_back(std::move(resource));
+
+        return TransientResourceIndex(m_Resources.size() - 1);
+    }
+
+    bool TransientResourcePool::createResource(Resource& resource, bool isVirtual)
+    {
+        resource.texture = nullptr;
+        resource.buffer = nullptr;
+        resource.memoryRequirements = MemoryRequirements();
+        resource.placed = false;
+        resource.aliasedResource = c_InvalidTransientResource;
+
+        // Placed resources get their state from the aliasing barrier in beginPass. Resources that could not be placed
+        // behave like regular resources and keep their state between command lists.
+        if (resource.isTexture)
+        {
+            TextureDesc desc = resource.textureDesc;
+            desc.isVirtual = isVirtual;
+            desc.keepInitialState = !isVirtual;
+            desc.initialState = isVirtual ? ResourceStates::Unknown : getDefaultTextureState(desc);
+
+            resource.texture = m_Device->createTexture(desc);
+            if (resource.texture && isVirtual)
+                resource.memoryRequirements = m_Device->getTextureMemoryRequirements(resource.texture);
+
+            return resource.texture != nullptr;
+        }
+
+        BufferDesc desc = resource.bufferDesc;
+        desc.isVirtual = isVirtual;
+        desc.keepInitialState = !isVirtual;
+        desc.initialState = isVirtual ? ResourceStates::Unknown : ResourceStates::Common;
+
+        resource.buffer = m_Device->createBuffer(desc);
+        if (resource.buffer && isVirtual)
+            resource.memoryRequirements = m_Device->getBufferMemoryRequirements(resource.buffer);
+
+        return resource.buffer != nullptr;
+    }
+
+    uint64_t TransientResourcePool::placeResources(HeapClass heapClass)
+    {
+        std::vector<Resource*> resources;
+        for (Resource& resource : m_Resources)
+        {
+            if (resource.heapClass == heapClass && resource.memoryRequirements.size != 0)
+                resources.push_back(&resource);
+        }
+
+        // Place the largest resources first, that gives tighter packing for typical render target sets
+        std::stable_sort(resources.begin(), resources.end(), [](const Resource* a, const Resource* b)
+        {
+            return a->memoryRequirements.size > b->memoryRequirements.size;
+        });
+
+        std::vector<Resource*> placedResources;
+        std::vector<Resource*> liveResources;
+        uint64_t heapSize = 0;
+
+        for (Resource* resource : resources)
+        {
+            const uint64_t size = resource->memoryRequirements.size;
+            const uint64_t alignment = std::max<uint64_t>(resource->memoryRequirements.alignment, 1);
+
+            // Find the placed resources that are alive at the same time as this one, in memory order
+            liveResources.clear();
+            for (Resource* placed : placedResources)
+            {
+                if (lifetimesOverlap(placed->firstPass, placed->lastPass, resource->firstPass, resource->lastPass))
+                    liveResources.push_back(placed);
+            }
+
+            std::sort(liveResources.begin(), liveResources.end(), [](const Resource* a, const Resource* b)
+            {
+                return a->offset < b->offset;
+            });
+
+            // Take the first gap between the live resources that fits this one
+            uint64_t offset = 0;
+            for (const Resource* live : liveResources)
+            {
+                if (align(offset, alignment) + size <= live->offset)
+                    break;
+
+                offset = std::max(offset, live->offset + live->memoryRequirements.size);
+            }
+
+            resource->offset = align(offset, alignment);
+            resource->placed = true;
+            heapSize = std::max(heapSize, resource->offset + size);
+
+            placedResources.push_back(resource);
+        }
+
+        return heapSize;
+    }
+
+    void TransientResourcePool::findAliasedResources(HeapClass heapClass)
+    {
+        for (Resource& resource : m_Resources)
+        {
+            if (!resource.placed || resource.heapClass != heapClass)
+                continue;
+
+            uint32_t numAliased = 0;
+            for (size_t index = 0; index < m_Resources.size(); index++)
+            {
+                const Resource& other = m_Resources[index];
+                if (&other == &resource || !other.placed || other.heapClass != heapClass)
+                    continue;
+
+                if (rangesOverlap(resource.offset, resource.memoryRequirements.size, other.offset, other.memoryRequirements.size))
+                {
+                    resource.aliasedResource = TransientResourceIndex(index);
+                    ++numAliased;
+                }
+            }
+
+            if (numAliased != 1)
+                resource.aliasedResource = c_InvalidTransientResource;
+        }
+    }
+
+    bool TransientResourcePool::compile()
+    {
+        m_ResourcesByFirstPass.clear();
+
+        const bool virtualResources = m_Device->queryFeatureSupport(Feature::VirtualResources);
+
+        for (Resource& resource : m_Resources)
+        {
+            if (!createResource(resource, virtualResources))
+            {
+                std::stringstream ss;
+                ss << "TransientResourcePool " << utils::DebugNameToString(m_Desc.debugName) << ": failed to create "
+                    << (resource.isTexture ? "texture " : "buffer ")
+                    << utils::DebugNameToString(resource.isTexture ? resource.textureDesc.debugName : resource.bufferDesc.debugName);
+                error(ss.str());
+                return false;
+            }
+        }
+
+        if (virtualResources)
+        {
+            for (size_t classIndex = 0; classIndex < size_t(HeapClass::Count); classIndex++)
+            {
+                const HeapClass heapClass = HeapClass(classIndex);
+                const uint64_t heapSize = placeResources(heapClass);
+                if (heapSize == 0)
+                    continue;
+
+                HeapHandle& heap = m_Heaps[classIndex];
+                if (!heap || heap->getDesc().capacity < heapSize)
+                {
+                    heap = nullptr;
+
+                    HeapDesc heapDesc;
+                    heapDesc.capacity = align(heapSize, std::max<uint64_t>(m_Desc.heapSizeGranularity, 1));
+                    heapDesc.type = HeapType::DeviceLocal;
+                    heapDesc.debugName = m_Desc.debugName + "/" + c_HeapClassNames[classIndex];
+
+                    heap = m_Device->createHeap(heapDesc);
+                    if (!heap)
+                    {
+                        std::stringstream ss;
+                        ss << "TransientResourcePool " << utils::DebugNameToString(m_Desc.debugName)
+                            << ": failed to create a heap with capacity " << heapDesc.capacity;
+                        error(ss.str());
+                        return false;
+                    }
+                }
+
+                bool allBound = true;
+                for (Resource& resource : m_Resources)
+                {
+                    if (!resource.placed || resource.heapClass != heapClass)
+                        continue;
+
+                    const bool bound = resource.isTexture
+                        ? m_Device->bindTextureMemory(resource.texture, heap, resource.offset)
+                        : m_Device->bindBufferMemory(resource.buffer, heap, resource.offset);
+
+                    if (!bound)
+                    {
+                        allBound = false;
+                        break;
+                    }
+                }
+
+                if (!allBound)
+                {
+                    // The heap doesn't accept this class of resources on this device, create them without aliasing
+                    heap = nullptr;
+
+                    for (Resource& resource : m_Resources)
+                    {
+                        if (resource.heapClass == heapClass && !createResource(resource, false))
+                            return false;
+                    }
+
+                    continue;
+                }
+
+                findAliasedResources(heapClass);
+            }
+        }
+
+        m_ResourcesByFirstPass.resize(m_Resources.size());
+        for (size_t index = 0; index < m_Resources.size(); index++)
+            m_ResourcesByFirstPass[index] = TransientResourceIndex(index);
+
+        std::stable_sort(m_ResourcesByFirstPass.begin(), m_ResourcesByFirstPass.end(),
+            [this](TransientResourceIndex a, TransientResourceIndex b)
+        {
+            return m_Resources[a].firstPass < m_Resources[b].firstPass;
+        });
+
+        return true;
+    }
+
+    ITexture* TransientResourcePool::getTexture(TransientResourceIndex index)
+    {
+        if (index >= m_Resources.size())
+            return nullptr;
+
+        return m_Resources[index].texture;
+    }
+
+    IBuffer* TransientResourcePool::getBuffer(TransientResourceIndex index)
+    {
+        if (index >= m_Resources.size())
+            return nullptr;
+
+        return m_Resources[index].buffer;
+    }
+
+    void TransientResourcePool::beginPass(ICommandList* commandList, uint32_t passIndex)
+    {
+        auto it = std::lower_bound(m_ResourcesByFirstPass.begin(), m_ResourcesByFirstPass.end(), passIndex,
+            [this](TransientResourceIndex index, uint32_t pass)
+        {
+            return m_Resources[index].firstPass < pass;
+        });
+
+        for (; it != m_ResourcesByFirstPass.end() && m_Resources[*it].firstPass == passIndex; ++it)
+        {
+            const Resource& resource = m_Resources[*it];
+            if (!resource.placed)
+                continue;
+
+            IResource* resourceBefore = resource.aliasedResource != c_InvalidTransientResource
+                ? getResource(m_Resources[resource.aliasedResource])
+                : nullptr;
+
+            commandList->setAliasingBarrier(resourceBefore, getResource(resource));
+        }
+    }
+
+    void TransientResourcePool::reset()
+    {
+        m_Resources.clear();
+        m_ResourcesByFirstPass.clear();
+    }
+
+    TransientPoolStatistics TransientResourcePool::getStatistics()
+    {
+        TransientPoolStatistics statistics;
+
+        for (const HeapHandle& heap : m_Heaps)
+        {
+            if (heap)
+            {
+                statistics.heapBytes += heap->getDesc().capacity;
+                ++statistics.numHeaps;
+            }
+        }
+
+        for (const Resource& resource : m_Resources)
+        {
+            if (resource.texture || resource.buffer)
+                ++statistics.numResources;
+
+            if (resource.placed)
+                statistics.unaliasedBytes += resource.memoryRequirements.size;
+        }
+
+        return statistics;
+    }
+
+    TransientResourcePoolHandle createTransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc)
+    {
+        if (!device)
+            return nullptr;
+
+        return TransientResourcePoolHandle::Create(new TransientResourcePool(device, desc));
+    }
+}
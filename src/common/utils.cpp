@@ -172,10 +172,66 @@ namespace nvrhi::utils
         case GraphicsAPI::D3D11:  return "D3D11";
         case GraphicsAPI::D3D12:  return "D3D12";
         case GraphicsAPI::VULKAN: return "Vulkan";
+        case GraphicsAPI::NONE:   return "Null";
         default:                         return "<UNKNOWN>";
         }
     }
 
+    const char* InstrumentationZoneToString(InstrumentationZone zone)
+    {
+        switch (zone)
+        {
+        case InstrumentationZone::CreateGraphicsPipeline:   return "CreateGraphicsPipeline";
+        case InstrumentationZone::CreateComputePipeline:    return "CreateComputePipeline";
+        case InstrumentationZone::CreateMeshletPipeline:    return "CreateMeshletPipeline";
+        case InstrumentationZone::CreateRayTracingPipeline: return "CreateRayTracingPipeline";
+        case InstrumentationZone::CreateBindingSet:         return "CreateBindingSet";
+        case InstrumentationZone::AllocateUploadChunk:      return "AllocateUploadChunk";
+        case InstrumentationZone::CommitBarriers:           return "CommitBarriers";
+        case InstrumentationZone::ExecuteCommandLists:      return "ExecuteCommandLists";
+        case InstrumentationZone::GarbageCollection:        return "GarbageCollection";
+        case InstrumentationZone::Count:
+        default:                                            return "<UNKNOWN>";
+        }
+    }
+
+    const char* ResourceAllocationTypeToString(ResourceAllocationType type)
+    {
+        switch (type)
+        {
+        case ResourceAllocationType::Buffer:         return "Buffer";
+        case ResourceAllocationType::Texture:        return "Texture";
+        case ResourceAllocationType::AccelStruct:    return "AccelStruct";
+        case ResourceAllocationType::Heap:           return "Heap";
+        case ResourceAllocationType::UploadChunk:    return "UploadChunk";
+        case ResourceAllocationType::DescriptorHeap: return "DescriptorHeap";
+        default:                                     return "<UNKNOWN>";
+        }
+    }
+
+    const char* PipelineTypeToString(PipelineType type)
+    {
+        switch (type)
+        {
+        case PipelineType::Graphics:   return "Graphics";
+        case PipelineType::Compute:    return "Compute";
+        case PipelineType::Meshlet:    return "Meshlet";
+        case PipelineType::RayTracing: return "RayTracing";
+        default:                       return "<UNKNOWN>";
+        }
+    }
+
+    const char* PipelineCacheResultToString(PipelineCacheResult result)
+    {
+        switch (result)
+        {
+        case PipelineCacheResult::Unknown: return "Unknown";
+        case PipelineCacheResult::Hit:     return "Hit";
+        case PipelineCacheResult::Miss:    return "Miss";
+        default:                           return "<UNKNOWN>";
+        }
+    }
+
     const char* TextureDimensionToString(TextureDimension dimension)
     {
         switch (dimension)
@@ -360,6 +416,7 @@ namespace nvrhi::utils
         if (desc.isAccelStructBuildInput) ss << ", IsAccelStructBuildInput";
         if (desc.isAccelStructStorage) ss << ", IsAccelStructStorage";
         if (desc.isShaderBindingTable) ss << ", IsShaderBindingTable";
+        if (desc.isPredicationBuffer) ss << ", IsPredicationBuffer";
 
         ss << ")";
 
@@ -429,4 +486,22 @@ namespace nvrhi::utils
         }
     }
 
+    void BitSetAllocator::resize(const size_t capacity)
+    {
+        if (m_MultiThreaded)
+            m_Mutex.lock();
+
+        const size_t oldCapacity = m_Allocated.size();
+        m_Allocated.resize(capacity);
+
+        // Continue with the new bits when growing, the search wraps around to any free bits below
+        if (capacity > oldCapacity)
+            m_NextAvailable = static_cast<int>(oldCapacity);
+        else if (m_NextAvailable >= static_cast<int>(capacity))
+            m_NextAvailable = 0;
+
+        if (m_MultiThreaded)
+            m_Mutex.unlock();
+    }
+
 }
@@ -20,6 +20,8 @@
 * DEALINGS IN THE SOFTWARE.
 */
 
+#include <atomic>
+
 namespace nvrhi
 {
     /*
@@ -59,4 +61,25 @@ namespace nvrhi
     {
         return (version & c_VersionSubmittedFlag) != 0;
     }
+
+    /*
+    Stores the version of the last command list recording that referenced an object, so that
+    the recording keeps one reference to the object no matter how many times it's bound.
+    Only the recording that stored its version can observe it, so concurrent recordings can
+    at worst take a redundant reference.
+     */
+    struct LastRecordingReference
+    {
+        std::atomic<uint64_t> version = 0;
+
+        // Returns true when the recording hasn't referenced the object yet
+        bool markReferenced(uint64_t recordingVersion)
+        {
+            if (version.load(std::memory_order_relaxed) == recordingVersion)
+                return false;
+
+            version.store(recordingVersion, std::memory_order_relaxed);
+            return true;
+        }
+    };
 }
\ No newline at end of file
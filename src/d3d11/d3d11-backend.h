@@ -25,10 +25,18 @@
 #include <nvrhi/d3d11.h>
 #include <nvrhi/common/resourcebindingmap.h>
 #include <nvrhi/utils.h>
+#include "../common/command-list-statistics.h"
 #include "../common/dxgi-format.h"
+#include "../common/instrumentation.h"
+#include "../common/memory-statistics.h"
+#include "../common/pipeline-compile-pool.h"
+#include "../common/pipeline-statistics.h"
 
 #include <d3d11_1.h>
+#include <dxgi1_4.h>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #ifndef NVRHI_D3D11_WITH_NVAPI
@@ -57,14 +65,21 @@ namespace nvrhi::d3d11
     D3D11_TEXTURE_ADDRESS_MODE convertSamplerAddressMode(SamplerAddressMode mode);
     UINT convertSamplerReductionType(SamplerReductionType reductionType);
 
+    class VolatileConstantRing;
+
     struct Context
     {
         RefCountPtr<ID3D11Device> device;
         RefCountPtr<ID3D11DeviceContext> immediateContext;
         RefCountPtr<ID3D11DeviceContext1> immediateContext1;
         RefCountPtr<ID3D11Buffer> pushConstantBuffer;
+        std::unique_ptr<VolatileConstantRing> volatileConstantRing; // null if not enabled or not supported
         IMessageCallback* messageCallback = nullptr;
+        InstrumentationHook instrumentation;
+        mutable MemoryCounters memoryCounters;
+        PipelineCreationCounters pipelineCounters;
         bool nvapiAvailable = false;
+        bool driverCommandLists = false; // see D3D11_FEATURE_DATA_THREADING::DriverCommandLists
 #if NVRHI_WITH_AFTERMATH
         GFSDK_Aftermath_ContextHandle aftermathContext = nullptr;
 #endif
@@ -72,12 +87,35 @@ namespace nvrhi::d3d11
         void error(const std::string& message) const;
     };
 
+    // Dynamic constant buffer that the volatile constant buffer writes are sub-allocated from,
+    // see DeviceDesc::volatileConstantRingSize. Whenever the writes wrap around, the ring is discarded,
+    // which makes all previous writes invalid, and its generation is incremented.
+    class VolatileConstantRing
+    {
+    public:
+        VolatileConstantRing(const Context& context, ID3D11Buffer* buffer, uint32_t size);
+
+        ID3D11Buffer* getBuffer() const { return m_Buffer; }
+        uint32_t getGeneration() const { return m_Generation; }
+
+        // Copies the data into the next range of the ring, returns false if the Map call failed
+        bool write(const void* data, uint32_t dataSize, uint32_t& outOffset);
+
+    private:
+        const Context& m_Context;
+        RefCountPtr<ID3D11Buffer> m_Buffer;
+        uint32_t m_Size;
+        uint32_t m_WriteOffset;
+        uint32_t m_Generation = 0;
+    };
+
     class Texture : public RefCounter<ITexture>
     {
     public:
         TextureDesc desc;
         RefCountPtr<ID3D11Resource> resource;
         HANDLE sharedHandle = nullptr;
+        TrackedMemory trackedMemory;
 
         Texture(const Context& context) : m_Context(context) { }
         const TextureDesc& getDesc() const override { return desc; }
@@ -95,6 +133,7 @@ namespace nvrhi::d3d11
         TextureBindingKey_HashMap<RefCountPtr<ID3D11RenderTargetView>> m_RenderTargetViews;
         TextureBindingKey_HashMap<RefCountPtr<ID3D11DepthStencilView>> m_DepthStencilViews;
         TextureBindingKey_HashMap<RefCountPtr<ID3D11UnorderedAccessView>> m_UnorderedAccessViews;
+        std::mutex m_ViewCacheMutex; // deferred command lists can create views from multiple threads
     };
 
     class StagingTexture : public RefCounter<IStagingTexture>
@@ -113,7 +152,14 @@ namespace nvrhi::d3d11
         BufferDesc desc;
         RefCountPtr<ID3D11Buffer> resource;
         HANDLE sharedHandle = nullptr;
+        TrackedMemory trackedMemory;
         
+        // For volatile buffers only, when the volatile constant ring is used:
+        // the latest data written into the buffer, and where it currently resides in the ring
+        std::vector<char> volatileData;
+        uint32_t volatileRingOffset = 0;
+        uint32_t volatileRingGeneration = ~0u;
+
         Buffer(const Context& context) : m_Context(context) { }
         const BufferDesc& getDesc() const override { return desc; }
         GpuVirtualAddress getGpuVirtualAddress() const override { nvrhi::utils::NotImplemented(); return 0; }
@@ -126,6 +172,7 @@ namespace nvrhi::d3d11
         const Context& m_Context;
         std::unordered_map<BufferBindingKey, RefCountPtr<ID3D11ShaderResourceView>> m_ShaderResourceViews;
         std::unordered_map<BufferBindingKey, RefCountPtr<ID3D11UnorderedAccessView>> m_UnorderedAccessViews;
+        std::mutex m_ViewCacheMutex; // deferred command lists can create views from multiple threads
     };
 
     class Shader : public RefCounter<IShader>
@@ -197,6 +244,18 @@ namespace nvrhi::d3d11
         const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
     };
 
+    // D3D11 has no native bundles, so the draws are replayed through the regular state setting path
+    class CommandBundle : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+
+        // GraphicsState holds raw pointers, so the bundle keeps the objects used by its draws alive
+        std::vector<RefCountPtr<IResource>> referencedResources;
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+    };
+
     struct DX11_ViewportState
     {
         uint32_t numViewports = 0;
@@ -277,6 +336,9 @@ namespace nvrhi::d3d11
         uint32_t maxUAVSlot = 0;
 
         std::vector<RefCountPtr<IResource>> resources;
+
+        // Constant buffer slots that are bound to ranges of the volatile constant ring, with their buffers
+        static_vector<std::pair<uint32_t, Buffer*>, c_MaxVolatileConstantBuffersPerLayout> volatileConstantBuffers;
         
         const BindingSetDesc* getDesc() const override { return &desc; }
         IBindingLayout* getLayout() const override { return layout; }
@@ -286,7 +348,9 @@ namespace nvrhi::d3d11
     class CommandList : public RefCounter<ICommandList>
     {
     public:
-        explicit CommandList(const Context& context, IDevice* device, const CommandListParameters& params);
+        // The device context is either the immediate context, or a deferred context for the command lists
+        // created without CommandListParameters::enableImmediateExecution
+        explicit CommandList(const Context& context, IDevice* device, ID3D11DeviceContext* deviceContext, const CommandListParameters& params);
         ~CommandList() override;
 
         // IResource implementation
@@ -310,6 +374,7 @@ namespace nvrhi::d3d11
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
@@ -317,10 +382,19 @@ namespace nvrhi::d3d11
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void beginRenderPassScope(const RenderPassScope& scope) override { (void)scope; }
+        void endRenderPassScope() override { }
+        void executeBundle(ICommandBundle* bundle) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndexedMulti(const DrawArguments* args, size_t numDraws) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
@@ -328,25 +402,46 @@ namespace nvrhi::d3d11
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
         void dispatchIndirect(uint32_t offsetBytes)  override;
+        void executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+            uint32_t countOffsetBytes) override;
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
+        void writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        rt::IndirectInstanceDesc* allocateTopLevelInstances(size_t numInstances) override;
+        void buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes) override;
+        void beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op) override;
+        void endPredication() override;
 
         // perf markers
         void beginMarker(const char* name) override;
@@ -367,6 +462,13 @@ namespace nvrhi::d3d11
 
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override { (void)texture; (void)stateBits; }
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override { (void)buffer; (void)stateBits; }
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override { (void)texture; (void)subresources; (void)stateBits; }
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override { (void)buffer; (void)stateBits; }
+        void releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits) override { (void)texture; (void)subresources; (void)destinationQueue; (void)stateBits; }
+        void acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits) override { (void)texture; (void)subresources; (void)sourceQueue; (void)stateBits; }
+        void releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits) override { (void)buffer; (void)destinationQueue; (void)stateBits; }
+        void acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits) override { (void)buffer; (void)sourceQueue; (void)stateBits; }
+        void setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override { (void)resourceBefore; (void)resourceAfter; }
 
         void commitBarriers() override { }
 
@@ -375,17 +477,30 @@ namespace nvrhi::d3d11
 
         IDevice* getDevice() override { return m_Device; }
         const CommandListParameters& getDesc() override { return m_Desc; }
+        BarrierStatistics getBarrierStatistics() override { return BarrierStatistics(); }
+        CommandListStatistics getStatistics() override { return m_Statistics; }
+
+        // The commands recorded on the deferred context by the last close(), null for the immediate command list
+        ID3D11CommandList* getD3DCommandList() const { return m_D3DCommandList; }
 
     private:
         const Context& m_Context;
         IDevice* m_Device; // weak reference - to avoid a cyclic reference between Device and its ImmediateCommandList
         CommandListParameters m_Desc;
 
+        RefCountPtr<ID3D11DeviceContext> m_DeviceContext;
+        RefCountPtr<ID3D11DeviceContext1> m_DeviceContext1;
+        RefCountPtr<ID3D11CommandList> m_D3DCommandList;
+        bool m_IsDeferred = false;
+
         RefCountPtr<ID3DUserDefinedAnnotation> m_UserDefinedAnnotation;
 #if NVRHI_WITH_AFTERMATH
         AftermathMarkerTracker m_AftermathTracker;
 #endif
 
+        // Mutable because the binding functions are const
+        mutable CommandListStatistics m_Statistics;
+
         int m_NumUAVOverlapCommands = 0;
         void enterUAVOverlapSection();
         void leaveUAVOverlapSection();
@@ -408,13 +523,23 @@ namespace nvrhi::d3d11
         BufferHandle m_CurrentIndirectBuffer;
         Color m_CurrentBlendConstantColor{};
         uint8_t m_CurrentStencilRefValue = 0;
+        DynamicRenderStateValues m_CurrentDynamicRenderState{};
         bool m_CurrentGraphicsStateValid = false;
         bool m_CurrentComputeStateValid = false;
 
+        // Binding sets created with createTransientBindingSet, released when the command list is reopened
+        std::vector<BindingSetHandle> m_TransientBindingSets;
+
         void copyTexture(ID3D11Resource* dst, const TextureDesc& dstDesc, const TextureSlice& dstSlice,
             ID3D11Resource* src, const TextureDesc& srcDesc, const TextureSlice& srcSlice);
+
+        // UpdateSubresource with the source pointer adjusted for the runtime emulation of deferred contexts,
+        // which offsets it by the destination box when the driver has no native command list support
+        void updateSubresource(ID3D11Resource* dst, UINT subresource, const D3D11_BOX* box, Format format,
+            const void* data, UINT rowPitch, UINT depthPitch);
         
         void bindGraphicsPipeline(const GraphicsPipeline* pso) const;
+        GraphicsState getCurrentGraphicsState() const;
 
         void prepareToBindGraphicsResourceSets(
             const BindingSetVector& resourceSets,
@@ -425,6 +550,12 @@ namespace nvrhi::d3d11
             BindingSetVector& outSetsToBind) const;
         void bindGraphicsResourceSets(const BindingSetVector& setsToBind, const IGraphicsPipeline* newPipeline) const;
         void bindComputeResourceSets(const BindingSetVector& resourceSets, const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets) const;
+
+        // Volatile constant ring support, see DeviceDesc::volatileConstantRingSize
+        void writeVolatileConstantBuffer(Buffer* buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes);
+        bool uploadVolatileConstantBuffer(Buffer* buffer);
+        void updateVolatileConstantBuffers(const BindingSetVector& sets, ShaderType boundStages);
+        void setConstantBufferRange(ShaderType stages, uint32_t slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants) const;
     };
 
     class Device : public RefCounter<IDevice>
@@ -453,13 +584,18 @@ namespace nvrhi::d3d11
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
+        BufferHandle createBufferFromHostMemory(const BufferDesc& d, void* hostMemory) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, uint64_t offset, size_t size) override;
         void unmapBuffer(IBuffer* b) override;
+        void flushMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
+        void invalidateMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
@@ -485,10 +621,16 @@ namespace nvrhi::d3d11
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimestampQueryPoolHandle createTimestampQueryPool(const TimestampQueryPoolDesc& desc) override;
+        bool getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) override;
+        uint64_t getTimestampFrequency(CommandQueue queue) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
         FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+        IndirectCommandLayoutHandle createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc) override;
 
         GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
 
@@ -501,6 +643,12 @@ namespace nvrhi::d3d11
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override;
+        PendingPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createGraphicsPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override { return m_PipelineCompilePool.createComputePipeline(this, desc); }
+        PendingPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createMeshletPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override { return m_PipelineCompilePool.createRayTracingPipeline(this, desc); }
+        PendingPipelineHandle addToRayTracingPipelineAsync(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override { return m_PipelineCompilePool.addToRayTracingPipeline(this, pipeline, additions); }
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -510,35 +658,61 @@ namespace nvrhi::d3d11
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems) override;
 
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
         MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::AccelStructBuildSizes getAccelStructBuildSizes(const rt::AccelStructDesc& desc) override;
+        bool isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header) override;
         rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
         bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
 
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
-        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override { (void)pCommandLists; (void)numCommandLists; (void)executionQueue; return 0; }
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override { (void)waitQueue; (void)executionQueue; (void)instance; }
+        void executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances = nullptr) override { if (pInstances) std::fill(pInstances, pInstances + graph.nodes.size(), 0); }
         bool waitForIdle() override;
-        void runGarbageCollection() override { }
+        void runGarbageCollection() override { (void)getMemoryStatistics(); }
+        bool runIncrementalGarbageCollection(const GarbageCollectionBudget& budget) override { (void)budget; return true; }
+        void setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds = 2) override { (void)enable; (void)intervalMilliseconds; }
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { (void)objectType; (void)queue;  return nullptr; }
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
+        void setInstrumentationCallback(IInstrumentationCallback* callback) override { m_Context.instrumentation.set(callback); }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+        bool getPipelineCacheData(void* data, size_t* dataSize) override { (void)data; (void)dataSize; return false; }
+        UploadRingStatistics getUploadRingStatistics(CommandQueue queue) override { (void)queue; return UploadRingStatistics(); }
+        MemoryStatistics getMemoryStatistics() override;
+        void enumerateResourceAllocations(IResourceAllocationCallback& callback) override { m_Context.memoryCounters.enumerateAllocations(callback); }
+        BarrierStatistics getBarrierStatistics(CommandQueue queue) override { (void)queue; return BarrierStatistics(); }
+        void resetBarrierStatistics() override { }
+        CommandListStatistics getCommandListStatistics(CommandQueue queue) override { return queue == CommandQueue::Graphics ? m_CommandListStatistics : CommandListStatistics(); }
+        void resetCommandListStatistics() override { m_CommandListStatistics = CommandListStatistics(); }
+        PipelineCreationStatistics getPipelineCreationStatistics() override { return m_Context.pipelineCounters.get(); }
+        void resetPipelineCreationStatistics() override { m_Context.pipelineCounters.reset(); }
+
+        // Return the state objects of a pipeline with the dynamic render state values applied,
+        // see GraphicsPipelineDesc::dynamicRenderState
+        ID3D11RasterizerState* getDynamicRasterizerState(const GraphicsPipeline* pso, const DynamicRenderStateValues& values);
+        ID3D11DepthStencilState* getDynamicDepthStencilState(const GraphicsPipeline* pso, const DynamicRenderStateValues& values);
 
     private:
         Context m_Context;
         EventQueryHandle m_WaitForIdleQuery;
         CommandListHandle m_ImmediateCommandList;
 
+        RefCountPtr<IDXGIAdapter3> m_DxgiAdapter; // used for memory budget queries, may be null
+        MemoryBudgetMonitor m_MemoryBudgetMonitor;
+
         std::unordered_map<size_t, RefCountPtr<ID3D11BlendState>> m_BlendStates;
         std::unordered_map<size_t, RefCountPtr<ID3D11DepthStencilState>> m_DepthStencilStates;
         std::unordered_map<size_t, RefCountPtr<ID3D11RasterizerState>> m_RasterizerStates;
+        std::mutex m_StateObjectMutex; // the dynamic render state objects are created while recording deferred command lists
 
         bool m_SinglePassStereoSupported = false;
         bool m_HlslExtensionsSupported = false;
@@ -555,6 +729,9 @@ namespace nvrhi::d3d11
 
         bool m_AftermathEnabled = false;
         AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
+        PipelineCompilePool m_PipelineCompilePool;
+
+        CommandListStatistics m_CommandListStatistics;
     };
 
 } // namespace nvrhi::d3d11
@@ -141,24 +141,104 @@ namespace nvrhi::d3d11
         buffer->desc = d;
         buffer->resource = newBuffer;
         buffer->sharedHandle = sharedHandle;
+        buffer->trackedMemory.set(m_Context.memoryCounters, buffer, desc11.ByteWidth);
+
+        if (d.isVolatile && m_Context.volatileConstantRing)
+            buffer->volatileData.resize(desc11.ByteWidth);
+
         return BufferHandle::Create(buffer);
     }
 
+    VolatileConstantRing::VolatileConstantRing(const Context& context, ID3D11Buffer* buffer, uint32_t size)
+        : m_Context(context)
+        , m_Buffer(buffer)
+        , m_Size(size)
+        , m_WriteOffset(size) // the first write wraps around and discards the ring
+    { }
+
+    bool VolatileConstantRing::write(const void* data, uint32_t dataSize, uint32_t& outOffset)
+    {
+        const uint32_t allocationSize = align(dataSize, c_ConstantBufferOffsetSizeAlignment);
+        if (allocationSize > m_Size)
+        {
+            std::stringstream ss;
+            ss << "Cannot write " << dataSize << " bytes into the volatile constant ring of size " << m_Size;
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        // Append to the ring without synchronization while it has space left, and let the driver
+        // rename the ring when it wraps around, because the GPU may still be reading the older ranges
+        D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+        if (m_WriteOffset + allocationSize > m_Size)
+        {
+            mapType = D3D11_MAP_WRITE_DISCARD;
+            m_WriteOffset = 0;
+            ++m_Generation;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mappedData;
+        const HRESULT res = m_Context.immediateContext->Map(m_Buffer, 0, mapType, 0, &mappedData);
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "Map call failed for the volatile constant ring, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        memcpy((char*)mappedData.pData + m_WriteOffset, data, dataSize);
+        m_Context.immediateContext->Unmap(m_Buffer, 0);
+
+        outOffset = m_WriteOffset;
+        m_WriteOffset += allocationSize;
+        return true;
+    }
+
+    BufferHandle Device::createBufferFromHostMemory(const BufferDesc&, void*)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
     void CommandList::writeBuffer(IBuffer* _buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
         assert(destOffsetBytes + dataSize <= UINT_MAX);
 
+        if (buffer->desc.isVolatile)
+            NVRHI_COUNT_STATISTIC(m_Statistics, volatileConstantBufferWrites, 1);
+
+        if (buffer->desc.isVolatile && m_Context.volatileConstantRing)
+        {
+            writeVolatileConstantBuffer(buffer, data, dataSize, destOffsetBytes);
+            return;
+        }
+
         if (buffer->desc.cpuAccess == CpuAccessMode::Write)
         {
-            // we can map if it it's D3D11_USAGE_DYNAMIC, but not UpdateSubresource
+            // we can map if it it's D3D11_USAGE_DYNAMIC, but not UpdateSubresource.
+            // Partial writes cannot discard the rest of the buffer, and D3D11_MAP_WRITE is not allowed
+            // on dynamic resources, so they use NO_OVERWRITE and leave the synchronization to the application.
             D3D11_MAPPED_SUBRESOURCE mappedData;
             D3D11_MAP mapType = D3D11_MAP_WRITE_DISCARD;
             if (destOffsetBytes > 0 || dataSize + destOffsetBytes < buffer->desc.byteSize)
-                mapType = D3D11_MAP_WRITE;
+            {
+                // Deferred contexts can only map dynamic resources with DISCARD
+                if (m_IsDeferred)
+                {
+                    std::stringstream ss;
+                    ss << "Partial writes into CPU-writable buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                        << " are not supported on deferred command lists";
+                    m_Context.error(ss.str());
+                    return;
+                }
+
+                mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+            }
 
-            const HRESULT res = m_Context.immediateContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
+            const HRESULT res = m_DeviceContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
             if (FAILED(res))
             {
                 std::stringstream ss;
@@ -169,17 +249,136 @@ namespace nvrhi::d3d11
             }
 
             memcpy((char*)mappedData.pData + destOffsetBytes, data, dataSize);
-            m_Context.immediateContext->Unmap(buffer->resource, 0);
+            m_DeviceContext->Unmap(buffer->resource, 0);
         }
         else
         {
             D3D11_BOX box = { UINT(destOffsetBytes), 0, 0, UINT(destOffsetBytes + dataSize), 1, 1 };
             bool useBox = destOffsetBytes > 0 || dataSize < buffer->desc.byteSize;
 
-            m_Context.immediateContext->UpdateSubresource(buffer->resource, 0, useBox ? &box : nullptr, data, (UINT)dataSize, 0);
+            updateSubresource(buffer->resource, 0, useBox ? &box : nullptr, Format::UNKNOWN, data, (UINT)dataSize, 0);
         }
     }
 
+    void CommandList::writeVolatileConstantBuffer(Buffer* buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        if (destOffsetBytes + dataSize > buffer->volatileData.size())
+        {
+            std::stringstream ss;
+            ss << "Cannot write " << dataSize << " bytes at offset " << destOffsetBytes << " into volatile buffer "
+                << utils::DebugNameToString(buffer->desc.debugName) << " of size " << buffer->volatileData.size();
+            m_Context.error(ss.str());
+            return;
+        }
+
+        // Volatile buffers are uploaded as a whole, so partial writes update the shadow copy first
+        memcpy(buffer->volatileData.data() + destOffsetBytes, data, dataSize);
+
+        // Always upload into a new range, even when the data is unchanged, because the draws recorded
+        // since the previous write still reference the previous range
+        if (!uploadVolatileConstantBuffer(buffer))
+            return;
+
+        // Point the currently bound sets at the new range, and re-upload the buffers that were lost
+        // if the ring has wrapped around
+        ShaderType boundStages = ShaderType::None;
+        if (m_CurrentGraphicsStateValid && m_CurrentGraphicsPipeline)
+            boundStages = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsPipeline.Get())->shaderMask;
+        else if (m_CurrentComputeStateValid)
+            boundStages = ShaderType::Compute;
+
+        if (boundStages != ShaderType::None)
+        {
+            BindingSetVector sets;
+            for (const auto& set : m_CurrentBindings)
+                sets.push_back(set);
+
+            updateVolatileConstantBuffers(sets, boundStages);
+        }
+    }
+
+    bool CommandList::uploadVolatileConstantBuffer(Buffer* buffer)
+    {
+        VolatileConstantRing* ring = m_Context.volatileConstantRing.get();
+
+        uint32_t offset = 0;
+        if (!ring->write(buffer->volatileData.data(), uint32_t(buffer->volatileData.size()), offset))
+            return false;
+
+        NVRHI_COUNT_STATISTIC(m_Statistics, uploadBytes, buffer->volatileData.size());
+
+        buffer->volatileRingOffset = offset;
+        buffer->volatileRingGeneration = ring->getGeneration();
+        return true;
+    }
+
+    void CommandList::updateVolatileConstantBuffers(const BindingSetVector& sets, ShaderType boundStages)
+    {
+        VolatileConstantRing* ring = m_Context.volatileConstantRing.get();
+
+        // Re-upload the buffers whose ranges were discarded when the ring wrapped around.
+        // The uploads can wrap the ring again, in which case the buffers uploaded before that are lost too,
+        // so make one more pass. A third pass would not help: it means that the ring cannot fit the sets.
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            const uint32_t generation = ring->getGeneration();
+
+            for (IBindingSet* _set : sets)
+            {
+                const auto set = checked_cast<BindingSet*>(_set);
+                if (!set)
+                    continue;
+
+                for (const auto& [slot, buffer] : set->volatileConstantBuffers)
+                {
+                    if (buffer->volatileRingGeneration != ring->getGeneration())
+                        uploadVolatileConstantBuffer(buffer);
+                }
+            }
+
+            if (generation == ring->getGeneration())
+                break;
+        }
+
+        for (IBindingSet* _set : sets)
+        {
+            const auto set = checked_cast<BindingSet*>(_set);
+            if (!set)
+                continue;
+
+            for (const auto& [slot, buffer] : set->volatileConstantBuffers)
+            {
+                const UINT firstConstant = buffer->volatileRingOffset / 16; // in 16-byte constants
+                if (set->constantBufferOffsets[slot] == firstConstant)
+                    continue;
+
+                set->constantBufferOffsets[slot] = firstConstant;
+
+                const ShaderType stages = set->visibility & boundStages;
+                if (stages != ShaderType::None)
+                    setConstantBufferRange(stages, slot, set->constantBuffers[slot], firstConstant, set->constantBufferCounts[slot]);
+            }
+        }
+    }
+
+    void CommandList::setConstantBufferRange(ShaderType stages, uint32_t slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants) const
+    {
+        ID3D11DeviceContext1* ctx1 = m_DeviceContext1;
+
+        if ((stages & ShaderType::Vertex) != 0)
+            ctx1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+        if ((stages & ShaderType::Hull) != 0)
+            ctx1->HSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+        if ((stages & ShaderType::Domain) != 0)
+            ctx1->DSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+        if ((stages & ShaderType::Geometry) != 0)
+            ctx1->GSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+        if ((stages & ShaderType::Pixel) != 0)
+            ctx1->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+        if ((stages & ShaderType::Compute) != 0)
+            ctx1->CSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+    }
+
     void CommandList::clearBufferUInt(IBuffer* buffer, uint32_t clearValue)
     {
         const BufferDesc& bufferDesc = buffer->getDesc();
@@ -191,7 +390,7 @@ namespace nvrhi::d3d11
         ID3D11UnorderedAccessView* uav = checked_cast<Buffer*>(buffer)->getUAV(Format::UNKNOWN, EntireBuffer, viewType);
 
         UINT clearValues[4] = { clearValue, clearValue, clearValue, clearValue };
-        m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+        m_DeviceContext->ClearUnorderedAccessViewUint(uav, clearValues);
     }
 
     void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
@@ -210,13 +409,23 @@ namespace nvrhi::d3d11
         srcBox.top = 0;
         srcBox.front = 0;
         srcBox.back = 1;
-        m_Context.immediateContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
+        m_DeviceContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
     }
     
     void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
+        return mapBuffer(buffer, flags, 0, size_t(buffer->desc.byteSize));
+    }
+
+    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, uint64_t offset, size_t size)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        // A partial write mapping must preserve the rest of the buffer, see CommandList::writeBuffer
+        const bool wholeBuffer = offset == 0 && size >= buffer->desc.byteSize;
+
         D3D11_MAP mapType;
         switch(flags)  // NOLINT(clang-diagnostic-switch-enum)
         {
@@ -227,7 +436,7 @@ namespace nvrhi::d3d11
 
             case CpuAccessMode::Write:
                 assert(buffer->desc.cpuAccess == CpuAccessMode::Write);
-                mapType = D3D11_MAP_WRITE_DISCARD;
+                mapType = wholeBuffer ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
                 break;
 
             default:
@@ -238,7 +447,7 @@ namespace nvrhi::d3d11
         D3D11_MAPPED_SUBRESOURCE res;
         if (SUCCEEDED(m_Context.immediateContext->Map(buffer->resource, 0, mapType, 0, &res)))
         {
-            return res.pData;
+            return static_cast<char*>(res.pData) + offset;
         } else {
             return nullptr;
         }
@@ -251,6 +460,15 @@ namespace nvrhi::d3d11
         m_Context.immediateContext->Unmap(buffer->resource, 0);
     }
 
+    void Device::flushMappedRange(IBuffer*, uint64_t, size_t)
+    {
+        // The runtime owns the mapped memory and publishes it on Unmap
+    }
+
+    void Device::invalidateMappedRange(IBuffer*, uint64_t, size_t)
+    {
+    }
+
     MemoryRequirements Device::getBufferMemoryRequirements(IBuffer*)
     {
         utils::NotSupported();
@@ -281,6 +499,8 @@ namespace nvrhi::d3d11
 
     ID3D11ShaderResourceView* Buffer::getSRV(Format format, BufferRange range, ResourceType type)
     {
+        std::lock_guard viewCacheLock(m_ViewCacheMutex);
+
         if (format == Format::UNKNOWN)
         {
             format = desc.format;
@@ -344,6 +564,8 @@ namespace nvrhi::d3d11
 
     ID3D11UnorderedAccessView* Buffer::getUAV(Format format, BufferRange range, ResourceType type)
     {
+        std::lock_guard viewCacheLock(m_ViewCacheMutex);
+
         if (format == Format::UNKNOWN)
         {
             format = desc.format;
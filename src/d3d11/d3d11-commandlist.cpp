@@ -23,14 +23,20 @@
 #include "d3d11-backend.h"
 #include <nvrhi/utils.h>
 
+#include <sstream>
+#include <iomanip>
+
 namespace nvrhi::d3d11
 {
-    CommandList::CommandList(const Context& context, IDevice* device, const CommandListParameters& params)
+    CommandList::CommandList(const Context& context, IDevice* device, ID3D11DeviceContext* deviceContext, const CommandListParameters& params)
         : m_Context(context)
         , m_Device(device)
         , m_Desc(params)
+        , m_DeviceContext(deviceContext)
+        , m_IsDeferred(deviceContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
     {
-        m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
+        m_DeviceContext->QueryInterface(IID_PPV_ARGS(&m_DeviceContext1));
+        m_DeviceContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
@@ -50,7 +56,7 @@ namespace nvrhi::d3d11
         switch (objectType)
         {
         case ObjectTypes::D3D11_DeviceContext:
-            return Object(m_Context.immediateContext);
+            return Object(m_DeviceContext);
         default:
             return nullptr;
         }
@@ -59,6 +65,13 @@ namespace nvrhi::d3d11
     void CommandList::open()
     {
         clearState();
+
+        // Commands on DX11 are executed immediately, and a deferred command list is consumed by the time it's reopened,
+        // so the transient sets from the previous recording are not in use anymore
+        m_TransientBindingSets.clear();
+        m_D3DCommandList = nullptr;
+
+        m_Statistics = CommandListStatistics();
     }
 
     void CommandList::close()
@@ -67,16 +80,28 @@ namespace nvrhi::d3d11
             leaveUAVOverlapSection();
 
         clearState();
+
+        if (m_IsDeferred)
+        {
+            // Don't restore the deferred context state, it's cleared on open() anyway
+            const HRESULT res = m_DeviceContext->FinishCommandList(FALSE, &m_D3DCommandList);
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "FinishCommandList call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+            }
+        }
     }
 
     void CommandList::clearState()
     {
-        m_Context.immediateContext->ClearState();
+        m_DeviceContext->ClearState();
 
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_CurrentGraphicsStateValid && m_CurrentSinglePassStereoState.enabled)
         {
-            NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, 1, 0, 0);
+            NvAPI_D3D_SetSinglePassStereoMode(m_DeviceContext, 1, 0, 0);
         }
 #endif
 
@@ -92,6 +117,7 @@ namespace nvrhi::d3d11
         m_CurrentComputePipeline = nullptr;
         m_CurrentIndirectBuffer = nullptr;
         m_CurrentBlendConstantColor = Color{};
+        m_CurrentDynamicRenderState = DynamicRenderStateValues();
     }
 
     void CommandList::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
@@ -118,7 +144,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 0)
-            NvAPI_D3D11_BeginUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_BeginUAVOverlap(m_DeviceContext);
 #endif
 
         m_NumUAVOverlapCommands += 1;
@@ -128,7 +154,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 1)
-            NvAPI_D3D11_EndUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_EndUAVOverlap(m_DeviceContext);
 #endif
 
         m_NumUAVOverlapCommands = std::max(0, m_NumUAVOverlapCommands - 1);
@@ -147,7 +173,11 @@ namespace nvrhi::d3d11
         if (m_Device->isAftermathEnabled())
         {
             const size_t aftermathMarker = m_AftermathTracker.pushEvent(name);
-            GFSDK_Aftermath_SetEventMarker(m_Context.aftermathContext, (const void*)aftermathMarker, 0);
+
+            // The Aftermath context handle belongs to the immediate context, markers set on it while recording
+            // a deferred command list would not match the order of execution
+            if (!m_IsDeferred)
+                GFSDK_Aftermath_SetEventMarker(m_Context.aftermathContext, (const void*)aftermathMarker, 0);
         }
 #endif
     }
@@ -164,18 +194,52 @@ namespace nvrhi::d3d11
 #endif
     }
     
-    static char g_PushConstantPaddingBuffer[c_MaxPushConstantSize] = {};
-
     void CommandList::setPushConstants(const void* data, size_t byteSize)
     {
         if (byteSize > c_MaxPushConstantSize)
             return;
 
-        memcpy(g_PushConstantPaddingBuffer, data, byteSize);
+        // The whole buffer is updated, so pad the data. The padding is on the stack because
+        // deferred command lists can set push constants from multiple threads.
+        char paddedData[c_MaxPushConstantSize] = {};
+        memcpy(paddedData, data, byteSize);
 
-        m_Context.immediateContext->UpdateSubresource(
+        m_DeviceContext->UpdateSubresource(
             m_Context.pushConstantBuffer, 0, nullptr, 
-            g_PushConstantPaddingBuffer, 0, 0);
+            paddedData, 0, 0);
+    }
+
+    void CommandList::updateSubresource(ID3D11Resource* dst, UINT subresource, const D3D11_BOX* box, Format format,
+        const void* data, UINT rowPitch, UINT depthPitch)
+    {
+        if (box && m_IsDeferred && !m_Context.driverCommandLists)
+        {
+            // When the runtime emulates command lists, it applies the destination box to the source pointer
+            // as if it pointed at the whole subresource, so move the pointer back by the same amount.
+            // Buffers have no format and are addressed in bytes.
+            const FormatInfo& formatInfo = getFormatInfo(format);
+            const UINT blockSize = format == Format::UNKNOWN ? 1 : formatInfo.blockSize;
+            const UINT bytesPerBlock = format == Format::UNKNOWN ? 1 : formatInfo.bytesPerBlock;
+
+            data = static_cast<const char*>(data)
+                - size_t(box->front) * depthPitch
+                - size_t(box->top / blockSize) * rowPitch
+                - size_t(box->left / blockSize) * bytesPerBlock;
+        }
+
+        m_DeviceContext->UpdateSubresource(dst, subresource, box, data, rowPitch, depthPitch);
+    }
+
+    IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
+        BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+        if (!bindingSet)
+            return nullptr;
+
+        m_TransientBindingSets.push_back(bindingSet);
+        return bindingSet;
     }
 
     void CommandList::setMeshletState(const MeshletState&)
@@ -188,6 +252,21 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::dispatchMeshIndirect(uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::executeIndirectCommands(IIndirectCommandLayout*, uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::setRayTracingState(const rt::State&)
     {
         utils::NotSupported();
@@ -208,11 +287,31 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::compactBottomLevelAccelStructs()
     {
         utils::NotSupported();
     }
 
+    void CommandList::writeAccelStructSerializedSize(rt::IAccelStruct*, IBuffer*, uint64_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::serializeAccelStruct(rt::IAccelStruct*, IBuffer*, uint64_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::deserializeAccelStruct(rt::IAccelStruct*, IBuffer*, uint64_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct*, const rt::InstanceDesc*, size_t, rt::AccelStructBuildFlags)
     {
         utils::NotSupported();
@@ -223,6 +322,22 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    rt::IndirectInstanceDesc* CommandList::allocateTopLevelInstances(size_t)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    void CommandList::buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct*, const rt::IndirectInstanceDesc*, size_t, rt::AccelStructBuildFlags)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::updateTopLevelInstances(rt::IAccelStruct*, uint32_t, const rt::InstanceDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc&)
     {
         utils::NotSupported();
@@ -29,11 +29,15 @@ namespace nvrhi::d3d11
 
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Compute, desc);
+
         ComputePipeline *pso = new ComputePipeline();
         pso->desc = desc;
 
         if (desc.CS) pso->shader = checked_cast<Shader*>(desc.CS.Get())->CS;
 
+        creationScope.setPipeline(pso);
+
         return ComputePipelineHandle::Create(pso);
     }
 
@@ -53,7 +57,16 @@ namespace nvrhi::d3d11
         bool updatePipeline = !m_CurrentComputeStateValid || pso != m_CurrentComputePipeline;
         bool updateBindings = updatePipeline || arraysAreDifferent(m_CurrentBindings, state.bindings);
 
-        if (updatePipeline) m_Context.immediateContext->CSSetShader(pso->shader, nullptr, 0);
+        // Assign the ring ranges of the volatile buffers before binding, the sets that stay bound are updated in place
+        if (m_Context.volatileConstantRing)
+            updateVolatileConstantBuffers(state.bindings, m_CurrentComputeStateValid ? ShaderType::Compute : ShaderType::None);
+
+        if (updatePipeline)
+        {
+            m_DeviceContext->CSSetShader(pso->shader, nullptr, 0);
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
+        }
+
         if (updateBindings) bindComputeResourceSets(state.bindings, m_CurrentComputeStateValid ? &m_CurrentBindings : nullptr);
 
         m_CurrentIndirectBuffer = state.indirectParams;
@@ -74,7 +87,8 @@ namespace nvrhi::d3d11
 
     void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
     {
-        m_Context.immediateContext->Dispatch(groupsX, groupsY, groupsZ);
+        m_DeviceContext->Dispatch(groupsX, groupsY, groupsZ);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
     }
 
     void CommandList::dispatchIndirect(uint32_t offsetBytes)
@@ -83,7 +97,8 @@ namespace nvrhi::d3d11
         
         if (indirectParams) // validation layer will issue an error otherwise
         {
-            m_Context.immediateContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
+            m_DeviceContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
+            NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
         }
     }
 
@@ -45,12 +45,19 @@ namespace nvrhi::d3d11
     }
 
     Device::Device(const DeviceDesc& desc)
+        : m_PipelineCompilePool(desc.numPipelineCompileThreads)
     {
         m_Context.messageCallback = desc.messageCallback;
         m_Context.immediateContext = desc.context;
         m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_Context.immediateContext1));
         desc.context->GetDevice(&m_Context.device);
 
+        // The adapter is only used for memory budget queries, so failing to find it is not an error
+        RefCountPtr<IDXGIDevice> dxgiDevice;
+        RefCountPtr<IDXGIAdapter> dxgiAdapter;
+        if (SUCCEEDED(m_Context.device->QueryInterface(IID_PPV_ARGS(&dxgiDevice))) && SUCCEEDED(dxgiDevice->GetAdapter(&dxgiAdapter)))
+            dxgiAdapter->QueryInterface(IID_PPV_ARGS(&m_DxgiAdapter));
+
 #if NVRHI_D3D11_WITH_NVAPI
         m_Context.nvapiAvailable = NvAPI_Initialize() == NVAPI_OK;
 
@@ -102,8 +109,13 @@ namespace nvrhi::d3d11
             if (success)
                 m_AftermathEnabled = true;
         }
+        m_AftermathCrashDumpHelper.setCompactMarkers(desc.aftermathCompactMarkers);
 #endif
 
+        D3D11_FEATURE_DATA_THREADING threadingFeatures = {};
+        if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threadingFeatures, sizeof(threadingFeatures))))
+            m_Context.driverCommandLists = threadingFeatures.DriverCommandLists != FALSE;
+
         D3D11_BUFFER_DESC bufferDesc = {};
         bufferDesc.ByteWidth = c_MaxPushConstantSize;
         bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
@@ -118,11 +130,41 @@ namespace nvrhi::d3d11
             m_Context.error(ss.str());
         }
 
-        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, CommandListParameters()));   
+        if (desc.volatileConstantRingSize > 0 && m_Context.immediateContext1)
+        {
+            D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+                options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer)
+            {
+                bufferDesc.ByteWidth = align(desc.volatileConstantRingSize, c_ConstantBufferOffsetSizeAlignment);
+                bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+                bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+                bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+                RefCountPtr<ID3D11Buffer> ringBuffer;
+                const HRESULT ringRes = m_Context.device->CreateBuffer(&bufferDesc, nullptr, &ringBuffer);
+
+                if (SUCCEEDED(ringRes))
+                {
+                    SetDebugName(ringBuffer, "VolatileConstantRing");
+                    m_Context.volatileConstantRing = std::make_unique<VolatileConstantRing>(m_Context, ringBuffer, bufferDesc.ByteWidth);
+                }
+                else
+                {
+                    std::stringstream ss;
+                    ss << "CreateBuffer call failed for the volatile constant ring, HRESULT = 0x" << std::hex << std::setw(8) << ringRes;
+                    m_Context.error(ss.str());
+                }
+            }
+        }
+
+        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, m_Context.immediateContext, CommandListParameters()));   
     }
 
     Device::~Device()
     {
+        m_PipelineCompilePool.shutdown();
+
         // Release the command list so that it unregisters the Aftermath marker tracker before the device is destroyed
         m_ImmediateCommandList = nullptr;
 
@@ -162,21 +204,64 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
-    CommandListHandle Device::createCommandList(const CommandListParameters& params)
+    MemoryStatistics Device::getMemoryStatistics()
     {
-        if (!params.enableImmediateExecution)
+        MemoryStatistics statistics;
+        m_Context.memoryCounters.fillStatistics(statistics);
+
+        if (m_DxgiAdapter)
         {
-            m_Context.error("Deferred command lists are not supported by the D3D11 backend.");
-            return nullptr;
+            for (DXGI_MEMORY_SEGMENT_GROUP segmentGroup : { DXGI_MEMORY_SEGMENT_GROUP_LOCAL, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL })
+            {
+                DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+                if (FAILED(m_DxgiAdapter->QueryVideoMemoryInfo(0, segmentGroup, &memoryInfo)))
+                    break;
+
+                MemoryHeapStatistics heap;
+                heap.budget = memoryInfo.Budget;
+                heap.usage = memoryInfo.CurrentUsage;
+                heap.isDeviceLocal = segmentGroup == DXGI_MEMORY_SEGMENT_GROUP_LOCAL;
+                statistics.heaps.push_back(heap);
+            }
         }
 
+        m_MemoryBudgetMonitor.update(statistics, m_Context.messageCallback);
+
+        return statistics;
+    }
+
+    CommandListHandle Device::createCommandList(const CommandListParameters& params)
+    {
         if (params.queueType != CommandQueue::Graphics)
         {
             m_Context.error("Non-graphics queues are not supported by the D3D11 backend.");
             return nullptr;
         }
-        
-        return m_ImmediateCommandList;
+
+        if (params.enableImmediateExecution)
+            return m_ImmediateCommandList;
+
+        // The ring is mapped through the immediate context, and the binding sets refer to its ranges
+        if (m_Context.volatileConstantRing)
+        {
+            m_Context.error("Deferred command lists cannot be used together with the volatile constant ring, "
+                "see DeviceDesc::volatileConstantRingSize");
+            return nullptr;
+        }
+
+        // When the driver doesn't support command lists natively, the runtime records the commands
+        // on the deferred context and plays them back in ExecuteCommandList
+        RefCountPtr<ID3D11DeviceContext> deferredContext;
+        const HRESULT res = m_Context.device->CreateDeferredContext(0, &deferredContext);
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateDeferredContext call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        return CommandListHandle::Create(new CommandList(m_Context, this, deferredContext, params));
     }
 
     void Device::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
@@ -201,6 +286,15 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void Device::updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue)
+    {
+        (void)updates;
+        (void)numUpdates;
+        (void)executionQueue;
+
+        utils::NotSupported();
+    }
+
     SamplerFeedbackTextureHandle Device::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
     {
         (void)pairedTexture;
@@ -230,7 +324,7 @@ namespace nvrhi::d3d11
         switch (feature)  // NOLINT(clang-diagnostic-switch-enum)
         {
         case Feature::DeferredCommandLists:
-            return false;
+            return m_Context.volatileConstantRing == nullptr;
         case Feature::SinglePassStereo:
             return m_SinglePassStereoSupported;
         case Feature::FastGeometryShader:
@@ -245,6 +339,28 @@ namespace nvrhi::d3d11
             return m_Context.immediateContext1 != nullptr;
         case Feature::HlslExtensionUAV:
             return m_HlslExtensionsSupported;
+        case Feature::ExtendedDynamicState:
+            // Emulated by selecting the cached state objects at bind time
+            if (pInfo)
+            {
+                if (infoSize == sizeof(DynamicRenderStateFeatureInfo))
+                {
+                    auto* pDynamicStateInfo = reinterpret_cast<DynamicRenderStateFeatureInfo*>(pInfo);
+                    pDynamicStateInfo->supportedStates = DynamicRenderState::PrimitiveTopology
+                        | DynamicRenderState::ViewportCount
+                        | DynamicRenderState::CullMode
+                        | DynamicRenderState::FrontFace
+                        | DynamicRenderState::DepthBias
+                        | DynamicRenderState::DepthTestEnable
+                        | DynamicRenderState::DepthWriteEnable
+                        | DynamicRenderState::DepthCompareOp
+                        | DynamicRenderState::StencilTestEnable
+                        | DynamicRenderState::StencilOp;
+                }
+                else
+                    utils::NotSupported();
+            }
+            return true;
         default:
             return false;
         }
@@ -305,6 +421,11 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    rt::PipelineHandle Device::addToRayTracingPipeline(rt::IPipeline*, const rt::PipelineDesc&)
+    {
+        return nullptr;
+    }
+
     rt::OpacityMicromapHandle Device::createOpacityMicromap(const rt::OpacityMicromapDesc& )
     {
         utils::NotSupported();
@@ -322,6 +443,17 @@ namespace nvrhi::d3d11
         return MemoryRequirements();
     }
 
+    rt::AccelStructBuildSizes Device::getAccelStructBuildSizes(const rt::AccelStructDesc&)
+    {
+        utils::NotSupported();
+        return rt::AccelStructBuildSizes();
+    }
+
+    bool Device::isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader&)
+    {
+        return false;
+    }
+
     rt::cluster::OperationSizeInfo Device::getClusterOperationSizeInfo(const rt::cluster::OperationParams&)
     {
         utils::NotSupported();
@@ -346,6 +478,41 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    IndirectCommandLayoutHandle Device::createIndirectCommandLayout(const IndirectCommandLayoutDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::ExecuteCommandLists);
+
+        (void)executionQueue;
+
+        // The commands of the immediate command list have already been executed, only the deferred ones are played back here
+        bool executedDeferredLists = false;
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+
+            if (ID3D11CommandList* d3dCommandList = commandList->getD3DCommandList())
+            {
+                m_Context.immediateContext->ExecuteCommandList(d3dCommandList, FALSE);
+                executedDeferredLists = true;
+            }
+
+            m_CommandListStatistics += commandList->getStatistics();
+        }
+
+        // ExecuteCommandList leaves the immediate context in the default state,
+        // which invalidates the state cache of the immediate command list
+        if (executedDeferredLists)
+            m_ImmediateCommandList->clearState();
+
+        return 0;
+    }
+
     bool Device::waitForIdle()
     {
         if (!m_WaitForIdleQuery)
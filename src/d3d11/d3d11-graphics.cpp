@@ -50,8 +50,56 @@ namespace nvrhi::d3d11
         return FramebufferHandle::Create(ret);
     }
 
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (desc.draws.empty())
+        {
+            m_Context.error("Cannot create a command bundle without draws");
+            return nullptr;
+        }
+
+        CommandBundle* bundle = new CommandBundle();
+        bundle->desc = desc;
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            const GraphicsState& state = draw.state;
+
+            bundle->referencedResources.push_back(state.pipeline);
+            bundle->referencedResources.push_back(state.framebuffer);
+
+            for (IBindingSet* bindingSet : state.bindings)
+                bundle->referencedResources.push_back(bindingSet);
+
+            if (state.indexBuffer.buffer)
+                bundle->referencedResources.push_back(state.indexBuffer.buffer);
+
+            for (const VertexBufferBinding& binding : state.vertexBuffers)
+                bundle->referencedResources.push_back(binding.buffer);
+        }
+
+        return CommandBundleHandle::Create(bundle);
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+
+        for (const CommandBundleDraw& bundleDraw : bundle->desc.draws)
+        {
+            setGraphicsState(bundleDraw.state);
+
+            if (bundleDraw.indexed)
+                drawIndexed(bundleDraw.args);
+            else
+                draw(bundleDraw.args);
+        }
+    }
+
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Graphics, desc);
+
         const RenderState& renderState = desc.renderState;
 
         if (desc.renderState.singlePassStereo.enabled && !m_SinglePassStereoSupported)
@@ -100,6 +148,8 @@ namespace nvrhi::d3d11
             if (pso->pixelShaderHasUAVs)
                 break;
         }
+
+        creationScope.setPipeline(pso);
         
         return GraphicsPipelineHandle::Create(pso);
     }
@@ -114,16 +164,18 @@ namespace nvrhi::d3d11
 
     void CommandList::bindGraphicsPipeline(const GraphicsPipeline* pso) const
     {
-        m_Context.immediateContext->IASetPrimitiveTopology(pso->primitiveTopology);
-        m_Context.immediateContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
+        NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
+
+        m_DeviceContext->IASetPrimitiveTopology(pso->primitiveTopology);
+        m_DeviceContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
 
-        m_Context.immediateContext->RSSetState(pso->pRS);
+        m_DeviceContext->RSSetState(pso->pRS);
 
-        m_Context.immediateContext->VSSetShader(pso->pVS, nullptr, 0);
-        m_Context.immediateContext->HSSetShader(pso->pHS, nullptr, 0);
-        m_Context.immediateContext->DSSetShader(pso->pDS, nullptr, 0);
-        m_Context.immediateContext->GSSetShader(pso->pGS, nullptr, 0);
-        m_Context.immediateContext->PSSetShader(pso->pPS, nullptr, 0);
+        m_DeviceContext->VSSetShader(pso->pVS, nullptr, 0);
+        m_DeviceContext->HSSetShader(pso->pHS, nullptr, 0);
+        m_DeviceContext->DSSetShader(pso->pDS, nullptr, 0);
+        m_DeviceContext->GSSetShader(pso->pGS, nullptr, 0);
+        m_DeviceContext->PSSetShader(pso->pPS, nullptr, 0);
     }
 
     static DX11_ViewportState convertViewportState(const ViewportState& vpState)
@@ -183,6 +235,13 @@ namespace nvrhi::d3d11
         const bool updateIndexBuffer = !m_CurrentGraphicsStateValid || m_CurrentIndexBufferBinding != state.indexBuffer;
         const bool updateVertexBuffers = !m_CurrentGraphicsStateValid || arraysAreDifferent(m_CurrentVertexBufferBindings, state.vertexBuffers);
 
+        const DynamicRenderState dynamicStates = pipeline->desc.dynamicRenderState;
+        const bool updateDynamicRenderState = dynamicStates != 0 && (updatePipeline || state.dynamicRenderState != m_CurrentDynamicRenderState);
+
+        // Assign the ring ranges of the volatile buffers before binding, the sets that stay bound are updated in place
+        if (m_Context.volatileConstantRing)
+            updateVolatileConstantBuffers(state.bindings, m_CurrentGraphicsStateValid ? pipeline->shaderMask : ShaderType::None);
+
         BindingSetVector setsToBind;
         if (updateBindings)
         {
@@ -199,17 +258,19 @@ namespace nvrhi::d3d11
 
             if (pipeline->pixelShaderHasUAVs)
             {
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(
+                m_DeviceContext->OMSetRenderTargetsAndUnorderedAccessViews(
                     UINT(RTVs.size()), RTVs.data(),
                     framebuffer->DSV,
                     D3D11_KEEP_UNORDERED_ACCESS_VIEWS, 0, nullptr, nullptr);
             }
             else
             {
-                m_Context.immediateContext->OMSetRenderTargets(
+                m_DeviceContext->OMSetRenderTargets(
                     UINT(RTVs.size()),RTVs.data(),
                     framebuffer->DSV);
             }
+
+            NVRHI_COUNT_STATISTIC(m_Statistics, renderPasses, 1);
         }
 
         if (updatePipeline)
@@ -217,18 +278,39 @@ namespace nvrhi::d3d11
             bindGraphicsPipeline(pipeline);
         }
 
-        if (updatePipeline || updateStencilRef)
+        // DX11 has no dynamic state beyond the topology; look up the state objects for the dynamic values instead
+        Device* device = checked_cast<Device*>(m_Device);
+        const DynamicRenderState rasterizerStates = DynamicRenderState::CullMode | DynamicRenderState::FrontFace | DynamicRenderState::DepthBias;
+        const DynamicRenderState depthStencilStates = DynamicRenderState::DepthTestEnable | DynamicRenderState::DepthWriteEnable
+            | DynamicRenderState::DepthCompareOp | DynamicRenderState::StencilTestEnable | DynamicRenderState::StencilOp;
+
+        if (updateDynamicRenderState)
+        {
+            if ((dynamicStates & DynamicRenderState::PrimitiveTopology) != 0)
+                m_DeviceContext->IASetPrimitiveTopology(convertPrimType(state.dynamicRenderState.primType, pipeline->desc.patchControlPoints));
+
+            if ((dynamicStates & rasterizerStates) != 0)
+                m_DeviceContext->RSSetState(device->getDynamicRasterizerState(pipeline, state.dynamicRenderState));
+        }
+
+        if (updatePipeline || updateStencilRef || (updateDynamicRenderState && (dynamicStates & depthStencilStates) != 0))
         {
             m_CurrentStencilRefValue = pipeline->desc.renderState.depthStencilState.dynamicStencilRef
                 ? state.dynamicStencilRefValue
                 : pipeline->desc.renderState.depthStencilState.stencilRefValue;
-            m_Context.immediateContext->OMSetDepthStencilState(pipeline->pDepthStencilState, m_CurrentStencilRefValue);
+
+            ID3D11DepthStencilState* depthStencilState = (dynamicStates & depthStencilStates) != 0
+                ? device->getDynamicDepthStencilState(pipeline, state.dynamicRenderState)
+                : pipeline->pDepthStencilState;
+            m_DeviceContext->OMSetDepthStencilState(depthStencilState, m_CurrentStencilRefValue);
         }
 
+        m_CurrentDynamicRenderState = state.dynamicRenderState;
+
         if (updatePipeline || updateBlendState)
         {
             float blendFactor[4]{ state.blendConstantColor.r, state.blendConstantColor.g, state.blendConstantColor.b, state.blendConstantColor.a };
-            m_Context.immediateContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
+            m_DeviceContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
         }
 
         if (updateBindings)
@@ -256,7 +338,7 @@ namespace nvrhi::d3d11
                     maxUAVSlot = std::max(maxUAVSlot, bindingSet->maxUAVSlot);
                 }
 
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
+                m_DeviceContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
             }
         }
 
@@ -266,12 +348,12 @@ namespace nvrhi::d3d11
 
             if (vpState.numViewports)
             {
-                m_Context.immediateContext->RSSetViewports(vpState.numViewports, vpState.viewports);
+                m_DeviceContext->RSSetViewports(vpState.numViewports, vpState.viewports);
             }
 
             if (vpState.numScissorRects)
             {
-                m_Context.immediateContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+                m_DeviceContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
             }
         }
 
@@ -282,7 +364,7 @@ namespace nvrhi::d3d11
         {
             const SinglePassStereoState& spsState = pipeline->desc.renderState.singlePassStereo;
 
-            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
+            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_DeviceContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
 
             if (Status != NVAPI_OK)
             {
@@ -326,7 +408,7 @@ namespace nvrhi::d3d11
                 }
             }
 
-            m_Context.immediateContext->IASetVertexBuffers(0, maxVbIndex + 1,
+            m_DeviceContext->IASetVertexBuffers(0, maxVbIndex + 1,
                 pVertexBuffers,
                 pVertexBufferStrides,
                 pVertexBufferOffsets);
@@ -336,13 +418,13 @@ namespace nvrhi::d3d11
         {
             if (state.indexBuffer.buffer)
             {
-                m_Context.immediateContext->IASetIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->resource,
+                m_DeviceContext->IASetIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->resource,
                     getDxgiFormatMapping(state.indexBuffer.format).srvFormat,
                     state.indexBuffer.offset);
             }
             else
             {
-                m_Context.immediateContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
+                m_DeviceContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
             }
         }
 
@@ -374,14 +456,101 @@ namespace nvrhi::d3d11
         }
     }
 
+    GraphicsState CommandList::getCurrentGraphicsState() const
+    {
+        GraphicsState state;
+        state.pipeline = m_CurrentGraphicsPipeline;
+        state.framebuffer = m_CurrentFramebuffer;
+        state.viewport = m_CurrentViewports;
+        state.blendConstantColor = m_CurrentBlendConstantColor;
+        state.dynamicStencilRefValue = m_CurrentStencilRefValue;
+        state.dynamicRenderState = m_CurrentDynamicRenderState;
+        for (const auto& bindingSet : m_CurrentBindings)
+            state.bindings.push_back(bindingSet);
+        state.vertexBuffers = m_CurrentVertexBufferBindings;
+        state.indexBuffer = m_CurrentIndexBufferBinding;
+        state.indirectParams = m_CurrentIndirectBuffer;
+        return state;
+    }
+
+    // The DX11 state is not kept as a GraphicsState, and setting it is cheap compared to the driver overhead,
+    // so the incremental setters go through setGraphicsState.
+
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsBindingSet requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        GraphicsState state = getCurrentGraphicsState();
+        if (slot >= state.bindings.size())
+            state.bindings.resize(slot + 1);
+        state.bindings[slot] = bindingSet;
+
+        setGraphicsState(state);
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setVertexBuffers requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        GraphicsState state = getCurrentGraphicsState();
+        state.vertexBuffers.resize(numBindings);
+        std::copy(bindings, bindings + numBindings, state.vertexBuffers.begin());
+
+        setGraphicsState(state);
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setIndexBuffer requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        GraphicsState state = getCurrentGraphicsState();
+        state.indexBuffer = binding;
+
+        setGraphicsState(state);
+    }
+
     void CommandList::draw(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+        m_DeviceContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+        m_DeviceContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::drawMulti(const DrawArguments* args, size_t numDraws)
+    {
+        for (size_t drawIndex = 0; drawIndex < numDraws; ++drawIndex)
+        {
+            const DrawArguments& drawArgs = args[drawIndex];
+            m_DeviceContext->DrawInstanced(drawArgs.vertexCount, drawArgs.instanceCount, drawArgs.startVertexLocation, drawArgs.startInstanceLocation);
+        }
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
+    }
+
+    void CommandList::drawIndexedMulti(const DrawArguments* args, size_t numDraws)
+    {
+        for (size_t drawIndex = 0; drawIndex < numDraws; ++drawIndex)
+        {
+            const DrawArguments& drawArgs = args[drawIndex];
+            m_DeviceContext->DrawIndexedInstanced(drawArgs.vertexCount, drawArgs.instanceCount, drawArgs.startIndexLocation, drawArgs.startVertexLocation, drawArgs.startInstanceLocation);
+        }
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
     }
 
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -390,10 +559,12 @@ namespace nvrhi::d3d11
         
         if (indirectParams) // validation layer will issue an error otherwise
         {
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_DeviceContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndirectArguments);
             }
         }
@@ -405,10 +576,12 @@ namespace nvrhi::d3d11
 
         if (indirectParams)
         {
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_DeviceContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndexedIndirectArguments);
             }
         }
@@ -423,6 +596,8 @@ namespace nvrhi::d3d11
 
     ID3D11BlendState* Device::getBlendState(const BlendState& blendState)
     {
+        std::lock_guard lockGuard(m_StateObjectMutex);
+
         size_t hash = 0;
         hash_combine(hash, blendState.alphaToCoverageEnable);
 
@@ -476,8 +651,57 @@ namespace nvrhi::d3d11
         return d3dBlendState;
     }
 
+    ID3D11RasterizerState* Device::getDynamicRasterizerState(const GraphicsPipeline* pso, const DynamicRenderStateValues& values)
+    {
+        const DynamicRenderState states = pso->desc.dynamicRenderState;
+        RasterState rasterState = pso->desc.renderState.rasterState;
+
+        if ((states & DynamicRenderState::CullMode) != 0)
+            rasterState.cullMode = values.cullMode;
+
+        if ((states & DynamicRenderState::FrontFace) != 0)
+            rasterState.frontCounterClockwise = values.frontCounterClockwise;
+
+        if ((states & DynamicRenderState::DepthBias) != 0)
+        {
+            rasterState.depthBias = values.depthBias;
+            rasterState.depthBiasClamp = values.depthBiasClamp;
+            rasterState.slopeScaledDepthBias = values.slopeScaledDepthBias;
+        }
+
+        return getRasterizerState(rasterState);
+    }
+
+    ID3D11DepthStencilState* Device::getDynamicDepthStencilState(const GraphicsPipeline* pso, const DynamicRenderStateValues& values)
+    {
+        const DynamicRenderState states = pso->desc.dynamicRenderState;
+        DepthStencilState depthState = pso->desc.renderState.depthStencilState;
+
+        if ((states & DynamicRenderState::DepthTestEnable) != 0)
+            depthState.depthTestEnable = values.depthTestEnable;
+
+        if ((states & DynamicRenderState::DepthWriteEnable) != 0)
+            depthState.depthWriteEnable = values.depthWriteEnable;
+
+        if ((states & DynamicRenderState::DepthCompareOp) != 0)
+            depthState.depthFunc = values.depthFunc;
+
+        if ((states & DynamicRenderState::StencilTestEnable) != 0)
+            depthState.stencilEnable = values.stencilEnable;
+
+        if ((states & DynamicRenderState::StencilOp) != 0)
+        {
+            depthState.frontFaceStencil = values.frontFaceStencil;
+            depthState.backFaceStencil = values.backFaceStencil;
+        }
+
+        return getDepthStencilState(depthState);
+    }
+
     ID3D11DepthStencilState* Device::getDepthStencilState(const DepthStencilState& depthState)
     {
+        std::lock_guard lockGuard(m_StateObjectMutex);
+
         size_t hash = 0;
         hash_combine(hash, depthState.depthTestEnable);
         hash_combine(hash, depthState.depthWriteEnable);
@@ -530,6 +754,8 @@ namespace nvrhi::d3d11
 
     ID3D11RasterizerState* Device::getRasterizerState(const RasterState& rasterState)
     {
+        std::lock_guard lockGuard(m_StateObjectMutex);
+
         size_t hash = 0;
         hash_combine(hash, rasterState.fillMode);
         hash_combine(hash, rasterState.cullMode);
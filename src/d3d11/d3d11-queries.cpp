@@ -159,8 +159,8 @@ void CommandList::beginTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->Begin(query->disjoint.Get());
-    m_Context.immediateContext->End(query->start.Get());
+    m_DeviceContext->Begin(query->disjoint.Get());
+    m_DeviceContext->End(query->start.Get());
 }
 
 void CommandList::endTimerQuery(ITimerQuery* _query)
@@ -168,8 +168,8 @@ void CommandList::endTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->End(query->end.Get());
-    m_Context.immediateContext->End(query->disjoint.Get());
+    m_DeviceContext->End(query->end.Get());
+    m_DeviceContext->End(query->disjoint.Get());
 }
 
 bool Device::pollTimerQuery(ITimerQuery* _query)
@@ -243,4 +243,73 @@ void Device::resetTimerQuery(ITimerQuery* _query)
     query->time = 0.f;
 }
 
+TimestampQueryPoolHandle Device::createTimestampQueryPool(const TimestampQueryPoolDesc&)
+{
+    utils::NotSupported();
+    return nullptr;
+}
+
+bool Device::getTimestampResults(ITimestampQueryPool*, uint32_t, uint32_t, uint64_t*)
+{
+    utils::NotSupported();
+    return false;
+}
+
+uint64_t Device::getTimestampFrequency(CommandQueue)
+{
+    utils::NotSupported();
+    return 0;
+}
+
+void CommandList::resetTimestamps(ITimestampQueryPool*, uint32_t, uint32_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::writeTimestamp(ITimestampQueryPool*, uint32_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::resolveTimestamps(ITimestampQueryPool*, uint32_t, uint32_t)
+{
+    utils::NotSupported();
+}
+
+QueryPoolHandle Device::createQueryPool(const QueryPoolDesc&)
+{
+    utils::NotSupported();
+    return nullptr;
+}
+
+void CommandList::resetQueries(IQueryPool*, uint32_t, uint32_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::beginQuery(IQueryPool*, uint32_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::endQuery(IQueryPool*, uint32_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::resolveQueries(IQueryPool*, uint32_t, uint32_t, IBuffer*, uint64_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::beginPredication(IBuffer*, uint64_t, PredicationOp)
+{
+    utils::NotSupported();
+}
+
+void CommandList::endPredication()
+{
+    utils::NotSupported();
+}
+
 } // namespace nvrhi::d3d11
\ No newline at end of file
@@ -45,6 +45,8 @@ BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc&)
 
 BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
 {
+    InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
     BindingSet *ret = new BindingSet();
     ret->desc = desc;
     ret->layout = layout;
@@ -121,11 +123,23 @@ BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLa
             const auto buffer = checked_cast<Buffer*>(binding.resourceHandle);
             const BufferRange range = binding.range.resolve(buffer->desc);
 
-            ret->constantBuffers[slot] = buffer->resource.Get();
+            if (binding.type == ResourceType::VolatileConstantBuffer && m_Context.volatileConstantRing)
+            {
+                // The whole buffer is bound from the ring, and the offset is set when the set is bound,
+                // see CommandList::updateVolatileConstantBuffers
+                ret->constantBuffers[slot] = m_Context.volatileConstantRing->getBuffer();
+                ret->constantBufferOffsets[slot] = ~0u;
+                ret->constantBufferCounts[slot] = align((UINT)buffer->volatileData.size(), c_ConstantBufferOffsetSizeAlignment) / sizeOfConstantInBytes;
+                ret->volatileConstantBuffers.push_back(std::make_pair(slot, buffer));
+            }
+            else
+            {
+                ret->constantBuffers[slot] = buffer->resource.Get();
 
-            // Calculate the offset and size of the CB range, in 16-byte constants.
-            ret->constantBufferOffsets[slot] = (UINT)range.byteOffset / sizeOfConstantInBytes;
-            ret->constantBufferCounts[slot] = align((UINT)range.byteSize, c_ConstantBufferOffsetSizeAlignment) / sizeOfConstantInBytes;
+                // Calculate the offset and size of the CB range, in 16-byte constants.
+                ret->constantBufferOffsets[slot] = (UINT)range.byteOffset / sizeOfConstantInBytes;
+                ret->constantBufferCounts[slot] = align((UINT)range.byteSize, c_ConstantBufferOffsetSizeAlignment) / sizeOfConstantInBytes;
+            }
 
             ret->minConstantBufferSlot = std::min(ret->minConstantBufferSlot, slot);
             ret->maxConstantBufferSlot = std::max(ret->maxConstantBufferSlot, slot);
@@ -191,6 +205,12 @@ bool Device::writeDescriptorTable(IDescriptorTable*, const BindingSetItem&)
     return false;
 }
 
+bool Device::writeDescriptorTable(IDescriptorTable*, const BindingSetItem*, uint32_t)
+{
+    utils::NotSupported();
+    return false;
+}
+
 static ID3D11Buffer *NullCBs[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = { nullptr };
 static ID3D11ShaderResourceView *NullSRVs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { nullptr };
 static ID3D11SamplerState *NullSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = { nullptr };
@@ -207,10 +227,10 @@ bool BindingSet::isSupersetOf(const BindingSet& other) const
 
 #define D3D11_SET_ARRAY(method, min, max, array) \
         if ((max) >= (min)) \
-            m_Context.immediateContext->method(min, ((max) - (min) + 1), &(array)[min])
+            m_DeviceContext->method(min, ((max) - (min) + 1), &(array)[min])
 #define D3D11_SET_ARRAY1(method, min, max, array, offsets, counts) \
         if ((max) >= (min)) \
-            m_Context.immediateContext1->method(min, ((max) - (min) + 1), &(array)[min], &(offsets)[min], &(counts)[min])
+            m_DeviceContext1->method(min, ((max) - (min) + 1), &(array)[min], &(offsets)[min], &(counts)[min])
 
 void CommandList::prepareToBindGraphicsResourceSets(
     const BindingSetVector& resourceSets, 
@@ -328,11 +348,13 @@ void CommandList::bindGraphicsResourceSets(
         BindingSet* set = checked_cast<BindingSet*>(_set);
         const GraphicsPipeline* pipeline = checked_cast<const GraphicsPipeline*>(newPipeline);
 
+        NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
+
         ShaderType stagesToBind = set->visibility & pipeline->shaderMask;
 
         if ((stagesToBind & ShaderType::Vertex) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_DeviceContext1)
             {
                 D3D11_SET_ARRAY1(VSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             }
@@ -346,7 +368,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Hull) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_DeviceContext1)
             {
                 D3D11_SET_ARRAY1(HSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             }
@@ -360,7 +382,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Domain) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_DeviceContext1)
             {
                 D3D11_SET_ARRAY1(DSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             }
@@ -374,7 +396,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Geometry) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_DeviceContext1)
             {
                 D3D11_SET_ARRAY1(GSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             }
@@ -388,7 +410,7 @@ void CommandList::bindGraphicsResourceSets(
 
         if ((stagesToBind & ShaderType::Pixel) != 0)
         {
-            if (m_Context.immediateContext1)
+            if (m_DeviceContext1)
             {
                 D3D11_SET_ARRAY1(PSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
             }
@@ -462,7 +484,7 @@ void CommandList::bindComputeResourceSets(
 
             if (set->maxUAVSlot >= set->minUAVSlot)
             {
-                m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
+                m_DeviceContext->CSSetUnorderedAccessViews(set->minUAVSlot,
                     set->maxUAVSlot - set->minUAVSlot + 1,
                     NullUAVs,
                     NullUAVInitialCounts);
@@ -477,7 +499,9 @@ void CommandList::bindComputeResourceSets(
         if ((set->visibility & ShaderType::Compute) == 0)
             continue;
 
-        if (m_Context.immediateContext1)
+        NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
+
+        if (m_DeviceContext1)
         {
             D3D11_SET_ARRAY1(CSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
         }
@@ -490,7 +514,7 @@ void CommandList::bindComputeResourceSets(
 
         if (set->maxUAVSlot >= set->minUAVSlot)
         {
-            m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
+            m_DeviceContext->CSSetUnorderedAccessViews(set->minUAVSlot,
                 set->maxUAVSlot - set->minUAVSlot + 1,
                 &set->UAVs[set->minUAVSlot],
                 NullUAVInitialCounts);
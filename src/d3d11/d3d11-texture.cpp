@@ -24,6 +24,7 @@
 
 #include <nvrhi/utils.h>
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -60,6 +61,25 @@ namespace nvrhi::d3d11
         }
     }
 
+    // D3D11 doesn't report allocation sizes, so they are estimated from the dimensions and format
+    static uint64_t estimateTextureSize(const TextureDesc& desc)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        uint64_t size = 0;
+        for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+        {
+            const uint64_t width = std::max(desc.width >> mipLevel, 1u);
+            const uint64_t height = std::max(desc.height >> mipLevel, 1u);
+            const uint64_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+            size += ((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize) * depth * formatInfo.bytesPerBlock;
+        }
+
+        return size * desc.arraySize * std::max(desc.sampleCount, 1u);
+    }
+
     TextureHandle Device::createTexture(const TextureDesc& d, CpuAccessMode cpuAccess) const
     {
         if (d.isVirtual)
@@ -222,6 +242,7 @@ namespace nvrhi::d3d11
         texture->desc = d;
         texture->resource = pResource;
         texture->sharedHandle = sharedHandle;
+        texture->trackedMemory.set(m_Context.memoryCounters, texture, estimateTextureSize(d));
         return TextureHandle::Create(texture);
     }
 
@@ -287,13 +308,13 @@ namespace nvrhi::d3d11
             {
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
-                m_Context.immediateContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
+                m_DeviceContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
-                m_Context.immediateContext->ClearRenderTargetView(rtv, &clearColor.r);
+                m_DeviceContext->ClearRenderTargetView(rtv, &clearColor.r);
             }
             else
             {
@@ -330,7 +351,7 @@ namespace nvrhi::d3d11
                 UINT clearFlags = 0;
                 if (clearDepth)   clearFlags |= D3D11_CLEAR_DEPTH;
                 if (clearStencil) clearFlags |= D3D11_CLEAR_STENCIL;
-                m_Context.immediateContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
+                m_DeviceContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
             }
         }
     }
@@ -356,14 +377,14 @@ namespace nvrhi::d3d11
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
                 uint32_t clearValues[4] = { clearColor, clearColor, clearColor, clearColor };
-                m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+                m_DeviceContext->ClearUnorderedAccessViewUint(uav, clearValues);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
                 float clearValues[4] = { float(clearColor), float(clearColor), float(clearColor), float(clearColor) };
-                m_Context.immediateContext->ClearRenderTargetView(rtv, clearValues);
+                m_DeviceContext->ClearRenderTargetView(rtv, clearValues);
             }
             else
             {
@@ -416,7 +437,7 @@ namespace nvrhi::d3d11
         srcBox.bottom = resolvedSrcSlice.y + resolvedSrcSlice.height;
         srcBox.back = resolvedSrcSlice.z + resolvedSrcSlice.depth;
 
-        m_Context.immediateContext->CopySubresourceRegion(dst,
+        m_DeviceContext->CopySubresourceRegion(dst,
                                        dstSubresource,
                                        resolvedDstSlice.x, resolvedDstSlice.y, resolvedDstSlice.z,
                                        src,
@@ -457,7 +478,24 @@ namespace nvrhi::d3d11
 
         UINT subresource = D3D11CalcSubresource(mipLevel, arraySlice, dest->desc.mipLevels);
 
-        m_Context.immediateContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+        m_DeviceContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+    }
+
+    void CommandList::writeTextureRegions(ITexture* _dest, const TextureUploadRegion* regions, size_t numRegions)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            const TextureUploadRegion& region = regions[i];
+            const TextureSlice slice = region.slice.resolve(dest->desc);
+
+            UINT subresource = D3D11CalcSubresource(slice.mipLevel, slice.arraySlice, dest->desc.mipLevels);
+
+            D3D11_BOX box = { slice.x, slice.y, slice.z, slice.x + slice.width, slice.y + slice.height, slice.z + slice.depth };
+
+            updateSubresource(dest->resource, subresource, &box, dest->desc.format, region.data, UINT(region.rowPitch), UINT(region.depthPitch));
+        }
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
@@ -480,7 +518,7 @@ namespace nvrhi::d3d11
             {
                 uint32_t dstSubresource = D3D11CalcSubresource(mipLevel + dstSR.baseMipLevel, arrayIndex + dstSR.baseArraySlice, dest->desc.mipLevels);
                 uint32_t srcSubresource = D3D11CalcSubresource(mipLevel + srcSR.baseMipLevel, arrayIndex + srcSR.baseArraySlice, src->desc.mipLevels);
-                m_Context.immediateContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
+                m_DeviceContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
             }
         }
     }
@@ -538,6 +576,8 @@ namespace nvrhi::d3d11
     
     ID3D11ShaderResourceView* Texture::getSRV(Format format, TextureSubresourceSet subresources, TextureDimension dimension)
     {
+        std::lock_guard viewCacheLock(m_ViewCacheMutex);
+
         if (format == Format::UNKNOWN)
         {
             format = desc.format;
@@ -641,6 +681,8 @@ namespace nvrhi::d3d11
 
     ID3D11RenderTargetView* Texture::getRTV(Format format, TextureSubresourceSet subresources)
     {
+        std::lock_guard viewCacheLock(m_ViewCacheMutex);
+
         if (format == Format::UNKNOWN)
         {
             format = desc.format;
@@ -726,6 +768,8 @@ namespace nvrhi::d3d11
 
     ID3D11DepthStencilView* Texture::getDSV(TextureSubresourceSet subresources, bool isReadOnly)
     {
+        std::lock_guard viewCacheLock(m_ViewCacheMutex);
+
         subresources = subresources.resolve(desc, true);
 
 
@@ -799,6 +843,8 @@ namespace nvrhi::d3d11
 
     ID3D11UnorderedAccessView* Texture::getUAV(Format format, TextureSubresourceSet subresources, TextureDimension dimension)
     {
+        std::lock_guard viewCacheLock(m_ViewCacheMutex);
+
         if (format == Format::UNKNOWN)
         {
             format = desc.format;
@@ -29,7 +29,7 @@
 #endif
 
 #if NVRHI_D3D12_WITH_NVAPI
-#include <dxgi.h>
+#include <dxgi1_4.h>
 #include <nvapi.h>
 #endif
 
@@ -81,15 +81,27 @@
 #include <memory>
 #include <queue>
 #include <list>
+#include <map>
 #include <mutex>
+#include <set>
 #include <unordered_map>
 #include <utility>
 
 #include <nvrhi/common/resourcebindingmap.h>
 #include <nvrhi/utils.h>
 #include "../common/state-tracking.h"
+#include "../common/command-list-statistics.h"
+#include "../common/instrumentation.h"
+#include "../common/intern-table.h"
+#include "../common/memory-statistics.h"
+#include "../common/pipeline-compile-pool.h"
+#include "../common/pipeline-statistics.h"
+#include "../common/shader-cache.h"
 #include "../common/dxgi-format.h"
 #include "../common/versioning.h"
+#include "../common/submit-graph.h"
+#include "../common/garbage-collection.h"
+#include "../common/accel-struct-storage.h"
 
 #ifdef NVRHI_WITH_RTXMU
 #include <rtxmu/D3D12AccelStructManager.h>
@@ -108,6 +120,10 @@ namespace nvrhi::d3d12
 
     constexpr RootParameterIndex c_InvalidRootParameterIndex = ~0u; // Used to skip mutable descriptor set
     constexpr DescriptorIndex c_InvalidDescriptorIndex = ~0u;
+    constexpr uint32_t c_TransientDescriptorChunkSizeSRVetc = 1024;
+    constexpr uint32_t c_TransientDescriptorChunkSizeSamplers = 128;
+    constexpr uint32_t c_MaxCompactedSizeQueries = 4096; // BLAS builds with AllowCompaction that can be in flight at once
+    constexpr uint64_t c_CompactedAccelStructChunkSize = 32 * 1024 * 1024;
     constexpr OptionalResourceState c_ResourceStateUnknown = ~0u;
     
     D3D12_SHADER_VISIBILITY convertShaderStage(ShaderType s);
@@ -136,7 +152,9 @@ namespace nvrhi::d3d12
     {
         RefCountPtr<ID3D12Device> device;
         RefCountPtr<ID3D12Device2> device2;
+        RefCountPtr<ID3D12Device3> device3;
         RefCountPtr<ID3D12Device5> device5;
+        RefCountPtr<ID3D12Device7> device7;
         RefCountPtr<ID3D12Device8> device8;
 #if NVRHI_D3D12_WITH_COOPVEC
         RefCountPtr<ID3D12DevicePreview> devicePreview;
@@ -148,15 +166,54 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12CommandSignature> drawIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> drawIndexedIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> dispatchIndirectSignature;
+        RefCountPtr<ID3D12CommandSignature> dispatchMeshIndirectSignature; // null if meshlets are not supported
         RefCountPtr<ID3D12QueryHeap> timerQueryHeap;
         RefCountPtr<Buffer> timerQueryResolveBuffer;
 
         bool logBufferLifetime = false;
+        bool enhancedBarriers = false;
+        bool dynamicDepthBias = false;
         IMessageCallback* messageCallback = nullptr;
+        InstrumentationHook instrumentation;
+        mutable MemoryCounters memoryCounters;
+        PipelineCreationCounters pipelineCounters;
         void error(const std::string& message) const;
         void info(const std::string& message) const;
     };
 
+    uint64_t getPipelineLibraryKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const RootSignature* rootSignature);
+    uint64_t getPipelineLibraryKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const RootSignature* rootSignature);
+    // For pipeline state streams: hashes the shaders and a block of translated, zero-initialized state structures
+    uint64_t getPipelineLibraryKey(const D3D12_SHADER_BYTECODE* shaders, size_t numShaders, const void* states, size_t statesSize, const RootSignature* rootSignature);
+
+    // Persistent storage for compiled PSOs, seeded from and serialized to DeviceDesc::pipelineCacheData.
+    // Pipelines are stored under a key derived from the contents of their D3D12 desc, so that the key is stable across runs.
+    class PipelineLibrary
+    {
+    public:
+        PipelineLibrary(const Context& context, const void* initialData, size_t initialDataSize);
+
+        [[nodiscard]] bool isValid() const { return m_Library != nullptr; }
+
+        RefCountPtr<ID3D12PipelineState> loadGraphicsPipeline(uint64_t key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+        RefCountPtr<ID3D12PipelineState> loadComputePipeline(uint64_t key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+        RefCountPtr<ID3D12PipelineState> loadPipeline(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+        void storePipeline(uint64_t key, ID3D12PipelineState* pipelineState);
+
+        bool serialize(void* data, size_t* dataSize);
+
+    private:
+        const Context& m_Context;
+        std::vector<uint8_t> m_InitialData; // referenced by the library, must stay alive as long as it does
+        RefCountPtr<ID3D12PipelineLibrary> m_Library;
+        RefCountPtr<ID3D12PipelineLibrary1> m_Library1;
+        std::mutex m_Mutex; // loading the same pipeline from multiple threads at once is not safe
+
+        static std::wstring getPipelineName(uint64_t key);
+    };
+
+    struct DescriptorHeapCacheLink;
+
     class StaticDescriptorHeap : public IDescriptorHeap
     {
     private:
@@ -169,14 +226,28 @@ namespace nvrhi::d3d12
         D3D12_GPU_DESCRIPTOR_HANDLE m_StartGpuHandleShaderVisible = { 0 };
         uint32_t m_Stride = 0;
         uint32_t m_NumDescriptors = 0;
-        std::vector<bool> m_AllocatedDescriptors;
-        DescriptorIndex m_SearchStart = 0;
         uint32_t m_NumAllocatedDescriptors = 0;
+        TrackedMemory m_TrackedMemory;
         std::mutex m_Mutex;
 
+        // Free ranges of the heap, keyed by their first descriptor, with a size-ordered index for best-fit allocation.
+        // Adjacent free ranges are always merged.
+        std::map<DescriptorIndex, uint32_t> m_FreeRanges;
+        std::set<std::pair<uint32_t, DescriptorIndex>> m_FreeRangesBySize;
+
+        // Identifies this heap in the per-thread caches used by allocateDescriptor, and lets a thread that exits
+        // return its cached descriptors if the heap still exists
+        std::shared_ptr<DescriptorHeapCacheLink> m_CacheLink;
+
         HRESULT Grow(uint32_t minRequiredSize);
+
+        // The following functions must be called with m_Mutex held
+        DescriptorIndex allocateRange(uint32_t count);
+        void addFreeRange(DescriptorIndex baseIndex, uint32_t count);
+        std::map<DescriptorIndex, uint32_t>::iterator removeFreeRange(std::map<DescriptorIndex, uint32_t>::iterator range);
     public:
         explicit StaticDescriptorHeap(const Context& context);
+        ~StaticDescriptorHeap() override;
 
         HRESULT allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors, bool shaderVisible);
         void copyToShaderVisibleHeap(DescriptorIndex index, uint32_t count = 1);
@@ -203,10 +274,20 @@ namespace nvrhi::d3d12
 #ifdef NVRHI_WITH_RTXMU
         std::mutex asListMutex;
         std::vector<uint64_t> asBuildsCompleted;
+#else
+        // Native BLAS compaction: post-build compacted sizes are written into compactedSizeBuffer, copied into
+        // the readback buffer when the command list is closed, and read when the command list is retired.
+        std::mutex compactionMutex;
+        BufferHandle compactedSizeBuffer; // created on first use
+        BufferHandle compactedSizeReadbackBuffer;
+        utils::BitSetAllocator compactedSizeQueries;
+        std::vector<rt::AccelStructHandle> compactionsReady; // BLASes with known compacted sizes
+        std::unique_ptr<AccelStructStoragePool> compactedStorage;
 #endif
 
         // The cache does not own the RS objects, so store weak references
         std::unordered_map<size_t, RootSignature*> rootsigCache;
+        std::mutex rootsigCacheMutex; // pipelines can be created on the compile threads
 
         explicit DeviceResources(const Context& context, const DeviceDesc& desc);
 
@@ -266,6 +347,7 @@ namespace nvrhi::d3d12
     public:
         HeapDesc desc;
         RefCountPtr<ID3D12Heap> heap;
+        TrackedMemory trackedMemory;
 
         const HeapDesc& getDesc() override { return desc; }
     };
@@ -279,7 +361,7 @@ namespace nvrhi::d3d12
         uint8_t planeCount = 1;
         HANDLE sharedHandle = nullptr;
         HeapHandle heap;
-
+        TrackedMemory trackedMemory;
 
         Texture(const Context& context, DeviceResources& resources, TextureDesc desc, const D3D12_RESOURCE_DESC& resourceDesc)
             : TextureStateExtension(this->desc)
@@ -325,11 +407,15 @@ namespace nvrhi::d3d12
         D3D12_RESOURCE_DESC resourceDesc{};
 
         HeapHandle heap;
+        RefCountPtr<ID3D12Heap> hostMemoryHeap; // for createBufferFromHostMemory
+        TrackedMemory trackedMemory;
 
         RefCountPtr<ID3D12Fence> lastUseFence;
         uint64_t lastUseFenceValue = 0;
         HANDLE sharedHandle = nullptr;
 
+        LastRecordingReference lastRecordingReference;
+
         Buffer(const Context& context, DeviceResources& resources, BufferDesc desc)
             : BufferStateExtension(this->desc)
             , desc(std::move(desc))
@@ -435,6 +521,8 @@ namespace nvrhi::d3d12
 
         const SamplerDesc& getDesc() const override { return m_Desc; }
 
+        StateObjectTables::SamplerTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
+
     private:
         const Context& m_Context;
         const SamplerDesc m_Desc;
@@ -449,6 +537,8 @@ namespace nvrhi::d3d12
 
         // maps a binding slot to an element stride
         std::unordered_map<uint32_t, uint32_t> elementStrides;
+
+        StateObjectTables::InputLayoutTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
         
         uint32_t getNumAttributes() const override;
         const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
@@ -486,10 +576,31 @@ namespace nvrhi::d3d12
         DeviceResources& m_Resources;
     };
 
+    class TimestampQueryPool : public RefCounter<ITimestampQueryPool>
+    {
+    public:
+        TimestampQueryPoolDesc desc;
+        RefCountPtr<ID3D12QueryHeap> queryHeap;
+        BufferHandle resolveBuffer;
+
+        const TimestampQueryPoolDesc& getDesc() const override { return desc; }
+    };
+
+    class QueryPool : public RefCounter<IQueryPool>
+    {
+    public:
+        QueryPoolDesc desc;
+        RefCountPtr<ID3D12QueryHeap> queryHeap;
+        D3D12_QUERY_TYPE queryType = D3D12_QUERY_TYPE_OCCLUSION;
+
+        const QueryPoolDesc& getDesc() const override { return desc; }
+    };
+
     class BindingLayout : public RefCounter<IBindingLayout>
     {
     public:
         BindingLayoutDesc desc;
+        StateObjectTables::BindingLayoutTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
         uint32_t pushConstantByteSize = 0;
         RootParameterIndex rootParameterPushConstants = ~0u;
         RootParameterIndex rootParameterSRVetc = ~0u;
@@ -502,6 +613,16 @@ namespace nvrhi::d3d12
         static_vector<std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
         static_vector<D3D12_ROOT_PARAMETER1, 32> rootParameters;
 
+        // Items of push layouts that are bound as root descriptors instead of descriptor table entries
+        struct RootDescriptorBinding
+        {
+            RootParameterIndex rootParameter = ~0u;
+            D3D12_ROOT_PARAMETER_TYPE parameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+            D3D12_ROOT_DESCRIPTOR1 descriptor{};
+            ResourceType resourceType = ResourceType::None;
+        };
+        static_vector<RootDescriptorBinding, c_MaxPushDescriptorsPerLayout> rootParametersPushDescriptors;
+
         BindingLayout(const BindingLayoutDesc& desc);
 
         const BindingLayoutDesc* getDesc() const override { return &desc; }
@@ -525,6 +646,7 @@ namespace nvrhi::d3d12
     {
     public:
         size_t hash = 0;
+        uint64_t serializedHash = 0; // hash of the serialized root signature, stable across runs
         static_vector<std::pair<BindingLayoutHandle, RootParameterIndex>, c_MaxBindingLayouts> pipelineLayouts;
         RefCountPtr<ID3D12RootSignature> handle;
         uint32_t pushConstantByteSize = 0;
@@ -552,6 +674,7 @@ namespace nvrhi::d3d12
         DescriptorIndex DSV = c_InvalidDescriptorIndex;
         uint32_t rtWidth = 0;
         uint32_t rtHeight = 0;
+        LastRecordingReference lastRecordingReference;
 
         Framebuffer(DeviceResources& resources)
             : m_Resources(resources)
@@ -584,6 +707,7 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12PipelineState> pipelineState;
 
         bool requiresBlendFactor = false;
+        LastRecordingReference lastRecordingReference;
         
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
@@ -597,6 +721,7 @@ namespace nvrhi::d3d12
 
         RefCountPtr<RootSignature> rootSignature;
         RefCountPtr<ID3D12PipelineState> pipelineState;
+        LastRecordingReference lastRecordingReference;
         
         const ComputePipelineDesc& getDesc() const override { return desc; }
         Object getNativeObject(ObjectType objectType) override;
@@ -614,18 +739,48 @@ namespace nvrhi::d3d12
         DX12_ViewportState viewportState;
 
         bool requiresBlendFactor = false;
+        LastRecordingReference lastRecordingReference;
         
         const MeshletPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
         Object getNativeObject(ObjectType objectType) override;
     };
     
+    // Linear allocator for the descriptor tables of transient binding sets.
+    // Descriptors are taken from a static heap in large chunks, and all chunks are returned
+    // to the heap at once when the arena is destroyed together with its command list instance.
+    class TransientDescriptorArena
+    {
+    public:
+        TransientDescriptorArena(StaticDescriptorHeap& heap, uint32_t chunkSize)
+            : m_Heap(heap)
+            , m_ChunkSize(chunkSize)
+        { }
+
+        ~TransientDescriptorArena();
+
+        DescriptorIndex allocate(uint32_t count);
+
+    private:
+        StaticDescriptorHeap& m_Heap;
+        uint32_t m_ChunkSize;
+        std::vector<std::pair<DescriptorIndex, uint32_t>> m_Chunks;
+        DescriptorIndex m_NextDescriptor = 0;
+        uint32_t m_RemainingDescriptors = 0;
+    };
+
     class BindingSet : public RefCounter<IBindingSet>
     {
     public:
         RefCountPtr<BindingLayout> layout;
         BindingSetDesc desc;
 
+        // Transient binding sets get their descriptors from the arenas of a command list instance
+        // and don't release them individually
+        bool transient = false;
+
+        LastRecordingReference lastRecordingReference;
+
         // ShaderType -> DescriptorIndex
         DescriptorIndex descriptorTableSRVetc = 0;
         DescriptorIndex descriptorTableSamplers = 0;
@@ -636,11 +791,17 @@ namespace nvrhi::d3d12
         bool hasUavBindings = false;
 
         static_vector<std::pair<RootParameterIndex, IBuffer*>, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
+
+        // GPU addresses for the layout's rootParametersPushDescriptors, in the same order
+        static_vector<std::pair<RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS>, c_MaxPushDescriptorsPerLayout> rootParametersPushDescriptors;
         
         std::vector<RefCountPtr<IResource>> resources;
 
         std::vector<uint16_t> bindingsThatNeedTransitions;
 
+        // The states required by bindingsThatNeedTransitions, built once by createDescriptors
+        std::vector<RequiredResourceState> requiredStates;
+
         BindingSet(const Context& context, DeviceResources& resources)
             : m_Context(context)
             , m_Resources(resources)
@@ -648,7 +809,9 @@ namespace nvrhi::d3d12
 
         ~BindingSet() override;
 
-        void createDescriptors();
+        // When the arenas are provided, the descriptor tables are allocated from them instead of the device heaps
+        void createDescriptors(TransientDescriptorArena* arenaSRVetc = nullptr, TransientDescriptorArena* arenaSamplers = nullptr);
+        void buildRequiredStates();
 
         const BindingSetDesc* getDesc() const override { return &desc; }
         IBindingLayout* getLayout() const override { return layout; }
@@ -681,6 +844,58 @@ namespace nvrhi::d3d12
 
     DX12_ViewportState convertViewportState(const RasterState& rasterState, const FramebufferInfoEx& framebufferInfo, const ViewportState& vpState);
 
+    class CommandBundle : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+
+        // The states of the resources used by all draws, applied by CommandList::executeBundle
+        std::vector<RequiredResourceState> requiredStates;
+        bool hasUavBindings = false;
+
+        // GraphicsState holds raw pointers, so the bundle keeps the objects used by its draws alive
+        std::vector<RefCountPtr<IResource>> referencedResources;
+
+        RefCountPtr<ID3D12CommandAllocator> allocator;
+        RefCountPtr<ID3D12GraphicsCommandList> commandList;
+
+        // The shader-visible heaps that were bound when the bundle was recorded. The descriptor table handles
+        // in the bundle are relative to them, so the bundle is recorded again when the heaps are reallocated.
+        ID3D12DescriptorHeap* heapSRVetc = nullptr;
+        ID3D12DescriptorHeap* heapSamplers = nullptr;
+        std::mutex mutex;
+
+        CommandBundle(const Context& context, DeviceResources& resources)
+            : m_Context(context)
+            , m_Resources(resources)
+        { }
+
+        void buildRequiredStates();
+        bool record();
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+
+    private:
+        const Context& m_Context;
+        DeviceResources& m_Resources;
+    };
+
+    class IndirectCommandLayout : public RefCounter<IIndirectCommandLayout>
+    {
+    public:
+        IndirectCommandLayoutDesc desc;
+        uint32_t byteStride = 0;
+        RefCountPtr<ID3D12CommandSignature> commandSignature;
+
+        // The desc holds a raw pointer, keep the pipeline alive while the layout exists
+        RefCountPtr<IResource> pipeline;
+        LastRecordingReference lastRecordingReference;
+
+        const IndirectCommandLayoutDesc& getDesc() const override { return desc; }
+        uint32_t getByteStride() const override { return byteStride; }
+        Object getNativeObject(ObjectType objectType) override;
+    };
+
     class TextureState
     {
     public:
@@ -706,6 +921,16 @@ namespace nvrhi::d3d12
     };
 
     D3D12_RESOURCE_STATES convertResourceStates(ResourceStates stateBits);
+
+    struct EnhancedBarrierState
+    {
+        D3D12_BARRIER_SYNC sync = D3D12_BARRIER_SYNC_NONE;
+        D3D12_BARRIER_ACCESS access = D3D12_BARRIER_ACCESS_NO_ACCESS;
+        D3D12_BARRIER_LAYOUT layout = D3D12_BARRIER_LAYOUT_UNDEFINED;
+    };
+
+    // Translates the state bits into the sync scope, access and (for textures) layout of an enhanced barrier
+    EnhancedBarrierState convertResourceStatesEnhanced(ResourceStates stateBits, bool isTexture);
     
     class BufferChunk
     {
@@ -720,31 +945,117 @@ namespace nvrhi::d3d12
         D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
         uint32_t identifier = 0;
 
+        // Chunks of an UploadRing share one buffer, these chunks start at bufferOffset and don't own the mapping
+        uint64_t bufferOffset = 0;
+        bool isRingChunk = false;
+        bool isPoolChunk = false; // owned by a ScratchPool
+
+        TrackedMemory trackedMemory;
+
         ~BufferChunk();
     };
 
+    // Device-wide ring of upload chunks shared by the command lists of one queue.
+    // All chunks are sub-ranges of one persistently mapped buffer, claimed in ring order, and the oldest chunk
+    // is reused once the command list that filled it has finished executing. Command lists sub-allocate from
+    // their claimed chunk without locking, only claiming a chunk takes the ring mutex.
+    class UploadRing
+    {
+    public:
+        UploadRing(const Context& context, class Queue* pQueue, uint64_t ringSize, uint64_t chunkSize);
+
+        uint64_t getChunkSize() const { return m_ChunkSize; }
+
+        // Returns nullptr if the oldest chunk is still in use, or if the ring buffer could not be created
+        std::shared_ptr<BufferChunk> claimChunk(uint64_t currentVersion);
+        void submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion);
+
+        UploadRingStatistics getStatistics();
+
+    private:
+        const Context& m_Context;
+        Queue* m_Queue;
+        uint64_t m_RingSize;
+        uint64_t m_ChunkSize;
+
+        std::mutex m_Mutex;
+        RefCountPtr<ID3D12Resource> m_Buffer;
+        TrackedMemory m_TrackedMemory;
+        void* m_CpuVA = nullptr;
+        bool m_CreationFailed = false;
+        std::vector<std::shared_ptr<BufferChunk>> m_Chunks;
+        size_t m_NextChunk = 0;
+        UploadRingStatistics m_Statistics;
+
+        static bool isChunkInUse(const BufferChunk& chunk, uint64_t completedInstance);
+        uint64_t getBytesInUse() const; // requires m_Mutex
+        bool createBuffer();
+    };
+
+    // Device-wide pool of AS build scratch chunks shared by the command lists of one queue.
+    // Command lists claim whole chunks for their recording and return them on submission; a chunk becomes
+    // free once that submission has finished. The total size of the chunks is limited by the budget.
+    class ScratchPool
+    {
+    public:
+        ScratchPool(const Context& context, class Queue* pQueue, uint64_t maxMemory, uint64_t chunkSize);
+
+        // Returns a chunk of at least 'size' bytes, or nullptr if every chunk that could be used is claimed
+        // by a recording command list and the budget doesn't allow a new one. needsBarrier is set when the chunk
+        // was reused while an earlier submission on the queue may still be using it.
+        std::shared_ptr<BufferChunk> claimChunk(uint64_t size, uint64_t currentVersion, bool& needsBarrier);
+        void submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion);
+
+    private:
+        const Context& m_Context;
+        Queue* m_Queue;
+        uint64_t m_MaxMemory;
+        uint64_t m_ChunkSize;
+        uint64_t m_AllocatedMemory = 0;
+
+        std::mutex m_Mutex;
+        std::vector<std::shared_ptr<BufferChunk>> m_Chunks;
+
+        [[nodiscard]] std::shared_ptr<BufferChunk> createChunk(uint64_t size);
+    };
+
     class UploadManager
     {
     public:
-        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer);
+        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer,
+            UploadRing* pRing = nullptr, ScratchPool* pScratchPool = nullptr);
 
         bool suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset, void** pCpuVA,
             D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment = 256);
 
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
+        // Bytes requested from suballocateBuffer since the last reset, see CommandListStatistics
+        [[nodiscard]] uint64_t getSuballocatedBytes() const { return m_SuballocatedBytes; }
+        void resetSuballocatedBytes() { m_SuballocatedBytes = 0; }
+
     private:
         const Context& m_Context;
         Queue* m_Queue;
         size_t m_DefaultChunkSize = 0;
         uint64_t m_MemoryLimit = 0;
         uint64_t m_AllocatedMemory = 0;
+        uint64_t m_SuballocatedBytes = 0;
         bool m_IsScratchBuffer = false;
 
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
 
+        // Chunks claimed from the shared ring in the current recording, returned to the ring on submission
+        UploadRing* m_Ring = nullptr;
+        std::vector<std::shared_ptr<BufferChunk>> m_RingChunks;
+
+        // Same for the chunks claimed from the shared scratch pool
+        ScratchPool* m_ScratchPool = nullptr;
+        std::vector<std::shared_ptr<BufferChunk>> m_PoolChunks;
+
         [[nodiscard]] std::shared_ptr<BufferChunk> createChunk(size_t size) const;
+        void retireChunk(const std::shared_ptr<BufferChunk>& chunk);
     };
 
     class OpacityMicromap : public RefCounter<rt::IOpacityMicromap>
@@ -769,14 +1080,21 @@ namespace nvrhi::d3d12
     {
     public:
         RefCountPtr<d3d12::Buffer> dataBuffer;
+        RefCountPtr<d3d12::Buffer> instanceBuffer; // only when desc.persistentInstanceBuffer = true
         std::vector<rt::AccelStructHandle> bottomLevelASes;
+        std::vector<rt::AccelStructHandle> instanceBufferBLASes; // per-slot BLAS references for the instance buffer
         std::vector<D3D12_RAYTRACING_INSTANCE_DESC> dxrInstances;
         rt::AccelStructDesc desc;
         bool allowUpdate = false;
         bool compacted = false;
         size_t rtxmuId = ~0ull;
+        size_t builtInstanceCount = 0; // for validating TLAS updates, which must keep the instance count
 #ifdef NVRHI_WITH_RTXMU
         D3D12_GPU_VIRTUAL_ADDRESS rtxmuGpuVA = 0;
+#else
+        uint64_t dataOffset = 0; // nonzero only for compacted BLASes that live in a pooled buffer
+        uint64_t compactedSize = 0; // known once the build with AllowCompaction has finished
+        AccelStructStoragePool* storagePool = nullptr; // set when dataBuffer is owned by the pool
 #endif
 
         AccelStruct(const Context& context)
@@ -792,6 +1110,7 @@ namespace nvrhi::d3d12
         const rt::AccelStructDesc& getDesc() const override { return desc; }
         bool isCompacted() const override { return compacted; }
         uint64_t getDeviceAddress() const override;
+        IBuffer* getInstanceBuffer() const override { return instanceBuffer; }
         
     private:
         const Context& m_Context;
@@ -815,6 +1134,7 @@ namespace nvrhi::d3d12
 
         std::unordered_map<std::string, ExportTableEntry> exports;
         uint32_t maxLocalRootParameters = 0;
+        uint32_t additionIndex = 0; // number of addToRayTracingPipeline calls that produced this pipeline
 
         RayTracingPipeline(const Context& context, Device* device)
             : m_Context(context)
@@ -838,6 +1158,7 @@ namespace nvrhi::d3d12
     {
     public:
         uint32_t committedVersion = 0;
+        uint32_t committedLayoutVersion = 0;
         ID3D12DescriptorHeap* descriptorHeapSRV = nullptr;
         ID3D12DescriptorHeap* descriptorHeapSamplers = nullptr;
         D3D12_DISPATCH_RAYS_DESC dispatchRaysTemplate = {};
@@ -860,6 +1181,8 @@ namespace nvrhi::d3d12
         std::vector<Entry> hitGroups;
 
         uint32_t version = 0;
+        uint32_t layoutVersion = 1; // incremented when records are added or removed
+        std::vector<uint32_t> dirtyRecords; // records replaced since the last upload, only for cached tables
 
         BufferHandle cache;
         ShaderTableState cacheState;
@@ -872,8 +1195,11 @@ namespace nvrhi::d3d12
 
         size_t getUploadSize() const { return pipeline->getShaderTableEntrySize() * size_t(getNumEntries()); }
         bool isStateValid(ShaderTableState const& state, DeviceResources const& resources) const;
+        bool canUpdateRecords(ShaderTableState const& state, DeviceResources const& resources) const;
         void bake(uint8_t* cpuVA, D3D12_GPU_VIRTUAL_ADDRESS gpuVA, DeviceResources& resources,
             ShaderTableState& state);
+        void writeRecord(uint8_t* cpuVA, const Entry& entry, DeviceResources& resources) const;
+        const Entry& getRecord(uint32_t recordIndex) const;
         
         rt::ShaderTableDesc const& getDesc() const override { return m_Desc; }
         uint32_t getNumEntries() const override;
@@ -885,12 +1211,22 @@ namespace nvrhi::d3d12
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
+        bool setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        IBuffer* getBuffer() const override { return cache; }
+        uint32_t getRecordSize() const override { return pipeline->getShaderTableEntrySize(); }
+        uint64_t getRecordOffset(rt::ShaderTableSection section, uint32_t index) const override;
 
     private:
         const Context& m_Context;
         rt::ShaderTableDesc const m_Desc;
 
         bool verifyExport(const RayTracingPipeline::ExportTableEntry* pExport, IBindingSet* bindings) const;
+        bool replaceRecord(std::vector<Entry>& section, uint32_t index, const char* exportName, IBindingSet* bindings);
+        uint32_t getRecordIndex(rt::ShaderTableSection section, uint32_t index) const;
+        void markRecordDirty(uint32_t recordIndex);
+        void markLayoutChanged();
     };
 
 
@@ -903,6 +1239,7 @@ namespace nvrhi::d3d12
         uint64_t lastCompletedInstance = 0;
         std::atomic<uint64_t> recordingInstance = 1;
         std::deque<std::shared_ptr<class CommandListInstance>> commandListsInFlight;
+        std::mutex inFlightMutex; // the background garbage collector retires the instances on its own thread
 
         explicit Queue(const Context& context, ID3D12CommandQueue* queue);
         uint64_t updateLastCompletedInstance();
@@ -918,6 +1255,8 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12GraphicsCommandList> commandList;
         RefCountPtr<ID3D12GraphicsCommandList4> commandList4;
         RefCountPtr<ID3D12GraphicsCommandList6> commandList6;
+        RefCountPtr<ID3D12GraphicsCommandList7> commandList7; // only queried when Context::enhancedBarriers is set
+        RefCountPtr<ID3D12GraphicsCommandList9> commandList9; // only queried when Context::dynamicDepthBias is set
 #if NVRHI_D3D12_WITH_COOPVEC
         RefCountPtr<ID3D12GraphicsCommandListPreview> commandListPreview;
 #endif
@@ -940,9 +1279,19 @@ namespace nvrhi::d3d12
         std::vector<RefCountPtr<StagingTexture>> referencedStagingTextures;
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers;
         std::vector<RefCountPtr<TimerQuery>> referencedTimerQueries;
+        std::vector<RefCountPtr<BindingSet>> transientBindingSets;
+        std::unique_ptr<TransientDescriptorArena> transientDescriptorsSRVetc;
+        std::unique_ptr<TransientDescriptorArena> transientDescriptorsSamplers;
 #ifdef NVRHI_WITH_RTXMU
         std::vector<uint64_t> rtxmuBuildIds;
         std::vector<uint64_t> rtxmuCompactionIds;
+#else
+        struct CompactedSizeQuery
+        {
+            rt::AccelStructHandle accelStruct;
+            int index = -1;
+        };
+        std::vector<CompactedSizeQuery> compactedSizeQueries;
 #endif
     };
 
@@ -958,7 +1307,18 @@ namespace nvrhi::d3d12
         void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
         void requireSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates state);
         void requireBufferState(IBuffer* buffer, ResourceStates state);
+
+        // Keeps the resource alive until the command list instance is retired. Resources that are bound
+        // many times in one recording are only referenced once, see LastRecordingReference.
+        template<typename T> void referenceResource(T* resource)
+        {
+            if (resource->lastRecordingReference.markReferenced(m_RecordingVersion))
+                m_Instance->referencedResources.push_back(resource);
+        }
+
+        void recordStateFixups(const std::vector<StateFixup>& fixups);
         ID3D12CommandList* getD3D12CommandList() const { return m_ActiveCommandList->commandList; }
+        CommandListResourceStateTracker& getStateTracker() { return m_StateTracker; }
 
         // IResource implementation
 
@@ -981,6 +1341,7 @@ namespace nvrhi::d3d12
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
@@ -988,10 +1349,19 @@ namespace nvrhi::d3d12
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void beginRenderPassScope(const RenderPassScope& scope) override;
+        void endRenderPassScope() override;
+        void executeBundle(ICommandBundle* bundle) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndexedMulti(const DrawArguments* args, size_t numDraws) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
@@ -999,25 +1369,46 @@ namespace nvrhi::d3d12
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
         void dispatchIndirect(uint32_t offsetBytes) override;
+        void executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+            uint32_t countOffsetBytes) override;
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
+        void writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        rt::IndirectInstanceDesc* allocateTopLevelInstances(size_t numInstances) override;
+        void buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes) override;
+        void beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op) override;
+        void endPredication() override;
 
         void beginMarker(const char *name) override;
         void endMarker() override;
@@ -1037,6 +1428,13 @@ namespace nvrhi::d3d12
         
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
 
         void commitBarriers() override;
 
@@ -1045,6 +1443,8 @@ namespace nvrhi::d3d12
 
         nvrhi::IDevice* getDevice() override;
         const CommandListParameters& getDesc() override { return m_Desc; }
+        BarrierStatistics getBarrierStatistics() override { return m_StateTracker.getStatistics(); }
+        CommandListStatistics getStatistics() override;
 
         // D3D12 specific methods
 
@@ -1061,6 +1461,8 @@ namespace nvrhi::d3d12
             uint32_t bindingUpdateMask,
             IBuffer* indirectParams,
             bool updateIndirectParams,
+            IBuffer* indirectCountBuffer,
+            bool updateIndirectCountBuffer,
             const RootSignature* rootSignature);
 
         void setGraphicsBindings(
@@ -1089,6 +1491,9 @@ namespace nvrhi::d3d12
         UploadManager m_DxrScratchManager;
         CommandListResourceStateTracker m_StateTracker;
         bool m_EnableAutomaticBarriers = true;
+
+        // Upload and scratch bytes are counted by the upload managers. Mutable because the pipeline binding functions are const.
+        mutable CommandListStatistics m_Statistics;
         
         CommandListParameters m_Desc;
 
@@ -1096,6 +1501,15 @@ namespace nvrhi::d3d12
         std::list<std::shared_ptr<InternalCommandList>> m_CommandListPool;
         std::shared_ptr<CommandListInstance> m_Instance;
         uint64_t m_RecordingVersion = 0;
+
+        // Upload memory returned by allocateTopLevelInstances in the current recording
+        struct TopLevelInstanceAllocation
+        {
+            const rt::IndirectInstanceDesc* cpuVA = nullptr;
+            D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
+            size_t numInstances = 0;
+        };
+        std::vector<TopLevelInstanceAllocation> m_TopLevelInstanceAllocations;
 #if NVRHI_WITH_AFTERMATH
         AftermathMarkerTracker m_AftermathTracker;
 #endif
@@ -1123,6 +1537,8 @@ namespace nvrhi::d3d12
         bool m_AnyVolatileBufferWrites = false;
 
         std::vector<D3D12_RESOURCE_BARRIER> m_D3DBarriers; // Used locally in commitBarriers, member to avoid re-allocations
+        std::vector<D3D12_TEXTURE_BARRIER> m_D3DTextureBarriers; // Same, for commitEnhancedBarriers
+        std::vector<D3D12_BUFFER_BARRIER> m_D3DBufferBarriers;
 
         // Bound volatile buffer state. Saves currently bound volatile buffers and their current GPU VAs.
         // Necessary to patch the bound VAs when a buffer is updated between setGraphicsState and draw, or between draws.
@@ -1132,17 +1548,29 @@ namespace nvrhi::d3d12
 
         std::unordered_map<rt::IShaderTable*, std::unique_ptr<ShaderTableState>> m_UncachedShaderTableStates;
         ShaderTableState& getShaderTableState(rt::IShaderTable* shaderTable);
+        bool updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state);
         
         void clearStateCache();
+        void commitEnhancedBarriers();
 
         void bindGraphicsPipeline(GraphicsPipeline* pso, bool updateRootSignature) const;
         void bindMeshletPipeline(MeshletPipeline* pso, bool updateRootSignature) const;
         void bindFramebuffer(Framebuffer* fb);
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer);
+        void bindVertexBuffers(const GraphicsPipeline* pso, const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers);
         void unbindShadingRateState();
         
         std::shared_ptr<InternalCommandList> createInternalCommandList() const;
 
+        void requireBottomLevelBuildInputStates(const rt::GeometryDesc* pGeometries, size_t numGeometries);
+        void buildBottomLevelAccelStructInternal(AccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags);
         void buildTopLevelAccelStructInternal(AccelStruct* as, D3D12_GPU_VIRTUAL_ADDRESS instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags);
+#ifndef NVRHI_WITH_RTXMU
+        int allocateCompactedSizeQuery();
+        void copyCompactedSizesToReadback();
+        // Returns the query slots of the current instance when it is dropped without being executed
+        void releaseCompactedSizeQueries();
+#endif
     };
 
     class Device final : public RefCounter<IDevice>
@@ -1171,13 +1599,18 @@ namespace nvrhi::d3d12
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
+        BufferHandle createBufferFromHostMemory(const BufferDesc& d, void* hostMemory) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, uint64_t offset, size_t size) override;
         void unmapBuffer(IBuffer* b) override;
+        void flushMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
+        void invalidateMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
@@ -1201,10 +1634,16 @@ namespace nvrhi::d3d12
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimestampQueryPoolHandle createTimestampQueryPool(const TimestampQueryPoolDesc& desc) override;
+        bool getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) override;
+        uint64_t getTimestampFrequency(CommandQueue queue) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
         FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+        IndirectCommandLayoutHandle createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc) override;
         
         GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
         
@@ -1217,6 +1656,12 @@ namespace nvrhi::d3d12
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override;
+        PendingPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createGraphicsPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override { return m_PipelineCompilePool.createComputePipeline(this, desc); }
+        PendingPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createMeshletPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override { return m_PipelineCompilePool.createRayTracingPipeline(this, desc); }
+        PendingPipelineHandle addToRayTracingPipelineAsync(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override { return m_PipelineCompilePool.addToRayTracingPipeline(this, pipeline, additions); }
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -1226,10 +1671,13 @@ namespace nvrhi::d3d12
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems) override;
 
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
         MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::AccelStructBuildSizes getAccelStructBuildSizes(const rt::AccelStructDesc& desc) override;
+        bool isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header) override;
         rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
 
         bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
@@ -1237,16 +1685,30 @@ namespace nvrhi::d3d12
         nvrhi::CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances = nullptr) override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        bool runIncrementalGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds = 2) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
+        void setInstrumentationCallback(IInstrumentationCallback* callback) override { m_Context.instrumentation.set(callback); }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+        bool getPipelineCacheData(void* data, size_t* dataSize) override;
+        UploadRingStatistics getUploadRingStatistics(CommandQueue queue) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void enumerateResourceAllocations(IResourceAllocationCallback& callback) override { m_Context.memoryCounters.enumerateAllocations(callback); }
+        BarrierStatistics getBarrierStatistics(CommandQueue queue) override;
+        void resetBarrierStatistics() override;
+        CommandListStatistics getCommandListStatistics(CommandQueue queue) override;
+        void resetCommandListStatistics() override;
+        PipelineCreationStatistics getPipelineCreationStatistics() override { return m_Context.pipelineCounters.get(); }
+        void resetPipelineCreationStatistics() override { m_Context.pipelineCounters.reset(); }
 
         // d3d12::IDevice implementation
 
@@ -1257,10 +1719,13 @@ namespace nvrhi::d3d12
 
         // Internal interface
         Queue* getQueue(CommandQueue type) { return m_Queues[int(type)].get(); }
+        UploadRing* getUploadRing(CommandQueue type) { return m_UploadRings[int(type)].get(); }
+        ScratchPool* getScratchPool(CommandQueue type) { return m_ScratchPools[int(type)].get(); }
 
         Context& getContext() { return m_Context; }
 
         bool setHlslExtensionsUAV(uint32_t slot);
+        rt::PipelineHandle createRayTracingPipelineInternal(const rt::PipelineDesc& desc, RayTracingPipeline* basePipeline);
 
         bool GetAccelStructPreBuildInfo(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO& outPreBuildInfo, const rt::AccelStructDesc& desc) const;
 
@@ -1273,11 +1738,26 @@ namespace nvrhi::d3d12
         DeviceResources m_Resources;
 
         std::array<std::unique_ptr<Queue>, (int)CommandQueue::Count> m_Queues;
+        std::array<std::unique_ptr<UploadRing>, (int)CommandQueue::Count> m_UploadRings;
+        std::array<std::unique_ptr<ScratchPool>, (int)CommandQueue::Count> m_ScratchPools;
         HANDLE m_FenceEvent;
 
+        RefCountPtr<IDXGIAdapter3> m_DxgiAdapter; // used for memory budget queries, may be null
+        MemoryBudgetMonitor m_MemoryBudgetMonitor;
+
         std::mutex m_Mutex;
 
         std::vector<ID3D12CommandList*> m_CommandListsToExecute; // used locally in executeCommandLists, member to avoid re-allocations
+        std::vector<CommandList*> m_ResolvedCommandLists; // same
+        std::vector<StateFixup> m_StateFixups; // same
+        std::array<std::vector<nvrhi::CommandListHandle>, (int)CommandQueue::Count> m_StateFixupCommandLists;
+        std::vector<SubmitBatch> m_SubmitBatches; // used locally in executeSubmitGraph, members to avoid re-allocations
+        std::vector<uint32_t> m_SubmitNodeBatches;
+        std::vector<uint64_t> m_SubmitBatchInstances;
+
+        // Sums of the barrier counters of the command lists executed on each queue
+        std::array<BarrierStatistics, (int)CommandQueue::Count> m_BarrierStatistics;
+        std::array<CommandListStatistics, (int)CommandQueue::Count> m_CommandListStatistics;
         
         bool m_NvapiIsInitialized = false;
         bool m_SinglePassStereoSupported = false;
@@ -1285,6 +1765,7 @@ namespace nvrhi::d3d12
         bool m_FastGeometryShaderSupported = false;
         bool m_RayTracingSupported = false;
         bool m_TraceRayInlineSupported = false;
+        bool m_RayTracingPipelineLibrariesSupported = false;
         bool m_MeshletsSupported = false;
         bool m_VariableRateShadingSupported = false;
         bool m_OpacityMicromapSupported = false;
@@ -1293,12 +1774,17 @@ namespace nvrhi::d3d12
         bool m_SpheresSupported = false;
         bool m_ShaderExecutionReorderingSupported = false;
         bool m_SamplerFeedbackSupported = false;
+        bool m_HostMemoryImportSupported = false;
         bool m_AftermathEnabled = false;
         bool m_HeapDirectlyIndexedEnabled = false;
         bool m_CoopVecInferencingSupported = false;
         bool m_CoopVecTrainingSupported = false;
         AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
-
+        std::unique_ptr<PipelineLibrary> m_PipelineLibrary;
+        std::unique_ptr<ShaderCache> m_ShaderCache; // null unless DeviceDesc::enableShaderCache
+        std::unique_ptr<StateObjectTables> m_InternedStates; // null unless DeviceDesc::enableStateObjectInterning
+        PipelineCompilePool m_PipelineCompilePool;
+        BackgroundGarbageCollector m_BackgroundGarbageCollector;
 
         D3D12_FEATURE_DATA_D3D12_OPTIONS  m_Options = {};
         D3D12_FEATURE_DATA_D3D12_OPTIONS1 m_Options1 = {};
@@ -1307,9 +1793,30 @@ namespace nvrhi::d3d12
         D3D12_FEATURE_DATA_D3D12_OPTIONS7 m_Options7 = {};
 
         RefCountPtr<RootSignature> getRootSignature(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& pipelineLayouts, bool allowInputLayout);
-        RefCountPtr<ID3D12PipelineState> createPipelineState(const GraphicsPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
-        RefCountPtr<ID3D12PipelineState> createPipelineState(const ComputePipelineDesc& desc, RootSignature* pRS) const;
-        RefCountPtr<ID3D12PipelineState> createPipelineState(const MeshletPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
+        // Issues one UpdateTileMappings call per mapping of the texture. The vectors are scratch storage owned by the caller.
+        void updateTileMappingsForTexture(Queue* queue, const TextureTilesMappingUpdate& update,
+            std::vector<D3D12_TILED_RESOURCE_COORDINATE>& resourceCoordinates, std::vector<D3D12_TILE_REGION_SIZE>& regionSizes,
+            std::vector<D3D12_TILE_RANGE_FLAGS>& rangeFlags, std::vector<UINT>& heapStartOffsets, std::vector<UINT>& rangeTileCounts);
+        // 'cacheResult' is set to Hit or Miss when the pipeline library is used for the state, and left unchanged otherwise.
+        RefCountPtr<ID3D12PipelineState> createPipelineState(const GraphicsPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo, PipelineCacheResult& cacheResult) const;
+        RefCountPtr<ID3D12PipelineState> createPipelineState(const ComputePipelineDesc& desc, RootSignature* pRS, PipelineCacheResult& cacheResult) const;
+        RefCountPtr<ID3D12PipelineState> createPipelineState(const MeshletPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo, PipelineCacheResult& cacheResult) const;
+
+        // Fills m_ResolvedCommandLists with the command lists to execute, preceded by fix-up command lists
+        // for the ones that have deferred initial states. fixupsUsed is the number of fix-up command lists
+        // of the execution queue that are already taken by the current submission, and is advanced by this call.
+        void resolveDeferredInitialStates(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, size_t& fixupsUsed);
+
+        // Executes m_ResolvedCommandLists on the queue and signals its fence, returns the submitted instance
+        uint64_t submitResolvedCommandLists(CommandQueue executionQueue);
+
+        // Releases the command list instances that have finished executing, oldest first, until the budget
+        // is used up if one is given. Returns true if all finished instances were released.
+        bool retireCommandListInstances(Queue* pQueue, uint64_t completedInstance, GarbageCollectionBudgetTracker* budget);
+
+        // Creates the descriptor for one item in the non-shader-visible copy of a descriptor table,
+        // the caller is responsible for copying it into the shader visible heap
+        bool createDescriptorTableItem(DescriptorTable* descriptorTable, const BindingSetItem& binding);
     
     };
 
@@ -181,6 +181,80 @@ namespace nvrhi::d3d12
 
         buffer->postCreate();
 
+        buffer->trackedMemory.set(m_Context.memoryCounters, buffer,
+            align(resourceDesc.Width, uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)));
+
+        return BufferHandle::Create(buffer);
+    }
+
+    BufferHandle Device::createBufferFromHostMemory(const BufferDesc& d, void* hostMemory)
+    {
+        if (!m_HostMemoryImportSupported)
+        {
+            utils::NotSupported();
+            return nullptr;
+        }
+
+        BufferDesc desc = d;
+        desc.initialState = ResourceStates::Common;
+
+        // The heap covers the entire allocation that starts at hostMemory, and it's not counted
+        // in the memory statistics because the application owns the memory
+        RefCountPtr<ID3D12Heap> heap;
+        HRESULT res = m_Context.device3->OpenExistingHeapFromAddress(hostMemory, IID_PPV_ARGS(&heap));
+
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "OpenExistingHeapFromAddress call failed for buffer " << utils::DebugNameToString(d.debugName)
+                << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        if (heap->GetDesc().SizeInBytes < desc.byteSize)
+        {
+            std::stringstream ss;
+            ss << "Host memory allocation for buffer " << utils::DebugNameToString(d.debugName) << " is "
+                << heap->GetDesc().SizeInBytes << " bytes, which is smaller than the buffer size " << desc.byteSize;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        Buffer* buffer = new Buffer(m_Context, m_Resources, desc);
+
+        D3D12_RESOURCE_DESC& resourceDesc = buffer->resourceDesc;
+        resourceDesc.Width = buffer->desc.byteSize;
+        resourceDesc.Height = 1;
+        resourceDesc.DepthOrArraySize = 1;
+        resourceDesc.MipLevels = 1;
+        resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+        resourceDesc.SampleDesc.Count = 1;
+        resourceDesc.SampleDesc.Quality = 0;
+        resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+        // Existing heaps are cross-adapter heaps, which only accept cross-adapter resources
+        resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_CROSS_ADAPTER;
+        if (buffer->desc.canHaveUAVs)
+            resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        res = m_Context.device->CreatePlacedResource(heap, 0, &resourceDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer->resource));
+
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreatePlacedResource call failed for buffer " << utils::DebugNameToString(d.debugName)
+                << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+
+            delete buffer;
+            return nullptr;
+        }
+
+        buffer->hostMemoryHeap = heap;
+        buffer->postCreate();
+
         return BufferHandle::Create(buffer);
     }
 
@@ -253,17 +327,25 @@ namespace nvrhi::d3d12
     {
         Buffer* b = checked_cast<Buffer*>(_b);
 
+        return mapBuffer(b, flags, 0, size_t(b->desc.byteSize));
+    }
+
+    void *Device::mapBuffer(IBuffer* _b, CpuAccessMode flags, uint64_t offset, size_t size)
+    {
+        Buffer* b = checked_cast<Buffer*>(_b);
+
         if (b->lastUseFence)
         {
             WaitForFence(b->lastUseFence, b->lastUseFenceValue, m_FenceEvent);
             b->lastUseFence = nullptr;
         }
 
+        // Only the read range of a readback heap needs CPU cache maintenance, so keep it as small as possible
         D3D12_RANGE range;
 
         if (flags == CpuAccessMode::Read)
         {
-            range = { 0, b->desc.byteSize };
+            range = { size_t(offset), size_t(std::min(offset + size, b->desc.byteSize)) };
         } else {
             range = { 0, 0 };
         }
@@ -281,7 +363,7 @@ namespace nvrhi::d3d12
             return nullptr;
         }
         
-        return mappedBuffer;
+        return static_cast<char*>(mappedBuffer) + offset;
     }
 
     void Device::unmapBuffer(IBuffer* _b)
@@ -291,6 +373,15 @@ namespace nvrhi::d3d12
         b->resource->Unmap(0, nullptr);
     }
 
+    void Device::flushMappedRange(IBuffer*, uint64_t, size_t)
+    {
+        // CPU-visible heaps are always coherent in D3D12
+    }
+
+    void Device::invalidateMappedRange(IBuffer*, uint64_t, size_t)
+    {
+    }
+
     MemoryRequirements Device::getBufferMemoryRequirements(IBuffer* _buffer)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
@@ -338,6 +429,7 @@ namespace nvrhi::d3d12
 
         buffer->heap = heap;
         buffer->postCreate();
+        buffer->trackedMemory.setPlaced(m_Context.memoryCounters, buffer, getBufferMemoryRequirements(buffer).size, heap, offset);
 
         return true;
     }
@@ -522,6 +614,7 @@ namespace nvrhi::d3d12
         {
             m_VolatileConstantBufferAddresses[buffer] = gpuVA;
             m_AnyVolatileBufferWrites = true;
+            NVRHI_COUNT_STATISTIC(m_Statistics, volatileConstantBufferWrites, 1);
         }
         else
         {
@@ -33,11 +33,16 @@ namespace nvrhi::d3d12
         , m_Resources(resources)
         , m_Device(device)
         , m_Queue(device->getQueue(params.queueType))
-        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false)
-        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true)
+        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false,
+            params.useSharedUploadRing ? device->getUploadRing(params.queueType) : nullptr)
+        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true, nullptr,
+            params.useSharedScratchPool ? device->getScratchPool(params.queueType) : nullptr)
         , m_StateTracker(context.messageCallback)
         , m_Desc(params)
     {
+        m_StateTracker.setDeferInitialStates(params.deferInitialStates);
+        m_StateTracker.setEnableStatistics(params.enableBarrierStatistics);
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
@@ -46,6 +51,11 @@ namespace nvrhi::d3d12
 
     CommandList::~CommandList()
     {
+#ifndef NVRHI_WITH_RTXMU
+        if (m_Instance)
+            releaseCompactedSizeQueries();
+#endif
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
@@ -104,6 +114,10 @@ namespace nvrhi::d3d12
 
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList4));
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList6));
+        if (m_Context.enhancedBarriers && m_Desc.queueType != CommandQueue::Copy)
+            commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList7));
+        if (m_Context.dynamicDepthBias && m_Desc.queueType == CommandQueue::Graphics)
+            commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList9));
 #if NVRHI_D3D12_WITH_COOPVEC
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandListPreview));
 #endif
@@ -150,6 +164,14 @@ namespace nvrhi::d3d12
             m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
     }
 
+    CommandListStatistics CommandList::getStatistics()
+    {
+        CommandListStatistics statistics = m_Statistics;
+        statistics.uploadBytes = m_UploadManager.getSuballocatedBytes();
+        statistics.scratchBytes = m_DxrScratchManager.getSuballocatedBytes();
+        return statistics;
+    }
+
     D3D12_GPU_VIRTUAL_ADDRESS CommandList::getBufferGpuVA(IBuffer* _buffer)
     {
         if (!_buffer)
@@ -234,6 +256,11 @@ namespace nvrhi::d3d12
 
     void CommandList::open()
     {
+        m_StateTracker.resetStatistics();
+        m_Statistics = CommandListStatistics();
+        m_UploadManager.resetSuballocatedBytes();
+        m_DxrScratchManager.resetSuballocatedBytes();
+
         uint64_t completedInstance = m_Queue->updateLastCompletedInstance();
 
         std::shared_ptr<InternalCommandList> chunk;
@@ -261,12 +288,19 @@ namespace nvrhi::d3d12
 
         m_ActiveCommandList = chunk;
 
+#ifndef NVRHI_WITH_RTXMU
+        // The previous recording was never executed, its queries would otherwise stay allocated forever
+        if (m_Instance)
+            releaseCompactedSizeQueries();
+#endif
+
         m_Instance = std::make_shared<CommandListInstance>();
         m_Instance->commandAllocator = m_ActiveCommandList->allocator;
         m_Instance->commandList = m_ActiveCommandList->commandList;
         m_Instance->commandQueue = m_Desc.queueType;
 
         m_RecordingVersion = MakeVersion(m_Queue->recordingInstance++, m_Desc.queueType, false);
+        m_TopLevelInstanceAllocations.clear();
     }
 
     void CommandList::clearStateCache()
@@ -307,6 +341,13 @@ namespace nvrhi::d3d12
 
     void CommandList::close()
     {
+        m_StateTracker.endSplitTransitions();
+
+#ifndef NVRHI_WITH_RTXMU
+        if (!m_Instance->compactedSizeQueries.empty())
+            copyCompactedSizesToReadback();
+#endif
+
         m_StateTracker.keepBufferInitialStates();
         m_StateTracker.keepTextureInitialStates();
         commitBarriers();
@@ -41,7 +41,7 @@ namespace nvrhi::d3d12
     }
 
 
-    RefCountPtr<ID3D12PipelineState> Device::createPipelineState(const ComputePipelineDesc & state, RootSignature* pRS) const
+    RefCountPtr<ID3D12PipelineState> Device::createPipelineState(const ComputePipelineDesc & state, RootSignature* pRS, PipelineCacheResult& cacheResult) const
     {
         RefCountPtr<ID3D12PipelineState> pipelineState;
 
@@ -67,6 +67,19 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        uint64_t libraryKey = 0;
+        if (m_PipelineLibrary)
+        {
+            libraryKey = getPipelineLibraryKey(desc, pRS);
+            pipelineState = m_PipelineLibrary->loadComputePipeline(libraryKey, desc);
+            if (pipelineState)
+            {
+                cacheResult = PipelineCacheResult::Hit;
+                return pipelineState;
+            }
+            cacheResult = PipelineCacheResult::Miss;
+        }
+
         const HRESULT hr = m_Context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
 
         if (FAILED(hr))
@@ -75,13 +88,20 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        if (m_PipelineLibrary)
+            m_PipelineLibrary->storePipeline(libraryKey, pipelineState);
+
         return pipelineState;
     }
 
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Compute, desc);
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
-        RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS);
+        PipelineCacheResult cacheResult = PipelineCacheResult::Unknown;
+        RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, cacheResult);
+        creationScope.setCacheResult(cacheResult);
 
         if (pPSO == nullptr)
             return nullptr;
@@ -93,6 +113,8 @@ namespace nvrhi::d3d12
         pso->rootSignature = pRS;
         pso->pipelineState = pPSO;
 
+        creationScope.setPipeline(pso);
+
         return ComputePipelineHandle::Create(pso);
     }
 
@@ -105,6 +127,7 @@ namespace nvrhi::d3d12
 
         bool updatePipeline = !m_CurrentComputeStateValid || m_CurrentComputeState.pipeline != state.pipeline;
         bool updateIndirectParams = !m_CurrentComputeStateValid || m_CurrentComputeState.indirectParams != state.indirectParams;
+        bool updateIndirectCountBuffer = !m_CurrentComputeStateValid || m_CurrentComputeState.indirectCountBuffer != state.indirectCountBuffer;
 
         uint32_t bindingUpdateMask = 0;
         if (!m_CurrentComputeStateValid || updateRootSignature)
@@ -124,11 +147,13 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             m_ActiveCommandList->commandList->SetPipelineState(pso->pipelineState);
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
             
-            m_Instance->referencedResources.push_back(pso);
+            referenceResource(pso);
         }
 
-        setComputeBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
+        setComputeBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams,
+            state.indirectCountBuffer, updateIndirectCountBuffer, pso->rootSignature);
 
         unbindShadingRateState();
         
@@ -168,6 +193,7 @@ namespace nvrhi::d3d12
         updateComputeVolatileBuffers();
 
         m_ActiveCommandList->commandList->Dispatch(groupsX, groupsY, groupsZ);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
     }
 
     void CommandList::dispatchIndirect(uint32_t offsetBytes)
@@ -178,6 +204,7 @@ namespace nvrhi::d3d12
         updateComputeVolatileBuffers();
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchIndirectSignature, 1, indirectParams->resource, offsetBytes, nullptr, 0);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
     }
 
 } // namespace nvrhi::d3d12
@@ -271,6 +271,95 @@ namespace nvrhi::d3d12
         if ((stateBits & ResourceStates::OpacityMicromapWrite) != 0) result |= D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
         if ((stateBits & ResourceStates::ConvertCoopVecMatrixInput) != 0) result |= D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
         if ((stateBits & ResourceStates::ConvertCoopVecMatrixOutput) != 0) result |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+        if ((stateBits & ResourceStates::Predication) != 0) result |= D3D12_RESOURCE_STATE_PREDICATION;
+
+        return result;
+    }
+
+    EnhancedBarrierState convertResourceStatesEnhanced(ResourceStates stateBits, bool isTexture)
+    {
+        EnhancedBarrierState result;
+
+        if (stateBits == ResourceStates::Unknown)
+            return result;
+
+        if (stateBits == ResourceStates::Common || stateBits == ResourceStates::Present)
+        {
+            result.sync = D3D12_BARRIER_SYNC_ALL;
+            result.access = D3D12_BARRIER_ACCESS_COMMON;
+            result.layout = isTexture
+                ? (stateBits == ResourceStates::Present ? D3D12_BARRIER_LAYOUT_PRESENT : D3D12_BARRIER_LAYOUT_COMMON)
+                : D3D12_BARRIER_LAYOUT_UNDEFINED;
+            return result;
+        }
+
+        D3D12_BARRIER_SYNC sync = D3D12_BARRIER_SYNC_NONE;
+        D3D12_BARRIER_ACCESS access = D3D12_BARRIER_ACCESS_COMMON; // also 0
+
+        auto add = [&sync, &access, stateBits](ResourceStates bit, D3D12_BARRIER_SYNC bitSync, D3D12_BARRIER_ACCESS bitAccess)
+        {
+            if ((stateBits & bit) != 0)
+            {
+                sync |= bitSync;
+                access |= bitAccess;
+            }
+        };
+
+        add(ResourceStates::ConstantBuffer, D3D12_BARRIER_SYNC_ALL_SHADING, D3D12_BARRIER_ACCESS_CONSTANT_BUFFER);
+        add(ResourceStates::VertexBuffer, D3D12_BARRIER_SYNC_VERTEX_SHADING, D3D12_BARRIER_ACCESS_VERTEX_BUFFER);
+        add(ResourceStates::IndexBuffer, D3D12_BARRIER_SYNC_INDEX_INPUT, D3D12_BARRIER_ACCESS_INDEX_BUFFER);
+        add(ResourceStates::IndirectArgument, D3D12_BARRIER_SYNC_EXECUTE_INDIRECT, D3D12_BARRIER_ACCESS_INDIRECT_ARGUMENT);
+        add(ResourceStates::ShaderResource, D3D12_BARRIER_SYNC_ALL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE);
+        add(ResourceStates::UnorderedAccess, D3D12_BARRIER_SYNC_ALL_SHADING, D3D12_BARRIER_ACCESS_UNORDERED_ACCESS);
+        add(ResourceStates::RenderTarget, D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET);
+        add(ResourceStates::DepthWrite, D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE);
+        add(ResourceStates::DepthRead, D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ);
+        add(ResourceStates::StreamOut, D3D12_BARRIER_SYNC_ALL, D3D12_BARRIER_ACCESS_STREAM_OUTPUT);
+        add(ResourceStates::CopyDest, D3D12_BARRIER_SYNC_COPY, D3D12_BARRIER_ACCESS_COPY_DEST);
+        add(ResourceStates::CopySource, D3D12_BARRIER_SYNC_COPY, D3D12_BARRIER_ACCESS_COPY_SOURCE);
+        add(ResourceStates::ResolveDest, D3D12_BARRIER_SYNC_RESOLVE, D3D12_BARRIER_ACCESS_RESOLVE_DEST);
+        add(ResourceStates::ResolveSource, D3D12_BARRIER_SYNC_RESOLVE, D3D12_BARRIER_ACCESS_RESOLVE_SOURCE);
+        add(ResourceStates::AccelStructRead, D3D12_BARRIER_SYNC_RAYTRACING | D3D12_BARRIER_SYNC_ALL_SHADING, D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ);
+        add(ResourceStates::AccelStructWrite, D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE | D3D12_BARRIER_SYNC_COPY_RAYTRACING_ACCELERATION_STRUCTURE, D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE);
+        add(ResourceStates::AccelStructBuildInput, D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE, D3D12_BARRIER_ACCESS_SHADER_RESOURCE);
+        add(ResourceStates::AccelStructBuildBlas, D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE, D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ);
+        add(ResourceStates::ShadingRateSurface, D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADING_RATE_SOURCE);
+        add(ResourceStates::OpacityMicromapWrite, D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE, D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE);
+        add(ResourceStates::OpacityMicromapBuildInput, D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE, D3D12_BARRIER_ACCESS_SHADER_RESOURCE);
+        add(ResourceStates::ConvertCoopVecMatrixInput, D3D12_BARRIER_SYNC_ALL, D3D12_BARRIER_ACCESS_SHADER_RESOURCE);
+        add(ResourceStates::ConvertCoopVecMatrixOutput, D3D12_BARRIER_SYNC_ALL, D3D12_BARRIER_ACCESS_UNORDERED_ACCESS);
+        add(ResourceStates::Predication, D3D12_BARRIER_SYNC_PREDICATION, D3D12_BARRIER_ACCESS_PREDICATION);
+
+        result.sync = sync;
+        result.access = access;
+
+        if (!isTexture)
+            return result;
+
+        // Pick the layout that supports all requested accesses. Writable layouts are exclusive,
+        // combinations of read-only states use the generic read layout.
+        if ((stateBits & ResourceStates::UnorderedAccess) != 0)
+            result.layout = D3D12_BARRIER_LAYOUT_UNORDERED_ACCESS;
+        else if ((stateBits & ResourceStates::RenderTarget) != 0)
+            result.layout = D3D12_BARRIER_LAYOUT_RENDER_TARGET;
+        else if ((stateBits & ResourceStates::DepthWrite) != 0)
+            result.layout = D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE;
+        else if ((stateBits & ResourceStates::CopyDest) != 0)
+            result.layout = D3D12_BARRIER_LAYOUT_COPY_DEST;
+        else if ((stateBits & ResourceStates::ResolveDest) != 0)
+            result.layout = D3D12_BARRIER_LAYOUT_RESOLVE_DEST;
+        else if ((stateBits & ResourceStates::ShadingRateSurface) != 0)
+            result.layout = D3D12_BARRIER_LAYOUT_SHADING_RATE_SOURCE;
+        else if ((stateBits & ResourceStates::DepthRead) != 0)
+            result.layout = D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ;
+        else if (stateBits == ResourceStates::ShaderResource)
+            result.layout = D3D12_BARRIER_LAYOUT_SHADER_RESOURCE;
+        else if (stateBits == ResourceStates::CopySource)
+            result.layout = D3D12_BARRIER_LAYOUT_COPY_SOURCE;
+        else if (stateBits == ResourceStates::ResolveSource)
+            result.layout = D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE;
+        else
+            result.layout = D3D12_BARRIER_LAYOUT_GENERIC_READ;
 
         return result;
     }
@@ -22,12 +22,86 @@
 
 #include "d3d12-backend.h"
 
+#include <algorithm>
+#include <memory>
+
 namespace nvrhi::d3d12
 {
+    // Shared by a heap and the thread caches that hold its descriptors, so that either of them can go away first
+    struct DescriptorHeapCacheLink
+    {
+        std::mutex mutex;
+        StaticDescriptorHeap* heap = nullptr; // null once the heap is destroyed
+    };
+
+    // Single descriptor allocations, which are used for all texture and buffer views, are served from small
+    // ranges reserved by each thread, so that the threads creating resources don't contend on the heap mutex.
+    struct ThreadDescriptorCache
+    {
+        // The weak reference keeps the link's memory from being reused by a new heap while the entry exists
+        std::weak_ptr<DescriptorHeapCacheLink> link;
+        const DescriptorHeapCacheLink* linkKey = nullptr;
+        DescriptorIndex nextDescriptor = 0;
+        uint32_t numDescriptors = 0;
+    };
+
+    // Returns the unused cached descriptors to their heaps when the thread exits
+    struct ThreadDescriptorCaches
+    {
+        std::vector<ThreadDescriptorCache> caches;
+
+        ~ThreadDescriptorCaches()
+        {
+            for (const ThreadDescriptorCache& cache : caches)
+            {
+                if (cache.numDescriptors == 0)
+                    continue;
+
+                if (std::shared_ptr<DescriptorHeapCacheLink> link = cache.link.lock())
+                {
+                    std::lock_guard lockGuard(link->mutex);
+                    if (link->heap)
+                        link->heap->releaseDescriptors(cache.nextDescriptor, cache.numDescriptors);
+                }
+            }
+        }
+    };
+
+    static constexpr uint32_t c_ThreadCacheDescriptors = 16;
+    static thread_local ThreadDescriptorCaches t_DescriptorCaches;
+
+    static ThreadDescriptorCache& getThreadDescriptorCache(const std::shared_ptr<DescriptorHeapCacheLink>& link)
+    {
+        std::vector<ThreadDescriptorCache>& caches = t_DescriptorCaches.caches;
+
+        // Drop the entries of destroyed heaps, their descriptors are gone with the heap
+        caches.erase(std::remove_if(caches.begin(), caches.end(),
+            [](const ThreadDescriptorCache& cache) { return cache.link.expired(); }), caches.end());
+
+        for (ThreadDescriptorCache& cache : caches)
+        {
+            if (cache.linkKey == link.get())
+                return cache;
+        }
+
+        ThreadDescriptorCache& cache = caches.emplace_back();
+        cache.link = link;
+        cache.linkKey = link.get();
+        return cache;
+    }
     
     StaticDescriptorHeap::StaticDescriptorHeap(const Context& context)
         : m_Context(context)
+        , m_CacheLink(std::make_shared<DescriptorHeapCacheLink>())
+    {
+        m_CacheLink->heap = this;
+    }
+
+    StaticDescriptorHeap::~StaticDescriptorHeap()
     {
+        // Threads that exit from now on keep their cached descriptors instead of releasing them into this heap
+        std::lock_guard lockGuard(m_CacheLink->mutex);
+        m_CacheLink->heap = nullptr;
     }
     
     HRESULT StaticDescriptorHeap::allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors, bool shaderVisible)
@@ -58,11 +132,19 @@ namespace nvrhi::d3d12
             m_StartGpuHandleShaderVisible = m_ShaderVisibleHeap->GetGPUDescriptorHandleForHeapStart();
         }
 
+        uint32_t const oldNumDescriptors = m_NumDescriptors;
+
         m_NumDescriptors = heapDesc.NumDescriptors;
         m_HeapType = heapDesc.Type;
         m_StartCpuHandle = m_Heap->GetCPUDescriptorHandleForHeapStart();
         m_Stride = m_Context.device->GetDescriptorHandleIncrementSize(heapDesc.Type);
-        m_AllocatedDescriptors.resize(m_NumDescriptors);
+
+        m_TrackedMemory.set(m_Context.memoryCounters, MemoryCategory::DescriptorHeaps,
+            uint64_t(m_NumDescriptors) * m_Stride * (shaderVisible ? 2 : 1));
+
+        // The new part of the heap is free, merged with the free range at the end of the old heap if there is one
+        if (m_NumDescriptors > oldNumDescriptors)
+            addFreeRange(oldNumDescriptors, m_NumDescriptors - oldNumDescriptors);
 
         return S_OK;
     }
@@ -91,6 +173,10 @@ namespace nvrhi::d3d12
 
         if (isShaderVisible)
         {
+            // Every growth of a shader-visible heap recreates and refills it, so grow these heaps 4x at a time
+            // to copy them half as often as the CPU-only heaps.
+            newSize = std::max(newSize, nextPowerOf2(oldSize) * 4);
+
             uint32_t const maxSize = (m_HeapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
                 ? D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_1 // Not a power of 2!
                 : D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE;
@@ -118,56 +204,109 @@ namespace nvrhi::d3d12
         return S_OK;
     }
 
-    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    std::map<DescriptorIndex, uint32_t>::iterator StaticDescriptorHeap::removeFreeRange(std::map<DescriptorIndex, uint32_t>::iterator range)
     {
-        std::lock_guard lockGuard(m_Mutex);
-
-        DescriptorIndex foundIndex = 0;
-        uint32_t freeCount = 0;
-        bool found = false;
+        m_FreeRangesBySize.erase(std::make_pair(range->second, range->first));
+        return m_FreeRanges.erase(range);
+    }
 
-        // Find a contiguous range of 'count' indices for which m_AllocatedDescriptors[index] is false
+    void StaticDescriptorHeap::addFreeRange(DescriptorIndex baseIndex, uint32_t count)
+    {
+        auto next = m_FreeRanges.lower_bound(baseIndex);
 
-        for (DescriptorIndex index = m_SearchStart; index < m_NumDescriptors; index++)
+        if (next != m_FreeRanges.end() && next->first == baseIndex + count)
         {
-            if (m_AllocatedDescriptors[index])
-                freeCount = 0;
-            else
-                freeCount += 1;
+            count += next->second;
+            next = removeFreeRange(next);
+        }
 
-            if (freeCount >= count)
+        if (next != m_FreeRanges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == baseIndex)
             {
-                foundIndex = index - count + 1;
-                found = true;
-                break;
+                baseIndex = prev->first;
+                count += prev->second;
+                removeFreeRange(prev);
             }
         }
 
-        if (!found)
+        m_FreeRanges.emplace(baseIndex, count);
+        m_FreeRangesBySize.emplace(count, baseIndex);
+    }
+
+    DescriptorIndex StaticDescriptorHeap::allocateRange(uint32_t count)
+    {
+        // Find the smallest free range that fits 'count' descriptors
+        auto found = m_FreeRangesBySize.lower_bound(std::make_pair(count, DescriptorIndex(0)));
+
+        if (found == m_FreeRangesBySize.end())
         {
-            foundIndex = m_NumDescriptors;
+            // The free range at the end of the heap, if any, becomes a part of the allocation after growing
+            uint32_t trailingFreeCount = 0;
+            if (!m_FreeRanges.empty())
+            {
+                auto last = std::prev(m_FreeRanges.end());
+                if (last->first + last->second == m_NumDescriptors)
+                    trailingFreeCount = last->second;
+            }
 
-            if (FAILED(Grow(m_NumDescriptors + count)))
+            if (FAILED(Grow(m_NumDescriptors + count - trailingFreeCount)))
             {
                 m_Context.error("Failed to grow a descriptor heap!");
                 return c_InvalidDescriptorIndex;
             }
+
+            found = m_FreeRangesBySize.lower_bound(std::make_pair(count, DescriptorIndex(0)));
+            assert(found != m_FreeRangesBySize.end());
         }
 
-        for (DescriptorIndex index = foundIndex; index < foundIndex + count; index++)
+        auto const [rangeSize, rangeBase] = *found;
+        m_FreeRangesBySize.erase(found);
+        m_FreeRanges.erase(rangeBase);
+
+        // The neighbors of the range are allocated, so the remainder doesn't need merging
+        if (rangeSize > count)
         {
-            m_AllocatedDescriptors[index] = true;
+            m_FreeRanges.emplace(rangeBase + count, rangeSize - count);
+            m_FreeRangesBySize.emplace(rangeSize - count, rangeBase + count);
         }
 
         m_NumAllocatedDescriptors += count;
+        return rangeBase;
+    }
+
+    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    {
+        if (count == 0)
+            return 0;
+
+        if (count == 1)
+            return allocateDescriptor();
+
+        std::lock_guard lockGuard(m_Mutex);
 
-        m_SearchStart = foundIndex + count;
-        return foundIndex;
+        return allocateRange(count);
     }
 
     DescriptorIndex StaticDescriptorHeap::allocateDescriptor()
     {
-        return allocateDescriptors(1);
+        ThreadDescriptorCache& cache = getThreadDescriptorCache(m_CacheLink);
+
+        if (cache.numDescriptors == 0)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            DescriptorIndex const baseIndex = allocateRange(c_ThreadCacheDescriptors);
+            if (baseIndex == c_InvalidDescriptorIndex)
+                return c_InvalidDescriptorIndex;
+
+            cache.nextDescriptor = baseIndex;
+            cache.numDescriptors = c_ThreadCacheDescriptors;
+        }
+
+        --cache.numDescriptors;
+        return cache.nextDescriptor++;
     }
 
     void StaticDescriptorHeap::releaseDescriptors(DescriptorIndex baseIndex, uint32_t count)
@@ -177,22 +316,20 @@ namespace nvrhi::d3d12
         if (count == 0)
             return;
 
-        for (DescriptorIndex index = baseIndex; index < baseIndex + count; index++)
-        {
 #ifdef _DEBUG
-            if (!m_AllocatedDescriptors[index])
-            {
-                m_Context.error("Attempted to release an un-allocated descriptor");
-            }
+        auto next = m_FreeRanges.lower_bound(baseIndex);
+        bool const overlapsNext = next != m_FreeRanges.end() && next->first < baseIndex + count;
+        bool const overlapsPrev = next != m_FreeRanges.begin() && std::prev(next)->first + std::prev(next)->second > baseIndex;
+        if (overlapsNext || overlapsPrev || baseIndex + count > m_NumDescriptors)
+        {
+            m_Context.error("Attempted to release an un-allocated descriptor");
+            return;
+        }
 #endif
 
-            m_AllocatedDescriptors[index] = false;
-        }
+        addFreeRange(baseIndex, count);
 
         m_NumAllocatedDescriptors -= count;
-
-        if (m_SearchStart > baseIndex)
-            m_SearchStart = baseIndex;
     }
 
     void StaticDescriptorHeap::releaseDescriptor(DescriptorIndex index)
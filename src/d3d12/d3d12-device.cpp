@@ -68,6 +68,9 @@ namespace nvrhi::d3d12
         , shaderResourceViewHeap(context)
         , samplerHeap(context)
         , timerQueries(desc.maxTimerQueries, true)
+#ifndef NVRHI_WITH_RTXMU
+        , compactedSizeQueries(c_MaxCompactedSizeQueries, true)
+#endif
         , m_Context(context)
     {
     }
@@ -91,6 +94,7 @@ namespace nvrhi::d3d12
 
     Device::Device(const DeviceDesc& desc)
         : m_Resources(m_Context, desc)
+        , m_PipelineCompilePool(desc.numPipelineCompileThreads)
     {
         m_Context.device = desc.pDevice;
         m_Context.logBufferLifetime = desc.logBufferLifetime;
@@ -103,6 +107,31 @@ namespace nvrhi::d3d12
         if (desc.pCopyCommandQueue)
             m_Queues[int(CommandQueue::Copy)] = std::make_unique<Queue>(m_Context, desc.pCopyCommandQueue);
 
+        if (desc.uploadRingSize > 0)
+        {
+            // The ring buffers are created when command lists first claim chunks from them
+            for (int queue = 0; queue < int(CommandQueue::Count); queue++)
+            {
+                if (m_Queues[queue])
+                    m_UploadRings[queue] = std::make_unique<UploadRing>(m_Context, m_Queues[queue].get(), desc.uploadRingSize, desc.uploadRingChunkSize);
+            }
+        }
+
+        if (desc.scratchPoolMaxMemory > 0)
+        {
+            // The scratch chunks are created when command lists first claim them
+            for (int queue = 0; queue < int(CommandQueue::Count); queue++)
+            {
+                if (m_Queues[queue])
+                    m_ScratchPools[queue] = std::make_unique<ScratchPool>(m_Context, m_Queues[queue].get(), desc.scratchPoolMaxMemory, desc.scratchPoolChunkSize);
+            }
+        }
+
+        // The adapter is only used for memory budget queries, so failing to find it is not an error
+        RefCountPtr<IDXGIFactory4> dxgiFactory;
+        if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&dxgiFactory))))
+            dxgiFactory->EnumAdapterByLuid(m_Context.device->GetAdapterLuid(), IID_PPV_ARGS(&m_DxgiAdapter));
+
         m_Resources.depthStencilViewHeap.allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, desc.depthStencilViewHeapSize, false);
         m_Resources.renderTargetViewHeap.allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, desc.renderTargetViewHeapSize, false);
         m_Resources.shaderResourceViewHeap.allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, desc.shaderResourceViewHeapSize, true);
@@ -130,6 +159,12 @@ namespace nvrhi::d3d12
                 // Initialize suballocator blocks to 8 MB
                 m_Context.rtxMemUtil->Initialize(8388608);
             }
+#else
+            if (m_RayTracingSupported)
+            {
+                m_Resources.compactedStorage = std::make_unique<AccelStructStoragePool>(this,
+                    c_CompactedAccelStructChunkSize, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+            }
 #endif
         }
 
@@ -138,6 +173,19 @@ namespace nvrhi::d3d12
             m_MeshletsSupported = m_Options7.MeshShaderTier >= D3D12_MESH_SHADER_TIER_1;
         }
 
+        if (SUCCEEDED(m_Context.device->QueryInterface(&m_Context.device3)))
+        {
+            D3D12_FEATURE_DATA_EXISTING_HEAPS existingHeaps = {};
+            m_HostMemoryImportSupported = SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_EXISTING_HEAPS, &existingHeaps, sizeof(existingHeaps)))
+                && existingHeaps.Supported;
+        }
+
+        // AddToStateObject requires DXR 1.1
+        if (m_TraceRayInlineSupported && SUCCEEDED(m_Context.device->QueryInterface(&m_Context.device7)))
+        {
+            m_RayTracingPipelineLibrariesSupported = true;
+        }
+
         if (SUCCEEDED(m_Context.device->QueryInterface(&m_Context.device8)) && hasOptions7)
         {
             m_SamplerFeedbackSupported = m_Options7.SamplerFeedbackTier >= D3D12_SAMPLER_FEEDBACK_TIER_0_9;
@@ -156,10 +204,33 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        if (desc.enableEnhancedBarriers)
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS12 options12 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS12, &options12, sizeof(options12))))
+                m_Context.enhancedBarriers = options12.EnhancedBarriersSupported;
+        }
+
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS16 options16 = {};
+            if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS16, &options16, sizeof(options16))))
+                m_Context.dynamicDepthBias = options16.DynamicDepthBiasSupported;
+        }
+
         if (hasOptions6)
         {
             m_VariableRateShadingSupported = m_Options6.VariableShadingRateTier >= D3D12_VARIABLE_SHADING_RATE_TIER_2;
         }
+
+        m_PipelineLibrary = std::make_unique<PipelineLibrary>(m_Context, desc.pipelineCacheData, desc.pipelineCacheDataSize);
+        if (!m_PipelineLibrary->isValid())
+            m_PipelineLibrary.reset();
+
+        if (desc.enableShaderCache)
+            m_ShaderCache = std::make_unique<ShaderCache>();
+
+        if (desc.enableStateObjectInterning)
+            m_InternedStates = std::make_unique<StateObjectTables>();
         
         {
             D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
@@ -178,6 +249,13 @@ namespace nvrhi::d3d12
             csDesc.ByteStride = 12;
             argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
             m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchIndirectSignature));
+
+            if (m_MeshletsSupported)
+            {
+                csDesc.ByteStride = 12;
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+                m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchMeshIndirectSignature));
+            }
         }
         
         m_FenceEvent = CreateEvent(nullptr, false, false, nullptr);
@@ -298,6 +376,7 @@ namespace nvrhi::d3d12
                 m_AftermathEnabled = true;
             }
         }
+        m_AftermathCrashDumpHelper.setCompactMarkers(desc.aftermathCompactMarkers);
 #endif
 
         if (desc.enableHeapDirectlyIndexed)
@@ -312,8 +391,19 @@ namespace nvrhi::d3d12
 
     Device::~Device()
     {
+        m_BackgroundGarbageCollector.stop();
+        m_PipelineCompilePool.shutdown();
+
         waitForIdle();
 
+#ifndef NVRHI_WITH_RTXMU
+        // Release the compaction resources while the rest of the device is still alive
+        m_Resources.compactionsReady.clear();
+        m_Resources.compactedStorage.reset();
+        m_Resources.compactedSizeBuffer = nullptr;
+        m_Resources.compactedSizeReadbackBuffer = nullptr;
+#endif
+
         if (m_FenceEvent)
         {
             CloseHandle(m_FenceEvent);
@@ -392,8 +482,19 @@ namespace nvrhi::d3d12
     
     SamplerHandle Device::createSampler(const SamplerDesc& d)
     {
+        if (m_InternedStates)
+        {
+            if (SamplerHandle existing = m_InternedStates->samplers.find(d))
+                return existing;
+        }
+
         Sampler* sampler = new Sampler(m_Context, d);
-        return SamplerHandle::Create(sampler);
+        SamplerHandle samplerHandle = SamplerHandle::Create(sampler);
+
+        if (m_InternedStates)
+            return m_InternedStates->samplers.insert(d, sampler, sampler->internEntry);
+
+        return samplerHandle;
     }
     
     GraphicsAPI Device::getGraphicsAPI()
@@ -425,12 +526,72 @@ namespace nvrhi::d3d12
         return CommandListHandle::Create(new CommandList(this, m_Context, m_Resources, params));
     }
     
-    uint64_t Device::executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    void Device::resolveDeferredInitialStates(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, size_t& fixupsUsed)
     {
-        m_CommandListsToExecute.resize(numCommandLists);
+        m_ResolvedCommandLists.clear();
+
+        bool anyDeferred = false;
         for (size_t i = 0; i < numCommandLists; i++)
         {
-            m_CommandListsToExecute[i] = checked_cast<CommandList*>(pCommandLists[i])->getD3D12CommandList();
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            m_ResolvedCommandLists.push_back(commandList);
+            anyDeferred = anyDeferred || commandList->getStateTracker().hasDeferredInitialStates();
+        }
+
+        if (!anyDeferred)
+            return;
+
+        auto& fixupPool = m_StateFixupCommandLists[uint32_t(executionQueue)];
+
+        m_ResolvedCommandLists.clear();
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            CommandListResourceStateTracker& stateTracker = commandList->getStateTracker();
+
+            m_StateFixups.clear();
+            if (stateTracker.resolveDeferredInitialStates(m_StateFixups))
+            {
+                if (fixupsUsed == fixupPool.size())
+                {
+                    fixupPool.push_back(createCommandList(CommandListParameters()
+                        .setQueueType(executionQueue)
+                        .setEnableImmediateExecution(false)));
+                }
+
+                CommandList* fixupList = checked_cast<CommandList*>(fixupPool[fixupsUsed].Get());
+                ++fixupsUsed;
+
+                fixupList->open();
+                fixupList->recordStateFixups(m_StateFixups);
+                fixupList->close();
+
+                m_ResolvedCommandLists.push_back(fixupList);
+            }
+
+            // The following command lists in this submission observe the final states of this one
+            stateTracker.publishSubmittedStates();
+
+            m_ResolvedCommandLists.push_back(commandList);
+        }
+    }
+    
+    uint64_t Device::executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::ExecuteCommandLists);
+
+        size_t fixupsUsed = 0;
+        resolveDeferredInitialStates(pCommandLists, numCommandLists, executionQueue, fixupsUsed);
+
+        return submitResolvedCommandLists(executionQueue);
+    }
+
+    uint64_t Device::submitResolvedCommandLists(CommandQueue executionQueue)
+    {
+        m_CommandListsToExecute.resize(m_ResolvedCommandLists.size());
+        for (size_t i = 0; i < m_ResolvedCommandLists.size(); i++)
+        {
+            m_CommandListsToExecute[i] = m_ResolvedCommandLists[i]->getD3D12CommandList();
         }
 
         Queue* pQueue = getQueue(executionQueue);
@@ -439,10 +600,20 @@ namespace nvrhi::d3d12
         pQueue->lastSubmittedInstance++;
         pQueue->queue->Signal(pQueue->fence, pQueue->lastSubmittedInstance);
 
-        for (size_t i = 0; i < numCommandLists; i++)
+        for (CommandList* commandList : m_ResolvedCommandLists)
         {
-            auto instance = checked_cast<CommandList*>(pCommandLists[i])->executed(pQueue);
-            pQueue->commandListsInFlight.push_front(instance);
+            auto instance = commandList->executed(pQueue);
+            {
+                std::lock_guard lockGuard(pQueue->inFlightMutex);
+                pQueue->commandListsInFlight.push_front(instance);
+            }
+
+            if (commandList->getDesc().enableBarrierStatistics)
+                m_BarrierStatistics[int(executionQueue)] += commandList->getStateTracker().getStatistics();
+
+#if NVRHI_WITH_COMMAND_LIST_STATISTICS
+            m_CommandListStatistics[int(executionQueue)] += commandList->getStatistics();
+#endif
         }
 
         HRESULT hr = m_Context.device->GetDeviceRemovedReason();
@@ -463,6 +634,46 @@ namespace nvrhi::d3d12
         pWaitQueue->queue->Wait(pExecutionQueue->fence, instanceID);
     }
 
+    void Device::executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::ExecuteCommandLists);
+
+        buildSubmitBatches(graph, m_SubmitBatches, m_SubmitNodeBatches);
+        m_SubmitBatchInstances.resize(m_SubmitBatches.size());
+
+        std::array<size_t, size_t(CommandQueue::Count)> fixupsUsed {};
+
+        // The batches are ordered so that every batch is submitted after the batches it depends on,
+        // and each one maps to one ExecuteCommandLists call preceded by the fence waits
+        for (size_t batchIndex = 0; batchIndex < m_SubmitBatches.size(); batchIndex++)
+        {
+            const SubmitBatch& batch = m_SubmitBatches[batchIndex];
+            Queue* pQueue = getQueue(batch.queue);
+
+            for (uint32_t dependency : batch.batchDependencies)
+            {
+                pQueue->queue->Wait(getQueue(m_SubmitBatches[dependency].queue)->fence, m_SubmitBatchInstances[dependency]);
+            }
+
+            for (const TimelinePoint& wait : batch.waits)
+            {
+                Queue* pExecutionQueue = getQueue(wait.queue);
+                assert(wait.instance <= pExecutionQueue->lastSubmittedInstance);
+
+                pQueue->queue->Wait(pExecutionQueue->fence, wait.instance);
+            }
+
+            resolveDeferredInitialStates(batch.commandLists.data(), batch.commandLists.size(), batch.queue, fixupsUsed[size_t(batch.queue)]);
+            m_SubmitBatchInstances[batchIndex] = submitResolvedCommandLists(batch.queue);
+        }
+
+        if (pInstances)
+        {
+            for (size_t nodeIndex = 0; nodeIndex < m_SubmitNodeBatches.size(); nodeIndex++)
+                pInstances[nodeIndex] = m_SubmitBatchInstances[m_SubmitNodeBatches[nodeIndex]];
+        }
+    }
+
     void Device::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* _subresourceTilings)
     {
         ID3D12Resource* resource = checked_cast<Texture*>(texture)->resource;
@@ -497,10 +708,40 @@ namespace nvrhi::d3d12
         }
     }
 
-    void Device::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    void Device::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        TextureTilesMappingUpdate update;
+        update.texture = texture;
+        update.tileMappings = tileMappings;
+        update.numTileMappings = numTileMappings;
+
+        updateTextureTileMappingsBatch(&update, 1, executionQueue);
+    }
+
+    void Device::updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue)
     {
         Queue* queue = getQueue(executionQueue);
-        Texture* texture = checked_cast<Texture*>(_texture);
+
+        // Reused between the calls to avoid reallocating them for every texture in the batch
+        std::vector<D3D12_TILED_RESOURCE_COORDINATE> resourceCoordinates;
+        std::vector<D3D12_TILE_REGION_SIZE> regionSizes;
+        std::vector<D3D12_TILE_RANGE_FLAGS> rangeFlags;
+        std::vector<UINT> heapStartOffsets;
+        std::vector<UINT> rangeTileCounts;
+
+        for (uint32_t updateIndex = 0; updateIndex < numUpdates; updateIndex++)
+        {
+            updateTileMappingsForTexture(queue, updates[updateIndex], resourceCoordinates, regionSizes, rangeFlags, heapStartOffsets, rangeTileCounts);
+        }
+    }
+
+    void Device::updateTileMappingsForTexture(Queue* queue, const TextureTilesMappingUpdate& update,
+        std::vector<D3D12_TILED_RESOURCE_COORDINATE>& resourceCoordinates, std::vector<D3D12_TILE_REGION_SIZE>& regionSizes,
+        std::vector<D3D12_TILE_RANGE_FLAGS>& rangeFlags, std::vector<UINT>& heapStartOffsets, std::vector<UINT>& rangeTileCounts)
+    {
+        Texture* texture = checked_cast<Texture*>(update.texture);
+        const TextureTilesMapping* tileMappings = update.tileMappings;
+        const uint32_t numTileMappings = update.numTileMappings;
 
         D3D12_TILE_SHAPE tileShape;
         D3D12_SUBRESOURCE_TILING subresourceTiling;
@@ -511,11 +752,11 @@ namespace nvrhi::d3d12
             ID3D12Heap* heap = tileMappings[i].heap ? checked_cast<Heap*>(tileMappings[i].heap)->heap : nullptr;
 
             uint32_t numRegions = tileMappings[i].numTextureRegions;
-            std::vector<D3D12_TILED_RESOURCE_COORDINATE> resourceCoordinates(numRegions);
-            std::vector<D3D12_TILE_REGION_SIZE> regionSizes(numRegions);
-            std::vector<D3D12_TILE_RANGE_FLAGS> rangeFlags(numRegions, heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL);
-            std::vector<UINT> heapStartOffsets(numRegions);
-            std::vector<UINT> rangeTileCounts(numRegions);
+            resourceCoordinates.resize(numRegions);
+            regionSizes.resize(numRegions);
+            rangeFlags.assign(numRegions, heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL);
+            heapStartOffsets.resize(numRegions);
+            rangeTileCounts.resize(numRegions);
 
             for (uint32_t j = 0; j < numRegions; ++j)
             {
@@ -559,43 +800,136 @@ namespace nvrhi::d3d12
 
     void Device::runGarbageCollection()
     {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::GarbageCollection);
+
         for (const auto& pQueue : m_Queues)
         {
-            if (!pQueue)
-                continue;
+            if (pQueue)
+                retireCommandListInstances(pQueue.get(), pQueue->updateLastCompletedInstance(), nullptr);
+        }
+
+        if (m_ShaderCache)
+            m_ShaderCache->prune();
 
-            pQueue->updateLastCompletedInstance();
+        // Notifies the message callback if the memory budget is exceeded
+        (void)getMemoryStatistics();
+    }
+
+    bool Device::runIncrementalGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::GarbageCollection);
 
-            // Starting from the back of the queue, i.e. oldest submitted command lists,
-            // see if those command lists have finished executing.
-            while (!pQueue->commandListsInFlight.empty())
+        GarbageCollectionBudgetTracker tracker(budget);
+
+        for (const auto& pQueue : m_Queues)
+        {
+            if (pQueue && !retireCommandListInstances(pQueue.get(), pQueue->updateLastCompletedInstance(), &tracker))
+                return false;
+        }
+
+        return true;
+    }
+
+    void Device::setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds)
+    {
+        if (!enable)
+        {
+            m_BackgroundGarbageCollector.stop();
+            return;
+        }
+
+        m_BackgroundGarbageCollector.start([this]()
+        {
+            InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::GarbageCollection);
+
+            for (const auto& pQueue : m_Queues)
             {
-                std::shared_ptr<CommandListInstance> instance = pQueue->commandListsInFlight.back();
-                
-                if (pQueue->lastCompletedInstance >= instance->submittedInstance)
-                {
+                // Queue::lastCompletedInstance belongs to the render thread, read the fence directly
+                if (pQueue)
+                    retireCommandListInstances(pQueue.get(), pQueue->fence->GetCompletedValue(), nullptr);
+            }
+        }, intervalMilliseconds);
+    }
+
+    bool Device::retireCommandListInstances(Queue* pQueue, uint64_t completedInstance, GarbageCollectionBudgetTracker* budget)
+    {
+        // Starting from the back of the queue, i.e. oldest submitted command lists,
+        // see if those command lists have finished executing.
+        while (true)
+        {
+            std::shared_ptr<CommandListInstance> instance;
+
+            {
+                std::lock_guard lockGuard(pQueue->inFlightMutex);
+
+                if (pQueue->commandListsInFlight.empty() || pQueue->commandListsInFlight.back()->submittedInstance > completedInstance)
+                    return true;
+
+                instance = std::move(pQueue->commandListsInFlight.back());
+                pQueue->commandListsInFlight.pop_back();
+            }
+
 #ifdef NVRHI_WITH_RTXMU
-                    if (!instance->rtxmuBuildIds.empty())
-                    {
-                        std::lock_guard lockGuard(m_Resources.asListMutex);
+            if (!instance->rtxmuBuildIds.empty())
+            {
+                std::lock_guard lockGuard(m_Resources.asListMutex);
 
-                        m_Resources.asBuildsCompleted.insert(m_Resources.asBuildsCompleted.end(),
-                            instance->rtxmuBuildIds.begin(), instance->rtxmuBuildIds.end());
+                m_Resources.asBuildsCompleted.insert(m_Resources.asBuildsCompleted.end(),
+                    instance->rtxmuBuildIds.begin(), instance->rtxmuBuildIds.end());
 
-                        instance->rtxmuBuildIds.clear();
-                    }
-                    if (!instance->rtxmuCompactionIds.empty())
+                instance->rtxmuBuildIds.clear();
+            }
+            if (!instance->rtxmuCompactionIds.empty())
+            {
+                m_Context.rtxMemUtil->GarbageCollection(instance->rtxmuCompactionIds);
+                instance->rtxmuCompactionIds.clear();
+            }
+#else
+            if (!instance->compactedSizeQueries.empty())
+            {
+                Buffer* readbackBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeReadbackBuffer.Get());
+
+                const uint64_t* compactedSizes = nullptr;
+                D3D12_RANGE readRange = { 0, SIZE_T(readbackBuffer->desc.byteSize) };
+                const HRESULT res = readbackBuffer->resource->Map(0, &readRange, (void**)&compactedSizes);
+
+                std::lock_guard lockGuard(m_Resources.compactionMutex);
+
+                for (const auto& query : instance->compactedSizeQueries)
+                {
+                    if (SUCCEEDED(res))
                     {
-                        m_Context.rtxMemUtil->GarbageCollection(instance->rtxmuCompactionIds);
-                        instance->rtxmuCompactionIds.clear();
+                        checked_cast<AccelStruct*>(query.accelStruct.Get())->compactedSize = compactedSizes[query.index];
+                        m_Resources.compactionsReady.push_back(query.accelStruct);
                     }
-#endif
-                    pQueue->commandListsInFlight.pop_back();
+
+                    m_Resources.compactedSizeQueries.release(query.index);
                 }
-                else
+
+                if (SUCCEEDED(res))
                 {
-                    break;
+                    D3D12_RANGE writtenRange = { 0, 0 };
+                    readbackBuffer->resource->Unmap(0, &writtenRange);
                 }
+
+                instance->compactedSizeQueries.clear();
+            }
+#endif
+
+            if (budget)
+            {
+                budget->objectsReleased(instance->referencedResources.size() + instance->referencedNativeResources.size()
+                    + instance->referencedStagingTextures.size() + instance->referencedStagingBuffers.size()
+                    + instance->referencedTimerQueries.size() + instance->transientBindingSets.size());
+            }
+
+            // Releases the referenced objects outside of the lock
+            instance.reset();
+
+            if (budget && budget->isExhausted())
+            {
+                std::lock_guard lockGuard(pQueue->inFlightMutex);
+                return pQueue->commandListsInFlight.empty() || pQueue->commandListsInFlight.back()->submittedInstance > completedInstance;
             }
         }
     }
@@ -606,12 +940,35 @@ namespace nvrhi::d3d12
         {
         case Feature::DeferredCommandLists:
             return true;
+        case Feature::IndirectCommandLayouts:
+            return true;
+        case Feature::PipelineStatisticsQueries:
+            return true;
+        case Feature::Predication:
+            return true;
+        case Feature::ExtendedDynamicState:
+            // The primitive topology and viewports are command list state on DX12
+            if (pInfo)
+            {
+                if (infoSize == sizeof(DynamicRenderStateFeatureInfo))
+                {
+                    auto* pDynamicStateInfo = reinterpret_cast<DynamicRenderStateFeatureInfo*>(pInfo);
+                    pDynamicStateInfo->supportedStates = DynamicRenderState::PrimitiveTopology | DynamicRenderState::ViewportCount;
+                    if (m_Context.dynamicDepthBias)
+                        pDynamicStateInfo->supportedStates = pDynamicStateInfo->supportedStates | DynamicRenderState::DepthBias;
+                }
+                else
+                    utils::NotSupported();
+            }
+            return true;
         case Feature::SinglePassStereo:
             return m_SinglePassStereoSupported;
         case Feature::RayTracingAccelStruct:
             return m_RayTracingSupported;
         case Feature::RayTracingPipeline:
             return m_RayTracingSupported;
+        case Feature::RayTracingPipelineLibraries:
+            return m_RayTracingPipelineLibrariesSupported;
         case Feature::RayTracingOpacityMicromap:
             return m_OpacityMicromapSupported;
         case Feature::RayTracingClusters:
@@ -671,6 +1028,20 @@ namespace nvrhi::d3d12
                     utils::NotSupported();
             }
             return true;
+        case Feature::HostMemoryImport:
+            if (!m_HostMemoryImportSupported)
+                return false;
+            if (pInfo)
+            {
+                if (infoSize == sizeof(HostMemoryImportFeatureInfo))
+                {
+                    auto* pHostMemoryInfo = reinterpret_cast<HostMemoryImportFeatureInfo*>(pInfo);
+                    pHostMemoryInfo->minPointerAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+                }
+                else
+                    utils::NotSupported();
+            }
+            return true;
         case Feature::CooperativeVectorInferencing:
             return m_CoopVecInferencingSupported;
         case Feature::CooperativeVectorTraining:
@@ -795,6 +1166,69 @@ namespace nvrhi::d3d12
         return result;
     }
 
+    bool Device::getPipelineCacheData(void* data, size_t* dataSize)
+    {
+        if (!m_PipelineLibrary || !dataSize)
+            return false;
+
+        return m_PipelineLibrary->serialize(data, dataSize);
+    }
+
+    UploadRingStatistics Device::getUploadRingStatistics(CommandQueue queue)
+    {
+        UploadRing* ring = getUploadRing(queue);
+        if (!ring)
+            return UploadRingStatistics();
+
+        return ring->getStatistics();
+    }
+
+    BarrierStatistics Device::getBarrierStatistics(CommandQueue queue)
+    {
+        return m_BarrierStatistics[int(queue)];
+    }
+
+    void Device::resetBarrierStatistics()
+    {
+        m_BarrierStatistics.fill(BarrierStatistics());
+    }
+
+    CommandListStatistics Device::getCommandListStatistics(CommandQueue queue)
+    {
+        return m_CommandListStatistics[int(queue)];
+    }
+
+    void Device::resetCommandListStatistics()
+    {
+        m_CommandListStatistics.fill(CommandListStatistics());
+    }
+
+    MemoryStatistics Device::getMemoryStatistics()
+    {
+        MemoryStatistics statistics;
+        m_Context.memoryCounters.fillStatistics(statistics);
+
+        if (m_DxgiAdapter)
+        {
+            for (DXGI_MEMORY_SEGMENT_GROUP segmentGroup : { DXGI_MEMORY_SEGMENT_GROUP_LOCAL, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL })
+            {
+                DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+                if (FAILED(m_DxgiAdapter->QueryVideoMemoryInfo(0, segmentGroup, &memoryInfo)))
+                    break;
+
+                MemoryHeapStatistics heap;
+                heap.budget = memoryInfo.Budget;
+                heap.usage = memoryInfo.CurrentUsage;
+                heap.isDeviceLocal = segmentGroup == DXGI_MEMORY_SEGMENT_GROUP_LOCAL;
+                statistics.heaps.push_back(heap);
+            }
+        }
+
+        m_MemoryBudgetMonitor.update(statistics, m_Context.messageCallback);
+
+        return statistics;
+    }
+
     size_t Device::getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns)
     {
 #if NVRHI_D3D12_WITH_COOPVEC
@@ -819,9 +1253,6 @@ namespace nvrhi::d3d12
 
     Object Device::getNativeQueue(ObjectType objectType, CommandQueue queue)
     {
-        if (objectType != ObjectTypes::D3D12_CommandQueue)
-            return nullptr;
-
         if (queue >= CommandQueue::Count)
             return nullptr;
 
@@ -830,7 +1261,15 @@ namespace nvrhi::d3d12
         if (!pQueue)
             return nullptr;
 
-        return Object(pQueue->queue.Get());
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_CommandQueue:
+            return Object(pQueue->queue.Get());
+        case ObjectTypes::D3D12_Fence:
+            return Object(pQueue->fence.Get());
+        default:
+            return nullptr;
+        }
     }
 
     IDescriptorHeap* Device::getDescriptorHeap(DescriptorHeapType heapType)
@@ -903,6 +1342,7 @@ namespace nvrhi::d3d12
         Heap* heap = new Heap();
         heap->heap = d3dHeap;
         heap->desc = d;
+        heap->trackedMemory.set(m_Context.memoryCounters, heap);
         return HeapHandle::Create(heap);
     }
 
@@ -23,7 +23,9 @@
 #include "d3d12-backend.h"
 
 #include <nvrhi/common/misc.h>
+#include <iomanip>
 #include <sstream>
+#include <unordered_set>
 
 namespace nvrhi::d3d12
 {
@@ -41,7 +43,7 @@ namespace nvrhi::d3d12
         }
     }
     
-    RefCountPtr<ID3D12PipelineState> Device::createPipelineState(const GraphicsPipelineDesc & state, RootSignature* pRS, const FramebufferInfo& fbinfo) const
+    RefCountPtr<ID3D12PipelineState> Device::createPipelineState(const GraphicsPipelineDesc & state, RootSignature* pRS, const FramebufferInfo& fbinfo, PipelineCacheResult& cacheResult) const
     {
         if (state.renderState.singlePassStereo.enabled && !m_SinglePassStereoSupported)
         {
@@ -128,6 +130,9 @@ namespace nvrhi::d3d12
         desc.NumRenderTargets = uint32_t(fbinfo.colorFormats.size());
         desc.SampleMask = ~0u;
 
+        if ((state.dynamicRenderState & DynamicRenderState::DepthBias) != 0 && m_Context.dynamicDepthBias)
+            desc.Flags |= D3D12_PIPELINE_STATE_FLAG_DYNAMIC_DEPTH_BIAS;
+
         RefCountPtr<ID3D12PipelineState> pipelineState;
 
 #if NVRHI_D3D12_WITH_NVAPI
@@ -169,6 +174,19 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        uint64_t libraryKey = 0;
+        if (m_PipelineLibrary)
+        {
+            libraryKey = getPipelineLibraryKey(desc, pRS);
+            pipelineState = m_PipelineLibrary->loadGraphicsPipeline(libraryKey, desc);
+            if (pipelineState)
+            {
+                cacheResult = PipelineCacheResult::Hit;
+                return pipelineState;
+            }
+            cacheResult = PipelineCacheResult::Miss;
+        }
+
         const HRESULT hr = m_Context.device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
 
         if (FAILED(hr))
@@ -177,16 +195,25 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        if (m_PipelineLibrary)
+            m_PipelineLibrary->storePipeline(libraryKey, pipelineState);
+
         return pipelineState;
     }
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Graphics, desc);
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, desc.inputLayout != nullptr);
 
-        RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, fbinfo);
+        PipelineCacheResult cacheResult = PipelineCacheResult::Unknown;
+        RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, fbinfo, cacheResult);
+        creationScope.setCacheResult(cacheResult);
 
-        return createHandleForNativeGraphicsPipeline(pRS, pPSO, desc, fbinfo);
+        GraphicsPipelineHandle pipeline = createHandleForNativeGraphicsPipeline(pRS, pPSO, desc, fbinfo);
+        creationScope.setPipeline(pipeline);
+        return pipeline;
     }
     
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
@@ -276,6 +303,318 @@ namespace nvrhi::d3d12
         if (DSV != c_InvalidDescriptorIndex)
             m_Resources.depthStencilViewHeap.releaseDescriptor(DSV);
     }
+
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (desc.draws.empty())
+        {
+            m_Context.error("Cannot create a command bundle without draws");
+            return nullptr;
+        }
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            if (!draw.state.pipeline || !draw.state.framebuffer)
+            {
+                std::stringstream ss;
+                ss << "Cannot create command bundle " << utils::DebugNameToString(desc.debugName)
+                    << " because one of its draws has no pipeline or framebuffer";
+                m_Context.error(ss.str());
+                return nullptr;
+            }
+
+            for (IBindingSet* _bindingSet : draw.state.bindings)
+            {
+                if (!_bindingSet || !_bindingSet->getDesc())
+                    continue;
+
+                BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+                for (const auto& parameter : bindingSet->rootParametersVolatileCB)
+                {
+                    if (parameter.second && checked_cast<Buffer*>(parameter.second)->desc.isVolatile)
+                    {
+                        std::stringstream ss;
+                        ss << "Cannot create command bundle " << utils::DebugNameToString(desc.debugName)
+                            << " because binding set " << utils::DebugNameToString(bindingSet->desc.debugName)
+                            << " uses volatile constant buffers";
+                        m_Context.error(ss.str());
+                        return nullptr;
+                    }
+                }
+            }
+        }
+
+        CommandBundle* bundle = new CommandBundle(m_Context, m_Resources);
+        bundle->desc = desc;
+        bundle->buildRequiredStates();
+
+        if (!bundle->record())
+        {
+            delete bundle;
+            return nullptr;
+        }
+
+        return CommandBundleHandle::Create(bundle);
+    }
+
+    void CommandBundle::buildRequiredStates()
+    {
+        std::unordered_set<IResource*> visited;
+        std::unordered_set<IBuffer*> vertexBuffers;
+        std::unordered_set<IBuffer*> indexBuffers;
+
+        auto reference = [this, &visited](IResource* resource)
+        {
+            if (resource && visited.insert(resource).second)
+                referencedResources.push_back(resource);
+        };
+
+        const FramebufferDesc& framebufferDesc = desc.draws[0].state.framebuffer->getDesc();
+        for (const auto& attachment : framebufferDesc.colorAttachments)
+        {
+            RequiredResourceState required;
+            required.texture = checked_cast<Texture*>(attachment.texture);
+            required.subresources = attachment.subresources;
+            required.state = ResourceStates::RenderTarget;
+            requiredStates.push_back(required);
+        }
+
+        if (framebufferDesc.depthAttachment.valid())
+        {
+            RequiredResourceState required;
+            required.texture = checked_cast<Texture*>(framebufferDesc.depthAttachment.texture);
+            required.subresources = framebufferDesc.depthAttachment.subresources;
+            required.state = framebufferDesc.depthAttachment.isReadOnly ? ResourceStates::DepthRead : ResourceStates::DepthWrite;
+            requiredStates.push_back(required);
+        }
+
+        if (framebufferDesc.shadingRateAttachment.valid())
+        {
+            RequiredResourceState required;
+            required.texture = checked_cast<Texture*>(framebufferDesc.shadingRateAttachment.texture);
+            required.subresources = framebufferDesc.shadingRateAttachment.subresources;
+            required.state = ResourceStates::ShadingRateSurface;
+            requiredStates.push_back(required);
+        }
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            const GraphicsState& state = draw.state;
+
+            reference(state.pipeline);
+            reference(state.framebuffer);
+
+            for (IBindingSet* _bindingSet : state.bindings)
+            {
+                if (!_bindingSet || visited.count(_bindingSet))
+                    continue;
+
+                reference(_bindingSet);
+
+                if (_bindingSet->getDesc())
+                {
+                    BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+                    requiredStates.insert(requiredStates.end(), bindingSet->requiredStates.begin(), bindingSet->requiredStates.end());
+                    hasUavBindings = hasUavBindings || bindingSet->hasUavBindings;
+                }
+            }
+
+            if (state.indexBuffer.buffer && indexBuffers.insert(state.indexBuffer.buffer).second)
+            {
+                reference(state.indexBuffer.buffer);
+
+                RequiredResourceState required;
+                required.buffer = checked_cast<Buffer*>(state.indexBuffer.buffer);
+                required.state = ResourceStates::IndexBuffer;
+                requiredStates.push_back(required);
+            }
+
+            for (const VertexBufferBinding& binding : state.vertexBuffers)
+            {
+                if (!binding.buffer || !vertexBuffers.insert(binding.buffer).second)
+                    continue;
+
+                reference(binding.buffer);
+
+                RequiredResourceState required;
+                required.buffer = checked_cast<Buffer*>(binding.buffer);
+                required.state = ResourceStates::VertexBuffer;
+                requiredStates.push_back(required);
+            }
+        }
+    }
+
+    // Sets the values of the states that are dynamic in the pipeline and live in the command list on DX12.
+    // The viewport count needs nothing here because RSSetViewports always takes the count.
+    static void setDynamicRenderState(ID3D12GraphicsCommandList* commandList, ID3D12GraphicsCommandList9* commandList9,
+        const GraphicsPipeline* pso, const DynamicRenderStateValues& values)
+    {
+        const DynamicRenderState states = pso->desc.dynamicRenderState;
+
+        if ((states & DynamicRenderState::PrimitiveTopology) != 0)
+            commandList->IASetPrimitiveTopology(convertPrimitiveType(values.primType, pso->desc.patchControlPoints));
+
+        if ((states & DynamicRenderState::DepthBias) != 0 && commandList9)
+            commandList9->RSSetDepthBias(float(values.depthBias), values.depthBiasClamp, values.slopeScaledDepthBias);
+    }
+
+    bool CommandBundle::record()
+    {
+        RefCountPtr<ID3D12CommandAllocator> newAllocator;
+        RefCountPtr<ID3D12GraphicsCommandList> newCommandList;
+
+        HRESULT hr = m_Context.device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&newAllocator));
+        if (SUCCEEDED(hr))
+            hr = m_Context.device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, newAllocator, nullptr, IID_PPV_ARGS(&newCommandList));
+
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to create the D3D12 bundle for command bundle " << utils::DebugNameToString(desc.debugName)
+                << ", HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        allocator = newAllocator;
+        commandList = newCommandList;
+
+        heapSRVetc = m_Resources.shaderResourceViewHeap.getShaderVisibleHeap();
+        heapSamplers = m_Resources.samplerHeap.getShaderVisibleHeap();
+
+        ID3D12DescriptorHeap* heaps[2] = { heapSRVetc, heapSamplers };
+        commandList->SetDescriptorHeaps(2, heaps);
+
+        RefCountPtr<ID3D12GraphicsCommandList9> commandList9;
+        if (m_Context.dynamicDepthBias)
+            commandList->QueryInterface(IID_PPV_ARGS(&commandList9));
+
+        const GraphicsState* prevState = nullptr;
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            const GraphicsState& state = draw.state;
+            GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
+            const GraphicsPipeline* prevPso = prevState ? checked_cast<const GraphicsPipeline*>(prevState->pipeline) : nullptr;
+
+            const bool updateRootSignature = !prevPso || prevPso->rootSignature != pso->rootSignature;
+            const bool updatePipeline = prevPso != pso;
+
+            if (updateRootSignature)
+                commandList->SetGraphicsRootSignature(pso->rootSignature->handle);
+
+            if (updatePipeline)
+            {
+                commandList->SetPipelineState(pso->pipelineState);
+                commandList->IASetPrimitiveTopology(convertPrimitiveType(pso->desc.primType, pso->desc.patchControlPoints));
+            }
+
+            if (pso->desc.dynamicRenderState != 0 && (updatePipeline || prevState->dynamicRenderState != state.dynamicRenderState))
+                setDynamicRenderState(commandList, commandList9, pso, state.dynamicRenderState);
+
+            if (pso->desc.renderState.depthStencilState.stencilEnable)
+            {
+                const uint8_t stencilRef = pso->desc.renderState.depthStencilState.dynamicStencilRef
+                    ? state.dynamicStencilRefValue
+                    : pso->desc.renderState.depthStencilState.stencilRefValue;
+                commandList->OMSetStencilRef(stencilRef);
+            }
+
+            if (pso->requiresBlendFactor)
+                commandList->OMSetBlendFactor(&state.blendConstantColor.r);
+
+            const uint32_t bindingUpdateMask = (updateRootSignature || !prevState) ? ~0u : arrayDifferenceMask(prevState->bindings, state.bindings);
+
+            for (uint32_t bindingSetIndex = 0; bindingSetIndex < uint32_t(state.bindings.size()); bindingSetIndex++)
+            {
+                IBindingSet* _bindingSet = state.bindings[bindingSetIndex];
+
+                if (!_bindingSet || (bindingUpdateMask & (1 << bindingSetIndex)) == 0)
+                    continue;
+
+                const RootParameterIndex rootParameterOffset = pso->rootSignature->pipelineLayouts[bindingSetIndex].second;
+
+                if (_bindingSet->getDesc())
+                {
+                    BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+                    // Volatile constant buffers are rejected in createCommandBundle
+                    for (const auto& parameter : bindingSet->rootParametersVolatileCB)
+                    {
+                        const Buffer* buffer = checked_cast<const Buffer*>(parameter.second);
+                        commandList->SetGraphicsRootConstantBufferView(rootParameterOffset + parameter.first, buffer ? buffer->gpuVA : 0);
+                    }
+
+                    if (bindingSet->descriptorTableValidSamplers)
+                    {
+                        commandList->SetGraphicsRootDescriptorTable(
+                            rootParameterOffset + bindingSet->rootParameterIndexSamplers,
+                            m_Resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers));
+                    }
+
+                    if (bindingSet->descriptorTableValidSRVetc)
+                    {
+                        commandList->SetGraphicsRootDescriptorTable(
+                            rootParameterOffset + bindingSet->rootParameterIndexSRVetc,
+                            m_Resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc));
+                    }
+                }
+                else if (rootParameterOffset != c_InvalidRootParameterIndex)
+                {
+                    DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_bindingSet);
+                    commandList->SetGraphicsRootDescriptorTable(rootParameterOffset, m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorTable->firstDescriptor));
+                }
+            }
+
+            if (!prevState || prevState->indexBuffer != state.indexBuffer)
+            {
+                D3D12_INDEX_BUFFER_VIEW IBV = {};
+
+                if (state.indexBuffer.buffer)
+                {
+                    const Buffer* buffer = checked_cast<const Buffer*>(state.indexBuffer.buffer);
+                    IBV.Format = getDxgiFormatMapping(state.indexBuffer.format).srvFormat;
+                    IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - state.indexBuffer.offset);
+                    IBV.BufferLocation = buffer->gpuVA + state.indexBuffer.offset;
+                }
+
+                commandList->IASetIndexBuffer(&IBV);
+            }
+
+            const InputLayout* inputLayout = checked_cast<const InputLayout*>(pso->desc.inputLayout.Get());
+            if (inputLayout && (updatePipeline || arraysAreDifferent(prevState->vertexBuffers, state.vertexBuffers)))
+            {
+                D3D12_VERTEX_BUFFER_VIEW VBVs[c_MaxVertexAttributes] = {};
+                uint32_t numVBVs = 0;
+
+                for (const VertexBufferBinding& binding : state.vertexBuffers)
+                {
+                    if (binding.slot >= c_MaxVertexAttributes)
+                        continue;
+
+                    const Buffer* buffer = checked_cast<const Buffer*>(binding.buffer);
+                    VBVs[binding.slot].StrideInBytes = inputLayout->elementStrides[binding.slot];
+                    VBVs[binding.slot].SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
+                    VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
+                    numVBVs = std::max(numVBVs, binding.slot + 1);
+                }
+
+                // Views past the used slots are left as they were, the input layout doesn't read them
+                if (numVBVs)
+                    commandList->IASetVertexBuffers(0, numVBVs, VBVs);
+            }
+
+            if (draw.indexed)
+                commandList->DrawIndexedInstanced(draw.args.vertexCount, draw.args.instanceCount, draw.args.startIndexLocation, draw.args.startVertexLocation, draw.args.startInstanceLocation);
+            else
+                commandList->DrawInstanced(draw.args.vertexCount, draw.args.instanceCount, draw.args.startVertexLocation, draw.args.startInstanceLocation);
+
+            prevState = &state;
+        }
+
+        commandList->Close();
+        return true;
+    }
     
     void CommandList::bindFramebuffer(Framebuffer *fb)
     {   
@@ -290,6 +629,60 @@ namespace nvrhi::d3d12
             DSV = m_Resources.depthStencilViewHeap.getCpuHandle(fb->DSV);
 
         m_ActiveCommandList->commandList->OMSetRenderTargets(UINT(RTVs.size()), RTVs.data(), false, fb->desc.depthAttachment.valid() ? &DSV : nullptr);
+        NVRHI_COUNT_STATISTIC(m_Statistics, renderPasses, 1);
+    }
+
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        D3D12_INDEX_BUFFER_VIEW IBV = {};
+
+        if (indexBuffer.buffer)
+        {
+            Buffer* buffer = checked_cast<Buffer*>(indexBuffer.buffer);
+
+            IBV.Format = getDxgiFormatMapping(indexBuffer.format).srvFormat;
+            IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - indexBuffer.offset);
+            IBV.BufferLocation = buffer->gpuVA + indexBuffer.offset;
+
+            referenceResource(buffer);
+        }
+
+        m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+    }
+
+    void CommandList::bindVertexBuffers(const GraphicsPipeline* pso, const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers)
+    {
+        D3D12_VERTEX_BUFFER_VIEW VBVs[c_MaxVertexAttributes] = {};
+        uint32_t maxVbIndex = 0;
+        InputLayout* inputLayout = checked_cast<InputLayout*>(pso->desc.inputLayout.Get());
+
+        for (const VertexBufferBinding& binding : vertexBuffers)
+        {
+            Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            VBVs[binding.slot].StrideInBytes = inputLayout->elementStrides[binding.slot];
+            VBVs[binding.slot].SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
+            VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+
+            referenceResource(buffer);
+        }
+
+        // Unbind the slots that were used by the previous vertex buffers
+        if (m_CurrentGraphicsStateValid)
+        {
+            for (const VertexBufferBinding& binding : m_CurrentGraphicsState.vertexBuffers)
+            {
+                if (binding.slot < c_MaxVertexAttributes)
+                    maxVbIndex = std::max(maxVbIndex, binding.slot);
+            }
+        }
+
+        m_ActiveCommandList->commandList->IASetVertexBuffers(0, maxVbIndex + 1, VBVs);
     }
 
     void CommandList::setGraphicsState(const GraphicsState& state)
@@ -334,7 +727,12 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindGraphicsPipeline(pso, updateRootSignature);
-            m_Instance->referencedResources.push_back(pso);
+            referenceResource(pso);
+        }
+
+        if (pso->desc.dynamicRenderState != 0 && (updatePipeline || m_CurrentGraphicsState.dynamicRenderState != state.dynamicRenderState))
+        {
+            setDynamicRenderState(m_ActiveCommandList->commandList, m_ActiveCommandList->commandList9, pso, state.dynamicRenderState);
         }
 
         if (pso->desc.renderState.depthStencilState.stencilEnable && (updatePipeline || updateStencilRef))
@@ -350,7 +748,7 @@ namespace nvrhi::d3d12
         if (updateFramebuffer)
         {
             bindFramebuffer(framebuffer);
-            m_Instance->referencedResources.push_back(framebuffer);
+            referenceResource(framebuffer);
         }
         
         if (m_EnableAutomaticBarriers && framebuffer && (m_BindingStatesDirty || updateFramebuffer))
@@ -365,20 +763,7 @@ namespace nvrhi::d3d12
 
         if (updateIndexBuffer)
         {
-            D3D12_INDEX_BUFFER_VIEW IBV = {};
-
-            if (state.indexBuffer.buffer)
-            {
-                Buffer* buffer = checked_cast<Buffer*>(state.indexBuffer.buffer);
-
-                IBV.Format = getDxgiFormatMapping(state.indexBuffer.format).srvFormat;
-                IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - state.indexBuffer.offset);
-                IBV.BufferLocation = buffer->gpuVA + state.indexBuffer.offset;
-
-                m_Instance->referencedResources.push_back(state.indexBuffer.buffer);
-            }
-
-            m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+            bindIndexBuffer(state.indexBuffer);
         }
 
         if (m_EnableAutomaticBarriers && state.indexBuffer.buffer && (m_BindingStatesDirty || updateIndexBuffer))
@@ -390,36 +775,7 @@ namespace nvrhi::d3d12
 
         if (updateVertexBuffers)
         {
-            D3D12_VERTEX_BUFFER_VIEW VBVs[c_MaxVertexAttributes] = {};
-            uint32_t maxVbIndex = 0;
-            InputLayout* inputLayout = checked_cast<InputLayout*>(pso->desc.inputLayout.Get());
-
-            for (const VertexBufferBinding& binding : state.vertexBuffers)
-            {
-                Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
-
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-
-                VBVs[binding.slot].StrideInBytes = inputLayout->elementStrides[binding.slot];
-                VBVs[binding.slot].SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
-                VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-
-                m_Instance->referencedResources.push_back(buffer);
-            }
-
-            if (m_CurrentGraphicsStateValid)
-            {
-                for (const VertexBufferBinding& binding : m_CurrentGraphicsState.vertexBuffers)
-                {
-                    if (binding.slot < c_MaxVertexAttributes)
-                        maxVbIndex = std::max(maxVbIndex, binding.slot);
-                }
-            }
-
-            m_ActiveCommandList->commandList->IASetVertexBuffers(0, maxVbIndex + 1, VBVs);
+            bindVertexBuffers(pso, state.vertexBuffers);
         }
 
         if (m_EnableAutomaticBarriers && state.indexBuffer.buffer && (m_BindingStatesDirty || updateVertexBuffers))
@@ -555,15 +911,176 @@ namespace nvrhi::d3d12
         }
 
         m_ActiveCommandList->commandList->SetPipelineState(pso->pipelineState);
+        NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
 
         m_ActiveCommandList->commandList->IASetPrimitiveTopology(convertPrimitiveType(pipelineDesc.primType, pipelineDesc.patchControlPoints));
     }
 
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setGraphicsBindingSet requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        const GraphicsPipeline* pso = checked_cast<const GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+        BindingSetVector& bindings = m_CurrentGraphicsState.bindings;
+
+        if (slot >= bindings.size())
+            bindings.resize(slot + 1);
+
+        // Even an unchanged set goes through setGraphicsBindings to pick up the volatile buffer versions
+        uint32_t bindingUpdateMask = (bindings[slot] != bindingSet) ? (1u << slot) : 0;
+        bindings[slot] = bindingSet;
+
+        if (commitDescriptorHeaps())
+            bindingUpdateMask = ~0u;
+
+        setGraphicsBindings(bindings, bindingUpdateMask, nullptr, false, nullptr, false, pso->rootSignature);
+
+        commitBarriers();
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setVertexBuffers requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        static_vector<VertexBufferBinding, c_MaxVertexAttributes> vertexBuffers;
+        vertexBuffers.resize(numBindings);
+        std::copy(bindings, bindings + numBindings, vertexBuffers.begin());
+
+        if (!arraysAreDifferent(vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
+            return;
+
+        bindVertexBuffers(checked_cast<const GraphicsPipeline*>(m_CurrentGraphicsState.pipeline), vertexBuffers);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            for (const VertexBufferBinding& binding : vertexBuffers)
+                requireBufferState(binding.buffer, ResourceStates::VertexBuffer);
+
+            commitBarriers();
+        }
+
+        m_CurrentGraphicsState.vertexBuffers = vertexBuffers;
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_Context.error("setIndexBuffer requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        if (m_CurrentGraphicsState.indexBuffer == binding)
+            return;
+
+        bindIndexBuffer(binding);
+
+        if (m_EnableAutomaticBarriers && binding.buffer)
+        {
+            requireBufferState(binding.buffer, ResourceStates::IndexBuffer);
+            commitBarriers();
+        }
+
+        m_CurrentGraphicsState.indexBuffer = binding;
+    }
+
+    void CommandList::beginRenderPassScope(const RenderPassScope& scope)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            setResourceStatesForRenderPassScope(scope);
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::endRenderPassScope()
+    {
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+        const GraphicsState& state = bundle->desc.draws[0].state;
+        const GraphicsPipeline* pso = checked_cast<const GraphicsPipeline*>(state.pipeline);
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            // Bundles with UAVs may need UAV barriers on every use, so they can't be skipped
+            m_StateTracker.requireResourceStates(bundle->requiredStates, bundle->hasUavBindings ? nullptr : bundle);
+        }
+
+        commitBarriers();
+        commitDescriptorHeaps();
+
+        {
+            std::lock_guard lockGuard(bundle->mutex);
+
+            if (bundle->heapSRVetc != m_CurrentHeapSRVetc || bundle->heapSamplers != m_CurrentHeapSamplers)
+            {
+                // The descriptor heaps were reallocated since the bundle was recorded.
+                // The previous recording may still be executing, keep it alive with this instance.
+                m_Instance->referencedNativeResources.push_back(bundle->allocator);
+                m_Instance->referencedNativeResources.push_back(bundle->commandList);
+
+                if (!bundle->record())
+                    return;
+            }
+
+            bindFramebuffer(framebuffer);
+
+            DX12_ViewportState vpState = convertViewportState(pso->desc.renderState.rasterState, framebuffer->framebufferInfo, state.viewport);
+            if (vpState.numViewports)
+                m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
+            if (vpState.numScissorRects)
+                m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+
+            const bool variableRateShadingCurrentlyEnabled = m_CurrentGraphicsStateValid && m_CurrentGraphicsState.shadingRateState.enabled;
+            if (state.shadingRateState.enabled)
+            {
+                const FramebufferDesc& framebufferDesc = framebuffer->getDesc();
+                Texture* shadingRateTexture = framebufferDesc.shadingRateAttachment.valid()
+                    ? checked_cast<Texture*>(framebufferDesc.shadingRateAttachment.texture) : nullptr;
+                m_ActiveCommandList->commandList6->RSSetShadingRateImage(shadingRateTexture ? shadingRateTexture->resource.Get() : nullptr);
+
+                D3D12_SHADING_RATE_COMBINER combiners[D3D12_RS_SET_SHADING_RATE_COMBINER_COUNT];
+                combiners[0] = convertShadingRateCombiner(state.shadingRateState.pipelinePrimitiveCombiner);
+                combiners[1] = convertShadingRateCombiner(state.shadingRateState.imageCombiner);
+                m_ActiveCommandList->commandList6->RSSetShadingRate(convertPixelShadingRate(state.shadingRateState.shadingRate), combiners);
+            }
+            else if (variableRateShadingCurrentlyEnabled)
+            {
+                m_ActiveCommandList->commandList6->RSSetShadingRateImage(nullptr);
+                m_ActiveCommandList->commandList6->RSSetShadingRate(D3D12_SHADING_RATE_1X1, nullptr);
+            }
+
+            m_ActiveCommandList->commandList->ExecuteBundle(bundle->commandList);
+        }
+
+        m_Instance->referencedResources.push_back(bundle);
+
+        // The bundle leaves its pipeline, root signature and bindings on the command list
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+    }
+
     void CommandList::draw(const DrawArguments& args)
     {
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
@@ -571,6 +1088,33 @@ namespace nvrhi::d3d12
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::drawMulti(const DrawArguments* args, size_t numDraws)
+    {
+        updateGraphicsVolatileBuffers();
+
+        ID3D12GraphicsCommandList* commandList = m_ActiveCommandList->commandList;
+        for (size_t drawIndex = 0; drawIndex < numDraws; ++drawIndex)
+        {
+            const DrawArguments& drawArgs = args[drawIndex];
+            commandList->DrawInstanced(drawArgs.vertexCount, drawArgs.instanceCount, drawArgs.startVertexLocation, drawArgs.startInstanceLocation);
+        }
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
+    }
+
+    void CommandList::drawIndexedMulti(const DrawArguments* args, size_t numDraws)
+    {
+        updateGraphicsVolatileBuffers();
+
+        ID3D12GraphicsCommandList* commandList = m_ActiveCommandList->commandList;
+        for (size_t drawIndex = 0; drawIndex < numDraws; ++drawIndex)
+        {
+            const DrawArguments& drawArgs = args[drawIndex];
+            commandList->DrawIndexedInstanced(drawArgs.vertexCount, drawArgs.instanceCount, drawArgs.startIndexLocation, drawArgs.startVertexLocation, drawArgs.startInstanceLocation);
+        }
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
     }
 
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -581,6 +1125,7 @@ namespace nvrhi::d3d12
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -591,6 +1136,7 @@ namespace nvrhi::d3d12
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
@@ -610,6 +1156,7 @@ namespace nvrhi::d3d12
             countBuffer->resource,
             countOffsetBytes
         );
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     DX12_ViewportState convertViewportState(const RasterState& rasterState, const FramebufferInfoEx& framebufferInfo, const ViewportState& vpState)
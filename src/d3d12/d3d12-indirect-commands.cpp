@@ -0,0 +1,186 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "d3d12-backend.h"
+#include "../common/indirect-commands.h"
+
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+#include <iomanip>
+#include <sstream>
+
+namespace nvrhi::d3d12
+{
+    Object IndirectCommandLayout::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_CommandSignature:
+            return Object(commandSignature.Get());
+        default:
+            return nullptr;
+        }
+    }
+
+    IndirectCommandLayoutHandle Device::createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc)
+    {
+        RootSignature* rootSignature = nullptr;
+        if (desc.graphicsPipeline)
+            rootSignature = checked_cast<GraphicsPipeline*>(desc.graphicsPipeline)->rootSignature;
+        else if (desc.computePipeline)
+            rootSignature = checked_cast<ComputePipeline*>(desc.computePipeline)->rootSignature;
+
+        if (!rootSignature)
+        {
+            m_Context.error("Cannot create an indirect command layout without a pipeline");
+            return nullptr;
+        }
+
+        std::vector<D3D12_INDIRECT_ARGUMENT_DESC> argumentDescs;
+        argumentDescs.reserve(desc.arguments.size());
+
+        // The root signature is only needed when the commands change root arguments
+        bool changesRootArguments = false;
+
+        for (const IndirectArgumentDesc& argument : desc.arguments)
+        {
+            D3D12_INDIRECT_ARGUMENT_DESC& argumentDesc = argumentDescs.emplace_back();
+            argumentDesc = {};
+
+            switch (argument.type)
+            {
+            case IndirectArgumentType::PushConstants:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+                argumentDesc.Constant.RootParameterIndex = rootSignature->rootParameterPushConstants;
+                argumentDesc.Constant.DestOffsetIn32BitValues = argument.pushConstantsOffset / 4;
+                argumentDesc.Constant.Num32BitValuesToSet = argument.pushConstantsByteSize / 4;
+                changesRootArguments = true;
+                break;
+            case IndirectArgumentType::VertexBuffer:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+                argumentDesc.VertexBuffer.Slot = argument.vertexBufferSlot;
+                break;
+            case IndirectArgumentType::IndexBuffer:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+                break;
+            case IndirectArgumentType::Draw:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+                break;
+            case IndirectArgumentType::DrawIndexed:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+                break;
+            case IndirectArgumentType::Dispatch:
+                argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+                break;
+            default:
+                utils::InvalidEnum();
+                return nullptr;
+            }
+        }
+
+        if (changesRootArguments && rootSignature->pushConstantByteSize == 0)
+        {
+            std::stringstream ss;
+            ss << "Cannot create indirect command layout " << utils::DebugNameToString(desc.debugName)
+                << " with push constant arguments because its pipeline has no push constants";
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        IndirectCommandLayout* layout = new IndirectCommandLayout();
+        layout->desc = desc;
+        layout->byteStride = getIndirectCommandStride(desc);
+        layout->pipeline = desc.graphicsPipeline
+            ? static_cast<IResource*>(desc.graphicsPipeline)
+            : static_cast<IResource*>(desc.computePipeline);
+
+        D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+        signatureDesc.ByteStride = layout->byteStride;
+        signatureDesc.NumArgumentDescs = UINT(argumentDescs.size());
+        signatureDesc.pArgumentDescs = argumentDescs.data();
+
+        const HRESULT hr = m_Context.device->CreateCommandSignature(&signatureDesc,
+            changesRootArguments ? rootSignature->handle.Get() : nullptr, IID_PPV_ARGS(&layout->commandSignature));
+
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to create the command signature for indirect command layout " << utils::DebugNameToString(desc.debugName)
+                << ", HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+            delete layout;
+            return nullptr;
+        }
+
+        if (!desc.debugName.empty())
+        {
+            std::wstring wname(desc.debugName.begin(), desc.debugName.end());
+            layout->commandSignature->SetName(wname.c_str());
+        }
+
+        return IndirectCommandLayoutHandle::Create(layout);
+    }
+
+    void CommandList::executeIndirectCommands(IIndirectCommandLayout* _layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+        uint32_t countOffsetBytes)
+    {
+        IndirectCommandLayout* layout = checked_cast<IndirectCommandLayout*>(_layout);
+
+        Buffer* paramBuffer = nullptr;
+        Buffer* countBuffer = nullptr;
+
+        if (layout->desc.graphicsPipeline)
+        {
+            paramBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+            countBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+
+            updateGraphicsVolatileBuffers();
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+        }
+        else
+        {
+            paramBuffer = checked_cast<Buffer*>(m_CurrentComputeState.indirectParams);
+            countBuffer = checked_cast<Buffer*>(m_CurrentComputeState.indirectCountBuffer);
+
+            updateComputeVolatileBuffers();
+            NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
+        }
+
+        assert(paramBuffer); // validation layer handles this
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(
+            layout->commandSignature,
+            maxCommandCount,
+            paramBuffer->resource,
+            paramOffsetBytes,
+            countBuffer ? countBuffer->resource.Get() : nullptr,
+            countBuffer ? countOffsetBytes : 0);
+
+        referenceResource(layout);
+
+        // The commands leave the vertex buffers, index buffer and root constants in an unknown state
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+    }
+
+} // namespace nvrhi::d3d12
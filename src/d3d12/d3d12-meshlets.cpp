@@ -40,7 +40,7 @@ namespace nvrhi::d3d12
         }
     }
 
-    nvrhi::RefCountPtr<ID3D12PipelineState> Device::createPipelineState(const MeshletPipelineDesc& state, RootSignature* pRS, const FramebufferInfo& fbinfo) const
+    nvrhi::RefCountPtr<ID3D12PipelineState> Device::createPipelineState(const MeshletPipelineDesc& state, RootSignature* pRS, const FramebufferInfo& fbinfo, PipelineCacheResult& cacheResult) const
     {
         RefCountPtr<ID3D12PipelineState> pipelineState;
 
@@ -145,6 +145,25 @@ namespace nvrhi::d3d12
         streamDesc.pPipelineStateSubobjectStream = &psoDesc;
         streamDesc.SizeInBytes = sizeof(psoDesc);
 
+        uint64_t libraryKey = 0;
+        if (m_PipelineLibrary)
+        {
+            // Everything from the rasterizer state onwards is plain data
+            const D3D12_SHADER_BYTECODE shaders[] = { psoDesc.AmplificationShader, psoDesc.MeshShader, psoDesc.PixelShader };
+            const char* statesBegin = reinterpret_cast<const char*>(&psoDesc.RasterizerState_Type);
+            const size_t statesSize = reinterpret_cast<const char*>(&psoDesc + 1) - statesBegin;
+            libraryKey = getPipelineLibraryKey(shaders, std::size(shaders), statesBegin, statesSize, pRS);
+            libraryKey = hash_bytes(&psoDesc.PrimitiveTopologyType, sizeof(psoDesc.PrimitiveTopologyType), libraryKey);
+
+            pipelineState = m_PipelineLibrary->loadPipeline(libraryKey, streamDesc);
+            if (pipelineState)
+            {
+                cacheResult = PipelineCacheResult::Hit;
+                return pipelineState;
+            }
+            cacheResult = PipelineCacheResult::Miss;
+        }
+
         HRESULT hr = m_Context.device2->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&pipelineState));
         if (FAILED(hr))
         {
@@ -152,16 +171,25 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        if (m_PipelineLibrary)
+            m_PipelineLibrary->storePipeline(libraryKey, pipelineState);
+
         return pipelineState;
     }
 
     MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Meshlet, desc);
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
 
-        RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, fbinfo);
+        PipelineCacheResult cacheResult = PipelineCacheResult::Unknown;
+        RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, fbinfo, cacheResult);
+        creationScope.setCacheResult(cacheResult);
 
-        return createHandleForNativeMeshletPipeline(pRS, pPSO, desc, fbinfo);
+        MeshletPipelineHandle pipeline = createHandleForNativeMeshletPipeline(pRS, pPSO, desc, fbinfo);
+        creationScope.setPipeline(pipeline);
+        return pipeline;
     }
 
     MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
@@ -202,6 +230,7 @@ namespace nvrhi::d3d12
         }
 
         commandList->SetPipelineState(pso->pipelineState);
+        NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
 
         commandList->IASetPrimitiveTopology(convertPrimitiveType(state.primType, 0));
 
@@ -229,6 +258,7 @@ namespace nvrhi::d3d12
 
         const bool updatePipeline = !m_CurrentMeshletStateValid || m_CurrentMeshletState.pipeline != state.pipeline;
         const bool updateIndirectParams = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectParams != state.indirectParams;
+        const bool updateIndirectCountBuffer = !m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectCountBuffer != state.indirectCountBuffer;
 
         const bool updateViewports = !m_CurrentMeshletStateValid ||
             arraysAreDifferent(m_CurrentMeshletState.viewport.viewports, state.viewport.viewports) ||
@@ -254,7 +284,7 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             bindMeshletPipeline(pso, updateRootSignature);
-            m_Instance->referencedResources.push_back(pso);
+            referenceResource(pso);
         }
 
         if (pso->desc.renderState.depthStencilState.stencilEnable && (updatePipeline || updateStencilRef))
@@ -270,7 +300,7 @@ namespace nvrhi::d3d12
         if (updateFramebuffer)
         {
             bindFramebuffer(framebuffer);
-            m_Instance->referencedResources.push_back(framebuffer);
+            referenceResource(framebuffer);
         }
 
         if (m_EnableAutomaticBarriers && framebuffer && (m_BindingStatesDirty || updateFramebuffer))
@@ -280,7 +310,7 @@ namespace nvrhi::d3d12
         
         setGraphicsBindings(state.bindings, bindingUpdateMask,
             state.indirectParams, updateIndirectParams,
-            nullptr, false, // <-- indirect count buffer not supported for meshlets
+            state.indirectCountBuffer, updateIndirectCountBuffer,
             pso->rootSignature);
         
         commitBarriers();
@@ -316,5 +346,37 @@ namespace nvrhi::d3d12
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList6->DispatchMesh(groupsX, groupsY, groupsZ);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams); // validation layer handles this
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchMeshIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* paramBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(paramBuffer);
+        assert(countBuffer);
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(
+            m_Context.dispatchMeshIndirectSignature,
+            maxDrawCount,
+            paramBuffer->resource,
+            paramOffsetBytes,
+            countBuffer->resource,
+            countOffsetBytes
+        );
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 } // namespace nvrhi::d3d12
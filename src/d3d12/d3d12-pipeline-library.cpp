@@ -0,0 +1,220 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+namespace nvrhi::d3d12
+{
+    static uint64_t hashShaderBytecode(const D3D12_SHADER_BYTECODE& bytecode, uint64_t seed)
+    {
+        seed = hash_bytes(&bytecode.BytecodeLength, sizeof(bytecode.BytecodeLength), seed);
+        return hash_bytes(bytecode.pShaderBytecode, bytecode.BytecodeLength, seed);
+    }
+
+    // The keys only include the contents of the descs and never any pointers, so that they don't change between runs.
+    // The state structures are hashed as raw memory, which relies on them being zero-initialized before translation.
+
+    uint64_t getPipelineLibraryKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const RootSignature* rootSignature)
+    {
+        uint64_t hash = hash_bytes(&rootSignature->serializedHash, sizeof(rootSignature->serializedHash));
+        hash = hashShaderBytecode(desc.VS, hash);
+        hash = hashShaderBytecode(desc.HS, hash);
+        hash = hashShaderBytecode(desc.DS, hash);
+        hash = hashShaderBytecode(desc.GS, hash);
+        hash = hashShaderBytecode(desc.PS, hash);
+        hash = hash_bytes(&desc.BlendState, sizeof(desc.BlendState), hash);
+        hash = hash_bytes(&desc.SampleMask, sizeof(desc.SampleMask), hash);
+        hash = hash_bytes(&desc.RasterizerState, sizeof(desc.RasterizerState), hash);
+        hash = hash_bytes(&desc.DepthStencilState, sizeof(desc.DepthStencilState), hash);
+
+        for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+        {
+            const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+            hash = hash_bytes(element.SemanticName, strlen(element.SemanticName), hash);
+            hash = hash_bytes(&element.SemanticIndex, sizeof(element.SemanticIndex), hash);
+            hash = hash_bytes(&element.Format, sizeof(element.Format), hash);
+            hash = hash_bytes(&element.InputSlot, sizeof(element.InputSlot), hash);
+            hash = hash_bytes(&element.AlignedByteOffset, sizeof(element.AlignedByteOffset), hash);
+            hash = hash_bytes(&element.InputSlotClass, sizeof(element.InputSlotClass), hash);
+            hash = hash_bytes(&element.InstanceDataStepRate, sizeof(element.InstanceDataStepRate), hash);
+        }
+
+        hash = hash_bytes(&desc.IBStripCutValue, sizeof(desc.IBStripCutValue), hash);
+        hash = hash_bytes(&desc.PrimitiveTopologyType, sizeof(desc.PrimitiveTopologyType), hash);
+        hash = hash_bytes(&desc.NumRenderTargets, sizeof(desc.NumRenderTargets), hash);
+        hash = hash_bytes(desc.RTVFormats, sizeof(desc.RTVFormats), hash);
+        hash = hash_bytes(&desc.DSVFormat, sizeof(desc.DSVFormat), hash);
+        hash = hash_bytes(&desc.SampleDesc, sizeof(desc.SampleDesc), hash);
+        hash = hash_bytes(&desc.NodeMask, sizeof(desc.NodeMask), hash);
+        hash = hash_bytes(&desc.Flags, sizeof(desc.Flags), hash);
+        return hash;
+    }
+
+    uint64_t getPipelineLibraryKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const RootSignature* rootSignature)
+    {
+        uint64_t hash = hash_bytes(&rootSignature->serializedHash, sizeof(rootSignature->serializedHash));
+        hash = hashShaderBytecode(desc.CS, hash);
+        hash = hash_bytes(&desc.NodeMask, sizeof(desc.NodeMask), hash);
+        hash = hash_bytes(&desc.Flags, sizeof(desc.Flags), hash);
+        return hash;
+    }
+
+    uint64_t getPipelineLibraryKey(const D3D12_SHADER_BYTECODE* shaders, size_t numShaders, const void* states, size_t statesSize, const RootSignature* rootSignature)
+    {
+        uint64_t hash = hash_bytes(&rootSignature->serializedHash, sizeof(rootSignature->serializedHash));
+        for (size_t i = 0; i < numShaders; i++)
+            hash = hashShaderBytecode(shaders[i], hash);
+        hash = hash_bytes(states, statesSize, hash);
+        return hash;
+    }
+
+    PipelineLibrary::PipelineLibrary(const Context& context, const void* initialData, size_t initialDataSize)
+        : m_Context(context)
+    {
+        RefCountPtr<ID3D12Device1> device1;
+        if (FAILED(m_Context.device->QueryInterface(&device1)))
+            return;
+
+        if (initialData && initialDataSize != 0)
+        {
+            m_InitialData.assign(static_cast<const uint8_t*>(initialData), static_cast<const uint8_t*>(initialData) + initialDataSize);
+
+            const HRESULT hr = device1->CreatePipelineLibrary(m_InitialData.data(), m_InitialData.size(), IID_PPV_ARGS(&m_Library));
+
+            if (FAILED(hr))
+            {
+                // Expected after driver updates (D3D12_ERROR_DRIVER_VERSION_MISMATCH) or on a different GPU (D3D12_ERROR_ADAPTER_NOT_FOUND)
+                std::stringstream ss;
+                ss << "The provided pipeline cache data cannot be used, HRESULT = 0x" << std::hex << std::setw(8) << hr
+                    << ". Starting with an empty pipeline library.";
+                m_Context.info(ss.str());
+
+                m_InitialData.clear();
+                m_Library = nullptr;
+            }
+        }
+
+        if (!m_Library)
+        {
+            const HRESULT hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_Library));
+
+            // Pipeline libraries are optional, e.g. they are not supported when running under some graphics debuggers
+            if (FAILED(hr))
+                return;
+        }
+
+        m_Library->QueryInterface(&m_Library1);
+    }
+
+    std::wstring PipelineLibrary::getPipelineName(uint64_t key)
+    {
+        std::wstringstream ss;
+        ss << L"nvrhi_" << std::hex << std::setw(16) << std::setfill(L'0') << key;
+        return ss.str();
+    }
+
+    RefCountPtr<ID3D12PipelineState> PipelineLibrary::loadGraphicsPipeline(uint64_t key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+    {
+        RefCountPtr<ID3D12PipelineState> pipelineState;
+        const std::wstring name = getPipelineName(key);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // E_INVALIDARG means that the pipeline is not in the library, or that it was stored with a different desc
+        if (FAILED(m_Library->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+            return nullptr;
+
+        return pipelineState;
+    }
+
+    RefCountPtr<ID3D12PipelineState> PipelineLibrary::loadComputePipeline(uint64_t key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+    {
+        RefCountPtr<ID3D12PipelineState> pipelineState;
+        const std::wstring name = getPipelineName(key);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (FAILED(m_Library->LoadComputePipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+            return nullptr;
+
+        return pipelineState;
+    }
+
+    RefCountPtr<ID3D12PipelineState> PipelineLibrary::loadPipeline(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+    {
+        // Stream descs can only be loaded through ID3D12PipelineLibrary1
+        if (!m_Library1)
+            return nullptr;
+
+        RefCountPtr<ID3D12PipelineState> pipelineState;
+        const std::wstring name = getPipelineName(key);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (FAILED(m_Library1->LoadPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+            return nullptr;
+
+        return pipelineState;
+    }
+
+    void PipelineLibrary::storePipeline(uint64_t key, ID3D12PipelineState* pipelineState)
+    {
+        if (!pipelineState)
+            return;
+
+        const std::wstring name = getPipelineName(key);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // This fails with E_INVALIDARG if there is a stale pipeline with the same name already, which is harmless:
+        // the pipeline will just be compiled again on the next run.
+        m_Library->StorePipeline(name.c_str(), pipelineState);
+    }
+
+    bool PipelineLibrary::serialize(void* data, size_t* dataSize)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        const size_t serializedSize = m_Library->GetSerializedSize();
+
+        if (!data)
+        {
+            *dataSize = serializedSize;
+            return true;
+        }
+
+        if (*dataSize < serializedSize)
+            return false;
+
+        if (FAILED(m_Library->Serialize(data, serializedSize)))
+            return false;
+
+        *dataSize = serializedSize;
+        return true;
+    }
+
+} // namespace nvrhi::d3d12
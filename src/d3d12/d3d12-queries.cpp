@@ -24,6 +24,9 @@
 
 #include <nvrhi/common/misc.h>
 
+#include <sstream>
+#include <iomanip>
+
 namespace nvrhi::d3d12
 {
     TimerQuery::~TimerQuery()
@@ -219,5 +222,212 @@ namespace nvrhi::d3d12
             query->beginQueryIndex * 8);
     }
 
+    TimestampQueryPoolHandle Device::createTimestampQueryPool(const TimestampQueryPoolDesc& desc)
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = desc.queryCount;
+
+        RefCountPtr<ID3D12QueryHeap> queryHeap;
+        const HRESULT res = m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&queryHeap));
+
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateQueryHeap call failed for timestamp query pool " << utils::DebugNameToString(desc.debugName)
+               << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+
+            return nullptr;
+        }
+
+        BufferHandle resolveBuffer = createBuffer(BufferDesc()
+            .setByteSize(uint64_t(desc.queryCount) * sizeof(uint64_t))
+            .setCpuAccess(CpuAccessMode::Read)
+            .setDebugName(desc.debugName));
+
+        if (!resolveBuffer)
+            return nullptr;
+
+        TimestampQueryPool* pool = new TimestampQueryPool();
+        pool->desc = desc;
+        pool->queryHeap = queryHeap;
+        pool->resolveBuffer = resolveBuffer;
+
+        return TimestampQueryPoolHandle::Create(pool);
+    }
+
+    bool Device::getTimestampResults(ITimestampQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps)
+    {
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        const uint64_t offset = uint64_t(firstQuery) * sizeof(uint64_t);
+        const size_t size = size_t(queryCount) * sizeof(uint64_t);
+
+        // The resolve buffer is never used through the state tracker, so this doesn't wait for the GPU
+        const void* data = mapBuffer(pool->resolveBuffer, CpuAccessMode::Read, offset, size);
+        if (!data)
+            return false;
+
+        memcpy(outTimestamps, data, size);
+        unmapBuffer(pool->resolveBuffer);
+
+        return true;
+    }
+
+    uint64_t Device::getTimestampFrequency(CommandQueue queue)
+    {
+        Queue* pQueue = getQueue(queue);
+        if (!pQueue)
+            return 0;
+
+        uint64_t frequency = 0;
+        pQueue->queue->GetTimestampFrequency(&frequency);
+        return frequency;
+    }
+
+    void CommandList::resetTimestamps(ITimestampQueryPool*, uint32_t, uint32_t)
+    {
+        // D3D12 timestamp queries can be overwritten without a reset
+    }
+
+    void CommandList::writeTimestamp(ITimestampQueryPool* _pool, uint32_t queryIndex)
+    {
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        m_Instance->referencedResources.push_back(pool);
+
+        m_ActiveCommandList->commandList->EndQuery(pool->queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, queryIndex);
+    }
+
+    void CommandList::resolveTimestamps(ITimestampQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+        Buffer* resolveBuffer = checked_cast<Buffer*>(pool->resolveBuffer.Get());
+
+        m_Instance->referencedResources.push_back(pool);
+
+        m_ActiveCommandList->commandList->ResolveQueryData(pool->queryHeap,
+            D3D12_QUERY_TYPE_TIMESTAMP,
+            firstQuery,
+            queryCount,
+            resolveBuffer->resource,
+            uint64_t(firstQuery) * sizeof(uint64_t));
+    }
+
+    QueryPoolHandle Device::createQueryPool(const QueryPoolDesc& desc)
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Count = desc.queryCount;
+
+        D3D12_QUERY_TYPE queryType;
+        switch (desc.type)
+        {
+        case QueryType::Occlusion:
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_OCCLUSION;
+            queryType = D3D12_QUERY_TYPE_OCCLUSION;
+            break;
+        case QueryType::BinaryOcclusion:
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_OCCLUSION;
+            queryType = D3D12_QUERY_TYPE_BINARY_OCCLUSION;
+            break;
+        case QueryType::PipelineStatistics:
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS;
+            queryType = D3D12_QUERY_TYPE_PIPELINE_STATISTICS;
+            break;
+        default:
+            utils::InvalidEnum();
+            return nullptr;
+        }
+
+        RefCountPtr<ID3D12QueryHeap> queryHeap;
+        const HRESULT res = m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&queryHeap));
+
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateQueryHeap call failed for query pool " << utils::DebugNameToString(desc.debugName)
+               << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+
+            return nullptr;
+        }
+
+        QueryPool* pool = new QueryPool();
+        pool->desc = desc;
+        pool->queryHeap = queryHeap;
+        pool->queryType = queryType;
+
+        return QueryPoolHandle::Create(pool);
+    }
+
+    void CommandList::resetQueries(IQueryPool*, uint32_t, uint32_t)
+    {
+        // D3D12 queries can be reused without a reset
+    }
+
+    void CommandList::beginQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        m_Instance->referencedResources.push_back(pool);
+
+        m_ActiveCommandList->commandList->BeginQuery(pool->queryHeap, pool->queryType, queryIndex);
+    }
+
+    void CommandList::endQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        m_Instance->referencedResources.push_back(pool);
+
+        m_ActiveCommandList->commandList->EndQuery(pool->queryHeap, pool->queryType, queryIndex);
+    }
+
+    void CommandList::resolveQueries(IQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* _dest, uint64_t destOffsetBytes)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+        Buffer* dest = checked_cast<Buffer*>(_dest);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(dest, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(pool);
+
+        if (dest->desc.cpuAccess != CpuAccessMode::None)
+            m_Instance->referencedStagingBuffers.push_back(dest);
+        else
+            m_Instance->referencedResources.push_back(dest);
+
+        m_ActiveCommandList->commandList->ResolveQueryData(pool->queryHeap, pool->queryType, firstQuery, queryCount,
+            dest->resource, destOffsetBytes);
+    }
+
+    void CommandList::beginPredication(IBuffer* _buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::Predication);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(buffer);
+
+        m_ActiveCommandList->commandList->SetPredication(buffer->resource, offsetBytes,
+            op == PredicationOp::SkipIfZero ? D3D12_PREDICATION_OP_EQUAL_ZERO : D3D12_PREDICATION_OP_NOT_EQUAL_ZERO);
+    }
+
+    void CommandList::endPredication()
+    {
+        m_ActiveCommandList->commandList->SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+    }
+
 
 } // namespace nvrhi::d3d12
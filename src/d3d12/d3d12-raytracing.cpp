@@ -315,7 +315,7 @@ namespace nvrhi::d3d12
             rayGenerationShader.pShaderIdentifier = pipelineExport->pShaderIdentifier;
             rayGenerationShader.localBindings = bindings;
 
-            ++version;
+            markRecordDirty(0);
         }
     }
 
@@ -330,7 +330,7 @@ namespace nvrhi::d3d12
             entry.localBindings = bindings;
             missShaders.push_back(entry);
 
-            ++version;
+            markLayoutChanged();
 
             return int(missShaders.size()) - 1;
         }
@@ -349,7 +349,7 @@ namespace nvrhi::d3d12
             entry.localBindings = bindings;
             hitGroups.push_back(entry);
 
-            ++version;
+            markLayoutChanged();
 
             return int(hitGroups.size()) - 1;
         }
@@ -368,7 +368,7 @@ namespace nvrhi::d3d12
             entry.localBindings = bindings;
             callableShaders.push_back(entry);
 
-            ++version;
+            markLayoutChanged();
 
             return int(callableShaders.size()) - 1;
         }
@@ -379,19 +379,133 @@ namespace nvrhi::d3d12
     void ShaderTable::clearMissShaders()
     {
         missShaders.clear();
-        ++version;
+        markLayoutChanged();
     }
 
     void ShaderTable::clearHitShaders()
     {
         hitGroups.clear();
-        ++version;
+        markLayoutChanged();
     }
 
     void ShaderTable::clearCallableShaders()
     {
         callableShaders.clear();
+        markLayoutChanged();
+    }
+
+    bool ShaderTable::replaceRecord(std::vector<Entry>& section, uint32_t index, const char* exportName, IBindingSet* bindings)
+    {
+        if (index >= section.size())
+        {
+            std::stringstream ss;
+            ss << "Shader table record index " << index << " is out of range, the section has "
+                << section.size() << " records";
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
+
+        if (!verifyExport(pipelineExport, bindings))
+            return false;
+
+        Entry& entry = section[index];
+        entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
+        entry.localBindings = bindings;
+
+        return true;
+    }
+
+    bool ShaderTable::setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!replaceRecord(missShaders, index, exportName, bindings))
+            return false;
+
+        markRecordDirty(getRecordIndex(rt::ShaderTableSection::Miss, index));
+        return true;
+    }
+
+    bool ShaderTable::setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!replaceRecord(hitGroups, index, exportName, bindings))
+            return false;
+
+        markRecordDirty(getRecordIndex(rt::ShaderTableSection::HitGroup, index));
+        return true;
+    }
+
+    bool ShaderTable::setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!replaceRecord(callableShaders, index, exportName, bindings))
+            return false;
+
+        markRecordDirty(getRecordIndex(rt::ShaderTableSection::Callable, index));
+        return true;
+    }
+
+    uint32_t ShaderTable::getRecordIndex(rt::ShaderTableSection section, uint32_t index) const
+    {
+        switch (section)
+        {
+        case rt::ShaderTableSection::RayGeneration:
+            return 0;
+        case rt::ShaderTableSection::Miss:
+            return 1 + index;
+        case rt::ShaderTableSection::HitGroup:
+            return 1 + uint32_t(missShaders.size()) + index;
+        case rt::ShaderTableSection::Callable:
+            return 1 + uint32_t(missShaders.size()) + uint32_t(hitGroups.size()) + index;
+        default:
+            utils::InvalidEnum();
+            return 0;
+        }
+    }
+
+    uint64_t ShaderTable::getRecordOffset(rt::ShaderTableSection section, uint32_t index) const
+    {
+        return uint64_t(getRecordIndex(section, index)) * pipeline->getShaderTableEntrySize();
+    }
+
+    const ShaderTable::Entry& ShaderTable::getRecord(uint32_t recordIndex) const
+    {
+        if (recordIndex == 0)
+            return rayGenerationShader;
+        recordIndex -= 1;
+
+        if (recordIndex < missShaders.size())
+            return missShaders[recordIndex];
+        recordIndex -= uint32_t(missShaders.size());
+
+        if (recordIndex < hitGroups.size())
+            return hitGroups[recordIndex];
+        recordIndex -= uint32_t(hitGroups.size());
+
+        return callableShaders[recordIndex];
+    }
+
+    void ShaderTable::markRecordDirty(uint32_t recordIndex)
+    {
         ++version;
+
+        if (!m_Desc.isCached)
+            return;
+
+        // When most of the table is dirty, a full rebuild is no more expensive than the record updates
+        if (dirtyRecords.size() >= getNumEntries() / 2)
+        {
+            markLayoutChanged();
+            return;
+        }
+
+        dirtyRecords.push_back(recordIndex);
+    }
+
+    void ShaderTable::markLayoutChanged()
+    {
+        ++version;
+        ++layoutVersion;
+        dirtyRecords.clear();
     }
 
     const RayTracingPipeline::ExportTableEntry* RayTracingPipeline::getExport(const char* name)
@@ -420,6 +534,7 @@ namespace nvrhi::d3d12
                 .setDebugName(stDesc.debugName)
                 .setByteSize(getShaderTableEntrySize() * stDesc.maxEntries)
                 .setIsShaderBindingTable(true)
+                .setCanHaveUAVs(stDesc.allowGpuWrites)
                 .enableAutomaticStateTracking(ResourceStates::ShaderResource);
 
             cache = m_Device->createBuffer(bufferDesc);
@@ -449,6 +564,9 @@ namespace nvrhi::d3d12
             m_Context.rtxMemUtil->RemoveAccelerationStructures(delAccel);
             rtxmuId = ~0ull;
         }
+#else
+        if (storagePool)
+            storagePool->release(dataBuffer, dataOffset, compactedSize);
 #endif // NVRHI_WITH_RTXMU
     }
 
@@ -478,8 +596,9 @@ namespace nvrhi::d3d12
 #ifdef NVRHI_WITH_RTXMU
         if (!desc.isTopLevel)
             return m_Context.rtxMemUtil->GetAccelStructGPUVA(rtxmuId);
+#else
+        return dataBuffer->gpuVA + dataOffset;
 #endif
-        return dataBuffer->gpuVA;
     }
 
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP
@@ -909,6 +1028,22 @@ namespace nvrhi::d3d12
             BufferHandle buffer = createBuffer(bufferDesc);
             as->dataBuffer = checked_cast<Buffer*>(buffer.Get());
         }
+
+        if (desc.isTopLevel && desc.persistentInstanceBuffer)
+        {
+            BufferDesc bufferDesc;
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.byteSize = std::max<size_t>(desc.topLevelMaxInstances, 1) * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+            bufferDesc.initialState = ResourceStates::AccelStructBuildInput;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.isAccelStructBuildInput = true;
+            bufferDesc.debugName = desc.debugName + " instances";
+            BufferHandle buffer = createBuffer(bufferDesc);
+            as->instanceBuffer = checked_cast<Buffer*>(buffer.Get());
+
+            if (desc.trackLiveness)
+                as->instanceBufferBLASes.resize(desc.topLevelMaxInstances);
+        }
         
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the desc
         for (auto& geometry : as->desc.bottomLevelGeometries)
@@ -946,6 +1081,37 @@ namespace nvrhi::d3d12
         return MemoryRequirements();
     }
 
+    rt::AccelStructBuildSizes Device::getAccelStructBuildSizes(const rt::AccelStructDesc& desc)
+    {
+        rt::AccelStructBuildSizes sizes;
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
+        if (GetAccelStructPreBuildInfo(ASPreBuildInfo, desc))
+        {
+            sizes.resultSize = ASPreBuildInfo.ResultDataMaxSizeInBytes;
+            sizes.buildScratchSize = ASPreBuildInfo.ScratchDataSizeInBytes;
+            sizes.updateScratchSize = ASPreBuildInfo.UpdateScratchDataSizeInBytes;
+        }
+
+        return sizes;
+    }
+
+    bool Device::isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header)
+    {
+        if (!m_Context.device5)
+            return false;
+
+        static_assert(sizeof(header.driverIdentifier) == sizeof(D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER));
+
+        D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER identifier;
+        memcpy(&identifier, header.driverIdentifier, sizeof(identifier));
+
+        D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS const status = m_Context.device5->CheckDriverMatchingIdentifier(
+            D3D12_SERIALIZED_DATA_RAYTRACING_ACCELERATION_STRUCTURE, &identifier);
+
+        return status == D3D12_DRIVER_MATCHING_IDENTIFIER_COMPATIBLE_WITH_DEVICE;
+    }
+
     bool Device::bindAccelStructMemory(rt::IAccelStruct* _as, IHeap* heap, uint64_t offset)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
@@ -1183,10 +1349,53 @@ namespace nvrhi::d3d12
     
     rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
     {
+        return createRayTracingPipelineInternal(desc, nullptr);
+    }
+
+    rt::PipelineHandle Device::addToRayTracingPipeline(rt::IPipeline* _pipeline, const rt::PipelineDesc& additions)
+    {
+        RayTracingPipeline* basePipeline = checked_cast<RayTracingPipeline*>(_pipeline);
+
+        if (!basePipeline->desc.allowAdditions)
+        {
+            m_Context.error("Cannot add to a DXR pipeline that was created without allowAdditions");
+            return nullptr;
+        }
+
+        return createRayTracingPipelineInternal(additions, basePipeline);
+    }
+
+    rt::PipelineHandle Device::createRayTracingPipelineInternal(const rt::PipelineDesc& desc, RayTracingPipeline* basePipeline)
+    {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::RayTracing, desc);
+
+        // When adding to an existing pipeline, only the shaders and hit groups come from 'desc',
+        // everything else is inherited from the base pipeline.
+        const rt::PipelineDesc& settings = basePipeline ? basePipeline->desc : desc;
+
+        if (settings.allowAdditions && !m_RayTracingPipelineLibrariesSupported)
+        {
+            m_Context.error("Ray tracing pipeline additions are not supported by this device");
+            return nullptr;
+        }
+
         RayTracingPipeline* pso = new RayTracingPipeline(m_Context, this);
-        pso->desc = desc;
+        pso->desc = settings;
         pso->maxLocalRootParameters = 0;
 
+        if (basePipeline)
+        {
+            pso->desc.shaders.insert(pso->desc.shaders.end(), desc.shaders.begin(), desc.shaders.end());
+            pso->desc.hitGroups.insert(pso->desc.hitGroups.end(), desc.hitGroups.begin(), desc.hitGroups.end());
+            pso->localRootSignatures = basePipeline->localRootSignatures;
+            pso->globalRootSignature = basePipeline->globalRootSignature;
+            pso->maxLocalRootParameters = basePipeline->maxLocalRootParameters;
+            pso->additionIndex = basePipeline->additionIndex + 1;
+        }
+
+        // Local root signatures that are associated with the exports in 'desc'
+        std::unordered_map<IBindingLayout*, RootSignatureHandle> localRootSignatures;
+
         // Collect all DXIL libraries that are referenced in `desc`, and enumerate their exports.
         // Build local root signatures for all referenced local binding layouts.
         // Convert the export names to wstring.
@@ -1235,6 +1444,7 @@ namespace nvrhi::d3d12
                     BindingLayout* layout = checked_cast<BindingLayout*>(shaderDesc.bindingLayout.Get());
                     pso->maxLocalRootParameters = std::max(pso->maxLocalRootParameters, uint32_t(layout->rootParameters.size()));
                 }
+                localRootSignatures[shaderDesc.bindingLayout] = localRS;
             }
         }
 
@@ -1269,8 +1479,11 @@ namespace nvrhi::d3d12
                     library.pBlob = pBlob;
                     library.blobSize = blobSize;
 
+                    // Names from additions get a unique prefix, they must not collide with the base pipeline.
                     std::string originalShaderName = shader->getDesc().entryName;
                     std::string newShaderName = originalShaderName + std::to_string(hitGroupShaderNames.size());
+                    if (pso->additionIndex != 0)
+                        newShaderName = originalShaderName + "_add" + std::to_string(pso->additionIndex) + "_" + std::to_string(hitGroupShaderNames.size());
 
                     library.exports.push_back(std::make_pair<std::wstring, std::wstring>(
                         std::wstring(originalShaderName.begin(), originalShaderName.end()),
@@ -1293,6 +1506,7 @@ namespace nvrhi::d3d12
                     BindingLayout* layout = checked_cast<BindingLayout*>(hitGroupDesc.bindingLayout.Get());
                     pso->maxLocalRootParameters = std::max(pso->maxLocalRootParameters, uint32_t(layout->rootParameters.size()));
                 }
+                localRootSignatures[hitGroupDesc.bindingLayout] = localRS;
             }
 
             // Create a hit group descriptor and store the new export names in it.
@@ -1352,8 +1566,8 @@ namespace nvrhi::d3d12
         // Subobject: Shader config
 
         D3D12_RAYTRACING_SHADER_CONFIG d3dShaderConfig = {};
-        d3dShaderConfig.MaxAttributeSizeInBytes = desc.maxAttributeSize;
-        d3dShaderConfig.MaxPayloadSizeInBytes = desc.maxPayloadSize;
+        d3dShaderConfig.MaxAttributeSizeInBytes = settings.maxAttributeSize;
+        d3dShaderConfig.MaxPayloadSizeInBytes = settings.maxPayloadSize;
 
         d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG;
         d3dSubobject.pDesc = &d3dShaderConfig;
@@ -1364,7 +1578,7 @@ namespace nvrhi::d3d12
         d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG1;
         D3D12_RAYTRACING_PIPELINE_CONFIG1 d3dPipelineConfig = {};
 
-        if (m_OpacityMicromapSupported && desc.allowOpacityMicromaps)
+        if (m_OpacityMicromapSupported && settings.allowOpacityMicromaps)
         {
             d3dPipelineConfig.Flags = D3D12_RAYTRACING_PIPELINE_FLAG_ALLOW_OPACITY_MICROMAPS;
         }
@@ -1373,10 +1587,23 @@ namespace nvrhi::d3d12
         D3D12_RAYTRACING_PIPELINE_CONFIG d3dPipelineConfig = {};
 #endif
 
-        d3dPipelineConfig.MaxTraceRecursionDepth = desc.maxRecursionDepth;
+        d3dPipelineConfig.MaxTraceRecursionDepth = settings.maxRecursionDepth;
         d3dSubobject.pDesc = &d3dPipelineConfig;
         d3dSubobjects.push_back(d3dSubobject);
 
+        // Subobject: state object config
+
+        D3D12_STATE_OBJECT_CONFIG d3dStateObjectConfig = {};
+
+        if (settings.allowAdditions)
+        {
+            d3dStateObjectConfig.Flags = D3D12_STATE_OBJECT_FLAG_ALLOW_STATE_OBJECT_ADDITIONS;
+
+            d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_STATE_OBJECT_CONFIG;
+            d3dSubobject.pDesc = &d3dStateObjectConfig;
+            d3dSubobjects.push_back(d3dSubobject);
+        }
+
         // Subobjects: DXIL libraries
 
         for (const D3D12_DXIL_LIBRARY_DESC& d3dLibraryDesc : d3dDxilLibraries)
@@ -1399,10 +1626,13 @@ namespace nvrhi::d3d12
 
         D3D12_GLOBAL_ROOT_SIGNATURE d3dGlobalRootSignature = {};
 
-        if (!desc.globalBindingLayouts.empty())
+        if (!settings.globalBindingLayouts.empty())
         {
-            RootSignatureHandle rootSignature = buildRootSignature(desc.globalBindingLayouts, false, false);
-            pso->globalRootSignature = checked_cast<RootSignature*>(rootSignature.Get());
+            if (!pso->globalRootSignature)
+            {
+                RootSignatureHandle rootSignature = buildRootSignature(settings.globalBindingLayouts, false, false);
+                pso->globalRootSignature = checked_cast<RootSignature*>(rootSignature.Get());
+            }
             d3dGlobalRootSignature.pGlobalRootSignature = pso->globalRootSignature->getNativeObject(ObjectTypes::D3D12_RootSignature);
 
             d3dSubobject.Type = D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE;
@@ -1416,9 +1646,9 @@ namespace nvrhi::d3d12
         // because we need to store pointers to array elements there.
         std::vector<D3D12_LOCAL_ROOT_SIGNATURE> d3dLocalRootSignatures;
         std::vector<D3D12_SUBOBJECT_TO_EXPORTS_ASSOCIATION> d3dAssociations;
-        d3dLocalRootSignatures.reserve(pso->localRootSignatures.size());
-        d3dAssociations.reserve(pso->localRootSignatures.size());
-        d3dSubobjects.reserve(d3dSubobjects.size() + pso->localRootSignatures.size() * 2);
+        d3dLocalRootSignatures.reserve(localRootSignatures.size());
+        d3dAssociations.reserve(localRootSignatures.size());
+        d3dSubobjects.reserve(d3dSubobjects.size() + localRootSignatures.size() * 2);
 
         // Same - pre-allocate the arrays to avoid resizing them
         size_t numAssociations = desc.shaders.size() + desc.hitGroups.size();
@@ -1427,7 +1657,7 @@ namespace nvrhi::d3d12
         d3dAssociationExports.reserve(numAssociations);
         d3dAssociationExportsCStr.reserve(numAssociations);
 
-        for (const auto& it : pso->localRootSignatures)
+        for (const auto& it : localRootSignatures)
         {
             D3D12_LOCAL_ROOT_SIGNATURE* d3dLocalRootSignature = &d3dLocalRootSignatures.emplace_back();
             d3dLocalRootSignature->pLocalRootSignature = it.second->getNativeObject(ObjectTypes::D3D12_RootSignature);
@@ -1478,15 +1708,19 @@ namespace nvrhi::d3d12
         pipelineDesc.NumSubobjects = static_cast<UINT>(d3dSubobjects.size());
         pipelineDesc.pSubobjects = d3dSubobjects.data();
 
-        if (desc.hlslExtensionsUAV >= 0)
+        if (settings.hlslExtensionsUAV >= 0)
         {
-            if (!setHlslExtensionsUAV(desc.hlslExtensionsUAV))
+            if (!setHlslExtensionsUAV(settings.hlslExtensionsUAV))
                 return nullptr;
         }
 
-        HRESULT hr = m_Context.device5->CreateStateObject(&pipelineDesc, IID_PPV_ARGS(&pso->pipelineState));
+        HRESULT hr;
+        if (basePipeline)
+            hr = m_Context.device7->AddToStateObject(&pipelineDesc, basePipeline->pipelineState, IID_PPV_ARGS(&pso->pipelineState));
+        else
+            hr = m_Context.device5->CreateStateObject(&pipelineDesc, IID_PPV_ARGS(&pso->pipelineState));
 
-        if (desc.hlslExtensionsUAV >= 0)
+        if (settings.hlslExtensionsUAV >= 0)
         {
             // Disable the magic UAV slot - do it before the test for successful pipeline creation below
             // to avoid leaving the slot set when there's an error in the pipeline.
@@ -1508,7 +1742,10 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
-        for (const rt::PipelineShaderDesc& shaderDesc : desc.shaders)
+        // Query the identifiers of all exports, including those inherited from the base pipeline,
+        // from the new state object.
+
+        for (const rt::PipelineShaderDesc& shaderDesc : pso->desc.shaders)
         {
             std::string exportName = !shaderDesc.exportName.empty() ? shaderDesc.exportName : shaderDesc.shader->getDesc().entryName;
             std::wstring exportNameW = std::wstring(exportName.begin(), exportName.end());
@@ -1523,7 +1760,7 @@ namespace nvrhi::d3d12
             pso->exports[exportName] = RayTracingPipeline::ExportTableEntry{ shaderDesc.bindingLayout, pShaderIdentifier };
         }
 
-        for(const rt::PipelineHitGroupDesc& hitGroupDesc : desc.hitGroups)
+        for(const rt::PipelineHitGroupDesc& hitGroupDesc : pso->desc.hitGroups)
         { 
             std::wstring exportNameW = std::wstring(hitGroupDesc.exportName.begin(), hitGroupDesc.exportName.end());
             const void* pShaderIdentifier = pso->pipelineInfo->GetShaderIdentifier(exportNameW.c_str());
@@ -1537,42 +1774,57 @@ namespace nvrhi::d3d12
             pso->exports[hitGroupDesc.exportName] = RayTracingPipeline::ExportTableEntry{ hitGroupDesc.bindingLayout, pShaderIdentifier };
         }
 
+        creationScope.setPipeline(pso);
+
         return rt::PipelineHandle::Create(pso);
     }
 
-    void ShaderTable::bake(uint8_t* cpuVA, D3D12_GPU_VIRTUAL_ADDRESS gpuVA, DeviceResources& resources, ShaderTableState& state)
+    void ShaderTable::writeRecord(uint8_t* cpuVA, const Entry& entry, DeviceResources& resources) const
     {
-        uint32_t const entrySize = pipeline->getShaderTableEntrySize();
+        memcpy(cpuVA, entry.pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
 
-        auto writeEntry = [this, &resources, entrySize, &cpuVA, &gpuVA](const ShaderTable::Entry& entry) 
+        if (!entry.localBindings)
+            return;
+
+        d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry.localBindings.Get());
+        d3d12::BindingLayout* layout = bindingSet->layout;
+
+        if (layout->descriptorTableSizeSamplers > 0)
+        {
+            auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
+                + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+            *pTable = resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
+        }
+
+        if (layout->descriptorTableSizeSRVetc > 0)
         {
-            memcpy(cpuVA, entry.pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+            auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
+                + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+            *pTable = resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
+        }
 
-            if (entry.localBindings)
-            {
-                d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry.localBindings.Get());
-                d3d12::BindingLayout* layout = bindingSet->layout;
+        // Root descriptors are 8-byte GPU addresses, same size as the table handles
+        for (size_t pushIndex = 0; pushIndex < bindingSet->rootParametersPushDescriptors.size(); pushIndex++)
+        {
+            const auto& parameter = bindingSet->rootParametersPushDescriptors[pushIndex];
+            auto pAddress = reinterpret_cast<D3D12_GPU_VIRTUAL_ADDRESS*>(cpuVA
+                + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + parameter.first * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+            *pAddress = parameter.second;
+        }
 
-                if (layout->descriptorTableSizeSamplers > 0)
-                {
-                    auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
-                        + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                    *pTable = resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
-                }
+        if (!layout->rootParametersVolatileCB.empty())
+        {
+            m_Context.error("Cannot use Volatile CBs in a shader binding table");
+        }
+    }
 
-                if (layout->descriptorTableSizeSRVetc > 0)
-                {
-                    auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
-                        + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                    *pTable = resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
-                }
+    void ShaderTable::bake(uint8_t* cpuVA, D3D12_GPU_VIRTUAL_ADDRESS gpuVA, DeviceResources& resources, ShaderTableState& state)
+    {
+        uint32_t const entrySize = pipeline->getShaderTableEntrySize();
 
-                if (!layout->rootParametersVolatileCB.empty())
-                {
-                    m_Context.error("Cannot use Volatile CBs in a shader binding table");
-                    return;
-                }
-            }
+        auto writeEntry = [this, &resources, entrySize, &cpuVA, &gpuVA](const ShaderTable::Entry& entry) 
+        {
+            writeRecord(cpuVA, entry, resources);
 
             cpuVA += entrySize;
             gpuVA += entrySize;
@@ -1616,6 +1868,9 @@ namespace nvrhi::d3d12
         }
 
         state.committedVersion = version;
+        state.committedLayoutVersion = layoutVersion;
+        dirtyRecords.clear();
+
         if (pipeline->hasLocalResources())
         {
             state.descriptorHeapSRV =  resources.shaderResourceViewHeap.getShaderVisibleHeap();
@@ -1641,6 +1896,72 @@ namespace nvrhi::d3d12
             return state.committedVersion == version;
         }
     }
+
+    bool ShaderTable::canUpdateRecords(ShaderTableState const& state, DeviceResources const& resources) const
+    {
+        // Individual records can only be patched in the cache buffer, and only while the layout
+        // and the descriptor heaps referenced by the whole table stay the same.
+        if (!m_Desc.isCached || state.committedLayoutVersion != layoutVersion)
+            return false;
+
+        if (pipeline->hasLocalResources())
+        {
+            return state.descriptorHeapSRV == resources.shaderResourceViewHeap.getShaderVisibleHeap() &&
+                state.descriptorHeapSamplers == resources.samplerHeap.getShaderVisibleHeap();
+        }
+
+        return true;
+    }
+
+    bool CommandList::updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state)
+    {
+        std::vector<uint32_t>& dirtyRecords = shaderTable->dirtyRecords;
+        std::sort(dirtyRecords.begin(), dirtyRecords.end());
+        dirtyRecords.erase(std::unique(dirtyRecords.begin(), dirtyRecords.end()), dirtyRecords.end());
+
+        if (!dirtyRecords.empty())
+        {
+            uint32_t const entrySize = shaderTable->pipeline->getShaderTableEntrySize();
+
+            ID3D12Resource* uploadBuffer = nullptr;
+            uint64_t uploadOffset = 0;
+            uint8_t* uploadCpuVA = nullptr;
+            bool allocated = m_UploadManager.suballocateBuffer(dirtyRecords.size() * entrySize, nullptr, &uploadBuffer, &uploadOffset,
+                (void**)&uploadCpuVA, nullptr, m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+
+            if (!allocated)
+            {
+                m_Context.error("Couldn't suballocate an upload buffer");
+                return false;
+            }
+
+            for (size_t i = 0; i < dirtyRecords.size(); i++)
+            {
+                shaderTable->writeRecord(uploadCpuVA + i * entrySize, shaderTable->getRecord(dirtyRecords[i]), m_Resources);
+            }
+
+            setBufferState(shaderTable->cache, nvrhi::ResourceStates::CopyDest);
+            commitBarriers();
+
+            // Copy each run of consecutive records with a single copy
+            ID3D12Resource* cacheBuffer = shaderTable->cache->getNativeObject(nvrhi::ObjectTypes::D3D12_Resource);
+            size_t runStart = 0;
+            for (size_t i = 1; i <= dirtyRecords.size(); i++)
+            {
+                if (i < dirtyRecords.size() && dirtyRecords[i] == dirtyRecords[i - 1] + 1)
+                    continue;
+
+                m_ActiveCommandList->commandList->CopyBufferRegion(cacheBuffer, uint64_t(dirtyRecords[runStart]) * entrySize,
+                    uploadBuffer, uploadOffset + runStart * entrySize, (i - runStart) * entrySize);
+                runStart = i;
+            }
+
+            dirtyRecords.clear();
+        }
+
+        state.committedVersion = shaderTable->version;
+        return true;
+    }
     
     ShaderTableState& CommandList::getShaderTableState(rt::IShaderTable* _shaderTable)
     {
@@ -1675,7 +1996,14 @@ namespace nvrhi::d3d12
         ShaderTableState& shaderTableState = getShaderTableState(shaderTable);
         bool const rebuildShaderTable = !shaderTable->isStateValid(shaderTableState, m_Resources);
 
-        if (rebuildShaderTable)
+        if (rebuildShaderTable && shaderTable->canUpdateRecords(shaderTableState, m_Resources))
+        {
+            // Only some records were replaced since the cache was built, upload just those.
+
+            if (!updateShaderTableRecords(shaderTable, shaderTableState))
+                return;
+        }
+        else if (rebuildShaderTable)
         {
             size_t shaderTableSize = shaderTable->getUploadSize();
 
@@ -1757,11 +2085,12 @@ namespace nvrhi::d3d12
         if (updatePipeline)
         {
             m_ActiveCommandList->commandList4->SetPipelineState1(pso->pipelineState);
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
 
             m_Instance->referencedResources.push_back(pso);
         }
 
-        setComputeBindings(state.bindings, bindingUpdateMask, nullptr, false, pso->globalRootSignature);
+        setComputeBindings(state.bindings, bindingUpdateMask, nullptr, false, nullptr, false, pso->globalRootSignature);
 
         unbindShadingRateState();
 
@@ -1792,6 +2121,7 @@ namespace nvrhi::d3d12
         desc.Depth = args.depth;
 
         m_ActiveCommandList->commandList4->DispatchRays(&desc);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
     }
 
     void CommandList::buildOpacityMicromap([[maybe_unused]] rt::IOpacityMicromap* pOmm, [[maybe_unused]] const rt::OpacityMicromapDesc& desc)
@@ -1899,16 +2229,8 @@ namespace nvrhi::d3d12
 #endif
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandList::requireBottomLevelBuildInputStates(const rt::GeometryDesc* pGeometries, size_t numGeometries)
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
-
-        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
-        if (performUpdate)
-        {
-            assert(as->allowUpdate);
-        }
-
         for (uint32_t i = 0; i < numGeometries; i++)
         {
             const auto& geometryDesc = pGeometries[i];
@@ -1986,8 +2308,56 @@ namespace nvrhi::d3d12
         {
             m_BindingStatesDirty = true;
         }
+    }
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        requireBottomLevelBuildInputStates(pGeometries, numGeometries);
+        commitBarriers();
+
+        buildBottomLevelAccelStructInternal(as, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        // Transition the inputs and destinations of all builds first and commit them as one barrier batch.
+        // The builds below then find their resources in the right states and don't emit barriers in between,
+        // and their scratch ranges are packed into the same chunk by the linear suballocator.
+        // DXR has no multi-build command, but back-to-back builds without barriers can overlap on the GPU.
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& desc = pBuilds[i];
+
+            requireBottomLevelBuildInputStates(desc.geometries, desc.numGeometries);
+
+#ifndef NVRHI_WITH_RTXMU
+            if (m_EnableAutomaticBarriers)
+            {
+                AccelStruct* as = checked_cast<AccelStruct*>(desc.accelStruct);
+                requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            }
+#endif
+        }
         commitBarriers();
 
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& desc = pBuilds[i];
+
+            buildBottomLevelAccelStructInternal(checked_cast<AccelStruct*>(desc.accelStruct), desc.geometries, desc.numGeometries, desc.buildFlags);
+        }
+    }
+
+    void CommandList::buildBottomLevelAccelStructInternal(AccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+        if (performUpdate)
+        {
+            assert(as->allowUpdate);
+        }
+
         D3D12BuildRaytracingAccelerationStructureInputs inputs;
         inputs.SetType(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL);
         if (as->allowUpdate)
@@ -2097,6 +2467,26 @@ namespace nvrhi::d3d12
             return;
         }
 
+        // Request the compacted size, which is read back when the command list is retired,
+        // so that compactBottomLevelAccelStructs() can copy the BLAS into pooled storage later
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfo = {};
+        const bool queryCompactedSize = (buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0 && !performUpdate;
+        const int compactedSizeQuery = queryCompactedSize ? allocateCompactedSizeQuery() : -1;
+        if (compactedSizeQuery >= 0)
+        {
+            Buffer* compactedSizeBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeBuffer.Get());
+
+            // The queries write to different locations, so they don't need UAV barriers between them
+            m_StateTracker.setEnableUavBarriersForBuffer(compactedSizeBuffer, false);
+            requireBufferState(compactedSizeBuffer, nvrhi::ResourceStates::UnorderedAccess);
+
+            postbuildInfo.DestBuffer = compactedSizeBuffer->gpuVA + uint64_t(compactedSizeQuery) * sizeof(uint64_t);
+            postbuildInfo.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+
+            m_Instance->compactedSizeQueries.push_back({ as, compactedSizeQuery });
+        }
+        const UINT numPostbuildInfoDescs = (compactedSizeQuery >= 0) ? 1 : 0;
+
         if (m_EnableAutomaticBarriers)
         {
             requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
@@ -2117,8 +2507,8 @@ namespace nvrhi::d3d12
             NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS params = {};
             params.version = NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS_VER;
             params.pDesc = &buildDesc;
-            params.numPostbuildInfoDescs = 0;
-            params.pPostbuildInfoDescs = nullptr;
+            params.numPostbuildInfoDescs = numPostbuildInfoDescs;
+            params.pPostbuildInfoDescs = numPostbuildInfoDescs ? &postbuildInfo : nullptr;
             [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingAccelerationStructureEx(m_ActiveCommandList->commandList4, &params);
             assert(status == S_OK);
         }
@@ -2130,7 +2520,8 @@ namespace nvrhi::d3d12
             buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
             buildDesc.DestAccelerationStructureData = as->dataBuffer->gpuVA;
             buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
-            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc,
+                numPostbuildInfoDescs, numPostbuildInfoDescs ? &postbuildInfo : nullptr);
         }
 #endif // NVRHI_WITH_RTXMU
 
@@ -2138,6 +2529,73 @@ namespace nvrhi::d3d12
             m_Instance->referencedResources.push_back(as);
     }
 
+#ifndef NVRHI_WITH_RTXMU
+    int CommandList::allocateCompactedSizeQuery()
+    {
+        {
+            std::lock_guard lockGuard(m_Resources.compactionMutex);
+
+            if (!m_Resources.compactedSizeBuffer)
+            {
+                BufferDesc bufferDesc;
+                bufferDesc.byteSize = uint64_t(c_MaxCompactedSizeQueries) * sizeof(uint64_t);
+                bufferDesc.canHaveUAVs = true;
+                bufferDesc.initialState = ResourceStates::UnorderedAccess;
+                bufferDesc.keepInitialState = true;
+                bufferDesc.debugName = "BLAS compacted sizes";
+                m_Resources.compactedSizeBuffer = m_Device->createBuffer(bufferDesc);
+
+                bufferDesc.canHaveUAVs = false;
+                bufferDesc.cpuAccess = CpuAccessMode::Read;
+                bufferDesc.initialState = ResourceStates::CopyDest;
+                bufferDesc.debugName = "BLAS compacted sizes readback";
+                m_Resources.compactedSizeReadbackBuffer = m_Device->createBuffer(bufferDesc);
+            }
+
+            if (!m_Resources.compactedSizeBuffer || !m_Resources.compactedSizeReadbackBuffer)
+                return -1;
+        }
+
+        const int query = m_Resources.compactedSizeQueries.allocate();
+        if (query < 0)
+        {
+            std::stringstream ss;
+            ss << "Too many BLAS builds with AllowCompaction are in flight (the limit is " << c_MaxCompactedSizeQueries
+                << "), the BLAS will not be compacted";
+            m_Context.messageCallback->message(MessageSeverity::Warning, ss.str().c_str());
+        }
+
+        return query;
+    }
+
+    void CommandList::copyCompactedSizesToReadback()
+    {
+        Buffer* compactedSizeBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeBuffer.Get());
+        Buffer* readbackBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeReadbackBuffer.Get());
+
+        requireBufferState(compactedSizeBuffer, nvrhi::ResourceStates::CopySource);
+        commitBarriers();
+
+        // The slots of one command list are not necessarily contiguous, and the other slots may be
+        // written by command lists in flight, so copy only the slots used here
+        for (const auto& query : m_Instance->compactedSizeQueries)
+        {
+            const uint64_t offset = uint64_t(query.index) * sizeof(uint64_t);
+            m_ActiveCommandList->commandList->CopyBufferRegion(readbackBuffer->resource, offset,
+                compactedSizeBuffer->resource, offset, sizeof(uint64_t));
+        }
+    }
+
+    void CommandList::releaseCompactedSizeQueries()
+    {
+        for (const auto& query : m_Instance->compactedSizeQueries)
+            m_Resources.compactedSizeQueries.release(query.index);
+
+        m_Instance->compactedSizeQueries.clear();
+    }
+#endif
+
+
     void CommandList::compactBottomLevelAccelStructs()
     {
 #ifdef NVRHI_WITH_RTXMU
@@ -2155,6 +2613,147 @@ namespace nvrhi::d3d12
                 m_Resources.asBuildsCompleted.clear();
             }
         }
+#else
+        std::vector<rt::AccelStructHandle> ready;
+        {
+            std::lock_guard lockGuard(m_Resources.compactionMutex);
+            ready.swap(m_Resources.compactionsReady);
+        }
+
+        if (ready.empty())
+            return;
+
+        struct Compaction
+        {
+            AccelStruct* as;
+            BufferHandle storage;
+            uint64_t offset;
+        };
+        std::vector<Compaction> compactions;
+        compactions.reserve(ready.size());
+
+        for (const auto& handle : ready)
+        {
+            AccelStruct* as = checked_cast<AccelStruct*>(handle.Get());
+
+            if (as->compacted || as->compactedSize == 0)
+                continue;
+
+            Compaction compaction{ as, nullptr, 0 };
+            if (!m_Resources.compactedStorage->allocate(as->compactedSize, compaction.storage, compaction.offset))
+            {
+                std::stringstream ss;
+                ss << "Couldn't allocate " << as->compactedSize << " bytes of pooled storage to compact BLAS "
+                    << utils::DebugNameToString(as->desc.debugName);
+                m_Context.error(ss.str());
+                continue;
+            }
+
+            // These are internal transitions that the application cannot do by itself
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+            requireBufferState(compaction.storage, nvrhi::ResourceStates::AccelStructWrite);
+
+            compactions.push_back(compaction);
+        }
+        commitBarriers();
+
+        for (const Compaction& compaction : compactions)
+        {
+            AccelStruct* as = compaction.as;
+            Buffer* storage = checked_cast<Buffer*>(compaction.storage.Get());
+
+            m_ActiveCommandList->commandList4->CopyRaytracingAccelerationStructure(storage->gpuVA + compaction.offset,
+                as->dataBuffer->gpuVA, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+            // Keep the original storage alive until the copy is finished, then it is released
+            m_Instance->referencedResources.push_back(as->dataBuffer);
+            m_Instance->referencedResources.push_back(as);
+
+            as->dataBuffer = storage;
+            as->dataOffset = compaction.offset;
+            as->storagePool = m_Resources.compactedStorage.get();
+            as->compacted = true;
+        }
+
+        m_BindingStatesDirty = true;
+#endif
+    }
+
+    void CommandList::writeAccelStructSerializedSize(rt::IAccelStruct* _as, IBuffer* _buffer, uint64_t offset)
+    {
+#ifdef NVRHI_WITH_RTXMU
+        (void)_as;
+        (void)_buffer;
+        (void)offset;
+        m_Context.error("writeAccelStructSerializedSize is not supported when NVRHI is built with RTXMU");
+#else
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        // The post-build info can only be written after the build has finished
+        requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+        requireBufferState(buffer, nvrhi::ResourceStates::UnorderedAccess);
+        commitBarriers();
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfo = {};
+        postbuildInfo.DestBuffer = buffer->gpuVA + offset;
+        postbuildInfo.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION;
+
+        D3D12_GPU_VIRTUAL_ADDRESS const sourceAddress = as->getDeviceAddress();
+        m_ActiveCommandList->commandList4->EmitRaytracingAccelerationStructurePostbuildInfo(&postbuildInfo, 1, &sourceAddress);
+
+        m_Instance->referencedResources.push_back(as);
+        m_Instance->referencedResources.push_back(buffer);
+#endif
+    }
+
+    void CommandList::serializeAccelStruct(rt::IAccelStruct* _as, IBuffer* _buffer, uint64_t offset)
+    {
+#ifdef NVRHI_WITH_RTXMU
+        (void)_as;
+        (void)_buffer;
+        (void)offset;
+        m_Context.error("serializeAccelStruct is not supported when NVRHI is built with RTXMU");
+#else
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+        requireBufferState(buffer, nvrhi::ResourceStates::UnorderedAccess);
+        commitBarriers();
+
+        m_ActiveCommandList->commandList4->CopyRaytracingAccelerationStructure(buffer->gpuVA + offset,
+            as->getDeviceAddress(), D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE);
+
+        m_Instance->referencedResources.push_back(as);
+        m_Instance->referencedResources.push_back(buffer);
+#endif
+    }
+
+    void CommandList::deserializeAccelStruct(rt::IAccelStruct* _as, IBuffer* _buffer, uint64_t offset)
+    {
+#ifdef NVRHI_WITH_RTXMU
+        (void)_as;
+        (void)_buffer;
+        (void)offset;
+        m_Context.error("deserializeAccelStruct is not supported when NVRHI is built with RTXMU");
+#else
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+        requireBufferState(buffer, nvrhi::ResourceStates::AccelStructBuildInput);
+        commitBarriers();
+
+        m_ActiveCommandList->commandList4->CopyRaytracingAccelerationStructure(as->getDeviceAddress(),
+            buffer->gpuVA + offset, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE);
+
+        m_Instance->referencedResources.push_back(as);
+        m_Instance->referencedResources.push_back(buffer);
+
+        // A compaction that is pending for an earlier build of this BLAS would copy the wrong data
+        as->compactedSize = 0;
+        m_BindingStatesDirty = true;
 #endif
     }
 
@@ -2168,7 +2767,7 @@ namespace nvrhi::d3d12
         if (performUpdate)
         {
             assert(as->allowUpdate);
-            assert(as->dxrInstances.size() == numInstances); // DXR doesn't allow updating to a different instance count
+            assert(as->builtInstanceCount == numInstances); // DXR doesn't allow updating to a different instance count
         }
 
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS ASInputs;
@@ -2217,6 +2816,8 @@ namespace nvrhi::d3d12
         buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
 
         m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+
+        as->builtInstanceCount = numInstances;
     }
 
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -2248,7 +2849,7 @@ namespace nvrhi::d3d12
 #ifdef NVRHI_WITH_RTXMU
                 dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
 #else
-                dxrInstance.AccelerationStructure = blas->dataBuffer->gpuVA;
+                dxrInstance.AccelerationStructure = blas->getDeviceAddress();
 
                 if (m_EnableAutomaticBarriers)
                 {
@@ -2313,6 +2914,127 @@ namespace nvrhi::d3d12
             m_Instance->referencedResources.push_back(as);
     }
 
+    void CommandList::updateTopLevelInstances(rt::IAccelStruct* _as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (!as->instanceBuffer)
+        {
+            std::stringstream ss;
+            ss << "TLAS " << utils::DebugNameToString(as->desc.debugName) << " was not created with a persistent instance buffer";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        if (numInstances == 0)
+            return;
+
+        // Only the updated range is converted and uploaded, the rest of the instance buffer remains unchanged
+        as->dxrInstances.resize(numInstances);
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            const rt::InstanceDesc& instance = pInstances[i];
+            D3D12_RAYTRACING_INSTANCE_DESC& dxrInstance = as->dxrInstances[i];
+
+            static_assert(sizeof(dxrInstance) == sizeof(instance));
+            memcpy(&dxrInstance, &instance, sizeof(instance));
+
+            AccelStruct* blas = checked_cast<AccelStruct*>(instance.bottomLevelAS);
+
+            if (blas)
+            {
+#ifdef NVRHI_WITH_RTXMU
+                dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
+#else
+                dxrInstance.AccelerationStructure = blas->getDeviceAddress();
+
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+                }
+#endif
+            }
+            else
+            {
+                dxrInstance.AccelerationStructure = 0;
+            }
+
+            if (!as->instanceBufferBLASes.empty())
+            {
+                as->instanceBufferBLASes[firstInstance + i] = (blas && blas->desc.trackLiveness) ? blas : nullptr;
+            }
+        }
+
+        writeBuffer(as->instanceBuffer, as->dxrInstances.data(), sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * numInstances,
+            sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * uint64_t(firstInstance));
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.push_back(as);
+    }
+
+    rt::IndirectInstanceDesc* CommandList::allocateTopLevelInstances(size_t numInstances)
+    {
+        static_assert(sizeof(rt::IndirectInstanceDesc) == sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+
+        void* cpuVA = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
+        if (!m_UploadManager.suballocateBuffer(sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * numInstances, nullptr, nullptr, nullptr,
+            &cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_INSTANCE_DESCS_BYTE_ALIGNMENT))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer for TLAS instances");
+            return nullptr;
+        }
+
+        TopLevelInstanceAllocation allocation;
+        allocation.cpuVA = static_cast<rt::IndirectInstanceDesc*>(cpuVA);
+        allocation.gpuVA = gpuVA;
+        allocation.numInstances = numInstances;
+        m_TopLevelInstanceAllocations.push_back(allocation);
+
+        return static_cast<rt::IndirectInstanceDesc*>(cpuVA);
+    }
+
+    void CommandList::buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* _as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        // Find the allocation that contains the instances to get their GPU address
+        D3D12_GPU_VIRTUAL_ADDRESS instanceData = 0;
+        for (const TopLevelInstanceAllocation& allocation : m_TopLevelInstanceAllocations)
+        {
+            if (pInstances >= allocation.cpuVA && pInstances + numInstances <= allocation.cpuVA + allocation.numInstances)
+            {
+                instanceData = allocation.gpuVA + (pInstances - allocation.cpuVA) * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+                break;
+            }
+        }
+
+        if (!instanceData && numInstances != 0)
+        {
+            std::stringstream ss;
+            ss << "The instances for TLAS " << utils::DebugNameToString(as->desc.debugName) << " build were not allocated "
+                "with allocateTopLevelInstances on this command list";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        as->bottomLevelASes.clear();
+        as->dxrInstances.clear();
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        buildTopLevelAccelStructInternal(as, instanceData, numInstances, buildFlags);
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.push_back(as);
+    }
+
 
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
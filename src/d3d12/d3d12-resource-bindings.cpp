@@ -23,6 +23,7 @@
 #include "d3d12-backend.h"
 
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -65,8 +66,28 @@ namespace nvrhi::d3d12
 
         return false;
     }
+
+    // Returns the root parameter type used for an item of a push layout,
+    // or D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE if the item cannot be a root descriptor
+    static D3D12_ROOT_PARAMETER_TYPE GetRootParameterTypeForPushDescriptor(ResourceType type)
+    {
+        switch (type)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case ResourceType::ConstantBuffer:
+            return D3D12_ROOT_PARAMETER_TYPE_CBV;
+        case ResourceType::StructuredBuffer_SRV:
+        case ResourceType::RawBuffer_SRV:
+        case ResourceType::RayTracingAccelStruct:
+            return D3D12_ROOT_PARAMETER_TYPE_SRV;
+        case ResourceType::StructuredBuffer_UAV:
+        case ResourceType::RawBuffer_UAV:
+            return D3D12_ROOT_PARAMETER_TYPE_UAV;
+        default:
+            return D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        }
+    }
     
-    void BindingSet::createDescriptors()
+    void BindingSet::createDescriptors(TransientDescriptorArena* arenaSRVetc, TransientDescriptorArena* arenaSamplers)
     {
         // Process the volatile constant buffers: they occupy one root parameter each
         for (const std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>& parameter : layout->rootParametersVolatileCB)
@@ -93,9 +114,70 @@ namespace nvrhi::d3d12
             rootParametersVolatileCB.push_back(std::make_pair(rootParameterIndex, foundBuffer));
         }
 
+        // Process the root descriptors of push layouts, one root parameter each
+        for (const BindingLayout::RootDescriptorBinding& parameter : layout->rootParametersPushDescriptors)
+        {
+            D3D12_GPU_VIRTUAL_ADDRESS address = 0;
+
+            for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
+            {
+                const BindingSetItem& binding = desc.bindings[bindingIndex];
+
+                if (binding.type != parameter.resourceType || binding.slot != parameter.descriptor.ShaderRegister || !binding.resourceHandle)
+                    continue;
+
+                if (binding.type == ResourceType::RayTracingAccelStruct)
+                {
+                    AccelStruct* accelStruct = checked_cast<AccelStruct*>(binding.resourceHandle);
+                    resources.push_back(accelStruct);
+                    address = accelStruct->dataBuffer->gpuVA;
+
+                    bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                    break;
+                }
+
+                Buffer* buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                resources.push_back(buffer);
+
+                if (buffer->desc.isVolatile)
+                {
+                    std::stringstream ss;
+                    ss << "Attempted to bind a volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                        << " to a push descriptor layout at slot b" << binding.slot;
+                    m_Context.error(ss.str());
+                    break;
+                }
+
+                const BufferRange range = binding.range.resolve(buffer->desc);
+                address = buffer->gpuVA + range.byteOffset;
+
+                const bool isUAV = (parameter.parameterType == D3D12_ROOT_PARAMETER_TYPE_UAV);
+                const ResourceStates requiredState = isUAV
+                    ? ResourceStates::UnorderedAccess
+                    : (parameter.parameterType == D3D12_ROOT_PARAMETER_TYPE_CBV)
+                        ? ResourceStates::ConstantBuffer
+                        : ResourceStates::ShaderResource;
+
+                if (!buffer->permanentState)
+                    bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(buffer->permanentState, requiredState,
+                        false, buffer->desc.debugName, m_Context.messageCallback);
+
+                if (isUAV)
+                    hasUavBindings = true;
+                break;
+            }
+
+            // Like with volatile CBs, bind something to the root parameter even if the binding is missing
+            rootParametersPushDescriptors.push_back(std::make_pair(parameter.rootParameter, address));
+        }
+
         if (layout->descriptorTableSizeSamplers > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.samplerHeap.allocateDescriptors(layout->descriptorTableSizeSamplers);
+            DescriptorIndex descriptorTableBaseIndex = arenaSamplers
+                ? arenaSamplers->allocate(layout->descriptorTableSizeSamplers)
+                : m_Resources.samplerHeap.allocateDescriptors(layout->descriptorTableSizeSamplers);
             descriptorTableSamplers = descriptorTableBaseIndex;
             rootParameterIndexSamplers = layout->rootParameterSamplers;
             descriptorTableValidSamplers = true;
@@ -136,7 +218,9 @@ namespace nvrhi::d3d12
 
         if (layout->descriptorTableSizeSRVetc > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.shaderResourceViewHeap.allocateDescriptors(layout->descriptorTableSizeSRVetc);
+            DescriptorIndex descriptorTableBaseIndex = arenaSRVetc
+                ? arenaSRVetc->allocate(layout->descriptorTableSizeSRVetc)
+                : m_Resources.shaderResourceViewHeap.allocateDescriptors(layout->descriptorTableSizeSRVetc);
             descriptorTableSRVetc = descriptorTableBaseIndex;
             rootParameterIndexSRVetc = layout->rootParameterSRVetc;
             descriptorTableValidSRVetc = true;
@@ -338,12 +422,25 @@ namespace nvrhi::d3d12
 
             m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTableBaseIndex, layout->descriptorTableSizeSRVetc);
         }
+
+        buildRequiredStates();
     }
 
     BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
     {
+        if (m_InternedStates)
+        {
+            if (BindingLayoutHandle existing = m_InternedStates->bindingLayouts.find(desc))
+                return existing;
+        }
+
         BindingLayout* ret = new BindingLayout(desc);
-        return BindingLayoutHandle::Create(ret);
+        BindingLayoutHandle layoutHandle = BindingLayoutHandle::Create(ret);
+
+        if (m_InternedStates)
+            return m_InternedStates->bindingLayouts.insert(desc, ret, ret->internEntry);
+
+        return layoutHandle;
     }
 
     BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
@@ -354,6 +451,8 @@ namespace nvrhi::d3d12
 
     BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
     {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
         BindingSet *ret = new BindingSet(m_Context, m_Resources);
         ret->desc = desc;
 
@@ -376,8 +475,63 @@ namespace nvrhi::d3d12
         return DescriptorTableHandle::Create(ret);
     }
 
+    IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        if (!m_Instance->transientDescriptorsSRVetc)
+        {
+            m_Instance->transientDescriptorsSRVetc = std::make_unique<TransientDescriptorArena>(
+                m_Resources.shaderResourceViewHeap, c_TransientDescriptorChunkSizeSRVetc);
+            m_Instance->transientDescriptorsSamplers = std::make_unique<TransientDescriptorArena>(
+                m_Resources.samplerHeap, c_TransientDescriptorChunkSizeSamplers);
+        }
+
+        BindingSet* bindingSet = new BindingSet(m_Context, m_Resources);
+        bindingSet->desc = desc;
+        bindingSet->layout = layout;
+        bindingSet->transient = true;
+
+        bindingSet->createDescriptors(m_Instance->transientDescriptorsSRVetc.get(), m_Instance->transientDescriptorsSamplers.get());
+        NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, desc.bindings.size());
+
+        m_Instance->transientBindingSets.push_back(RefCountPtr<BindingSet>::Create(bindingSet));
+
+        return bindingSet;
+    }
+
+    TransientDescriptorArena::~TransientDescriptorArena()
+    {
+        for (const auto& [baseIndex, count] : m_Chunks)
+            m_Heap.releaseDescriptors(baseIndex, count);
+    }
+
+    DescriptorIndex TransientDescriptorArena::allocate(uint32_t count)
+    {
+        if (count > m_RemainingDescriptors)
+        {
+            // Descriptor tables cannot span chunks, so the rest of the current chunk is wasted
+            uint32_t const chunkSize = std::max(count, m_ChunkSize);
+            DescriptorIndex const chunk = m_Heap.allocateDescriptors(chunkSize);
+            m_Chunks.push_back(std::make_pair(chunk, chunkSize));
+
+            m_NextDescriptor = chunk;
+            m_RemainingDescriptors = chunkSize;
+        }
+
+        DescriptorIndex const result = m_NextDescriptor;
+        m_NextDescriptor += count;
+        m_RemainingDescriptors -= count;
+        return result;
+    }
+
     BindingSet::~BindingSet()
     {
+        if (transient)
+            return;
+
         m_Resources.shaderResourceViewHeap.releaseDescriptors(descriptorTableSRVetc, layout->descriptorTableSizeSRVetc);
     
         m_Resources.samplerHeap.releaseDescriptors(descriptorTableSamplers, layout->descriptorTableSizeSamplers);
@@ -420,6 +574,17 @@ namespace nvrhi::d3d12
                 rootConstants.RegisterSpace = desc.registerSpace;
                 rootConstants.Num32BitValues = binding.size / 4;
             }
+            else if (desc.usePushDescriptors && binding.size == 1 && GetRootParameterTypeForPushDescriptor(binding.type) != D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE
+                && rootParametersPushDescriptors.size() < c_MaxPushDescriptorsPerLayout)
+            {
+                BindingLayout::RootDescriptorBinding& rootDescriptor = rootParametersPushDescriptors.emplace_back();
+                rootDescriptor.parameterType = GetRootParameterTypeForPushDescriptor(binding.type);
+                rootDescriptor.descriptor.ShaderRegister = binding.slot;
+                rootDescriptor.descriptor.RegisterSpace = desc.registerSpace;
+                // Same as the descriptor tables, the resources may be written between binding and use
+                rootDescriptor.descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE;
+                rootDescriptor.resourceType = binding.type;
+            }
             else if (!AreResourceTypesCompatible(binding.type, currentType) || binding.slot != currentSlot + 1)
             {
                 // Start a new range
@@ -546,6 +711,17 @@ namespace nvrhi::d3d12
             rootParameterVolatileCB.first = RootParameterIndex(rootParameters.size() - 1);
         }
 
+        for (RootDescriptorBinding& rootDescriptor : rootParametersPushDescriptors)
+        {
+            D3D12_ROOT_PARAMETER1& param = rootParameters.emplace_back();
+
+            param.ParameterType = rootDescriptor.parameterType;
+            param.ShaderVisibility = convertShaderStage(desc.visibility);
+            param.Descriptor = rootDescriptor.descriptor;
+
+            rootDescriptor.rootParameter = RootParameterIndex(rootParameters.size() - 1);
+        }
+
         if (descriptorTableSizeSamplers > 0)
         {
             rootParameters.resize(rootParameters.size() + 1);
@@ -751,6 +927,8 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        rootsig->serializedHash = hash_bytes(rsBlob->GetBufferPointer(), rsBlob->GetBufferSize());
+
         // Create the RS object
 
         res = m_Context.device->CreateRootSignature(0, rsBlob->GetBufferPointer(), rsBlob->GetBufferSize(), IID_PPV_ARGS(&rootsig->handle));
@@ -776,6 +954,8 @@ namespace nvrhi::d3d12
         
         hash_combine(hash, allowInputLayout ? 1u : 0u);
         
+        std::lock_guard lockGuard(m_Resources.rootsigCacheMutex);
+
         // Get a cached RS and AddRef it (if it exists)
         RefCountPtr<RootSignature> rootsig = m_Resources.rootsigCache[hash];
 
@@ -794,16 +974,16 @@ namespace nvrhi::d3d12
 
     RootSignature::~RootSignature()
     {
+        std::lock_guard lockGuard(m_Resources.rootsigCacheMutex);
+
         // Remove the root signature from the cache
         const auto it = m_Resources.rootsigCache.find(hash);
-        if (it != m_Resources.rootsigCache.end())
+        if (it != m_Resources.rootsigCache.end() && it->second == this)
             m_Resources.rootsigCache.erase(it);
     }
 
-    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& binding)
+    bool Device::createDescriptorTableItem(DescriptorTable* descriptorTable, const BindingSetItem& binding)
     {
-        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
-
         if (binding.slot >= descriptorTable->capacity)
             return false;
 
@@ -866,10 +1046,59 @@ namespace nvrhi::d3d12
             return false;
         }
 
+        return true;
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& binding)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (!createDescriptorTableItem(descriptorTable, binding))
+            return false;
+
         m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTable->firstDescriptor + binding.slot, 1);
         return true;
     }
 
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem* items, uint32_t numItems)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        bool success = true;
+
+        // Copy runs of consecutive slots into the shader visible heap with one call each
+        uint32_t runStart = 0;
+        uint32_t runLength = 0;
+
+        for (uint32_t index = 0; index < numItems; index++)
+        {
+            const BindingSetItem& binding = items[index];
+
+            if (!createDescriptorTableItem(descriptorTable, binding))
+            {
+                success = false;
+                continue;
+            }
+
+            if (runLength > 0 && binding.slot == runStart + runLength)
+            {
+                ++runLength;
+                continue;
+            }
+
+            if (runLength > 0)
+                m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTable->firstDescriptor + runStart, runLength);
+
+            runStart = binding.slot;
+            runLength = 1;
+        }
+
+        if (runLength > 0)
+            m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTable->firstDescriptor + runStart, runLength);
+
+        return success;
+    }
+
     void Device::resizeDescriptorTable(IDescriptorTable* _descriptorTable, uint32_t newSize, bool keepContents)
     {
         DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
@@ -913,6 +1142,7 @@ namespace nvrhi::d3d12
     void CommandList::setComputeBindings(
         const BindingSetVector& bindings, uint32_t bindingUpdateMask,
         IBuffer* indirectParams, bool updateIndirectParams,
+        IBuffer* indirectCountBuffer, bool updateIndirectCountBuffer,
         const RootSignature* rootSignature)
     {
         if (bindingUpdateMask)
@@ -964,6 +1194,7 @@ namespace nvrhi::d3d12
                                 if (updateThisSet || volatileData != m_CurrentComputeVolatileCBs[newVolatileCBs.size()].address)
                                 {
                                     m_ActiveCommandList->commandList->SetComputeRootConstantBufferView(rootParameterIndex, volatileData);
+                                    NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, 1);
                                 }
 
                                 newVolatileCBs.push_back(VolatileConstantBufferBinding{ rootParameterIndex, buffer, volatileData });
@@ -985,6 +1216,32 @@ namespace nvrhi::d3d12
 
                     if (updateThisSet)
                     {
+                        NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
+                        NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, bindingSet->rootParametersPushDescriptors.size());
+
+                        // Bind the buffers and acceleration structures of push layouts
+                        for (size_t pushIndex = 0; pushIndex < bindingSet->rootParametersPushDescriptors.size(); pushIndex++)
+                        {
+                            const auto& parameter = bindingSet->rootParametersPushDescriptors[pushIndex];
+                            RootParameterIndex rootParameterIndex = rootParameterOffset + parameter.first;
+
+                            switch (bindingSet->layout->rootParametersPushDescriptors[pushIndex].parameterType)  // NOLINT(clang-diagnostic-switch-enum)
+                            {
+                            case D3D12_ROOT_PARAMETER_TYPE_CBV:
+                                m_ActiveCommandList->commandList->SetComputeRootConstantBufferView(rootParameterIndex, parameter.second);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_SRV:
+                                m_ActiveCommandList->commandList->SetComputeRootShaderResourceView(rootParameterIndex, parameter.second);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_UAV:
+                                m_ActiveCommandList->commandList->SetComputeRootUnorderedAccessView(rootParameterIndex, parameter.second);
+                                break;
+                            default:
+                                utils::InvalidEnum();
+                                break;
+                            }
+                        }
+
                         if (bindingSet->descriptorTableValidSamplers)
                         {
                             m_ActiveCommandList->commandList->SetComputeRootDescriptorTable(
@@ -1000,7 +1257,7 @@ namespace nvrhi::d3d12
                         }
 
                         if (bindingSet->desc.trackLiveness)
-                            m_Instance->referencedResources.push_back(bindingSet);
+                            referenceResource(bindingSet);
                     }
 
                     if (m_EnableAutomaticBarriers && (m_BindingStatesDirty || updateThisSet || bindingSet->hasUavBindings)) // UAV bindings may place UAV barriers on the same binding set
@@ -1013,6 +1270,7 @@ namespace nvrhi::d3d12
                     DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_bindingSet);
 
                     m_ActiveCommandList->commandList->SetComputeRootDescriptorTable(rootParameterOffset, m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorTable->firstDescriptor));
+                    NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
                 }
             }
 
@@ -1025,7 +1283,16 @@ namespace nvrhi::d3d12
             {
                 requireBufferState(indirectParams, ResourceStates::IndirectArgument);
             }
-            m_Instance->referencedResources.push_back(indirectParams);
+            referenceResource(checked_cast<Buffer*>(indirectParams));
+        }
+
+        if (indirectCountBuffer && updateIndirectCountBuffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+            referenceResource(checked_cast<Buffer*>(indirectCountBuffer));
         }
 
         uint32_t bindingMask = (1 << uint32_t(bindings.size())) - 1;
@@ -1091,6 +1358,7 @@ namespace nvrhi::d3d12
                                 if (updateThisSet || volatileData != m_CurrentGraphicsVolatileCBs[newVolatileCBs.size()].address)
                                 {
                                     m_ActiveCommandList->commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, volatileData);
+                                    NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, 1);
                                 }
 
                                 newVolatileCBs.push_back(VolatileConstantBufferBinding{ rootParameterIndex, buffer, volatileData });
@@ -1112,6 +1380,32 @@ namespace nvrhi::d3d12
 
                     if (updateThisSet)
                     {
+                        NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
+                        NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, bindingSet->rootParametersPushDescriptors.size());
+
+                        // Bind the buffers and acceleration structures of push layouts
+                        for (size_t pushIndex = 0; pushIndex < bindingSet->rootParametersPushDescriptors.size(); pushIndex++)
+                        {
+                            const auto& parameter = bindingSet->rootParametersPushDescriptors[pushIndex];
+                            RootParameterIndex rootParameterIndex = rootParameterOffset + parameter.first;
+
+                            switch (bindingSet->layout->rootParametersPushDescriptors[pushIndex].parameterType)  // NOLINT(clang-diagnostic-switch-enum)
+                            {
+                            case D3D12_ROOT_PARAMETER_TYPE_CBV:
+                                m_ActiveCommandList->commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, parameter.second);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_SRV:
+                                m_ActiveCommandList->commandList->SetGraphicsRootShaderResourceView(rootParameterIndex, parameter.second);
+                                break;
+                            case D3D12_ROOT_PARAMETER_TYPE_UAV:
+                                m_ActiveCommandList->commandList->SetGraphicsRootUnorderedAccessView(rootParameterIndex, parameter.second);
+                                break;
+                            default:
+                                utils::InvalidEnum();
+                                break;
+                            }
+                        }
+
                         if (bindingSet->descriptorTableValidSamplers)
                         {
                             m_ActiveCommandList->commandList->SetGraphicsRootDescriptorTable(
@@ -1127,7 +1421,7 @@ namespace nvrhi::d3d12
                         }
 
                         if (bindingSet->desc.trackLiveness)
-                            m_Instance->referencedResources.push_back(bindingSet);
+                            referenceResource(bindingSet);
                     }
 
                     if (m_EnableAutomaticBarriers && (m_BindingStatesDirty || updateThisSet || bindingSet->hasUavBindings)) // UAV bindings may place UAV barriers on the same binding set
@@ -1140,6 +1434,7 @@ namespace nvrhi::d3d12
                     DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_bindingSet);
 
                     m_ActiveCommandList->commandList->SetGraphicsRootDescriptorTable(rootParameterOffset, m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorTable->firstDescriptor));
+                    NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
                 }
             }
 
@@ -1152,7 +1447,7 @@ namespace nvrhi::d3d12
             {
                 requireBufferState(indirectParams, ResourceStates::IndirectArgument);
             }
-            m_Instance->referencedResources.push_back(indirectParams);
+            referenceResource(checked_cast<Buffer*>(indirectParams));
         }
 
         if (indirectCountBuffer && updateIndirectCountBuffer)
@@ -1161,7 +1456,7 @@ namespace nvrhi::d3d12
             {
                 requireBufferState(indirectCountBuffer, ResourceStates::IndirectArgument);
             }
-            m_Instance->referencedResources.push_back(indirectCountBuffer);
+            referenceResource(checked_cast<Buffer*>(indirectCountBuffer));
         }
 
         uint32_t bindingMask = (1 << uint32_t(bindings.size())) - 1;
@@ -68,6 +68,15 @@ namespace nvrhi::d3d12
         if (binarySize == 0)
             return nullptr;
 
+        const bool useCache = m_ShaderCache && ShaderCache::isCacheable(d);
+        uint64_t cacheKey = 0;
+        if (useCache)
+        {
+            cacheKey = ShaderCache::getKey(d, binary, binarySize);
+            if (ShaderHandle cachedShader = m_ShaderCache->find(cacheKey, d, binary, binarySize))
+                return cachedShader;
+        }
+
         Shader* shader = new Shader();
         shader->bytecode.resize(binarySize);
         shader->desc = d;
@@ -211,8 +220,13 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 #endif
+
+        ShaderHandle shaderHandle = ShaderHandle::Create(shader);
+
+        if (useCache)
+            return m_ShaderCache->insert(cacheKey, d, binary, binarySize, shaderHandle);
         
-        return ShaderHandle::Create(shader);
+        return shaderHandle;
     }
     
     ShaderHandle Device::createShaderSpecialization(IShader*, const ShaderSpecialization*, uint32_t)
@@ -236,6 +250,14 @@ namespace nvrhi::d3d12
         // The shader is not needed here, there are no separate IL objects in DX12
         (void)vertexShader;
 
+        std::vector<VertexAttributeDesc> internKey;
+        if (m_InternedStates)
+        {
+            internKey.assign(d, d + attributeCount);
+            if (InputLayoutHandle existing = m_InternedStates->inputLayouts.find(internKey))
+                return existing;
+        }
+
         InputLayout* layout = new InputLayout();
         layout->attributes.resize(attributeCount);
 
@@ -283,7 +305,12 @@ namespace nvrhi::d3d12
             }
         }
 
-        return InputLayoutHandle::Create(layout);
+        InputLayoutHandle layoutHandle = InputLayoutHandle::Create(layout);
+
+        if (m_InternedStates)
+            return m_InternedStates->inputLayouts.insert(internKey, layout, layout->internEntry);
+
+        return layoutHandle;
     }
 
     uint32_t InputLayout::getNumAttributes() const
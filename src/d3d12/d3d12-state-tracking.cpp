@@ -27,53 +27,73 @@
 
 namespace nvrhi::d3d12
 {
-    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    void BindingSet::buildRequiredStates()
     {
-        if (_bindingSet->getDesc() == nullptr)
-            return; // is bindless
+        requiredStates.clear();
+        requiredStates.reserve(bindingsThatNeedTransitions.size());
 
-        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
-
-        for (auto bindingIndex : bindingSet->bindingsThatNeedTransitions)
+        for (auto bindingIndex : bindingsThatNeedTransitions)
         {
-            const BindingSetItem& binding = bindingSet->desc.bindings[bindingIndex];
+            const BindingSetItem& binding = desc.bindings[bindingIndex];
+
+            RequiredResourceState required;
+            required.subresources = binding.subresources;
 
             switch (binding.type)  // NOLINT(clang-diagnostic-switch-enum)
             {
             case ResourceType::Texture_SRV:
-                requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::ShaderResource);
+                required.texture = checked_cast<Texture*>(binding.resourceHandle);
+                required.state = ResourceStates::ShaderResource;
                 break;
 
             case ResourceType::Texture_UAV:
-                requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::UnorderedAccess);
+                required.texture = checked_cast<Texture*>(binding.resourceHandle);
+                required.state = ResourceStates::UnorderedAccess;
                 break;
 
             case ResourceType::TypedBuffer_SRV:
             case ResourceType::StructuredBuffer_SRV:
             case ResourceType::RawBuffer_SRV:
-                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ShaderResource);
+                required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                required.state = ResourceStates::ShaderResource;
                 break;
 
             case ResourceType::TypedBuffer_UAV:
             case ResourceType::StructuredBuffer_UAV:
             case ResourceType::RawBuffer_UAV:
-                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::UnorderedAccess);
+                required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                required.state = ResourceStates::UnorderedAccess;
                 break;
 
             case ResourceType::ConstantBuffer:
-                requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ConstantBuffer);
+                required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                required.state = ResourceStates::ConstantBuffer;
                 break;
 
             case ResourceType::RayTracingAccelStruct:
-                requireBufferState(checked_cast<AccelStruct*>(binding.resourceHandle)->dataBuffer, ResourceStates::AccelStructRead);
+                required.buffer = checked_cast<AccelStruct*>(binding.resourceHandle)->dataBuffer.Get();
+                required.state = ResourceStates::AccelStructRead;
                 break;
 
             default:
                 // do nothing
-                break;
+                continue;
             }
+
+            requiredStates.push_back(required);
         }
     }
+
+    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    {
+        if (_bindingSet->getDesc() == nullptr)
+            return; // is bindless
+
+        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+        // Sets with UAVs may need UAV barriers on every use, so they can't be skipped
+        m_StateTracker.requireResourceStates(bindingSet->requiredStates, bindingSet->hasUavBindings ? nullptr : bindingSet);
+    }
     
     void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
     {
@@ -96,23 +116,78 @@ namespace nvrhi::d3d12
         m_StateTracker.requireBufferState(buffer, state);
     }
 
+    void CommandList::recordStateFixups(const std::vector<StateFixup>& fixups)
+    {
+        for (const StateFixup& fixup : fixups)
+        {
+            if (fixup.texture)
+            {
+                m_StateTracker.beginTrackingTextureState(fixup.texture, AllSubresources, fixup.stateBefore);
+                m_StateTracker.requireTextureState(fixup.texture, AllSubresources, fixup.stateAfter);
+            }
+            else
+            {
+                m_StateTracker.beginTrackingBufferState(fixup.buffer, fixup.stateBefore);
+                m_StateTracker.requireBufferState(fixup.buffer, fixup.stateAfter);
+            }
+        }
+
+        commitBarriers();
+    }
+
     void CommandList::commitBarriers()
     {
         const auto& textureBarriers = m_StateTracker.getTextureBarriers();
         const auto& bufferBarriers = m_StateTracker.getBufferBarriers();
-        const size_t barrierCount = textureBarriers.size() + bufferBarriers.size();
+        const auto& aliasingBarriers = m_StateTracker.getAliasingBarriers();
+        const size_t barrierCount = textureBarriers.size() + bufferBarriers.size() + aliasingBarriers.size();
         if (barrierCount == 0)
             return;
 
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CommitBarriers);
+
+        if (m_ActiveCommandList->commandList7)
+        {
+            commitEnhancedBarriers();
+            return;
+        }
+
         // Allocate vector space for the barriers assuming 1:1 translation.
         // For partial transitions on multi-plane textures, original barriers may translate
         // into more than 1 barrier each, but that's relatively rare.
         m_D3DBarriers.clear();
         m_D3DBarriers.reserve(barrierCount);
 
+        // The aliasing barriers go first because the transitions of the aliased resources depend on them
+        for (const auto& barrier : aliasingBarriers)
+        {
+            D3D12_RESOURCE_BARRIER d3dbarrier{};
+            d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+            if (barrier.resourceBefore)
+                d3dbarrier.Aliasing.pResourceBefore = barrier.resourceBefore->getNativeObject(ObjectTypes::D3D12_Resource);
+            if (barrier.resourceAfter)
+                d3dbarrier.Aliasing.pResourceAfter = barrier.resourceAfter->getNativeObject(ObjectTypes::D3D12_Resource);
+            m_D3DBarriers.push_back(d3dbarrier);
+        }
+
+        auto convertSplitPhase = [](SplitBarrierPhase phase)
+        {
+            switch (phase)
+            {
+            case SplitBarrierPhase::Begin: return D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+            case SplitBarrierPhase::End: return D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+            case SplitBarrierPhase::None:
+            default: return D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            }
+        };
+
         // Convert the texture barriers into D3D equivalents
         for (const auto& barrier : textureBarriers)
         {
+            // Queue ownership is implicit in D3D12, the transition into the handoff state is a separate barrier
+            if (barrier.ownershipTransfer != QueueOwnershipTransfer::None)
+                continue;
+
             const Texture* texture = nullptr;
             ID3D12Resource* resource = nullptr;
 
@@ -132,6 +207,7 @@ namespace nvrhi::d3d12
             if (stateBefore != stateAfter)
             {
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                d3dbarrier.Flags = convertSplitPhase(barrier.splitPhase);
                 d3dbarrier.Transition.StateBefore = stateBefore;
                 d3dbarrier.Transition.StateAfter = stateAfter;
                 d3dbarrier.Transition.pResource = resource;
@@ -160,6 +236,9 @@ namespace nvrhi::d3d12
         // Convert the buffer barriers into D3D equivalents
         for (const auto& barrier : bufferBarriers)
         {
+            if (barrier.ownershipTransfer != QueueOwnershipTransfer::None)
+                continue;
+
             const Buffer* buffer = static_cast<const Buffer*>(barrier.buffer);
 
             D3D12_RESOURCE_BARRIER d3dbarrier{};
@@ -170,6 +249,7 @@ namespace nvrhi::d3d12
                 (stateAfter & D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE) == 0)
             {
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                d3dbarrier.Flags = convertSplitPhase(barrier.splitPhase);
                 d3dbarrier.Transition.StateBefore = stateBefore;
                 d3dbarrier.Transition.StateAfter = stateAfter;
                 d3dbarrier.Transition.pResource = buffer->resource;
@@ -190,9 +270,242 @@ namespace nvrhi::d3d12
         if (m_D3DBarriers.size() > 0)
             m_ActiveCommandList->commandList->ResourceBarrier(uint32_t(m_D3DBarriers.size()), m_D3DBarriers.data());
 
+        NVRHI_COUNT_STATISTIC(m_Statistics, barriers, m_D3DBarriers.size());
+
+        m_StateTracker.clearBarriers();
+    }
+
+    void CommandList::commitEnhancedBarriers()
+    {
+        const auto& textureBarriers = m_StateTracker.getTextureBarriers();
+        const auto& bufferBarriers = m_StateTracker.getBufferBarriers();
+        const auto& aliasingBarriers = m_StateTracker.getAliasingBarriers();
+
+        // Aliasing barriers don't involve resource states, so the legacy version can be used with enhanced barriers.
+        // Placing them in a separate call orders them before the transitions of the aliased resources.
+        if (!aliasingBarriers.empty())
+        {
+            m_D3DBarriers.clear();
+            for (const auto& barrier : aliasingBarriers)
+            {
+                D3D12_RESOURCE_BARRIER d3dbarrier{};
+                d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+                if (barrier.resourceBefore)
+                    d3dbarrier.Aliasing.pResourceBefore = barrier.resourceBefore->getNativeObject(ObjectTypes::D3D12_Resource);
+                if (barrier.resourceAfter)
+                    d3dbarrier.Aliasing.pResourceAfter = barrier.resourceAfter->getNativeObject(ObjectTypes::D3D12_Resource);
+                m_D3DBarriers.push_back(d3dbarrier);
+            }
+            m_ActiveCommandList->commandList->ResourceBarrier(uint32_t(m_D3DBarriers.size()), m_D3DBarriers.data());
+            NVRHI_COUNT_STATISTIC(m_Statistics, barriers, m_D3DBarriers.size());
+        }
+
+        auto applySplitPhase = [](SplitBarrierPhase phase, D3D12_BARRIER_SYNC& syncBefore, D3D12_BARRIER_SYNC& syncAfter)
+        {
+            if (phase == SplitBarrierPhase::Begin)
+                syncAfter = D3D12_BARRIER_SYNC_SPLIT;
+            else if (phase == SplitBarrierPhase::End)
+                syncBefore = D3D12_BARRIER_SYNC_SPLIT;
+        };
+
+        m_D3DTextureBarriers.clear();
+        m_D3DTextureBarriers.reserve(textureBarriers.size());
+
+        for (const auto& barrier : textureBarriers)
+        {
+            if (barrier.ownershipTransfer != QueueOwnershipTransfer::None)
+                continue;
+
+            const Texture* texture = nullptr;
+            ID3D12Resource* resource = nullptr;
+
+            if (barrier.texture->isSamplerFeedback)
+            {
+                resource = static_cast<const SamplerFeedbackTexture*>(barrier.texture)->resource;
+            }
+            else
+            {
+                texture = static_cast<const Texture*>(barrier.texture);
+                resource = texture->resource;
+            }
+
+            const EnhancedBarrierState before = convertResourceStatesEnhanced(barrier.stateBefore, true);
+            const EnhancedBarrierState after = convertResourceStatesEnhanced(barrier.stateAfter, true);
+
+            D3D12_TEXTURE_BARRIER d3dbarrier{};
+            d3dbarrier.SyncBefore = before.sync;
+            d3dbarrier.SyncAfter = after.sync;
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            d3dbarrier.LayoutBefore = before.layout;
+            d3dbarrier.LayoutAfter = after.layout;
+            d3dbarrier.pResource = resource;
+
+            if (barrier.aliased)
+            {
+                // The previous contents belong to another resource, discard them
+                d3dbarrier.SyncBefore = D3D12_BARRIER_SYNC_NONE;
+                d3dbarrier.AccessBefore = D3D12_BARRIER_ACCESS_NO_ACCESS;
+                d3dbarrier.LayoutBefore = D3D12_BARRIER_LAYOUT_UNDEFINED;
+                d3dbarrier.Flags = D3D12_TEXTURE_BARRIER_FLAG_DISCARD;
+            }
+
+            applySplitPhase(barrier.splitPhase, d3dbarrier.SyncBefore, d3dbarrier.SyncAfter);
+
+            if (barrier.entireTexture)
+            {
+                // IndexOrFirstMipLevel = 0xffffffff selects all subresources
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = 0xffffffff;
+            }
+            else
+            {
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = barrier.mipLevel;
+                d3dbarrier.Subresources.NumMipLevels = 1;
+                d3dbarrier.Subresources.FirstArraySlice = barrier.arraySlice;
+                d3dbarrier.Subresources.NumArraySlices = 1;
+                d3dbarrier.Subresources.FirstPlane = 0;
+                d3dbarrier.Subresources.NumPlanes = texture ? texture->planeCount : 1;
+            }
+
+            m_D3DTextureBarriers.push_back(d3dbarrier);
+        }
+
+        m_D3DBufferBarriers.clear();
+        m_D3DBufferBarriers.reserve(bufferBarriers.size());
+
+        for (const auto& barrier : bufferBarriers)
+        {
+            if (barrier.ownershipTransfer != QueueOwnershipTransfer::None)
+                continue;
+
+            const Buffer* buffer = static_cast<const Buffer*>(barrier.buffer);
+
+            const EnhancedBarrierState before = convertResourceStatesEnhanced(barrier.stateBefore, false);
+            const EnhancedBarrierState after = convertResourceStatesEnhanced(barrier.stateAfter, false);
+
+            D3D12_BUFFER_BARRIER d3dbarrier{};
+            d3dbarrier.SyncBefore = before.sync;
+            d3dbarrier.SyncAfter = after.sync;
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            d3dbarrier.pResource = buffer->resource;
+            d3dbarrier.Offset = 0;
+            d3dbarrier.Size = UINT64_MAX;
+
+            applySplitPhase(barrier.splitPhase, d3dbarrier.SyncBefore, d3dbarrier.SyncAfter);
+
+            m_D3DBufferBarriers.push_back(d3dbarrier);
+        }
+
+        static_vector<D3D12_BARRIER_GROUP, 2> barrierGroups;
+
+        if (!m_D3DTextureBarriers.empty())
+        {
+            D3D12_BARRIER_GROUP group{};
+            group.Type = D3D12_BARRIER_TYPE_TEXTURE;
+            group.NumBarriers = uint32_t(m_D3DTextureBarriers.size());
+            group.pTextureBarriers = m_D3DTextureBarriers.data();
+            barrierGroups.push_back(group);
+        }
+
+        if (!m_D3DBufferBarriers.empty())
+        {
+            D3D12_BARRIER_GROUP group{};
+            group.Type = D3D12_BARRIER_TYPE_BUFFER;
+            group.NumBarriers = uint32_t(m_D3DBufferBarriers.size());
+            group.pBufferBarriers = m_D3DBufferBarriers.data();
+            barrierGroups.push_back(group);
+        }
+
+        if (!barrierGroups.empty())
+            m_ActiveCommandList->commandList7->Barrier(uint32_t(barrierGroups.size()), barrierGroups.data());
+
+        NVRHI_COUNT_STATISTIC(m_Statistics, barriers, m_D3DTextureBarriers.size() + m_D3DBufferBarriers.size());
+
         m_StateTracker.clearBarriers();
     }
 
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, subresources, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::releaseTextureOwnership(ITexture* _texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.releaseTextureOwnership(texture, subresources, destinationQueue, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::acquireTextureOwnership(ITexture* _texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.acquireTextureOwnership(texture, subresources, sourceQueue, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::releaseBufferOwnership(IBuffer* _buffer, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.releaseBufferOwnership(buffer, destinationQueue, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::acquireBufferOwnership(IBuffer* _buffer, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.acquireBufferOwnership(buffer, sourceQueue, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        if (ITexture* textureAfter = dynamic_cast<ITexture*>(resourceAfter))
+        {
+            Texture* texture = checked_cast<Texture*>(textureAfter);
+            m_StateTracker.discardTextureState(texture);
+            m_Instance->referencedResources.push_back(texture);
+        }
+        else if (IBuffer* bufferAfter = dynamic_cast<IBuffer*>(resourceAfter))
+        {
+            Buffer* buffer = checked_cast<Buffer*>(bufferAfter);
+            m_StateTracker.discardBufferState(buffer);
+            m_Instance->referencedResources.push_back(buffer);
+        }
+
+        if (resourceBefore)
+            m_Instance->referencedResources.push_back(resourceBefore);
+
+        m_StateTracker.addAliasingBarrier(resourceBefore, resourceAfter);
+    }
+
     void CommandList::setEnableAutomaticBarriers(bool enable)
     {
         m_EnableAutomaticBarriers = enable;
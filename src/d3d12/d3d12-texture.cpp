@@ -395,6 +395,12 @@ namespace nvrhi::d3d12
 
         texture->postCreate();
 
+        if (!d.isTiled)
+        {
+            const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = m_Context.device->GetResourceAllocationInfo(1, 1, &texture->resourceDesc);
+            texture->trackedMemory.set(m_Context.memoryCounters, texture, allocInfo.SizeInBytes);
+        }
+
         return TextureHandle::Create(texture);
     }
 
@@ -444,6 +450,7 @@ namespace nvrhi::d3d12
 
         texture->heap = heap;
         texture->postCreate();
+        texture->trackedMemory.setPlaced(m_Context.memoryCounters, texture, getTextureMemoryRequirements(texture).size, heap, offset);
 
         return true;
     }
@@ -1380,6 +1387,121 @@ namespace nvrhi::d3d12
         m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
     }
 
+    void CommandList::writeTextureRegions(ITexture* _dest, const TextureUploadRegion* regions, size_t numRegions)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        if (numRegions == 0)
+            return;
+
+        const FormatInfo& formatInfo = getFormatInfo(dest->desc.format);
+
+        std::vector<TextureSlice> slices(numRegions);
+        std::vector<uint32_t> subresources(numRegions);
+        uint32_t firstSubresource = ~0u;
+        uint32_t lastSubresource = 0;
+
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            slices[i] = regions[i].slice.resolve(dest->desc);
+            subresources[i] = calcSubresource(slices[i].mipLevel, slices[i].arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+            firstSubresource = std::min(firstSubresource, subresources[i]);
+            lastSubresource = std::max(lastSubresource, subresources[i]);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireTextureState(dest, TextureSubresourceSet(slices[i].mipLevel, 1, slices[i].arraySlice, 1), ResourceStates::CopyDest);
+            }
+        }
+
+        if (m_EnableAutomaticBarriers)
+            m_BindingStatesDirty = true;
+        commitBarriers();
+
+        // Get the layouts of all the subresources at once, then shrink them to the uploaded boxes
+        // and pack the boxes into one upload allocation
+        const uint32_t numSubresources = lastSubresource - firstSubresource + 1;
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresources);
+
+        D3D12_RESOURCE_DESC resourceDesc = dest->resource->GetDesc();
+        m_Context.device->GetCopyableFootprints(&resourceDesc, firstSubresource, numSubresources, 0, layouts.data(), nullptr, nullptr, nullptr);
+
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(numRegions);
+        std::vector<uint32_t> rowCounts(numRegions);
+        uint64_t totalBytes = 0;
+
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            const TextureSlice& slice = slices[i];
+            const uint32_t numCols = (slice.width + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            const uint32_t numRows = (slice.height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint = footprints[i];
+            footprint = layouts[subresources[i] - firstSubresource];
+            footprint.Offset = align(totalBytes, uint64_t(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+            footprint.Footprint.Width = numCols * formatInfo.blockSize;
+            footprint.Footprint.Height = numRows * formatInfo.blockSize;
+            footprint.Footprint.Depth = slice.depth;
+            footprint.Footprint.RowPitch = align(numCols * formatInfo.bytesPerBlock, uint32_t(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+
+            rowCounts[i] = numRows;
+            totalBytes = footprint.Offset + uint64_t(footprint.Footprint.RowPitch) * numRows * slice.depth;
+        }
+
+        void* cpuVA;
+        ID3D12Resource* uploadBuffer;
+        size_t offsetInUploadBuffer;
+        if (!m_UploadManager.suballocateBuffer(totalBytes, nullptr, &uploadBuffer, &offsetInUploadBuffer, &cpuVA, nullptr, 
+            m_RecordingVersion, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
+
+        m_Instance->referencedResources.push_back(dest);
+
+        if (uploadBuffer != m_CurrentUploadBuffer)
+        {
+            m_Instance->referencedNativeResources.push_back(uploadBuffer);
+            m_CurrentUploadBuffer = uploadBuffer;
+        }
+
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            const TextureUploadRegion& region = regions[i];
+            const TextureSlice& slice = slices[i];
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint = footprints[i];
+
+            const uint32_t numRows = rowCounts[i];
+            const size_t rowSizeInBytes = size_t((slice.width + formatInfo.blockSize - 1) / formatInfo.blockSize) * formatInfo.bytesPerBlock;
+            char* regionCpuVA = (char*)cpuVA + footprint.Offset;
+
+            for (uint32_t depthSlice = 0; depthSlice < slice.depth; depthSlice++)
+            {
+                for (uint32_t row = 0; row < numRows; row++)
+                {
+                    void* destAddress = regionCpuVA + uint64_t(footprint.Footprint.RowPitch) * uint64_t(row + depthSlice * numRows);
+                    const void* srcAddress = (const char*)region.data + region.rowPitch * row + region.depthPitch * depthSlice;
+                    memcpy(destAddress, srcAddress, std::min(region.rowPitch, rowSizeInBytes));
+                }
+            }
+
+            footprint.Offset += uint64_t(offsetInUploadBuffer);
+
+            D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
+            destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            destCopyLocation.SubresourceIndex = subresources[i];
+            destCopyLocation.pResource = dest->resource;
+
+            D3D12_TEXTURE_COPY_LOCATION srcCopyLocation;
+            srcCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            srcCopyLocation.PlacedFootprint = footprint;
+            srcCopyLocation.pResource = uploadBuffer;
+
+            m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, slice.x, slice.y, slice.z, &srcCopyLocation, nullptr);
+        }
+    }
+
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
     {
         Texture* dest = checked_cast<Texture*>(_dest);
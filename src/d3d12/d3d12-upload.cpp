@@ -24,31 +24,314 @@
 
 #include <nvrhi/common/misc.h>
 #include <sstream>
+#include <iomanip>
 
 namespace nvrhi::d3d12
 {
 
     BufferChunk::~BufferChunk()
     {
-        if (buffer && cpuVA)
+        if (buffer && cpuVA && !isRingChunk)
         {
             buffer->Unmap(0, nullptr);
             cpuVA = nullptr;
         }
     }
     
-    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+    UploadRing::UploadRing(const Context& context, class Queue* pQueue, uint64_t ringSize, uint64_t chunkSize)
+        : m_Context(context)
+        , m_Queue(pQueue)
+        , m_ChunkSize(align(std::max(chunkSize, BufferChunk::c_sizeAlignment), BufferChunk::c_sizeAlignment))
+    {
+        assert(pQueue);
+
+        m_RingSize = std::max(ringSize / m_ChunkSize, uint64_t(1)) * m_ChunkSize;
+    }
+
+    bool UploadRing::createBuffer()
+    {
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+        D3D12_RESOURCE_DESC bufferDesc = {};
+        bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufferDesc.Width = m_RingSize;
+        bufferDesc.Height = 1;
+        bufferDesc.DepthOrArraySize = 1;
+        bufferDesc.MipLevels = 1;
+        bufferDesc.SampleDesc.Count = 1;
+        bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+        HRESULT hr = m_Context.device->CreateCommittedResource(
+            &heapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&m_Buffer));
+
+        if (SUCCEEDED(hr))
+            hr = m_Buffer->Map(0, nullptr, &m_CpuVA);
+
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to create an upload ring buffer of " << m_RingSize << " bytes, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+
+            m_Buffer = nullptr;
+            return false;
+        }
+
+        m_Buffer->SetName(L"Upload Ring");
+        m_TrackedMemory.set(m_Context.memoryCounters, MemoryCategory::UploadChunks, m_RingSize);
+
+        D3D12_GPU_VIRTUAL_ADDRESS const gpuVA = m_Buffer->GetGPUVirtualAddress();
+        size_t const numChunks = size_t(m_RingSize / m_ChunkSize);
+        m_Chunks.reserve(numChunks);
+
+        for (size_t index = 0; index < numChunks; index++)
+        {
+            auto chunk = std::make_shared<BufferChunk>();
+            chunk->buffer = m_Buffer;
+            chunk->bufferOffset = index * m_ChunkSize;
+            chunk->bufferSize = m_ChunkSize;
+            chunk->cpuVA = static_cast<char*>(m_CpuVA) + chunk->bufferOffset;
+            chunk->gpuVA = gpuVA + chunk->bufferOffset;
+            chunk->identifier = uint32_t(index);
+            chunk->isRingChunk = true;
+            m_Chunks.push_back(chunk);
+        }
+
+        m_Statistics.capacity = m_RingSize;
+        return true;
+    }
+
+    bool UploadRing::isChunkInUse(const BufferChunk& chunk, uint64_t completedInstance)
+    {
+        if (chunk.version == 0)
+            return false;
+
+        return !VersionGetSubmitted(chunk.version)
+            || VersionGetInstance(chunk.version) > completedInstance;
+    }
+
+    std::shared_ptr<BufferChunk> UploadRing::claimChunk(uint64_t currentVersion)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_Buffer)
+        {
+            // Don't retry creating the buffer on every allocation if it has failed once
+            if (m_CreationFailed || !createBuffer())
+            {
+                m_CreationFailed = true;
+                return nullptr;
+            }
+        }
+
+        // Chunks are claimed in order, so if the oldest chunk is in use, the ring is full
+        std::shared_ptr<BufferChunk> const& chunk = m_Chunks[m_NextChunk];
+        if (isChunkInUse(*chunk, m_Queue->fence->GetCompletedValue()))
+        {
+            ++m_Statistics.numClaimFailures;
+            return nullptr;
+        }
+
+        chunk->version = currentVersion;
+        chunk->writePointer = 0;
+        m_NextChunk = (m_NextChunk + 1) % m_Chunks.size();
+
+        ++m_Statistics.numChunksClaimed;
+        m_Statistics.peakBytesInUse = std::max(m_Statistics.peakBytesInUse, getBytesInUse());
+
+        return chunk;
+    }
+
+    void UploadRing::submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const auto& chunk : chunks)
+            chunk->version = submittedVersion;
+    }
+
+    uint64_t UploadRing::getBytesInUse() const
+    {
+        uint64_t const completedInstance = m_Queue->fence->GetCompletedValue();
+
+        uint64_t bytesInUse = 0;
+        for (const auto& chunk : m_Chunks)
+        {
+            if (isChunkInUse(*chunk, completedInstance))
+                bytesInUse += chunk->bufferSize;
+        }
+        return bytesInUse;
+    }
+
+    UploadRingStatistics UploadRing::getStatistics()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        UploadRingStatistics result = m_Statistics;
+        result.bytesInUse = getBytesInUse();
+        return result;
+    }
+
+    ScratchPool::ScratchPool(const Context& context, class Queue* pQueue, uint64_t maxMemory, uint64_t chunkSize)
+        : m_Context(context)
+        , m_Queue(pQueue)
+        , m_MaxMemory(maxMemory)
+        , m_ChunkSize(align(std::max(chunkSize, BufferChunk::c_sizeAlignment), BufferChunk::c_sizeAlignment))
+    {
+        assert(pQueue);
+    }
+
+    std::shared_ptr<BufferChunk> ScratchPool::createChunk(uint64_t size)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::AllocateUploadChunk);
+
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_RESOURCE_DESC bufferDesc = {};
+        bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufferDesc.Width = size;
+        bufferDesc.Height = 1;
+        bufferDesc.DepthOrArraySize = 1;
+        bufferDesc.MipLevels = 1;
+        bufferDesc.SampleDesc.Count = 1;
+        bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        bufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        auto chunk = std::make_shared<BufferChunk>();
+
+        HRESULT hr = m_Context.device->CreateCommittedResource(
+            &heapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            IID_PPV_ARGS(&chunk->buffer));
+
+        if (FAILED(hr))
+            return nullptr;
+
+        chunk->bufferSize = size;
+        chunk->gpuVA = chunk->buffer->GetGPUVirtualAddress();
+        chunk->identifier = uint32_t(m_Chunks.size());
+        chunk->isPoolChunk = true;
+        chunk->trackedMemory.set(m_Context.memoryCounters, MemoryCategory::UploadChunks, size);
+
+        std::wstringstream wss;
+        wss << L"DXR Shared Scratch Buffer " << chunk->identifier;
+        chunk->buffer->SetName(wss.str().c_str());
+
+        return chunk;
+    }
+
+    std::shared_ptr<BufferChunk> ScratchPool::claimChunk(uint64_t size, uint64_t currentVersion, bool& needsBarrier)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        needsBarrier = false;
+        uint64_t const completedInstance = m_Queue->fence->GetCompletedValue();
+
+        auto isFree = [completedInstance](const BufferChunk& chunk)
+        {
+            return chunk.version == 0 ||
+                (VersionGetSubmitted(chunk.version) && VersionGetInstance(chunk.version) <= completedInstance);
+        };
+
+        // Pick the smallest free chunk that fits, and remember the oldest submitted one for the over-budget case
+        std::shared_ptr<BufferChunk> bestChunk;
+        std::shared_ptr<BufferChunk> oldestSubmittedChunk;
+        for (const auto& chunk : m_Chunks)
+        {
+            if (chunk->bufferSize < size)
+                continue;
+
+            if (isFree(*chunk))
+            {
+                if (!bestChunk || chunk->bufferSize < bestChunk->bufferSize)
+                    bestChunk = chunk;
+            }
+            else if (VersionGetSubmitted(chunk->version))
+            {
+                if (!oldestSubmittedChunk || VersionGetInstance(chunk->version) < VersionGetInstance(oldestSubmittedChunk->version))
+                    oldestSubmittedChunk = chunk;
+            }
+        }
+
+        if (!bestChunk)
+        {
+            uint64_t const sizeToAllocate = align(std::max(size, m_ChunkSize), BufferChunk::c_sizeAlignment);
+
+            // Free chunks that are too small for this allocation are released to make room in the budget
+            for (auto it = m_Chunks.begin(); it != m_Chunks.end() && m_AllocatedMemory + sizeToAllocate > m_MaxMemory; )
+            {
+                if (isFree(**it))
+                {
+                    m_AllocatedMemory -= (*it)->bufferSize;
+                    it = m_Chunks.erase(it);
+                }
+                else
+                    ++it;
+            }
+
+            if (m_AllocatedMemory + sizeToAllocate <= m_MaxMemory)
+            {
+                bestChunk = createChunk(sizeToAllocate);
+                if (bestChunk)
+                {
+                    m_AllocatedMemory += sizeToAllocate;
+                    m_Chunks.push_back(bestChunk);
+                }
+            }
+        }
+
+        if (!bestChunk && oldestSubmittedChunk)
+        {
+            // Over the budget: the submissions on one queue execute in order, so a chunk used by an earlier
+            // submission can be reused after a UAV barrier that waits for its builds.
+            bestChunk = oldestSubmittedChunk;
+            needsBarrier = true;
+        }
+
+        if (bestChunk)
+        {
+            bestChunk->version = currentVersion;
+            bestChunk->writePointer = 0;
+        }
+
+        return bestChunk;
+    }
+
+    void ScratchPool::submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const auto& chunk : chunks)
+            chunk->version = submittedVersion;
+    }
+
+    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer,
+        UploadRing* pRing, ScratchPool* pScratchPool)
         : m_Context(context)
         , m_Queue(pQueue)
         , m_DefaultChunkSize(defaultChunkSize)
         , m_MemoryLimit(memoryLimit)
         , m_IsScratchBuffer(isScratchBuffer)
+        , m_Ring(pRing)
+        , m_ScratchPool(pScratchPool)
     {
         assert(pQueue);
     }
 
     std::shared_ptr<BufferChunk> UploadManager::createChunk(size_t size) const
     {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::AllocateUploadChunk);
+
         auto chunk = std::make_shared<BufferChunk>();
 
         size = align(size, BufferChunk::c_sizeAlignment);
@@ -88,6 +371,7 @@ namespace nvrhi::d3d12
         chunk->bufferSize = size;
         chunk->gpuVA = chunk->buffer->GetGPUVirtualAddress();
         chunk->identifier = uint32_t(m_ChunkPool.size());
+        chunk->trackedMemory.set(m_Context.memoryCounters, MemoryCategory::UploadChunks, size);
 
         std::wstringstream wss;
         if (m_IsScratchBuffer)
@@ -105,6 +389,10 @@ namespace nvrhi::d3d12
         // Scratch allocations need a command list, upload ones don't
         assert(!m_IsScratchBuffer || pCommandList);
 
+#if NVRHI_WITH_COMMAND_LIST_STATISTICS
+        m_SuballocatedBytes += size;
+#endif
+
         std::shared_ptr<BufferChunk> chunkToRetire;
 
         // Try to allocate from the current chunk first
@@ -119,7 +407,7 @@ namespace nvrhi::d3d12
                 m_CurrentChunk->writePointer = endOfDataInChunk;
 
                 if (pBuffer) *pBuffer = m_CurrentChunk->buffer;
-                if (pOffset) *pOffset = alignedOffset;
+                if (pOffset) *pOffset = m_CurrentChunk->bufferOffset + alignedOffset;
                 if (pCpuVA && m_CurrentChunk->cpuVA)
                     *pCpuVA = (char*)m_CurrentChunk->cpuVA + alignedOffset;
                 if (pGpuVA && m_CurrentChunk->gpuVA)
@@ -132,10 +420,30 @@ namespace nvrhi::d3d12
             m_CurrentChunk.reset();
         }
 
+        // Prefer the shared ring when the allocation fits into its chunks
+        if (m_Ring && size <= m_Ring->getChunkSize())
+        {
+            m_CurrentChunk = m_Ring->claimChunk(currentVersion);
+        }
+
+        if (m_ScratchPool && !m_CurrentChunk)
+        {
+            bool needsBarrier = false;
+            m_CurrentChunk = m_ScratchPool->claimChunk(size, currentVersion, needsBarrier);
+
+            if (m_CurrentChunk && needsBarrier)
+            {
+                D3D12_RESOURCE_BARRIER barrier = {};
+                barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+                barrier.UAV.pResource = m_CurrentChunk->buffer;
+                pCommandList->ResourceBarrier(1, &barrier);
+            }
+        }
+
         uint64_t completedInstance = m_Queue->lastCompletedInstance;
 
         // Try to find a chunk in the pool that's no longer used and is large enough to allocate our buffer
-        for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); ++it)
+        for (auto it = m_ChunkPool.begin(); !m_CurrentChunk && it != m_ChunkPool.end(); ++it)
         {
             std::shared_ptr<BufferChunk> chunk = *it;
 
@@ -155,7 +463,7 @@ namespace nvrhi::d3d12
 
         if (chunkToRetire)
         {
-            m_ChunkPool.push_back(chunkToRetire);
+            retireChunk(chunkToRetire);
         }
 
         if (!m_CurrentChunk)
@@ -227,22 +535,35 @@ namespace nvrhi::d3d12
             }
         }
 
-        m_CurrentChunk->version = currentVersion;
+        // The version of ring and pool chunks is set by their owner under its mutex
+        if (!m_CurrentChunk->isRingChunk && !m_CurrentChunk->isPoolChunk)
+            m_CurrentChunk->version = currentVersion;
         m_CurrentChunk->writePointer = size;
 
         if (pBuffer) *pBuffer = m_CurrentChunk->buffer;
-        if (pOffset) *pOffset = 0;
+        if (pOffset) *pOffset = m_CurrentChunk->bufferOffset;
         if (pCpuVA) *pCpuVA = m_CurrentChunk->cpuVA;
         if (pGpuVA) *pGpuVA = m_CurrentChunk->gpuVA;
 
         return true;
     }
 
+    void UploadManager::retireChunk(const std::shared_ptr<BufferChunk>& chunk)
+    {
+        // Ring and pool chunks go back to their owner on submission, they're not reused by this manager directly
+        if (chunk->isRingChunk)
+            m_RingChunks.push_back(chunk);
+        else if (chunk->isPoolChunk)
+            m_PoolChunks.push_back(chunk);
+        else
+            m_ChunkPool.push_back(chunk);
+    }
+
     void UploadManager::submitChunks(uint64_t currentVersion, uint64_t submittedVersion)
     {
         if (m_CurrentChunk)
         {
-            m_ChunkPool.push_back(m_CurrentChunk);
+            retireChunk(m_CurrentChunk);
             m_CurrentChunk.reset();
         }
 
@@ -251,5 +572,17 @@ namespace nvrhi::d3d12
             if (chunk->version == currentVersion)
                 chunk->version = submittedVersion;
         }
+
+        if (!m_RingChunks.empty())
+        {
+            m_Ring->submitChunks(m_RingChunks, submittedVersion);
+            m_RingChunks.clear();
+        }
+
+        if (!m_PoolChunks.empty())
+        {
+            m_ScratchPool->submitChunks(m_PoolChunks, submittedVersion);
+            m_PoolChunks.clear();
+        }
     }
 } // namespace nvrhi::d3d12
@@ -0,0 +1,642 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/null.h>
+#include <nvrhi/utils.h>
+#include <nvrhi/common/aftermath.h>
+#include "../common/command-list-statistics.h"
+#include "../common/instrumentation.h"
+#include "../common/intern-table.h"
+#include "../common/memory-statistics.h"
+#include "../common/pipeline-compile-pool.h"
+#include "../common/pipeline-statistics.h"
+#include "../common/shader-cache.h"
+#include "../common/state-tracking.h"
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi::null
+{
+    class Device;
+
+    struct Context
+    {
+        IMessageCallback* messageCallback = nullptr;
+        InstrumentationHook instrumentation;
+        mutable MemoryCounters memoryCounters;
+        PipelineCreationCounters pipelineCounters;
+
+        void error(const std::string& message) const;
+    };
+
+    // Returns the size of one subresource of a texture with tightly packed rows
+    uint64_t getTextureSubresourceSize(const TextureDesc& desc, MipLevel mipLevel);
+
+    class Heap : public RefCounter<IHeap>
+    {
+    public:
+        HeapDesc desc;
+        TrackedMemory trackedMemory;
+
+        const HeapDesc& getDesc() override { return desc; }
+    };
+
+    class Texture : public RefCounter<ITexture>, public TextureStateExtension
+    {
+    public:
+        TextureDesc desc;
+        HeapHandle heap;
+        TrackedMemory trackedMemory;
+
+        Texture()
+            : TextureStateExtension(this->desc)
+        { }
+
+        const TextureDesc& getDesc() const override { return desc; }
+        Object getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV = false) override
+            { (void)objectType; (void)format; (void)subresources; (void)dimension; (void)isReadOnlyDSV; return nullptr; }
+    };
+
+    class StagingTexture : public RefCounter<IStagingTexture>
+    {
+    public:
+        TextureDesc desc;
+        CpuAccessMode cpuAccess = CpuAccessMode::None;
+
+        // Subresources are stored one after another with tightly packed rows, index = mipLevel * arraySize + arraySlice
+        std::vector<uint8_t> memory;
+        std::vector<uint64_t> subresourceOffsets;
+        TrackedMemory trackedMemory;
+
+        const TextureDesc& getDesc() const override { return desc; }
+    };
+
+    class Buffer : public RefCounter<IBuffer>, public BufferStateExtension
+    {
+    public:
+        BufferDesc desc;
+        GpuVirtualAddress gpuAddress = 0;
+        HeapHandle heap;
+        TrackedMemory trackedMemory;
+
+        // Backing store of CPU-accessible buffers, or the memory passed to createBufferFromHostMemory
+        std::vector<uint8_t> hostMemory;
+        void* mappedMemory = nullptr;
+
+        Buffer()
+            : BufferStateExtension(this->desc)
+        { }
+
+        const BufferDesc& getDesc() const override { return desc; }
+        GpuVirtualAddress getGpuVirtualAddress() const override { return gpuAddress; }
+    };
+
+    class Shader : public RefCounter<IShader>
+    {
+    public:
+        ShaderDesc desc;
+        std::vector<char> bytecode;
+
+        const ShaderDesc& getDesc() const override { return desc; }
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override;
+    };
+
+    class Sampler : public RefCounter<ISampler>
+    {
+    public:
+        SamplerDesc desc;
+        StateObjectTables::SamplerTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
+
+        const SamplerDesc& getDesc() const override { return desc; }
+    };
+
+    class InputLayout : public RefCounter<IInputLayout>
+    {
+    public:
+        std::vector<VertexAttributeDesc> attributes;
+        StateObjectTables::InputLayoutTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
+
+        uint32_t getNumAttributes() const override { return uint32_t(attributes.size()); }
+        const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override { return index < attributes.size() ? &attributes[index] : nullptr; }
+    };
+
+    class EventQuery : public RefCounter<IEventQuery>
+    {
+    public:
+        // Work completes on submission, so a query is signaled as soon as it's set
+        bool signaled = false;
+    };
+
+    class TimerQuery : public RefCounter<ITimerQuery>
+    {
+    public:
+        bool resolved = false;
+    };
+
+    class TimestampQueryPool : public RefCounter<ITimestampQueryPool>
+    {
+    public:
+        TimestampQueryPoolDesc desc;
+
+        // CPU time in nanoseconds when writeTimestamp was recorded
+        std::vector<uint64_t> timestamps;
+
+        const TimestampQueryPoolDesc& getDesc() const override { return desc; }
+    };
+
+    class QueryPool : public RefCounter<IQueryPool>
+    {
+    public:
+        QueryPoolDesc desc;
+
+        const QueryPoolDesc& getDesc() const override { return desc; }
+    };
+
+    class Framebuffer : public RefCounter<IFramebuffer>
+    {
+    public:
+        FramebufferDesc desc;
+        FramebufferInfoEx framebufferInfo;
+
+        // FramebufferAttachment only stores raw pointers
+        std::vector<ResourceHandle> resources;
+
+        const FramebufferDesc& getDesc() const override { return desc; }
+        const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+
+        const GraphicsPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class ComputePipeline : public RefCounter<IComputePipeline>
+    {
+    public:
+        ComputePipelineDesc desc;
+
+        const ComputePipelineDesc& getDesc() const override { return desc; }
+    };
+
+    class BindingLayout : public RefCounter<IBindingLayout>
+    {
+    public:
+        BindingLayoutDesc desc;
+        BindlessLayoutDesc bindlessDesc;
+        bool isBindless = false;
+        StateObjectTables::BindingLayoutTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
+
+        const BindingLayoutDesc* getDesc() const override { return isBindless ? nullptr : &desc; }
+        const BindlessLayoutDesc* getBindlessDesc() const override { return isBindless ? &bindlessDesc : nullptr; }
+    };
+
+    class BindingSet : public RefCounter<IBindingSet>
+    {
+    public:
+        BindingSetDesc desc;
+        BindingLayoutHandle layout;
+
+        // Strong references to the bound resources, BindingSetItem only stores raw pointers
+        std::vector<ResourceHandle> resources;
+
+        // States required by the bindings, precomputed for CommandListResourceStateTracker::requireResourceStates
+        std::vector<RequiredResourceState> requiredStates;
+        bool hasUavBindings = false;
+
+        const BindingSetDesc* getDesc() const override { return &desc; }
+        IBindingLayout* getLayout() const override { return layout; }
+
+        void initialize(const Context& context);
+    };
+
+    class DescriptorTable : public RefCounter<IDescriptorTable>
+    {
+    public:
+        BindingLayoutHandle layout;
+        std::vector<BindingSetItem> descriptors;
+        std::vector<ResourceHandle> resources;
+
+        const BindingSetDesc* getDesc() const override { return nullptr; }
+        IBindingLayout* getLayout() const override { return layout; }
+        uint32_t getCapacity() const override { return uint32_t(descriptors.size()); }
+        uint32_t getFirstDescriptorIndexInHeap() const override { return 0; }
+    };
+
+    // The draws are replayed through the regular state setting path
+    class CommandBundle : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+
+        // GraphicsState holds raw pointers, so the bundle keeps the objects used by its draws alive
+        std::vector<ResourceHandle> referencedResources;
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+    };
+
+    // A block of CPU memory that upload data is sub-allocated from, see UploadManager
+    struct UploadChunk
+    {
+        std::vector<uint8_t> memory;
+        uint64_t writePointer = 0;
+        TrackedMemory trackedMemory;
+    };
+
+    // Sub-allocates the upload data of one command list from a pool of chunks, like the upload managers
+    // of the other backends do. The chunks become available again when the command list is executed,
+    // because the null device finishes the work on submission.
+    class UploadManager
+    {
+    public:
+        UploadManager(const Context& context, uint64_t defaultChunkSize);
+
+        // Returns a pointer to 'size' bytes of upload memory that stay valid until the command list is executed
+        uint8_t* suballocate(uint64_t size, uint32_t alignment = 256);
+
+        void submitChunks();
+
+        // Bytes requested from suballocate since the last reset, see CommandListStatistics
+        [[nodiscard]] uint64_t getSuballocatedBytes() const { return m_SuballocatedBytes; }
+        void resetSuballocatedBytes() { m_SuballocatedBytes = 0; }
+
+    private:
+        static constexpr uint64_t c_sizeAlignment = 4096; // GPU page size, like the other backends
+
+        const Context& m_Context;
+        uint64_t m_DefaultChunkSize = 0;
+        uint64_t m_SuballocatedBytes = 0;
+
+        std::unique_ptr<UploadChunk> m_CurrentChunk;
+        std::vector<std::unique_ptr<UploadChunk>> m_UsedChunks;
+        std::list<std::unique_ptr<UploadChunk>> m_ChunkPool;
+    };
+
+    class CommandList : public RefCounter<ICommandList>
+    {
+    public:
+        CommandList(Device* device, const Context& context, const CommandListParameters& parameters);
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override { (void)objectType; return nullptr; }
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* texture, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* texture, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* texture, TextureSubresourceSet subresources, uint32_t clearColor) override;
+        void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override { (void)texture; utils::NotSupported(); }
+        void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, Format format) override { (void)buffer; (void)texture; (void)format; utils::NotSupported(); }
+        void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override { (void)texture; (void)stateBits; utils::NotSupported(); }
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+
+        void writeBuffer(IBuffer* buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
+        void clearBufferUInt(IBuffer* buffer, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override { (void)data; (void)byteSize; }
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void beginRenderPassScope(const RenderPassScope& scope) override;
+        void endRenderPassScope() override { }
+        void executeBundle(ICommandBundle* bundle) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndexedMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes) override;
+        void executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+            uint32_t countOffsetBytes) override { (void)layout; (void)paramOffsetBytes; (void)maxCommandCount; (void)countOffsetBytes; utils::NotSupported(); }
+
+        void setMeshletState(const MeshletState& state) override { (void)state; utils::NotSupported(); }
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override { (void)groupsX; (void)groupsY; (void)groupsZ; utils::NotSupported(); }
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override { (void)offsetBytes; (void)drawCount; utils::NotSupported(); }
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override
+            { (void)paramOffsetBytes; (void)countOffsetBytes; (void)maxDrawCount; utils::NotSupported(); }
+
+        void setRayTracingState(const rt::State& state) override { (void)state; utils::NotSupported(); }
+        void dispatchRays(const rt::DispatchRaysArguments& args) override { (void)args; utils::NotSupported(); }
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override { (void)omm; (void)desc; utils::NotSupported(); }
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override
+            { (void)as; (void)pGeometries; (void)numGeometries; (void)buildFlags; utils::NotSupported(); }
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override { (void)pBuilds; (void)numBuilds; utils::NotSupported(); }
+        void compactBottomLevelAccelStructs() override { }
+        void writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override { (void)as; (void)buffer; (void)offset; utils::NotSupported(); }
+        void serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override { (void)as; (void)buffer; (void)offset; utils::NotSupported(); }
+        void deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override { (void)as; (void)buffer; (void)offset; utils::NotSupported(); }
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override
+            { (void)as; (void)pInstances; (void)numInstances; (void)buildFlags; utils::NotSupported(); }
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override
+            { (void)as; (void)instanceBuffer; (void)instanceBufferOffset; (void)numInstances; (void)buildFlags; utils::NotSupported(); }
+        rt::IndirectInstanceDesc* allocateTopLevelInstances(size_t numInstances) override { (void)numInstances; utils::NotSupported(); return nullptr; }
+        void buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override
+            { (void)as; (void)pInstances; (void)numInstances; (void)buildFlags; utils::NotSupported(); }
+        void updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override
+            { (void)as; (void)firstInstance; (void)pInstances; (void)numInstances; utils::NotSupported(); }
+        void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override { (void)desc; utils::NotSupported(); }
+
+        void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override { (void)convertDescs; (void)numDescs; utils::NotSupported(); }
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+        void resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override { (void)pool; (void)firstQuery; (void)queryCount; }
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override { (void)pool; (void)firstQuery; (void)queryCount; }
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override { (void)pool; (void)queryIndex; }
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override { (void)pool; (void)queryIndex; }
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes) override;
+        void beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op) override;
+        void endPredication() override { }
+
+        void beginMarker(const char* name) override { (void)name; }
+        void endMarker() override { }
+
+        void setEnableAutomaticBarriers(bool enable) override { m_EnableAutomaticBarriers = enable; }
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override { (void)as; (void)stateBits; }
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
+        void commitBarriers() override;
+
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
+        ResourceStates getBufferState(IBuffer* buffer) override;
+
+        IDevice* getDevice() override;
+        const CommandListParameters& getDesc() override { return m_CommandListParameters; }
+        BarrierStatistics getBarrierStatistics() override { return m_StateTracker.getStatistics(); }
+        CommandListStatistics getStatistics() override;
+
+        // Internal interface
+
+        void executed();
+        void recordStateFixups(const std::vector<StateFixup>& fixups);
+
+        CommandListResourceStateTracker& getStateTracker() { return m_StateTracker; }
+
+    private:
+        Device* m_Device;
+        const Context& m_Context;
+        CommandListParameters m_CommandListParameters;
+
+        CommandListResourceStateTracker m_StateTracker;
+        bool m_EnableAutomaticBarriers = true;
+
+        UploadManager m_UploadManager;
+
+        GraphicsState m_CurrentGraphicsState;
+        ComputeState m_CurrentComputeState;
+        bool m_BindingStatesDirty = false;
+
+        // Objects used by the commands in the current recording, released when it's executed
+        std::vector<ResourceHandle> m_ReferencedResources;
+        std::vector<BindingSetHandle> m_TransientBindingSets;
+
+        CommandListStatistics m_Statistics;
+
+        void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
+        void requireBufferState(IBuffer* buffer, ResourceStates state);
+
+        void insertResourceBarriersForBindingSets(const BindingSetVector& newBindings, const BindingSetVector& oldBindings);
+        void insertGraphicsResourceBarriers(const GraphicsState& state);
+        void insertComputeResourceBarriers(const ComputeState& state);
+    };
+
+    class Device : public RefCounter<IDevice>
+    {
+    public:
+        explicit Device(const DeviceDesc& desc);
+        ~Device() override;
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override { (void)objectType; return nullptr; }
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void* mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch) override;
+        void unmapStagingTexture(IStagingTexture* tex) override { (void)tex; }
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override
+            { (void)texture; (void)tileMappings; (void)numTileMappings; (void)executionQueue; }
+        void updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue = CommandQueue::Graphics) override
+            { (void)updates; (void)numUpdates; (void)executionQueue; }
+
+        SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override { (void)pairedTexture; (void)desc; return nullptr; }
+        SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override { (void)objectType; (void)texture; (void)pairedTexture; return nullptr; }
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        BufferHandle createBufferFromHostMemory(const BufferDesc& d, void* hostMemory) override;
+        void* mapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess) override;
+        void* mapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess, uint64_t offset, size_t size) override;
+        void unmapBuffer(IBuffer* buffer) override { (void)buffer; }
+        void flushMappedRange(IBuffer* buffer, uint64_t offset, size_t size) override { (void)buffer; (void)offset; (void)size; }
+        void invalidateMappedRange(IBuffer* buffer, uint64_t offset, size_t size) override { (void)buffer; (void)offset; (void)size; }
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override { (void)binary; (void)binarySize; return nullptr; }
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        EventQueryHandle createEventQuery() override;
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override;
+        bool pollEventQuery(IEventQuery* query) override;
+        void waitEventQuery(IEventQuery* query) override { (void)query; }
+        void resetEventQuery(IEventQuery* query) override;
+
+        TimerQueryHandle createTimerQuery() override;
+        bool pollTimerQuery(ITimerQuery* query) override;
+        float getTimerQueryTime(ITimerQuery* query) override { (void)query; return 0.f; }
+        void resetTimerQuery(ITimerQuery* query) override;
+
+        TimestampQueryPoolHandle createTimestampQueryPool(const TimestampQueryPoolDesc& desc) override;
+        bool getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) override;
+        uint64_t getTimestampFrequency(CommandQueue queue) override { (void)queue; return 1000000000ull; }
+
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
+
+        GraphicsAPI getGraphicsAPI() override { return GraphicsAPI::NONE; }
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+        IndirectCommandLayoutHandle createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc) override { (void)desc; return nullptr; }
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override { (void)desc; (void)fbinfo; return nullptr; }
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override { (void)desc; (void)fb; return nullptr; }
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override { (void)desc; return nullptr; }
+        rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override { (void)pipeline; (void)additions; return nullptr; }
+        PendingPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createGraphicsPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override { return m_PipelineCompilePool.createComputePipeline(this, desc); }
+        PendingPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createMeshletPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override { return m_PipelineCompilePool.createRayTracingPipeline(this, desc); }
+        PendingPipelineHandle addToRayTracingPipelineAsync(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override { return m_PipelineCompilePool.addToRayTracingPipeline(this, pipeline, additions); }
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override { (void)desc; return nullptr; }
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override { (void)desc; return nullptr; }
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override { (void)as; return MemoryRequirements(); }
+        rt::AccelStructBuildSizes getAccelStructBuildSizes(const rt::AccelStructDesc& desc) override { (void)desc; return rt::AccelStructBuildSizes(); }
+        bool isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header) override { (void)header; return false; }
+        rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override { (void)params; return rt::cluster::OperationSizeInfo(); }
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override { (void)as; (void)heap; (void)offset; return false; }
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override { (void)waitQueue; (void)executionQueue; (void)instance; }
+        void executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances = nullptr) override;
+        bool waitForIdle() override { return true; }
+        void runGarbageCollection() override { if (m_ShaderCache) m_ShaderCache->prune(); }
+        bool runIncrementalGarbageCollection(const GarbageCollectionBudget& budget) override { (void)budget; return true; }
+        void setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds = 2) override { (void)enable; (void)intervalMilliseconds; }
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
+        FormatSupport queryFormatSupport(Format format) override;
+        coopvec::DeviceFeatures queryCoopVecFeatures() override { return coopvec::DeviceFeatures(); }
+        size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override { (void)type; (void)layout; (void)rows; (void)columns; return 0; }
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { (void)objectType; (void)queue; return nullptr; }
+        IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
+        void setInstrumentationCallback(IInstrumentationCallback* callback) override { m_Context.instrumentation.set(callback); }
+        bool isAftermathEnabled() override { return false; }
+        AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+        bool getPipelineCacheData(void* data, size_t* dataSize) override { (void)data; (void)dataSize; return false; }
+        UploadRingStatistics getUploadRingStatistics(CommandQueue queue) override { (void)queue; return UploadRingStatistics(); }
+        MemoryStatistics getMemoryStatistics() override;
+        void enumerateResourceAllocations(IResourceAllocationCallback& callback) override { m_Context.memoryCounters.enumerateAllocations(callback); }
+        BarrierStatistics getBarrierStatistics(CommandQueue queue) override;
+        void resetBarrierStatistics() override;
+        CommandListStatistics getCommandListStatistics(CommandQueue queue) override;
+        void resetCommandListStatistics() override;
+        PipelineCreationStatistics getPipelineCreationStatistics() override { return m_Context.pipelineCounters.get(); }
+        void resetPipelineCreationStatistics() override { m_Context.pipelineCounters.reset(); }
+
+    private:
+        Context m_Context;
+        DeviceDesc m_Desc;
+
+        // Fake GPU addresses for buffers, allocated linearly and never reused
+        std::atomic<uint64_t> m_NextGpuAddress { 0x10000 };
+
+        // Last instance submitted on each queue; the work is complete as soon as it's submitted
+        std::array<std::atomic<uint64_t>, uint32_t(CommandQueue::Count)> m_LastSubmittedInstances {};
+
+        std::mutex m_StatisticsMutex;
+        std::array<BarrierStatistics, uint32_t(CommandQueue::Count)> m_BarrierStatistics;
+        std::array<CommandListStatistics, uint32_t(CommandQueue::Count)> m_CommandListStatistics;
+
+        // Deferred initial states of the command lists being submitted, see CommandListParameters::deferInitialStates
+        std::mutex m_SubmitMutex;
+        std::vector<StateFixup> m_StateFixups;
+        std::vector<ICommandList*> m_ResolvedCommandLists;
+        std::array<std::vector<CommandListHandle>, uint32_t(CommandQueue::Count)> m_StateFixupCommandLists;
+
+        AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
+        PipelineCompilePool m_PipelineCompilePool;
+        std::unique_ptr<ShaderCache> m_ShaderCache; // null unless DeviceDesc::enableShaderCache
+        std::unique_ptr<StateObjectTables> m_InternedStates; // null unless DeviceDesc::enableStateObjectInterning
+
+        bool isQueueEnabled(CommandQueue queue) const;
+        void resolveDeferredInitialStates(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, size_t& fixupsUsed);
+        uint64_t submit(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue);
+    };
+
+} // namespace nvrhi::null
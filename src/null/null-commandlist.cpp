@@ -0,0 +1,935 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace nvrhi::null
+{
+    // Row pitch alignment of the upload data for writeTexture, the same as D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    static constexpr uint32_t c_TextureRowPitchAlignment = 256;
+
+    CommandList::CommandList(Device* device, const Context& context, const CommandListParameters& parameters)
+        : m_Device(device)
+        , m_Context(context)
+        , m_CommandListParameters(parameters)
+        , m_StateTracker(context.messageCallback)
+        , m_UploadManager(context, parameters.uploadChunkSize)
+    {
+        m_StateTracker.setDeferInitialStates(parameters.deferInitialStates);
+        m_StateTracker.setEnableStatistics(parameters.enableBarrierStatistics);
+    }
+
+    IDevice* CommandList::getDevice()
+    {
+        return m_Device;
+    }
+
+    CommandListStatistics CommandList::getStatistics()
+    {
+        CommandListStatistics statistics = m_Statistics;
+        statistics.uploadBytes = m_UploadManager.getSuballocatedBytes();
+        return statistics;
+    }
+
+    void CommandList::open()
+    {
+        m_StateTracker.resetStatistics();
+        m_Statistics = CommandListStatistics();
+        m_UploadManager.resetSuballocatedBytes();
+
+        // A previous recording that was never executed is discarded
+        m_ReferencedResources.clear();
+        m_TransientBindingSets.clear();
+
+        clearState();
+    }
+
+    void CommandList::close()
+    {
+        m_StateTracker.endSplitTransitions();
+        m_StateTracker.keepBufferInitialStates();
+        m_StateTracker.keepTextureInitialStates();
+        commitBarriers();
+
+        clearState();
+    }
+
+    void CommandList::clearState()
+    {
+        m_CurrentGraphicsState = GraphicsState();
+        m_CurrentComputeState = ComputeState();
+        m_BindingStatesDirty = true;
+    }
+
+    void CommandList::executed()
+    {
+        m_StateTracker.commandListSubmitted();
+        m_UploadManager.submitChunks();
+
+        m_ReferencedResources.clear();
+        m_TransientBindingSets.clear();
+    }
+
+    void CommandList::recordStateFixups(const std::vector<StateFixup>& fixups)
+    {
+        for (const StateFixup& fixup : fixups)
+        {
+            if (fixup.texture)
+            {
+                m_StateTracker.beginTrackingTextureState(fixup.texture, AllSubresources, fixup.stateBefore);
+                m_StateTracker.requireTextureState(fixup.texture, AllSubresources, fixup.stateAfter);
+            }
+            else
+            {
+                m_StateTracker.beginTrackingBufferState(fixup.buffer, fixup.stateBefore);
+                m_StateTracker.requireBufferState(fixup.buffer, fixup.stateAfter);
+            }
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::commitBarriers()
+    {
+        if (!m_StateTracker.hasPendingBarriers())
+            return;
+
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CommitBarriers);
+
+        // There is nothing to submit the barriers to, but the counters reflect what a native backend would emit
+        NVRHI_COUNT_STATISTIC(m_Statistics, barriers, m_StateTracker.getTextureBarriers().size() + m_StateTracker.getBufferBarriers().size()
+            + (m_StateTracker.getAliasingBarriers().empty() ? 0 : 1));
+
+        m_StateTracker.clearBarriers();
+    }
+
+    void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.requireTextureState(texture, subresources, state);
+    }
+
+    void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.requireBufferState(buffer, state);
+    }
+
+    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    {
+        if (_bindingSet == nullptr)
+            return;
+        if (_bindingSet->getDesc() == nullptr)
+            return; // is bindless
+
+        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+        // Sets with UAVs may need UAV barriers on every use, so they can't be skipped
+        m_StateTracker.requireResourceStates(bindingSet->requiredStates, bindingSet->hasUavBindings ? nullptr : bindingSet);
+    }
+
+    void CommandList::insertResourceBarriersForBindingSets(const BindingSetVector& newBindings, const BindingSetVector& oldBindings)
+    {
+        uint32_t bindingUpdateMask = 0;
+
+        if (m_BindingStatesDirty)
+            bindingUpdateMask = ~0u;
+
+        if (bindingUpdateMask == 0)
+            bindingUpdateMask = arrayDifferenceMask(newBindings, oldBindings);
+
+        if (bindingUpdateMask != 0)
+        {
+            for (size_t i = 0; i < newBindings.size(); i++)
+            {
+                if (newBindings[i]->getDesc() == nullptr) // Ignore bindless sets
+                    continue;
+
+                BindingSet const* bindingSet = checked_cast<BindingSet const*>(newBindings[i]);
+
+                bool const updateThisSet = (bindingUpdateMask & (1u << i)) != 0;
+                if (updateThisSet || bindingSet->hasUavBindings) // UAV bindings may place UAV barriers on the same binding set
+                    setResourceStatesForBindingSet(newBindings[i]);
+            }
+        }
+    }
+
+    void CommandList::insertGraphicsResourceBarriers(const GraphicsState& state)
+    {
+        insertResourceBarriersForBindingSets(state.bindings, m_CurrentGraphicsState.bindings);
+
+        if (state.indexBuffer.buffer && (m_BindingStatesDirty || state.indexBuffer.buffer != m_CurrentGraphicsState.indexBuffer.buffer))
+        {
+            requireBufferState(state.indexBuffer.buffer, ResourceStates::IndexBuffer);
+        }
+
+        if (m_BindingStatesDirty || arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
+        {
+            for (const auto& vb : state.vertexBuffers)
+            {
+                requireBufferState(vb.buffer, ResourceStates::VertexBuffer);
+            }
+        }
+
+        if (m_BindingStatesDirty || m_CurrentGraphicsState.framebuffer != state.framebuffer)
+        {
+            setResourceStatesForFramebuffer(state.framebuffer);
+        }
+
+        if (state.indirectParams && (m_BindingStatesDirty || state.indirectParams != m_CurrentGraphicsState.indirectParams))
+        {
+            requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
+        }
+
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentGraphicsState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
+        m_BindingStatesDirty = false;
+    }
+
+    void CommandList::insertComputeResourceBarriers(const ComputeState& state)
+    {
+        insertResourceBarriersForBindingSets(state.bindings, m_CurrentComputeState.bindings);
+
+        if (state.indirectParams && (m_BindingStatesDirty || state.indirectParams != m_CurrentComputeState.indirectParams))
+        {
+            requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
+        }
+
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentComputeState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
+        m_BindingStatesDirty = false;
+    }
+
+    void CommandList::clearTextureFloat(ITexture* texture, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        (void)clearColor;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, subresources, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::clearDepthStencilTexture(ITexture* texture, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        (void)depth;
+        (void)stencil;
+
+        if (!clearDepth && !clearStencil)
+            return;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, subresources, ResourceStates::DepthWrite);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::clearTextureUInt(ITexture* texture, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        (void)clearColor;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(texture, subresources, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(src, TextureSubresourceSet(srcSlice.mipLevel, 1, srcSlice.arraySlice, 1), ResourceStates::CopySource);
+            requireTextureState(dest, TextureSubresourceSet(destSlice.mipLevel, 1, destSlice.arraySlice, 1), ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        // Device-local textures have no contents, so the staging memory is left unchanged
+        (void)destSlice;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(src, TextureSubresourceSet(srcSlice.mipLevel, 1, srcSlice.arraySlice, 1), ResourceStates::CopySource);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice)
+    {
+        (void)srcSlice;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(destSlice.mipLevel, 1, destSlice.arraySlice, 1), ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        // Repack the data into upload memory with aligned rows, like the D3D12 backend does
+        const FormatInfo& formatInfo = getFormatInfo(dest->desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+        const uint64_t width = std::max(dest->desc.width >> mipLevel, 1u);
+        const uint64_t height = std::max(dest->desc.height >> mipLevel, 1u);
+        const uint64_t depth = dest->desc.dimension == TextureDimension::Texture3D ? std::max(dest->desc.depth >> mipLevel, 1u) : 1u;
+        const uint64_t numRows = (height + blockSize - 1) / blockSize;
+        const uint64_t rowSize = ((width + blockSize - 1) / blockSize) * formatInfo.bytesPerBlock;
+        const uint64_t uploadRowPitch = align(rowSize, uint64_t(c_TextureRowPitchAlignment));
+
+        uint8_t* uploadData = m_UploadManager.suballocate(uploadRowPitch * numRows * depth, c_TextureRowPitchAlignment);
+
+        for (uint64_t depthSlice = 0; depthSlice < depth; depthSlice++)
+        {
+            for (uint64_t row = 0; row < numRows; row++)
+            {
+                const uint8_t* srcRow = static_cast<const uint8_t*>(data) + depthSlice * depthPitch + row * rowPitch;
+                memcpy(uploadData + (depthSlice * numRows + row) * uploadRowPitch, srcRow, size_t(std::min<uint64_t>(rowSize, rowPitch)));
+            }
+        }
+
+        m_ReferencedResources.push_back(dest);
+    }
+
+    void CommandList::writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions)
+    {
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            const TextureUploadRegion& region = regions[i];
+            writeTexture(dest, region.slice.arraySlice, region.slice.mipLevel, region.data, region.rowPitch, region.depthPitch);
+        }
+    }
+
+    void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(src, srcSubresources.resolve(src->desc, false), ResourceStates::ResolveSource);
+            requireTextureState(dest, dstSubresources.resolve(dest->desc, false), ResourceStates::ResolveDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::writeBuffer(IBuffer* _buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        assert(destOffsetBytes + dataSize <= buffer->desc.byteSize);
+
+        m_ReferencedResources.push_back(buffer);
+
+        if (buffer->desc.isVolatile)
+        {
+            assert(destOffsetBytes == 0);
+            NVRHI_COUNT_STATISTIC(m_Statistics, volatileConstantBufferWrites, 1);
+
+            // Volatile buffers get a new version in upload memory on every write
+            uint8_t* uploadData = m_UploadManager.suballocate(dataSize, c_ConstantBufferOffsetSizeAlignment);
+            memcpy(uploadData, data, dataSize);
+            return;
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        uint8_t* uploadData = m_UploadManager.suballocate(dataSize, 4);
+        memcpy(uploadData, data, dataSize);
+
+        // Buffers that the application can read see the written data, as they would after the copy completes
+        if (buffer->mappedMemory)
+            memcpy(static_cast<uint8_t*>(buffer->mappedMemory) + destOffsetBytes, data, dataSize);
+    }
+
+    void CommandList::clearBufferUInt(IBuffer* _buffer, uint32_t clearValue)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        if (buffer->mappedMemory)
+        {
+            uint32_t* words = static_cast<uint32_t*>(buffer->mappedMemory);
+            std::fill_n(words, size_t(buffer->desc.byteSize / sizeof(uint32_t)), clearValue);
+        }
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        Buffer* dest = checked_cast<Buffer*>(_dest);
+        Buffer* src = checked_cast<Buffer*>(_src);
+
+        assert(destOffsetBytes + dataSizeBytes <= dest->desc.byteSize);
+        assert(srcOffsetBytes + dataSizeBytes <= src->desc.byteSize);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(src, ResourceStates::CopySource);
+            requireBufferState(dest, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        if (dest->mappedMemory && src->mappedMemory)
+        {
+            memmove(static_cast<uint8_t*>(dest->mappedMemory) + destOffsetBytes,
+                static_cast<const uint8_t*>(src->mappedMemory) + srcOffsetBytes, size_t(dataSizeBytes));
+        }
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
+        BindingSet* bindingSet = new BindingSet();
+        bindingSet->desc = desc;
+        bindingSet->layout = layout;
+        bindingSet->initialize(m_Context);
+
+        NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, desc.bindings.size());
+
+        // the command list owns the binding set until it's executed
+        BindingSetHandle handle = BindingSetHandle::Create(bindingSet);
+        m_TransientBindingSets.push_back(handle);
+        return bindingSet;
+    }
+
+    void CommandList::setGraphicsState(const GraphicsState& state)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            insertGraphicsResourceBarriers(state);
+        }
+
+        commitBarriers();
+
+        if (m_CurrentGraphicsState.pipeline != state.pipeline)
+        {
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
+            m_ReferencedResources.push_back(state.pipeline);
+        }
+
+        if (m_CurrentGraphicsState.framebuffer != state.framebuffer)
+        {
+            NVRHI_COUNT_STATISTIC(m_Statistics, renderPasses, 1);
+            m_ReferencedResources.push_back(state.framebuffer);
+        }
+
+        if (arraysAreDifferent(m_CurrentGraphicsState.bindings, state.bindings))
+        {
+            NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, state.bindings.size());
+
+            for (IBindingSet* bindingSet : state.bindings)
+                m_ReferencedResources.push_back(bindingSet);
+        }
+
+        if (state.indexBuffer.buffer && m_CurrentGraphicsState.indexBuffer != state.indexBuffer)
+            m_ReferencedResources.push_back(state.indexBuffer.buffer);
+
+        if (!state.vertexBuffers.empty() && arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
+        {
+            for (const VertexBufferBinding& binding : state.vertexBuffers)
+                m_ReferencedResources.push_back(binding.buffer);
+        }
+
+        if (state.indirectParams && state.indirectParams != m_CurrentGraphicsState.indirectParams)
+            m_ReferencedResources.push_back(state.indirectParams);
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentGraphicsState.indirectCountBuffer)
+            m_ReferencedResources.push_back(state.indirectCountBuffer);
+
+        m_CurrentComputeState = ComputeState();
+        m_CurrentGraphicsState = state;
+    }
+
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        assert(m_CurrentGraphicsState.pipeline);
+
+        GraphicsState state = m_CurrentGraphicsState;
+        if (slot >= state.bindings.size())
+            state.bindings.resize(slot + 1);
+        state.bindings[slot] = bindingSet;
+
+        setGraphicsState(state);
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings)
+    {
+        assert(m_CurrentGraphicsState.pipeline);
+
+        GraphicsState state = m_CurrentGraphicsState;
+        state.vertexBuffers.resize(0);
+        for (size_t i = 0; i < numBindings; i++)
+            state.vertexBuffers.push_back(bindings[i]);
+
+        setGraphicsState(state);
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        assert(m_CurrentGraphicsState.pipeline);
+
+        GraphicsState state = m_CurrentGraphicsState;
+        state.indexBuffer = binding;
+
+        setGraphicsState(state);
+    }
+
+    void CommandList::beginRenderPassScope(const RenderPassScope& scope)
+    {
+        // The states of the whole scope are set up front, as on the backends that keep the pass open
+        if (m_EnableAutomaticBarriers)
+        {
+            setResourceStatesForRenderPassScope(scope);
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+
+        for (const CommandBundleDraw& bundleDraw : bundle->desc.draws)
+        {
+            setGraphicsState(bundleDraw.state);
+
+            if (bundleDraw.indexed)
+                drawIndexed(bundleDraw.args);
+            else
+                draw(bundleDraw.args);
+        }
+
+        m_ReferencedResources.push_back(bundle);
+    }
+
+    void CommandList::draw(const DrawArguments& args)
+    {
+        (void)args;
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::drawIndexed(const DrawArguments& args)
+    {
+        (void)args;
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::drawMulti(const DrawArguments* args, size_t numDraws)
+    {
+        (void)args;
+        (void)numDraws;
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
+    }
+
+    void CommandList::drawIndexedMulti(const DrawArguments* args, size_t numDraws)
+    {
+        (void)args;
+        (void)numDraws;
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
+    }
+
+    void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        assert(m_CurrentGraphicsState.indirectParams);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        assert(m_CurrentGraphicsState.indirectParams);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        assert(m_CurrentGraphicsState.indirectParams);
+        assert(m_CurrentGraphicsState.indirectCountBuffer);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::setComputeState(const ComputeState& state)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            insertComputeResourceBarriers(state);
+        }
+
+        commitBarriers();
+
+        if (m_CurrentComputeState.pipeline != state.pipeline)
+        {
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
+            m_ReferencedResources.push_back(state.pipeline);
+        }
+
+        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings))
+        {
+            NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, state.bindings.size());
+
+            for (IBindingSet* bindingSet : state.bindings)
+                m_ReferencedResources.push_back(bindingSet);
+        }
+
+        if (state.indirectParams && state.indirectParams != m_CurrentComputeState.indirectParams)
+            m_ReferencedResources.push_back(state.indirectParams);
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentComputeState.indirectCountBuffer)
+            m_ReferencedResources.push_back(state.indirectCountBuffer);
+
+        m_CurrentGraphicsState = GraphicsState();
+        m_CurrentComputeState = state;
+    }
+
+    void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        (void)groupsX;
+        (void)groupsY;
+        (void)groupsZ;
+
+        assert(m_CurrentComputeState.pipeline);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
+    }
+
+    void CommandList::dispatchIndirect(uint32_t offsetBytes)
+    {
+        (void)offsetBytes;
+
+        assert(m_CurrentComputeState.indirectParams);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
+    }
+
+    void CommandList::beginTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+        query->resolved = false;
+
+        m_ReferencedResources.push_back(query);
+    }
+
+    void CommandList::endTimerQuery(ITimerQuery* _query)
+    {
+        // The GPU takes no time, so the query reports zero as soon as it's ended
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+        query->resolved = true;
+
+        m_ReferencedResources.push_back(query);
+    }
+
+    void CommandList::resetTimestamps(ITimestampQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        assert(uint64_t(firstQuery) + queryCount <= pool->timestamps.size());
+        std::fill_n(pool->timestamps.begin() + firstQuery, queryCount, 0);
+    }
+
+    void CommandList::writeTimestamp(ITimestampQueryPool* _pool, uint32_t queryIndex)
+    {
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        assert(queryIndex < pool->timestamps.size());
+
+        // Timestamps are taken at recording time, which is when the null device does the work
+        pool->timestamps[queryIndex] = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+
+        m_ReferencedResources.push_back(pool);
+    }
+
+    void CommandList::resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* _dest, uint64_t destOffsetBytes)
+    {
+        // Nothing is rendered, so all queries resolve to zero
+        QueryPool* queryPool = checked_cast<QueryPool*>(pool);
+        Buffer* dest = checked_cast<Buffer*>(_dest);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(dest, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        if (dest->mappedMemory)
+        {
+            const uint64_t stride = queryPool->desc.type == QueryType::PipelineStatistics
+                ? sizeof(PipelineStatistics)
+                : sizeof(uint64_t);
+
+            assert(destOffsetBytes + stride * queryCount <= dest->desc.byteSize);
+            memset(static_cast<uint8_t*>(dest->mappedMemory) + destOffsetBytes, 0, size_t(stride * queryCount));
+        }
+
+        (void)firstQuery;
+
+        m_ReferencedResources.push_back(pool);
+        m_ReferencedResources.push_back(dest);
+    }
+
+    void CommandList::beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        (void)offsetBytes;
+        (void)op;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::Predication);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::setEnableUavBarriersForTexture(ITexture* _texture, bool enableBarriers)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandList::setEnableUavBarriersForBuffer(IBuffer* _buffer, bool enableBarriers)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandList::beginTrackingBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandList::setTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.requireTextureState(texture, subresources, stateBits);
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.requireBufferState(buffer, stateBits);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::setPermanentTextureState(ITexture* _texture, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setPermanentBufferState(buffer, stateBits);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, subresources, stateBits);
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, stateBits);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::releaseTextureOwnership(ITexture* _texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.releaseTextureOwnership(texture, subresources, destinationQueue, stateBits);
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::acquireTextureOwnership(ITexture* _texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.acquireTextureOwnership(texture, subresources, sourceQueue, stateBits);
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::releaseBufferOwnership(IBuffer* _buffer, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.releaseBufferOwnership(buffer, destinationQueue, stateBits);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::acquireBufferOwnership(IBuffer* _buffer, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.acquireBufferOwnership(buffer, sourceQueue, stateBits);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        if (ITexture* textureAfter = dynamic_cast<ITexture*>(resourceAfter))
+        {
+            Texture* texture = checked_cast<Texture*>(textureAfter);
+            m_StateTracker.discardTextureState(texture);
+        }
+        else if (IBuffer* bufferAfter = dynamic_cast<IBuffer*>(resourceAfter))
+        {
+            Buffer* buffer = checked_cast<Buffer*>(bufferAfter);
+            m_StateTracker.discardBufferState(buffer);
+        }
+
+        m_StateTracker.addAliasingBarrier(resourceBefore, resourceAfter);
+
+        if (resourceBefore)
+            m_ReferencedResources.push_back(resourceBefore);
+        if (resourceAfter)
+            m_ReferencedResources.push_back(resourceAfter);
+    }
+
+    ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        return m_StateTracker.getTextureSubresourceState(texture, arraySlice, mipLevel);
+    }
+
+    ResourceStates CommandList::getBufferState(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        return m_StateTracker.getBufferState(buffer);
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,947 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+#include "../common/submit-graph.h"
+
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace nvrhi::null
+{
+    // Placed resources and fake GPU addresses use the same alignment as the D3D12 default placement alignment
+    static constexpr uint64_t c_ResourceAlignment = 65536;
+
+    void Context::error(const std::string& message) const
+    {
+        messageCallback->message(MessageSeverity::Error, message.c_str());
+    }
+
+    uint64_t getTextureSubresourceSize(const TextureDesc& desc, MipLevel mipLevel)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        const uint64_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint64_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint64_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        return ((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize) * depth * formatInfo.bytesPerBlock;
+    }
+
+    static uint64_t getTextureSize(const TextureDesc& desc)
+    {
+        uint64_t size = 0;
+        for (MipLevel mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+            size += getTextureSubresourceSize(desc, mipLevel);
+
+        return size * desc.arraySize * std::max(desc.sampleCount, 1u);
+    }
+
+    DeviceHandle createDevice(const DeviceDesc& desc)
+    {
+        Device* device = new Device(desc);
+        return DeviceHandle::Create(device);
+    }
+
+    Device::Device(const DeviceDesc& desc)
+        : m_Desc(desc)
+        , m_PipelineCompilePool(desc.numPipelineCompileThreads)
+    {
+        m_Context.messageCallback = desc.messageCallback;
+
+        if (desc.enableShaderCache)
+            m_ShaderCache = std::make_unique<ShaderCache>();
+
+        if (desc.enableStateObjectInterning)
+            m_InternedStates = std::make_unique<StateObjectTables>();
+    }
+
+    Device::~Device()
+    {
+        m_PipelineCompilePool.shutdown();
+    }
+
+    bool Device::isQueueEnabled(CommandQueue queue) const
+    {
+        switch (queue)
+        {
+        case CommandQueue::Graphics:
+            return true;
+        case CommandQueue::Compute:
+            return m_Desc.enableComputeQueue;
+        case CommandQueue::Copy:
+            return m_Desc.enableCopyQueue;
+        case CommandQueue::Count:
+        default:
+            return false;
+        }
+    }
+
+    HeapHandle Device::createHeap(const HeapDesc& d)
+    {
+        Heap* heap = new Heap();
+        heap->desc = d;
+        heap->trackedMemory.set(m_Context.memoryCounters, heap);
+
+        return HeapHandle::Create(heap);
+    }
+
+    TextureHandle Device::createTexture(const TextureDesc& d)
+    {
+        Texture* texture = new Texture();
+        texture->desc = d;
+
+        if (!d.isVirtual)
+            texture->trackedMemory.set(m_Context.memoryCounters, texture, getTextureSize(d));
+
+        return TextureHandle::Create(texture);
+    }
+
+    MemoryRequirements Device::getTextureMemoryRequirements(ITexture* _texture)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        MemoryRequirements memReq;
+        memReq.size = align(getTextureSize(texture->desc), c_ResourceAlignment);
+        memReq.alignment = c_ResourceAlignment;
+        return memReq;
+    }
+
+    bool Device::bindTextureMemory(ITexture* _texture, IHeap* heap, uint64_t offset)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (texture->heap || !texture->desc.isVirtual)
+            return false;
+
+        if (offset + getTextureSize(texture->desc) > heap->getDesc().capacity)
+            return false;
+
+        texture->heap = heap;
+        texture->trackedMemory.setPlaced(m_Context.memoryCounters, texture, getTextureSize(texture->desc), heap, offset);
+        return true;
+    }
+
+    TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        // There are no native objects to wrap, the handle only carries the description and state tracking
+        (void)objectType;
+        (void)texture;
+
+        Texture* ret = new Texture();
+        ret->desc = desc;
+
+        return TextureHandle::Create(ret);
+    }
+
+    StagingTextureHandle Device::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        StagingTexture* texture = new StagingTexture();
+        texture->desc = d;
+        texture->cpuAccess = cpuAccess;
+
+        uint64_t size = 0;
+        texture->subresourceOffsets.reserve(size_t(d.mipLevels) * d.arraySize);
+        for (MipLevel mipLevel = 0; mipLevel < d.mipLevels; mipLevel++)
+        {
+            const uint64_t subresourceSize = getTextureSubresourceSize(d, mipLevel);
+            for (ArraySlice arraySlice = 0; arraySlice < d.arraySize; arraySlice++)
+            {
+                texture->subresourceOffsets.push_back(size);
+                size += subresourceSize;
+            }
+        }
+
+        texture->memory.resize(size);
+        texture->trackedMemory.set(m_Context.memoryCounters, texture, cpuAccess, size);
+
+        return StagingTextureHandle::Create(texture);
+    }
+
+    void* Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        (void)cpuAccess;
+
+        StagingTexture* tex = checked_cast<StagingTexture*>(_tex);
+        const TextureSlice resolvedSlice = slice.resolve(tex->desc);
+
+        assert(resolvedSlice.x == 0);
+        assert(resolvedSlice.y == 0);
+
+        const FormatInfo& formatInfo = getFormatInfo(tex->desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+        const uint64_t width = std::max(tex->desc.width >> resolvedSlice.mipLevel, 1u);
+        const uint64_t height = std::max(tex->desc.height >> resolvedSlice.mipLevel, 1u);
+        const uint64_t rowPitch = ((width + blockSize - 1) / blockSize) * formatInfo.bytesPerBlock;
+        const uint64_t depthPitch = rowPitch * ((height + blockSize - 1) / blockSize);
+
+        if (outRowPitch)
+            *outRowPitch = size_t(rowPitch);
+
+        const size_t subresource = size_t(resolvedSlice.mipLevel) * tex->desc.arraySize + resolvedSlice.arraySlice;
+        return tex->memory.data() + tex->subresourceOffsets[subresource] + resolvedSlice.z * depthPitch;
+    }
+
+    void Device::getTextureTiling(ITexture* _texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        // Reports a texture without standard tiles, so that callers fall back to their non-tiled paths
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (numTiles)
+            *numTiles = 0;
+
+        if (desc)
+        {
+            desc->numStandardMips = 0;
+            desc->numPackedMips = texture->desc.mipLevels;
+            desc->numTilesForPackedMips = 0;
+            desc->startTileIndexInOverallResource = 0;
+        }
+
+        if (tileShape)
+            *tileShape = TileShape();
+
+        if (subresourceTilingsNum)
+            *subresourceTilingsNum = 0;
+
+        (void)subresourceTilings;
+    }
+
+    BufferHandle Device::createBuffer(const BufferDesc& d)
+    {
+        Buffer* buffer = new Buffer();
+        buffer->desc = d;
+        buffer->gpuAddress = m_NextGpuAddress.fetch_add(align(std::max<uint64_t>(d.byteSize, 1), c_ResourceAlignment));
+
+        // Only the buffers that the application can read or write directly need backing memory
+        if (d.cpuAccess != CpuAccessMode::None && !d.isVirtual)
+        {
+            buffer->hostMemory.resize(d.byteSize);
+            buffer->mappedMemory = buffer->hostMemory.data();
+        }
+
+        if (!d.isVirtual)
+            buffer->trackedMemory.set(m_Context.memoryCounters, buffer, d.byteSize);
+
+        return BufferHandle::Create(buffer);
+    }
+
+    BufferHandle Device::createBufferFromHostMemory(const BufferDesc& d, void* hostMemory)
+    {
+        if (!hostMemory)
+        {
+            m_Context.error("createBufferFromHostMemory: hostMemory must not be null");
+            return nullptr;
+        }
+
+        Buffer* buffer = new Buffer();
+        buffer->desc = d;
+        buffer->gpuAddress = m_NextGpuAddress.fetch_add(align(std::max<uint64_t>(d.byteSize, 1), c_ResourceAlignment));
+        buffer->mappedMemory = hostMemory;
+
+        return BufferHandle::Create(buffer);
+    }
+
+    void* Device::mapBuffer(IBuffer* _buffer, CpuAccessMode cpuAccess)
+    {
+        (void)cpuAccess;
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (!buffer->mappedMemory)
+        {
+            std::stringstream ss;
+            ss << "Buffer " << utils::DebugNameToString(buffer->desc.debugName) << " cannot be mapped because it was created without CPU access";
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        return buffer->mappedMemory;
+    }
+
+    void* Device::mapBuffer(IBuffer* _buffer, CpuAccessMode cpuAccess, uint64_t offset, size_t size)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        assert(offset + size <= buffer->desc.byteSize);
+        (void)size;
+
+        uint8_t* memory = static_cast<uint8_t*>(mapBuffer(buffer, cpuAccess));
+        return memory ? memory + offset : nullptr;
+    }
+
+    MemoryRequirements Device::getBufferMemoryRequirements(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        MemoryRequirements memReq;
+        memReq.size = align(buffer->desc.byteSize, c_ResourceAlignment);
+        memReq.alignment = c_ResourceAlignment;
+        return memReq;
+    }
+
+    bool Device::bindBufferMemory(IBuffer* _buffer, IHeap* heap, uint64_t offset)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (buffer->heap || !buffer->desc.isVirtual)
+            return false;
+
+        if (offset + buffer->desc.byteSize > heap->getDesc().capacity)
+            return false;
+
+        buffer->heap = heap;
+        buffer->trackedMemory.setPlaced(m_Context.memoryCounters, buffer, buffer->desc.byteSize, heap, offset);
+
+        if (buffer->desc.cpuAccess != CpuAccessMode::None)
+        {
+            buffer->hostMemory.resize(buffer->desc.byteSize);
+            buffer->mappedMemory = buffer->hostMemory.data();
+        }
+
+        return true;
+    }
+
+    BufferHandle Device::createHandleForNativeBuffer(ObjectType objectType, Object _buffer, const BufferDesc& desc)
+    {
+        (void)objectType;
+        (void)_buffer;
+
+        Buffer* buffer = new Buffer();
+        buffer->desc = desc;
+        buffer->gpuAddress = m_NextGpuAddress.fetch_add(align(std::max<uint64_t>(desc.byteSize, 1), c_ResourceAlignment));
+
+        return BufferHandle::Create(buffer);
+    }
+
+    void Shader::getBytecode(const void** ppBytecode, size_t* pSize) const
+    {
+        if (ppBytecode) *ppBytecode = bytecode.data();
+        if (pSize) *pSize = bytecode.size();
+    }
+
+    ShaderHandle Device::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        const bool useCache = m_ShaderCache && ShaderCache::isCacheable(d);
+        uint64_t cacheKey = 0;
+        if (useCache)
+        {
+            cacheKey = ShaderCache::getKey(d, binary, binarySize);
+            if (ShaderHandle cachedShader = m_ShaderCache->find(cacheKey, d, binary, binarySize))
+                return cachedShader;
+        }
+
+        Shader* shader = new Shader();
+        shader->desc = d;
+        shader->bytecode.assign(static_cast<const char*>(binary), static_cast<const char*>(binary) + binarySize);
+
+        ShaderHandle shaderHandle = ShaderHandle::Create(shader);
+
+        if (useCache)
+            return m_ShaderCache->insert(cacheKey, d, binary, binarySize, shaderHandle);
+
+        return shaderHandle;
+    }
+
+    ShaderHandle Device::createShaderSpecialization(IShader* _baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        // Shaders are never compiled, so a specialization is just a copy of the base shader
+        Shader* baseShader = checked_cast<Shader*>(_baseShader);
+
+        uint64_t cacheKey = 0;
+        if (m_ShaderCache)
+        {
+            cacheKey = ShaderCache::getKey(_baseShader, constants, numConstants);
+            if (ShaderHandle cachedShader = m_ShaderCache->find(cacheKey, _baseShader, constants, numConstants))
+                return cachedShader;
+        }
+
+        Shader* shader = new Shader();
+        shader->desc = baseShader->desc;
+        shader->bytecode = baseShader->bytecode;
+
+        ShaderHandle shaderHandle = ShaderHandle::Create(shader);
+
+        if (m_ShaderCache)
+            return m_ShaderCache->insert(cacheKey, _baseShader, constants, numConstants, shaderHandle);
+
+        return shaderHandle;
+    }
+
+    SamplerHandle Device::createSampler(const SamplerDesc& d)
+    {
+        if (m_InternedStates)
+        {
+            if (SamplerHandle existing = m_InternedStates->samplers.find(d))
+                return existing;
+        }
+
+        Sampler* sampler = new Sampler();
+        sampler->desc = d;
+        SamplerHandle samplerHandle = SamplerHandle::Create(sampler);
+
+        if (m_InternedStates)
+            return m_InternedStates->samplers.insert(d, sampler, sampler->internEntry);
+
+        return samplerHandle;
+    }
+
+    InputLayoutHandle Device::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        (void)vertexShader;
+
+        std::vector<VertexAttributeDesc> internKey;
+        if (m_InternedStates)
+        {
+            internKey.assign(d, d + attributeCount);
+            if (InputLayoutHandle existing = m_InternedStates->inputLayouts.find(internKey))
+                return existing;
+        }
+
+        InputLayout* layout = new InputLayout();
+        layout->attributes.assign(d, d + attributeCount);
+        InputLayoutHandle layoutHandle = InputLayoutHandle::Create(layout);
+
+        if (m_InternedStates)
+            return m_InternedStates->inputLayouts.insert(internKey, layout, layout->internEntry);
+
+        return layoutHandle;
+    }
+
+    EventQueryHandle Device::createEventQuery()
+    {
+        return EventQueryHandle::Create(new EventQuery());
+    }
+
+    void Device::setEventQuery(IEventQuery* _query, CommandQueue queue)
+    {
+        (void)queue;
+
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+        query->signaled = true;
+    }
+
+    bool Device::pollEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+        return query->signaled;
+    }
+
+    void Device::resetEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+        query->signaled = false;
+    }
+
+    TimerQueryHandle Device::createTimerQuery()
+    {
+        return TimerQueryHandle::Create(new TimerQuery());
+    }
+
+    bool Device::pollTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+        return query->resolved;
+    }
+
+    void Device::resetTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+        query->resolved = false;
+    }
+
+    TimestampQueryPoolHandle Device::createTimestampQueryPool(const TimestampQueryPoolDesc& desc)
+    {
+        TimestampQueryPool* pool = new TimestampQueryPool();
+        pool->desc = desc;
+        pool->timestamps.resize(desc.queryCount);
+
+        return TimestampQueryPoolHandle::Create(pool);
+    }
+
+    bool Device::getTimestampResults(ITimestampQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps)
+    {
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        if (uint64_t(firstQuery) + queryCount > pool->timestamps.size())
+            return false;
+
+        std::copy_n(pool->timestamps.begin() + firstQuery, queryCount, outTimestamps);
+        return true;
+    }
+
+    QueryPoolHandle Device::createQueryPool(const QueryPoolDesc& desc)
+    {
+        QueryPool* pool = new QueryPool();
+        pool->desc = desc;
+
+        return QueryPoolHandle::Create(pool);
+    }
+
+    FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
+    {
+        Framebuffer* fb = new Framebuffer();
+        fb->desc = desc;
+        fb->framebufferInfo = FramebufferInfoEx(desc);
+
+        for (const FramebufferAttachment& attachment : desc.colorAttachments)
+            fb->resources.push_back(attachment.texture);
+
+        if (desc.depthAttachment.valid())
+            fb->resources.push_back(desc.depthAttachment.texture);
+
+        if (desc.shadingRateAttachment.valid())
+            fb->resources.push_back(desc.shadingRateAttachment.texture);
+
+        return FramebufferHandle::Create(fb);
+    }
+
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (desc.draws.empty())
+        {
+            m_Context.error("Cannot create a command bundle without draws");
+            return nullptr;
+        }
+
+        CommandBundle* bundle = new CommandBundle();
+        bundle->desc = desc;
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            const GraphicsState& state = draw.state;
+
+            bundle->referencedResources.push_back(state.pipeline);
+            bundle->referencedResources.push_back(state.framebuffer);
+
+            for (IBindingSet* bindingSet : state.bindings)
+                bundle->referencedResources.push_back(bindingSet);
+
+            if (state.indexBuffer.buffer)
+                bundle->referencedResources.push_back(state.indexBuffer.buffer);
+
+            for (const VertexBufferBinding& binding : state.vertexBuffers)
+                bundle->referencedResources.push_back(binding.buffer);
+        }
+
+        return CommandBundleHandle::Create(bundle);
+    }
+
+    GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Graphics, desc);
+
+        GraphicsPipeline* pso = new GraphicsPipeline();
+        pso->desc = desc;
+        pso->framebufferInfo = fbinfo;
+        creationScope.setPipeline(pso);
+
+        return GraphicsPipelineHandle::Create(pso);
+    }
+
+    GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return createGraphicsPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Compute, desc);
+
+        ComputePipeline* pso = new ComputePipeline();
+        pso->desc = desc;
+        creationScope.setPipeline(pso);
+
+        return ComputePipelineHandle::Create(pso);
+    }
+
+    BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        if (m_InternedStates)
+        {
+            if (BindingLayoutHandle existing = m_InternedStates->bindingLayouts.find(desc))
+                return existing;
+        }
+
+        BindingLayout* layout = new BindingLayout();
+        layout->desc = desc;
+        BindingLayoutHandle layoutHandle = BindingLayoutHandle::Create(layout);
+
+        if (m_InternedStates)
+            return m_InternedStates->bindingLayouts.insert(desc, layout, layout->internEntry);
+
+        return layoutHandle;
+    }
+
+    BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        BindingLayout* layout = new BindingLayout();
+        layout->bindlessDesc = desc;
+        layout->isBindless = true;
+
+        return BindingLayoutHandle::Create(layout);
+    }
+
+    void BindingSet::initialize(const Context& context)
+    {
+        resources.reserve(desc.bindings.size());
+        requiredStates.reserve(desc.bindings.size());
+
+        for (const BindingSetItem& binding : desc.bindings)
+        {
+            if (binding.resourceHandle)
+                resources.push_back(binding.resourceHandle); // keep a strong reference to the resource
+
+            RequiredResourceState required;
+            required.subresources = binding.subresources;
+
+            switch (binding.type)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+            case ResourceType::Texture_SRV:
+                required.texture = checked_cast<Texture*>(binding.resourceHandle);
+                required.state = ResourceStates::ShaderResource;
+                break;
+
+            case ResourceType::Texture_UAV:
+                required.texture = checked_cast<Texture*>(binding.resourceHandle);
+                required.state = ResourceStates::UnorderedAccess;
+                hasUavBindings = true;
+                break;
+
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::StructuredBuffer_SRV:
+            case ResourceType::RawBuffer_SRV:
+                required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                required.state = ResourceStates::ShaderResource;
+                break;
+
+            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::StructuredBuffer_UAV:
+            case ResourceType::RawBuffer_UAV:
+                required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                required.state = ResourceStates::UnorderedAccess;
+                hasUavBindings = true;
+                break;
+
+            case ResourceType::ConstantBuffer:
+                required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                required.state = ResourceStates::ConstantBuffer;
+                break;
+
+            case ResourceType::Sampler:
+            case ResourceType::VolatileConstantBuffer:
+            case ResourceType::PushConstants:
+            case ResourceType::None:
+                continue;
+
+            default:
+            {
+                std::stringstream ss;
+                ss << "Binding type " << uint32_t(binding.type) << " is not supported by the null backend";
+                context.error(ss.str());
+                continue;
+            }
+            }
+
+            if (!binding.resourceHandle)
+                continue;
+
+            // Resources in permanent states are never transitioned, like on the other backends
+            if (required.texture && required.texture->permanentState != ResourceStates::Unknown)
+            {
+                verifyPermanentResourceState(required.texture->permanentState, required.state, true, required.texture->descRef.debugName, context.messageCallback);
+                continue;
+            }
+
+            if (required.buffer && required.buffer->permanentState != ResourceStates::Unknown)
+            {
+                verifyPermanentResourceState(required.buffer->permanentState, required.state, false, required.buffer->descRef.debugName, context.messageCallback);
+                continue;
+            }
+
+            requiredStates.push_back(required);
+        }
+    }
+
+    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
+        BindingSet* bindingSet = new BindingSet();
+        bindingSet->desc = desc;
+        bindingSet->layout = layout;
+        bindingSet->initialize(m_Context);
+
+        return BindingSetHandle::Create(bindingSet);
+    }
+
+    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    {
+        DescriptorTable* table = new DescriptorTable();
+        table->layout = layout;
+
+        return DescriptorTableHandle::Create(table);
+    }
+
+    void Device::resizeDescriptorTable(IDescriptorTable* _descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        DescriptorTable* table = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (!keepContents)
+        {
+            table->descriptors.clear();
+            table->resources.clear();
+        }
+
+        table->descriptors.resize(newSize);
+        table->resources.resize(newSize);
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& item)
+    {
+        DescriptorTable* table = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (item.slot >= table->descriptors.size())
+            return false;
+
+        table->descriptors[item.slot] = item;
+        table->resources[item.slot] = item.resourceHandle;
+        return true;
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems)
+    {
+        bool success = true;
+        for (uint32_t i = 0; i < numItems; i++)
+            success = writeDescriptorTable(descriptorTable, items[i]) && success;
+        return success;
+    }
+
+    CommandListHandle Device::createCommandList(const CommandListParameters& params)
+    {
+        if (!isQueueEnabled(params.queueType))
+            return nullptr;
+
+        CommandList* cmdList = new CommandList(this, m_Context, params);
+
+        return CommandListHandle::Create(cmdList);
+    }
+
+    void Device::resolveDeferredInitialStates(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, size_t& fixupsUsed)
+    {
+        m_ResolvedCommandLists.assign(pCommandLists, pCommandLists + numCommandLists);
+
+        bool anyDeferred = false;
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            anyDeferred = anyDeferred || checked_cast<CommandList*>(pCommandLists[i])->getStateTracker().hasDeferredInitialStates();
+        }
+
+        if (!anyDeferred)
+            return;
+
+        auto& fixupPool = m_StateFixupCommandLists[uint32_t(executionQueue)];
+
+        m_ResolvedCommandLists.clear();
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            CommandListResourceStateTracker& stateTracker = commandList->getStateTracker();
+
+            m_StateFixups.clear();
+            if (stateTracker.resolveDeferredInitialStates(m_StateFixups))
+            {
+                if (fixupsUsed == fixupPool.size())
+                {
+                    fixupPool.push_back(createCommandList(CommandListParameters()
+                        .setQueueType(executionQueue)
+                        .setEnableImmediateExecution(false)));
+                }
+
+                CommandList* fixupList = checked_cast<CommandList*>(fixupPool[fixupsUsed].Get());
+                ++fixupsUsed;
+
+                fixupList->open();
+                fixupList->recordStateFixups(m_StateFixups);
+                fixupList->close();
+
+                m_ResolvedCommandLists.push_back(fixupList);
+            }
+
+            // The following command lists in this submission observe the final states of this one
+            stateTracker.publishSubmittedStates();
+
+            m_ResolvedCommandLists.push_back(commandList);
+        }
+    }
+
+    uint64_t Device::submit(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        const uint64_t instance = ++m_LastSubmittedInstances[uint32_t(executionQueue)];
+
+        std::lock_guard lockGuard(m_StatisticsMutex);
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* cmdList = checked_cast<CommandList*>(pCommandLists[i]);
+
+            if (cmdList->getDesc().enableBarrierStatistics)
+                m_BarrierStatistics[uint32_t(executionQueue)] += cmdList->getStateTracker().getStatistics();
+
+#if NVRHI_WITH_COMMAND_LIST_STATISTICS
+            m_CommandListStatistics[uint32_t(executionQueue)] += cmdList->getStatistics();
+#endif
+
+            // There is no GPU work, so the command list is completed by the submission
+            cmdList->executed();
+        }
+
+        return instance;
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::ExecuteCommandLists);
+
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        size_t fixupsUsed = 0;
+        resolveDeferredInitialStates(pCommandLists, numCommandLists, executionQueue, fixupsUsed);
+
+        return submit(m_ResolvedCommandLists.data(), m_ResolvedCommandLists.size(), executionQueue);
+    }
+
+    void Device::executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::ExecuteCommandLists);
+
+        std::lock_guard lockGuard(m_SubmitMutex);
+
+        std::vector<SubmitBatch> batches;
+        std::vector<uint32_t> nodeBatches;
+        buildSubmitBatches(graph, batches, nodeBatches);
+
+        // The batches are listed after their dependencies, and every submission completes immediately,
+        // so submitting them in order satisfies all waits
+        std::array<size_t, uint32_t(CommandQueue::Count)> fixupsUsed {};
+        std::vector<uint64_t> batchInstances(batches.size());
+
+        for (size_t batchIndex = 0; batchIndex < batches.size(); batchIndex++)
+        {
+            const SubmitBatch& batch = batches[batchIndex];
+
+            resolveDeferredInitialStates(batch.commandLists.data(), batch.commandLists.size(), batch.queue, fixupsUsed[uint32_t(batch.queue)]);
+            batchInstances[batchIndex] = submit(m_ResolvedCommandLists.data(), m_ResolvedCommandLists.size(), batch.queue);
+        }
+
+        if (pInstances)
+        {
+            for (size_t nodeIndex = 0; nodeIndex < nodeBatches.size(); nodeIndex++)
+                pInstances[nodeIndex] = batchInstances[nodeBatches[nodeIndex]];
+        }
+    }
+
+    bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
+    {
+        (void)pInfo;
+        (void)infoSize;
+
+        switch (feature)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case Feature::ComputeQueue:
+            return m_Desc.enableComputeQueue;
+        case Feature::CopyQueue:
+            return m_Desc.enableCopyQueue;
+        case Feature::ConstantBufferRanges:
+        case Feature::DeferredCommandLists:
+        case Feature::HostMemoryImport:
+        case Feature::Predication:
+        case Feature::ShaderSpecializations:
+        case Feature::VirtualResources:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    FormatSupport Device::queryFormatSupport(Format format)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(format);
+
+        if (format == Format::UNKNOWN)
+            return FormatSupport::None;
+
+        FormatSupport result = FormatSupport::Texture | FormatSupport::ShaderLoad | FormatSupport::ShaderSample;
+
+        if (formatInfo.hasDepth || formatInfo.hasStencil)
+            return result | FormatSupport::DepthStencil;
+
+        if (formatInfo.blockSize == 1)
+        {
+            result = result | FormatSupport::Buffer | FormatSupport::VertexBuffer | FormatSupport::RenderTarget | FormatSupport::Blendable
+                | FormatSupport::ShaderUavLoad | FormatSupport::ShaderUavStore;
+        }
+
+        if (format == Format::R16_UINT || format == Format::R32_UINT)
+            result = result | FormatSupport::IndexBuffer;
+
+        if (format == Format::R32_UINT || format == Format::R32_SINT)
+            result = result | FormatSupport::ShaderAtomic;
+
+        return result;
+    }
+
+    MemoryStatistics Device::getMemoryStatistics()
+    {
+        MemoryStatistics statistics;
+        m_Context.memoryCounters.fillStatistics(statistics);
+        return statistics;
+    }
+
+    BarrierStatistics Device::getBarrierStatistics(CommandQueue queue)
+    {
+        std::lock_guard lockGuard(m_StatisticsMutex);
+        return m_BarrierStatistics[uint32_t(queue)];
+    }
+
+    void Device::resetBarrierStatistics()
+    {
+        std::lock_guard lockGuard(m_StatisticsMutex);
+        m_BarrierStatistics.fill(BarrierStatistics());
+    }
+
+    CommandListStatistics Device::getCommandListStatistics(CommandQueue queue)
+    {
+        std::lock_guard lockGuard(m_StatisticsMutex);
+        return m_CommandListStatistics[uint32_t(queue)];
+    }
+
+    void Device::resetCommandListStatistics()
+    {
+        std::lock_guard lockGuard(m_StatisticsMutex);
+        m_CommandListStatistics.fill(CommandListStatistics());
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,94 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi::null
+{
+    UploadManager::UploadManager(const Context& context, uint64_t defaultChunkSize)
+        : m_Context(context)
+        , m_DefaultChunkSize(defaultChunkSize)
+    { }
+
+    uint8_t* UploadManager::suballocate(uint64_t size, uint32_t alignment)
+    {
+#if NVRHI_WITH_COMMAND_LIST_STATISTICS
+        m_SuballocatedBytes += size;
+#endif
+
+        if (m_CurrentChunk)
+        {
+            const uint64_t alignedOffset = align(m_CurrentChunk->writePointer, uint64_t(alignment));
+
+            if (alignedOffset + size <= m_CurrentChunk->memory.size())
+            {
+                m_CurrentChunk->writePointer = alignedOffset + size;
+                return m_CurrentChunk->memory.data() + alignedOffset;
+            }
+
+            m_UsedChunks.push_back(std::move(m_CurrentChunk));
+        }
+
+        // Reuse a free chunk that is large enough, or allocate a new one
+        for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); ++it)
+        {
+            if ((*it)->memory.size() >= size)
+            {
+                m_CurrentChunk = std::move(*it);
+                m_ChunkPool.erase(it);
+                break;
+            }
+        }
+
+        if (!m_CurrentChunk)
+        {
+            InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::AllocateUploadChunk);
+
+            const uint64_t chunkSize = align(std::max(size, m_DefaultChunkSize), c_sizeAlignment);
+
+            m_CurrentChunk = std::make_unique<UploadChunk>();
+            m_CurrentChunk->memory.resize(chunkSize);
+            m_CurrentChunk->trackedMemory.set(m_Context.memoryCounters, MemoryCategory::UploadChunks, chunkSize);
+        }
+
+        m_CurrentChunk->writePointer = size;
+        return m_CurrentChunk->memory.data();
+    }
+
+    void UploadManager::submitChunks()
+    {
+        // The null device completes the work on submission, so all chunks are free again
+        if (m_CurrentChunk)
+            m_UsedChunks.push_back(std::move(m_CurrentChunk));
+
+        for (auto& chunk : m_UsedChunks)
+        {
+            chunk->writePointer = 0;
+            m_ChunkPool.push_back(std::move(chunk));
+        }
+
+        m_UsedChunks.clear();
+    }
+
+} // namespace nvrhi::null
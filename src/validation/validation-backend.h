@@ -23,6 +23,8 @@
 #pragma once
 
 #include <nvrhi/validation.h>
+#include "../common/pipeline-compile-pool.h"
+#include <unordered_map>
 #include <unordered_set>
 
 namespace nvrhi::validation
@@ -140,6 +142,7 @@ namespace nvrhi::validation
         const rt::AccelStructDesc& getDesc() const override { return m_AccelStruct->getDesc(); }
         bool isCompacted() const override { return m_AccelStruct->isCompacted(); }
         uint64_t getDeviceAddress() const override { return m_AccelStruct->getDeviceAddress(); };
+        IBuffer* getInstanceBuffer() const override { return m_AccelStruct->getInstanceBuffer(); }
         
     private:
         rt::AccelStructHandle m_AccelStruct;
@@ -172,6 +175,40 @@ namespace nvrhi::validation
         size_t m_PipelinePushConstantSize = 0;
         bool m_PushConstantsSet = false;
 
+        bool m_PredicationActive = false;
+
+        mutable std::atomic<uint32_t> m_DeepCheckCounter = 0;
+
+        struct ValidatedBindingSetKey
+        {
+            IBindingLayout* layout = nullptr;
+            IBindingSet* bindingSet = nullptr;
+
+            bool operator==(const ValidatedBindingSetKey& other) const { return layout == other.layout && bindingSet == other.bindingSet; }
+        };
+
+        struct ValidatedBindingSetKeyHash
+        {
+            size_t operator()(const ValidatedBindingSetKey& key) const
+            {
+                size_t hash = 0;
+                hash_combine(hash, key.layout);
+                hash_combine(hash, key.bindingSet);
+                return hash;
+            }
+        };
+
+        // (pipeline layout, binding set) pairs that passed validateBindingSetsAgainstLayouts, and transient binding set
+        // descs that passed validateBindingSet, since the command list was opened. Bound sets and transient sets are
+        // referenced by the underlying command list until it is executed, so their addresses cannot be reused for
+        // other objects while the caches are alive. The pair cache is also dropped when any descriptor table is written.
+        mutable std::unordered_set<ValidatedBindingSetKey, ValidatedBindingSetKeyHash> m_ValidatedBindingSets;
+        mutable uint64_t m_ValidatedBindingSetsGeneration = 0;
+        std::unordered_map<IBindingLayout*, std::unordered_set<BindingSetDesc>> m_ValidatedTransientBindingSets;
+
+        // Whether the expensive checks should run for the current call, see DeviceWrapper::shouldRunDeepChecks
+        bool shouldRunDeepChecks() const;
+
         void error(const std::string& messageText) const;
         void warning(const std::string& messageText) const;
 
@@ -184,7 +221,11 @@ namespace nvrhi::validation
         bool validatePushConstants(const char* pipelineType, const char* stateFunctionName) const;
         bool validateBindingSetsAgainstLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& layouts, const static_vector<IBindingSet*, c_MaxBindingLayouts>& sets) const;
 
+        bool validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const;
         bool validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const;
+        bool validateAccelStructSerialization(const char* function, rt::IAccelStruct*& as, IBuffer* buffer, uint64_t offset, uint64_t alignment, bool requireBuilt) const;
+        bool validateTimestampRange(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, const char* function) const;
+        bool validateQueryRange(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, const char* function) const;
 
     public:
 
@@ -206,6 +247,7 @@ namespace nvrhi::validation
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
@@ -217,10 +259,19 @@ namespace nvrhi::validation
         void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void beginRenderPassScope(const RenderPassScope& scope) override;
+        void endRenderPassScope() override;
+        void executeBundle(ICommandBundle* bundle) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndexedMulti(const DrawArguments* args, size_t numDraws) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
@@ -228,25 +279,46 @@ namespace nvrhi::validation
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
         void dispatchIndirect(uint32_t offsetBytes)  override;
+        void executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+            uint32_t countOffsetBytes) override;
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
+        void writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        rt::IndirectInstanceDesc* allocateTopLevelInstances(size_t numInstances) override;
+        void buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes) override;
+        void beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op) override;
+        void endPredication() override;
 
         void beginMarker(const char* name) override;
         void endMarker() override;
@@ -266,6 +338,13 @@ namespace nvrhi::validation
 
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
 
         void commitBarriers() override;
         
@@ -274,6 +353,8 @@ namespace nvrhi::validation
 
         IDevice* getDevice() override;
         const CommandListParameters& getDesc() override;
+        BarrierStatistics getBarrierStatistics() override;
+        CommandListStatistics getStatistics() override;
     };
 
     class DeviceWrapper : public RefCounter<IDevice>
@@ -281,19 +362,38 @@ namespace nvrhi::validation
     public:
         friend class CommandListWrapper;
 
-        DeviceWrapper(IDevice* device);
+        DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc);
+        ~DeviceWrapper() override;
         
     protected:
         DeviceHandle m_Device;
         IMessageCallback* m_MessageCallback;
         std::atomic<unsigned int> m_NumOpenImmediateCommandLists = 0;
 
+        ValidationLayerDesc m_Desc;
+        std::atomic<uint64_t> m_FrameIndex = 0;
+        mutable std::atomic<uint32_t> m_DeepCheckCounter = 0;
+
+        // Incremented on every descriptor table write or resize, invalidates the binding set validation caches of command lists
+        std::atomic<uint64_t> m_DescriptorTableGeneration = 0;
+
+        // Runs the validated create...Pipeline functions of this wrapper, so that the async versions are validated too
+        PipelineCompilePool m_PipelineCompilePool;
+
         void error(const std::string& messageText) const;
         void warning(const std::string& messageText) const;
 
+        // Returns true if the expensive checks should run for the current call, according to the validation tier.
+        // The counter is used for the PerCall sampling mode, and each command list has its own.
+        bool shouldRunDeepChecks(std::atomic<uint32_t>& callCounter) const;
+
         bool validateBindingSetItem(const BindingSetItem& binding, IDescriptorTable *pOptDescriptorTable, std::stringstream& errorStream);
+        bool validateBindingSet(const BindingSetDesc& desc, IBindingLayout* layout);
+        static BindingSetDesc unwrapBindingSetDesc(const BindingSetDesc& desc);
         bool validatePipelineBindingLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& bindingLayouts, const std::vector<IShader*>& shaders) const;
         bool validateShaderType(ShaderType expected, const ShaderDesc& shaderDesc, const char* function) const;
+        bool validateMappedRange(IBuffer* buffer, uint64_t offset, size_t size, const char* function);
+        bool validateTimestampRange(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, const char* function);
         bool validateRenderState(const RenderState& renderState, FramebufferInfo const& fbinfo) const;
 
         bool validateClusterOperationParams(const rt::cluster::OperationParams& params) const;
@@ -319,13 +419,18 @@ namespace nvrhi::validation
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
+        BufferHandle createBufferFromHostMemory(const BufferDesc& d, void* hostMemory) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, uint64_t offset, size_t size) override;
         void unmapBuffer(IBuffer* b) override;
+        void flushMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
+        void invalidateMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
@@ -351,10 +456,16 @@ namespace nvrhi::validation
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimestampQueryPoolHandle createTimestampQueryPool(const TimestampQueryPoolDesc& desc) override;
+        bool getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) override;
+        uint64_t getTimestampFrequency(CommandQueue queue) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
         FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+        IndirectCommandLayoutHandle createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc) override;
 
         GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
 
@@ -367,6 +478,12 @@ namespace nvrhi::validation
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override;
+        PendingPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createGraphicsPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override { return m_PipelineCompilePool.createComputePipeline(this, desc); }
+        PendingPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createMeshletPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override { return m_PipelineCompilePool.createRayTracingPipeline(this, desc); }
+        PendingPipelineHandle addToRayTracingPipelineAsync(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override { return m_PipelineCompilePool.addToRayTracingPipeline(this, pipeline, additions); }
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -376,26 +493,43 @@ namespace nvrhi::validation
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems) override;
 
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc)  override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
         MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::AccelStructBuildSizes getAccelStructBuildSizes(const rt::AccelStructDesc& desc) override;
+        bool isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header) override;
         rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
         bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
 
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances = nullptr) override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        bool runIncrementalGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds = 2) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
         IMessageCallback* getMessageCallback() override;
+        void setInstrumentationCallback(IInstrumentationCallback* callback) override;
         bool isAftermathEnabled() override;
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override;
+        bool getPipelineCacheData(void* data, size_t* dataSize) override;
+        UploadRingStatistics getUploadRingStatistics(CommandQueue queue) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void enumerateResourceAllocations(IResourceAllocationCallback& callback) override;
+        BarrierStatistics getBarrierStatistics(CommandQueue queue) override;
+        void resetBarrierStatistics() override;
+        CommandListStatistics getCommandListStatistics(CommandQueue queue) override;
+        void resetCommandListStatistics() override;
+        PipelineCreationStatistics getPipelineCreationStatistics() override;
+        void resetPipelineCreationStatistics() override;
     };
 
 } // namespace nvrhi::validation
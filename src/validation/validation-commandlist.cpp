@@ -81,6 +81,23 @@ namespace nvrhi::validation
         }
     }
 
+    // Returns the topology class of a primitive type: dynamic topology may only switch within the same class
+    static int GetPrimitiveTopologyClass(PrimitiveType type)
+    {
+        switch (type)
+        {
+        case PrimitiveType::PointList:
+            return 0;
+        case PrimitiveType::LineList:
+        case PrimitiveType::LineStrip:
+            return 1;
+        case PrimitiveType::PatchList:
+            return 3;
+        default:
+            return 2;
+        }
+    }
+
     bool CommandListWrapper::requireOpenState() const
     {
         if (m_State == CommandListState::OPEN)
@@ -113,6 +130,11 @@ namespace nvrhi::validation
         return true;
     }
 
+    bool CommandListWrapper::shouldRunDeepChecks() const
+    {
+        return m_Device->shouldRunDeepChecks(m_DeepCheckCounter);
+    }
+
     bool CommandListWrapper::requireType(CommandQueue queueType, const char* operation) const
     {
         if ((int)m_type > (int)queueType)
@@ -172,6 +194,9 @@ namespace nvrhi::validation
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+
+        m_ValidatedBindingSets.clear();
+        m_ValidatedTransientBindingSets.clear();
     }
 
     void CommandListWrapper::close()
@@ -194,6 +219,12 @@ namespace nvrhi::validation
             --m_Device->m_NumOpenImmediateCommandLists;
         }
 
+        if (m_PredicationActive)
+        {
+            error("Cannot close a command list while predication is active, call endPredication() first");
+            m_PredicationActive = false;
+        }
+
         m_CommandList->close();
 
         m_State = CommandListState::CLOSED;
@@ -351,6 +382,96 @@ namespace nvrhi::validation
         m_CommandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
     }
 
+    void CommandListWrapper::writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!dest)
+        {
+            error("writeTextureRegions: dest is NULL");
+            return;
+        }
+
+        if (numRegions > 0 && !regions)
+        {
+            error("writeTextureRegions: regions is NULL");
+            return;
+        }
+
+        const TextureDesc& desc = dest->getDesc();
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        bool anyErrors = false;
+
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            const TextureUploadRegion& region = regions[i];
+
+            if (region.slice.mipLevel >= desc.mipLevels || region.slice.arraySlice >= desc.arraySize)
+            {
+                std::stringstream ss;
+                ss << "writeTextureRegions: region " << i << " refers to mip level " << region.slice.mipLevel
+                    << " and array slice " << region.slice.arraySlice << ", but texture " << utils::DebugNameToString(desc.debugName)
+                    << " has " << desc.mipLevels << " mip levels and " << desc.arraySize << " array slices";
+                error(ss.str());
+                anyErrors = true;
+                continue;
+            }
+
+            const TextureSlice slice = region.slice.resolve(desc);
+            const uint32_t mipWidth = std::max(desc.width >> slice.mipLevel, 1u);
+            const uint32_t mipHeight = std::max(desc.height >> slice.mipLevel, 1u);
+            const uint32_t mipDepth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> slice.mipLevel, 1u) : 1u;
+
+            if (uint64_t(slice.x) + slice.width > mipWidth || uint64_t(slice.y) + slice.height > mipHeight || uint64_t(slice.z) + slice.depth > mipDepth)
+            {
+                std::stringstream ss;
+                ss << "writeTextureRegions: region " << i << " is outside of mip level " << slice.mipLevel
+                    << " of texture " << utils::DebugNameToString(desc.debugName);
+                error(ss.str());
+                anyErrors = true;
+            }
+
+            if ((slice.x % formatInfo.blockSize) != 0 || (slice.y % formatInfo.blockSize) != 0)
+            {
+                std::stringstream ss;
+                ss << "writeTextureRegions: the origin of region " << i << " is not aligned to the "
+                    << uint32_t(formatInfo.blockSize) << "x" << uint32_t(formatInfo.blockSize) << " compression blocks of format " << formatInfo.name;
+                error(ss.str());
+                anyErrors = true;
+            }
+
+            if (!region.data)
+            {
+                std::stringstream ss;
+                ss << "writeTextureRegions: region " << i << " has NULL data";
+                error(ss.str());
+                anyErrors = true;
+            }
+
+            if (slice.height > formatInfo.blockSize && region.rowPitch == 0)
+            {
+                std::stringstream ss;
+                ss << "writeTextureRegions: region " << i << " has rowPitch = 0 but multiple rows";
+                error(ss.str());
+                anyErrors = true;
+            }
+
+            if (slice.depth > 1 && region.depthPitch == 0)
+            {
+                std::stringstream ss;
+                ss << "writeTextureRegions: region " << i << " has depthPitch = 0 but multiple depth slices";
+                error(ss.str());
+                anyErrors = true;
+            }
+        }
+
+        if (anyErrors)
+            return;
+
+        m_CommandList->writeTextureRegions(dest, regions, numRegions);
+    }
+
     void CommandListWrapper::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
     {
         if (!requireOpenState())
@@ -493,7 +614,15 @@ namespace nvrhi::validation
             return false;
         }
 
+        uint64_t const descriptorTableGeneration = m_Device->m_DescriptorTableGeneration.load();
+        if (m_ValidatedBindingSetsGeneration != descriptorTableGeneration)
+        {
+            m_ValidatedBindingSets.clear();
+            m_ValidatedBindingSetsGeneration = descriptorTableGeneration;
+        }
+
         bool anyErrors = false;
+        static_vector<ValidatedBindingSetKey, c_MaxBindingLayouts> newlyValidatedSets;
 
         for (int index = 0; index < int(layouts.size()); index++)
         {
@@ -506,6 +635,12 @@ namespace nvrhi::validation
                 continue;
             }
 
+            ValidatedBindingSetKey const key{ layouts[index], sets[index] };
+            if (m_ValidatedBindingSets.find(key) != m_ValidatedBindingSets.end())
+                continue;
+
+            newlyValidatedSets.push_back(key);
+
             IBindingLayout* setLayout = sets[index]->getLayout();
             IBindingLayout* expectedLayout = layouts[index];
             bool setIsBindless = (sets[index]->getDesc() == nullptr);
@@ -528,6 +663,10 @@ namespace nvrhi::validation
             }
         }
 
+        // Only remember the sets when the whole state is valid: otherwise they won't be bound and referenced
+        if (!anyErrors)
+            m_ValidatedBindingSets.insert(newlyValidatedSets.begin(), newlyValidatedSets.end());
+
         return !anyErrors;
     }
 
@@ -568,6 +707,31 @@ namespace nvrhi::validation
         m_CommandList->setPushConstants(data, byteSize);
     }
 
+    IBindingSet* CommandListWrapper::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        if (!requireOpenState())
+            return nullptr;
+
+        bool const alreadyValidated = layout && m_ValidatedTransientBindingSets[layout].count(desc) != 0;
+        bool validated = false;
+
+        if (!alreadyValidated && (!layout || !layout->getDesc() || shouldRunDeepChecks()))
+        {
+            if (!m_Device->validateBindingSet(desc, layout))
+                return nullptr;
+
+            validated = true;
+        }
+
+        IBindingSet* bindingSet = m_CommandList->createTransientBindingSet(DeviceWrapper::unwrapBindingSetDesc(desc), layout);
+
+        // The transient set keeps the resources in the desc alive until the command list is executed
+        if (bindingSet && validated)
+            m_ValidatedTransientBindingSets[layout].insert(desc);
+
+        return bindingSet;
+    }
+
     void CommandListWrapper::setGraphicsState(const GraphicsState& state)
     {
         if (!requireOpenState())
@@ -632,20 +796,32 @@ namespace nvrhi::validation
             return;
         }
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
-            anyErrors = true;
-
-        if (state.framebuffer->getFramebufferInfo() != state.pipeline->getFramebufferInfo())
+        if (shouldRunDeepChecks())
         {
-            ss << "The framebuffer used in the draw call does not match the framebuffer used to create the pipeline." << std::endl <<
-                "Formats and sample counts of the framebuffers must match." << std::endl;
-            anyErrors = true;
-        }
+            if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
+                anyErrors = true;
 
-        if (anyErrors)
-        {
-            error(ss.str());
-            return;
+            if (state.framebuffer->getFramebufferInfo() != state.pipeline->getFramebufferInfo())
+            {
+                ss << "The framebuffer used in the draw call does not match the framebuffer used to create the pipeline." << std::endl <<
+                    "Formats and sample counts of the framebuffers must match." << std::endl;
+                anyErrors = true;
+            }
+
+            const GraphicsPipelineDesc& pipelineDesc = state.pipeline->getDesc();
+            if ((pipelineDesc.dynamicRenderState & DynamicRenderState::PrimitiveTopology) != 0 &&
+                GetPrimitiveTopologyClass(state.dynamicRenderState.primType) != GetPrimitiveTopologyClass(pipelineDesc.primType))
+            {
+                ss << "The dynamic primitive topology must belong to the same topology class (points, lines, triangles or patches) "
+                    "as the primType used to create the pipeline." << std::endl;
+                anyErrors = true;
+            }
+
+            if (anyErrors)
+            {
+                error(ss.str());
+                return;
+            }
         }
 
         evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
@@ -660,6 +836,159 @@ namespace nvrhi::validation
         m_CurrentGraphicsState = state;
     }
 
+    void CommandListWrapper::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setGraphicsBindingSet: graphics state is not set, call setGraphicsState first");
+            return;
+        }
+
+        BindingSetVector bindings = m_CurrentGraphicsState.bindings;
+        if (slot >= bindings.size())
+            bindings.resize(slot + 1);
+        bindings[slot] = bindingSet;
+
+        if (shouldRunDeepChecks() && !validateBindingSetsAgainstLayouts(m_CurrentGraphicsState.pipeline->getDesc().bindingLayouts, bindings))
+            return;
+
+        m_CommandList->setGraphicsBindingSet(slot, bindingSet);
+
+        m_CurrentGraphicsState.bindings = bindings;
+    }
+
+    void CommandListWrapper::setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setVertexBuffers: graphics state is not set, call setGraphicsState first");
+            return;
+        }
+
+        if (numBindings > c_MaxVertexAttributes)
+        {
+            std::stringstream ss;
+            ss << "setVertexBuffers: numBindings (" << numBindings << ") exceeds the maximum of " << c_MaxVertexAttributes;
+            error(ss.str());
+            return;
+        }
+
+        if (numBindings > 0 && !bindings)
+        {
+            error("setVertexBuffers: bindings is NULL");
+            return;
+        }
+
+        bool anyErrors = false;
+        std::stringstream ss;
+        ss << "setVertexBuffers: " << std::endl;
+
+        for (size_t index = 0; index < numBindings; index++)
+        {
+            const VertexBufferBinding& vb = bindings[index];
+
+            if (!vb.buffer)
+            {
+                ss << "Vertex buffer at index " << index << " is NULL." << std::endl;
+                anyErrors = true;
+            }
+            else if (!vb.buffer->getDesc().isVertexBuffer)
+            {
+                ss << "Buffer '" << utils::DebugNameToString(vb.buffer->getDesc().debugName) << "' bound to vertex buffer slot " << index << " cannot be used as a vertex buffer because it does not have the isVertexBuffer flag set." << std::endl;
+                anyErrors = true;
+            }
+
+            if (vb.slot >= c_MaxVertexAttributes)
+            {
+                ss << "Vertex buffer binding at index " << index << " uses an invalid slot " << vb.slot << "." << std::endl;
+                anyErrors = true;
+            }
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->setVertexBuffers(bindings, numBindings);
+
+        m_CurrentGraphicsState.vertexBuffers.resize(numBindings);
+        std::copy(bindings, bindings + numBindings, m_CurrentGraphicsState.vertexBuffers.begin());
+    }
+
+    void CommandListWrapper::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("setIndexBuffer: graphics state is not set, call setGraphicsState first");
+            return;
+        }
+
+        if (binding.buffer && !binding.buffer->getDesc().isIndexBuffer)
+        {
+            std::stringstream ss;
+            ss << "setIndexBuffer: Cannot use buffer '" << utils::DebugNameToString(binding.buffer->getDesc().debugName) << "' as an index buffer because it does not have the isIndexBuffer flag set.";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->setIndexBuffer(binding);
+
+        m_CurrentGraphicsState.indexBuffer = binding;
+    }
+
+    void CommandListWrapper::beginRenderPassScope(const RenderPassScope& scope)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "beginRenderPassScope"))
+            return;
+
+        if (!scope.framebuffer)
+        {
+            error("beginRenderPassScope: framebuffer is NULL");
+            return;
+        }
+
+        m_CommandList->beginRenderPassScope(scope);
+    }
+
+    void CommandListWrapper::endRenderPassScope()
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->endRenderPassScope();
+    }
+
+    void CommandListWrapper::executeBundle(ICommandBundle* bundle)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "executeBundle"))
+            return;
+
+        if (!bundle)
+        {
+            error("executeBundle: bundle is NULL");
+            return;
+        }
+
+        m_CommandList->executeBundle(bundle);
+    }
+
     void CommandListWrapper::draw(const DrawArguments& args)
     {
         if (!requireOpenState())
@@ -708,83 +1037,143 @@ namespace nvrhi::validation
         m_CommandList->drawIndexed(args);
     }
 
-    void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    void CommandListWrapper::drawMulti(const DrawArguments* args, size_t numDraws)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Graphics, "drawIndirect"))
+        if (!requireType(CommandQueue::Graphics, "drawMulti"))
             return;
 
         if (!m_GraphicsStateSet)
         {
-            error("Graphics state is not set before a drawIndirect call.\n"
+            error("Graphics state is not set before a drawMulti call.\n"
                 "Note that setting compute state invalidates the graphics state.");
             return;
         }
 
-        if (!m_CurrentGraphicsState.indirectParams)
+        if (!args && numDraws != 0)
         {
-            error("Indirect params buffer is not set before a drawIndirect call.");
+            error("drawMulti: 'args' is NULL");
             return;
         }
 
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
-        m_CommandList->drawIndirect(offsetBytes, drawCount);
+        m_CommandList->drawMulti(args, numDraws);
     }
 
-    void CommandListWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    void CommandListWrapper::drawIndexedMulti(const DrawArguments* args, size_t numDraws)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Graphics, "drawIndexedIndirect"))
+        if (!requireType(CommandQueue::Graphics, "drawIndexedMulti"))
             return;
 
         if (!m_GraphicsStateSet)
         {
-            error("Graphics state is not set before a drawIndexedIndirect call.\n"
+            error("Graphics state is not set before a drawIndexedMulti call.\n"
                 "Note that setting compute state invalidates the graphics state.");
             return;
         }
 
-        if (!m_CurrentGraphicsState.indirectParams)
+        if (m_CurrentGraphicsState.indexBuffer.buffer == nullptr)
         {
-            error("Indirect params buffer is not set before a drawIndexedIndirect call.");
+            error("Index buffer is not set before a drawIndexedMulti call");
+            return;
+        }
+
+        if (!args && numDraws != 0)
+        {
+            error("drawIndexedMulti: 'args' is NULL");
             return;
         }
 
         if (!validatePushConstants("graphics", "setGraphicsState"))
             return;
 
-        m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
+        m_CommandList->drawIndexedMulti(args, numDraws);
     }
 
-    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Graphics, "drawIndexedIndirectCount"))
+        if (!requireType(CommandQueue::Graphics, "drawIndirect"))
             return;
 
         if (!m_GraphicsStateSet)
         {
-            error("Graphics state is not set before a drawIndexedIndirectCount call.\n"
+            error("Graphics state is not set before a drawIndirect call.\n"
                 "Note that setting compute state invalidates the graphics state.");
             return;
         }
 
         if (!m_CurrentGraphicsState.indirectParams)
         {
-            error("Indirect params buffer is not set before a drawIndexedIndirectCount call.");
+            error("Indirect params buffer is not set before a drawIndirect call.");
             return;
         }
 
-        if (!m_CurrentGraphicsState.indirectCountBuffer)
-        {
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "drawIndexedIndirect"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndexedIndirect call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndexedIndirect call.");
+            return;
+        }
+
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "drawIndexedIndirectCount"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndexedIndirectCount call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndexedIndirectCount call.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectCountBuffer)
+        {
             error("Indirect count buffer is not set before a drawIndexedIndirectCount call.");
             return;
         }
@@ -819,6 +1208,12 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) << "' as an indirect count buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+            anyErrors = true;
+        }
+
         if (anyErrors)
         {
             error(ss.str());
@@ -828,7 +1223,7 @@ namespace nvrhi::validation
         if (anyErrors)
             return;
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
+        if (shouldRunDeepChecks() && !validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
             anyErrors = true;
 
         if (anyErrors)
@@ -894,6 +1289,94 @@ namespace nvrhi::validation
         m_CommandList->dispatchIndirect(offsetBytes);
     }
 
+    void CommandListWrapper::executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+        uint32_t countOffsetBytes)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!layout)
+        {
+            error("executeIndirectCommands: layout is NULL");
+            return;
+        }
+
+        const IndirectCommandLayoutDesc& layoutDesc = layout->getDesc();
+        const bool isGraphics = layoutDesc.graphicsPipeline != nullptr;
+
+        IBuffer* paramBuffer = nullptr;
+
+        if (isGraphics)
+        {
+            if (!requireType(CommandQueue::Graphics, "executeIndirectCommands with a graphics layout"))
+                return;
+
+            if (!m_GraphicsStateSet || m_CurrentGraphicsState.pipeline != layoutDesc.graphicsPipeline)
+            {
+                std::stringstream ss;
+                ss << "Graphics state with the pipeline of indirect command layout "
+                    << utils::DebugNameToString(layoutDesc.debugName) << " is not set before an executeIndirectCommands call.";
+                error(ss.str());
+                return;
+            }
+
+            paramBuffer = m_CurrentGraphicsState.indirectParams;
+        }
+        else
+        {
+            if (!requireType(CommandQueue::Compute, "executeIndirectCommands with a compute layout"))
+                return;
+
+            if (!m_ComputeStateSet || m_CurrentComputeState.pipeline != layoutDesc.computePipeline)
+            {
+                std::stringstream ss;
+                ss << "Compute state with the pipeline of indirect command layout "
+                    << utils::DebugNameToString(layoutDesc.debugName) << " is not set before an executeIndirectCommands call.";
+                error(ss.str());
+                return;
+            }
+
+            paramBuffer = m_CurrentComputeState.indirectParams;
+        }
+
+        if (!paramBuffer)
+        {
+            error("Indirect params buffer is not set before an executeIndirectCommands call.");
+            return;
+        }
+
+        if ((paramOffsetBytes & 3) != 0 || (countOffsetBytes & 3) != 0)
+        {
+            error("executeIndirectCommands: parameter and count buffer offsets must be multiples of 4");
+            return;
+        }
+
+        const uint64_t commandsEnd = uint64_t(paramOffsetBytes) + uint64_t(maxCommandCount) * layout->getByteStride();
+        if (commandsEnd > paramBuffer->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "executeIndirectCommands: " << maxCommandCount << " commands at offset " << paramOffsetBytes
+                << " don't fit into buffer " << utils::DebugNameToString(paramBuffer->getDesc().debugName)
+                << " (" << paramBuffer->getDesc().byteSize << " bytes)";
+            error(ss.str());
+            return;
+        }
+
+        bool writesPushConstants = false;
+        for (const IndirectArgumentDesc& argument : layoutDesc.arguments)
+            writesPushConstants |= argument.type == IndirectArgumentType::PushConstants;
+
+        if (!writesPushConstants && !validatePushConstants(isGraphics ? "graphics" : "compute", isGraphics ? "setGraphicsState" : "setComputeState"))
+            return;
+
+        m_CommandList->executeIndirectCommands(layout, paramOffsetBytes, maxCommandCount, countOffsetBytes);
+
+        // The commands leave the vertex buffers, index buffer and push constants undefined
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_PushConstantsSet = false;
+    }
+
     void CommandListWrapper::setMeshletState(const MeshletState& state)
     {
         if (!requireOpenState())
@@ -912,7 +1395,7 @@ namespace nvrhi::validation
         if (anyErrors)
             return;
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
+        if (shouldRunDeepChecks() && !validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
             anyErrors = true;
 
         if (anyErrors)
@@ -951,6 +1434,66 @@ namespace nvrhi::validation
         m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
     }
 
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "dispatchMeshIndirect"))
+            return;
+
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMeshIndirect call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return;
+        }
+
+        if (!m_CurrentMeshletState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a dispatchMeshIndirect call.");
+            return;
+        }
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return;
+
+        m_CommandList->dispatchMeshIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "dispatchMeshIndirectCount"))
+            return;
+
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMeshIndirectCount call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return;
+        }
+
+        if (!m_CurrentMeshletState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a dispatchMeshIndirectCount call.");
+            return;
+        }
+
+        if (!m_CurrentMeshletState.indirectCountBuffer)
+        {
+            error("Indirect count buffer is not set before a dispatchMeshIndirectCount call.");
+            return;
+        }
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return;
+
+        m_CommandList->dispatchMeshIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
     void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
     {
         if (!requireOpenState())
@@ -967,6 +1510,215 @@ namespace nvrhi::validation
         m_CommandList->endTimerQuery(query);
     }
 
+    bool CommandListWrapper::validateTimestampRange(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, const char* function) const
+    {
+        if (!pool)
+        {
+            std::stringstream ss;
+            ss << function << ": pool is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        const TimestampQueryPoolDesc& desc = pool->getDesc();
+        if (firstQuery > desc.queryCount || queryCount > desc.queryCount - firstQuery)
+        {
+            std::stringstream ss;
+            ss << function << ": range [" << firstQuery << ", " << uint64_t(firstQuery) + queryCount
+                << ") is outside of timestamp query pool " << utils::DebugNameToString(desc.debugName)
+                << " with " << desc.queryCount << " queries";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateTimestampRange(pool, firstQuery, queryCount, "resetTimestamps"))
+            return;
+
+        m_CommandList->resetTimestamps(pool, firstQuery, queryCount);
+    }
+
+    void CommandListWrapper::writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateTimestampRange(pool, queryIndex, 1, "writeTimestamp"))
+            return;
+
+        m_CommandList->writeTimestamp(pool, queryIndex);
+    }
+
+    void CommandListWrapper::resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateTimestampRange(pool, firstQuery, queryCount, "resolveTimestamps"))
+            return;
+
+        m_CommandList->resolveTimestamps(pool, firstQuery, queryCount);
+    }
+
+    bool CommandListWrapper::validateQueryRange(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, const char* function) const
+    {
+        if (!pool)
+        {
+            std::stringstream ss;
+            ss << function << ": pool is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        const QueryPoolDesc& desc = pool->getDesc();
+        if (firstQuery > desc.queryCount || queryCount > desc.queryCount - firstQuery)
+        {
+            std::stringstream ss;
+            ss << function << ": range [" << firstQuery << ", " << uint64_t(firstQuery) + queryCount
+                << ") is outside of query pool " << utils::DebugNameToString(desc.debugName)
+                << " with " << desc.queryCount << " queries";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, firstQuery, queryCount, "resetQueries"))
+            return;
+
+        m_CommandList->resetQueries(pool, firstQuery, queryCount);
+    }
+
+    void CommandListWrapper::beginQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, queryIndex, 1, "beginQuery"))
+            return;
+
+        if (pool->getDesc().type != QueryType::PipelineStatistics && !requireType(CommandQueue::Graphics, "beginQuery with an occlusion query"))
+            return;
+
+        m_CommandList->beginQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::endQuery(IQueryPool* pool, uint32_t queryIndex)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, queryIndex, 1, "endQuery"))
+            return;
+
+        m_CommandList->endQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateQueryRange(pool, firstQuery, queryCount, "resolveQueries"))
+            return;
+
+        if (!dest)
+        {
+            error("resolveQueries: dest is NULL");
+            return;
+        }
+
+        const uint64_t resultSize = pool->getDesc().type == QueryType::PipelineStatistics
+            ? sizeof(PipelineStatistics)
+            : sizeof(uint64_t);
+
+        const BufferDesc& destDesc = dest->getDesc();
+        if ((destOffsetBytes % 8) != 0 || destOffsetBytes + resultSize * queryCount > destDesc.byteSize)
+        {
+            std::stringstream ss;
+            ss << "resolveQueries: " << queryCount << " results of " << resultSize << " bytes at offset " << destOffsetBytes
+                << " do not fit into buffer " << utils::DebugNameToString(destDesc.debugName) << " of size " << destDesc.byteSize
+                << ", or the offset is not a multiple of 8";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->resolveQueries(pool, firstQuery, queryCount, dest, destOffsetBytes);
+    }
+
+    void CommandListWrapper::beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!m_Device->queryFeatureSupport(Feature::Predication))
+        {
+            error("beginPredication: predication is not supported by the device");
+            return;
+        }
+
+        if (m_PredicationActive)
+        {
+            error("beginPredication: predication is already active, ranges cannot be nested");
+            return;
+        }
+
+        if (!buffer)
+        {
+            error("beginPredication: buffer is NULL");
+            return;
+        }
+
+        const BufferDesc& desc = buffer->getDesc();
+        if (!desc.isPredicationBuffer)
+        {
+            std::stringstream ss;
+            ss << "beginPredication: buffer " << utils::DebugNameToString(desc.debugName) << " does not have the isPredicationBuffer flag set";
+            error(ss.str());
+            return;
+        }
+
+        if ((offsetBytes % 8) != 0 || offsetBytes + sizeof(uint64_t) > desc.byteSize)
+        {
+            std::stringstream ss;
+            ss << "beginPredication: offset " << offsetBytes << " is not a multiple of 8 or is outside of buffer "
+                << utils::DebugNameToString(desc.debugName) << " of size " << desc.byteSize;
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->beginPredication(buffer, offsetBytes, op);
+        m_PredicationActive = true;
+    }
+
+    void CommandListWrapper::endPredication()
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!m_PredicationActive)
+        {
+            error("endPredication: predication is not active");
+            return;
+        }
+
+        m_CommandList->endPredication();
+        m_PredicationActive = false;
+    }
+
     void CommandListWrapper::beginMarker(const char *name)
     {
         if (!requireOpenState())
@@ -1077,6 +1829,140 @@ namespace nvrhi::validation
         m_CommandList->setPermanentBufferState(buffer, stateBits);
     }
 
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!texture)
+        {
+            error("beginTextureStateTransition: texture is NULL");
+            return;
+        }
+
+        m_CommandList->beginTextureStateTransition(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!buffer)
+        {
+            error("beginBufferStateTransition: buffer is NULL");
+            return;
+        }
+
+        m_CommandList->beginBufferStateTransition(buffer, stateBits);
+    }
+
+    void CommandListWrapper::releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!texture)
+        {
+            error("releaseTextureOwnership: texture is NULL");
+            return;
+        }
+
+        if (destinationQueue == m_type)
+        {
+            error("releaseTextureOwnership: destinationQueue is the queue of this command list");
+            return;
+        }
+
+        m_CommandList->releaseTextureOwnership(texture, subresources, destinationQueue, stateBits);
+    }
+
+    void CommandListWrapper::acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!texture)
+        {
+            error("acquireTextureOwnership: texture is NULL");
+            return;
+        }
+
+        if (sourceQueue == m_type)
+        {
+            error("acquireTextureOwnership: sourceQueue is the queue of this command list");
+            return;
+        }
+
+        m_CommandList->acquireTextureOwnership(texture, subresources, sourceQueue, stateBits);
+    }
+
+    void CommandListWrapper::releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!buffer)
+        {
+            error("releaseBufferOwnership: buffer is NULL");
+            return;
+        }
+
+        if (destinationQueue == m_type)
+        {
+            error("releaseBufferOwnership: destinationQueue is the queue of this command list");
+            return;
+        }
+
+        m_CommandList->releaseBufferOwnership(buffer, destinationQueue, stateBits);
+    }
+
+    void CommandListWrapper::acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!buffer)
+        {
+            error("acquireBufferOwnership: buffer is NULL");
+            return;
+        }
+
+        if (sourceQueue == m_type)
+        {
+            error("acquireBufferOwnership: sourceQueue is the queue of this command list");
+            return;
+        }
+
+        m_CommandList->acquireBufferOwnership(buffer, sourceQueue, stateBits);
+    }
+
+    void CommandListWrapper::setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!resourceAfter)
+        {
+            error("setAliasingBarrier: resourceAfter is NULL");
+            return;
+        }
+
+        if (!dynamic_cast<ITexture*>(resourceAfter) && !dynamic_cast<IBuffer*>(resourceAfter))
+        {
+            error("setAliasingBarrier: resourceAfter must be a texture or a buffer");
+            return;
+        }
+
+        if (resourceBefore == resourceAfter)
+        {
+            error("setAliasingBarrier: resourceBefore and resourceAfter must be different resources");
+            return;
+        }
+
+        m_CommandList->setAliasingBarrier(resourceBefore, resourceAfter);
+    }
+
     void CommandListWrapper::commitBarriers()
     {
         if (!requireOpenState())
@@ -1125,6 +2011,16 @@ namespace nvrhi::validation
         return m_CommandList->getDesc();
     }
 
+    BarrierStatistics CommandListWrapper::getBarrierStatistics()
+    {
+        return m_CommandList->getBarrierStatistics();
+    }
+
+    CommandListStatistics CommandListWrapper::getStatistics()
+    {
+        return m_CommandList->getStatistics();
+    }
+
     void CommandListWrapper::setRayTracingState(const rt::State& state)
     {
         if (!requireOpenState())
@@ -1145,36 +2041,163 @@ namespace nvrhi::validation
         m_CurrentRayTracingState = state;
     }
 
-    void CommandListWrapper::dispatchRays(const rt::DispatchRaysArguments& args)
+    void CommandListWrapper::dispatchRays(const rt::DispatchRaysArguments& args)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "dispatchRays"))
+            return;
+
+        if (!m_RayTracingStateSet)
+        {
+            error("Ray tracing state is not set before a dispatchRays call.\n"
+                "Note that setting graphics or compute state invalidates the ray tracing state.");
+            return;
+        }
+
+        if (!validatePushConstants("ray tracing", "setRayTracingState"))
+            return;
+
+        m_CommandList->dispatchRays(args);
+    }
+
+    void CommandListWrapper::compactBottomLevelAccelStructs()
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "compactBottomLevelAccelStructs"))
+            return;
+
+        m_CommandList->compactBottomLevelAccelStructs();
+    }
+
+    bool CommandListWrapper::validateAccelStructSerialization(const char* function, rt::IAccelStruct*& as, IBuffer* buffer, uint64_t offset, uint64_t alignment, bool requireBuilt) const
+    {
+        if (!requireOpenState())
+            return false;
+
+        if (!requireType(CommandQueue::Compute, function))
+            return false;
+
+        if (!as)
+        {
+            std::stringstream ss;
+            ss << function << ": 'as' is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        if (!buffer)
+        {
+            std::stringstream ss;
+            ss << function << ": 'buffer' is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        if (offset % alignment != 0)
+        {
+            std::stringstream ss;
+            ss << function << ": 'offset' (" << offset << ") must be a multiple of " << alignment;
+            error(ss.str());
+            return false;
+        }
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+        {
+            if (wrapper->isTopLevel)
+            {
+                std::stringstream ss;
+                ss << function << ": only bottom-level acceleration structures can be serialized, "
+                    << utils::DebugNameToString(wrapper->getDesc().debugName) << " is a TLAS";
+                error(ss.str());
+                return false;
+            }
+
+            if (requireBuilt && !wrapper->wasBuilt)
+            {
+                std::stringstream ss;
+                ss << function << ": BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " has not been built or deserialized";
+                error(ss.str());
+                return false;
+            }
+
+            as = wrapper->getUnderlyingObject();
+        }
+
+        if (!requireBuilt && as->isCompacted())
+        {
+            std::stringstream ss;
+            ss << function << ": BLAS " << utils::DebugNameToString(as->getDesc().debugName)
+                << " is compacted, its storage may be too small for the deserialized data";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset)
+    {
+        if (!validateAccelStructSerialization("writeAccelStructSerializedSize", as, buffer, offset, 8, true))
+            return;
+
+        if (offset + sizeof(rt::AccelStructSerializedSizeInfo) > buffer->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "writeAccelStructSerializedSize: buffer " << utils::DebugNameToString(buffer->getDesc().debugName)
+                << " is too small to hold the size info at offset " << offset;
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->writeAccelStructSerializedSize(as, buffer, offset);
+    }
+
+    void CommandListWrapper::serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset)
     {
-        if (!requireOpenState())
+        if (!validateAccelStructSerialization("serializeAccelStruct", as, buffer, offset, 256, true))
             return;
 
-        if (!requireType(CommandQueue::Compute, "dispatchRays"))
-            return;
-
-        if (!m_RayTracingStateSet)
+        if (!buffer->getDesc().canHaveUAVs)
         {
-            error("Ray tracing state is not set before a dispatchRays call.\n"
-                "Note that setting graphics or compute state invalidates the ray tracing state.");
+            std::stringstream ss;
+            ss << "serializeAccelStruct: buffer " << utils::DebugNameToString(buffer->getDesc().debugName)
+                << " must be created with canHaveUAVs = true";
+            error(ss.str());
             return;
         }
 
-        if (!validatePushConstants("ray tracing", "setRayTracingState"))
-            return;
-
-        m_CommandList->dispatchRays(args);
+        m_CommandList->serializeAccelStruct(as, buffer, offset);
     }
 
-    void CommandListWrapper::compactBottomLevelAccelStructs()
+    void CommandListWrapper::deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset)
     {
-        if (!requireOpenState())
+        rt::IAccelStruct* underlyingAS = as;
+        if (!validateAccelStructSerialization("deserializeAccelStruct", underlyingAS, buffer, offset, 256, false))
             return;
 
-        if (!requireType(CommandQueue::Compute, "compactBottomLevelAccelStructs"))
+        if (!buffer->getDesc().isAccelStructBuildInput)
+        {
+            std::stringstream ss;
+            ss << "deserializeAccelStruct: buffer " << utils::DebugNameToString(buffer->getDesc().debugName)
+                << " must be created with isAccelStructBuildInput = true";
+            error(ss.str());
             return;
+        }
 
-        m_CommandList->compactBottomLevelAccelStructs();
+        if (AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as))
+        {
+            // The deserialized geometry is unknown, so later updates are validated against an empty geometry list
+            wrapper->wasBuilt = true;
+            wrapper->buildGeometries.clear();
+        }
+
+        m_CommandList->deserializeAccelStruct(underlyingAS, buffer, offset);
     }
 
     void CommandListWrapper::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) 
@@ -1188,27 +2211,19 @@ namespace nvrhi::validation
         m_CommandList->buildOpacityMicromap(omm, desc);
     }
 
-    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    bool CommandListWrapper::validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const
     {
-        if (!requireOpenState())
-            return;
-
-        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStruct"))
-            return;
-
-        rt::IAccelStruct* underlyingAS = as;
-
-        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
-        if (wrapper)
+        if (wrapper->isTopLevel)
         {
-            underlyingAS = wrapper->getUnderlyingObject();
+            error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
+            return false;
+        }
 
-            if (wrapper->isTopLevel)
-            {
-                error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
-                return;
-            }
-            
+        // The per-geometry checks are the expensive part, the rest runs on every build
+        bool const deepChecks = shouldRunDeepChecks();
+        
+        if (deepChecks)
+        {
             for (size_t i = 0; i < numGeometries; i++)
             {
                 const auto& geom = pGeometries[i];
@@ -1225,10 +2240,10 @@ namespace nvrhi::validation
                             if (m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN)
                             {
                                 std::stringstream ss;
-                                ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                                ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                     << " has index format R8_UINT which is only supported on Vulkan";
                                 error(ss.str());
-                                return;
+                                return false;
                             }
                             break;
                         case Format::R16_UINT:
@@ -1236,53 +2251,53 @@ namespace nvrhi::validation
                             break;
                         default: {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                 << " has unsupported index format: " << utils::FormatToString(triangles.indexFormat);
                             error(ss.str());
-                            return;
+                            return false;
                         }
                         }
 
                         if (triangles.indexBuffer == nullptr)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                 << " has a NULL index buffer but indexFormat is " << utils::FormatToString(triangles.indexFormat);
                             error(ss.str());
-                            return;
+                            return false;
                         }
 
                         const BufferDesc& indexBufferDesc = triangles.indexBuffer->getDesc();
                         if (!indexBufferDesc.isAccelStructBuildInput)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                 << " has index buffer = " << utils::DebugNameToString(indexBufferDesc.debugName)
                                 << " which does not have the isAccelStructBuildInput flag set";
                             error(ss.str());
-                            return;
+                            return false;
                         }
 
                         const size_t indexSize = triangles.indexCount * getFormatInfo(triangles.indexFormat).bytesPerBlock;
                         if (triangles.indexOffset + indexSize > indexBufferDesc.byteSize)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                 << " points at " << indexSize << " bytes of index data at offset " << triangles.indexOffset
                                 << " in buffer " << utils::DebugNameToString(indexBufferDesc.debugName) << " whose size is " << indexBufferDesc.byteSize
                                 << ", which will result in a buffer overrun";
                             error(ss.str());
-                            return;
+                            return false;
                         }
 
                         if ((triangles.indexCount % 3) != 0)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                 << " has indexCount = " << triangles.indexCount
                                 << ", which is not a multiple of 3";
                             error(ss.str());
-                            return;
+                            return false;
                         }
                     }
                     else
@@ -1290,20 +2305,20 @@ namespace nvrhi::validation
                         if (triangles.indexCount != 0 || triangles.indexBuffer != nullptr)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                 << " has indexFormat = UNKNOWN but nonzero indexCount = " << triangles.indexCount;
                             error(ss.str());
-                            return;
+                            return false;
                         }
 
                         if (triangles.indexBuffer != nullptr)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                                 << " has indexFormat = UNKNOWN but non-NULL indexBuffer = "
                                 << utils::DebugNameToString(triangles.indexBuffer->getDesc().debugName);
                             error(ss.str());
-                            return;
+                            return false;
                         }
                     }
 
@@ -1326,62 +2341,62 @@ namespace nvrhi::validation
                         break;
                     default: {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has unsupported vertex format: " << utils::FormatToString(triangles.vertexFormat);
                         error(ss.str());
-                        return;
+                        return false;
                     }
                     }
 
                     if (triangles.vertexBuffer == nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has NULL vertex buffer";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     if (triangles.vertexStride == 0)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has vertexStride = 0";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     if ((triangles.indexFormat == Format::UNKNOWN) && (triangles.vertexCount % 3) != 0)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has indexFormat = UNKNOWN and vertexCount = " << triangles.vertexCount
                             << ", which is not a multiple of 3";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     const BufferDesc& vertexBufferDesc = triangles.vertexBuffer->getDesc();
                     if (!vertexBufferDesc.isAccelStructBuildInput)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has vertex buffer = " << utils::DebugNameToString(vertexBufferDesc.debugName)
                             << " which does not have the isAccelStructBuildInput flag set";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     const size_t vertexDataSize = triangles.vertexCount * triangles.vertexStride;
                     if (triangles.vertexOffset + vertexDataSize > vertexBufferDesc.byteSize)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " points at " << vertexDataSize << " bytes of vertex data at offset " << triangles.vertexOffset
                             << " in buffer " << utils::DebugNameToString(vertexBufferDesc.debugName) << " whose size is " << vertexBufferDesc.byteSize
                             << ", which will result in a buffer overrun";
                         error(ss.str());
-                        return;
+                        return false;
                     }
                 }
                 else if (geom.geometryType == rt::GeometryType::AABBs)
@@ -1391,49 +2406,49 @@ namespace nvrhi::validation
                     if (aabbs.buffer== nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has NULL AABB data buffer";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     const BufferDesc& aabbBufferDesc = aabbs.buffer->getDesc();
                     if (!aabbBufferDesc.isAccelStructBuildInput)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has AABB data buffer = " << utils::DebugNameToString(aabbBufferDesc.debugName)
                             << " which does not have the isAccelStructBuildInput flag set";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     if (aabbs.count > 1 && aabbs.stride < sizeof(rt::GeometryAABB))
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has AABB stride = " << aabbs.stride
                             << " which is less than the size of one AABB (" << sizeof(rt::GeometryAABB) << " bytes)";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     const size_t aabbDataSize = aabbs.count * aabbs.stride;
                     if (aabbs.offset + aabbDataSize > aabbBufferDesc.byteSize)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " points at " << aabbDataSize << " bytes of AABB data at offset " << aabbs.offset
                             << " in buffer " << utils::DebugNameToString(aabbBufferDesc.debugName) << " whose size is " << aabbBufferDesc.byteSize
                             << ", which will result in a buffer overrun";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     if (geom.useTransform)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " is of type AABB but has useTransform = true, "
                             "which is unsupported, and the transform will be ignored";
                         m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
@@ -1446,10 +2461,10 @@ namespace nvrhi::validation
                     if (spheres.vertexBuffer == nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has NULL vertex buffer";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     // TODO: Add more validation
@@ -1461,46 +2476,49 @@ namespace nvrhi::validation
                     if (lss.vertexBuffer == nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
                             << " has NULL vertex buffer";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     // TODO: Add more validation
                 }
             }
+        }
 
-            if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+        if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+        {
+            if (!wrapper->allowUpdate)
             {
-                if (!wrapper->allowUpdate)
-                {
-                    std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " that was not created with the AllowUpdate flag";
-                    error(ss.str());
-                    return;
-                }
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " that was not created with the AllowUpdate flag";
+                error(ss.str());
+                return false;
+            }
 
-                if (!wrapper->wasBuilt)
-                {
-                    std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " before the same BLAS was initially built";
-                    error(ss.str());
-                    return;
-                }
+            if (!wrapper->wasBuilt)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " before the same BLAS was initially built";
+                error(ss.str());
+                return false;
+            }
 
-                if (numGeometries != wrapper->buildGeometries.size())
-                {
-                    std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " with " << numGeometries << " geometries "
-                        "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
-                    error(ss.str());
-                    return;
-                }
-                
+            if (numGeometries != wrapper->buildGeometries.size())
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " with " << numGeometries << " geometries "
+                    "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
+                error(ss.str());
+                return false;
+            }
+            
+            if (deepChecks)
+            {
                 for (size_t i = 0; i < numGeometries; i++)
                 {
                     const auto& before = wrapper->buildGeometries[i];
@@ -1509,10 +2527,10 @@ namespace nvrhi::validation
                     if (before.geometryType != after.geometryType)
                     {
                         std::stringstream ss;
-                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
+                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
                             << " with mismatching geometry types in slot " << i;
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
                     if (before.geometryType == rt::GeometryType::Triangles)
@@ -1531,11 +2549,11 @@ namespace nvrhi::validation
                         if (primitivesBefore != primitivesAfter)
                         {
                             std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
+                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
                                 << " with mismatching triangle counts in geometry slot " << i << ": "
                                 "built with " << primitivesBefore << " triangles, updating with " << primitivesAfter << " triangles";
                             error(ss.str());
-                            return;
+                            return false;
                         }
                     }
                     else // AABBs
@@ -1546,30 +2564,117 @@ namespace nvrhi::validation
                         if (aabbsBefore != aabbsAfter)
                         {
                             std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
+                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
                                 << " with mismatching AABB counts in geometry slot " << i << ": "
                                 "built with " << aabbsBefore << " AABBs, updating with " << aabbsAfter << " AABBs";
                             error(ss.str());
-                            return;
+                            return false;
                         }
                     }
                 }
             }
+        }
+
+        if (wrapper->allowCompaction && wrapper->wasBuilt)
+        {
+            std::stringstream ss;
+            ss << "Cannot rebuild BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                << " that has the AllowCompaction flag set";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStruct"))
+            return;
+
+        rt::IAccelStruct* underlyingAS = as;
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+        {
+            underlyingAS = wrapper->getUnderlyingObject();
+
+            if (!validateBuildBottomLevelAccelStruct(wrapper, pGeometries, numGeometries, buildFlags))
+                return;
+
+            wrapper->wasBuilt = true;
+            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+        }
+
+        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStructs"))
+            return;
+
+        if (!pBuilds && numBuilds != 0)
+        {
+            error("buildBottomLevelAccelStructs: 'pBuilds' is NULL");
+            return;
+        }
+
+        std::vector<rt::BlasBuildDesc> patchedBuilds;
+        patchedBuilds.assign(pBuilds, pBuilds + numBuilds);
+
+        std::unordered_set<rt::IAccelStruct*> uniqueAccelStructs;
+
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            rt::BlasBuildDesc& build = patchedBuilds[i];
+
+            if (!build.accelStruct)
+            {
+                std::stringstream ss;
+                ss << "buildBottomLevelAccelStructs: 'accelStruct' is NULL in build " << i;
+                error(ss.str());
+                return;
+            }
 
-            if (wrapper->allowCompaction && wrapper->wasBuilt)
+            if (!uniqueAccelStructs.insert(build.accelStruct).second)
             {
                 std::stringstream ss;
-                ss << "Cannot rebuild BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                    << " that has the AllowCompaction flag set";
+                ss << "BLAS " << utils::DebugNameToString(build.accelStruct->getDesc().debugName)
+                    << " appears more than once in a buildBottomLevelAccelStructs batch";
                 error(ss.str());
                 return;
             }
 
-            wrapper->wasBuilt = true;
-            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+            AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct);
+            if (wrapper)
+            {
+                if (!validateBuildBottomLevelAccelStruct(wrapper, build.geometries, build.numGeometries, build.buildFlags))
+                    return;
+
+                build.accelStruct = wrapper->getUnderlyingObject();
+            }
         }
 
-        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+        // Only record the builds as done after the whole batch has been validated
+        for (size_t i = 0; i < numBuilds; i++)
+        {
+            const rt::BlasBuildDesc& build = pBuilds[i];
+
+            if (AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct))
+            {
+                wrapper->wasBuilt = true;
+                wrapper->buildGeometries.assign(build.geometries, build.geometries + build.numGeometries);
+            }
+        }
+
+        m_CommandList->buildBottomLevelAccelStructs(patchedBuilds.data(), patchedBuilds.size());
     }
 
     bool CommandListWrapper::validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const
@@ -1775,6 +2880,134 @@ namespace nvrhi::validation
         m_CommandList->buildTopLevelAccelStructFromBuffer(underlyingAS, instanceBuffer, instanceBufferOffset, numInstances, buildFlags);
     }
 
+    rt::IndirectInstanceDesc* CommandListWrapper::allocateTopLevelInstances(size_t numInstances)
+    {
+        if (!requireOpenState())
+            return nullptr;
+
+        if (!requireType(CommandQueue::Compute, "allocateTopLevelInstances"))
+            return nullptr;
+
+        if (numInstances == 0)
+        {
+            error("allocateTopLevelInstances: numInstances is 0");
+            return nullptr;
+        }
+
+        return m_CommandList->allocateTopLevelInstances(numInstances);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildTopLevelAccelStruct"))
+            return;
+
+        if (!as)
+        {
+            error("buildTopLevelAccelStructFromAllocatedInstances: 'as' is NULL");
+            return;
+        }
+
+        if (!pInstances && numInstances != 0)
+        {
+            error("buildTopLevelAccelStructFromAllocatedInstances: 'pInstances' is NULL");
+            return;
+        }
+
+        rt::IAccelStruct* underlyingAS = as;
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+        {
+            underlyingAS = wrapper->getUnderlyingObject();
+
+            if (!validateBuildTopLevelAccelStruct(wrapper, numInstances, buildFlags))
+                return;
+        }
+
+        m_CommandList->buildTopLevelAccelStructFromAllocatedInstances(underlyingAS, pInstances, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "updateTopLevelInstances"))
+            return;
+
+        if (!as)
+        {
+            error("updateTopLevelInstances: 'as' is NULL");
+            return;
+        }
+
+        if (!pInstances && numInstances != 0)
+        {
+            error("updateTopLevelInstances: 'pInstances' is NULL");
+            return;
+        }
+
+        const rt::AccelStructDesc& asDesc = as->getDesc();
+
+        if (!asDesc.isTopLevel || !asDesc.persistentInstanceBuffer)
+        {
+            std::stringstream ss;
+            ss << "Cannot perform updateTopLevelInstances on AS " << utils::DebugNameToString(asDesc.debugName)
+                << " which is not a TLAS created with persistentInstanceBuffer = true";
+            error(ss.str());
+            return;
+        }
+
+        if (uint64_t(firstInstance) + numInstances > asDesc.topLevelMaxInstances)
+        {
+            std::stringstream ss;
+            ss << "updateTopLevelInstances: instances [" << firstInstance << ", " << uint64_t(firstInstance) + numInstances
+                << ") are out of bounds for TLAS " << utils::DebugNameToString(asDesc.debugName)
+                << " with topLevelMaxInstances = " << asDesc.topLevelMaxInstances;
+            error(ss.str());
+            return;
+        }
+
+        std::vector<rt::InstanceDesc> patchedInstances;
+        patchedInstances.assign(pInstances, pInstances + numInstances);
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            rt::InstanceDesc& instance = patchedInstances[i];
+
+            AccelStructWrapper* blasWrapper = dynamic_cast<AccelStructWrapper*>(instance.bottomLevelAS);
+            if (blasWrapper)
+            {
+                if (blasWrapper->isTopLevel)
+                {
+                    std::stringstream ss;
+                    ss << "TLAS " << utils::DebugNameToString(asDesc.debugName) << " instance " << firstInstance + i
+                        << " refers to another TLAS, which is unsupported";
+                    error(ss.str());
+                    return;
+                }
+
+                if (!blasWrapper->wasBuilt)
+                {
+                    std::stringstream ss;
+                    ss << "TLAS " << utils::DebugNameToString(asDesc.debugName) << " instance " << firstInstance + i
+                        << " refers to a BLAS which was never built";
+                    error(ss.str());
+                    return;
+                }
+            }
+
+            instance.bottomLevelAS = checked_cast<rt::IAccelStruct*>(unwrapResource(instance.bottomLevelAS));
+        }
+
+        m_CommandList->updateTopLevelInstances(checked_cast<rt::IAccelStruct*>(unwrapResource(as)), firstInstance,
+            patchedInstances.data(), patchedInstances.size());
+    }
+
     void CommandListWrapper::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
         if (!requireOpenState())
@@ -27,6 +27,8 @@
 
 #include <sstream>
 
+#include "../common/indirect-commands.h"
+
 namespace nvrhi::validation
 {
     template<typename T>
@@ -59,15 +61,43 @@ namespace nvrhi::validation
 
     DeviceHandle createValidationLayer(IDevice* underlyingDevice)
     {
-        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice);
+        return createValidationLayer(underlyingDevice, ValidationLayerDesc());
+    }
+
+    DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc)
+    {
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice, desc);
         return DeviceHandle::Create(wrapper);
     }
 
-    DeviceWrapper::DeviceWrapper(IDevice* device)
+    DeviceWrapper::DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc)
         : m_Device(device)
         , m_MessageCallback(device->getMessageCallback())
+        , m_Desc(desc)
     {
+        m_Desc.samplingInterval = std::max(m_Desc.samplingInterval, 1u);
+    }
 
+    bool DeviceWrapper::shouldRunDeepChecks(std::atomic<uint32_t>& callCounter) const
+    {
+        switch (m_Desc.tier)
+        {
+        case ValidationTier::Cheap:
+            return false;
+        case ValidationTier::Full:
+            return true;
+        case ValidationTier::Sampled:
+        default:
+            if (m_Desc.samplingMode == ValidationSamplingMode::PerFrame)
+                return m_FrameIndex.load() % m_Desc.samplingInterval == 0;
+
+            return callCounter.fetch_add(1) % m_Desc.samplingInterval == 0;
+        }
+    }
+
+    DeviceWrapper::~DeviceWrapper()
+    {
+        m_PipelineCompilePool.shutdown();
     }
 
     void DeviceWrapper::error(const std::string& messageText) const
@@ -279,6 +309,43 @@ namespace nvrhi::validation
         m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
     }
 
+    void DeviceWrapper::updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue)
+    {
+        if (numUpdates > 0 && !updates)
+        {
+            error("updateTextureTileMappingsBatch: 'updates' is NULL while 'numUpdates' is " + std::to_string(numUpdates));
+            return;
+        }
+
+        for (uint32_t i = 0; i < numUpdates; i++)
+        {
+            const TextureTilesMappingUpdate& update = updates[i];
+
+            if (!update.texture)
+            {
+                error("updateTextureTileMappingsBatch: texture in update " + std::to_string(i) + " is NULL");
+                return;
+            }
+
+            if (!update.texture->getDesc().isTiled)
+            {
+                std::stringstream ss;
+                ss << "updateTextureTileMappingsBatch: texture " << utils::DebugNameToString(update.texture->getDesc().debugName)
+                    << " in update " << i << " is not tiled";
+                error(ss.str());
+                return;
+            }
+
+            if (update.numTileMappings > 0 && !update.tileMappings)
+            {
+                error("updateTextureTileMappingsBatch: 'tileMappings' in update " + std::to_string(i) + " is NULL");
+                return;
+            }
+        }
+
+        m_Device->updateTextureTileMappingsBatch(updates, numUpdates, executionQueue);
+    }
+
     SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
     {
         const GraphicsAPI graphicsApi = m_Device->getGraphicsAPI();
@@ -475,16 +542,139 @@ namespace nvrhi::validation
         return m_Device->createBuffer(patchedDesc);
     }
 
+    BufferHandle DeviceWrapper::createBufferFromHostMemory(const BufferDesc& d, void* hostMemory)
+    {
+        BufferDesc patchedDesc = d;
+        if (patchedDesc.debugName.empty())
+            patchedDesc.debugName = utils::GenerateBufferDebugName(patchedDesc);
+
+        HostMemoryImportFeatureInfo hostMemoryInfo;
+        if (!m_Device->queryFeatureSupport(Feature::HostMemoryImport, &hostMemoryInfo, sizeof(hostMemoryInfo)))
+        {
+            error("createBufferFromHostMemory: host memory import is not supported by the device");
+            return nullptr;
+        }
+
+        if (!hostMemory || d.byteSize == 0)
+        {
+            std::stringstream ss;
+            ss << "createBufferFromHostMemory: buffer " << patchedDesc.debugName << " has a NULL host pointer or zero size";
+            error(ss.str());
+            return nullptr;
+        }
+
+        const uint64_t alignment = std::max<uint64_t>(hostMemoryInfo.minPointerAlignment, 1);
+        if ((reinterpret_cast<uintptr_t>(hostMemory) % alignment) != 0 || (d.byteSize % alignment) != 0)
+        {
+            std::stringstream ss;
+            ss << "createBufferFromHostMemory: the host pointer and size of buffer " << patchedDesc.debugName
+                << " must be multiples of " << alignment << " bytes";
+            error(ss.str());
+            return nullptr;
+        }
+
+        if (d.isVolatile || d.isVirtual || d.sharedResourceFlags != SharedResourceFlags::None)
+        {
+            std::stringstream ss;
+            ss << "createBufferFromHostMemory: buffer " << patchedDesc.debugName << " cannot be volatile, virtual or shared";
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_Device->createBufferFromHostMemory(patchedDesc, hostMemory);
+    }
+
     void * DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags)
     {
         return m_Device->mapBuffer(b, mapFlags);
     }
 
+    void * DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags, uint64_t offset, size_t size)
+    {
+        if (!validateMappedRange(b, offset, size, "mapBuffer"))
+            return nullptr;
+
+        if (mapFlags == CpuAccessMode::None || b->getDesc().cpuAccess != mapFlags)
+        {
+            std::stringstream ss;
+            ss << "Cannot map buffer " << utils::DebugNameToString(b->getDesc().debugName) << " for "
+                << (mapFlags == CpuAccessMode::Read ? "reading" : mapFlags == CpuAccessMode::Write ? "writing" : "no access")
+                << " because it was not created with that CPU access mode";
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_Device->mapBuffer(b, mapFlags, offset, size);
+    }
+
     void DeviceWrapper::unmapBuffer(IBuffer* b)
     {
         m_Device->unmapBuffer(b);
     }
 
+    void DeviceWrapper::flushMappedRange(IBuffer* b, uint64_t offset, size_t size)
+    {
+        if (!validateMappedRange(b, offset, size, "flushMappedRange"))
+            return;
+
+        m_Device->flushMappedRange(b, offset, size);
+    }
+
+    void DeviceWrapper::invalidateMappedRange(IBuffer* b, uint64_t offset, size_t size)
+    {
+        if (!validateMappedRange(b, offset, size, "invalidateMappedRange"))
+            return;
+
+        m_Device->invalidateMappedRange(b, offset, size);
+    }
+
+    bool DeviceWrapper::validateMappedRange(IBuffer* b, uint64_t offset, size_t size, const char* function)
+    {
+        if (!b)
+        {
+            std::stringstream ss;
+            ss << function << ": buffer is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        const BufferDesc& desc = b->getDesc();
+        if (offset > desc.byteSize || size > desc.byteSize - offset)
+        {
+            std::stringstream ss;
+            ss << function << ": range [" << offset << ", " << offset + size << ") is outside of buffer "
+                << utils::DebugNameToString(desc.debugName) << " of size " << desc.byteSize;
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool DeviceWrapper::validateTimestampRange(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, const char* function)
+    {
+        if (!pool)
+        {
+            std::stringstream ss;
+            ss << function << ": pool is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        const TimestampQueryPoolDesc& desc = pool->getDesc();
+        if (firstQuery > desc.queryCount || queryCount > desc.queryCount - firstQuery)
+        {
+            std::stringstream ss;
+            ss << function << ": range [" << firstQuery << ", " << uint64_t(firstQuery) + queryCount
+                << ") is outside of timestamp query pool " << utils::DebugNameToString(desc.debugName)
+                << " with " << desc.queryCount << " queries";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
     MemoryRequirements DeviceWrapper::getBufferMemoryRequirements(IBuffer* buffer)
     {
         if (buffer == nullptr)
@@ -659,6 +849,60 @@ namespace nvrhi::validation
         return m_Device->resetTimerQuery(query);
     }
 
+    TimestampQueryPoolHandle DeviceWrapper::createTimestampQueryPool(const TimestampQueryPoolDesc& desc)
+    {
+        if (desc.queryCount == 0)
+        {
+            std::stringstream ss;
+            ss << "createTimestampQueryPool: queryCount must be positive for pool " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_Device->createTimestampQueryPool(desc);
+    }
+
+    bool DeviceWrapper::getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps)
+    {
+        if (!validateTimestampRange(pool, firstQuery, queryCount, "getTimestampResults"))
+            return false;
+
+        if (!outTimestamps)
+        {
+            error("getTimestampResults: outTimestamps is NULL");
+            return false;
+        }
+
+        return m_Device->getTimestampResults(pool, firstQuery, queryCount, outTimestamps);
+    }
+
+    uint64_t DeviceWrapper::getTimestampFrequency(CommandQueue queue)
+    {
+        return m_Device->getTimestampFrequency(queue);
+    }
+
+    QueryPoolHandle DeviceWrapper::createQueryPool(const QueryPoolDesc& desc)
+    {
+        if (desc.queryCount == 0)
+        {
+            std::stringstream ss;
+            ss << "createQueryPool: queryCount must be positive for pool " << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return nullptr;
+        }
+
+        if (desc.type == QueryType::PipelineStatistics && !m_Device->queryFeatureSupport(Feature::PipelineStatisticsQueries))
+        {
+            std::stringstream ss;
+            ss << "createQueryPool: pipeline statistics queries are not supported by the device, pool "
+                << utils::DebugNameToString(desc.debugName);
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_Device->createQueryPool(desc);
+    }
+
     GraphicsAPI DeviceWrapper::getGraphicsAPI()
     {
         return m_Device->getGraphicsAPI();
@@ -817,6 +1061,184 @@ namespace nvrhi::validation
         return m_Device->createFramebuffer(desc);
     }
 
+    CommandBundleHandle DeviceWrapper::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (desc.draws.empty())
+        {
+            std::stringstream ss;
+            ss << "Command bundle " << utils::DebugNameToString(desc.debugName) << " has no draws";
+            error(ss.str());
+            return nullptr;
+        }
+
+        const GraphicsState& firstState = desc.draws[0].state;
+
+        for (size_t index = 0; index < desc.draws.size(); index++)
+        {
+            const GraphicsState& state = desc.draws[index].state;
+
+            if (!state.pipeline || !state.framebuffer)
+            {
+                std::stringstream ss;
+                ss << "Draw " << index << " in command bundle " << utils::DebugNameToString(desc.debugName)
+                    << " has no pipeline or framebuffer";
+                error(ss.str());
+                return nullptr;
+            }
+
+            if (state.framebuffer != firstState.framebuffer)
+            {
+                std::stringstream ss;
+                ss << "Draw " << index << " in command bundle " << utils::DebugNameToString(desc.debugName)
+                    << " uses a different framebuffer than the first draw, all draws in a bundle must use the same framebuffer";
+                error(ss.str());
+                return nullptr;
+            }
+
+            if (arraysAreDifferent(state.viewport.viewports, firstState.viewport.viewports)
+                || arraysAreDifferent(state.viewport.scissorRects, firstState.viewport.scissorRects)
+                || state.shadingRateState != firstState.shadingRateState)
+            {
+                std::stringstream ss;
+                ss << "Draw " << index << " in command bundle " << utils::DebugNameToString(desc.debugName)
+                    << " uses a different viewport or shading rate state than the first draw";
+                error(ss.str());
+                return nullptr;
+            }
+
+            if (state.indirectParams || state.indirectCountBuffer)
+            {
+                std::stringstream ss;
+                ss << "Draw " << index << " in command bundle " << utils::DebugNameToString(desc.debugName)
+                    << " has indirect parameters, which are not supported in bundles";
+                error(ss.str());
+                return nullptr;
+            }
+
+            const FramebufferInfo& pipelineFbInfo = state.pipeline->getFramebufferInfo();
+            if (pipelineFbInfo != state.framebuffer->getFramebufferInfo())
+            {
+                std::stringstream ss;
+                ss << "Draw " << index << " in command bundle " << utils::DebugNameToString(desc.debugName)
+                    << " uses a pipeline that is incompatible with the framebuffer";
+                error(ss.str());
+                return nullptr;
+            }
+        }
+
+        return m_Device->createCommandBundle(desc);
+    }
+
+    static uint32_t getPipelinePushConstantSize(const BindingLayoutVector& bindingLayouts)
+    {
+        for (const auto& layout : bindingLayouts)
+        {
+            const BindingLayoutDesc* layoutDesc = layout->getDesc();
+
+            if (!layoutDesc) // bindless layouts have null desc
+                continue;
+
+            for (const auto& item : layoutDesc->bindings)
+            {
+                if (item.type == ResourceType::PushConstants)
+                    return item.size;
+            }
+        }
+
+        return 0;
+    }
+
+    IndirectCommandLayoutHandle DeviceWrapper::createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc)
+    {
+        const std::string layoutName = utils::DebugNameToString(desc.debugName);
+
+        if (!m_Device->queryFeatureSupport(Feature::IndirectCommandLayouts))
+        {
+            error("Indirect command layouts are not supported by this device");
+            return nullptr;
+        }
+
+        if (!desc.graphicsPipeline == !desc.computePipeline)
+        {
+            std::stringstream ss;
+            ss << "Indirect command layout " << layoutName << " must have exactly one of graphicsPipeline or computePipeline set";
+            error(ss.str());
+            return nullptr;
+        }
+
+        if (desc.arguments.empty())
+        {
+            std::stringstream ss;
+            ss << "Indirect command layout " << layoutName << " has no arguments";
+            error(ss.str());
+            return nullptr;
+        }
+
+        const bool isGraphics = desc.graphicsPipeline != nullptr;
+        const uint32_t pushConstantSize = getPipelinePushConstantSize(isGraphics
+            ? desc.graphicsPipeline->getDesc().bindingLayouts
+            : desc.computePipeline->getDesc().bindingLayouts);
+
+        for (size_t index = 0; index < desc.arguments.size(); index++)
+        {
+            const IndirectArgumentDesc& argument = desc.arguments[index];
+            const bool isLast = index == desc.arguments.size() - 1;
+
+            const bool isAction = argument.type == IndirectArgumentType::Draw
+                || argument.type == IndirectArgumentType::DrawIndexed
+                || argument.type == IndirectArgumentType::Dispatch;
+
+            if (isAction != isLast)
+            {
+                std::stringstream ss;
+                ss << "Indirect command layout " << layoutName << ": the last argument must be the only "
+                    "Draw, DrawIndexed or Dispatch argument, argument " << index << " violates that";
+                error(ss.str());
+                return nullptr;
+            }
+
+            if (argument.type == IndirectArgumentType::PushConstants)
+            {
+                if (argument.pushConstantsByteSize == 0
+                    || (argument.pushConstantsByteSize & 3) != 0
+                    || (argument.pushConstantsOffset & 3) != 0
+                    || argument.pushConstantsOffset + argument.pushConstantsByteSize > pushConstantSize)
+                {
+                    std::stringstream ss;
+                    ss << "Indirect command layout " << layoutName << ": push constants argument " << index
+                        << " (offset " << argument.pushConstantsOffset << ", size " << argument.pushConstantsByteSize
+                        << ") must be a non-empty range aligned to 4 bytes within the pipeline's push constants ("
+                        << pushConstantSize << " bytes)";
+                    error(ss.str());
+                    return nullptr;
+                }
+            }
+            else if ((argument.type == IndirectArgumentType::Dispatch) == isGraphics)
+            {
+                std::stringstream ss;
+                ss << "Indirect command layout " << layoutName << ": argument " << index << " is incompatible with a "
+                    << (isGraphics ? "graphics" : "compute") << " pipeline";
+                error(ss.str());
+                return nullptr;
+            }
+        }
+
+        IndirectCommandLayoutDesc packedDesc = desc;
+        packedDesc.byteStride = 0;
+        const uint32_t packedStride = getIndirectCommandStride(packedDesc);
+
+        if (desc.byteStride != 0 && (desc.byteStride < packedStride || (desc.byteStride & 3) != 0))
+        {
+            std::stringstream ss;
+            ss << "Indirect command layout " << layoutName << " has byteStride " << desc.byteStride
+                << ", which must be a multiple of 4 and at least the packed size of the arguments (" << packedStride << " bytes)";
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_Device->createIndirectCommandLayout(desc);
+    }
+
     static void UpdateBindingSummaryWithLocation(IMessageCallback* messageCallback, ResourceType type,
         BindingLocation location, BindingSummary& bindings, BindingLocationSet& duplicates)
     {
@@ -1104,6 +1526,7 @@ namespace nvrhi::validation
 
         int pushConstantCount = 0;
         uint32_t pushConstantSize = 0;
+        int pushDescriptorLayoutCount = 0;
         enum class RegisterSpaceIsDescriptorSet
         {
             False,
@@ -1128,6 +1551,9 @@ namespace nvrhi::validation
                     }
                 }
 
+                if (layoutDesc->usePushDescriptors)
+                    pushDescriptorLayoutCount++;
+
                 if (layoutDesc->registerSpaceIsDescriptorSet)
                 {
                     if (layoutDesc->registerSpace >= c_MaxBindingLayouts)
@@ -1192,6 +1618,15 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (pushDescriptorLayoutCount > 1 && m_Device->getGraphicsAPI() == GraphicsAPI::VULKAN)
+        {
+            std::stringstream errorStream;
+            errorStream << "Pipeline uses more than one (" << pushDescriptorLayoutCount << ") push descriptor layouts, "
+                "which is not supported on Vulkan";
+            error(errorStream.str());
+            anyErrors = true;
+        }
+
         return !anyErrors;
     }
 
@@ -1252,6 +1687,23 @@ namespace nvrhi::validation
         if (!validateRenderState(pipelineDesc.renderState, fbinfo))
             return nullptr;
 
+        if (pipelineDesc.dynamicRenderState != 0)
+        {
+            DynamicRenderStateFeatureInfo featureInfo;
+            if (!m_Device->queryFeatureSupport(Feature::ExtendedDynamicState, &featureInfo, sizeof(featureInfo)))
+                featureInfo.supportedStates = DynamicRenderState::None;
+
+            const DynamicRenderState unsupportedStates = pipelineDesc.dynamicRenderState & ~featureInfo.supportedStates;
+            if (unsupportedStates != 0)
+            {
+                std::stringstream ss;
+                ss << "createGraphicsPipeline: the pipeline requests dynamic render states that are not supported "
+                    "by the device (unsupported state mask = 0x" << std::hex << uint32_t(unsupportedStates) << ")";
+                error(ss.str());
+                return nullptr;
+            }
+        }
+
         return m_Device->createGraphicsPipeline(pipelineDesc, fbinfo);
     }
 
@@ -1326,6 +1778,72 @@ namespace nvrhi::validation
         return m_Device->createRayTracingPipeline(desc);
     }
 
+    nvrhi::rt::PipelineHandle DeviceWrapper::addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions)
+    {
+        if (!pipeline)
+        {
+            error("addToRayTracingPipeline: pipeline is NULL");
+            return nullptr;
+        }
+
+        if (!m_Device->queryFeatureSupport(Feature::RayTracingPipelineLibraries))
+        {
+            error("addToRayTracingPipeline: ray tracing pipeline libraries are not supported by this device");
+            return nullptr;
+        }
+
+        const rt::PipelineDesc& baseDesc = pipeline->getDesc();
+
+        if (!baseDesc.allowAdditions)
+        {
+            error("addToRayTracingPipeline: the pipeline was not created with allowAdditions = true");
+            return nullptr;
+        }
+
+        if (additions.shaders.empty() && additions.hitGroups.empty())
+        {
+            error("addToRayTracingPipeline: the additions do not contain any shaders or hit groups");
+            return nullptr;
+        }
+
+        std::unordered_set<std::string> exportNames;
+        for (const auto& shaderDesc : baseDesc.shaders)
+            exportNames.insert(shaderDesc.exportName.empty() ? shaderDesc.shader->getDesc().entryName : shaderDesc.exportName);
+        for (const auto& hitGroupDesc : baseDesc.hitGroups)
+            exportNames.insert(hitGroupDesc.exportName);
+
+        bool anyErrors = false;
+        auto checkExportName = [this, &exportNames, &anyErrors](const std::string& exportName)
+        {
+            if (!exportNames.insert(exportName).second)
+            {
+                std::stringstream ss;
+                ss << "addToRayTracingPipeline: export '" << exportName << "' already exists in the pipeline or the additions";
+                error(ss.str());
+                anyErrors = true;
+            }
+        };
+
+        for (const auto& shaderDesc : additions.shaders)
+        {
+            if (!shaderDesc.shader)
+            {
+                error("addToRayTracingPipeline: a shader in the additions is NULL");
+                return nullptr;
+            }
+
+            checkExportName(shaderDesc.exportName.empty() ? shaderDesc.shader->getDesc().entryName : shaderDesc.exportName);
+        }
+
+        for (const auto& hitGroupDesc : additions.hitGroups)
+            checkExportName(hitGroupDesc.exportName);
+
+        if (anyErrors)
+            return nullptr;
+
+        return m_Device->addToRayTracingPipeline(pipeline, additions);
+    }
+
     BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
     {
         std::stringstream errorStream;
@@ -1358,11 +1876,15 @@ namespace nvrhi::validation
         uint32_t noneItemCount = 0;
         uint32_t pushConstantCount = 0;
         uint32_t zeroSizeCount = 0;
+        uint32_t pushDescriptorCount = 0;
         for (const BindingLayoutItem& item : desc.bindings)
         {
             if (item.type == ResourceType::None)
                 noneItemCount++;
 
+            if (desc.usePushDescriptors && item.type != ResourceType::PushConstants)
+                pushDescriptorCount += item.size;
+
             if (item.type == ResourceType::PushConstants)
             {
                 if (item.size == 0)
@@ -1416,6 +1938,22 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (desc.usePushDescriptors)
+        {
+            if (bindings.numVolatileCBs > 0)
+            {
+                errorStream << "Push descriptor layouts cannot contain volatile constant buffers" << std::endl;
+                anyErrors = true;
+            }
+
+            if (pushDescriptorCount > c_MaxPushDescriptorsPerLayout)
+            {
+                errorStream << "Push descriptor layout contains too many descriptors (" << pushDescriptorCount
+                    << "), the limit is " << c_MaxPushDescriptorsPerLayout << std::endl;
+                anyErrors = true;
+            }
+        }
+
         const GraphicsAPI graphicsApi = m_Device->getGraphicsAPI();
         
         if (desc.registerSpace != 0 && graphicsApi == GraphicsAPI::VULKAN && !desc.registerSpaceIsDescriptorSet)
@@ -1815,19 +2353,19 @@ namespace nvrhi::validation
         return true;
     }
 
-    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    bool DeviceWrapper::validateBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
     {
         if (layout == nullptr)
         {
             error("Cannot create a binding set without a valid layout");
-            return nullptr;
+            return false;
         }
 
         const BindingLayoutDesc* layoutDesc = layout->getDesc();
         if (!layoutDesc)
         {
             error("Cannot create a binding set from a bindless layout");
-            return nullptr;
+            return false;
         }
 
         std::stringstream errorStream;
@@ -1879,17 +2417,35 @@ namespace nvrhi::validation
         if (anyErrors)
         {
             error(errorStream.str());
-            return nullptr;
+            return false;
         }
 
-        // Unwrap the resources
+        return true;
+    }
+
+    BindingSetDesc DeviceWrapper::unwrapBindingSetDesc(const BindingSetDesc& desc)
+    {
         BindingSetDesc patchedDesc = desc;
         for (auto& binding : patchedDesc.bindings)
         {
             binding.resourceHandle = unwrapResource(binding.resourceHandle);
         }
+        return patchedDesc;
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        if (!layout || !layout->getDesc())
+        {
+            // Report the missing or bindless layout through the regular validation path, regardless of the tier
+            validateBindingSet(desc, layout);
+            return nullptr;
+        }
 
-        return m_Device->createBindingSet(patchedDesc, layout);
+        if (shouldRunDeepChecks(m_DeepCheckCounter) && !validateBindingSet(desc, layout))
+            return nullptr;
+
+        return m_Device->createBindingSet(unwrapBindingSetDesc(desc), layout);
     }
 
     DescriptorTableHandle DeviceWrapper::createDescriptorTable(IBindingLayout* layout)
@@ -1905,6 +2461,7 @@ namespace nvrhi::validation
 
     void DeviceWrapper::resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents)
     {
+        ++m_DescriptorTableGeneration;
         m_Device->resizeDescriptorTable(descriptorTable, newSize, keepContents);
     }
 
@@ -1921,9 +2478,38 @@ namespace nvrhi::validation
         BindingSetItem patchedItem = item;
         patchedItem.resourceHandle = unwrapResource(patchedItem.resourceHandle);
 
+        ++m_DescriptorTableGeneration;
         return m_Device->writeDescriptorTable(descriptorTable, patchedItem);
     }
 
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems)
+    {
+        if (numItems > 0 && !items)
+        {
+            error("writeDescriptorTable: items is NULL");
+            return false;
+        }
+
+        std::stringstream errorStream;
+        std::vector<BindingSetItem> patchedItems;
+        patchedItems.reserve(numItems);
+
+        for (uint32_t index = 0; index < numItems; index++)
+        {
+            if (!validateBindingSetItem(items[index], descriptorTable, errorStream))
+            {
+                error(errorStream.str());
+                return false;
+            }
+
+            BindingSetItem& patchedItem = patchedItems.emplace_back(items[index]);
+            patchedItem.resourceHandle = unwrapResource(patchedItem.resourceHandle);
+        }
+
+        ++m_DescriptorTableGeneration;
+        return m_Device->writeDescriptorTable(descriptorTable, patchedItems.data(), numItems);
+    }
+
     rt::OpacityMicromapHandle DeviceWrapper::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
     {
         if (desc.inputBuffer == nullptr)
@@ -2000,6 +2586,16 @@ namespace nvrhi::validation
         return memReq;
     }
 
+    rt::AccelStructBuildSizes DeviceWrapper::getAccelStructBuildSizes(const rt::AccelStructDesc& desc)
+    {
+        return m_Device->getAccelStructBuildSizes(desc);
+    }
+
+    bool DeviceWrapper::isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header)
+    {
+        return m_Device->isSerializedAccelStructCompatible(header);
+    }
+
     static const char* kOperationTypeStrings[] =
     {
         "Move",
@@ -2280,6 +2876,82 @@ namespace nvrhi::validation
         m_Device->queueWaitForCommandList(waitQueue, executionQueue, instance);
     }
 
+    void DeviceWrapper::executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances)
+    {
+        SubmitGraphDesc unwrappedGraph = graph;
+
+        for (size_t nodeIndex = 0; nodeIndex < unwrappedGraph.nodes.size(); nodeIndex++)
+        {
+            SubmitNode& node = unwrappedGraph.nodes[nodeIndex];
+
+            if (node.queue >= CommandQueue::Count)
+            {
+                std::stringstream ss;
+                ss << "executeSubmitGraph: node " << nodeIndex << " has an invalid queue type";
+                error(ss.str());
+                return;
+            }
+
+            for (uint32_t dependency : node.dependencies)
+            {
+                if (dependency >= nodeIndex)
+                {
+                    std::stringstream ss;
+                    ss << "executeSubmitGraph: node " << nodeIndex << " depends on node " << dependency
+                        << ", only the nodes that come before it can be referenced";
+                    error(ss.str());
+                    return;
+                }
+            }
+
+            for (const TimelinePoint& wait : node.waits)
+            {
+                if (wait.queue >= CommandQueue::Count)
+                {
+                    std::stringstream ss;
+                    ss << "executeSubmitGraph: node " << nodeIndex << " waits for an invalid queue type";
+                    error(ss.str());
+                    return;
+                }
+            }
+
+            for (size_t i = 0; i < node.commandLists.size(); i++)
+            {
+                ICommandList* commandList = node.commandLists[i];
+
+                if (commandList == nullptr)
+                {
+                    std::stringstream ss;
+                    ss << "executeSubmitGraph: node " << nodeIndex << " command list [" << i << "] is NULL";
+                    error(ss.str());
+                    return;
+                }
+
+                const CommandListParameters& desc = commandList->getDesc();
+                if (desc.queueType != node.queue)
+                {
+                    std::stringstream ss;
+                    ss << "executeSubmitGraph: node " << nodeIndex << " command list [" << i << "] type is "
+                        << utils::CommandQueueToString(desc.queueType) << ", it cannot be executed on a "
+                        << utils::CommandQueueToString(node.queue) << " queue";
+                    error(ss.str());
+                    return;
+                }
+
+                CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(commandList);
+                if (wrapper)
+                {
+                    if (!wrapper->requireExecuteState())
+                        return;
+
+                    node.commandLists[i] = wrapper->getUnderlyingCommandList();
+                }
+            }
+        }
+
+        m_Device->executeSubmitGraph(unwrappedGraph, pInstances);
+    }
+
     bool DeviceWrapper::waitForIdle()
     {
         return m_Device->waitForIdle();
@@ -2287,9 +2959,27 @@ namespace nvrhi::validation
 
     void DeviceWrapper::runGarbageCollection()
     {
+        ++m_FrameIndex;
         m_Device->runGarbageCollection();
     }
 
+    bool DeviceWrapper::runIncrementalGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        if (budget.maxMilliseconds < 0.f)
+        {
+            error("runIncrementalGarbageCollection: budget.maxMilliseconds must not be negative");
+            return false;
+        }
+
+        ++m_FrameIndex;
+        return m_Device->runIncrementalGarbageCollection(budget);
+    }
+
+    void DeviceWrapper::setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds)
+    {
+        m_Device->setBackgroundGarbageCollection(enable, intervalMilliseconds);
+    }
+
     bool DeviceWrapper::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
     {
         return m_Device->queryFeatureSupport(feature, pInfo, infoSize);
@@ -2332,6 +3022,11 @@ namespace nvrhi::validation
         return m_MessageCallback;
     }
 
+    void DeviceWrapper::setInstrumentationCallback(IInstrumentationCallback* callback)
+    {
+        m_Device->setInstrumentationCallback(callback);
+    }
+
     bool DeviceWrapper::isAftermathEnabled()
     {
         return m_Device->isAftermathEnabled();
@@ -2342,6 +3037,80 @@ namespace nvrhi::validation
         return m_Device->getAftermathCrashDumpHelper();
     }
 
+    bool DeviceWrapper::getPipelineCacheData(void* data, size_t* dataSize)
+    {
+        if (!dataSize)
+        {
+            error("getPipelineCacheData: dataSize is NULL");
+            return false;
+        }
+
+        return m_Device->getPipelineCacheData(data, dataSize);
+    }
+
+    UploadRingStatistics DeviceWrapper::getUploadRingStatistics(CommandQueue queue)
+    {
+        if (queue >= CommandQueue::Count)
+        {
+            error("getUploadRingStatistics: invalid queue type");
+            return UploadRingStatistics();
+        }
+
+        return m_Device->getUploadRingStatistics(queue);
+    }
+
+    MemoryStatistics DeviceWrapper::getMemoryStatistics()
+    {
+        return m_Device->getMemoryStatistics();
+    }
+
+    void DeviceWrapper::enumerateResourceAllocations(IResourceAllocationCallback& callback)
+    {
+        m_Device->enumerateResourceAllocations(callback);
+    }
+
+    BarrierStatistics DeviceWrapper::getBarrierStatistics(CommandQueue queue)
+    {
+        if (queue >= CommandQueue::Count)
+        {
+            error("getBarrierStatistics: invalid queue type");
+            return BarrierStatistics();
+        }
+
+        return m_Device->getBarrierStatistics(queue);
+    }
+
+    void DeviceWrapper::resetBarrierStatistics()
+    {
+        m_Device->resetBarrierStatistics();
+    }
+
+    CommandListStatistics DeviceWrapper::getCommandListStatistics(CommandQueue queue)
+    {
+        if (queue >= CommandQueue::Count)
+        {
+            error("getCommandListStatistics: invalid queue type");
+            return CommandListStatistics();
+        }
+
+        return m_Device->getCommandListStatistics(queue);
+    }
+
+    void DeviceWrapper::resetCommandListStatistics()
+    {
+        m_Device->resetCommandListStatistics();
+    }
+
+    PipelineCreationStatistics DeviceWrapper::getPipelineCreationStatistics()
+    {
+        return m_Device->getPipelineCreationStatistics();
+    }
+
+    void DeviceWrapper::resetPipelineCreationStatistics()
+    {
+        m_Device->resetPipelineCreationStatistics();
+    }
+
     void Range::add(uint32_t item)
     {
         min = std::min(min, item);
@@ -21,6 +21,7 @@
 */
 
 #include "vulkan-backend.h"
+#include <algorithm>
 
 namespace nvrhi::vulkan
 {
@@ -45,50 +46,238 @@ namespace nvrhi::vulkan
         return flags;
     }
 
-    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress) const
+    static uint64_t alignUp(uint64_t value, uint64_t alignment)
     {
-        // figure out memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getBufferMemoryRequirements(buffer->buffer, &memRequirements);
+        return ((value + alignment - 1) / alignment) * alignment;
+    }
+
+    VulkanAllocator::VulkanAllocator(const VulkanContext& context, uint64_t blockSize)
+        : m_Context(context)
+        , m_BlockSize(blockSize)
+    {
+        // the memory properties never change for a physical device, query them once
+        m_Context.physicalDevice.getMemoryProperties(&m_MemoryProperties);
+    }
+
+    VulkanAllocator::~VulkanAllocator()
+    {
+        for (auto& pool : m_BlockPools)
+        {
+            for (auto& block : pool)
+            {
+                assert(block->usedBytes == 0); // some resources have outlived the device
+                destroyBlock(block.get());
+            }
+            pool.clear();
+        }
+    }
+
+    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress)
+    {
+        // figure out memory requirements, including the driver's opinion on dedicated allocations
+        auto requirementsInfo = vk::BufferMemoryRequirementsInfo2()
+            .setBuffer(buffer->buffer);
+        vk::MemoryDedicatedRequirements dedicatedRequirements;
+        vk::MemoryRequirements2 memRequirements;
+        memRequirements.setPNext(&dedicatedRequirements);
+        m_Context.device.getBufferMemoryRequirements2(&requirementsInfo, &memRequirements);
 
         // allocate memory
         const bool enableMemoryExport = (buffer->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
-        const vk::Result res = allocateMemory(buffer, memRequirements, pickBufferMemoryProperties(buffer->desc), enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
+        const bool preferDedicated = dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation;
+        const vk::Result res = allocateResourceMemory(buffer, memRequirements.memoryRequirements, pickBufferMemoryProperties(buffer->desc),
+            preferDedicated, enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
         CHECK_VK_RETURN(res)
 
-        m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, 0);
+        m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, buffer->memoryOffset);
 
         return vk::Result::eSuccess;
     }
 
-    void VulkanAllocator::freeBufferMemory(Buffer *buffer) const
+    void VulkanAllocator::freeBufferMemory(Buffer *buffer)
     {
         freeMemory(buffer);
     }
 
-    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture) const
+    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture)
     {
         // grab the image memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getImageMemoryRequirements(texture->image, &memRequirements);
+        auto requirementsInfo = vk::ImageMemoryRequirementsInfo2()
+            .setImage(texture->image);
+        vk::MemoryDedicatedRequirements dedicatedRequirements;
+        vk::MemoryRequirements2 memRequirements;
+        memRequirements.setPNext(&dedicatedRequirements);
+        m_Context.device.getImageMemoryRequirements2(&requirementsInfo, &memRequirements);
 
         // allocate memory
         const vk::MemoryPropertyFlags memProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
         const bool enableDeviceAddress = false;
         const bool enableMemoryExport = (texture->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
-        const vk::Result res = allocateMemory(texture, memRequirements, memProperties, enableDeviceAddress, enableMemoryExport, texture->image, nullptr);
+        const bool preferDedicated = dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation;
+        const vk::Result res = allocateResourceMemory(texture, memRequirements.memoryRequirements, memProperties,
+            preferDedicated, enableDeviceAddress, enableMemoryExport, texture->image, nullptr);
         CHECK_VK_RETURN(res)
 
-        m_Context.device.bindImageMemory(texture->image, texture->memory, 0);
+        m_Context.device.bindImageMemory(texture->image, texture->memory, texture->memoryOffset);
 
         return vk::Result::eSuccess;
     }
 
-    void VulkanAllocator::freeTextureMemory(Texture *texture) const
+    void VulkanAllocator::freeTextureMemory(Texture *texture)
     {
         freeMemory(texture);
     }
 
+    bool VulkanAllocator::findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags, uint32_t& outMemTypeIndex) const
+    {
+        for (uint32_t memTypeIndex = 0; memTypeIndex < m_MemoryProperties.memoryTypeCount; memTypeIndex++)
+        {
+            if ((memoryTypeBits & (1 << memTypeIndex)) &&
+                ((m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags & memPropertyFlags) == memPropertyFlags))
+            {
+                outMemTypeIndex = memTypeIndex;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    vk::Result VulkanAllocator::allocateResourceMemory(MemoryResource* res,
+                                                       const vk::MemoryRequirements& memRequirements,
+                                                       vk::MemoryPropertyFlags memPropertyFlags,
+                                                       bool preferDedicated,
+                                                       bool enableDeviceAddress,
+                                                       bool enableExportMemory,
+                                                       VkImage image,
+                                                       VkBuffer buffer)
+    {
+        uint32_t memTypeIndex;
+        if (!findMemoryType(memRequirements.memoryTypeBits, memPropertyFlags, memTypeIndex))
+            return vk::Result::eErrorOutOfDeviceMemory;
+
+        const vk::MemoryPropertyFlags typeFlags = m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags;
+        const vk::DeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memTypeIndex].heapIndex].size;
+
+        // use smaller blocks on small heaps, such as the 256 MB BAR heap, to avoid exhausting them with a single block
+        const uint64_t blockSize = std::min(m_BlockSize, heapSize / 8);
+
+        // exported memory must be dedicated because the handle refers to the whole VkDeviceMemory object,
+        // and large resources don't benefit from sharing a block with anything else
+        const bool useDedicated = blockSize == 0
+            || enableExportMemory
+            || preferDedicated
+            || memRequirements.size > blockSize / 2;
+
+        if (useDedicated)
+        {
+            return allocateMemory(res, memRequirements, memPropertyFlags, enableDeviceAddress, enableExportMemory, image, buffer);
+        }
+
+        // non-coherent host memory is flushed in nonCoherentAtomSize units, so keep resources from sharing atoms
+        uint64_t alignment = std::max<uint64_t>(memRequirements.alignment, 1);
+        uint64_t size = memRequirements.size;
+        const bool hostVisible = (typeFlags & vk::MemoryPropertyFlagBits::eHostVisible) != vk::MemoryPropertyFlags(0);
+        if (hostVisible)
+        {
+            const uint64_t atomSize = m_Context.physicalDeviceProperties.limits.nonCoherentAtomSize;
+            alignment = std::max(alignment, atomSize);
+            size = alignUp(size, atomSize);
+        }
+
+        const uint32_t poolIndex = memTypeIndex * 2 + (image ? 1 : 0);
+        res->hostCoherent = (typeFlags & vk::MemoryPropertyFlagBits::eHostCoherent) != vk::MemoryPropertyFlags(0);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (suballocate(res, poolIndex, size, alignment))
+            return vk::Result::eSuccess;
+
+        // no space in the existing blocks, create a new one
+        auto block = std::make_unique<MemoryBlock>();
+        block->size = blockSize;
+        block->poolIndex = poolIndex;
+
+        auto allocFlags = vk::MemoryAllocateFlagsInfo();
+        if (!image && m_Context.extensions.buffer_device_address)
+        {
+            // the block can hold any buffer, some of which will need the device address
+            allocFlags.flags |= vk::MemoryAllocateFlagBits::eDeviceAddress;
+        }
+
+        auto allocInfo = vk::MemoryAllocateInfo()
+            .setAllocationSize(blockSize)
+            .setMemoryTypeIndex(memTypeIndex)
+            .setPNext(&allocFlags);
+
+        vk::Result result = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &block->memory);
+        if (result != vk::Result::eSuccess)
+        {
+            // the heap might not have enough space for a whole block, try a dedicated allocation instead
+            return allocateMemory(res, memRequirements, memPropertyFlags, enableDeviceAddress, enableExportMemory, image, buffer);
+        }
+
+        if (hostVisible)
+        {
+            result = m_Context.device.mapMemory(block->memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), &block->mappedMemory);
+            if (result != vk::Result::eSuccess)
+            {
+                destroyBlock(block.get());
+                return result;
+            }
+        }
+
+        block->freeRanges[0] = blockSize;
+        m_BlockPools[poolIndex].push_back(std::move(block));
+
+        [[maybe_unused]] const bool success = suballocate(res, poolIndex, size, alignment);
+        assert(success);
+
+        return vk::Result::eSuccess;
+    }
+
+    bool VulkanAllocator::suballocate(MemoryResource* res, uint32_t poolIndex, uint64_t size, uint64_t alignment)
+    {
+        for (auto& block : m_BlockPools[poolIndex])
+        {
+            if (block->size - block->usedBytes < size)
+                continue;
+
+            // first fit
+            for (auto it = block->freeRanges.begin(); it != block->freeRanges.end(); ++it)
+            {
+                const uint64_t rangeOffset = it->first;
+                const uint64_t rangeSize = it->second;
+                const uint64_t alignedOffset = alignUp(rangeOffset, alignment);
+
+                if (alignedOffset + size > rangeOffset + rangeSize)
+                    continue;
+
+                block->freeRanges.erase(it);
+
+                // return the alignment padding and the tail to the free list
+                if (alignedOffset > rangeOffset)
+                    block->freeRanges[rangeOffset] = alignedOffset - rangeOffset;
+
+                const uint64_t tailOffset = alignedOffset + size;
+                if (tailOffset < rangeOffset + rangeSize)
+                    block->freeRanges[tailOffset] = rangeOffset + rangeSize - tailOffset;
+
+                block->usedBytes += size;
+
+                res->managed = true;
+                res->memory = block->memory;
+                res->memoryBlock = block.get();
+                res->memoryOffset = alignedOffset;
+                res->memorySize = size;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     vk::Result VulkanAllocator::allocateMemory(MemoryResource *res,
                                                vk::MemoryRequirements memRequirements,
                                                vk::MemoryPropertyFlags memPropertyFlags,
@@ -98,27 +287,20 @@ namespace nvrhi::vulkan
                                                 VkBuffer dedicatedBuffer) const
     {
         res->managed = true;
+        res->memoryBlock = nullptr;
+        res->memoryOffset = 0;
+        res->memorySize = memRequirements.size;
 
         // find a memory space that satisfies the requirements
-        vk::PhysicalDeviceMemoryProperties memProperties;
-        m_Context.physicalDevice.getMemoryProperties(&memProperties);
-
         uint32_t memTypeIndex;
-        for(memTypeIndex = 0; memTypeIndex < memProperties.memoryTypeCount; memTypeIndex++)
-        {
-            if ((memRequirements.memoryTypeBits & (1 << memTypeIndex)) &&
-                ((memProperties.memoryTypes[memTypeIndex].propertyFlags & memPropertyFlags) == memPropertyFlags))
-            {
-                break;
-            }
-        }
-
-        if (memTypeIndex == memProperties.memoryTypeCount)
+        if (!findMemoryType(memRequirements.memoryTypeBits, memPropertyFlags, memTypeIndex))
         {
             // xxxnsubtil: this is incorrect; need better error reporting
             return vk::Result::eErrorOutOfDeviceMemory;
         }
 
+        res->hostCoherent = (m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent) != vk::MemoryPropertyFlags(0);
+
         // allocate memory
         auto allocFlags = vk::MemoryAllocateFlagsInfo();
         if (enableDeviceAddress)
@@ -159,12 +341,142 @@ namespace nvrhi::vulkan
         return m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
     }
 
-    void VulkanAllocator::freeMemory(MemoryResource *res) const
+    vk::Result VulkanAllocator::importHostMemory(MemoryResource* res,
+                                                 void* hostMemory,
+                                                 vk::MemoryRequirements memRequirements,
+                                                 bool enableDeviceAddress) const
+    {
+        res->managed = true;
+        res->memoryBlock = nullptr;
+        res->memoryOffset = 0;
+        res->memorySize = memRequirements.size;
+
+        // the host allocation limits the memory types further than the buffer does
+        vk::MemoryHostPointerPropertiesEXT hostPointerProperties;
+        vk::Result result = m_Context.device.getMemoryHostPointerPropertiesEXT(
+            vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT, hostMemory, &hostPointerProperties);
+        if (result != vk::Result::eSuccess)
+            return result;
+
+        const uint32_t memoryTypeBits = memRequirements.memoryTypeBits & hostPointerProperties.memoryTypeBits;
+
+        // prefer a host-visible type so that the buffer can also be mapped
+        uint32_t memTypeIndex;
+        if (!findMemoryType(memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible, memTypeIndex) &&
+            !findMemoryType(memoryTypeBits, vk::MemoryPropertyFlags(), memTypeIndex))
+        {
+            return vk::Result::eErrorInvalidExternalHandle;
+        }
+
+        res->hostCoherent = (m_MemoryProperties.memoryTypes[memTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent) != vk::MemoryPropertyFlags(0);
+
+        auto allocFlags = vk::MemoryAllocateFlagsInfo();
+        if (enableDeviceAddress)
+            allocFlags.flags |= vk::MemoryAllocateFlagBits::eDeviceAddress;
+
+        auto importInfo = vk::ImportMemoryHostPointerInfoEXT()
+            .setHandleType(vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT)
+            .setPHostPointer(hostMemory)
+            .setPNext(&allocFlags);
+
+        auto allocInfo = vk::MemoryAllocateInfo()
+            .setAllocationSize(memRequirements.size)
+            .setMemoryTypeIndex(memTypeIndex)
+            .setPNext(&importInfo);
+
+        return m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
+    }
+
+    void VulkanAllocator::freeMemory(MemoryResource *res)
     {
         assert(res->managed);
 
-        m_Context.device.freeMemory(res->memory, m_Context.allocationCallbacks);
+        MemoryBlock* block = res->memoryBlock;
+        if (!block)
+        {
+            m_Context.device.freeMemory(res->memory, m_Context.allocationCallbacks);
+            res->memory = vk::DeviceMemory(nullptr);
+            return;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint64_t offset = res->memoryOffset;
+        uint64_t size = res->memorySize;
+
+        // merge with the following free range
+        auto next = block->freeRanges.lower_bound(offset);
+        if (next != block->freeRanges.end() && next->first == offset + size)
+        {
+            size += next->second;
+            next = block->freeRanges.erase(next);
+        }
+
+        // merge with the preceding free range
+        if (next != block->freeRanges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                offset = prev->first;
+                size += prev->second;
+                block->freeRanges.erase(prev);
+            }
+        }
+
+        block->freeRanges[offset] = size;
+        block->usedBytes -= res->memorySize;
+
         res->memory = vk::DeviceMemory(nullptr);
+        res->memoryBlock = nullptr;
+        res->memoryOffset = 0;
+        res->memorySize = 0;
+
+        // release empty blocks, but keep the last one in the pool to avoid thrashing on create/destroy patterns
+        auto& pool = m_BlockPools[block->poolIndex];
+        if (block->usedBytes == 0 && pool.size() > 1)
+        {
+            destroyBlock(block);
+            pool.erase(std::find_if(pool.begin(), pool.end(),
+                [block](const std::unique_ptr<MemoryBlock>& item) { return item.get() == block; }));
+        }
+    }
+
+    void* VulkanAllocator::mapMemory(MemoryResource* res, uint64_t offset, uint64_t size) const
+    {
+        if (res->memoryBlock)
+        {
+            assert(res->memoryBlock->mappedMemory);
+            return static_cast<char*>(res->memoryBlock->mappedMemory) + res->memoryOffset + offset;
+        }
+
+        void* ptr = nullptr;
+        [[maybe_unused]] const vk::Result result = m_Context.device.mapMemory(res->memory, offset, size, vk::MemoryMapFlags(), &ptr);
+        assert(result == vk::Result::eSuccess);
+
+        return ptr;
+    }
+
+    void VulkanAllocator::unmapMemory(MemoryResource* res) const
+    {
+        // sub-allocated resources use the persistent mapping of their block
+        if (!res->memoryBlock)
+            m_Context.device.unmapMemory(res->memory);
+    }
+
+    void VulkanAllocator::destroyBlock(MemoryBlock* block) const
+    {
+        if (block->mappedMemory)
+        {
+            m_Context.device.unmapMemory(block->memory);
+            block->mappedMemory = nullptr;
+        }
+
+        if (block->memory)
+        {
+            m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+            block->memory = vk::DeviceMemory();
+        }
     }
 
 } // namespace nvrhi::vulkan
@@ -26,9 +26,22 @@
 #include <nvrhi/utils.h>
 #include <nvrhi/common/aftermath.h>
 #include "../common/state-tracking.h"
+#include "../common/command-list-statistics.h"
+#include "../common/instrumentation.h"
+#include "../common/intern-table.h"
+#include "../common/memory-statistics.h"
+#include "../common/pipeline-compile-pool.h"
+#include "../common/pipeline-statistics.h"
+#include "../common/shader-cache.h"
 #include "../common/versioning.h"
+#include "../common/submit-graph.h"
+#include "../common/garbage-collection.h"
+#include "../common/accel-struct-storage.h"
+#include <atomic>
 #include <mutex>
 #include <list>
+#include <utility>
+#include <map>
 
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include <vulkan/vulkan.hpp>
@@ -115,6 +128,26 @@ namespace nvrhi::vulkan
         std::vector<uint64_t> asBuildsCompleted;
         std::mutex asListMutex;
     };
+#else
+    constexpr uint32_t c_MaxCompactedSizeQueries = 4096; // BLAS builds with AllowCompaction that can be in flight at once
+    constexpr uint32_t c_MaxSerializationSizeQueries = 1024;
+    constexpr uint64_t c_CompactedAccelStructChunkSize = 32 * 1024 * 1024;
+
+    // Native BLAS compaction: post-build compacted sizes are written into a query pool and read when
+    // the command buffer is retired, then compactBottomLevelAccelStructs() copies the BLASes into pooled storage.
+    struct AccelStructCompactionResources
+    {
+        std::mutex mutex;
+        vk::QueryPool compactedSizeQueryPool;
+        utils::BitSetAllocator compactedSizeQueries{ c_MaxCompactedSizeQueries, true };
+        std::vector<rt::AccelStructHandle> compactionsReady; // BLASes with known compacted sizes
+        std::unique_ptr<AccelStructStoragePool> compactedStorage;
+
+        // Used by writeAccelStructSerializedSize(...), the results are copied into buffers on the GPU
+        // and the queries are released when the command buffer is retired
+        vk::QueryPool serializationSizeQueryPool;
+        utils::BitSetAllocator serializationSizeQueries{ c_MaxSerializationSizeQueries, true };
+    };
 #endif
 
     // underlying vulkan context
@@ -144,6 +177,7 @@ namespace nvrhi::vulkan
             bool buffer_device_address = false; // either KHR_ or Vulkan 1.2 versions
             bool KHR_ray_query = false;
             bool KHR_ray_tracing_pipeline = false;
+            bool KHR_pipeline_library = false;
             bool EXT_mesh_shader = false;
             bool KHR_fragment_shading_rate = false;
             bool EXT_conservative_rasterization = false;
@@ -154,6 +188,13 @@ namespace nvrhi::vulkan
             bool EXT_debug_utils = false;
             bool NV_cooperative_vector = false;
             bool NV_ray_tracing_linear_swept_spheres = false;
+            bool EXT_memory_budget = false;
+            bool EXT_external_memory_host = false;
+            bool EXT_device_generated_commands = false;
+            bool KHR_push_descriptor = false;
+            bool EXT_conditional_rendering = false;
+            bool EXT_pipeline_creation_feedback = false;
+            bool EXT_multi_draw = false;
 #if NVRHI_WITH_AFTERMATH
             bool NV_device_diagnostic_checkpoints = false;
             bool NV_device_diagnostics_config= false;
@@ -173,11 +214,18 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceCooperativeVectorPropertiesNV coopVecProperties;
         vk::PhysicalDeviceRayTracingLinearSweptSpheresFeaturesNV linearSweptSpheresFeatures;
         vk::PhysicalDeviceSubgroupProperties subgroupProperties;
+        vk::PhysicalDeviceExternalMemoryHostPropertiesEXT externalMemoryHostProperties;
+        vk::PhysicalDeviceMultiDrawPropertiesEXT multiDrawProperties;
         IMessageCallback* messageCallback = nullptr;
+        InstrumentationHook instrumentation;
+        mutable MemoryCounters memoryCounters;
+        PipelineCreationCounters pipelineCounters;
         bool logBufferLifetime = false;
 #ifdef NVRHI_WITH_RTXMU
         std::unique_ptr<rtxmu::VkAccelStructManager> rtxMemUtil;
         std::unique_ptr<RtxMuResources> rtxMuResources;
+#else
+        std::unique_ptr<AccelStructCompactionResources> accelStructCompaction;
 #endif
         vk::DescriptorSetLayout emptyDescriptorSetLayout;
 
@@ -200,12 +248,28 @@ namespace nvrhi::vulkan
         std::vector<RefCountPtr<IResource>> referencedResources; // to keep them alive
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers; // to allow synchronous mapBuffer
 
+        // Preprocess memory for vkCmdExecuteGeneratedCommandsEXT, sub-allocated linearly and reused after reset()
+        RefCountPtr<Buffer> preprocessBuffer;
+        uint64_t preprocessOffset = 0;
+
         uint64_t recordingID = 0;
         uint64_t submissionID = 0;
 
+        // Set by Queue::retireCommandBuffers after the command buffer and its pool were reset, which hands the
+        // command buffer back to the command list that owns it. The command list never touches it while in flight.
+        std::atomic<bool> retired = false;
+
 #ifdef NVRHI_WITH_RTXMU
         std::vector<uint64_t> rtxmuBuildIds;
         std::vector<uint64_t> rtxmuCompactionIds;
+#else
+        struct CompactedSizeQuery
+        {
+            rt::AccelStructHandle accelStruct;
+            int index = -1;
+        };
+        std::vector<CompactedSizeQuery> compactedSizeQueries;
+        std::vector<int> serializationSizeQueries;
 #endif
 
         explicit TrackedCommandBuffer(const VulkanContext& context)
@@ -213,14 +277,57 @@ namespace nvrhi::vulkan
         { }
 
         ~TrackedCommandBuffer();
+
+        // Releases the resources referenced by the previous recording and resets the command pool
+        void reset();
+
+#ifndef NVRHI_WITH_RTXMU
+        // Returns the AS property query slots of a recording that will never be submitted, without reading them
+        void releaseAccelStructQueries();
+#endif
+
+        // Allocates a descriptor set for a transient binding set from the pools owned by this command buffer.
+        // The sets are never freed individually, all pools are reset when the command buffer is retired.
+        vk::Result allocateTransientDescriptorSet(vk::DescriptorSetLayout layout, vk::DescriptorPool& outPool, vk::DescriptorSet& outSet);
+        void resetTransientDescriptorPools();
+
+        // Returns an unsignaled event for a split barrier. The command list resets the event in this command buffer
+        // after waiting on it, so the events can be reused once the command buffer is retired.
+        vk::Event acquireSplitBarrierEvent();
+        void releaseSplitBarrierEvents() { m_NumActiveSplitBarrierEvents = 0; }
     
     private:
         const VulkanContext& m_Context;
+
+        static constexpr uint32_t c_TransientDescriptorPoolSets = 256;
+        static constexpr uint32_t c_TransientDescriptorPoolDescriptors = 1024;
+
+        std::vector<vk::DescriptorPool> m_TransientDescriptorPools;
+        size_t m_NumActiveTransientDescriptorPools = 0;
+
+        std::vector<vk::Event> m_SplitBarrierEvents;
+        size_t m_NumActiveSplitBarrierEvents = 0;
+
+        vk::Result activateTransientDescriptorPool();
     };
 
     typedef std::shared_ptr<TrackedCommandBuffer> TrackedCommandBufferPtr;
 
     // represents a hardware queue
+    // One VkSubmitInfo in Queue::submitBatches(...)
+    struct QueueSubmitBatch
+    {
+        ICommandList* const* commandLists = nullptr;
+        size_t numCommandLists = 0;
+
+        // timeline semaphores of other queues and the values to wait for
+        std::vector<vk::Semaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+
+        // obtained from Queue::reserveSubmissionID(), the tracking semaphore is signaled with it
+        uint64_t submissionID = 0;
+    };
+
     class Queue
     {
     public:
@@ -232,7 +339,9 @@ namespace nvrhi::vulkan
         // creates a command buffer and its synchronization resources
         TrackedCommandBufferPtr createCommandBuffer();
 
-        TrackedCommandBufferPtr getOrCreateCommandBuffer();
+        // Returns a retired command buffer from the pool, or creates a new one and adds it to the pool.
+        // The pool belongs to one command list, so this doesn't take any locks.
+        TrackedCommandBufferPtr getOrCreateCommandBuffer(std::vector<TrackedCommandBufferPtr>& pool);
 
         void addWaitSemaphore(vk::Semaphore semaphore, uint64_t value);
         void addSignalSemaphore(vk::Semaphore semaphore, uint64_t value);
@@ -240,17 +349,29 @@ namespace nvrhi::vulkan
         // submits a command buffer to this queue, returns submissionID
         uint64_t submit(ICommandList* const* ppCmd, size_t numCmd);
 
-        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings);
+        // Allocates the submission ID for a batch before it is submitted, so that the batches of other queues
+        // can wait for it. Every reserved ID must be submitted with submitBatches(...) before the next submit.
+        uint64_t reserveSubmissionID() { return ++m_LastSubmittedID; }
+
+        // Submits multiple batches with one vkQueueSubmit call. The semaphores added with addWaitSemaphore(...)
+        // and addSignalSemaphore(...) apply to the first and the last batch, respectively.
+        void submitBatches(const QueueSubmitBatch* batches, size_t numBatches);
+
+        // Binds the tiles of all textures in the batch with one vkQueueBindSparse call
+        void updateTextureTileMappings(const TextureTilesMappingUpdate* updates, uint32_t numUpdates);
 
-        // retire any command buffers that have finished execution from the pending execution list
-        void retireCommandBuffers();
+        // Retires the command buffers that have finished execution from the pending execution list,
+        // until the budget is used up if one is given. Returns true if all finished command buffers were retired.
+        // Can be called from the background garbage collector while other threads submit to the queue.
+        bool retireCommandBuffers(GarbageCollectionBudgetTracker* budget = nullptr);
 
         TrackedCommandBufferPtr getCommandBufferInFlight(uint64_t submissionID);
 
         uint64_t updateLastFinishedID();
         uint64_t getLastSubmittedID() const { return m_LastSubmittedID; }
-        uint64_t getLastFinishedID() const { return m_LastFinishedID; }
+        uint64_t getLastFinishedID() const { return m_LastFinishedID.load(std::memory_order_relaxed); }
         CommandQueue getQueueID() const { return m_QueueID; }
+        uint32_t getQueueFamilyIndex() const { return m_QueueFamilyIndex; }
         vk::Queue getVkQueue() const { return m_Queue; }
 
         bool pollCommandList(uint64_t commandListID);
@@ -263,19 +384,34 @@ namespace nvrhi::vulkan
         CommandQueue m_QueueID;
         uint32_t m_QueueFamilyIndex = uint32_t(-1);
 
-        std::mutex m_Mutex;
         std::vector<vk::Semaphore> m_WaitSemaphores;
         std::vector<uint64_t> m_WaitSemaphoreValues;
         std::vector<vk::Semaphore> m_SignalSemaphores;
         std::vector<uint64_t> m_SignalSemaphoreValues;
 
-        uint64_t m_LastRecordingID = 0;
+        std::atomic<uint64_t> m_LastRecordingID = 0;
         uint64_t m_LastSubmittedID = 0;
-        uint64_t m_LastFinishedID = 0;
+        std::atomic<uint64_t> m_LastFinishedID = 0;
 
         // tracks the list of command buffers in flight on this queue
         std::list<TrackedCommandBufferPtr> m_CommandBuffersInFlight;
-        std::list<TrackedCommandBufferPtr> m_CommandBuffersPool;
+        std::mutex m_InFlightMutex; // the background garbage collector retires the command buffers on its own thread
+    };
+
+    // a large VkDeviceMemory allocation that multiple resources are placed into
+    struct MemoryBlock
+    {
+        vk::DeviceMemory memory;
+        uint64_t size = 0;
+        uint64_t usedBytes = 0;
+        uint32_t poolIndex = 0;
+
+        // host-visible blocks stay mapped for their entire lifetime because
+        // vkMapMemory cannot be called on the same memory object more than once
+        void* mappedMemory = nullptr;
+
+        // free ranges of the block, offset -> size, adjacent ranges are always merged
+        std::map<uint64_t, uint64_t> freeRanges;
     };
 
     class MemoryResource
@@ -283,21 +419,33 @@ namespace nvrhi::vulkan
     public:
         bool managed = true;
         vk::DeviceMemory memory;
+
+        // placement of the resource in 'memory' when it's sub-allocated from a block,
+        // memoryBlock is nullptr for dedicated allocations
+        MemoryBlock* memoryBlock = nullptr;
+        uint64_t memoryOffset = 0;
+        uint64_t memorySize = 0;
+
+        // host-visible memory without eHostCoherent needs explicit flushes and invalidations
+        bool hostCoherent = false;
+
+        // memory statistics entry of the resource, set when the resource allocates memory on its own
+        TrackedMemory trackedMemory;
     };
 
     class VulkanAllocator
     {
     public:
-        explicit VulkanAllocator(const VulkanContext& context)
-            : m_Context(context)
-        { }
+        VulkanAllocator(const VulkanContext& context, uint64_t blockSize);
+        ~VulkanAllocator();
 
-        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false) const;
-        void freeBufferMemory(Buffer* buffer) const;
+        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false);
+        void freeBufferMemory(Buffer* buffer);
 
-        vk::Result allocateTextureMemory(Texture* texture) const;
-        void freeTextureMemory(Texture* texture) const;
+        vk::Result allocateTextureMemory(Texture* texture);
+        void freeTextureMemory(Texture* texture);
 
+        // always creates a separate VkDeviceMemory object
         vk::Result allocateMemory(MemoryResource* res,
             vk::MemoryRequirements memRequirements,
             vk::MemoryPropertyFlags memPropertyFlags,
@@ -305,10 +453,34 @@ namespace nvrhi::vulkan
             bool enableExportMemory = false,
             VkImage dedicatedImage = nullptr,
             VkBuffer dedicatedBuffer = nullptr) const;
-        void freeMemory(MemoryResource* res) const;
+        void freeMemory(MemoryResource* res);
+
+        // creates a memory object that aliases application-owned host memory, using VK_EXT_external_memory_host
+        vk::Result importHostMemory(MemoryResource* res,
+            void* hostMemory,
+            vk::MemoryRequirements memRequirements,
+            bool enableDeviceAddress) const;
+
+        // maps a host-visible resource; sub-allocated resources return a pointer into the persistent block mapping
+        void* mapMemory(MemoryResource* res, uint64_t offset, uint64_t size) const;
+        void unmapMemory(MemoryResource* res) const;
 
     private:
         const VulkanContext& m_Context;
+        vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+        uint64_t m_BlockSize;
+
+        // buffers and images go into separate pools to avoid dealing with bufferImageGranularity
+        static constexpr uint32_t c_NumBlockPools = VK_MAX_MEMORY_TYPES * 2;
+        std::vector<std::unique_ptr<MemoryBlock>> m_BlockPools[c_NumBlockPools];
+        std::mutex m_Mutex;
+
+        bool findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags, uint32_t& outMemTypeIndex) const;
+        vk::Result allocateResourceMemory(MemoryResource* res, const vk::MemoryRequirements& memRequirements,
+            vk::MemoryPropertyFlags memPropertyFlags, bool preferDedicated, bool enableDeviceAddress,
+            bool enableExportMemory, VkImage image, VkBuffer buffer);
+        bool suballocate(MemoryResource* res, uint32_t poolIndex, uint64_t size, uint64_t alignment);
+        void destroyBlock(MemoryBlock* block) const;
     };
 
     class Heap : public MemoryResource, public RefCounter<IHeap>
@@ -493,8 +665,15 @@ namespace nvrhi::vulkan
     to the available state (tracking word == 0) if their command list is abandoned,
     but that is currently not implemented.
 
+    When DeviceDesc::volatileConstantRingSize is nonzero, none of the above is used.
+    The descriptors of all volatile buffers point at one device-wide UploadRing instead,
+    and each write takes the next range of a ring chunk claimed by the command list.
+    There is no per-buffer version limit and no per-write search; the chunks are
+    returned to the ring on submission and reused when their command list has finished.
+
     See also:
         - CommandList::writeVolatileBuffer
+        - CommandList::writeVolatileBufferToRing
         - CommandList::flushVolatileBufferWrites
         - CommandList::submitVolatileBuffers
 
@@ -502,6 +681,7 @@ namespace nvrhi::vulkan
 
     struct VolatileBufferState
     {
+        uint64_t latestOffset = 0; // dynamic offset of the latest write, in the buffer or in the volatile constant ring
         int latestVersion = 0;
         int minVersion = 0;
         int maxVersion = 0;
@@ -539,8 +719,10 @@ namespace nvrhi::vulkan
         HeapHandle heap;
         
         std::unordered_map<uint64_t, vk::BufferView> viewCache;
+        std::mutex viewCacheMutex; // binding sets and descriptor tables can be written from multiple threads
 
         std::vector<BufferVersionItem> versionTracking;
+        LastRecordingReference lastRecordingReference;
         void* mappedMemory = nullptr;
         void* sharedHandle = nullptr;
         uint32_t versionSearchStart = 0;
@@ -601,6 +783,7 @@ namespace nvrhi::vulkan
 
         vk::SamplerCreateInfo samplerInfo;
         vk::Sampler sampler;
+        StateObjectTables::SamplerTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
 
         explicit Sampler(const VulkanContext& context)
             : m_Context(context)
@@ -663,6 +846,7 @@ namespace nvrhi::vulkan
 
         std::vector<vk::VertexInputBindingDescription> bindingDesc;
         std::vector<vk::VertexInputAttributeDescription> attributeDesc;
+        StateObjectTables::InputLayoutTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
         
         uint32_t getNumAttributes() const override;
         const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
@@ -695,6 +879,43 @@ namespace nvrhi::vulkan
         utils::BitSetAllocator& m_QueryAllocator;
     };
 
+    class TimestampQueryPool : public RefCounter<ITimestampQueryPool>
+    {
+    public:
+        TimestampQueryPoolDesc desc;
+        vk::QueryPool queryPool;
+        BufferHandle resolveBuffer;
+
+        explicit TimestampQueryPool(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~TimestampQueryPool() override;
+
+        const TimestampQueryPoolDesc& getDesc() const override { return desc; }
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
+    class QueryPool : public RefCounter<IQueryPool>
+    {
+    public:
+        QueryPoolDesc desc;
+        vk::QueryPool queryPool;
+
+        explicit QueryPool(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~QueryPool() override;
+
+        const QueryPoolDesc& getDesc() const override { return desc; }
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
     class Framebuffer : public RefCounter<IFramebuffer>
     {
     public:
@@ -707,6 +928,7 @@ namespace nvrhi::vulkan
         vk::RenderingFragmentShadingRateAttachmentInfoKHR shadingRateAttachment{};
 
         std::vector<ResourceHandle> resources;
+        LastRecordingReference lastRecordingReference;
 
         bool managed = true;
 
@@ -720,6 +942,11 @@ namespace nvrhi::vulkan
         BindingLayoutDesc desc;
         BindlessLayoutDesc bindlessDesc;
         bool isBindless;
+        StateObjectTables::BindingLayoutTable::Entry internEntry; // see DeviceDesc::enableStateObjectInterning
+
+        // true when the layout was created with usePushDescriptors and the device supports push descriptors,
+        // in which case binding sets don't allocate descriptor sets and are pushed into the command buffer instead
+        bool pushDescriptors = false;
 
         std::vector<vk::DescriptorSetLayoutBinding> vulkanLayoutBindings;
 
@@ -738,8 +965,24 @@ namespace nvrhi::vulkan
         // generate the descriptor set layout
         vk::Result bake();
 
+        // Allocates a descriptor set for a binding set with this layout from the shared pools of the layout.
+        // Released sets are reused by later allocations without going back to the pool.
+        vk::Result allocateDescriptorSet(vk::DescriptorPool& outPool, vk::DescriptorSet& outSet);
+        void releaseDescriptorSet(vk::DescriptorPool pool, vk::DescriptorSet set);
+
     private:
         const VulkanContext& m_Context;
+
+        // the pools grow geometrically, starting from a few sets, up to c_MaxDescriptorPoolSets
+        static constexpr uint32_t c_MinDescriptorPoolSets = 8;
+        static constexpr uint32_t c_MaxDescriptorPoolSets = 1024;
+
+        std::mutex m_DescriptorPoolMutex;
+        std::vector<vk::DescriptorPool> m_DescriptorPools;
+        uint32_t m_NextDescriptorPoolSets = c_MinDescriptorPoolSets;
+        std::vector<std::pair<vk::DescriptorPool, vk::DescriptorSet>> m_FreeDescriptorSets;
+
+        vk::Result createDescriptorPool();
     };
 
     // contains a vk::DescriptorSet
@@ -749,15 +992,29 @@ namespace nvrhi::vulkan
         BindingSetDesc desc;
         BindingLayoutHandle layout;
 
-        // TODO: move pool to the context instead
+        // the pool is shared with other binding sets of the same layout and owned by the layout
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
 
         std::vector<ResourceHandle> resources;
         static_vector<Buffer*, c_MaxVolatileConstantBuffersPerLayout> volatileConstantBuffers;
 
+        // descriptor writes for binding sets with push layouts, replayed by bindBindingSets with pushDescriptorSetKHR
+        std::vector<vk::DescriptorImageInfo> pushDescriptorImageInfo;
+        std::vector<vk::DescriptorBufferInfo> pushDescriptorBufferInfo;
+        std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> pushAccelStructWriteInfo;
+        std::vector<vk::WriteDescriptorSet> pushDescriptorWriteInfo;
+
         std::vector<uint16_t> bindingsThatNeedTransitions;
         bool hasUavBindings = false;
+        LastRecordingReference lastRecordingReference;
+
+        // The states required by bindingsThatNeedTransitions, built once by writeBindingSetDescriptors
+        std::vector<RequiredResourceState> requiredStates;
+        void buildRequiredStates();
+
+        // transient binding sets get their descriptor set from the pools of a command buffer, see createTransientBindingSet
+        bool transient = false;
 
         explicit BindingSet(const VulkanContext& context)
             : m_Context(context)
@@ -781,6 +1038,8 @@ namespace nvrhi::vulkan
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
 
+        std::mutex writeMutex; // serializes the descriptor set updates from writeDescriptorTable
+
         explicit DescriptorTable(const VulkanContext& context)
             : m_Context(context)
         { }
@@ -798,6 +1057,63 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
+    class CommandBundle : public RefCounter<ICommandBundle>
+    {
+    public:
+        CommandBundleDesc desc;
+
+        // The states of the resources used by all draws, applied by CommandList::executeBundle
+        std::vector<RequiredResourceState> requiredStates;
+        bool hasUavBindings = false;
+
+        // GraphicsState holds raw pointers, so the bundle keeps the objects used by its draws alive
+        std::vector<RefCountPtr<IResource>> referencedResources;
+
+        // secondary command buffer that was recorded with eSimultaneousUse
+        vk::CommandPool cmdPool;
+        vk::CommandBuffer cmdBuf;
+
+        explicit CommandBundle(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~CommandBundle() override;
+
+        void buildRequiredStates();
+        void record();
+
+        const CommandBundleDesc& getDesc() const override { return desc; }
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
+    class IndirectCommandLayout : public RefCounter<IIndirectCommandLayout>
+    {
+    public:
+        IndirectCommandLayoutDesc desc;
+        uint32_t byteStride = 0;
+        vk::IndirectCommandsLayoutEXT layout;
+        vk::ShaderStageFlags shaderStages;
+
+        // The desc holds a raw pointer, keep the pipeline alive while the layout exists
+        RefCountPtr<IResource> pipeline;
+        LastRecordingReference lastRecordingReference;
+
+        explicit IndirectCommandLayout(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~IndirectCommandLayout() override;
+
+        const IndirectCommandLayoutDesc& getDesc() const override { return desc; }
+        uint32_t getByteStride() const override { return byteStride; }
+        Object getNativeObject(ObjectType objectType) override;
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
     template <typename T>
     using BindingVector = static_vector<T, c_MaxBindingLayouts>;
 
@@ -810,6 +1126,41 @@ namespace nvrhi::vulkan
         VulkanContext const& context,
         BindingLayoutVector const& inBindingLayouts);
 
+    // Requests VK_EXT_pipeline_creation_feedback for one pipeline creation and translates the result into
+    // a PipelineCacheResult. The object must outlive the create call, and chain() must be the last change
+    // to the pNext of the create info because it prepends the feedback structure.
+    class PipelineCreationFeedback
+    {
+    public:
+        template<typename CreateInfo>
+        void chain(VulkanContext const& context, CreateInfo& createInfo)
+        {
+            if (!context.extensions.EXT_pipeline_creation_feedback)
+                return;
+
+            m_CreateInfo = vk::PipelineCreationFeedbackCreateInfo()
+                .setPPipelineCreationFeedback(&m_Feedback)
+                .setPNext(createInfo.pNext);
+            createInfo.setPNext(&m_CreateInfo);
+            m_Chained = true;
+        }
+
+        [[nodiscard]] PipelineCacheResult getCacheResult() const
+        {
+            if (!m_Chained || !(m_Feedback.flags & vk::PipelineCreationFeedbackFlagBits::eValid))
+                return PipelineCacheResult::Unknown;
+
+            return (m_Feedback.flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit)
+                ? PipelineCacheResult::Hit
+                : PipelineCacheResult::Miss;
+        }
+
+    private:
+        vk::PipelineCreationFeedback m_Feedback;
+        vk::PipelineCreationFeedbackCreateInfo m_CreateInfo;
+        bool m_Chained = false;
+    };
+
     class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
     {
     public:
@@ -822,6 +1173,7 @@ namespace nvrhi::vulkan
         vk::Pipeline pipeline;
         vk::ShaderStageFlags pushConstantVisibility;
         bool usesBlendConstants = false;
+        LastRecordingReference lastRecordingReference;
 
         explicit GraphicsPipeline(const VulkanContext& context)
             : m_Context(context)
@@ -846,6 +1198,7 @@ namespace nvrhi::vulkan
         vk::PipelineLayout pipelineLayout;
         vk::Pipeline pipeline;
         vk::ShaderStageFlags pushConstantVisibility;
+        LastRecordingReference lastRecordingReference;
 
         explicit ComputePipeline(const VulkanContext& context)
             : m_Context(context)
@@ -871,6 +1224,7 @@ namespace nvrhi::vulkan
         vk::Pipeline pipeline;
         vk::ShaderStageFlags pushConstantVisibility;
         bool usesBlendConstants = false;
+        LastRecordingReference lastRecordingReference;
 
         explicit MeshletPipeline(const VulkanContext& context)
             : m_Context(context)
@@ -898,6 +1252,11 @@ namespace nvrhi::vulkan
         std::unordered_map<std::string, uint32_t> shaderGroups; // name -> index
         std::vector<uint8_t> shaderGroupHandles;
 
+        // Only used for pipelines created with allowAdditions
+        RefCountPtr<RayTracingPipeline> basePipeline; // set when created by addToRayTracingPipeline
+        vk::Pipeline library; // the library with the shaders added by this pipeline, owned
+        std::vector<vk::Pipeline> libraries; // all libraries linked into 'pipeline', including those of the base pipelines
+
         explicit RayTracingPipeline(const VulkanContext& context, Device* device)
             : m_Context(context)
             , m_Device(device)
@@ -919,6 +1278,7 @@ namespace nvrhi::vulkan
     struct ShaderTableState
     {
         uint32_t version = 0;
+        uint32_t layoutVersion = 0;
         vk::StridedDeviceAddressRegionKHR rayGen;
         vk::StridedDeviceAddressRegionKHR miss;
         vk::StridedDeviceAddressRegionKHR hitGroups;
@@ -936,6 +1296,8 @@ namespace nvrhi::vulkan
         std::vector<uint32_t> hitGroups;
 
         uint32_t version = 0;
+        uint32_t layoutVersion = 1; // incremented when records are added or removed
+        std::vector<uint32_t> dirtyRecords; // records replaced since the last upload, only for cached tables
 
         BufferHandle cache;
         ShaderTableState cacheState;
@@ -948,6 +1310,8 @@ namespace nvrhi::vulkan
         
         size_t getUploadSize() const { return pipeline->getShaderTableEntrySize() * size_t(getNumEntries()); }
         void bake(uint8_t* cpuVA, vk::DeviceAddress gpuVA, ShaderTableState& state);
+        void writeRecord(uint8_t* cpuVA, uint32_t recordIndex) const;
+        bool canUpdateRecords(ShaderTableState const& state) const;
 
         rt::ShaderTableDesc const& getDesc() const override { return m_Desc; }
         uint32_t getNumEntries() const override;
@@ -959,12 +1323,22 @@ namespace nvrhi::vulkan
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
+        bool setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        bool setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        IBuffer* getBuffer() const override { return cache; }
+        uint32_t getRecordSize() const override { return pipeline->getShaderTableEntrySize(); }
+        uint64_t getRecordOffset(rt::ShaderTableSection section, uint32_t index) const override;
 
     private:
         const VulkanContext& m_Context;
         rt::ShaderTableDesc const m_Desc;
 
         bool verifyShaderGroupExists(const char* exportName, int shaderGroupIndex) const;
+        bool replaceRecord(std::vector<uint32_t>& section, uint32_t index, const char* exportName, IBindingSet* bindings);
+        uint32_t getRecordIndex(rt::ShaderTableSection section, uint32_t index) const;
+        void markRecordDirty(uint32_t recordIndex);
+        void markLayoutChanged();
     };
 
     struct BufferChunk
@@ -975,39 +1349,141 @@ namespace nvrhi::vulkan
         uint64_t writePointer = 0;
         void* mappedMemory = nullptr;
 
+        // Chunks of an UploadRing share one buffer, these chunks start at bufferOffset
+        uint64_t bufferOffset = 0;
+        bool isRingChunk = false;
+        bool isPoolChunk = false; // owned by a ScratchPool
+
         static constexpr uint64_t c_sizeAlignment = 4096; // GPU page size
     };
 
+    // Device-wide ring of upload chunks shared by the command lists of one queue, or of all queues for the
+    // volatile constant ring. All chunks are sub-ranges of one persistently mapped buffer, claimed in ring order,
+    // and the oldest chunk is reused once the command list that filled it has finished executing.
+    // Command lists sub-allocate from their claimed chunk without locking, only claiming a chunk takes the ring mutex.
+    class UploadRing
+    {
+    public:
+        UploadRing(Device* pParent, uint64_t ringSize, uint64_t chunkSize, bool isVolatileConstantRing = false);
+
+        uint64_t getChunkSize() const { return m_ChunkSize; }
+
+        // Returns the ring buffer, creating it if necessary, or nullptr if it could not be created
+        Buffer* getBuffer();
+
+        // Returns nullptr if the oldest chunk is still in use, or if the ring buffer could not be created
+        std::shared_ptr<BufferChunk> claimChunk(uint64_t currentVersion);
+        void submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion);
+        // Makes the chunks of a recording that will never be submitted available again
+        void releaseChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks);
+
+        UploadRingStatistics getStatistics();
+
+    private:
+        Device* m_Device;
+        uint64_t m_RingSize;
+        uint64_t m_ChunkSize;
+        bool m_IsVolatileConstantRing;
+
+        std::mutex m_Mutex;
+        BufferHandle m_Buffer;
+        bool m_CreationFailed = false;
+        std::vector<std::shared_ptr<BufferChunk>> m_Chunks;
+        size_t m_NextChunk = 0;
+        UploadRingStatistics m_Statistics;
+
+        bool isChunkInUse(const BufferChunk& chunk) const;
+        uint64_t getBytesInUse() const; // requires m_Mutex
+        bool createBuffer();
+        bool ensureBuffer(); // requires m_Mutex
+    };
+
+    // Device-wide pool of AS build scratch chunks shared by the command lists of one queue.
+    // Command lists claim whole chunks for their recording and return them on submission; a chunk becomes
+    // free once that submission has finished. The total size of the chunks is limited by the budget.
+    class ScratchPool
+    {
+    public:
+        ScratchPool(Device* pParent, CommandQueue queue, uint64_t maxMemory, uint64_t chunkSize);
+
+        // Returns a chunk of at least 'size' bytes, or nullptr if every chunk that could be used is claimed
+        // by a recording command list and the budget doesn't allow a new one. needsBarrier is set when the chunk
+        // was reused while an earlier submission on the queue may still be using it.
+        std::shared_ptr<BufferChunk> claimChunk(uint64_t size, uint64_t currentVersion, bool& needsBarrier);
+        void submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion);
+        void releaseChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks);
+
+    private:
+        Device* m_Device;
+        CommandQueue m_Queue;
+        uint64_t m_MaxMemory;
+        uint64_t m_ChunkSize;
+        uint64_t m_AllocatedMemory = 0;
+
+        std::mutex m_Mutex;
+        std::vector<std::shared_ptr<BufferChunk>> m_Chunks;
+    };
+
     class UploadManager
     {
     public:
-        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer,
+            UploadRing* pRing = nullptr, ScratchPool* pScratchPool = nullptr)
             : m_Device(pParent)
             , m_DefaultChunkSize(defaultChunkSize)
             , m_MemoryLimit(memoryLimit)
             , m_IsScratchBuffer(isScratchBuffer)
+            , m_Ring(pRing)
+            , m_ScratchPool(pScratchPool)
         { }
 
+        ~UploadManager();
+
         std::shared_ptr<BufferChunk> CreateChunk(uint64_t size);
 
         bool suballocateBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA, uint64_t currentVersion, uint32_t alignment = 256);
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
+        // Called when the current recording is abandoned without being submitted, so that the chunks it has
+        // claimed don't stay in use forever. Shared ring and pool chunks are returned to their owner.
+        void releaseUnsubmittedChunks();
+
+        // Returns true once after suballocateBuffer has reused a scratch pool chunk that an earlier submission
+        // may still be using, the caller must then place a barrier before using the allocation.
+        bool takeReusedChunkBarrier() { return std::exchange(m_ReusedChunkBarrier, false); }
+
+        // Bytes requested from suballocateBuffer since the last reset, see CommandListStatistics
+        [[nodiscard]] uint64_t getSuballocatedBytes() const { return m_SuballocatedBytes; }
+        void resetSuballocatedBytes() { m_SuballocatedBytes = 0; }
+
     private:
         Device* m_Device;
         uint64_t m_DefaultChunkSize = 0;
         uint64_t m_MemoryLimit = 0;
         uint64_t m_AllocatedMemory = 0;
+        uint64_t m_SuballocatedBytes = 0;
         bool m_IsScratchBuffer = false;
 
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
+
+        // Chunks claimed from the shared ring in the current recording, returned to the ring on submission
+        UploadRing* m_Ring = nullptr;
+        std::vector<std::shared_ptr<BufferChunk>> m_RingChunks;
+
+        // Same for the chunks claimed from the shared scratch pool
+        ScratchPool* m_ScratchPool = nullptr;
+        std::vector<std::shared_ptr<BufferChunk>> m_PoolChunks;
+        bool m_ReusedChunkBarrier = false;
+
+        void retireChunk(const std::shared_ptr<BufferChunk>& chunk);
     };
 
     class AccelStruct : public RefCounter<rt::IAccelStruct>
     {
     public:
         BufferHandle dataBuffer;
+        BufferHandle instanceBuffer; // only when desc.persistentInstanceBuffer = true
         std::vector<vk::AccelerationStructureInstanceKHR> instances;
         vk::AccelerationStructureKHR accelStruct;
         vk::DeviceAddress accelStructDeviceAddress = 0;
@@ -1016,6 +1492,12 @@ namespace nvrhi::vulkan
         bool compacted = false;
         size_t rtxmuId = ~0ull;
         vk::Buffer rtxmuBuffer;
+        size_t builtInstanceCount = 0; // for validating TLAS updates, which must keep the instance count
+#ifndef NVRHI_WITH_RTXMU
+        uint64_t dataOffset = 0; // nonzero only for compacted BLASes that live in a pooled buffer
+        uint64_t compactedSize = 0; // known once the build with AllowCompaction has finished
+        AccelStructStoragePool* storagePool = nullptr; // set when dataBuffer is owned by the pool
+#endif
 
 
         explicit AccelStruct(const VulkanContext& context)
@@ -1028,6 +1510,7 @@ namespace nvrhi::vulkan
         const rt::AccelStructDesc& getDesc() const override { return desc; }
         bool isCompacted() const override { return compacted; }
         uint64_t getDeviceAddress() const override;
+        IBuffer* getInstanceBuffer() const override { return instanceBuffer; }
 
     private:
         const VulkanContext& m_Context;
@@ -1062,7 +1545,17 @@ namespace nvrhi::vulkan
         ~Device() override;
 
         Queue* getQueue(CommandQueue queue) const { return m_Queues[int(queue)].get(); }
+        UploadRing* getUploadRing(CommandQueue queue) const { return m_UploadRings[int(queue)].get(); }
+        ScratchPool* getScratchPool(CommandQueue queue) const { return m_ScratchPools[int(queue)].get(); }
+        UploadRing* getVolatileConstantRing() const { return m_VolatileConstantRing.get(); }
         vk::QueryPool getTimerQueryPool() const { return m_TimerQueryPool; }
+        const InstrumentationHook& getInstrumentation() const { return m_Context.instrumentation; }
+
+        // fills the descriptor set of a binding set whose desc, layout and descriptorSet are already initialized
+        void writeBindingSetDescriptors(BindingSet* bindingSet);
+
+        // creates a buffer that can be used as preprocess memory for device-generated commands
+        RefCountPtr<Buffer> createPreprocessBuffer(uint64_t size);
 
         // IResource implementation
 
@@ -1085,13 +1578,18 @@ namespace nvrhi::vulkan
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
+        BufferHandle createBufferFromHostMemory(const BufferDesc& d, void* hostMemory) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, uint64_t offset, size_t size) override;
         void unmapBuffer(IBuffer* b) override;
+        void flushMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
+        void invalidateMappedRange(IBuffer* b, uint64_t offset, size_t size) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
 
@@ -1117,10 +1615,16 @@ namespace nvrhi::vulkan
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimestampQueryPoolHandle createTimestampQueryPool(const TimestampQueryPoolDesc& desc) override;
+        bool getTimestampResults(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) override;
+        uint64_t getTimestampFrequency(CommandQueue queue) override;
+        QueryPoolHandle createQueryPool(const QueryPoolDesc& desc) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
         FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+        CommandBundleHandle createCommandBundle(const CommandBundleDesc& desc) override;
+        IndirectCommandLayoutHandle createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc) override;
 
         GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
 
@@ -1133,6 +1637,12 @@ namespace nvrhi::vulkan
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        rt::PipelineHandle addToRayTracingPipeline(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override;
+        PendingPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createGraphicsPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc) override { return m_PipelineCompilePool.createComputePipeline(this, desc); }
+        PendingPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override { return m_PipelineCompilePool.createMeshletPipeline(this, desc, fbinfo); }
+        PendingPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc) override { return m_PipelineCompilePool.createRayTracingPipeline(this, desc); }
+        PendingPipelineHandle addToRayTracingPipelineAsync(rt::IPipeline* pipeline, const rt::PipelineDesc& additions) override { return m_PipelineCompilePool.addToRayTracingPipeline(this, pipeline, additions); }
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -1142,26 +1652,43 @@ namespace nvrhi::vulkan
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, uint32_t numItems) override;
         
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
         MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::AccelStructBuildSizes getAccelStructBuildSizes(const rt::AccelStructDesc& desc) override;
+        bool isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header) override;
         rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
         bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
 
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances = nullptr) override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        bool runIncrementalGarbageCollection(const GarbageCollectionBudget& budget) override;
+        void setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds = 2) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
+        void setInstrumentationCallback(IInstrumentationCallback* callback) override { m_Context.instrumentation.set(callback); }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+        bool getPipelineCacheData(void* data, size_t* dataSize) override;
+        UploadRingStatistics getUploadRingStatistics(CommandQueue queue) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void enumerateResourceAllocations(IResourceAllocationCallback& callback) override { m_Context.memoryCounters.enumerateAllocations(callback); }
+        BarrierStatistics getBarrierStatistics(CommandQueue queue) override;
+        void resetBarrierStatistics() override;
+        CommandListStatistics getCommandListStatistics(CommandQueue queue) override;
+        void resetCommandListStatistics() override;
+        PipelineCreationStatistics getPipelineCreationStatistics() override { return m_Context.pipelineCounters.get(); }
+        void resetPipelineCreationStatistics() override { m_Context.pipelineCounters.reset(); }
 
         // vulkan::IDevice implementation
         VkSemaphore getQueueSemaphore(CommandQueue queue) override;
@@ -1185,8 +1712,40 @@ namespace nvrhi::vulkan
 
         // array of submission queues
         std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> m_Queues;
+        std::array<std::unique_ptr<UploadRing>, uint32_t(CommandQueue::Count)> m_UploadRings;
+        std::array<std::unique_ptr<ScratchPool>, uint32_t(CommandQueue::Count)> m_ScratchPools;
+        std::unique_ptr<UploadRing> m_VolatileConstantRing;
+        std::unique_ptr<ShaderCache> m_ShaderCache; // null unless DeviceDesc::enableShaderCache
+        std::unique_ptr<StateObjectTables> m_InternedStates; // null unless DeviceDesc::enableStateObjectInterning
+        MemoryBudgetMonitor m_MemoryBudgetMonitor;
+
+        PipelineCompilePool m_PipelineCompilePool;
+        BackgroundGarbageCollector m_BackgroundGarbageCollector;
+
+        std::vector<ICommandList*> m_ResolvedCommandLists; // used locally in executeCommandLists, member to avoid re-allocations
+        std::vector<StateFixup> m_StateFixups; // same
+        std::array<std::vector<CommandListHandle>, uint32_t(CommandQueue::Count)> m_StateFixupCommandLists;
+        std::vector<SubmitBatch> m_SubmitBatches; // used locally in executeSubmitGraph, members to avoid re-allocations
+        std::vector<uint32_t> m_SubmitNodeBatches;
+        std::vector<uint64_t> m_SubmitBatchIDs;
+
+        // Sums of the barrier counters of the command lists executed on each queue
+        std::array<BarrierStatistics, uint32_t(CommandQueue::Count)> m_BarrierStatistics;
+        std::array<CommandListStatistics, uint32_t(CommandQueue::Count)> m_CommandListStatistics;
         
-        void *mapBuffer(IBuffer* b, CpuAccessMode flags, uint64_t offset, size_t size) const;
+        // Returns the atom-aligned range of the buffer's memory object that covers the given buffer range
+        vk::MappedMemoryRange getMappedMemoryRange(const Buffer* buffer, uint64_t offset, size_t size) const;
+
+        // Fills m_ResolvedCommandLists with the command lists to execute, preceded by fix-up command lists
+        // for the ones that have deferred initial states. fixupsUsed is the number of fix-up command lists
+        // of the execution queue that are already taken by the current submission, and is advanced by this call.
+        void resolveDeferredInitialStates(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, size_t& fixupsUsed);
+
+        // Notifies the command lists that they have been submitted and accumulates their statistics
+        void markExecuted(ICommandList* const* pCommandLists, size_t numCommandLists, Queue& queue, uint64_t submissionID);
+
+        // Creates a pipeline from desc, or when basePipeline is not null, adds the shaders from desc to it
+        rt::PipelineHandle createRayTracingPipelineInternal(const rt::PipelineDesc& desc, RayTracingPipeline* basePipeline);
     };
 
     class CommandList : public RefCounter<ICommandList>
@@ -1198,6 +1757,8 @@ namespace nvrhi::vulkan
         ~CommandList() override;
 
         void executed(Queue& queue, uint64_t submissionID);
+        void recordStateFixups(const std::vector<StateFixup>& fixups);
+        CommandListResourceStateTracker& getStateTracker() { return m_StateTracker; }
 
         // IResource implementation
 
@@ -1220,6 +1781,7 @@ namespace nvrhi::vulkan
         void copyTexture(IStagingTexture* dest, const TextureSlice& dstSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& dstSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureRegions(ITexture* dest, const TextureUploadRegion* regions, size_t numRegions) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
@@ -1227,10 +1789,19 @@ namespace nvrhi::vulkan
         void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings) override;
+        void setIndexBuffer(const IndexBufferBinding& binding) override;
+        void beginRenderPassScope(const RenderPassScope& scope) override;
+        void endRenderPassScope() override;
+        void executeBundle(ICommandBundle* bundle) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
+        void drawMulti(const DrawArguments* args, size_t numDraws) override;
+        void drawIndexedMulti(const DrawArguments* args, size_t numDraws) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
@@ -1238,25 +1809,46 @@ namespace nvrhi::vulkan
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
         void dispatchIndirect(uint32_t offsetBytes)  override;
+        void executeIndirectCommands(IIndirectCommandLayout* layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+            uint32_t countOffsetBytes) override;
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
         
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
+        void writeAccelStructSerializedSize(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void serializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
+        void deserializeAccelStruct(rt::IAccelStruct* as, IBuffer* buffer, uint64_t offset) override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        rt::IndirectInstanceDesc* allocateTopLevelInstances(size_t numInstances) override;
+        void buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelInstances(rt::IAccelStruct* as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void resetTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void writeTimestamp(ITimestampQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimestamps(ITimestampQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void resetQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount) override;
+        void beginQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void endQuery(IQueryPool* pool, uint32_t queryIndex) override;
+        void resolveQueries(IQueryPool* pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* dest, uint64_t destOffsetBytes) override;
+        void beginPredication(IBuffer* buffer, uint64_t offsetBytes, PredicationOp op) override;
+        void endPredication() override;
 
         void beginMarker(const char* name) override;
         void endMarker() override;
@@ -1276,6 +1868,13 @@ namespace nvrhi::vulkan
 
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void releaseTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireTextureOwnership(ITexture* texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void releaseBufferOwnership(IBuffer* buffer, CommandQueue destinationQueue, ResourceStates stateBits) override;
+        void acquireBufferOwnership(IBuffer* buffer, CommandQueue sourceQueue, ResourceStates stateBits) override;
+        void setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
 
         void commitBarriers() override;
 
@@ -1284,6 +1883,8 @@ namespace nvrhi::vulkan
 
         IDevice* getDevice() override { return m_Device; }
         const CommandListParameters& getDesc() override { return m_CommandListParameters; }
+        BarrierStatistics getBarrierStatistics() override { return m_StateTracker.getStatistics(); }
+        CommandListStatistics getStatistics() override;
 
         TrackedCommandBufferPtr getCurrentCmdBuf() const { return m_CurrentCmdBuf; }
 
@@ -1296,8 +1897,28 @@ namespace nvrhi::vulkan
         CommandListResourceStateTracker m_StateTracker;
         bool m_EnableAutomaticBarriers = true;
 
+        // Upload and scratch bytes are counted by the upload managers
+        CommandListStatistics m_Statistics;
+
+        // Framebuffer of the render pass started by beginRenderPassScope, or null when there is no scope
+        IFramebuffer* m_RenderPassScopeFramebuffer = nullptr;
+
         // current internal command buffer
         TrackedCommandBufferPtr m_CurrentCmdBuf = nullptr;
+        // MakeVersion of the recording ID of m_CurrentCmdBuf, see referenceResource
+        uint64_t m_RecordingVersion = 0;
+
+        // Upload memory returned by allocateTopLevelInstances in the current recording
+        struct TopLevelInstanceAllocation
+        {
+            const rt::IndirectInstanceDesc* cpuVA = nullptr;
+            VkDeviceAddress deviceAddress = 0;
+            size_t numInstances = 0;
+        };
+        std::vector<TopLevelInstanceAllocation> m_TopLevelInstanceAllocations;
+
+        // All command buffers used by this command list, recycled when the queue retires them
+        std::vector<TrackedCommandBufferPtr> m_CommandBufferPool;
 
 #if NVRHI_WITH_AFTERMATH
         AftermathMarkerTracker m_AftermathTracker;
@@ -1314,31 +1935,69 @@ namespace nvrhi::vulkan
 
         std::unordered_map<rt::IShaderTable*, std::unique_ptr<ShaderTableState>> m_UncachedShaderTableStates;
         ShaderTableState& getShaderTableState(rt::IShaderTable* shaderTable);
+        bool updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state);
 
         std::unordered_map<Buffer*, VolatileBufferState> m_VolatileBufferStates;
 
+        // Dynamic offsets of the volatile buffers in each descriptor set bound by the last bindBindingSets call,
+        // and the bind point and layout they were bound with
+        BindingVector<static_vector<uint32_t, c_MaxVolatileConstantBuffersPerLayout>> m_BoundDynamicOffsets;
+        vk::PipelineBindPoint m_BoundDynamicOffsetsBindPoint = vk::PipelineBindPoint::eGraphics;
+        vk::PipelineLayout m_BoundDynamicOffsetsLayout;
+
+        // Chunks of the volatile constant ring claimed in the current recording, returned to the ring on submission
+        std::vector<std::shared_ptr<BufferChunk>> m_VolatileRingChunks;
+        std::shared_ptr<BufferChunk> m_CurrentVolatileRingChunk;
+
+        // Split transitions whose events have been set by commitBarriersInternal and not waited on yet,
+        // indexed by the split ID from the state tracker. The wait must use the same dependency info as the set.
+        struct PendingSplitBarrier
+        {
+            vk::Event event;
+            std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+            std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
+        };
+        std::unordered_map<uint32_t, PendingSplitBarrier> m_PendingSplitBarriers;
+
         std::unique_ptr<UploadManager> m_UploadManager;
         std::unique_ptr<UploadManager> m_ScratchManager;
+
+        // Reused by drawMulti and drawIndexedMulti to convert the arguments into the VK_EXT_multi_draw layout
+        std::vector<vk::MultiDrawInfoEXT> m_MultiDrawInfos;
+        std::vector<vk::MultiDrawIndexedInfoEXT> m_MultiDrawIndexedInfos;
         
         void clearTexture(ITexture* texture, TextureSubresourceSet subresources, const vk::ClearColorValue& clearValue);
 
         void bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx);
+        // Rebinds only the sets of the current bindings whose volatile buffer offsets changed since bindBindingSets
+        void updateVolatileBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx);
+        uint32_t getVolatileBufferDynamicOffset(Buffer* constantBuffer);
 
-        void beginRenderPass(nvrhi::IFramebuffer* framebuffer);
+        void beginRenderPass(nvrhi::IFramebuffer* framebuffer, vk::RenderingFlags flags = vk::RenderingFlags());
         void endRenderPass();
 
         void insertGraphicsResourceBarriers(const GraphicsState& state);
+        void reportRenderPassScopeBreak(IFramebuffer* nextFramebuffer);
+        void commitGraphicsBarriersInRenderPass();
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer);
+        void bindVertexBuffers(const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& bindings);
         void insertComputeResourceBarriers(const ComputeState& state);
         void insertMeshletResourceBarriers(const MeshletState& state);
         void insertRayTracingResourceBarriers(const rt::State& state);
         void insertResourceBarriersForBindingSets(const BindingSetVector& newBindings, const BindingSetVector& oldBindings);
         
         void writeVolatileBuffer(Buffer* buffer, const void* data, size_t dataSize);
+        void writeVolatileBufferToRing(UploadRing* ring, Buffer* buffer, const void* data, size_t dataSize, VolatileBufferState& state);
         void flushVolatileBufferWrites();
         void submitVolatileBuffers(uint64_t recordingID, uint64_t submittedID);
+        // Returns the volatile constant ring chunks of a recording that will not be executed
+        void releaseVolatileRingChunks();
 
         void updateGraphicsVolatileBuffers();
         void updateComputeVolatileBuffers();
+
+        // Sub-allocates preprocess memory for device-generated commands from the current command buffer
+        bool allocatePreprocessMemory(uint64_t size, uint64_t alignment, vk::DeviceAddress& outAddress);
         void updateMeshletVolatileBuffers();
         void updateRayTracingVolatileBuffers();
 
@@ -1346,6 +2005,32 @@ namespace nvrhi::vulkan
         void requireBufferState(IBuffer* buffer, ResourceStates state);
         bool anyBarriers() const;
 
+        // Keeps the resource alive until the command buffer is retired. Resources that are bound
+        // many times in one recording are only referenced once, see LastRecordingReference.
+        template<typename T> void referenceResource(T* resource)
+        {
+            if (resource->lastRecordingReference.markReferenced(m_RecordingVersion))
+                m_CurrentCmdBuf->referencedResources.push_back(resource);
+        }
+
+        // Native inputs of one BLAS build, kept alive until the build command is recorded
+        struct BottomLevelBuild
+        {
+            std::vector<vk::AccelerationStructureGeometryKHR> geometries;
+            std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
+            std::vector<vk::AccelerationStructureGeometryLinearSweptSpheresDataNV> lss;
+            std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
+            std::vector<uint32_t> maxPrimitiveCounts;
+            vk::AccelerationStructureBuildGeometryInfoKHR buildInfo;
+            bool queryCompactedSize = false;
+        };
+
+        bool prepareBottomLevelAccelStructBuild(AccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+            rt::AccelStructBuildFlags buildFlags, uint64_t currentVersion, BottomLevelBuild& build);
+#ifndef NVRHI_WITH_RTXMU
+        void writeCompactedSizeQueries(AccelStruct* const* accelStructs, size_t numAccelStructs);
+#endif
+        bool suballocateScratchBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, uint64_t currentVersion, uint32_t alignment);
         void buildTopLevelAccelStructInternal(AccelStruct* as, VkDeviceAddress instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags, uint64_t currentVersion);
 
         void commitBarriersInternal();
@@ -28,23 +28,8 @@
 namespace nvrhi::vulkan
 {
 
-    BufferHandle Device::createBuffer(const BufferDesc& desc)
+    static vk::BufferUsageFlags pickBufferUsageFlags(const BufferDesc& desc, const VulkanContext& context)
     {
-        // Check some basic constraints first - the validation layer is expected to handle them too
-
-        if (desc.isVolatile && desc.maxVersions == 0)
-            return nullptr;
-
-        if (desc.isVolatile && !desc.isConstantBuffer)
-            return nullptr;
-
-        if (desc.byteSize == 0)
-            return nullptr;
-
-
-        Buffer *buffer = new Buffer(m_Context, m_Allocator);
-        buffer->desc = desc;
-
         vk::BufferUsageFlags usageFlags = vk::BufferUsageFlagBits::eTransferSrc |
                                           vk::BufferUsageFlagBits::eTransferDst;
 
@@ -56,6 +41,9 @@ namespace nvrhi::vulkan
         
         if (desc.isDrawIndirectArgs)
             usageFlags |= vk::BufferUsageFlagBits::eIndirectBuffer;
+
+        if (desc.isPredicationBuffer && context.extensions.EXT_conditional_rendering)
+            usageFlags |= vk::BufferUsageFlagBits::eConditionalRenderingEXT;
         
         if (desc.isConstantBuffer)
             usageFlags |= vk::BufferUsageFlagBits::eUniformBuffer;
@@ -78,9 +66,31 @@ namespace nvrhi::vulkan
         if (desc.isShaderBindingTable)
             usageFlags |= vk::BufferUsageFlagBits::eShaderBindingTableKHR;
 
-        if (m_Context.extensions.buffer_device_address)
+        if (context.extensions.buffer_device_address)
             usageFlags |= vk::BufferUsageFlagBits::eShaderDeviceAddress;
 
+        return usageFlags;
+    }
+
+    BufferHandle Device::createBuffer(const BufferDesc& desc)
+    {
+        // Check some basic constraints first - the validation layer is expected to handle them too
+
+        if (desc.isVolatile && desc.maxVersions == 0 && !m_VolatileConstantRing)
+            return nullptr;
+
+        if (desc.isVolatile && !desc.isConstantBuffer)
+            return nullptr;
+
+        if (desc.byteSize == 0)
+            return nullptr;
+
+
+        Buffer *buffer = new Buffer(m_Context, m_Allocator);
+        buffer->desc = desc;
+
+        const vk::BufferUsageFlags usageFlags = pickBufferUsageFlags(desc, m_Context);
+
         uint64_t size = desc.byteSize;
 
         if (desc.isVolatile)
@@ -97,9 +107,14 @@ namespace nvrhi::vulkan
             size = (size + alignment - 1) & ~(alignment - 1);
             buffer->desc.byteSize = size;
 
-            size *= desc.maxVersions;
+            // With the volatile constant ring, the writes never go into the buffer's own memory,
+            // keep a single version to have a valid buffer object
+            const uint32_t numVersions = m_VolatileConstantRing ? 1 : desc.maxVersions;
+            buffer->desc.maxVersions = numVersions;
 
-            buffer->versionTracking.resize(desc.maxVersions);
+            size *= numVersions;
+
+            buffer->versionTracking.resize(numVersions);
             std::fill(buffer->versionTracking.begin(), buffer->versionTracking.end(), 0);
 
             buffer->desc.cpuAccess = CpuAccessMode::Write; // to get the right memory type allocated
@@ -136,11 +151,15 @@ namespace nvrhi::vulkan
             res = m_Allocator.allocateBufferMemory(buffer, (usageFlags & vk::BufferUsageFlagBits::eShaderDeviceAddress) != vk::BufferUsageFlags(0));
             CHECK_VK_FAIL(res)
 
-            m_Context.nameVKObject(buffer->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            buffer->trackedMemory.set(m_Context.memoryCounters, buffer, buffer->memorySize);
+
+            // sub-allocated buffers share the memory object with other resources, don't name it after one of them
+            if (!buffer->memoryBlock)
+                m_Context.nameVKObject(buffer->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
 
             if (desc.isVolatile)
             {
-                buffer->mappedMemory = m_Context.device.mapMemory(buffer->memory, 0, size);
+                buffer->mappedMemory = m_Allocator.mapMemory(buffer, 0, size);
                 assert(buffer->mappedMemory);
             }
 
@@ -199,6 +218,58 @@ namespace nvrhi::vulkan
         return BufferHandle::Create(buffer);
     }
 
+    BufferHandle Device::createBufferFromHostMemory(const BufferDesc& desc, void* hostMemory)
+    {
+        if (!m_Context.extensions.EXT_external_memory_host)
+        {
+            utils::NotSupported();
+            return nullptr;
+        }
+
+        Buffer* buffer = new Buffer(m_Context, m_Allocator);
+        buffer->desc = desc;
+        buffer->desc.initialState = ResourceStates::Common;
+
+        const vk::BufferUsageFlags usageFlags = pickBufferUsageFlags(desc, m_Context);
+
+        auto externalBuffer = vk::ExternalMemoryBufferCreateInfo()
+            .setHandleTypes(vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT);
+
+        auto bufferInfo = vk::BufferCreateInfo()
+            .setSize(desc.byteSize)
+            .setUsage(usageFlags)
+            .setSharingMode(vk::SharingMode::eExclusive)
+            .setPNext(&externalBuffer);
+
+        vk::Result res = m_Context.device.createBuffer(&bufferInfo, m_Context.allocationCallbacks, &buffer->buffer);
+        CHECK_VK_FAIL(res);
+
+        m_Context.nameVKObject(VkBuffer(buffer->buffer), vk::ObjectType::eBuffer, vk::DebugReportObjectTypeEXT::eBuffer, desc.debugName.c_str());
+
+        vk::MemoryRequirements memRequirements;
+        m_Context.device.getBufferMemoryRequirements(buffer->buffer, &memRequirements);
+
+        // the imported range cannot be larger than the application's allocation
+        memRequirements.size = desc.byteSize;
+
+        const bool enableDeviceAddress = (usageFlags & vk::BufferUsageFlagBits::eShaderDeviceAddress) != vk::BufferUsageFlags(0);
+        res = m_Allocator.importHostMemory(buffer, hostMemory, memRequirements, enableDeviceAddress);
+        CHECK_VK_FAIL(res);
+
+        m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, 0);
+
+        // the memory belongs to the application, so it's not tracked in the memory statistics
+
+        if (m_Context.extensions.buffer_device_address)
+        {
+            auto addressInfo = vk::BufferDeviceAddressInfo().setBuffer(buffer->buffer);
+
+            buffer->deviceAddress = m_Context.device.getBufferAddress(addressInfo);
+        }
+
+        return BufferHandle::Create(buffer);
+    }
+
     BufferHandle Device::createHandleForNativeBuffer(ObjectType objectType, Object _buffer, const BufferDesc& desc)
     {
         if (!_buffer.pointer)
@@ -278,6 +349,12 @@ namespace nvrhi::vulkan
             state.maxVersion = -1;
             state.initialized = true;
         }
+
+        if (UploadRing* ring = m_Device->getVolatileConstantRing())
+        {
+            writeVolatileBufferToRing(ring, buffer, data, dataSize, state);
+            return;
+        }
         
         std::array<uint64_t, uint32_t(CommandQueue::Count)> queueCompletionValues = {
             getQueueLastFinishedID(m_Device, CommandQueue::Graphics),
@@ -370,6 +447,7 @@ namespace nvrhi::vulkan
 
         // Store the current version and expand the version range in this CL
         state.latestVersion = int(version);
+        state.latestOffset = uint64_t(version) * buffer->desc.byteSize;
         state.minVersion = std::min(int(version), state.minVersion);
         state.maxVersion = std::max(int(version), state.maxVersion);
 
@@ -380,6 +458,49 @@ namespace nvrhi::vulkan
         m_AnyVolatileBufferWrites = true;
     }
 
+    void CommandList::writeVolatileBufferToRing(UploadRing* ring, Buffer* buffer, const void* data, size_t dataSize, VolatileBufferState& state)
+    {
+        // The buffer size is already aligned to the offset alignment and the non-coherent atom size, see createBuffer
+        const uint64_t size = buffer->desc.byteSize;
+
+        if (size > ring->getChunkSize())
+        {
+            std::stringstream ss;
+            ss << "Volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName) <<
+                " is larger than DeviceDesc::volatileConstantRingChunkSize = " << ring->getChunkSize();
+
+            m_Context.error(ss.str());
+            return;
+        }
+
+        if (!m_CurrentVolatileRingChunk || m_CurrentVolatileRingChunk->writePointer + size > m_CurrentVolatileRingChunk->bufferSize)
+        {
+            m_CurrentVolatileRingChunk = ring->claimChunk(MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false));
+
+            if (!m_CurrentVolatileRingChunk)
+            {
+                std::stringstream ss;
+                ss << "The volatile constant ring is full or could not be created, cannot write volatile constant buffer " <<
+                    utils::DebugNameToString(buffer->desc.debugName) << ". Increase DeviceDesc::volatileConstantRingSize.";
+
+                m_Context.error(ss.str());
+                return;
+            }
+
+            m_VolatileRingChunks.push_back(m_CurrentVolatileRingChunk);
+        }
+
+        // All writes are multiples of the alignment, so the write pointer stays aligned
+        const uint64_t offsetInChunk = m_CurrentVolatileRingChunk->writePointer;
+        m_CurrentVolatileRingChunk->writePointer += size;
+
+        memcpy((char*)m_CurrentVolatileRingChunk->mappedMemory + offsetInChunk, data, dataSize);
+
+        state.latestOffset = m_CurrentVolatileRingChunk->bufferOffset + offsetInChunk;
+
+        m_AnyVolatileBufferWrites = true;
+    }
+
     void CommandList::flushVolatileBufferWrites()
     {
         // The volatile CBs are permanently mapped with the eHostVisible flag, but not eHostCoherent,
@@ -402,12 +523,31 @@ namespace nvrhi::vulkan
 
             auto range = vk::MappedMemoryRange()
                 .setMemory(buffer->memory)
-                .setOffset(state.minVersion * buffer->desc.byteSize)
+                .setOffset(buffer->memoryOffset + state.minVersion * buffer->desc.byteSize)
                 .setSize(numVersions * buffer->desc.byteSize);
 
             ranges.push_back(range);
         }
 
+        if (!m_VolatileRingChunks.empty())
+        {
+            // The chunks are whole multiples of the atom size, and so are the written parts of them
+            Buffer* ringBuffer = m_Device->getVolatileConstantRing()->getBuffer();
+
+            for (const auto& chunk : m_VolatileRingChunks)
+            {
+                if (chunk->writePointer == 0)
+                    continue;
+
+                auto range = vk::MappedMemoryRange()
+                    .setMemory(ringBuffer->memory)
+                    .setOffset(ringBuffer->memoryOffset + chunk->bufferOffset)
+                    .setSize(chunk->writePointer);
+
+                ranges.push_back(range);
+            }
+        }
+
         if (!ranges.empty())
         {
             m_Context.device.flushMappedMemoryRanges(ranges);
@@ -454,6 +594,7 @@ namespace nvrhi::vulkan
         if (buffer->desc.isVolatile)
         {
             assert(destOffsetBytes == 0);
+            NVRHI_COUNT_STATISTIC(m_Statistics, volatileConstantBufferWrites, 1);
 
             writeVolatileBuffer(buffer, data, dataSize);
             
@@ -534,7 +675,7 @@ namespace nvrhi::vulkan
 
         if (mappedMemory)
         {
-            m_Context.device.unmapMemory(memory);
+            m_Allocator.unmapMemory(this);
             mappedMemory = nullptr;
         }
 
@@ -575,7 +716,7 @@ namespace nvrhi::vulkan
         }
     }
 
-    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, uint64_t offset, size_t size) const
+    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, uint64_t offset, size_t size)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
@@ -609,11 +750,12 @@ namespace nvrhi::vulkan
         // TODO: there should be a barrier... But there can't be a command list here
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eHost, accessFlags);
 
-        void* ptr = nullptr;
-        [[maybe_unused]] const vk::Result res = m_Context.device.mapMemory(buffer->memory, offset, size, vk::MemoryMapFlags(), &ptr);
-        assert(res == vk::Result::eSuccess);
+        void* mappedMemory = m_Allocator.mapMemory(buffer, offset, size);
+
+        if (mappedMemory && flags == CpuAccessMode::Read)
+            invalidateMappedRange(buffer, offset, size);
 
-        return ptr;
+        return mappedMemory;
     }
 
     void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags)
@@ -627,12 +769,51 @@ namespace nvrhi::vulkan
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_Context.device.unmapMemory(buffer->memory);
+        m_Allocator.unmapMemory(buffer);
 
         // TODO: there should be a barrier
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
     }
 
+    vk::MappedMemoryRange Device::getMappedMemoryRange(const Buffer* buffer, uint64_t offset, size_t size) const
+    {
+        // Flushed and invalidated ranges must start and end on nonCoherentAtomSize boundaries of the memory object,
+        // or end at the end of the object. Sub-allocated host-visible resources are padded to whole atoms,
+        // so the expanded range never reaches into another resource.
+        const uint64_t atomSize = m_Context.physicalDeviceProperties.limits.nonCoherentAtomSize;
+        const uint64_t objectSize = buffer->memoryBlock ? buffer->memoryBlock->size : buffer->memorySize;
+
+        const uint64_t begin = ((buffer->memoryOffset + offset) / atomSize) * atomSize;
+        const uint64_t end = ((buffer->memoryOffset + std::min<uint64_t>(offset + size, buffer->desc.byteSize) + atomSize - 1) / atomSize) * atomSize;
+
+        return vk::MappedMemoryRange()
+            .setMemory(buffer->memory)
+            .setOffset(begin)
+            .setSize(end >= objectSize ? VK_WHOLE_SIZE : end - begin);
+    }
+
+    void Device::flushMappedRange(IBuffer* _buffer, uint64_t offset, size_t size)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (buffer->hostCoherent || !buffer->memory || size == 0)
+            return;
+
+        const vk::MappedMemoryRange range = getMappedMemoryRange(buffer, offset, size);
+        m_Context.device.flushMappedMemoryRanges(1, &range);
+    }
+
+    void Device::invalidateMappedRange(IBuffer* _buffer, uint64_t offset, size_t size)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (buffer->hostCoherent || !buffer->memory || size == 0)
+            return;
+
+        const vk::MappedMemoryRange range = getMappedMemoryRange(buffer, offset, size);
+        m_Context.device.invalidateMappedMemoryRanges(1, &range);
+    }
+
     MemoryRequirements Device::getBufferMemoryRequirements(IBuffer* _buffer)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
@@ -660,6 +841,7 @@ namespace nvrhi::vulkan
         m_Context.device.bindBufferMemory(buffer->buffer, heap->memory, offset);
 
         buffer->heap = heap;
+        buffer->trackedMemory.setPlaced(m_Context.memoryCounters, buffer, getBufferMemoryRequirements(buffer).size, heap, offset);
 
         if (m_Context.extensions.buffer_device_address)
         {
@@ -30,9 +30,14 @@ namespace nvrhi::vulkan
         , m_Context(context)
         , m_CommandListParameters(parameters)
         , m_StateTracker(context.messageCallback)
-        , m_UploadManager(std::make_unique<UploadManager>(device, parameters.uploadChunkSize, 0, false))
-        , m_ScratchManager(std::make_unique<UploadManager>(device, parameters.scratchChunkSize, parameters.scratchMaxMemory, true))
+        , m_UploadManager(std::make_unique<UploadManager>(device, parameters.uploadChunkSize, 0, false,
+            parameters.useSharedUploadRing ? device->getUploadRing(parameters.queueType) : nullptr))
+        , m_ScratchManager(std::make_unique<UploadManager>(device, parameters.scratchChunkSize, parameters.scratchMaxMemory, true, nullptr,
+            parameters.useSharedScratchPool ? device->getScratchPool(parameters.queueType) : nullptr))
     {
+        m_StateTracker.setDeferInitialStates(parameters.deferInitialStates);
+        m_StateTracker.setEnableStatistics(parameters.enableBarrierStatistics);
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
@@ -41,6 +46,8 @@ namespace nvrhi::vulkan
 
     CommandList::~CommandList()
     {
+        releaseVolatileRingChunks();
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
@@ -58,9 +65,40 @@ namespace nvrhi::vulkan
         }
     }
 
+    CommandListStatistics CommandList::getStatistics()
+    {
+        CommandListStatistics statistics = m_Statistics;
+        statistics.uploadBytes = m_UploadManager->getSuballocatedBytes();
+        statistics.scratchBytes = m_ScratchManager->getSuballocatedBytes();
+        return statistics;
+    }
+
     void CommandList::open()
     {
-        m_CurrentCmdBuf = m_Device->getQueue(m_CommandListParameters.queueType)->getOrCreateCommandBuffer();
+        m_StateTracker.resetStatistics();
+        m_Statistics = CommandListStatistics();
+        m_UploadManager->resetSuballocatedBytes();
+        m_ScratchManager->resetSuballocatedBytes();
+
+        if (m_CurrentCmdBuf)
+        {
+            // The previous recording was never executed, so the command buffer can be reused right away
+            m_CurrentCmdBuf->reset();
+#ifndef NVRHI_WITH_RTXMU
+            // The queries were never written, reading them on retirement would return the results of an earlier use
+            m_CurrentCmdBuf->releaseAccelStructQueries();
+#endif
+            m_CurrentCmdBuf->retired.store(true, std::memory_order_relaxed);
+
+            // Same for the upload and volatile constant memory it has claimed
+            m_UploadManager->releaseUnsubmittedChunks();
+            m_ScratchManager->releaseUnsubmittedChunks();
+            releaseVolatileRingChunks();
+        }
+
+        m_CurrentCmdBuf = m_Device->getQueue(m_CommandListParameters.queueType)->getOrCreateCommandBuffer(m_CommandBufferPool);
+        m_RecordingVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+        m_TopLevelInstanceAllocations.clear();
 
         auto beginInfo = vk::CommandBufferBeginInfo()
             .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
@@ -73,8 +111,10 @@ namespace nvrhi::vulkan
 
     void CommandList::close()
     {
+        m_RenderPassScopeFramebuffer = nullptr;
         endRenderPass();
 
+        m_StateTracker.endSplitTransitions();
         m_StateTracker.keepBufferInitialStates();
         m_StateTracker.keepTextureInitialStates();
         commitBarriers();
@@ -97,10 +137,12 @@ namespace nvrhi::vulkan
 
     void CommandList::clearState()
     {
+        m_RenderPassScopeFramebuffer = nullptr;
         endRenderPass();
 
         m_CurrentPipelineLayout = vk::PipelineLayout();
         m_CurrentPushConstantsVisibility = vk::ShaderStageFlagBits();
+        m_BoundDynamicOffsetsLayout = vk::PipelineLayout();
 
         m_CurrentGraphicsState = GraphicsState();
         m_CurrentComputeState = ComputeState();
@@ -123,8 +165,6 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
-        m_CurrentCmdBuf->submissionID = submissionID;
-
         const CommandQueue queueID = queue.getQueueID();
         const uint64_t recordingID = m_CurrentCmdBuf->recordingID;
 
@@ -142,8 +182,25 @@ namespace nvrhi::vulkan
             MakeVersion(recordingID, queueID, false),
             MakeVersion(submissionID, queueID, true));
 
+        if (!m_VolatileRingChunks.empty())
+        {
+            m_Device->getVolatileConstantRing()->submitChunks(m_VolatileRingChunks, MakeVersion(submissionID, queueID, true));
+            m_VolatileRingChunks.clear();
+        }
+        m_CurrentVolatileRingChunk.reset();
+
         m_VolatileBufferStates.clear();
     }
+
+    void CommandList::releaseVolatileRingChunks()
+    {
+        if (!m_VolatileRingChunks.empty())
+        {
+            m_Device->getVolatileConstantRing()->releaseChunks(m_VolatileRingChunks);
+            m_VolatileRingChunks.clear();
+        }
+        m_CurrentVolatileRingChunk.reset();
+    }
  
     void CommandList::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
     {
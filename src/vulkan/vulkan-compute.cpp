@@ -27,6 +27,8 @@ namespace nvrhi::vulkan
 {
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Compute, desc);
+
         vk::Result res;
 
         assert(desc.CS);
@@ -71,6 +73,9 @@ namespace nvrhi::vulkan
                                 .setStage(shaderStageInfo)
                                 .setLayout(pso->pipelineLayout);
 
+        PipelineCreationFeedback feedback;
+        feedback.chain(m_Context, pipelineInfo);
+
         res = m_Context.device.createComputePipelines(m_Context.pipelineCache,
                                                     1, &pipelineInfo,
                                                     m_Context.allocationCallbacks,
@@ -78,6 +83,9 @@ namespace nvrhi::vulkan
 
         CHECK_VK_FAIL(res)
 
+        creationScope.setCacheResult(feedback.getCacheResult());
+        creationScope.setPipeline(pso);
+
         return ComputePipelineHandle::Create(pso);
     }
 
@@ -125,19 +133,29 @@ namespace nvrhi::vulkan
         if (m_CurrentComputeState.pipeline != state.pipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, pso->pipeline);
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            referenceResource(pso);
         }
 
         if (state.indirectParams && state.indirectParams != m_CurrentComputeState.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            referenceResource(checked_cast<Buffer*>(state.indirectParams));
+        }
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentComputeState.indirectCountBuffer)
+        {
+            referenceResource(checked_cast<Buffer*>(state.indirectCountBuffer));
         }
 
-        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings))
         {
             bindBindingSets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
         }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            updateVolatileBindingSets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
+        }
 
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
@@ -157,7 +175,7 @@ namespace nvrhi::vulkan
         {
             ComputePipeline* pso = checked_cast<ComputePipeline*>(m_CurrentComputeState.pipeline);
 
-            bindBindingSets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, m_CurrentComputeState.bindings, pso->descriptorSetIdxToBindingIdx);
+            updateVolatileBindingSets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, m_CurrentComputeState.bindings, pso->descriptorSetIdxToBindingIdx);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -170,6 +188,7 @@ namespace nvrhi::vulkan
         updateComputeVolatileBuffers();
 
         m_CurrentCmdBuf->cmdBuf.dispatch(groupsX, groupsY, groupsZ);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
     }
 
     void CommandList::dispatchIndirect(uint32_t offsetBytes)
@@ -182,6 +201,7 @@ namespace nvrhi::vulkan
         assert(indirectParams);
 
         m_CurrentCmdBuf->cmdBuf.dispatchIndirect(indirectParams->buffer, offsetBytes);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
     }
 
 } // namespace nvrhi::vulkan
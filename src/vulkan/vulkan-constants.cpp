@@ -311,6 +311,10 @@ namespace nvrhi::vulkan
             vk::PipelineStageFlagBits2::eConvertCooperativeVectorMatrixNV,
             vk::AccessFlagBits2::eTransferWrite,
             vk::ImageLayout::eUndefined },
+        { ResourceStates::Predication,
+            vk::PipelineStageFlagBits2::eConditionalRenderingEXT,
+            vk::AccessFlagBits2::eConditionalRenderingReadEXT,
+            vk::ImageLayout::eUndefined },
     };
 
     ResourceStateMapping convertResourceState(ResourceStates state, bool isImage)
@@ -23,6 +23,7 @@
 #include "vulkan-backend.h"
 #include <unordered_map>
 #include <sstream>
+#include <cstring>
 
 #include <nvrhi/common/misc.h>
 
@@ -50,10 +51,27 @@ namespace nvrhi::vulkan
         return DeviceHandle::Create(device);
     }
         
+    // Some drivers don't validate the initial pipeline cache data carefully enough, so check the header here.
+    static bool isPipelineCacheDataCompatible(const void* data, size_t dataSize, const vk::PhysicalDeviceProperties& properties)
+    {
+        VkPipelineCacheHeaderVersionOne header;
+        if (dataSize < sizeof(header))
+            return false;
+
+        memcpy(&header, data, sizeof(header));
+
+        return header.headerSize >= sizeof(header)
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == properties.vendorID
+            && header.deviceID == properties.deviceID
+            && memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    }
+
     Device::Device(const DeviceDesc& desc)
         : m_Context(desc.instance, desc.physicalDevice, desc.device, reinterpret_cast<vk::AllocationCallbacks*>(desc.allocationCallbacks))
-        , m_Allocator(m_Context)
+        , m_Allocator(m_Context, desc.deviceMemoryBlockSize)
         , m_TimerQueryAllocator(desc.maxTimerQueries, true)
+        , m_PipelineCompilePool(desc.numPipelineCompileThreads)
     {
         if (desc.graphicsQueue)
         {
@@ -73,6 +91,40 @@ namespace nvrhi::vulkan
                 CommandQueue::Copy, desc.transferQueue, desc.transferQueueIndex);
         }
 
+        if (desc.uploadRingSize > 0)
+        {
+            // The ring buffers are created when command lists first claim chunks from them
+            for (uint32_t queue = 0; queue < uint32_t(CommandQueue::Count); queue++)
+            {
+                if (m_Queues[queue])
+                    m_UploadRings[queue] = std::make_unique<UploadRing>(this, desc.uploadRingSize, desc.uploadRingChunkSize);
+            }
+        }
+
+        if (desc.scratchPoolMaxMemory > 0)
+        {
+            // The scratch chunks are created when command lists first claim them
+            for (uint32_t queue = 0; queue < uint32_t(CommandQueue::Count); queue++)
+            {
+                if (m_Queues[queue])
+                    m_ScratchPools[queue] = std::make_unique<ScratchPool>(this, CommandQueue(queue), desc.scratchPoolMaxMemory, desc.scratchPoolChunkSize);
+            }
+        }
+
+        if (desc.volatileConstantRingSize > 0)
+        {
+            // The dynamic offsets of the volatile buffer descriptors are 32-bit
+            assert(desc.volatileConstantRingSize <= uint64_t(std::numeric_limits<uint32_t>::max()));
+
+            m_VolatileConstantRing = std::make_unique<UploadRing>(this, desc.volatileConstantRingSize, desc.volatileConstantRingChunkSize, true);
+        }
+
+        if (desc.enableShaderCache)
+            m_ShaderCache = std::make_unique<ShaderCache>();
+
+        if (desc.enableStateObjectInterning)
+            m_InternedStates = std::make_unique<StateObjectTables>();
+
         // maps Vulkan extension strings into the corresponding boolean flags in Device
         const std::unordered_map<std::string, bool*> extensionStringMap = {
             { VK_EXT_CONSERVATIVE_RASTERIZATION_EXTENSION_NAME, &m_Context.extensions.EXT_conservative_rasterization},
@@ -85,12 +137,20 @@ namespace nvrhi::vulkan
             { VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME, &m_Context.extensions.KHR_fragment_shading_rate },
             { VK_KHR_RAY_QUERY_EXTENSION_NAME,&m_Context.extensions.KHR_ray_query },
             { VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, &m_Context.extensions.KHR_ray_tracing_pipeline },
+            { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, &m_Context.extensions.KHR_pipeline_library },
             { VK_EXT_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.EXT_mesh_shader },
             { VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME, &m_Context.extensions.NV_ray_tracing_invocation_reorder },
             { VK_NV_CLUSTER_ACCELERATION_STRUCTURE_EXTENSION_NAME, &m_Context.extensions.NV_cluster_acceleration_structure },
             { VK_EXT_MUTABLE_DESCRIPTOR_TYPE_EXTENSION_NAME, &m_Context.extensions.EXT_mutable_descriptor_type },
             { VK_NV_COOPERATIVE_VECTOR_EXTENSION_NAME, &m_Context.extensions.NV_cooperative_vector },
             { VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME, &m_Context.extensions.NV_ray_tracing_linear_swept_spheres },
+            { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, &m_Context.extensions.EXT_memory_budget },
+            { VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME, &m_Context.extensions.EXT_external_memory_host },
+            { VK_EXT_DEVICE_GENERATED_COMMANDS_EXTENSION_NAME, &m_Context.extensions.EXT_device_generated_commands },
+            { VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, &m_Context.extensions.KHR_push_descriptor },
+            { VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME, &m_Context.extensions.EXT_conditional_rendering },
+            { VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME, &m_Context.extensions.EXT_pipeline_creation_feedback },
+            { VK_EXT_MULTI_DRAW_EXTENSION_NAME, &m_Context.extensions.EXT_multi_draw },
 #if NVRHI_WITH_AFTERMATH
             { VK_NV_DEVICE_DIAGNOSTIC_CHECKPOINTS_EXTENSION_NAME, &m_Context.extensions.NV_device_diagnostic_checkpoints },
             { VK_NV_DEVICE_DIAGNOSTICS_CONFIG_EXTENSION_NAME, &m_Context.extensions.NV_device_diagnostics_config }
@@ -130,6 +190,8 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceClusterAccelerationStructurePropertiesNV nvClusterAccelerationStructureProperties;
         vk::PhysicalDeviceCooperativeVectorPropertiesNV nvCoopVecProperties;
         vk::PhysicalDeviceSubgroupProperties subgroupProperties;
+        vk::PhysicalDeviceExternalMemoryHostPropertiesEXT externalMemoryHostProperties;
+        vk::PhysicalDeviceMultiDrawPropertiesEXT multiDrawProperties;
         
         vk::PhysicalDeviceProperties2 deviceProperties2;
 
@@ -185,6 +247,18 @@ namespace nvrhi::vulkan
             pNext = &nvCoopVecProperties;
         }
 
+        if (m_Context.extensions.EXT_external_memory_host)
+        {
+            externalMemoryHostProperties.pNext = pNext;
+            pNext = &externalMemoryHostProperties;
+        }
+
+        if (m_Context.extensions.EXT_multi_draw)
+        {
+            multiDrawProperties.pNext = pNext;
+            pNext = &multiDrawProperties;
+        }
+
         deviceProperties2.pNext = pNext;
 
         m_Context.physicalDevice.getProperties2(&deviceProperties2);
@@ -199,6 +273,8 @@ namespace nvrhi::vulkan
         m_Context.subgroupProperties = subgroupProperties;
         m_Context.nvClusterAccelerationStructureProperties = nvClusterAccelerationStructureProperties;
         m_Context.coopVecProperties = nvCoopVecProperties;
+        m_Context.externalMemoryHostProperties = externalMemoryHostProperties;
+        m_Context.multiDrawProperties = multiDrawProperties;
         m_Context.messageCallback = desc.errorCB;
         m_Context.logBufferLifetime = desc.logBufferLifetime;
 
@@ -237,8 +313,53 @@ namespace nvrhi::vulkan
         {
             m_Context.warning("Opacity micro-maps are not currently supported by RTXMU.");
         }
+#else
+        if (m_Context.extensions.KHR_acceleration_structure)
+        {
+            auto compaction = std::make_unique<AccelStructCompactionResources>();
+
+            auto queryPoolInfo = vk::QueryPoolCreateInfo()
+                .setQueryType(vk::QueryType::eAccelerationStructureCompactedSizeKHR)
+                .setQueryCount(c_MaxCompactedSizeQueries);
+
+            vk::Result res = m_Context.device.createQueryPool(&queryPoolInfo, m_Context.allocationCallbacks,
+                &compaction->compactedSizeQueryPool);
+
+            if (res == vk::Result::eSuccess)
+            {
+                queryPoolInfo
+                    .setQueryType(vk::QueryType::eAccelerationStructureSerializationSizeKHR)
+                    .setQueryCount(c_MaxSerializationSizeQueries);
+
+                res = m_Context.device.createQueryPool(&queryPoolInfo, m_Context.allocationCallbacks,
+                    &compaction->serializationSizeQueryPool);
+
+                if (res != vk::Result::eSuccess)
+                    m_Context.device.destroyQueryPool(compaction->compactedSizeQueryPool, m_Context.allocationCallbacks);
+            }
+
+            if (res == vk::Result::eSuccess)
+            {
+                // Acceleration structure offsets must be multiples of 256 bytes
+                compaction->compactedStorage = std::make_unique<AccelStructStoragePool>(this, c_CompactedAccelStructChunkSize, 256);
+                m_Context.accelStructCompaction = std::move(compaction);
+            }
+        }
 #endif
         auto pipelineInfo = vk::PipelineCacheCreateInfo();
+        if (desc.pipelineCacheData && desc.pipelineCacheDataSize != 0)
+        {
+            if (isPipelineCacheDataCompatible(desc.pipelineCacheData, desc.pipelineCacheDataSize, m_Context.physicalDeviceProperties))
+            {
+                pipelineInfo.setInitialDataSize(desc.pipelineCacheDataSize);
+                pipelineInfo.setPInitialData(desc.pipelineCacheData);
+            }
+            else
+            {
+                m_Context.info("The provided pipeline cache data was created by a different device or driver, ignoring it");
+            }
+        }
+
         vk::Result res = m_Context.device.createPipelineCache(&pipelineInfo,
             m_Context.allocationCallbacks,
             &m_Context.pipelineCache);
@@ -263,17 +384,34 @@ namespace nvrhi::vulkan
 
 #if NVRHI_WITH_AFTERMATH
         m_AftermathEnabled = desc.aftermathEnabled;
+        m_AftermathCrashDumpHelper.setCompactMarkers(desc.aftermathCompactMarkers);
 #endif
     }
 
     Device::~Device()
     {
+        m_BackgroundGarbageCollector.stop();
+
+        // Finish the pipelines that are being compiled before destroying the pipeline cache
+        m_PipelineCompilePool.shutdown();
+
         if (m_TimerQueryPool)
         {
             m_Context.device.destroyQueryPool(m_TimerQueryPool);
             m_TimerQueryPool = vk::QueryPool();
         }
 
+#ifndef NVRHI_WITH_RTXMU
+        if (m_Context.accelStructCompaction)
+        {
+            // The BLASes waiting for compaction may return their storage to the pool, release them first
+            m_Context.accelStructCompaction->compactionsReady.clear();
+            m_Context.device.destroyQueryPool(m_Context.accelStructCompaction->compactedSizeQueryPool, m_Context.allocationCallbacks);
+            m_Context.device.destroyQueryPool(m_Context.accelStructCompaction->serializationSizeQueryPool, m_Context.allocationCallbacks);
+            m_Context.accelStructCompaction.reset();
+        }
+#endif
+
         if (m_Context.pipelineCache)
         {
             m_Context.device.destroyPipelineCache(m_Context.pipelineCache);
@@ -287,6 +425,83 @@ namespace nvrhi::vulkan
         }
     }
 
+    UploadRingStatistics Device::getUploadRingStatistics(CommandQueue queue)
+    {
+        UploadRing* ring = getUploadRing(queue);
+        if (!ring)
+            return UploadRingStatistics();
+
+        return ring->getStatistics();
+    }
+
+    BarrierStatistics Device::getBarrierStatistics(CommandQueue queue)
+    {
+        return m_BarrierStatistics[uint32_t(queue)];
+    }
+
+    void Device::resetBarrierStatistics()
+    {
+        m_BarrierStatistics.fill(BarrierStatistics());
+    }
+
+    CommandListStatistics Device::getCommandListStatistics(CommandQueue queue)
+    {
+        return m_CommandListStatistics[uint32_t(queue)];
+    }
+
+    void Device::resetCommandListStatistics()
+    {
+        m_CommandListStatistics.fill(CommandListStatistics());
+    }
+
+    MemoryStatistics Device::getMemoryStatistics()
+    {
+        MemoryStatistics statistics;
+        m_Context.memoryCounters.fillStatistics(statistics);
+
+        vk::PhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties;
+        vk::PhysicalDeviceMemoryProperties2 memoryProperties;
+        if (m_Context.extensions.EXT_memory_budget)
+            memoryProperties.setPNext(&budgetProperties);
+
+        m_Context.physicalDevice.getMemoryProperties2(&memoryProperties);
+
+        const vk::PhysicalDeviceMemoryProperties& properties = memoryProperties.memoryProperties;
+        for (uint32_t heapIndex = 0; heapIndex < properties.memoryHeapCount && heapIndex < c_MaxMemoryHeaps; heapIndex++)
+        {
+            MemoryHeapStatistics heap;
+            heap.isDeviceLocal = (properties.memoryHeaps[heapIndex].flags & vk::MemoryHeapFlagBits::eDeviceLocal) != vk::MemoryHeapFlags();
+
+            if (m_Context.extensions.EXT_memory_budget)
+            {
+                heap.budget = budgetProperties.heapBudget[heapIndex];
+                heap.usage = budgetProperties.heapUsage[heapIndex];
+            }
+            else
+            {
+                // Without the extension, the heap size is the best available approximation of the budget
+                heap.budget = properties.memoryHeaps[heapIndex].size;
+            }
+
+            statistics.heaps.push_back(heap);
+        }
+
+        m_MemoryBudgetMonitor.update(statistics, m_Context.messageCallback);
+
+        return statistics;
+    }
+
+    bool Device::getPipelineCacheData(void* data, size_t* dataSize)
+    {
+        if (!m_Context.pipelineCache || !dataSize)
+            return false;
+
+        const vk::Result res = m_Context.device.getPipelineCacheData(m_Context.pipelineCache, dataSize, data);
+
+        // eIncomplete means that the cache didn't fit into the provided buffer
+        return res == vk::Result::eSuccess;
+    }
+
     Object Device::getNativeObject(ObjectType objectType)
     {
         switch (objectType)
@@ -323,6 +538,8 @@ namespace nvrhi::vulkan
 
     void Device::runGarbageCollection()
     {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::GarbageCollection);
+
         for (auto& m_Queue : m_Queues)
         {
             if (m_Queue)
@@ -330,6 +547,47 @@ namespace nvrhi::vulkan
                 m_Queue->retireCommandBuffers();
             }
         }
+
+        if (m_ShaderCache)
+            m_ShaderCache->prune();
+
+        // Notifies the message callback if the memory budget is exceeded
+        (void)getMemoryStatistics();
+    }
+
+    bool Device::runIncrementalGarbageCollection(const GarbageCollectionBudget& budget)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::GarbageCollection);
+
+        GarbageCollectionBudgetTracker tracker(budget);
+
+        for (auto& queue : m_Queues)
+        {
+            if (queue && !queue->retireCommandBuffers(&tracker))
+                return false;
+        }
+
+        return true;
+    }
+
+    void Device::setBackgroundGarbageCollection(bool enable, uint32_t intervalMilliseconds)
+    {
+        if (!enable)
+        {
+            m_BackgroundGarbageCollector.stop();
+            return;
+        }
+
+        m_BackgroundGarbageCollector.start([this]()
+        {
+            InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::GarbageCollection);
+
+            for (auto& queue : m_Queues)
+            {
+                if (queue)
+                    queue->retireCommandBuffers();
+            }
+        }, intervalMilliseconds);
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -342,6 +600,8 @@ namespace nvrhi::vulkan
             return m_Context.extensions.KHR_acceleration_structure;
         case Feature::RayTracingPipeline:
             return m_Context.extensions.KHR_ray_tracing_pipeline;
+        case Feature::RayTracingPipelineLibraries:
+            return m_Context.extensions.KHR_ray_tracing_pipeline && m_Context.extensions.KHR_pipeline_library;
         case Feature::RayTracingOpacityMicromap:
 #ifdef NVRHI_WITH_RTXMU
             return false; // RTXMU does not support OMMs
@@ -405,6 +665,51 @@ namespace nvrhi::vulkan
             return true;
         case Feature::HeapDirectlyIndexed:
             return m_Context.extensions.EXT_mutable_descriptor_type;
+        case Feature::IndirectCommandLayouts:
+            return m_Context.extensions.EXT_device_generated_commands;
+        case Feature::PushDescriptors:
+            return m_Context.extensions.KHR_push_descriptor;
+        case Feature::PipelineStatisticsQueries:
+            // The application must also enable the feature when creating the device
+            return m_Context.physicalDevice.getFeatures().pipelineStatisticsQuery;
+        case Feature::Predication:
+            return m_Context.extensions.EXT_conditional_rendering;
+        case Feature::HostMemoryImport:
+            if (!m_Context.extensions.EXT_external_memory_host)
+                return false;
+            if (pInfo)
+            {
+                if (infoSize == sizeof(HostMemoryImportFeatureInfo))
+                {
+                    auto* pHostMemoryInfo = reinterpret_cast<HostMemoryImportFeatureInfo*>(pInfo);
+                    pHostMemoryInfo->minPointerAlignment = m_Context.externalMemoryHostProperties.minImportedHostPointerAlignment;
+                }
+                else
+                    utils::NotSupported();
+            }
+            return true;
+        case Feature::ExtendedDynamicState:
+            // Extended dynamic state 1 and 2 are core in Vulkan 1.3, which is the minimum supported version
+            if (pInfo)
+            {
+                if (infoSize == sizeof(DynamicRenderStateFeatureInfo))
+                {
+                    auto* pDynamicStateInfo = reinterpret_cast<DynamicRenderStateFeatureInfo*>(pInfo);
+                    pDynamicStateInfo->supportedStates = DynamicRenderState::PrimitiveTopology
+                        | DynamicRenderState::ViewportCount
+                        | DynamicRenderState::CullMode
+                        | DynamicRenderState::FrontFace
+                        | DynamicRenderState::DepthBias
+                        | DynamicRenderState::DepthTestEnable
+                        | DynamicRenderState::DepthWriteEnable
+                        | DynamicRenderState::DepthCompareOp
+                        | DynamicRenderState::StencilTestEnable
+                        | DynamicRenderState::StencilOp;
+                }
+                else
+                    utils::NotSupported();
+            }
+            return true;
         case Feature::CooperativeVectorInferencing:
             return m_Context.extensions.NV_cooperative_vector && m_Context.coopVecFeatures.cooperativeVector;
         case Feature::CooperativeVectorTraining:
@@ -543,13 +848,18 @@ namespace nvrhi::vulkan
 
     Object Device::getNativeQueue(ObjectType objectType, CommandQueue queue)
     {
-        if (objectType != ObjectTypes::VK_Queue)
+        if (queue >= CommandQueue::Count || !m_Queues[uint32_t(queue)])
             return nullptr;
 
-        if (queue >= CommandQueue::Count)
+        switch (objectType)
+        {
+        case ObjectTypes::VK_Queue:
+            return Object(m_Queues[uint32_t(queue)]->getVkQueue());
+        case ObjectTypes::VK_Semaphore:
+            return Object(m_Queues[uint32_t(queue)]->trackingSemaphore);
+        default:
             return nullptr;
-
-        return Object(m_Queues[uint32_t(queue)]->getVkQueue());
+        }
     }
 
     CommandListHandle Device::createCommandList(const CommandListParameters& params)
@@ -562,18 +872,148 @@ namespace nvrhi::vulkan
         return CommandListHandle::Create(cmdList);
     }
     
+    void Device::resolveDeferredInitialStates(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue, size_t& fixupsUsed)
+    {
+        m_ResolvedCommandLists.assign(pCommandLists, pCommandLists + numCommandLists);
+
+        bool anyDeferred = false;
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            anyDeferred = anyDeferred || checked_cast<CommandList*>(pCommandLists[i])->getStateTracker().hasDeferredInitialStates();
+        }
+
+        if (!anyDeferred)
+            return;
+
+        auto& fixupPool = m_StateFixupCommandLists[uint32_t(executionQueue)];
+
+        m_ResolvedCommandLists.clear();
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            CommandListResourceStateTracker& stateTracker = commandList->getStateTracker();
+
+            m_StateFixups.clear();
+            if (stateTracker.resolveDeferredInitialStates(m_StateFixups))
+            {
+                if (fixupsUsed == fixupPool.size())
+                {
+                    fixupPool.push_back(createCommandList(CommandListParameters()
+                        .setQueueType(executionQueue)
+                        .setEnableImmediateExecution(false)));
+                }
+
+                CommandList* fixupList = checked_cast<CommandList*>(fixupPool[fixupsUsed].Get());
+                ++fixupsUsed;
+
+                fixupList->open();
+                fixupList->recordStateFixups(m_StateFixups);
+                fixupList->close();
+
+                m_ResolvedCommandLists.push_back(fixupList);
+            }
+
+            // The following command lists in this submission observe the final states of this one
+            stateTracker.publishSubmittedStates();
+
+            m_ResolvedCommandLists.push_back(commandList);
+        }
+    }
+    
     uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
     {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::ExecuteCommandLists);
+
         Queue& queue = *m_Queues[uint32_t(executionQueue)];
 
-        uint64_t submissionID = queue.submit(pCommandLists, numCommandLists);
+        size_t fixupsUsed = 0;
+        resolveDeferredInitialStates(pCommandLists, numCommandLists, executionQueue, fixupsUsed);
+
+        uint64_t submissionID = queue.submit(m_ResolvedCommandLists.data(), m_ResolvedCommandLists.size());
 
+        markExecuted(m_ResolvedCommandLists.data(), m_ResolvedCommandLists.size(), queue, submissionID);
+
+        return submissionID;
+    }
+
+    void Device::markExecuted(ICommandList* const* pCommandLists, size_t numCommandLists, Queue& queue, uint64_t submissionID)
+    {
         for (size_t i = 0; i < numCommandLists; i++)
         {
-            checked_cast<CommandList*>(pCommandLists[i])->executed(queue, submissionID);
+            CommandList* cmdList = checked_cast<CommandList*>(pCommandLists[i]);
+            cmdList->executed(queue, submissionID);
+
+            if (cmdList->getDesc().enableBarrierStatistics)
+                m_BarrierStatistics[uint32_t(queue.getQueueID())] += cmdList->getStateTracker().getStatistics();
+
+#if NVRHI_WITH_COMMAND_LIST_STATISTICS
+            m_CommandListStatistics[uint32_t(queue.getQueueID())] += cmdList->getStatistics();
+#endif
         }
+    }
 
-        return submissionID;
+    void Device::executeSubmitGraph(const SubmitGraphDesc& graph, uint64_t* pInstances)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::ExecuteCommandLists);
+
+        buildSubmitBatches(graph, m_SubmitBatches, m_SubmitNodeBatches);
+
+        // The IDs are reserved up front because a batch may wait for a batch of another queue
+        // that is only submitted later, which timeline semaphores allow
+        m_SubmitBatchIDs.resize(m_SubmitBatches.size());
+        for (size_t batchIndex = 0; batchIndex < m_SubmitBatches.size(); batchIndex++)
+        {
+            m_SubmitBatchIDs[batchIndex] = m_Queues[uint32_t(m_SubmitBatches[batchIndex].queue)]->reserveSubmissionID();
+        }
+
+        std::array<size_t, uint32_t(CommandQueue::Count)> fixupsUsed {};
+        std::array<std::vector<QueueSubmitBatch>, uint32_t(CommandQueue::Count)> queueBatches;
+
+        // Deferred initial states are resolved in graph order, so that every batch observes the states
+        // published by the batches before it
+        for (size_t batchIndex = 0; batchIndex < m_SubmitBatches.size(); batchIndex++)
+        {
+            SubmitBatch& batch = m_SubmitBatches[batchIndex];
+
+            resolveDeferredInitialStates(batch.commandLists.data(), batch.commandLists.size(), batch.queue, fixupsUsed[uint32_t(batch.queue)]);
+            batch.commandLists = m_ResolvedCommandLists;
+
+            QueueSubmitBatch& queueBatch = queueBatches[uint32_t(batch.queue)].emplace_back();
+            queueBatch.commandLists = batch.commandLists.data();
+            queueBatch.numCommandLists = batch.commandLists.size();
+            queueBatch.submissionID = m_SubmitBatchIDs[batchIndex];
+
+            for (uint32_t dependency : batch.batchDependencies)
+            {
+                queueBatch.waitSemaphores.push_back(m_Queues[uint32_t(m_SubmitBatches[dependency].queue)]->trackingSemaphore);
+                queueBatch.waitValues.push_back(m_SubmitBatchIDs[dependency]);
+            }
+
+            for (const TimelinePoint& wait : batch.waits)
+            {
+                queueBatch.waitSemaphores.push_back(m_Queues[uint32_t(wait.queue)]->trackingSemaphore);
+                queueBatch.waitValues.push_back(wait.instance);
+            }
+        }
+
+        // One vkQueueSubmit per queue
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            if (!queueBatches[queueIndex].empty())
+                m_Queues[queueIndex]->submitBatches(queueBatches[queueIndex].data(), queueBatches[queueIndex].size());
+        }
+
+        for (size_t batchIndex = 0; batchIndex < m_SubmitBatches.size(); batchIndex++)
+        {
+            const SubmitBatch& batch = m_SubmitBatches[batchIndex];
+            markExecuted(batch.commandLists.data(), batch.commandLists.size(), *m_Queues[uint32_t(batch.queue)], m_SubmitBatchIDs[batchIndex]);
+        }
+
+        if (pInstances)
+        {
+            for (size_t nodeIndex = 0; nodeIndex < m_SubmitNodeBatches.size(); nodeIndex++)
+                pInstances[nodeIndex] = m_SubmitBatchIDs[m_SubmitNodeBatches[nodeIndex]];
+        }
     }
 
     void Device::getTextureTiling(ITexture* _texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
@@ -729,6 +1169,8 @@ namespace nvrhi::vulkan
             m_Context.nameVKObject(heap->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, d.debugName.c_str());
         }
 
+        heap->trackedMemory.set(m_Context.memoryCounters, heap);
+
         return HeapHandle::Create(heap);
     }
 
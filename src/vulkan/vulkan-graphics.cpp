@@ -22,6 +22,8 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <sstream>
+#include <unordered_set>
 
 namespace nvrhi::vulkan
 {
@@ -130,15 +132,11 @@ namespace nvrhi::vulkan
 
             const auto& view = vrsTexture->getSubresourceView(subresources, dimension, vrsAttachment.format, vk::ImageUsageFlagBits::eFragmentShadingRateAttachmentKHR);
 
-            auto rateProps = vk::PhysicalDeviceFragmentShadingRatePropertiesKHR();
-            auto props = vk::PhysicalDeviceProperties2();
-            props.pNext = &rateProps;
-            m_Context.physicalDevice.getProperties2(&props);
-
+            // Use the properties queried at device creation, framebuffers can be created often (e.g. with dynamic resolution)
             fb->shadingRateAttachment = vk::RenderingFragmentShadingRateAttachmentInfoKHR()
                 .setImageLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR)
                 .setImageView(view.view)
-                .setShadingRateAttachmentTexelSize(rateProps.minFragmentShadingRateAttachmentTexelSize);
+                .setShadingRateAttachmentTexelSize(m_Context.shadingRateProperties.minFragmentShadingRateAttachmentTexelSize);
 
             fb->resources.push_back(vrsAttachment.texture);
         }
@@ -215,6 +213,8 @@ namespace nvrhi::vulkan
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Graphics, desc);
+
         if (desc.renderState.singlePassStereo.enabled)
         {
             m_Context.error("Single-pass stereo is not supported by the Vulkan backend");
@@ -313,9 +313,11 @@ namespace nvrhi::vulkan
         const auto& depthStencilState = desc.renderState.depthStencilState;
         const auto& blendState = desc.renderState.blendState;
 
+        // With a dynamic viewport count, the counts are set with the viewports and must be 0 here
+        const bool dynamicViewportCount = (desc.dynamicRenderState & DynamicRenderState::ViewportCount) != 0;
         auto viewportState = vk::PipelineViewportStateCreateInfo()
-            .setViewportCount(1)
-            .setScissorCount(1);
+            .setViewportCount(dynamicViewportCount ? 0 : 1)
+            .setScissorCount(dynamicViewportCount ? 0 : 1);
 
         auto rasterizer = vk::PipelineRasterizationStateCreateInfo()
                             // .setDepthClampEnable(??)
@@ -381,10 +383,39 @@ namespace nvrhi::vulkan
 
         pso->usesBlendConstants = blendState.usesConstantColor(uint32_t(fbinfo.colorFormats.size()));
 
-        static_vector<vk::DynamicState, 5> dynamicStates = {
-            vk::DynamicState::eViewport,
-            vk::DynamicState::eScissor
-        };
+        static_vector<vk::DynamicState, 16> dynamicStates;
+        if (dynamicViewportCount)
+        {
+            dynamicStates.push_back(vk::DynamicState::eViewportWithCount);
+            dynamicStates.push_back(vk::DynamicState::eScissorWithCount);
+        }
+        else
+        {
+            dynamicStates.push_back(vk::DynamicState::eViewport);
+            dynamicStates.push_back(vk::DynamicState::eScissor);
+        }
+        // Extended dynamic state 1 and 2 are core in Vulkan 1.3
+        if ((desc.dynamicRenderState & DynamicRenderState::PrimitiveTopology) != 0)
+            dynamicStates.push_back(vk::DynamicState::ePrimitiveTopology);
+        if ((desc.dynamicRenderState & DynamicRenderState::CullMode) != 0)
+            dynamicStates.push_back(vk::DynamicState::eCullMode);
+        if ((desc.dynamicRenderState & DynamicRenderState::FrontFace) != 0)
+            dynamicStates.push_back(vk::DynamicState::eFrontFace);
+        if ((desc.dynamicRenderState & DynamicRenderState::DepthBias) != 0)
+        {
+            dynamicStates.push_back(vk::DynamicState::eDepthBias);
+            dynamicStates.push_back(vk::DynamicState::eDepthBiasEnable);
+        }
+        if ((desc.dynamicRenderState & DynamicRenderState::DepthTestEnable) != 0)
+            dynamicStates.push_back(vk::DynamicState::eDepthTestEnable);
+        if ((desc.dynamicRenderState & DynamicRenderState::DepthWriteEnable) != 0)
+            dynamicStates.push_back(vk::DynamicState::eDepthWriteEnable);
+        if ((desc.dynamicRenderState & DynamicRenderState::DepthCompareOp) != 0)
+            dynamicStates.push_back(vk::DynamicState::eDepthCompareOp);
+        if ((desc.dynamicRenderState & DynamicRenderState::StencilTestEnable) != 0)
+            dynamicStates.push_back(vk::DynamicState::eStencilTestEnable);
+        if ((desc.dynamicRenderState & DynamicRenderState::StencilOp) != 0)
+            dynamicStates.push_back(vk::DynamicState::eStencilOp);
         if (pso->usesBlendConstants)
             dynamicStates.push_back(vk::DynamicState::eBlendConstants);
         if (pso->desc.renderState.depthStencilState.dynamicStencilRef)
@@ -437,12 +468,18 @@ namespace nvrhi::vulkan
             pipelineInfo.setPTessellationState(&tessellationState);
         }
 
+        PipelineCreationFeedback feedback;
+        feedback.chain(m_Context, pipelineInfo);
+
         res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
                                                      1, &pipelineInfo,
                                                      m_Context.allocationCallbacks,
                                                      &pso->pipeline);
         ASSERT_VK_OK(res); // for debugging
         CHECK_VK_FAIL(res);
+
+        creationScope.setCacheResult(feedback.getCacheResult());
+        creationScope.setPipeline(pso);
         
         return GraphicsPipelineHandle::Create(pso);
     }
@@ -483,7 +520,7 @@ namespace nvrhi::vulkan
         }
     }
 
-    void CommandList::beginRenderPass(nvrhi::IFramebuffer* _framebuffer)
+    void CommandList::beginRenderPass(nvrhi::IFramebuffer* _framebuffer, vk::RenderingFlags flags)
     {
         endRenderPass();
 
@@ -496,6 +533,7 @@ namespace nvrhi::vulkan
         m_CurrentMeshletState.framebuffer = framebuffer;
 
         vk::RenderingInfo renderingInfo = vk::RenderingInfo()
+            .setFlags(flags)
             .setRenderArea(vk::Rect2D()
                 .setOffset(vk::Offset2D(0, 0))
                 .setExtent(vk::Extent2D(framebuffer->framebufferInfo.width, framebuffer->framebufferInfo.height)))
@@ -506,17 +544,84 @@ namespace nvrhi::vulkan
             .setPStencilAttachment(framebuffer->stencilAttachment.imageView ? &framebuffer->stencilAttachment : nullptr);
         
         m_CurrentCmdBuf->cmdBuf.beginRendering(renderingInfo);
-        m_CurrentCmdBuf->referencedResources.push_back(framebuffer);
+        referenceResource(framebuffer);
+        NVRHI_COUNT_STATISTIC(m_Statistics, renderPasses, 1);
+
+        if (m_StateTracker.statisticsEnabled())
+            ++m_StateTracker.getStatistics().renderPassesBegun;
     }
 
     void CommandList::endRenderPass()
     {
         if (m_CurrentGraphicsState.framebuffer || m_CurrentMeshletState.framebuffer)
         {
+            if (m_RenderPassScopeFramebuffer)
+                reportRenderPassScopeBreak(nullptr);
+
             m_CurrentCmdBuf->cmdBuf.endRendering();
             m_CurrentGraphicsState.framebuffer = nullptr;
             m_CurrentMeshletState.framebuffer = nullptr;
+
+            if (m_StateTracker.statisticsEnabled())
+                ++m_StateTracker.getStatistics().renderPassesEnded;
+        }
+    }
+
+    void CommandList::reportRenderPassScopeBreak(IFramebuffer* nextFramebuffer)
+    {
+        std::stringstream ss;
+        ss << "The render pass started by beginRenderPassScope was split";
+
+        if (nextFramebuffer && nextFramebuffer != m_RenderPassScopeFramebuffer)
+        {
+            ss << " by a draw into a different framebuffer.";
+        }
+        else if (nextFramebuffer)
+        {
+            ss << " by barriers for resources that are not listed in the scope or need UAV barriers:";
+
+            for (const TextureBarrier& barrier : m_StateTracker.getTextureBarriers())
+                ss << " texture " << utils::DebugNameToString(barrier.texture->descRef.debugName) << ";";
+
+            for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
+                ss << " buffer " << utils::DebugNameToString(barrier.buffer->descRef.debugName) << ";";
+        }
+        else
+        {
+            ss << " by an operation that cannot be recorded inside a render pass.";
+        }
+
+        m_Context.messageCallback->message(MessageSeverity::Warning, ss.str().c_str());
+
+        // Report only the first break of each scope
+        m_RenderPassScopeFramebuffer = nullptr;
+    }
+
+    void CommandList::beginRenderPassScope(const RenderPassScope& scope)
+    {
+        assert(m_CurrentCmdBuf);
+
+        m_RenderPassScopeFramebuffer = nullptr;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            setResourceStatesForRenderPassScope(scope);
         }
+
+        // Start a new pass only if the current one can't be kept
+        if (m_CurrentGraphicsState.framebuffer != scope.framebuffer || anyBarriers())
+        {
+            endRenderPass();
+            commitBarriers();
+            beginRenderPass(scope.framebuffer);
+        }
+
+        m_RenderPassScopeFramebuffer = scope.framebuffer;
+    }
+
+    void CommandList::endRenderPassScope()
+    {
+        m_RenderPassScopeFramebuffer = nullptr;
     }
 
     static vk::Viewport VKViewportWithDXCoords(const Viewport& v)
@@ -524,6 +629,223 @@ namespace nvrhi::vulkan
         return vk::Viewport(v.minX, v.maxY, v.maxX - v.minX, -(v.maxY - v.minY), v.minZ, v.maxZ);
     }
 
+    static bool hasDynamicViewportCount(const GraphicsPipeline* pso)
+    {
+        return pso && (pso->desc.dynamicRenderState & DynamicRenderState::ViewportCount) != 0;
+    }
+
+    static void setViewports(vk::CommandBuffer cmdBuf, const ViewportState& viewportState, bool dynamicViewportCount)
+    {
+        nvrhi::static_vector<vk::Viewport, c_MaxViewports> viewports;
+        for (const auto& vp : viewportState.viewports)
+            viewports.push_back(VKViewportWithDXCoords(vp));
+
+        if (dynamicViewportCount)
+            cmdBuf.setViewportWithCount(uint32_t(viewports.size()), viewports.data());
+        else
+            cmdBuf.setViewport(0, uint32_t(viewports.size()), viewports.data());
+    }
+
+    static void setScissors(vk::CommandBuffer cmdBuf, const ViewportState& viewportState, bool dynamicViewportCount)
+    {
+        nvrhi::static_vector<vk::Rect2D, c_MaxViewports> scissors;
+        for (const auto& sc : viewportState.scissorRects)
+        {
+            scissors.push_back(vk::Rect2D(vk::Offset2D(sc.minX, sc.minY),
+                vk::Extent2D(std::abs(sc.maxX - sc.minX), std::abs(sc.maxY - sc.minY))));
+        }
+
+        if (dynamicViewportCount)
+            cmdBuf.setScissorWithCount(uint32_t(scissors.size()), scissors.data());
+        else
+            cmdBuf.setScissor(0, uint32_t(scissors.size()), scissors.data());
+    }
+
+    // Sets the values of the states that are dynamic in the pipeline, except the viewports
+    static void setDynamicRenderState(vk::CommandBuffer cmdBuf, DynamicRenderState states, const DynamicRenderStateValues& values)
+    {
+        if ((states & DynamicRenderState::PrimitiveTopology) != 0)
+            cmdBuf.setPrimitiveTopology(convertPrimitiveTopology(values.primType));
+
+        if ((states & DynamicRenderState::CullMode) != 0)
+            cmdBuf.setCullMode(convertCullMode(values.cullMode));
+
+        if ((states & DynamicRenderState::FrontFace) != 0)
+            cmdBuf.setFrontFace(values.frontCounterClockwise ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise);
+
+        if ((states & DynamicRenderState::DepthBias) != 0)
+        {
+            const bool depthBiasEnable = values.depthBias != 0 || values.slopeScaledDepthBias != 0.f;
+            cmdBuf.setDepthBiasEnable(depthBiasEnable);
+            if (depthBiasEnable)
+                cmdBuf.setDepthBias(float(values.depthBias), values.depthBiasClamp, values.slopeScaledDepthBias);
+        }
+
+        if ((states & DynamicRenderState::DepthTestEnable) != 0)
+            cmdBuf.setDepthTestEnable(values.depthTestEnable);
+
+        if ((states & DynamicRenderState::DepthWriteEnable) != 0)
+            cmdBuf.setDepthWriteEnable(values.depthWriteEnable);
+
+        if ((states & DynamicRenderState::DepthCompareOp) != 0)
+            cmdBuf.setDepthCompareOp(convertCompareOp(values.depthFunc));
+
+        if ((states & DynamicRenderState::StencilTestEnable) != 0)
+            cmdBuf.setStencilTestEnable(values.stencilEnable);
+
+        if ((states & DynamicRenderState::StencilOp) != 0)
+        {
+            const auto& front = values.frontFaceStencil;
+            const auto& back = values.backFaceStencil;
+            cmdBuf.setStencilOp(vk::StencilFaceFlagBits::eFront, convertStencilOp(front.failOp), convertStencilOp(front.passOp),
+                convertStencilOp(front.depthFailOp), convertCompareOp(front.stencilFunc));
+            cmdBuf.setStencilOp(vk::StencilFaceFlagBits::eBack, convertStencilOp(back.failOp), convertStencilOp(back.passOp),
+                convertStencilOp(back.depthFailOp), convertCompareOp(back.stencilFunc));
+        }
+    }
+
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(indexBuffer.buffer)->buffer,
+            indexBuffer.offset,
+            indexBuffer.format == Format::R16_UINT ?
+            vk::IndexType::eUint16 : vk::IndexType::eUint32);
+
+        referenceResource(checked_cast<Buffer*>(indexBuffer.buffer));
+    }
+
+    void CommandList::bindVertexBuffers(const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& bindings)
+    {
+        vk::Buffer vertexBuffers[c_MaxVertexAttributes];
+        vk::DeviceSize vertexBufferOffsets[c_MaxVertexAttributes];
+        uint32_t maxVbIndex = 0;
+
+        for (const auto& binding : bindings)
+        {
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            vertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->buffer;
+            vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+
+            referenceResource(checked_cast<Buffer*>(binding.buffer));
+        }
+
+        m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
+    }
+
+    void CommandList::commitGraphicsBarriersInRenderPass()
+    {
+        if (!anyBarriers())
+            return;
+
+        // Barriers can't be placed inside a render pass, so restart it
+        IFramebuffer* framebuffer = m_CurrentGraphicsState.framebuffer;
+
+        if (m_RenderPassScopeFramebuffer && framebuffer)
+            reportRenderPassScopeBreak(framebuffer);
+
+        if (framebuffer && m_StateTracker.statisticsEnabled())
+            ++m_StateTracker.getStatistics().renderPassSplits;
+
+        endRenderPass();
+        commitBarriers();
+        beginRenderPass(framebuffer);
+    }
+
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_CurrentGraphicsState.pipeline)
+        {
+            m_Context.error("setGraphicsBindingSet requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+
+        BindingSetVector bindings = m_CurrentGraphicsState.bindings;
+        if (slot >= bindings.size())
+            bindings.resize(slot + 1);
+
+        if (bindings[slot] == bindingSet && !m_AnyVolatileBufferWrites)
+            return;
+
+        bindings[slot] = bindingSet;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            insertResourceBarriersForBindingSets(bindings, m_CurrentGraphicsState.bindings);
+            commitGraphicsBarriersInRenderPass();
+        }
+
+        bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, bindings, pso->descriptorSetIdxToBindingIdx);
+
+        m_CurrentGraphicsState.bindings = bindings;
+        m_AnyVolatileBufferWrites = false;
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* bindings, size_t numBindings)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_CurrentGraphicsState.pipeline)
+        {
+            m_Context.error("setVertexBuffers requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        static_vector<VertexBufferBinding, c_MaxVertexAttributes> vertexBuffers;
+        vertexBuffers.resize(numBindings);
+        std::copy(bindings, bindings + numBindings, vertexBuffers.begin());
+
+        if (!arraysAreDifferent(vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
+            return;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            for (const VertexBufferBinding& binding : vertexBuffers)
+                requireBufferState(binding.buffer, ResourceStates::VertexBuffer);
+
+            commitGraphicsBarriersInRenderPass();
+        }
+
+        if (!vertexBuffers.empty())
+            bindVertexBuffers(vertexBuffers);
+
+        m_CurrentGraphicsState.vertexBuffers = vertexBuffers;
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& binding)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (!m_CurrentGraphicsState.pipeline)
+        {
+            m_Context.error("setIndexBuffer requires a graphics state set with setGraphicsState");
+            return;
+        }
+
+        if (m_CurrentGraphicsState.indexBuffer == binding)
+            return;
+
+        if (binding.buffer)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(binding.buffer, ResourceStates::IndexBuffer);
+                commitGraphicsBarriersInRenderPass();
+            }
+
+            bindIndexBuffer(binding);
+        }
+
+        m_CurrentGraphicsState.indexBuffer = binding;
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
         assert(m_CurrentCmdBuf);
@@ -539,16 +861,28 @@ namespace nvrhi::vulkan
         bool anyBarriers = this->anyBarriers();
         bool updatePipeline = false;
 
+        // Viewports set for pipelines with a static viewport count don't apply to pipelines with a dynamic count, and vice versa
+        const bool dynamicViewportCount = hasDynamicViewportCount(pso);
+        const bool viewportCountModeChanged = !m_CurrentGraphicsState.pipeline ||
+            hasDynamicViewportCount(checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline)) != dynamicViewportCount;
+
         if (m_CurrentGraphicsState.pipeline != state.pipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            referenceResource(pso);
             updatePipeline = true;
         }
 
         if (m_CurrentGraphicsState.framebuffer != state.framebuffer || anyBarriers /* because barriers cannot be set inside a renderpass */)
         {
+            if (m_RenderPassScopeFramebuffer && m_CurrentGraphicsState.framebuffer)
+                reportRenderPassScopeBreak(state.framebuffer);
+
+            if (anyBarriers && m_CurrentGraphicsState.framebuffer == state.framebuffer && m_StateTracker.statisticsEnabled())
+                ++m_StateTracker.getStatistics().renderPassSplits;
+
             endRenderPass();
         }
 
@@ -562,32 +896,29 @@ namespace nvrhi::vulkan
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
 
-        if (arraysAreDifferent(m_CurrentGraphicsState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (arraysAreDifferent(m_CurrentGraphicsState.bindings, state.bindings))
         {
             bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
         }
-
-        if (!state.viewport.viewports.empty() && arraysAreDifferent(state.viewport.viewports, m_CurrentGraphicsState.viewport.viewports))
+        else if (m_AnyVolatileBufferWrites)
         {
-            nvrhi::static_vector<vk::Viewport, c_MaxViewports> viewports;
-            for (const auto& vp : state.viewport.viewports)
-            {
-                viewports.push_back(VKViewportWithDXCoords(vp));
-            }
+            updateVolatileBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
+        }
 
-            m_CurrentCmdBuf->cmdBuf.setViewport(0, uint32_t(viewports.size()), viewports.data());
+        if (!state.viewport.viewports.empty() && (viewportCountModeChanged || arraysAreDifferent(state.viewport.viewports, m_CurrentGraphicsState.viewport.viewports)))
+        {
+            setViewports(m_CurrentCmdBuf->cmdBuf, state.viewport, dynamicViewportCount);
         }
 
-        if (!state.viewport.scissorRects.empty() && arraysAreDifferent(state.viewport.scissorRects, m_CurrentGraphicsState.viewport.scissorRects))
+        if (!state.viewport.scissorRects.empty() && (viewportCountModeChanged || arraysAreDifferent(state.viewport.scissorRects, m_CurrentGraphicsState.viewport.scissorRects)))
         {
-            nvrhi::static_vector<vk::Rect2D, c_MaxViewports> scissors;
-            for (const auto& sc : state.viewport.scissorRects)
-            {
-                scissors.push_back(vk::Rect2D(vk::Offset2D(sc.minX, sc.minY),
-                    vk::Extent2D(std::abs(sc.maxX - sc.minX), std::abs(sc.maxY - sc.minY))));
-            }
+            setScissors(m_CurrentCmdBuf->cmdBuf, state.viewport, dynamicViewportCount);
+        }
 
-            m_CurrentCmdBuf->cmdBuf.setScissor(0, uint32_t(scissors.size()), scissors.data());
+        // Binding a pipeline with static state invalidates the dynamic values, so set them again after pipeline changes
+        if (pso->desc.dynamicRenderState != 0 && (updatePipeline || m_CurrentGraphicsState.dynamicRenderState != state.dynamicRenderState))
+        {
+            setDynamicRenderState(m_CurrentCmdBuf->cmdBuf, pso->desc.dynamicRenderState, state.dynamicRenderState);
         }
 
         if (pso->desc.renderState.depthStencilState.dynamicStencilRef && (updatePipeline || m_CurrentGraphicsState.dynamicStencilRefValue != state.dynamicStencilRefValue))
@@ -602,44 +933,22 @@ namespace nvrhi::vulkan
 
         if (state.indexBuffer.buffer && m_CurrentGraphicsState.indexBuffer != state.indexBuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->buffer,
-                state.indexBuffer.offset,
-                state.indexBuffer.format == Format::R16_UINT ?
-                vk::IndexType::eUint16 : vk::IndexType::eUint32);
-
-            m_CurrentCmdBuf->referencedResources.push_back(state.indexBuffer.buffer);
+            bindIndexBuffer(state.indexBuffer);
         }
 
         if (!state.vertexBuffers.empty() && arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
         {
-            vk::Buffer vertexBuffers[c_MaxVertexAttributes];
-            vk::DeviceSize vertexBufferOffsets[c_MaxVertexAttributes];
-            uint32_t maxVbIndex = 0;
-
-            for (const auto& binding : state.vertexBuffers)
-            {
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-
-                vertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->buffer;
-                vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-
-                m_CurrentCmdBuf->referencedResources.push_back(binding.buffer);
-            }
-
-            m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
+            bindVertexBuffers(state.vertexBuffers);
         }
 
         if (state.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            referenceResource(checked_cast<Buffer*>(state.indirectParams));
         }
         
         if (state.indirectCountBuffer && state.indirectCountBuffer != state.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectCountBuffer);
+            referenceResource(checked_cast<Buffer*>(state.indirectCountBuffer));
         }
 
         if (state.shadingRateState.enabled)
@@ -656,13 +965,342 @@ namespace nvrhi::vulkan
         m_AnyVolatileBufferWrites = false;
     }
 
+    CommandBundleHandle Device::createCommandBundle(const CommandBundleDesc& desc)
+    {
+        if (desc.draws.empty())
+        {
+            m_Context.error("Cannot create a command bundle without draws");
+            return nullptr;
+        }
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            if (!draw.state.pipeline || !draw.state.framebuffer)
+            {
+                std::stringstream ss;
+                ss << "Cannot create command bundle " << utils::DebugNameToString(desc.debugName)
+                    << " because one of its draws has no pipeline or framebuffer";
+                m_Context.error(ss.str());
+                return nullptr;
+            }
+
+            for (IBindingSet* _bindingSet : draw.state.bindings)
+            {
+                if (!_bindingSet || !_bindingSet->getDesc())
+                    continue;
+
+                BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+                if (!bindingSet->volatileConstantBuffers.empty())
+                {
+                    std::stringstream ss;
+                    ss << "Cannot create command bundle " << utils::DebugNameToString(desc.debugName)
+                        << " because binding set " << utils::DebugNameToString(bindingSet->desc.debugName)
+                        << " uses volatile constant buffers";
+                    m_Context.error(ss.str());
+                    return nullptr;
+                }
+            }
+        }
+
+        CommandBundle* bundle = new CommandBundle(m_Context);
+        bundle->desc = desc;
+        bundle->buildRequiredStates();
+
+        auto cmdPoolInfo = vk::CommandPoolCreateInfo()
+            .setQueueFamilyIndex(m_Queues[uint32_t(CommandQueue::Graphics)]->getQueueFamilyIndex());
+
+        vk::Result res = m_Context.device.createCommandPool(&cmdPoolInfo, m_Context.allocationCallbacks, &bundle->cmdPool);
+        if (res == vk::Result::eSuccess)
+        {
+            auto allocInfo = vk::CommandBufferAllocateInfo()
+                .setLevel(vk::CommandBufferLevel::eSecondary)
+                .setCommandPool(bundle->cmdPool)
+                .setCommandBufferCount(1);
+
+            res = m_Context.device.allocateCommandBuffers(&allocInfo, &bundle->cmdBuf);
+        }
+
+        if (res != vk::Result::eSuccess)
+        {
+            std::stringstream ss;
+            ss << "Failed to create the secondary command buffer for command bundle " << utils::DebugNameToString(desc.debugName)
+                << ", VkResult = " << resultToString(VkResult(res));
+            m_Context.error(ss.str());
+            delete bundle;
+            return nullptr;
+        }
+
+        bundle->record();
+
+        return CommandBundleHandle::Create(bundle);
+    }
+
+    CommandBundle::~CommandBundle()
+    {
+        if (cmdPool)
+        {
+            m_Context.device.destroyCommandPool(cmdPool, m_Context.allocationCallbacks);
+            cmdPool = vk::CommandPool();
+        }
+    }
+
+    void CommandBundle::buildRequiredStates()
+    {
+        std::unordered_set<IResource*> visited;
+        std::unordered_set<IBuffer*> vertexBuffers;
+        std::unordered_set<IBuffer*> indexBuffers;
+
+        auto reference = [this, &visited](IResource* resource)
+        {
+            if (resource && visited.insert(resource).second)
+                referencedResources.push_back(resource);
+        };
+
+        const FramebufferDesc& framebufferDesc = desc.draws[0].state.framebuffer->getDesc();
+        for (const auto& attachment : framebufferDesc.colorAttachments)
+        {
+            RequiredResourceState required;
+            required.texture = checked_cast<Texture*>(attachment.texture);
+            required.subresources = attachment.subresources;
+            required.state = ResourceStates::RenderTarget;
+            requiredStates.push_back(required);
+        }
+
+        if (framebufferDesc.depthAttachment.valid())
+        {
+            RequiredResourceState required;
+            required.texture = checked_cast<Texture*>(framebufferDesc.depthAttachment.texture);
+            required.subresources = framebufferDesc.depthAttachment.subresources;
+            required.state = framebufferDesc.depthAttachment.isReadOnly ? ResourceStates::DepthRead : ResourceStates::DepthWrite;
+            requiredStates.push_back(required);
+        }
+
+        if (framebufferDesc.shadingRateAttachment.valid())
+        {
+            RequiredResourceState required;
+            required.texture = checked_cast<Texture*>(framebufferDesc.shadingRateAttachment.texture);
+            required.subresources = framebufferDesc.shadingRateAttachment.subresources;
+            required.state = ResourceStates::ShadingRateSurface;
+            requiredStates.push_back(required);
+        }
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            const GraphicsState& state = draw.state;
+
+            reference(state.pipeline);
+            reference(state.framebuffer);
+
+            for (IBindingSet* _bindingSet : state.bindings)
+            {
+                if (!_bindingSet || visited.count(_bindingSet))
+                    continue;
+
+                reference(_bindingSet);
+
+                if (_bindingSet->getDesc())
+                {
+                    BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+                    requiredStates.insert(requiredStates.end(), bindingSet->requiredStates.begin(), bindingSet->requiredStates.end());
+                    hasUavBindings = hasUavBindings || bindingSet->hasUavBindings;
+                }
+            }
+
+            if (state.indexBuffer.buffer && indexBuffers.insert(state.indexBuffer.buffer).second)
+            {
+                reference(state.indexBuffer.buffer);
+
+                RequiredResourceState required;
+                required.buffer = checked_cast<Buffer*>(state.indexBuffer.buffer);
+                required.state = ResourceStates::IndexBuffer;
+                requiredStates.push_back(required);
+            }
+
+            for (const VertexBufferBinding& binding : state.vertexBuffers)
+            {
+                if (!binding.buffer || !vertexBuffers.insert(binding.buffer).second)
+                    continue;
+
+                reference(binding.buffer);
+
+                RequiredResourceState required;
+                required.buffer = checked_cast<Buffer*>(binding.buffer);
+                required.state = ResourceStates::VertexBuffer;
+                requiredStates.push_back(required);
+            }
+        }
+    }
+
+    void CommandBundle::record()
+    {
+        const GraphicsState& firstState = desc.draws[0].state;
+        const FramebufferInfoEx& fbinfo = checked_cast<Framebuffer*>(firstState.framebuffer)->framebufferInfo;
+
+        std::array<vk::Format, c_MaxRenderTargets> colorFormats;
+        for (size_t i = 0; i < fbinfo.colorFormats.size(); i++)
+            colorFormats[i] = vk::Format(convertFormat(fbinfo.colorFormats[i]));
+
+        FormatInfo const& depthStencilFormatInfo = getFormatInfo(fbinfo.depthFormat);
+        vk::Format depthStencilFormat = vk::Format(convertFormat(fbinfo.depthFormat));
+
+        auto inheritanceRenderingInfo = vk::CommandBufferInheritanceRenderingInfo()
+            .setColorAttachmentCount(uint32_t(fbinfo.colorFormats.size()))
+            .setPColorAttachmentFormats(colorFormats.data())
+            .setDepthAttachmentFormat(depthStencilFormatInfo.hasDepth ? depthStencilFormat : vk::Format::eUndefined)
+            .setStencilAttachmentFormat(depthStencilFormatInfo.hasStencil ? depthStencilFormat : vk::Format::eUndefined)
+            .setRasterizationSamples(vk::SampleCountFlagBits(fbinfo.sampleCount));
+
+        auto inheritanceInfo = vk::CommandBufferInheritanceInfo()
+            .setPNext(&inheritanceRenderingInfo);
+
+        // The bundle can be executed by any number of command lists that are in flight at the same time
+        auto beginInfo = vk::CommandBufferBeginInfo()
+            .setFlags(vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse)
+            .setPInheritanceInfo(&inheritanceInfo);
+
+        (void)cmdBuf.begin(&beginInfo);
+
+        if (firstState.shadingRateState.enabled)
+        {
+            vk::FragmentShadingRateCombinerOpKHR combiners[2] = { convertShadingRateCombiner(firstState.shadingRateState.pipelinePrimitiveCombiner), convertShadingRateCombiner(firstState.shadingRateState.imageCombiner) };
+            vk::Extent2D shadingRate = convertFragmentShadingRate(firstState.shadingRateState.shadingRate);
+            cmdBuf.setFragmentShadingRateKHR(&shadingRate, combiners);
+        }
+
+        const GraphicsState* prevState = nullptr;
+
+        for (const CommandBundleDraw& draw : desc.draws)
+        {
+            const GraphicsState& state = draw.state;
+            GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
+            const bool updatePipeline = !prevState || prevState->pipeline != state.pipeline;
+
+            if (updatePipeline)
+                cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+
+            // Secondary command buffers don't inherit any dynamic state, all draws in a bundle share the viewports
+            const bool dynamicViewportCount = hasDynamicViewportCount(pso);
+            if (!prevState || hasDynamicViewportCount(checked_cast<GraphicsPipeline*>(prevState->pipeline)) != dynamicViewportCount)
+            {
+                if (!firstState.viewport.viewports.empty())
+                    setViewports(cmdBuf, firstState.viewport, dynamicViewportCount);
+
+                if (!firstState.viewport.scissorRects.empty())
+                    setScissors(cmdBuf, firstState.viewport, dynamicViewportCount);
+            }
+
+            if (pso->desc.dynamicRenderState != 0 && (updatePipeline || prevState->dynamicRenderState != state.dynamicRenderState))
+                setDynamicRenderState(cmdBuf, pso->desc.dynamicRenderState, state.dynamicRenderState);
+
+            if (updatePipeline || arraysAreDifferent(prevState->bindings, state.bindings))
+            {
+                const uint32_t numDescriptorSets = pso->descriptorSetIdxToBindingIdx.empty()
+                    ? uint32_t(state.bindings.size())
+                    : uint32_t(pso->descriptorSetIdxToBindingIdx.size());
+
+                for (uint32_t setIndex = 0; setIndex < numDescriptorSets; setIndex++)
+                {
+                    IBindingSet* bindingSet = nullptr;
+                    if (pso->descriptorSetIdxToBindingIdx.empty())
+                        bindingSet = state.bindings[setIndex];
+                    else if (pso->descriptorSetIdxToBindingIdx[setIndex] != 0xffffffff)
+                        bindingSet = state.bindings[pso->descriptorSetIdxToBindingIdx[setIndex]];
+
+                    if (!bindingSet)
+                        continue;
+
+                    vk::DescriptorSet descriptorSet = bindingSet->getDesc()
+                        ? checked_cast<BindingSet*>(bindingSet)->descriptorSet
+                        : checked_cast<DescriptorTable*>(bindingSet)->descriptorSet;
+
+                    cmdBuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout,
+                        setIndex, 1, &descriptorSet, 0, nullptr);
+                }
+            }
+
+            if (pso->desc.renderState.depthStencilState.dynamicStencilRef)
+                cmdBuf.setStencilReference(vk::StencilFaceFlagBits::eFrontAndBack, state.dynamicStencilRefValue);
+
+            if (pso->usesBlendConstants)
+                cmdBuf.setBlendConstants(&state.blendConstantColor.r);
+
+            if (state.indexBuffer.buffer && (!prevState || prevState->indexBuffer != state.indexBuffer))
+            {
+                cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->buffer,
+                    state.indexBuffer.offset,
+                    state.indexBuffer.format == Format::R16_UINT ? vk::IndexType::eUint16 : vk::IndexType::eUint32);
+            }
+
+            if (!state.vertexBuffers.empty() && (!prevState || arraysAreDifferent(prevState->vertexBuffers, state.vertexBuffers)))
+            {
+                vk::Buffer vertexBuffers[c_MaxVertexAttributes];
+                vk::DeviceSize vertexBufferOffsets[c_MaxVertexAttributes];
+                uint32_t maxVbIndex = 0;
+
+                for (const auto& binding : state.vertexBuffers)
+                {
+                    if (binding.slot >= c_MaxVertexAttributes)
+                        continue;
+
+                    vertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->buffer;
+                    vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
+                    maxVbIndex = std::max(maxVbIndex, binding.slot);
+                }
+
+                cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
+            }
+
+            if (draw.indexed)
+                cmdBuf.drawIndexed(draw.args.vertexCount, draw.args.instanceCount, draw.args.startIndexLocation, draw.args.startVertexLocation, draw.args.startInstanceLocation);
+            else
+                cmdBuf.draw(draw.args.vertexCount, draw.args.instanceCount, draw.args.startVertexLocation, draw.args.startInstanceLocation);
+
+            prevState = &state;
+        }
+
+        cmdBuf.end();
+    }
+
+    void CommandList::executeBundle(ICommandBundle* _bundle)
+    {
+        assert(m_CurrentCmdBuf);
+
+        CommandBundle* bundle = checked_cast<CommandBundle*>(_bundle);
+
+        // The bundle runs in its own render pass that only contains secondary command buffers
+        endRenderPass();
+
+        if (m_EnableAutomaticBarriers)
+        {
+            // Bundles with UAVs may need UAV barriers on every use, so they can't be skipped
+            m_StateTracker.requireResourceStates(bundle->requiredStates, bundle->hasUavBindings ? nullptr : bundle);
+        }
+
+        commitBarriers();
+
+        beginRenderPass(bundle->desc.draws[0].state.framebuffer, vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+        m_CurrentCmdBuf->cmdBuf.executeCommands(1, &bundle->cmdBuf);
+        endRenderPass();
+
+        m_CurrentCmdBuf->referencedResources.push_back(bundle);
+
+        // All state of the primary command buffer is undefined after vkCmdExecuteCommands
+        m_CurrentPipelineLayout = vk::PipelineLayout();
+        m_BoundDynamicOffsetsLayout = vk::PipelineLayout();
+        m_CurrentPushConstantsVisibility = vk::ShaderStageFlagBits();
+        m_CurrentGraphicsState = GraphicsState();
+        m_CurrentComputeState = ComputeState();
+        m_CurrentMeshletState = MeshletState();
+        m_CurrentRayTracingState = rt::State();
+    }
+
     void CommandList::updateGraphicsVolatileBuffers()
     {
         if (m_AnyVolatileBufferWrites && m_CurrentGraphicsState.pipeline)
         {
             GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
 
-            bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentGraphicsState.bindings, pso->descriptorSetIdxToBindingIdx);
+            updateVolatileBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentGraphicsState.bindings, pso->descriptorSetIdxToBindingIdx);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -678,6 +1316,7 @@ namespace nvrhi::vulkan
             args.instanceCount,
             args.startVertexLocation,
             args.startInstanceLocation);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
@@ -691,6 +1330,102 @@ namespace nvrhi::vulkan
             args.startIndexLocation,
             args.startVertexLocation,
             args.startInstanceLocation);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    // Returns the end of the run of draws starting at 'first' that can go into one VK_EXT_multi_draw call,
+    // which takes the instance parameters once for all of its draws
+    static size_t findMultiDrawBatchEnd(const DrawArguments* args, size_t first, size_t numDraws, uint32_t maxMultiDrawCount)
+    {
+        const size_t end = std::min(numDraws, first + std::max(maxMultiDrawCount, 1u));
+
+        size_t drawIndex = first + 1;
+        while (drawIndex < end
+            && args[drawIndex].instanceCount == args[first].instanceCount
+            && args[drawIndex].startInstanceLocation == args[first].startInstanceLocation)
+        {
+            ++drawIndex;
+        }
+
+        return drawIndex;
+    }
+
+    void CommandList::drawMulti(const DrawArguments* args, size_t numDraws)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateGraphicsVolatileBuffers();
+
+        if (!m_Context.extensions.EXT_multi_draw)
+        {
+            for (size_t drawIndex = 0; drawIndex < numDraws; ++drawIndex)
+            {
+                const DrawArguments& drawArgs = args[drawIndex];
+                m_CurrentCmdBuf->cmdBuf.draw(drawArgs.vertexCount, drawArgs.instanceCount, drawArgs.startVertexLocation, drawArgs.startInstanceLocation);
+            }
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
+            return;
+        }
+
+        size_t batchStart = 0;
+        while (batchStart < numDraws)
+        {
+            const size_t batchEnd = findMultiDrawBatchEnd(args, batchStart, numDraws, m_Context.multiDrawProperties.maxMultiDrawCount);
+
+            m_MultiDrawInfos.clear();
+            for (size_t drawIndex = batchStart; drawIndex < batchEnd; ++drawIndex)
+            {
+                m_MultiDrawInfos.push_back(vk::MultiDrawInfoEXT()
+                    .setFirstVertex(args[drawIndex].startVertexLocation)
+                    .setVertexCount(args[drawIndex].vertexCount));
+            }
+
+            m_CurrentCmdBuf->cmdBuf.drawMultiEXT(uint32_t(m_MultiDrawInfos.size()), m_MultiDrawInfos.data(),
+                args[batchStart].instanceCount, args[batchStart].startInstanceLocation, sizeof(vk::MultiDrawInfoEXT));
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, batchEnd - batchStart);
+
+            batchStart = batchEnd;
+        }
+    }
+
+    void CommandList::drawIndexedMulti(const DrawArguments* args, size_t numDraws)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateGraphicsVolatileBuffers();
+
+        if (!m_Context.extensions.EXT_multi_draw)
+        {
+            for (size_t drawIndex = 0; drawIndex < numDraws; ++drawIndex)
+            {
+                const DrawArguments& drawArgs = args[drawIndex];
+                m_CurrentCmdBuf->cmdBuf.drawIndexed(drawArgs.vertexCount, drawArgs.instanceCount, drawArgs.startIndexLocation, drawArgs.startVertexLocation, drawArgs.startInstanceLocation);
+            }
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, numDraws);
+            return;
+        }
+
+        size_t batchStart = 0;
+        while (batchStart < numDraws)
+        {
+            const size_t batchEnd = findMultiDrawBatchEnd(args, batchStart, numDraws, m_Context.multiDrawProperties.maxMultiDrawCount);
+
+            m_MultiDrawIndexedInfos.clear();
+            for (size_t drawIndex = batchStart; drawIndex < batchEnd; ++drawIndex)
+            {
+                m_MultiDrawIndexedInfos.push_back(vk::MultiDrawIndexedInfoEXT()
+                    .setFirstIndex(args[drawIndex].startIndexLocation)
+                    .setIndexCount(args[drawIndex].vertexCount)
+                    .setVertexOffset(int32_t(args[drawIndex].startVertexLocation)));
+            }
+
+            // No common vertex offset, each draw uses its own from the info structure
+            m_CurrentCmdBuf->cmdBuf.drawMultiIndexedEXT(uint32_t(m_MultiDrawIndexedInfos.size()), m_MultiDrawIndexedInfos.data(),
+                args[batchStart].instanceCount, args[batchStart].startInstanceLocation, sizeof(vk::MultiDrawIndexedInfoEXT), nullptr);
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, batchEnd - batchStart);
+
+            batchStart = batchEnd;
+        }
     }
 
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -703,6 +1438,7 @@ namespace nvrhi::vulkan
         assert(indirectParams);
 
         m_CurrentCmdBuf->cmdBuf.drawIndirect(indirectParams->buffer, offsetBytes, drawCount, sizeof(DrawIndirectArguments));
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
@@ -715,6 +1451,7 @@ namespace nvrhi::vulkan
         assert(indirectParams);
 
         m_CurrentCmdBuf->cmdBuf.drawIndexedIndirect(indirectParams->buffer, offsetBytes, drawCount, sizeof(DrawIndexedIndirectArguments));
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
     void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
@@ -736,6 +1473,7 @@ namespace nvrhi::vulkan
             maxDrawCount,
             sizeof(DrawIndexedIndirectArguments)
         );
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
 } // namespace nvrhi::vulkan
@@ -0,0 +1,337 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "vulkan-backend.h"
+#include "../common/indirect-commands.h"
+
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+#include <sstream>
+
+namespace nvrhi::vulkan
+{
+    // Initial size of the per-command-buffer preprocess buffers, they grow as needed
+    static constexpr uint64_t c_DefaultPreprocessBufferSize = 1024 * 1024;
+
+    IndirectCommandLayout::~IndirectCommandLayout()
+    {
+        if (layout)
+        {
+            m_Context.device.destroyIndirectCommandsLayoutEXT(layout, m_Context.allocationCallbacks);
+            layout = vk::IndirectCommandsLayoutEXT();
+        }
+    }
+
+    Object IndirectCommandLayout::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::VK_IndirectCommandsLayoutEXT:
+            return Object(VkIndirectCommandsLayoutEXT(layout));
+        default:
+            return nullptr;
+        }
+    }
+
+    IndirectCommandLayoutHandle Device::createIndirectCommandLayout(const IndirectCommandLayoutDesc& desc)
+    {
+        if (!m_Context.extensions.EXT_device_generated_commands)
+        {
+            m_Context.error("Indirect command layouts require the VK_EXT_device_generated_commands extension");
+            return nullptr;
+        }
+
+        vk::PipelineLayout pipelineLayout;
+        vk::ShaderStageFlags pushConstantVisibility;
+        vk::ShaderStageFlags shaderStages;
+
+        if (desc.graphicsPipeline)
+        {
+            GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(desc.graphicsPipeline);
+            pipelineLayout = pso->pipelineLayout;
+            pushConstantVisibility = pso->pushConstantVisibility;
+            shaderStages = vk::ShaderStageFlags(convertShaderTypeToShaderStageFlagBits(pso->shaderMask));
+        }
+        else if (desc.computePipeline)
+        {
+            ComputePipeline* pso = checked_cast<ComputePipeline*>(desc.computePipeline);
+            pipelineLayout = pso->pipelineLayout;
+            pushConstantVisibility = pso->pushConstantVisibility;
+            shaderStages = vk::ShaderStageFlagBits::eCompute;
+        }
+        else
+        {
+            m_Context.error("Cannot create an indirect command layout without a pipeline");
+            return nullptr;
+        }
+
+        // The token data is referenced by pointers, so it has to stay in place until the layout is created
+        std::vector<vk::IndirectCommandsPushConstantTokenEXT> pushConstantTokens;
+        std::vector<vk::IndirectCommandsVertexBufferTokenEXT> vertexBufferTokens;
+        pushConstantTokens.reserve(desc.arguments.size());
+        vertexBufferTokens.reserve(desc.arguments.size());
+
+        const auto indexBufferToken = vk::IndirectCommandsIndexBufferTokenEXT()
+            .setMode(vk::IndirectCommandsInputModeFlagBitsEXT::eDxgiIndexBuffer);
+
+        std::vector<vk::IndirectCommandsLayoutTokenEXT> tokens;
+        tokens.reserve(desc.arguments.size());
+
+        bool usesPushConstants = false;
+        uint32_t offset = 0;
+
+        for (const IndirectArgumentDesc& argument : desc.arguments)
+        {
+            vk::IndirectCommandsLayoutTokenEXT& token = tokens.emplace_back();
+            token.setOffset(offset);
+
+            switch (argument.type)
+            {
+            case IndirectArgumentType::PushConstants: {
+                auto& pushConstantToken = pushConstantTokens.emplace_back();
+                pushConstantToken.setUpdateRange(vk::PushConstantRange()
+                    .setStageFlags(pushConstantVisibility)
+                    .setOffset(argument.pushConstantsOffset)
+                    .setSize(argument.pushConstantsByteSize));
+
+                token.setType(vk::IndirectCommandsTokenTypeEXT::ePushConstant);
+                token.data.pPushConstant = &pushConstantToken;
+                usesPushConstants = true;
+                break;
+            }
+            case IndirectArgumentType::VertexBuffer: {
+                auto& vertexBufferToken = vertexBufferTokens.emplace_back();
+                vertexBufferToken.setVertexBindingUnit(argument.vertexBufferSlot);
+
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eVertexBuffer);
+                token.data.pVertexBuffer = &vertexBufferToken;
+                break;
+            }
+            case IndirectArgumentType::IndexBuffer:
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eIndexBuffer);
+                token.data.pIndexBuffer = &indexBufferToken;
+                break;
+            case IndirectArgumentType::Draw:
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eDraw);
+                break;
+            case IndirectArgumentType::DrawIndexed:
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eDrawIndexed);
+                break;
+            case IndirectArgumentType::Dispatch:
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eDispatch);
+                break;
+            default:
+                utils::InvalidEnum();
+                return nullptr;
+            }
+
+            offset += getIndirectArgumentByteSize(argument);
+        }
+
+        if (usesPushConstants && !pushConstantVisibility)
+        {
+            std::stringstream ss;
+            ss << "Cannot create indirect command layout " << utils::DebugNameToString(desc.debugName)
+                << " with push constant arguments because its pipeline has no push constants";
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        IndirectCommandLayout* layout = new IndirectCommandLayout(m_Context);
+        layout->desc = desc;
+        layout->byteStride = getIndirectCommandStride(desc);
+        layout->shaderStages = shaderStages;
+        layout->pipeline = desc.graphicsPipeline
+            ? static_cast<IResource*>(desc.graphicsPipeline)
+            : static_cast<IResource*>(desc.computePipeline);
+
+        auto layoutInfo = vk::IndirectCommandsLayoutCreateInfoEXT()
+            .setShaderStages(shaderStages)
+            .setIndirectStride(layout->byteStride)
+            .setPipelineLayout(usesPushConstants ? pipelineLayout : vk::PipelineLayout())
+            .setTokens(tokens);
+
+        const vk::Result res = m_Context.device.createIndirectCommandsLayoutEXT(&layoutInfo, m_Context.allocationCallbacks, &layout->layout);
+
+        if (res != vk::Result::eSuccess)
+        {
+            std::stringstream ss;
+            ss << "Failed to create the indirect commands layout " << utils::DebugNameToString(desc.debugName)
+                << ", VkResult = " << resultToString(VkResult(res));
+            m_Context.error(ss.str());
+            delete layout;
+            return nullptr;
+        }
+
+        m_Context.nameVKObject(VkIndirectCommandsLayoutEXT(layout->layout), vk::ObjectType::eIndirectCommandsLayoutEXT,
+            vk::DebugReportObjectTypeEXT::eUnknown, desc.debugName.c_str());
+
+        return IndirectCommandLayoutHandle::Create(layout);
+    }
+
+    RefCountPtr<Buffer> Device::createPreprocessBuffer(uint64_t size)
+    {
+        Buffer* buffer = new Buffer(m_Context, m_Allocator);
+        buffer->desc.byteSize = size;
+        buffer->desc.debugName = "PreprocessBuffer";
+
+        // The preprocess usage only exists in the 64-bit usage flags from VK_KHR_maintenance5,
+        // which is a dependency of VK_EXT_device_generated_commands
+        auto usageFlags = vk::BufferUsageFlags2CreateInfoKHR()
+            .setUsage(vk::BufferUsageFlagBits2KHR::ePreprocessBufferEXT | vk::BufferUsageFlagBits2KHR::eShaderDeviceAddress);
+
+        auto bufferInfo = vk::BufferCreateInfo()
+            .setPNext(&usageFlags)
+            .setSize(size)
+            .setSharingMode(vk::SharingMode::eExclusive);
+
+        vk::Result res = m_Context.device.createBuffer(&bufferInfo, m_Context.allocationCallbacks, &buffer->buffer);
+        if (res == vk::Result::eSuccess)
+            res = m_Allocator.allocateBufferMemory(buffer, true);
+
+        if (res != vk::Result::eSuccess)
+        {
+            std::stringstream ss;
+            ss << "Failed to create a preprocess buffer of " << size << " bytes"
+                << ", VkResult = " << resultToString(VkResult(res));
+            m_Context.error(ss.str());
+            delete buffer;
+            return nullptr;
+        }
+
+        m_Context.nameVKObject(VkBuffer(buffer->buffer), vk::ObjectType::eBuffer, vk::DebugReportObjectTypeEXT::eBuffer, buffer->desc.debugName.c_str());
+
+        buffer->trackedMemory.set(m_Context.memoryCounters, buffer, buffer->memorySize);
+
+        auto addressInfo = vk::BufferDeviceAddressInfo().setBuffer(buffer->buffer);
+        buffer->deviceAddress = m_Context.device.getBufferAddress(addressInfo);
+
+        return RefCountPtr<Buffer>::Create(buffer);
+    }
+
+    bool CommandList::allocatePreprocessMemory(uint64_t size, uint64_t alignment, vk::DeviceAddress& outAddress)
+    {
+        TrackedCommandBuffer& cmdBuf = *m_CurrentCmdBuf;
+
+        alignment = std::max<uint64_t>(alignment, 1);
+        uint64_t offset = align(cmdBuf.preprocessOffset, alignment);
+
+        if (!cmdBuf.preprocessBuffer || offset + size > cmdBuf.preprocessBuffer->desc.byteSize)
+        {
+            uint64_t newSize = c_DefaultPreprocessBufferSize;
+
+            if (cmdBuf.preprocessBuffer)
+            {
+                newSize = cmdBuf.preprocessBuffer->desc.byteSize * 2;
+
+                // This recording still uses the outgrown buffer, release it when the command buffer is retired
+                cmdBuf.referencedResources.push_back(cmdBuf.preprocessBuffer);
+            }
+
+            cmdBuf.preprocessBuffer = m_Device->createPreprocessBuffer(std::max(newSize, size));
+            if (!cmdBuf.preprocessBuffer)
+                return false;
+
+            offset = 0;
+        }
+
+        outAddress = cmdBuf.preprocessBuffer->deviceAddress + offset;
+        cmdBuf.preprocessOffset = offset + size;
+        return true;
+    }
+
+    void CommandList::executeIndirectCommands(IIndirectCommandLayout* _layout, uint32_t paramOffsetBytes, uint32_t maxCommandCount,
+        uint32_t countOffsetBytes)
+    {
+        assert(m_CurrentCmdBuf);
+
+        IndirectCommandLayout* layout = checked_cast<IndirectCommandLayout*>(_layout);
+        const bool isGraphics = layout->desc.graphicsPipeline != nullptr;
+
+        Buffer* paramBuffer = nullptr;
+        Buffer* countBuffer = nullptr;
+        vk::Pipeline pipeline;
+
+        if (isGraphics)
+        {
+            paramBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+            countBuffer = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+            pipeline = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline)->pipeline;
+
+            updateGraphicsVolatileBuffers();
+        }
+        else
+        {
+            paramBuffer = checked_cast<Buffer*>(m_CurrentComputeState.indirectParams);
+            countBuffer = checked_cast<Buffer*>(m_CurrentComputeState.indirectCountBuffer);
+            pipeline = checked_cast<ComputePipeline*>(m_CurrentComputeState.pipeline)->pipeline;
+
+            updateComputeVolatileBuffers();
+        }
+
+        assert(paramBuffer); // validation layer handles this
+
+        if (maxCommandCount == 0)
+            return;
+
+        auto pipelineInfo = vk::GeneratedCommandsPipelineInfoEXT()
+            .setPipeline(pipeline);
+
+        auto requirementsInfo = vk::GeneratedCommandsMemoryRequirementsInfoEXT()
+            .setPNext(&pipelineInfo)
+            .setIndirectCommandsLayout(layout->layout)
+            .setMaxSequenceCount(maxCommandCount);
+
+        const vk::MemoryRequirements2 requirements = m_Context.device.getGeneratedCommandsMemoryRequirementsEXT(requirementsInfo);
+
+        vk::DeviceAddress preprocessAddress = 0;
+        const uint64_t preprocessSize = requirements.memoryRequirements.size;
+
+        if (preprocessSize != 0 && !allocatePreprocessMemory(preprocessSize, requirements.memoryRequirements.alignment, preprocessAddress))
+            return;
+
+        auto generatedCommandsInfo = vk::GeneratedCommandsInfoEXT()
+            .setPNext(&pipelineInfo)
+            .setShaderStages(layout->shaderStages)
+            .setIndirectCommandsLayout(layout->layout)
+            .setIndirectAddress(paramBuffer->deviceAddress + paramOffsetBytes)
+            .setIndirectAddressSize(uint64_t(maxCommandCount) * layout->byteStride)
+            .setPreprocessAddress(preprocessAddress)
+            .setPreprocessSize(preprocessSize)
+            .setMaxSequenceCount(maxCommandCount)
+            .setSequenceCountAddress(countBuffer ? countBuffer->deviceAddress + countOffsetBytes : 0);
+
+        m_CurrentCmdBuf->cmdBuf.executeGeneratedCommandsEXT(VK_FALSE, generatedCommandsInfo);
+        if (isGraphics)
+            NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+        else
+            NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
+
+        referenceResource(layout);
+
+        // The commands leave the vertex buffers, index buffer and push constants undefined
+        m_CurrentGraphicsState.vertexBuffers.resize(0);
+        m_CurrentGraphicsState.indexBuffer = IndexBufferBinding();
+    }
+
+} // namespace nvrhi::vulkan
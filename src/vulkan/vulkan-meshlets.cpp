@@ -27,6 +27,8 @@ namespace nvrhi::vulkan
 {
     MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::Meshlet, desc);
+
         if (!m_Context.extensions.EXT_mesh_shader)
         {
             utils::NotSupported();
@@ -187,6 +189,9 @@ namespace nvrhi::vulkan
             .setBasePipelineHandle(nullptr)
             .setBasePipelineIndex(-1);
 
+        PipelineCreationFeedback feedback;
+        feedback.chain(m_Context, pipelineInfo);
+
         res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
                                                      1, &pipelineInfo,
                                                      m_Context.allocationCallbacks,
@@ -194,6 +199,9 @@ namespace nvrhi::vulkan
 
         ASSERT_VK_OK(res); // for debugging
         CHECK_VK_FAIL(res)
+
+        creationScope.setCacheResult(feedback.getCacheResult());
+        creationScope.setPipeline(pso);
         
         return MeshletPipelineHandle::Create(pso);
     }
@@ -257,13 +265,20 @@ namespace nvrhi::vulkan
         if (m_CurrentMeshletState.pipeline != state.pipeline)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
 
-            m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
+            referenceResource(pso);
             updatePipeline = true;
         }
 
         if (m_CurrentMeshletState.framebuffer != state.framebuffer || anyBarriers /* because barriers cannot be set inside a renderpass */)
         {
+            if (m_RenderPassScopeFramebuffer && m_CurrentMeshletState.framebuffer)
+                reportRenderPassScopeBreak(state.framebuffer);
+
+            if (anyBarriers && m_CurrentMeshletState.framebuffer == state.framebuffer && m_StateTracker.statisticsEnabled())
+                ++m_StateTracker.getStatistics().renderPassSplits;
+
             endRenderPass();
         }
 
@@ -277,10 +292,14 @@ namespace nvrhi::vulkan
         m_CurrentPipelineLayout = pso->pipelineLayout;
         m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
 
-        if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (arraysAreDifferent(m_CurrentMeshletState.bindings, state.bindings))
         {
             bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
         }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            updateVolatileBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
+        }
 
         if (!state.viewport.viewports.empty() && arraysAreDifferent(state.viewport.viewports, m_CurrentMeshletState.viewport.viewports))
         {
@@ -317,7 +336,12 @@ namespace nvrhi::vulkan
 
         if (state.indirectParams)
         {
-            m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
+            referenceResource(checked_cast<Buffer*>(state.indirectParams));
+        }
+
+        if (state.indirectCountBuffer && state.indirectCountBuffer != state.indirectParams)
+        {
+            referenceResource(checked_cast<Buffer*>(state.indirectCountBuffer));
         }
 
         m_CurrentComputeState = ComputeState();
@@ -333,7 +357,7 @@ namespace nvrhi::vulkan
         {
             MeshletPipeline* pso = checked_cast<MeshletPipeline*>(m_CurrentMeshletState.pipeline);
 
-            bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentMeshletState.bindings, pso->descriptorSetIdxToBindingIdx);
+            updateVolatileBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, m_CurrentMeshletState.bindings, pso->descriptorSetIdxToBindingIdx);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -346,6 +370,42 @@ namespace nvrhi::vulkan
         updateMeshletVolatileBuffers();
 
         m_CurrentCmdBuf->cmdBuf.drawMeshTasksEXT(groupsX, groupsY, groupsZ);
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateMeshletVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams);
+
+        m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectEXT(indirectParams->buffer, offsetBytes, drawCount, sizeof(DispatchIndirectArguments));
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateMeshletVolatileBuffers();
+
+        Buffer* paramBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* countBuffer = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(paramBuffer);
+        assert(countBuffer);
+
+        m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountEXT(
+            paramBuffer->buffer,
+            paramOffsetBytes,
+            countBuffer->buffer,
+            countOffsetBytes,
+            maxDrawCount,
+            sizeof(DispatchIndirectArguments)
+        );
+        NVRHI_COUNT_STATISTIC(m_Statistics, drawCalls, 1);
     }
 
 } // namespace nvrhi::vulkan
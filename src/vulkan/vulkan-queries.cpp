@@ -209,6 +209,285 @@ namespace nvrhi::vulkan
         query->time = 0.f;
     }
 
+    TimestampQueryPoolHandle Device::createTimestampQueryPool(const TimestampQueryPoolDesc& desc)
+    {
+        auto poolInfo = vk::QueryPoolCreateInfo()
+            .setQueryType(vk::QueryType::eTimestamp)
+            .setQueryCount(desc.queryCount);
+
+        vk::QueryPool queryPool;
+        const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &queryPool);
+        CHECK_VK_FAIL(res)
+
+        m_Context.nameVKObject(VkQueryPool(queryPool), vk::ObjectType::eQueryPool, vk::DebugReportObjectTypeEXT::eQueryPool, desc.debugName.c_str());
+
+        TimestampQueryPool* pool = new TimestampQueryPool(m_Context);
+        pool->desc = desc;
+        pool->queryPool = queryPool;
+        pool->resolveBuffer = createBuffer(BufferDesc()
+            .setByteSize(uint64_t(desc.queryCount) * sizeof(uint64_t))
+            .setCpuAccess(CpuAccessMode::Read)
+            .setDebugName(desc.debugName));
+
+        if (!pool->resolveBuffer)
+        {
+            delete pool;
+            return nullptr;
+        }
+
+        return TimestampQueryPoolHandle::Create(pool);
+    }
+
+    TimestampQueryPool::~TimestampQueryPool()
+    {
+        if (queryPool)
+        {
+            m_Context.device.destroyQueryPool(queryPool, m_Context.allocationCallbacks);
+            queryPool = vk::QueryPool();
+        }
+    }
+
+    bool Device::getTimestampResults(ITimestampQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps)
+    {
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        const uint64_t offset = uint64_t(firstQuery) * sizeof(uint64_t);
+        const size_t size = size_t(queryCount) * sizeof(uint64_t);
+
+        // The resolve buffer is never tracked as a staging buffer, so this doesn't wait for the GPU
+        const void* data = mapBuffer(pool->resolveBuffer, CpuAccessMode::Read, offset, size);
+        if (!data)
+            return false;
+
+        memcpy(outTimestamps, data, size);
+        unmapBuffer(pool->resolveBuffer);
+
+        return true;
+    }
+
+    uint64_t Device::getTimestampFrequency(CommandQueue)
+    {
+        const double timestampPeriod = double(m_Context.physicalDeviceProperties.limits.timestampPeriod); // in nanoseconds
+
+        return uint64_t(1e9 / timestampPeriod);
+    }
+
+    void CommandList::resetTimestamps(ITimestampQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        endRenderPass();
+
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+
+        m_CurrentCmdBuf->cmdBuf.resetQueryPool(pool->queryPool, firstQuery, queryCount);
+    }
+
+    void CommandList::writeTimestamp(ITimestampQueryPool* _pool, uint32_t queryIndex)
+    {
+        endRenderPass();
+
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+
+        m_CurrentCmdBuf->cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pool->queryPool, queryIndex);
+    }
+
+    void CommandList::resolveTimestamps(ITimestampQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        endRenderPass();
+
+        TimestampQueryPool* pool = checked_cast<TimestampQueryPool*>(_pool);
+        Buffer* resolveBuffer = checked_cast<Buffer*>(pool->resolveBuffer.Get());
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+
+        // eWait makes the copy wait on the GPU for the timestamps written earlier in the queue
+        m_CurrentCmdBuf->cmdBuf.copyQueryPoolResults(pool->queryPool, firstQuery, queryCount,
+            resolveBuffer->buffer, uint64_t(firstQuery) * sizeof(uint64_t), sizeof(uint64_t),
+            vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+        // Make the copied results visible to getTimestampResults once the command list has finished
+        auto memoryBarrier = vk::MemoryBarrier2()
+            .setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+            .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits2::eHost)
+            .setDstAccessMask(vk::AccessFlagBits2::eHostRead);
+
+        vk::DependencyInfo dep_info;
+        dep_info.setMemoryBarriers(memoryBarrier);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+    }
+
+    QueryPoolHandle Device::createQueryPool(const QueryPoolDesc& desc)
+    {
+        auto poolInfo = vk::QueryPoolCreateInfo()
+            .setQueryCount(desc.queryCount);
+
+        switch (desc.type)
+        {
+        case QueryType::Occlusion:
+        case QueryType::BinaryOcclusion:
+            poolInfo.setQueryType(vk::QueryType::eOcclusion);
+            break;
+        case QueryType::PipelineStatistics:
+            // The bit order matches the layout of nvrhi::PipelineStatistics
+            poolInfo.setQueryType(vk::QueryType::ePipelineStatistics);
+            poolInfo.setPipelineStatistics(
+                vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+                vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+                vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+                vk::QueryPipelineStatisticFlagBits::eGeometryShaderInvocations |
+                vk::QueryPipelineStatisticFlagBits::eGeometryShaderPrimitives |
+                vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+                vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+                vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+                vk::QueryPipelineStatisticFlagBits::eTessellationControlShaderPatches |
+                vk::QueryPipelineStatisticFlagBits::eTessellationEvaluationShaderInvocations |
+                vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations);
+            break;
+        default:
+            utils::InvalidEnum();
+            return nullptr;
+        }
+
+        vk::QueryPool queryPool;
+        const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &queryPool);
+        CHECK_VK_FAIL(res)
+
+        m_Context.nameVKObject(VkQueryPool(queryPool), vk::ObjectType::eQueryPool, vk::DebugReportObjectTypeEXT::eQueryPool, desc.debugName.c_str());
+
+        QueryPool* pool = new QueryPool(m_Context);
+        pool->desc = desc;
+        pool->queryPool = queryPool;
+
+        return QueryPoolHandle::Create(pool);
+    }
+
+    QueryPool::~QueryPool()
+    {
+        if (queryPool)
+        {
+            m_Context.device.destroyQueryPool(queryPool, m_Context.allocationCallbacks);
+            queryPool = vk::QueryPool();
+        }
+    }
+
+    void CommandList::resetQueries(IQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        endRenderPass();
+
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+
+        m_CurrentCmdBuf->cmdBuf.resetQueryPool(pool->queryPool, firstQuery, queryCount);
+    }
+
+    void CommandList::beginQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        // No endRenderPass here: occlusion queries are usually placed around draws in the current render pass
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+
+        const vk::QueryControlFlags flags = pool->desc.type == QueryType::Occlusion
+            ? vk::QueryControlFlagBits::ePrecise
+            : vk::QueryControlFlags();
+
+        m_CurrentCmdBuf->cmdBuf.beginQuery(pool->queryPool, queryIndex, flags);
+    }
+
+    void CommandList::endQuery(IQueryPool* _pool, uint32_t queryIndex)
+    {
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->cmdBuf.endQuery(pool->queryPool, queryIndex);
+    }
+
+    void CommandList::resolveQueries(IQueryPool* _pool, uint32_t firstQuery, uint32_t queryCount, IBuffer* _dest, uint64_t destOffsetBytes)
+    {
+        endRenderPass();
+
+        QueryPool* pool = checked_cast<QueryPool*>(_pool);
+        Buffer* dest = checked_cast<Buffer*>(_dest);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+
+        if (dest->desc.cpuAccess != CpuAccessMode::None)
+            m_CurrentCmdBuf->referencedStagingBuffers.push_back(dest);
+        else
+            m_CurrentCmdBuf->referencedResources.push_back(dest);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(dest, ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        const vk::DeviceSize stride = pool->desc.type == QueryType::PipelineStatistics
+            ? sizeof(PipelineStatistics)
+            : sizeof(uint64_t);
+
+        m_CurrentCmdBuf->cmdBuf.copyQueryPoolResults(pool->queryPool, firstQuery, queryCount,
+            dest->buffer, destOffsetBytes, stride,
+            vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+    }
+
+    void CommandList::beginPredication(IBuffer* _buffer, uint64_t offsetBytes, PredicationOp op)
+    {
+        // Conditional rendering that begins outside of a render pass may cover any number of render passes
+        endRenderPass();
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->referencedResources.push_back(buffer);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(buffer, ResourceStates::Predication);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        auto beginInfo = vk::ConditionalRenderingBeginInfoEXT()
+            .setBuffer(buffer->buffer)
+            .setOffset(offsetBytes)
+            .setFlags(op == PredicationOp::SkipIfNotZero
+                ? vk::ConditionalRenderingFlagBitsEXT::eInverted
+                : vk::ConditionalRenderingFlagsEXT());
+
+        m_CurrentCmdBuf->cmdBuf.beginConditionalRenderingEXT(beginInfo);
+    }
+
+    void CommandList::endPredication()
+    {
+        endRenderPass();
+
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->cmdBuf.endConditionalRenderingEXT();
+    }
+
 
     void CommandList::beginMarker(const char* name)
     {
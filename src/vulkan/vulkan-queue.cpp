@@ -29,9 +29,154 @@ namespace nvrhi::vulkan
 
     TrackedCommandBuffer::~TrackedCommandBuffer()
     {
+        // the transient binding sets must not outlive their pools
+        referencedResources.clear();
+
+#ifndef NVRHI_WITH_RTXMU
+        releaseAccelStructQueries();
+#endif
+
+        for (vk::DescriptorPool pool : m_TransientDescriptorPools)
+            m_Context.device.destroyDescriptorPool(pool, m_Context.allocationCallbacks);
+        m_TransientDescriptorPools.clear();
+
+        for (vk::Event event : m_SplitBarrierEvents)
+            m_Context.device.destroyEvent(event, m_Context.allocationCallbacks);
+        m_SplitBarrierEvents.clear();
+
         m_Context.device.destroyCommandPool(cmdPool, m_Context.allocationCallbacks);
     }
 
+    void TrackedCommandBuffer::reset()
+    {
+        referencedResources.clear();
+        referencedStagingBuffers.clear();
+        resetTransientDescriptorPools();
+        releaseSplitBarrierEvents();
+        preprocessOffset = 0;
+        submissionID = 0;
+
+        m_Context.device.resetCommandPool(cmdPool);
+    }
+
+#ifndef NVRHI_WITH_RTXMU
+    void TrackedCommandBuffer::releaseAccelStructQueries()
+    {
+        // The compaction resources are destroyed before the queues and command lists when the device goes away
+        if (m_Context.accelStructCompaction)
+        {
+            for (const auto& query : compactedSizeQueries)
+                m_Context.accelStructCompaction->compactedSizeQueries.release(query.index);
+
+            for (int query : serializationSizeQueries)
+                m_Context.accelStructCompaction->serializationSizeQueries.release(query);
+        }
+
+        compactedSizeQueries.clear();
+        serializationSizeQueries.clear();
+    }
+#endif
+
+    vk::Result TrackedCommandBuffer::activateTransientDescriptorPool()
+    {
+        if (m_NumActiveTransientDescriptorPools < m_TransientDescriptorPools.size())
+        {
+            // reuse a pool that was reset when the command buffer was retired
+            ++m_NumActiveTransientDescriptorPools;
+            return vk::Result::eSuccess;
+        }
+
+        static_vector<vk::DescriptorPoolSize, 9> poolSizes;
+        for (vk::DescriptorType type : {
+            vk::DescriptorType::eSampledImage,
+            vk::DescriptorType::eStorageImage,
+            vk::DescriptorType::eUniformTexelBuffer,
+            vk::DescriptorType::eStorageTexelBuffer,
+            vk::DescriptorType::eStorageBuffer,
+            vk::DescriptorType::eUniformBuffer,
+            vk::DescriptorType::eUniformBufferDynamic,
+            vk::DescriptorType::eSampler })
+        {
+            poolSizes.push_back(vk::DescriptorPoolSize()
+                .setType(type)
+                .setDescriptorCount(c_TransientDescriptorPoolDescriptors));
+        }
+
+        if (m_Context.extensions.KHR_acceleration_structure)
+        {
+            poolSizes.push_back(vk::DescriptorPoolSize()
+                .setType(vk::DescriptorType::eAccelerationStructureKHR)
+                .setDescriptorCount(c_TransientDescriptorPoolDescriptors));
+        }
+
+        auto poolInfo = vk::DescriptorPoolCreateInfo()
+            .setPoolSizeCount(uint32_t(poolSizes.size()))
+            .setPPoolSizes(poolSizes.data())
+            .setMaxSets(c_TransientDescriptorPoolSets);
+
+        vk::DescriptorPool pool;
+        const vk::Result res = m_Context.device.createDescriptorPool(&poolInfo, m_Context.allocationCallbacks, &pool);
+        CHECK_VK_RETURN(res)
+
+        m_TransientDescriptorPools.push_back(pool);
+        m_NumActiveTransientDescriptorPools = m_TransientDescriptorPools.size();
+        return vk::Result::eSuccess;
+    }
+
+    vk::Result TrackedCommandBuffer::allocateTransientDescriptorSet(vk::DescriptorSetLayout layout, vk::DescriptorPool& outPool, vk::DescriptorSet& outSet)
+    {
+        if (m_NumActiveTransientDescriptorPools == 0)
+        {
+            const vk::Result res = activateTransientDescriptorPool();
+            CHECK_VK_RETURN(res)
+        }
+
+        auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
+            .setDescriptorPool(m_TransientDescriptorPools[m_NumActiveTransientDescriptorPools - 1])
+            .setDescriptorSetCount(1)
+            .setPSetLayouts(&layout);
+
+        vk::Result res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+
+        if (res == vk::Result::eErrorOutOfPoolMemory || res == vk::Result::eErrorFragmentedPool)
+        {
+            res = activateTransientDescriptorPool();
+            CHECK_VK_RETURN(res)
+
+            descriptorSetAllocInfo.setDescriptorPool(m_TransientDescriptorPools[m_NumActiveTransientDescriptorPools - 1]);
+            res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+        }
+        CHECK_VK_RETURN(res)
+
+        outPool = m_TransientDescriptorPools[m_NumActiveTransientDescriptorPools - 1];
+        return vk::Result::eSuccess;
+    }
+
+    void TrackedCommandBuffer::resetTransientDescriptorPools()
+    {
+        for (size_t i = 0; i < m_NumActiveTransientDescriptorPools; i++)
+            m_Context.device.resetDescriptorPool(m_TransientDescriptorPools[i]);
+
+        m_NumActiveTransientDescriptorPools = 0;
+    }
+
+    vk::Event TrackedCommandBuffer::acquireSplitBarrierEvent()
+    {
+        if (m_NumActiveSplitBarrierEvents < m_SplitBarrierEvents.size())
+            return m_SplitBarrierEvents[m_NumActiveSplitBarrierEvents++];
+
+        auto eventInfo = vk::EventCreateInfo()
+            .setFlags(vk::EventCreateFlagBits::eDeviceOnly);
+
+        vk::Event event;
+        const vk::Result res = m_Context.device.createEvent(&eventInfo, m_Context.allocationCallbacks, &event);
+        CHECK_VK_FAIL(res)
+
+        m_SplitBarrierEvents.push_back(event);
+        ++m_NumActiveSplitBarrierEvents;
+        return event;
+    }
+
     Queue::Queue(const VulkanContext& context, CommandQueue queueID, vk::Queue queue, uint32_t queueFamilyIndex)
         : m_Context(context)
         , m_Queue(queue)
@@ -61,8 +206,7 @@ namespace nvrhi::vulkan
 
         auto cmdPoolInfo = vk::CommandPoolCreateInfo()
                             .setQueueFamilyIndex(m_QueueFamilyIndex)
-                            .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer |
-                                        vk::CommandPoolCreateFlagBits::eTransient);
+                            .setFlags(vk::CommandPoolCreateFlagBits::eTransient);
 
         res = m_Context.device.createCommandPool(&cmdPoolInfo, m_Context.allocationCallbacks, &ret->cmdPool);
         CHECK_VK_FAIL(res)
@@ -79,23 +223,28 @@ namespace nvrhi::vulkan
         return ret;
     }
 
-    TrackedCommandBufferPtr Queue::getOrCreateCommandBuffer()
+    TrackedCommandBufferPtr Queue::getOrCreateCommandBuffer(std::vector<TrackedCommandBufferPtr>& pool)
     {
-        std::lock_guard lockGuard(m_Mutex); // this is called from CommandList::open, so free-threaded
-
-        uint64_t recordingID = ++m_LastRecordingID;
+        // This is called from CommandList::open, so free-threaded
+        uint64_t recordingID = m_LastRecordingID.fetch_add(1) + 1;
 
         TrackedCommandBufferPtr cmdBuf;
-        if (m_CommandBuffersPool.empty())
+        for (const TrackedCommandBufferPtr& candidate : pool)
         {
-            cmdBuf = createCommandBuffer();
+            if (candidate->retired.load(std::memory_order_acquire))
+            {
+                cmdBuf = candidate;
+                break;
+            }
         }
-        else
+
+        if (!cmdBuf)
         {
-            cmdBuf = m_CommandBuffersPool.front();
-            m_CommandBuffersPool.pop_front();
+            cmdBuf = createCommandBuffer();
+            pool.push_back(cmdBuf);
         }
 
+        cmdBuf->retired.store(false, std::memory_order_relaxed);
         cmdBuf->recordingID = recordingID;
         return cmdBuf;
     }
@@ -120,56 +269,119 @@ namespace nvrhi::vulkan
 
     uint64_t Queue::submit(ICommandList* const* ppCmd, size_t numCmd)
     {
-        std::vector<vk::PipelineStageFlags> waitStageArray(m_WaitSemaphores.size());
-        std::vector<vk::CommandBuffer> commandBuffers(numCmd);
+        QueueSubmitBatch batch;
+        batch.commandLists = ppCmd;
+        batch.numCommandLists = numCmd;
+        batch.submissionID = reserveSubmissionID();
+
+        submitBatches(&batch, 1);
+
+        return batch.submissionID;
+    }
 
-        for (size_t i = 0; i < m_WaitSemaphores.size(); i++)
+    void Queue::submitBatches(const QueueSubmitBatch* batches, size_t numBatches)
+    {
+        if (numBatches == 0)
+            return;
+
+        // Count everything first so that the arrays are not reallocated while the submit infos point into them
+        size_t totalCommandBuffers = 0;
+        size_t totalWaits = m_WaitSemaphores.size();
+        size_t totalSignals = m_SignalSemaphores.size() + numBatches;
+        for (size_t batchIndex = 0; batchIndex < numBatches; batchIndex++)
         {
-            waitStageArray[i] = vk::PipelineStageFlagBits::eTopOfPipe;
+            totalCommandBuffers += batches[batchIndex].numCommandLists;
+            totalWaits += batches[batchIndex].waitSemaphores.size();
         }
 
-        m_LastSubmittedID++;
-
-        for (size_t i = 0; i < numCmd; i++)
+        std::vector<vk::CommandBuffer> commandBuffers;
+        std::vector<vk::Semaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+        std::vector<vk::Semaphore> signalSemaphores;
+        std::vector<uint64_t> signalValues;
+        commandBuffers.reserve(totalCommandBuffers);
+        waitSemaphores.reserve(totalWaits);
+        waitValues.reserve(totalWaits);
+        signalSemaphores.reserve(totalSignals);
+        signalValues.reserve(totalSignals);
+        std::vector<vk::PipelineStageFlags> waitStageArray(totalWaits, vk::PipelineStageFlagBits::eTopOfPipe);
+
+        std::vector<vk::TimelineSemaphoreSubmitInfo> timelineSemaphoreInfos(numBatches);
+        std::vector<vk::SubmitInfo> submitInfos(numBatches);
+
+        for (size_t batchIndex = 0; batchIndex < numBatches; batchIndex++)
         {
-            CommandList* commandList = checked_cast<CommandList*>(ppCmd[i]);
-            TrackedCommandBufferPtr commandBuffer = commandList->getCurrentCmdBuf();
+            const QueueSubmitBatch& batch = batches[batchIndex];
+            assert(batch.submissionID != 0 && batch.submissionID <= m_LastSubmittedID);
 
-            commandBuffers[i] = commandBuffer->cmdBuf;
-            m_CommandBuffersInFlight.push_back(commandBuffer);
+            const size_t firstCommandBuffer = commandBuffers.size();
+            const size_t firstWait = waitSemaphores.size();
+            const size_t firstSignal = signalSemaphores.size();
 
-            for (const auto& buffer : commandBuffer->referencedStagingBuffers)
+            for (size_t i = 0; i < batch.numCommandLists; i++)
             {
-                buffer->lastUseQueue = m_QueueID;
-                buffer->lastUseCommandListID = m_LastSubmittedID;
+                CommandList* commandList = checked_cast<CommandList*>(batch.commandLists[i]);
+                TrackedCommandBufferPtr commandBuffer = commandList->getCurrentCmdBuf();
+
+                commandBuffers.push_back(commandBuffer->cmdBuf);
+                {
+                    // The ID has to be set before the garbage collector can see the command buffer
+                    std::lock_guard lockGuard(m_InFlightMutex);
+                    commandBuffer->submissionID = batch.submissionID;
+                    m_CommandBuffersInFlight.push_back(commandBuffer);
+                }
+
+                for (const auto& buffer : commandBuffer->referencedStagingBuffers)
+                {
+                    buffer->lastUseQueue = m_QueueID;
+                    buffer->lastUseCommandListID = batch.submissionID;
+                }
             }
-        }
-        
-        m_SignalSemaphores.push_back(trackingSemaphore);
-        m_SignalSemaphoreValues.push_back(m_LastSubmittedID);
 
-        auto timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
-            .setSignalSemaphoreValueCount(uint32_t(m_SignalSemaphoreValues.size()))
-            .setPSignalSemaphoreValues(m_SignalSemaphoreValues.data());
+            if (batchIndex == 0)
+            {
+                waitSemaphores.insert(waitSemaphores.end(), m_WaitSemaphores.begin(), m_WaitSemaphores.end());
+                waitValues.insert(waitValues.end(), m_WaitSemaphoreValues.begin(), m_WaitSemaphoreValues.end());
+            }
 
-        if (!m_WaitSemaphoreValues.empty()) 
-        {
-            timelineSemaphoreInfo.setWaitSemaphoreValueCount(uint32_t(m_WaitSemaphoreValues.size()));
-            timelineSemaphoreInfo.setPWaitSemaphoreValues(m_WaitSemaphoreValues.data());
-        }
+            waitSemaphores.insert(waitSemaphores.end(), batch.waitSemaphores.begin(), batch.waitSemaphores.end());
+            waitValues.insert(waitValues.end(), batch.waitValues.begin(), batch.waitValues.end());
+
+            if (batchIndex == numBatches - 1)
+            {
+                signalSemaphores.insert(signalSemaphores.end(), m_SignalSemaphores.begin(), m_SignalSemaphores.end());
+                signalValues.insert(signalValues.end(), m_SignalSemaphoreValues.begin(), m_SignalSemaphoreValues.end());
+            }
+
+            signalSemaphores.push_back(trackingSemaphore);
+            signalValues.push_back(batch.submissionID);
+
+            const uint32_t numWaits = uint32_t(waitSemaphores.size() - firstWait);
+            const uint32_t numSignals = uint32_t(signalSemaphores.size() - firstSignal);
 
-        auto submitInfo = vk::SubmitInfo()
-            .setPNext(&timelineSemaphoreInfo)
-            .setCommandBufferCount(uint32_t(numCmd))
-            .setPCommandBuffers(commandBuffers.data())
-            .setWaitSemaphoreCount(uint32_t(m_WaitSemaphores.size()))
-            .setPWaitSemaphores(m_WaitSemaphores.empty() ? nullptr : m_WaitSemaphores.data())
-            .setPWaitDstStageMask(waitStageArray.data())
-            .setSignalSemaphoreCount(uint32_t(m_SignalSemaphores.size()))
-            .setPSignalSemaphores(m_SignalSemaphores.empty() ? nullptr : m_SignalSemaphores.data());
+            timelineSemaphoreInfos[batchIndex] = vk::TimelineSemaphoreSubmitInfo()
+                .setSignalSemaphoreValueCount(numSignals)
+                .setPSignalSemaphoreValues(signalValues.data() + firstSignal);
+
+            if (numWaits != 0)
+            {
+                timelineSemaphoreInfos[batchIndex].setWaitSemaphoreValueCount(numWaits);
+                timelineSemaphoreInfos[batchIndex].setPWaitSemaphoreValues(waitValues.data() + firstWait);
+            }
+
+            submitInfos[batchIndex] = vk::SubmitInfo()
+                .setPNext(&timelineSemaphoreInfos[batchIndex])
+                .setCommandBufferCount(uint32_t(batch.numCommandLists))
+                .setPCommandBuffers(batch.numCommandLists ? commandBuffers.data() + firstCommandBuffer : nullptr)
+                .setWaitSemaphoreCount(numWaits)
+                .setPWaitSemaphores(numWaits ? waitSemaphores.data() + firstWait : nullptr)
+                .setPWaitDstStageMask(numWaits ? waitStageArray.data() + firstWait : nullptr)
+                .setSignalSemaphoreCount(numSignals)
+                .setPSignalSemaphores(signalSemaphores.data() + firstSignal);
+        }
 
         try {
-            m_Queue.submit(submitInfo);
+            m_Queue.submit(submitInfos);
         }
         catch (vk::DeviceLostError&)
         {
@@ -180,158 +392,249 @@ namespace nvrhi::vulkan
         m_WaitSemaphoreValues.clear();
         m_SignalSemaphores.clear();
         m_SignalSemaphoreValues.clear();
-        
-        return m_LastSubmittedID;
     }
 
-    void Queue::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings)
+    void Queue::updateTextureTileMappings(const TextureTilesMappingUpdate* updates, uint32_t numUpdates)
     {
-        Texture* texture = checked_cast<Texture*>(_texture);
-
+        // The binds of all textures are collected first because the bind infos point into these arrays
         std::vector<vk::SparseImageMemoryBind> sparseImageMemoryBinds;
         std::vector<vk::SparseMemoryBind> sparseMemoryBinds;
 
-        vk::ImageCreateInfo& imageInfo = texture->imageInfo;
-		vk::ImageAspectFlags textureAspectFlags = guessImageAspectFlags(imageInfo.format);
+        struct TextureBindRanges
+        {
+            vk::Image image;
+            size_t firstImageBind = 0;
+            size_t numImageBinds = 0;
+            size_t firstOpaqueBind = 0;
+            size_t numOpaqueBinds = 0;
+        };
+        std::vector<TextureBindRanges> textureBindRanges;
+        textureBindRanges.reserve(numUpdates);
+
+        for (uint32_t updateIndex = 0; updateIndex < numUpdates; updateIndex++)
+        {
+            Texture* texture = checked_cast<Texture*>(updates[updateIndex].texture);
+            const TextureTilesMapping* tileMappings = updates[updateIndex].tileMappings;
+            const uint32_t numTileMappings = updates[updateIndex].numTileMappings;
 
-		// Required for extent and offset since they must be multiples of the tile dimensions
-		uint32_t tileWidth = 1;
-		uint32_t tileHeight = 1;
-		uint32_t tileDepth = 1;
+            TextureBindRanges& ranges = textureBindRanges.emplace_back();
+            ranges.image = texture->image;
+            ranges.firstImageBind = sparseImageMemoryBinds.size();
+            ranges.firstOpaqueBind = sparseMemoryBinds.size();
 
-        // Mip tail info, required for resource offset
-        vk::DeviceSize imageMipTailOffset = 0;
+            vk::ImageCreateInfo& imageInfo = texture->imageInfo;
+            vk::ImageAspectFlags textureAspectFlags = guessImageAspectFlags(imageInfo.format);
 
-        std::vector<vk::SparseImageFormatProperties> formatProperties = m_Context.physicalDevice.getSparseImageFormatProperties(imageInfo.format, imageInfo.imageType, imageInfo.samples, imageInfo.usage, imageInfo.tiling);
-		std::vector<vk::SparseImageMemoryRequirements> memoryRequirements = m_Context.device.getImageSparseMemoryRequirements(texture->image);
+            // Required for extent and offset since they must be multiples of the tile dimensions
+            uint32_t tileWidth = 1;
+            uint32_t tileHeight = 1;
+            uint32_t tileDepth = 1;
 
-		if (!formatProperties.empty())
-		{
-			tileWidth = formatProperties[0].imageGranularity.width;
-			tileHeight = formatProperties[0].imageGranularity.height;
-			tileDepth = formatProperties[0].imageGranularity.depth;
-		}
+            // Mip tail info, required for resource offset
+            vk::DeviceSize imageMipTailOffset = 0;
 
-        if (!memoryRequirements.empty())
-        {
-			imageMipTailOffset = memoryRequirements[0].imageMipTailOffset;
-        }
+            std::vector<vk::SparseImageFormatProperties> formatProperties = m_Context.physicalDevice.getSparseImageFormatProperties(imageInfo.format, imageInfo.imageType, imageInfo.samples, imageInfo.usage, imageInfo.tiling);
+            std::vector<vk::SparseImageMemoryRequirements> memoryRequirements = m_Context.device.getImageSparseMemoryRequirements(texture->image);
 
-        for (size_t i = 0; i < numTileMappings; i++)
-        {
-            uint32_t numRegions = tileMappings[i].numTextureRegions;
-            Heap* heap = tileMappings[i].heap ? checked_cast<Heap*>(tileMappings[i].heap) : nullptr;
-            vk::DeviceMemory deviceMemory = heap ? heap->memory : VK_NULL_HANDLE;
+            if (!formatProperties.empty())
+            {
+                tileWidth = formatProperties[0].imageGranularity.width;
+                tileHeight = formatProperties[0].imageGranularity.height;
+                tileDepth = formatProperties[0].imageGranularity.depth;
+            }
 
-            for (uint32_t j = 0; j < numRegions; ++j)
+            if (!memoryRequirements.empty())
             {
-                const TiledTextureCoordinate& tiledTextureCoordinate = tileMappings[i].tiledTextureCoordinates[j];
-                const TiledTextureRegion& tiledTextureRegion = tileMappings[i].tiledTextureRegions[j];
+                imageMipTailOffset = memoryRequirements[0].imageMipTailOffset;
+            }
 
-                if (tiledTextureRegion.tilesNum)
-                {
-                    sparseMemoryBinds.push_back(vk::SparseMemoryBind()
-                        .setResourceOffset(imageMipTailOffset + tiledTextureCoordinate.arrayLevel * imageMipTailOffset)
-                        .setSize(tiledTextureRegion.tilesNum * texture->tileByteSize)
-                        .setMemory(deviceMemory)
-                        .setMemoryOffset(deviceMemory ? tileMappings[i].byteOffsets[j] : 0));
-                }
-                else
+            for (size_t i = 0; i < numTileMappings; i++)
+            {
+                uint32_t numRegions = tileMappings[i].numTextureRegions;
+                Heap* heap = tileMappings[i].heap ? checked_cast<Heap*>(tileMappings[i].heap) : nullptr;
+                vk::DeviceMemory deviceMemory = heap ? heap->memory : VK_NULL_HANDLE;
+
+                for (uint32_t j = 0; j < numRegions; ++j)
                 {
-                    vk::ImageSubresource subresource = {};
-                    subresource.arrayLayer = tiledTextureCoordinate.arrayLevel;
-                    subresource.mipLevel = tiledTextureCoordinate.mipLevel;
-					subresource.aspectMask = textureAspectFlags; // Required for sparse binding
-
-                    vk::Offset3D offset3D;
-                    offset3D.x = tiledTextureCoordinate.x * tileWidth;
-                    offset3D.y = tiledTextureCoordinate.y * tileHeight;
-                    offset3D.z = tiledTextureCoordinate.z * tileHeight;
-
-                    vk::Extent3D extent3D;
-                    extent3D.width = tiledTextureRegion.width * tileWidth;
-                    extent3D.height = tiledTextureRegion.height * tileHeight;
-                    extent3D.depth = tiledTextureRegion.depth * tileDepth;
-
-                    sparseImageMemoryBinds.push_back(vk::SparseImageMemoryBind()
-                        .setSubresource(subresource)
-                        .setOffset(offset3D)
-                        .setExtent(extent3D)
-                        .setMemory(deviceMemory)
-                        .setMemoryOffset(deviceMemory ? tileMappings[i].byteOffsets[j] : 0));
+                    const TiledTextureCoordinate& tiledTextureCoordinate = tileMappings[i].tiledTextureCoordinates[j];
+                    const TiledTextureRegion& tiledTextureRegion = tileMappings[i].tiledTextureRegions[j];
+
+                    if (tiledTextureRegion.tilesNum)
+                    {
+                        sparseMemoryBinds.push_back(vk::SparseMemoryBind()
+                            .setResourceOffset(imageMipTailOffset + tiledTextureCoordinate.arrayLevel * imageMipTailOffset)
+                            .setSize(tiledTextureRegion.tilesNum * texture->tileByteSize)
+                            .setMemory(deviceMemory)
+                            .setMemoryOffset(deviceMemory ? tileMappings[i].byteOffsets[j] : 0));
+                    }
+                    else
+                    {
+                        vk::ImageSubresource subresource = {};
+                        subresource.arrayLayer = tiledTextureCoordinate.arrayLevel;
+                        subresource.mipLevel = tiledTextureCoordinate.mipLevel;
+                        subresource.aspectMask = textureAspectFlags; // Required for sparse binding
+
+                        vk::Offset3D offset3D;
+                        offset3D.x = tiledTextureCoordinate.x * tileWidth;
+                        offset3D.y = tiledTextureCoordinate.y * tileHeight;
+                        offset3D.z = tiledTextureCoordinate.z * tileDepth;
+
+                        vk::Extent3D extent3D;
+                        extent3D.width = tiledTextureRegion.width * tileWidth;
+                        extent3D.height = tiledTextureRegion.height * tileHeight;
+                        extent3D.depth = tiledTextureRegion.depth * tileDepth;
+
+                        sparseImageMemoryBinds.push_back(vk::SparseImageMemoryBind()
+                            .setSubresource(subresource)
+                            .setOffset(offset3D)
+                            .setExtent(extent3D)
+                            .setMemory(deviceMemory)
+                            .setMemoryOffset(deviceMemory ? tileMappings[i].byteOffsets[j] : 0));
+                    }
                 }
             }
+
+            ranges.numImageBinds = sparseImageMemoryBinds.size() - ranges.firstImageBind;
+            ranges.numOpaqueBinds = sparseMemoryBinds.size() - ranges.firstOpaqueBind;
         }
 
-        vk::BindSparseInfo bindSparseInfo = {};
+        std::vector<vk::SparseImageMemoryBindInfo> sparseImageMemoryBindInfos;
+        std::vector<vk::SparseImageOpaqueMemoryBindInfo> sparseImageOpaqueMemoryBindInfos;
 
-        vk::SparseImageMemoryBindInfo sparseImageMemoryBindInfo;
-        if (!sparseImageMemoryBinds.empty())
+        for (const TextureBindRanges& ranges : textureBindRanges)
         {
-            sparseImageMemoryBindInfo.setImage(texture->image);
-            sparseImageMemoryBindInfo.setBinds(sparseImageMemoryBinds);
-            bindSparseInfo.setImageBinds(sparseImageMemoryBindInfo);
-        }
+            if (ranges.numImageBinds)
+            {
+                sparseImageMemoryBindInfos.push_back(vk::SparseImageMemoryBindInfo()
+                    .setImage(ranges.image)
+                    .setBindCount(uint32_t(ranges.numImageBinds))
+                    .setPBinds(sparseImageMemoryBinds.data() + ranges.firstImageBind));
+            }
 
-        vk::SparseImageOpaqueMemoryBindInfo sparseImageOpaqueMemoryBindInfo;
-        if (!sparseMemoryBinds.empty())
-        {
-            sparseImageOpaqueMemoryBindInfo.setImage(texture->image);
-            sparseImageOpaqueMemoryBindInfo.setBinds(sparseMemoryBinds);
-            bindSparseInfo.setImageOpaqueBinds(sparseImageOpaqueMemoryBindInfo);
+            if (ranges.numOpaqueBinds)
+            {
+                sparseImageOpaqueMemoryBindInfos.push_back(vk::SparseImageOpaqueMemoryBindInfo()
+                    .setImage(ranges.image)
+                    .setBindCount(uint32_t(ranges.numOpaqueBinds))
+                    .setPBinds(sparseMemoryBinds.data() + ranges.firstOpaqueBind));
+            }
         }
 
+        if (sparseImageMemoryBindInfos.empty() && sparseImageOpaqueMemoryBindInfos.empty())
+            return;
+
+        vk::BindSparseInfo bindSparseInfo = {};
+        bindSparseInfo.setImageBinds(sparseImageMemoryBindInfos);
+        bindSparseInfo.setImageOpaqueBinds(sparseImageOpaqueMemoryBindInfos);
+
         m_Queue.bindSparse(bindSparseInfo, vk::Fence());
     }
 
     uint64_t Queue::updateLastFinishedID()
     {
-        m_LastFinishedID = m_Context.device.getSemaphoreCounterValue(trackingSemaphore);
+        uint64_t lastFinishedID = m_Context.device.getSemaphoreCounterValue(trackingSemaphore);
+        m_LastFinishedID.store(lastFinishedID, std::memory_order_relaxed);
 
-        return m_LastFinishedID;
+        return lastFinishedID;
     }
 
-    void Queue::retireCommandBuffers()
+    bool Queue::retireCommandBuffers(GarbageCollectionBudgetTracker* budget)
     {
-        std::list<TrackedCommandBufferPtr> submissions = std::move(m_CommandBuffersInFlight);
-
         uint64_t lastFinishedID = updateLastFinishedID();
-        
-        for (const TrackedCommandBufferPtr& cmd : submissions)
+
+        // Take the finished command buffers out of the list so that other threads can keep submitting
+        // while the objects they reference are being released
+        std::list<TrackedCommandBufferPtr> finished;
         {
-            if (cmd->submissionID <= lastFinishedID)
+            std::lock_guard lockGuard(m_InFlightMutex);
+
+            for (auto it = m_CommandBuffersInFlight.begin(); it != m_CommandBuffersInFlight.end(); )
             {
-                cmd->referencedResources.clear();
-                cmd->referencedStagingBuffers.clear();
-                cmd->submissionID = 0;
-                m_CommandBuffersPool.push_back(cmd);
+                auto current = it++;
+                if ((*current)->submissionID <= lastFinishedID)
+                    finished.splice(finished.end(), m_CommandBuffersInFlight, current);
+            }
+        }
+
+        auto it = finished.begin();
+        while (it != finished.end())
+        {
+            const TrackedCommandBufferPtr& cmd = *it;
+            ++it;
+
+            if (budget)
+                budget->objectsReleased(cmd->referencedResources.size() + cmd->referencedStagingBuffers.size());
+
+            cmd->reset();
 
 #ifdef NVRHI_WITH_RTXMU
-                if (!cmd->rtxmuBuildIds.empty())
-                {
-                    std::lock_guard lockGuard(m_Context.rtxMuResources->asListMutex);
-                    
-                    m_Context.rtxMuResources->asBuildsCompleted.insert(m_Context.rtxMuResources->asBuildsCompleted.end(),
-                        cmd->rtxmuBuildIds.begin(), cmd->rtxmuBuildIds.end());
+            if (!cmd->rtxmuBuildIds.empty())
+            {
+                std::lock_guard lockGuard(m_Context.rtxMuResources->asListMutex);
+                
+                m_Context.rtxMuResources->asBuildsCompleted.insert(m_Context.rtxMuResources->asBuildsCompleted.end(),
+                    cmd->rtxmuBuildIds.begin(), cmd->rtxmuBuildIds.end());
 
-                    cmd->rtxmuBuildIds.clear();
-                }
-                if (!cmd->rtxmuCompactionIds.empty())
+                cmd->rtxmuBuildIds.clear();
+            }
+            if (!cmd->rtxmuCompactionIds.empty())
+            {
+                m_Context.rtxMemUtil->GarbageCollection(cmd->rtxmuCompactionIds);
+                cmd->rtxmuCompactionIds.clear();
+            }
+#else
+            if (!cmd->compactedSizeQueries.empty())
+            {
+                AccelStructCompactionResources& compaction = *m_Context.accelStructCompaction;
+                std::lock_guard lockGuard(compaction.mutex);
+
+                for (const auto& query : cmd->compactedSizeQueries)
                 {
-                    m_Context.rtxMemUtil->GarbageCollection(cmd->rtxmuCompactionIds);
-                    cmd->rtxmuCompactionIds.clear();
+                    uint64_t compactedSize = 0;
+                    const vk::Result res = m_Context.device.getQueryPoolResults(compaction.compactedSizeQueryPool,
+                        uint32_t(query.index), 1, sizeof(compactedSize), &compactedSize, sizeof(compactedSize),
+                        vk::QueryResultFlagBits::e64);
+
+                    if (res == vk::Result::eSuccess)
+                    {
+                        checked_cast<AccelStruct*>(query.accelStruct.Get())->compactedSize = compactedSize;
+                        compaction.compactionsReady.push_back(query.accelStruct);
+                    }
+
+                    compaction.compactedSizeQueries.release(query.index);
                 }
-#endif
+
+                cmd->compactedSizeQueries.clear();
             }
-            else
+
+            if (!cmd->serializationSizeQueries.empty())
             {
-                m_CommandBuffersInFlight.push_back(cmd);
+                for (int query : cmd->serializationSizeQueries)
+                    m_Context.accelStructCompaction->serializationSizeQueries.release(query);
+
+                cmd->serializationSizeQueries.clear();
             }
+#endif
+
+            cmd->retired.store(true, std::memory_order_release);
+
+            if (budget && budget->isExhausted())
+                break;
         }
+
+        if (it == finished.end())
+            return true;
+
+        // Out of budget, the remaining command buffers are retired by the next call
+        std::lock_guard lockGuard(m_InFlightMutex);
+        m_CommandBuffersInFlight.splice(m_CommandBuffersInFlight.begin(), finished, it, finished.end());
+        return false;
     }
 
     TrackedCommandBufferPtr Queue::getCommandBufferInFlight(uint64_t submissionID)
     {
+        std::lock_guard lockGuard(m_InFlightMutex);
+
         for (const TrackedCommandBufferPtr& cmd : m_CommandBuffersInFlight)
         {
             if (cmd->submissionID == submissionID)
@@ -371,7 +674,19 @@ namespace nvrhi::vulkan
     {
         Queue& queue = *m_Queues[uint32_t(executionQueue)];
 
-        queue.updateTextureTileMappings(texture, tileMappings, numTileMappings);
+        TextureTilesMappingUpdate update;
+        update.texture = texture;
+        update.tileMappings = tileMappings;
+        update.numTileMappings = numTileMappings;
+
+        queue.updateTextureTileMappings(&update, 1);
+    }
+
+    void Device::updateTextureTileMappingsBatch(const TextureTilesMappingUpdate* updates, uint32_t numUpdates, CommandQueue executionQueue)
+    {
+        Queue& queue = *m_Queues[uint32_t(executionQueue)];
+
+        queue.updateTextureTileMappings(updates, numUpdates);
     }
 
     uint64_t Device::queueGetCompletedInstance(CommandQueue queue)
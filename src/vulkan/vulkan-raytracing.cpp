@@ -23,6 +23,7 @@
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
 #include <sstream>
+#include <algorithm>
 
 namespace nvrhi::vulkan
 {
@@ -321,6 +322,50 @@ namespace nvrhi::vulkan
         return rt::OpacityMicromapHandle::Create(om);
     }
 
+    static vk::AccelerationStructureBuildSizesInfoKHR getAccelStructBuildSizesInternal(const rt::AccelStructDesc& desc, const VulkanContext& context)
+    {
+        std::vector<vk::AccelerationStructureGeometryKHR> geometries;
+        std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
+        std::vector<vk::AccelerationStructureGeometryLinearSweptSpheresDataNV> lss;
+        std::vector<uint32_t> maxPrimitiveCounts;
+
+        auto buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR();
+
+        if (desc.isTopLevel)
+        {
+            geometries.push_back(vk::AccelerationStructureGeometryKHR()
+                .setGeometryType(vk::GeometryTypeKHR::eInstances));
+
+            geometries[0].geometry.setInstances(vk::AccelerationStructureGeometryInstancesDataKHR());
+
+            maxPrimitiveCounts.push_back(uint32_t(desc.topLevelMaxInstances));
+
+            buildInfo.setType(vk::AccelerationStructureTypeKHR::eTopLevel);
+        }
+        else
+        {
+            geometries.resize(desc.bottomLevelGeometries.size());
+            omms.resize(desc.bottomLevelGeometries.size());
+            lss.resize(desc.bottomLevelGeometries.size());
+            maxPrimitiveCounts.resize(desc.bottomLevelGeometries.size());
+
+            for (size_t i = 0; i < desc.bottomLevelGeometries.size(); i++)
+            {
+                convertBottomLevelGeometry(desc.bottomLevelGeometries[i], geometries[i], omms[i], lss[i], maxPrimitiveCounts[i],
+                    nullptr, context, nullptr, 0);
+            }
+
+            buildInfo.setType(vk::AccelerationStructureTypeKHR::eBottomLevel);
+        }
+
+        buildInfo.setMode(vk::BuildAccelerationStructureModeKHR::eBuild)
+            .setGeometries(geometries)
+            .setFlags(convertAccelStructBuildFlags(desc.buildFlags));
+
+        return context.device.getAccelerationStructureBuildSizesKHR(
+            vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
+    }
+
     rt::AccelStructHandle Device::createAccelStruct(const rt::AccelStructDesc& desc)
     {
         AccelStruct* as = new AccelStruct(m_Context);
@@ -335,46 +380,7 @@ namespace nvrhi::vulkan
 
         if (isManaged)
         {
-            std::vector<vk::AccelerationStructureGeometryKHR> geometries;
-            std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
-            std::vector<vk::AccelerationStructureGeometryLinearSweptSpheresDataNV> lss;
-            std::vector<uint32_t> maxPrimitiveCounts;
-
-            auto buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR();
-
-            if (desc.isTopLevel)
-            {
-                geometries.push_back(vk::AccelerationStructureGeometryKHR()
-                    .setGeometryType(vk::GeometryTypeKHR::eInstances));
-
-                geometries[0].geometry.setInstances(vk::AccelerationStructureGeometryInstancesDataKHR());
-
-                maxPrimitiveCounts.push_back(uint32_t(desc.topLevelMaxInstances));
-
-                buildInfo.setType(vk::AccelerationStructureTypeKHR::eTopLevel);
-            }
-            else
-            {
-                geometries.resize(desc.bottomLevelGeometries.size());
-                omms.resize(desc.bottomLevelGeometries.size());
-                lss.resize(desc.bottomLevelGeometries.size());
-                maxPrimitiveCounts.resize(desc.bottomLevelGeometries.size());
-
-                for (size_t i = 0; i < desc.bottomLevelGeometries.size(); i++)
-                {
-                    convertBottomLevelGeometry(desc.bottomLevelGeometries[i], geometries[i], omms[i], lss[i], maxPrimitiveCounts[i],
-                        nullptr, m_Context, nullptr, 0);
-                }
-
-                buildInfo.setType(vk::AccelerationStructureTypeKHR::eBottomLevel);
-            }
-
-            buildInfo.setMode(vk::BuildAccelerationStructureModeKHR::eBuild)
-                .setGeometries(geometries)
-                .setFlags(convertAccelStructBuildFlags(desc.buildFlags));
-
-            auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
-                vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
+            auto buildSizes = getAccelStructBuildSizesInternal(desc, m_Context);
 
             BufferDesc bufferDesc;
             bufferDesc.byteSize = buildSizes.accelerationStructureSize;
@@ -403,6 +409,18 @@ namespace nvrhi::vulkan
             }
         }
 
+        if (desc.isTopLevel && desc.persistentInstanceBuffer)
+        {
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = std::max<size_t>(desc.topLevelMaxInstances, 1) * sizeof(vk::AccelerationStructureInstanceKHR);
+            bufferDesc.debugName = desc.debugName + " instances";
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.initialState = ResourceStates::AccelStructBuildInput;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.isAccelStructBuildInput = true;
+            as->instanceBuffer = createBuffer(bufferDesc);
+        }
+
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the Desc
         for (auto& geometry : as->desc.bottomLevelGeometries)
         {
@@ -439,6 +457,37 @@ namespace nvrhi::vulkan
         return MemoryRequirements();
     }
 
+    rt::AccelStructBuildSizes Device::getAccelStructBuildSizes(const rt::AccelStructDesc& desc)
+    {
+        if (!m_Context.extensions.KHR_acceleration_structure)
+            return rt::AccelStructBuildSizes();
+
+        auto buildSizes = getAccelStructBuildSizesInternal(desc, m_Context);
+
+        rt::AccelStructBuildSizes sizes;
+        sizes.resultSize = buildSizes.accelerationStructureSize;
+        sizes.buildScratchSize = buildSizes.buildScratchSize;
+        sizes.updateScratchSize = buildSizes.updateScratchSize;
+        return sizes;
+    }
+
+    bool Device::isSerializedAccelStructCompatible(const rt::AccelStructSerializedHeader& header)
+    {
+        if (!m_Context.extensions.KHR_acceleration_structure)
+            return false;
+
+        // The version data is the driver UUID followed by the compatibility UUID
+        static_assert(sizeof(header.driverIdentifier) == 2 * VK_UUID_SIZE);
+
+        auto versionInfo = vk::AccelerationStructureVersionInfoKHR()
+            .setPVersionData(header.driverIdentifier);
+
+        vk::AccelerationStructureCompatibilityKHR const compatibility =
+            m_Context.device.getAccelerationStructureCompatibilityKHR(versionInfo);
+
+        return compatibility == vk::AccelerationStructureCompatibilityKHR::eCompatible;
+    }
+
     static vk::ClusterAccelerationStructureTypeNV convertClusterAccelerationStructureType(rt::cluster::OperationMoveType type)
     {
         switch (type)
@@ -648,7 +697,7 @@ namespace nvrhi::vulkan
             uint64_t scratchOffset = 0;
             uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-            bool allocated = m_ScratchManager->suballocateBuffer(buildSize.buildScratchSize, &scratchBuffer, &scratchOffset, nullptr,
+            bool allocated = suballocateScratchBuffer(buildSize.buildScratchSize, &scratchBuffer, &scratchOffset,
                 currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
 
             if (!allocated)
@@ -667,33 +716,25 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.buildMicromapsEXT(1, &buildInfo);
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    bool CommandList::prepareBottomLevelAccelStructBuild(AccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries,
+        rt::AccelStructBuildFlags buildFlags, uint64_t currentVersion, BottomLevelBuild& build)
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
-
         const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
         if (performUpdate)
         {
             assert(as->allowUpdate);
         }
 
-        std::vector<vk::AccelerationStructureGeometryKHR> geometries;
-        std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
-        std::vector<vk::AccelerationStructureGeometryLinearSweptSpheresDataNV> lss;
-        std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
-        std::vector<uint32_t> maxPrimitiveCounts;
-        geometries.resize(numGeometries);
-        omms.resize(numGeometries);
-        lss.resize(numGeometries);
-        maxPrimitiveCounts.resize(numGeometries);
-        buildRanges.resize(numGeometries);
-
-        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+        build.geometries.resize(numGeometries);
+        build.omms.resize(numGeometries);
+        build.lss.resize(numGeometries);
+        build.maxPrimitiveCounts.resize(numGeometries);
+        build.buildRanges.resize(numGeometries);
 
         for (size_t i = 0; i < numGeometries; i++)
         {
-            convertBottomLevelGeometry(pGeometries[i], geometries[i], omms[i], lss[i], maxPrimitiveCounts[i], &buildRanges[i],
-                m_Context, m_UploadManager.get(), currentVersion);
+            convertBottomLevelGeometry(pGeometries[i], build.geometries[i], build.omms[i], build.lss[i], build.maxPrimitiveCounts[i],
+                &build.buildRanges[i], m_Context, m_UploadManager.get(), currentVersion);
 
             const rt::GeometryDesc& src = pGeometries[i];
 
@@ -740,25 +781,86 @@ namespace nvrhi::vulkan
 
         m_BindingStatesDirty = true;
 
-        auto buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR()
+        build.buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR()
             .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
             .setMode(performUpdate ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild)
-            .setGeometries(geometries)
+            .setGeometries(build.geometries)
             .setFlags(convertAccelStructBuildFlags(buildFlags))
             .setDstAccelerationStructure(as->accelStruct);
 
         if (as->allowUpdate)
-            buildInfo.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+            build.buildInfo.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
 
         if (performUpdate)
-            buildInfo.setSrcAccelerationStructure(as->accelStruct);
+            build.buildInfo.setSrcAccelerationStructure(as->accelStruct);
+
+#ifndef NVRHI_WITH_RTXMU
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+        }
+
+        auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
+            vk::AccelerationStructureBuildTypeKHR::eDevice, build.buildInfo, build.maxPrimitiveCounts);
+
+        if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
+        {
+            std::stringstream ss;
+            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
+                << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
+                << as->dataBuffer->getDesc().byteSize << " bytes";
+
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        size_t scratchSize = performUpdate
+            ? buildSizes.updateScratchSize
+            : buildSizes.buildScratchSize;
+
+        Buffer* scratchBuffer = nullptr;
+        uint64_t scratchOffset = 0;
+
+        // Consecutive builds are packed into the same scratch chunk by the linear suballocator
+        bool allocated = suballocateScratchBuffer(scratchSize, &scratchBuffer, &scratchOffset,
+            currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
+
+        if (!allocated)
+        {
+            std::stringstream ss;
+            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
+                "The build requires " << scratchSize << " bytes of scratch space.";
+
+            m_Context.error(ss.str());
+            return false;
+        }
+        
+        assert(scratchBuffer->deviceAddress);
+        build.buildInfo.setScratchData(scratchBuffer->deviceAddress + scratchOffset);
+
+        build.queryCompactedSize = (buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0 && !performUpdate
+            && m_Context.accelStructCompaction;
+#endif
+
+        return true;
+    }
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+
+        BottomLevelBuild build;
+        if (!prepareBottomLevelAccelStructBuild(as, pGeometries, numGeometries, buildFlags, currentVersion, build))
+            return;
         
 #ifdef NVRHI_WITH_RTXMU
         commitBarriers();
 
-        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
-        std::array<const uint32_t*, 1> maxPrimArrays = { maxPrimitiveCounts.data() };
+        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { build.buildInfo };
+        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { build.buildRanges.data() };
+        std::array<const uint32_t*, 1> maxPrimArrays = { build.maxPrimitiveCounts.data() };
 
         if(as->rtxmuId == ~0ull)
         {
@@ -791,59 +893,268 @@ namespace nvrhi::vulkan
                                                             buildsToUpdate);
         }
 #else
+        commitBarriers();
 
-        if (m_EnableAutomaticBarriers)
+        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { build.buildInfo };
+        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { build.buildRanges.data() };
+
+        m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
+
+        if (build.queryCompactedSize)
+            writeCompactedSizeQueries(&as, 1);
+#endif
+        if (as->desc.trackLiveness)
+            m_CurrentCmdBuf->referencedResources.push_back(as);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* pBuilds, size_t numBuilds)
+    {
+#ifdef NVRHI_WITH_RTXMU
+        // RTXMU manages the BLAS storage and scratch memory itself, so the builds are forwarded one by one
+        for (size_t i = 0; i < numBuilds; i++)
         {
-            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            const rt::BlasBuildDesc& desc = pBuilds[i];
+            buildBottomLevelAccelStruct(desc.accelStruct, desc.geometries, desc.numGeometries, desc.buildFlags);
         }
-        commitBarriers();
+#else
+        uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-        auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
-            vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
+        // The builds keep their geometry arrays on the heap, so moving them around while growing the vector
+        // doesn't invalidate the pointers stored in the build infos
+        std::vector<BottomLevelBuild> builds;
+        builds.reserve(numBuilds);
 
-        if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
+        std::vector<AccelStruct*> compactableAccelStructs;
+
+        for (size_t i = 0; i < numBuilds; i++)
         {
-            std::stringstream ss;
-            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
-                << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->getDesc().byteSize << " bytes";
+            const rt::BlasBuildDesc& desc = pBuilds[i];
+            AccelStruct* as = checked_cast<AccelStruct*>(desc.accelStruct);
 
-            m_Context.error(ss.str());
+            BottomLevelBuild& build = builds.emplace_back();
+            if (!prepareBottomLevelAccelStructBuild(as, desc.geometries, desc.numGeometries, desc.buildFlags, currentVersion, build))
+            {
+                builds.pop_back();
+                continue;
+            }
+
+            if (build.queryCompactedSize)
+                compactableAccelStructs.push_back(as);
+
+            if (as->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.push_back(as);
+        }
+
+        if (builds.empty())
             return;
+
+        // All state transitions for the batch are committed together, and the builds are recorded with a single
+        // command so that the driver can overlap them
+        commitBarriers();
+
+        std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos;
+        std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> buildRangeArrays;
+        buildInfos.reserve(builds.size());
+        buildRangeArrays.reserve(builds.size());
+
+        for (const BottomLevelBuild& build : builds)
+        {
+            buildInfos.push_back(build.buildInfo);
+            buildRangeArrays.push_back(build.buildRanges.data());
         }
 
-        size_t scratchSize = performUpdate
-            ? buildSizes.updateScratchSize
-            : buildSizes.buildScratchSize;
+        m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
 
-        Buffer* scratchBuffer = nullptr;
-        uint64_t scratchOffset = 0;
+        if (!compactableAccelStructs.empty())
+            writeCompactedSizeQueries(compactableAccelStructs.data(), compactableAccelStructs.size());
+#endif
+    }
 
-        bool allocated = m_ScratchManager->suballocateBuffer(scratchSize, &scratchBuffer, &scratchOffset, nullptr,
-            currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
+    bool CommandList::suballocateScratchBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, uint64_t currentVersion, uint32_t alignment)
+    {
+        if (!m_ScratchManager->suballocateBuffer(size, pBuffer, pOffset, nullptr, currentVersion, alignment))
+            return false;
 
-        if (!allocated)
+        if (m_ScratchManager->takeReusedChunkBarrier())
         {
-            std::stringstream ss;
-            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
-                "The build requires " << scratchSize << " bytes of scratch space.";
+            // The chunk came from the shared scratch pool while an earlier submission may still be building with it
+            auto memoryBarrier = vk::MemoryBarrier2()
+                .setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+                .setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite);
+
+            vk::DependencyInfo dep_info;
+            dep_info.setMemoryBarriers(memoryBarrier);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+        }
+
+        return true;
+    }
+
+    void CommandList::writeAccelStructSerializedSize(rt::IAccelStruct* _as, IBuffer* _buffer, uint64_t offset)
+    {
+#ifdef NVRHI_WITH_RTXMU
+        (void)_as;
+        (void)_buffer;
+        (void)offset;
+        m_Context.error("writeAccelStructSerializedSize is not supported when NVRHI is built with RTXMU");
+#else
+        if (!m_Context.accelStructCompaction)
+            return;
+
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+        AccelStructCompactionResources& resources = *m_Context.accelStructCompaction;
 
+        const int query = resources.serializationSizeQueries.allocate();
+        if (query < 0)
+        {
+            std::stringstream ss;
+            ss << "Too many serialized size queries are in flight (the limit is " << c_MaxSerializationSizeQueries
+                << "), cannot write the size for BLAS " << utils::DebugNameToString(as->desc.debugName);
             m_Context.error(ss.str());
             return;
         }
-        
-        assert(scratchBuffer->deviceAddress);
-        buildInfo.setScratchData(scratchBuffer->deviceAddress + scratchOffset);
 
-        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
+        // The properties can only be written after the build has finished
+        requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+        requireBufferState(buffer, nvrhi::ResourceStates::CopyDest);
+        commitBarriers();
 
-        m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
+        m_CurrentCmdBuf->cmdBuf.resetQueryPool(resources.serializationSizeQueryPool, uint32_t(query), 1);
+        m_CurrentCmdBuf->cmdBuf.writeAccelerationStructuresPropertiesKHR(as->accelStruct,
+            vk::QueryType::eAccelerationStructureSerializationSizeKHR, resources.serializationSizeQueryPool, uint32_t(query));
+
+        // eWait makes the copy wait on the GPU for the property written above
+        m_CurrentCmdBuf->cmdBuf.copyQueryPoolResults(resources.serializationSizeQueryPool, uint32_t(query), 1,
+            buffer->buffer, offset, sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+        m_CurrentCmdBuf->serializationSizeQueries.push_back(query);
+        m_CurrentCmdBuf->referencedResources.push_back(as);
+        m_CurrentCmdBuf->referencedResources.push_back(buffer);
 #endif
-        if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
     }
 
+    void CommandList::serializeAccelStruct(rt::IAccelStruct* _as, IBuffer* _buffer, uint64_t offset)
+    {
+#ifdef NVRHI_WITH_RTXMU
+        (void)_as;
+        (void)_buffer;
+        (void)offset;
+        m_Context.error("serializeAccelStruct is not supported when NVRHI is built with RTXMU");
+#else
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+        requireBufferState(buffer, nvrhi::ResourceStates::UnorderedAccess);
+        commitBarriers();
+
+        m_CurrentCmdBuf->cmdBuf.copyAccelerationStructureToMemoryKHR(vk::CopyAccelerationStructureToMemoryInfoKHR()
+            .setSrc(as->accelStruct)
+            .setDst(getMutableBufferAddress(buffer, offset))
+            .setMode(vk::CopyAccelerationStructureModeKHR::eSerialize));
+
+        // The copy writes the buffer as a transfer, which the UnorderedAccess state doesn't describe
+        auto memoryBarrier = vk::MemoryBarrier2()
+            .setSrcStageMask(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR)
+            .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+            .setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite);
+
+        vk::DependencyInfo dep_info;
+        dep_info.setMemoryBarriers(memoryBarrier);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+
+        m_CurrentCmdBuf->referencedResources.push_back(as);
+        m_CurrentCmdBuf->referencedResources.push_back(buffer);
+#endif
+    }
+
+    void CommandList::deserializeAccelStruct(rt::IAccelStruct* _as, IBuffer* _buffer, uint64_t offset)
+    {
+#ifdef NVRHI_WITH_RTXMU
+        (void)_as;
+        (void)_buffer;
+        (void)offset;
+        m_Context.error("deserializeAccelStruct is not supported when NVRHI is built with RTXMU");
+#else
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+        requireBufferState(buffer, nvrhi::ResourceStates::AccelStructBuildInput);
+        commitBarriers();
+
+        // The copy reads the buffer as a transfer, which the AccelStructBuildInput state doesn't describe
+        auto memoryBarrier = vk::MemoryBarrier2()
+            .setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+            .setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR)
+            .setDstAccessMask(vk::AccessFlagBits2::eTransferRead);
+
+        vk::DependencyInfo dep_info;
+        dep_info.setMemoryBarriers(memoryBarrier);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+
+        m_CurrentCmdBuf->cmdBuf.copyMemoryToAccelerationStructureKHR(vk::CopyMemoryToAccelerationStructureInfoKHR()
+            .setSrc(getBufferAddress(buffer, offset))
+            .setDst(as->accelStruct)
+            .setMode(vk::CopyAccelerationStructureModeKHR::eDeserialize));
+
+        m_CurrentCmdBuf->referencedResources.push_back(as);
+        m_CurrentCmdBuf->referencedResources.push_back(buffer);
+
+        // A compaction that is pending for an earlier build of this BLAS would copy the wrong data
+        as->compactedSize = 0;
+        m_BindingStatesDirty = true;
+#endif
+    }
+
+#ifndef NVRHI_WITH_RTXMU
+    void CommandList::writeCompactedSizeQueries(AccelStruct* const* accelStructs, size_t numAccelStructs)
+    {
+        AccelStructCompactionResources& compaction = *m_Context.accelStructCompaction;
+
+        // The properties can only be written after the builds have finished
+        auto memoryBarrier = vk::MemoryBarrier2()
+            .setSrcStageMask(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR)
+            .setSrcAccessMask(vk::AccessFlagBits2::eAccelerationStructureWriteKHR)
+            .setDstStageMask(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR)
+            .setDstAccessMask(vk::AccessFlagBits2::eAccelerationStructureReadKHR);
+
+        vk::DependencyInfo dep_info;
+        dep_info.setMemoryBarriers(memoryBarrier);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+
+        for (size_t i = 0; i < numAccelStructs; i++)
+        {
+            AccelStruct* as = accelStructs[i];
+
+            const int query = compaction.compactedSizeQueries.allocate();
+            if (query < 0)
+            {
+                std::stringstream ss;
+                ss << "Too many BLAS builds with AllowCompaction are in flight (the limit is " << c_MaxCompactedSizeQueries
+                    << "), BLAS " << utils::DebugNameToString(as->desc.debugName) << " will not be compacted";
+                m_Context.warning(ss.str());
+                continue;
+            }
+
+            m_CurrentCmdBuf->cmdBuf.resetQueryPool(compaction.compactedSizeQueryPool, uint32_t(query), 1);
+            m_CurrentCmdBuf->cmdBuf.writeAccelerationStructuresPropertiesKHR(as->accelStruct,
+                vk::QueryType::eAccelerationStructureCompactedSizeKHR, compaction.compactedSizeQueryPool, uint32_t(query));
+
+            m_CurrentCmdBuf->compactedSizeQueries.push_back({ as, query });
+        }
+    }
+#endif
+
     void CommandList::compactBottomLevelAccelStructs()
     {
 #ifdef NVRHI_WITH_RTXMU
@@ -861,6 +1172,99 @@ namespace nvrhi::vulkan
                 m_Context.rtxMuResources->asBuildsCompleted.clear();
             }
         }
+#else
+        if (!m_Context.accelStructCompaction)
+            return;
+
+        AccelStructCompactionResources& compaction = *m_Context.accelStructCompaction;
+
+        std::vector<rt::AccelStructHandle> ready;
+        {
+            std::lock_guard lockGuard(compaction.mutex);
+            ready.swap(compaction.compactionsReady);
+        }
+
+        if (ready.empty())
+            return;
+
+        struct Compaction
+        {
+            AccelStruct* as;
+            BufferHandle storage;
+            uint64_t offset;
+        };
+        std::vector<Compaction> compactions;
+        compactions.reserve(ready.size());
+
+        for (const auto& handle : ready)
+        {
+            AccelStruct* as = checked_cast<AccelStruct*>(handle.Get());
+
+            if (as->compacted || as->compactedSize == 0)
+                continue;
+
+            Compaction item{ as, nullptr, 0 };
+            if (!compaction.compactedStorage->allocate(as->compactedSize, item.storage, item.offset))
+            {
+                std::stringstream ss;
+                ss << "Couldn't allocate " << as->compactedSize << " bytes of pooled storage to compact BLAS "
+                    << utils::DebugNameToString(as->desc.debugName);
+                m_Context.error(ss.str());
+                continue;
+            }
+
+            // These are internal transitions that the application cannot do by itself
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+            requireBufferState(item.storage, nvrhi::ResourceStates::AccelStructWrite);
+
+            compactions.push_back(item);
+        }
+        commitBarriers();
+
+        for (const Compaction& item : compactions)
+        {
+            AccelStruct* as = item.as;
+            Buffer* storage = checked_cast<Buffer*>(item.storage.Get());
+
+            auto createInfo = vk::AccelerationStructureCreateInfoKHR()
+                .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+                .setBuffer(storage->buffer)
+                .setOffset(item.offset)
+                .setSize(as->compactedSize);
+
+            vk::AccelerationStructureKHR compactedAccelStruct;
+            const vk::Result res = m_Context.device.createAccelerationStructureKHR(&createInfo, m_Context.allocationCallbacks,
+                &compactedAccelStruct);
+            if (res != vk::Result::eSuccess)
+            {
+                compaction.compactedStorage->release(storage, item.offset, as->compactedSize);
+                continue;
+            }
+
+            m_CurrentCmdBuf->cmdBuf.copyAccelerationStructureKHR(vk::CopyAccelerationStructureInfoKHR()
+                .setSrc(as->accelStruct)
+                .setDst(compactedAccelStruct)
+                .setMode(vk::CopyAccelerationStructureModeKHR::eCompact));
+
+            // Move the original AS object and its buffer into a temporary that is destroyed
+            // when the command buffer is retired, after the copy has finished
+            AccelStruct* original = new AccelStruct(m_Context);
+            original->desc = as->desc;
+            original->accelStruct = as->accelStruct;
+            original->dataBuffer = as->dataBuffer;
+            m_CurrentCmdBuf->referencedResources.push_back(rt::AccelStructHandle::Create(original));
+            m_CurrentCmdBuf->referencedResources.push_back(as);
+
+            as->accelStruct = compactedAccelStruct;
+            as->accelStructDeviceAddress = m_Context.device.getAccelerationStructureAddressKHR(
+                vk::AccelerationStructureDeviceAddressInfoKHR().setAccelerationStructure(compactedAccelStruct));
+            as->dataBuffer = storage;
+            as->dataOffset = item.offset;
+            as->storagePool = compaction.compactedStorage.get();
+            as->compacted = true;
+        }
+
+        m_BindingStatesDirty = true;
 #endif
     }
 
@@ -873,7 +1277,7 @@ namespace nvrhi::vulkan
         if (performUpdate)
         {
             assert(as->allowUpdate);
-            assert(as->instances.size() == numInstances);
+            assert(as->builtInstanceCount == numInstances);
         }
 
         auto geometry = vk::AccelerationStructureGeometryKHR()
@@ -922,7 +1326,7 @@ namespace nvrhi::vulkan
         Buffer* scratchBuffer = nullptr;
         uint64_t scratchOffset = 0;
 
-        bool allocated = m_ScratchManager->suballocateBuffer(scratchSize, &scratchBuffer, &scratchOffset, nullptr,
+        bool allocated = suballocateScratchBuffer(scratchSize, &scratchBuffer, &scratchOffset,
             currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
 
         if (!allocated)
@@ -942,6 +1346,8 @@ namespace nvrhi::vulkan
         std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
 
         m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
+
+        as->builtInstanceCount = numInstances;
     }
 
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -950,11 +1356,18 @@ namespace nvrhi::vulkan
 
         as->instances.resize(numInstances);
 
+        // rt::InstanceDesc has the layout of vk::AccelerationStructureInstanceKHR with a BLAS pointer
+        // instead of its address, so each instance is copied as a whole and only the reference is patched
+        static_assert(sizeof(rt::InstanceDesc) == sizeof(vk::AccelerationStructureInstanceKHR));
+
         for (size_t i = 0; i < numInstances; i++)
         {
             const rt::InstanceDesc& src = pInstances[i];
             vk::AccelerationStructureInstanceKHR& dst = as->instances[i];
 
+            memcpy(&dst, &src, sizeof(src)); // NOLINT(bugprone-undefined-memory-manipulation)
+            dst.setFlags(convertInstanceFlags(src.flags));
+
             if (src.bottomLevelAS)
             {
                 AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
@@ -976,12 +1389,6 @@ namespace nvrhi::vulkan
             {
                 dst.setAccelerationStructureReference(0);
             }
-
-            dst.setInstanceCustomIndex(src.instanceID);
-            dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
-            dst.setFlags(convertInstanceFlags(src.flags));
-            dst.setMask(src.instanceMask);
-            memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
         }
 
 #ifdef NVRHI_WITH_RTXMU
@@ -1015,6 +1422,64 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(as);
     }
 
+    void CommandList::updateTopLevelInstances(rt::IAccelStruct* _as, uint32_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (!as->instanceBuffer)
+        {
+            std::stringstream ss;
+            ss << "TLAS " << utils::DebugNameToString(as->desc.debugName) << " was not created with a persistent instance buffer";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        if (numInstances == 0)
+            return;
+
+        // Only the updated range is converted and uploaded, the rest of the instance buffer remains unchanged
+        as->instances.resize(numInstances);
+
+        static_assert(sizeof(rt::InstanceDesc) == sizeof(vk::AccelerationStructureInstanceKHR));
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            const rt::InstanceDesc& src = pInstances[i];
+            vk::AccelerationStructureInstanceKHR& dst = as->instances[i];
+
+            memcpy(&dst, &src, sizeof(src)); // NOLINT(bugprone-undefined-memory-manipulation)
+            dst.setFlags(convertInstanceFlags(src.flags));
+
+            if (src.bottomLevelAS)
+            {
+                AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
+#ifdef NVRHI_WITH_RTXMU
+                blas->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(blas->rtxmuId);
+                blas->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(blas->rtxmuId);
+                blas->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(blas->rtxmuId);
+                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+#else
+                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+                }
+#endif
+            }
+            else // !src.bottomLevelAS
+            {
+                dst.setAccelerationStructureReference(0);
+            }
+        }
+
+        writeBuffer(as->instanceBuffer, as->instances.data(), numInstances * sizeof(vk::AccelerationStructureInstanceKHR),
+            uint64_t(firstInstance) * sizeof(vk::AccelerationStructureInstanceKHR));
+
+        if (as->desc.trackLiveness)
+            m_CurrentCmdBuf->referencedResources.push_back(as);
+    }
+
     void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* _instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
@@ -1038,6 +1503,70 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(as);
     }
 
+    rt::IndirectInstanceDesc* CommandList::allocateTopLevelInstances(size_t numInstances)
+    {
+        static_assert(sizeof(rt::IndirectInstanceDesc) == sizeof(vk::AccelerationStructureInstanceKHR));
+
+        Buffer* uploadBuffer = nullptr;
+        uint64_t uploadOffset = 0;
+        void* uploadCpuVA = nullptr;
+
+        // Instance data must be 16-byte aligned
+        if (!m_UploadManager->suballocateBuffer(numInstances * sizeof(vk::AccelerationStructureInstanceKHR),
+            &uploadBuffer, &uploadOffset, &uploadCpuVA, m_RecordingVersion, 16))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer for TLAS instances");
+            return nullptr;
+        }
+
+        TopLevelInstanceAllocation allocation;
+        allocation.cpuVA = static_cast<rt::IndirectInstanceDesc*>(uploadCpuVA);
+        allocation.deviceAddress = uploadBuffer->deviceAddress + uploadOffset;
+        allocation.numInstances = numInstances;
+        m_TopLevelInstanceAllocations.push_back(allocation);
+
+        return static_cast<rt::IndirectInstanceDesc*>(uploadCpuVA);
+    }
+
+    void CommandList::buildTopLevelAccelStructFromAllocatedInstances(rt::IAccelStruct* _as, const rt::IndirectInstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        // Find the allocation that contains the instances to get their device address
+        VkDeviceAddress instanceData = 0;
+        for (const TopLevelInstanceAllocation& allocation : m_TopLevelInstanceAllocations)
+        {
+            if (pInstances >= allocation.cpuVA && pInstances + numInstances <= allocation.cpuVA + allocation.numInstances)
+            {
+                instanceData = allocation.deviceAddress + (pInstances - allocation.cpuVA) * sizeof(vk::AccelerationStructureInstanceKHR);
+                break;
+            }
+        }
+
+        if (!instanceData && numInstances != 0)
+        {
+            std::stringstream ss;
+            ss << "The instances for TLAS " << utils::DebugNameToString(as->desc.debugName) << " build were not allocated "
+                "with allocateTopLevelInstances on this command list";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        as->instances.clear();
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        buildTopLevelAccelStructInternal(as, instanceData, numInstances, buildFlags, m_RecordingVersion);
+
+        if (as->desc.trackLiveness)
+            m_CurrentCmdBuf->referencedResources.push_back(as);
+    }
+
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
         // Create Vulkan operation info
@@ -1093,7 +1622,7 @@ namespace nvrhi::vulkan
 
         if (desc.scratchSizeInBytes > 0)
         {
-            if (!m_ScratchManager->suballocateBuffer(desc.scratchSizeInBytes, &scratchBuffer, &scratchOffset, nullptr,
+            if (!suballocateScratchBuffer(desc.scratchSizeInBytes, &scratchBuffer, &scratchOffset,
                 currentVersion, m_Context.nvClusterAccelerationStructureProperties.clusterScratchByteAlignment))
             {
                 std::stringstream ss;
@@ -1166,6 +1695,11 @@ namespace nvrhi::vulkan
             m_Context.device.destroyAccelerationStructureKHR(accelStruct, m_Context.allocationCallbacks);
             accelStruct = nullptr;
         }
+
+#ifndef NVRHI_WITH_RTXMU
+        if (storagePool)
+            storagePool->release(dataBuffer, dataOffset, compactedSize);
+#endif
     }
 
     Object AccelStruct::getNativeObject(ObjectType objectType)
@@ -1189,8 +1723,9 @@ namespace nvrhi::vulkan
 #ifdef NVRHI_WITH_RTXMU
         if (!desc.isTopLevel)
             return m_Context.rtxMemUtil->GetDeviceAddress(rtxmuId);
+#else
+        return getBufferAddress(dataBuffer, dataOffset).deviceAddress;
 #endif
-        return getBufferAddress(dataBuffer, 0).deviceAddress;
     }
 
     OpacityMicromap::~OpacityMicromap()
@@ -1226,6 +1761,8 @@ namespace nvrhi::vulkan
         // Copy the shader and group handles into the device SBT, record the pointers and the version.
 
         state.version = version;
+        state.layoutVersion = layoutVersion;
+        dirtyRecords.clear();
 
         // ... RayGen
 
@@ -1299,6 +1836,81 @@ namespace nvrhi::vulkan
         }
     }
 
+    void ShaderTable::writeRecord(uint8_t* cpuVA, uint32_t recordIndex) const
+    {
+        uint32_t shaderGroupIndex;
+        if (recordIndex == 0)
+            shaderGroupIndex = uint32_t(rayGenerationShader);
+        else if (recordIndex - 1 < missShaders.size())
+            shaderGroupIndex = missShaders[recordIndex - 1];
+        else if (recordIndex - 1 - missShaders.size() < hitGroups.size())
+            shaderGroupIndex = hitGroups[recordIndex - 1 - missShaders.size()];
+        else
+            shaderGroupIndex = callableShaders[recordIndex - 1 - missShaders.size() - hitGroups.size()];
+
+        const uint32_t shaderGroupHandleSize = m_Context.rayTracingPipelineProperties.shaderGroupHandleSize;
+
+        memcpy(cpuVA, pipeline->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex, shaderGroupHandleSize);
+    }
+
+    bool ShaderTable::canUpdateRecords(ShaderTableState const& state) const
+    {
+        // Individual records can only be patched in the cache buffer, and only while the layout stays the same.
+        return m_Desc.isCached && state.layoutVersion == layoutVersion;
+    }
+
+    bool CommandList::updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state)
+    {
+        std::vector<uint32_t>& dirtyRecords = shaderTable->dirtyRecords;
+        std::sort(dirtyRecords.begin(), dirtyRecords.end());
+        dirtyRecords.erase(std::unique(dirtyRecords.begin(), dirtyRecords.end()), dirtyRecords.end());
+
+        if (!dirtyRecords.empty())
+        {
+            uint32_t const entrySize = shaderTable->pipeline->getShaderTableEntrySize();
+
+            Buffer* uploadBuffer = nullptr;
+            uint64_t uploadOffset = 0;
+            uint8_t* uploadCpuVA = nullptr;
+            bool allocated = m_UploadManager->suballocateBuffer(dirtyRecords.size() * entrySize, &uploadBuffer, &uploadOffset, (void**)&uploadCpuVA,
+                MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false), entrySize);
+
+            if (!allocated)
+            {
+                m_Context.error("Failed to suballocate an upload buffer for the SBT");
+                return false;
+            }
+
+            // Copy each run of consecutive records with a single region
+            std::vector<vk::BufferCopy> copyRegions;
+            size_t runStart = 0;
+            for (size_t i = 0; i < dirtyRecords.size(); i++)
+            {
+                shaderTable->writeRecord(uploadCpuVA + i * entrySize, dirtyRecords[i]);
+
+                if (i + 1 < dirtyRecords.size() && dirtyRecords[i + 1] == dirtyRecords[i] + 1)
+                    continue;
+
+                copyRegions.push_back(vk::BufferCopy()
+                    .setSrcOffset(uploadOffset + runStart * entrySize)
+                    .setDstOffset(uint64_t(dirtyRecords[runStart]) * entrySize)
+                    .setSize((i + 1 - runStart) * entrySize));
+                runStart = i + 1;
+            }
+
+            Buffer* cache = checked_cast<Buffer*>(shaderTable->cache.Get());
+            requireBufferState(cache, nvrhi::ResourceStates::CopyDest);
+            commitBarriers();
+
+            m_CurrentCmdBuf->cmdBuf.copyBuffer(uploadBuffer->buffer, cache->buffer, copyRegions);
+
+            dirtyRecords.clear();
+        }
+
+        state.version = shaderTable->version;
+        return true;
+    }
+
     ShaderTableState& CommandList::getShaderTableState(rt::IShaderTable* _shaderTable)
     {
         ShaderTable* shaderTable = checked_cast<ShaderTable*>(_shaderTable);
@@ -1347,14 +1959,19 @@ namespace nvrhi::vulkan
         if (!m_CurrentRayTracingState.shaderTable || m_CurrentRayTracingState.shaderTable->getPipeline() != pso)
         {
             m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, pso->pipeline);
+            NVRHI_COUNT_STATISTIC(m_Statistics, pipelineBinds, 1);
             m_CurrentPipelineLayout = pso->pipelineLayout;
             m_CurrentPushConstantsVisibility = pso->pushConstantVisibility;
         }
 
-        if (arraysAreDifferent(m_CurrentRayTracingState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
+        if (arraysAreDifferent(m_CurrentRayTracingState.bindings, state.bindings))
         {
             bindBindingSets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
         }
+        else if (m_AnyVolatileBufferWrites)
+        {
+            updateVolatileBindingSets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
+        }
 
         // Rebuild the SBT if it's uncached and we're using it for the first time in this command list,
         // or if it's been changed since the previous build.
@@ -1363,7 +1980,14 @@ namespace nvrhi::vulkan
         ShaderTableState& shaderTableState = getShaderTableState(shaderTable);
         bool const rebuildShaderTable = shaderTableState.version != shaderTable->version;
 
-        if (rebuildShaderTable)
+        if (rebuildShaderTable && shaderTable->canUpdateRecords(shaderTableState))
+        {
+            // Only some records were replaced since the cache was built, upload just those.
+
+            if (!updateShaderTableRecords(shaderTable, shaderTableState))
+                return;
+        }
+        else if (rebuildShaderTable)
         {
             size_t const shaderTableSize = shaderTable->getUploadSize();
 
@@ -1444,6 +2068,7 @@ namespace nvrhi::vulkan
             &shaderTableState.hitGroups,
             &shaderTableState.callable,
             args.width, args.height, args.depth);
+        NVRHI_COUNT_STATISTIC(m_Statistics, dispatches, 1);
     }
 
     void CommandList::updateRayTracingVolatileBuffers()
@@ -1452,7 +2077,7 @@ namespace nvrhi::vulkan
         {
             RayTracingPipeline* pso = checked_cast<RayTracingPipeline*>(m_CurrentRayTracingState.shaderTable->getPipeline());
 
-            bindBindingSets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, m_CurrentComputeState.bindings, pso->descriptorSetIdxToBindingIdx);
+            updateVolatileBindingSets(vk::PipelineBindPoint::eRayTracingKHR, pso->pipelineLayout, m_CurrentRayTracingState.bindings, pso->descriptorSetIdxToBindingIdx);
 
             m_AnyVolatileBufferWrites = false;
         }
@@ -1479,8 +2104,50 @@ namespace nvrhi::vulkan
 
     rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
     {
+        return createRayTracingPipelineInternal(desc, nullptr);
+    }
+
+    rt::PipelineHandle Device::addToRayTracingPipeline(rt::IPipeline* _pipeline, const rt::PipelineDesc& additions)
+    {
+        RayTracingPipeline* basePipeline = checked_cast<RayTracingPipeline*>(_pipeline);
+
+        if (!basePipeline->desc.allowAdditions)
+        {
+            m_Context.error("Cannot add to a ray tracing pipeline that was created without allowAdditions");
+            return nullptr;
+        }
+
+        return createRayTracingPipelineInternal(additions, basePipeline);
+    }
+
+    rt::PipelineHandle Device::createRayTracingPipelineInternal(const rt::PipelineDesc& desc, RayTracingPipeline* basePipeline)
+    {
+        PipelineCreationScope creationScope(m_Context.instrumentation, m_Context.pipelineCounters, PipelineType::RayTracing, desc);
+
+        // When adding to an existing pipeline, only the shaders and hit groups come from 'desc',
+        // everything else is inherited from the base pipeline.
+        const rt::PipelineDesc& settings = basePipeline ? basePipeline->desc : desc;
+
+        if (settings.allowAdditions && !m_Context.extensions.KHR_pipeline_library)
+        {
+            m_Context.error("Ray tracing pipeline additions require the VK_KHR_pipeline_library extension");
+            return nullptr;
+        }
+
         RayTracingPipeline* pso = new RayTracingPipeline(m_Context, this);
-        pso->desc = desc;
+        pso->desc = settings;
+
+        // The groups of the base pipeline come first in the linked pipeline
+        uint32_t groupOffset = 0;
+
+        if (basePipeline)
+        {
+            pso->desc.shaders.insert(pso->desc.shaders.end(), desc.shaders.begin(), desc.shaders.end());
+            pso->desc.hitGroups.insert(pso->desc.hitGroups.end(), desc.hitGroups.begin(), desc.hitGroups.end());
+            pso->basePipeline = basePipeline;
+            pso->shaderGroups = basePipeline->shaderGroups;
+            groupOffset = uint32_t(basePipeline->shaderGroupHandles.size() / m_Context.rayTracingPipelineProperties.shaderGroupHandleSize);
+        }
 
         vk::Result res = createPipelineLayout(
             pso->pipelineLayout,
@@ -1488,7 +2155,7 @@ namespace nvrhi::vulkan
             pso->pushConstantVisibility,
             pso->descriptorSetIdxToBindingIdx,
             m_Context,
-            desc.globalBindingLayouts);
+            settings.globalBindingLayouts);
         CHECK_VK_FAIL(res)
 
         // Count all shader modules with their specializations,
@@ -1572,7 +2239,7 @@ namespace nvrhi::vulkan
 
             if (!exportName.empty())
             {
-                pso->shaderGroups[exportName] = uint32_t(shaderGroups.size());
+                pso->shaderGroups[exportName] = groupOffset + uint32_t(shaderGroups.size());
                 shaderGroups.push_back(shaderGroupCreateInfo);
             }
         }
@@ -1614,50 +2281,131 @@ namespace nvrhi::vulkan
 
             assert(!hitGroupDesc.exportName.empty());
             
-            pso->shaderGroups[hitGroupDesc.exportName] = uint32_t(shaderGroups.size());
+            pso->shaderGroups[hitGroupDesc.exportName] = groupOffset + uint32_t(shaderGroups.size());
             shaderGroups.push_back(shaderGroupCreateInfo);
         }
 
         // Create the pipeline object
 
-        auto libraryInfo = vk::PipelineLibraryCreateInfoKHR();
-
         auto pipelineClusters = vk::RayTracingPipelineClusterAccelerationStructureCreateInfoNV()
             .setAllowClusterAccelerationStructure(true);
 
         auto pipelineFlags2 = vk::PipelineCreateFlags2CreateInfoKHR();
         pipelineFlags2.setFlags(vk::PipelineCreateFlagBits2::eRayTracingAllowSpheresAndLinearSweptSpheresNV);
 
-        auto pipelineInfo = vk::RayTracingPipelineCreateInfoKHR()
-            .setStages(shaderStages)
-            .setGroups(shaderGroups)
-            .setLayout(pso->pipelineLayout)
-            .setMaxPipelineRayRecursionDepth(desc.maxRecursionDepth)
-            .setPLibraryInfo(&libraryInfo)
-            .setPNext(&pipelineFlags2);
+        // Only the creation that compiles the shaders from 'desc' reports feedback, not the linking of libraries.
+        PipelineCreationFeedback feedback;
 
-        if (m_Context.extensions.NV_cluster_acceleration_structure)
+        if (!settings.allowAdditions)
         {
-            pipelineInfo.setPNext(&pipelineClusters);
+            auto libraryInfo = vk::PipelineLibraryCreateInfoKHR();
+
+            auto pipelineInfo = vk::RayTracingPipelineCreateInfoKHR()
+                .setStages(shaderStages)
+                .setGroups(shaderGroups)
+                .setLayout(pso->pipelineLayout)
+                .setMaxPipelineRayRecursionDepth(settings.maxRecursionDepth)
+                .setPLibraryInfo(&libraryInfo)
+                .setPNext(&pipelineFlags2);
+
+            if (m_Context.extensions.NV_cluster_acceleration_structure)
+            {
+                pipelineInfo.setPNext(&pipelineClusters);
+            }
+
+            feedback.chain(m_Context, pipelineInfo);
+
+            res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
+                1, &pipelineInfo,
+                m_Context.allocationCallbacks,
+                &pso->pipeline);
+
+            CHECK_VK_FAIL(res)
         }
+        else
+        {
+            // Compile the shaders from 'desc' into a pipeline library, then link it together with
+            // the libraries of the base pipeline. Only the library creation compiles any shaders.
 
-        res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
-            1, &pipelineInfo,
-            m_Context.allocationCallbacks,
-            &pso->pipeline);
+            auto libraryInterface = vk::RayTracingPipelineInterfaceCreateInfoKHR()
+                .setMaxPipelineRayPayloadSize(settings.maxPayloadSize)
+                .setMaxPipelineRayHitAttributeSize(settings.maxAttributeSize);
 
-        CHECK_VK_FAIL(res)
+            auto libraryFlags2 = vk::PipelineCreateFlags2CreateInfoKHR()
+                .setFlags(pipelineFlags2.flags | vk::PipelineCreateFlagBits2::eLibraryKHR);
+
+            if (m_Context.extensions.NV_cluster_acceleration_structure)
+            {
+                pipelineClusters.setPNext(&libraryFlags2);
+            }
+
+            auto emptyLibraryInfo = vk::PipelineLibraryCreateInfoKHR();
+
+            auto libraryCreateInfo = vk::RayTracingPipelineCreateInfoKHR()
+                .setFlags(vk::PipelineCreateFlagBits::eLibraryKHR)
+                .setStages(shaderStages)
+                .setGroups(shaderGroups)
+                .setLayout(pso->pipelineLayout)
+                .setMaxPipelineRayRecursionDepth(settings.maxRecursionDepth)
+                .setPLibraryInfo(&emptyLibraryInfo)
+                .setPLibraryInterface(&libraryInterface)
+                .setPNext(m_Context.extensions.NV_cluster_acceleration_structure
+                    ? static_cast<const void*>(&pipelineClusters)
+                    : static_cast<const void*>(&libraryFlags2));
+
+            feedback.chain(m_Context, libraryCreateInfo);
+
+            res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
+                1, &libraryCreateInfo,
+                m_Context.allocationCallbacks,
+                &pso->library);
+
+            CHECK_VK_FAIL(res)
+
+            if (basePipeline)
+                pso->libraries = basePipeline->libraries;
+            pso->libraries.push_back(pso->library);
+
+            auto linkLibraryInfo = vk::PipelineLibraryCreateInfoKHR()
+                .setLibraries(pso->libraries);
+
+            if (m_Context.extensions.NV_cluster_acceleration_structure)
+            {
+                pipelineClusters.setPNext(&pipelineFlags2);
+            }
+
+            auto linkCreateInfo = vk::RayTracingPipelineCreateInfoKHR()
+                .setLayout(pso->pipelineLayout)
+                .setMaxPipelineRayRecursionDepth(settings.maxRecursionDepth)
+                .setPLibraryInfo(&linkLibraryInfo)
+                .setPLibraryInterface(&libraryInterface)
+                .setPNext(m_Context.extensions.NV_cluster_acceleration_structure
+                    ? static_cast<const void*>(&pipelineClusters)
+                    : static_cast<const void*>(&pipelineFlags2));
 
-        // Obtain the shader group handles to fill the SBT buffer later
+            res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
+                1, &linkCreateInfo,
+                m_Context.allocationCallbacks,
+                &pso->pipeline);
 
-        pso->shaderGroupHandles.resize(m_Context.rayTracingPipelineProperties.shaderGroupHandleSize * shaderGroups.size());
+            CHECK_VK_FAIL(res)
+        }
+
+        // Obtain the shader group handles to fill the SBT buffer later.
+        // In a linked pipeline, the groups of each library follow the groups of the previous libraries.
+
+        const uint32_t numShaderGroups = groupOffset + uint32_t(shaderGroups.size());
+        pso->shaderGroupHandles.resize(m_Context.rayTracingPipelineProperties.shaderGroupHandleSize * numShaderGroups);
 
         res = m_Context.device.getRayTracingShaderGroupHandlesKHR(pso->pipeline, 0, 
-            uint32_t(shaderGroups.size()), 
+            numShaderGroups, 
             pso->shaderGroupHandles.size(), pso->shaderGroupHandles.data());
 
         CHECK_VK_FAIL(res)
 
+        creationScope.setCacheResult(feedback.getCacheResult());
+        creationScope.setPipeline(pso);
+
         return rt::PipelineHandle::Create(pso);
     }
 
@@ -1669,6 +2417,12 @@ namespace nvrhi::vulkan
             pipeline = nullptr;
         }
 
+        if (library)
+        {
+            m_Context.device.destroyPipeline(library, m_Context.allocationCallbacks);
+            library = nullptr;
+        }
+
         if (pipelineLayout)
         {
             m_Context.device.destroyPipelineLayout(pipelineLayout, m_Context.allocationCallbacks);
@@ -1691,6 +2445,7 @@ namespace nvrhi::vulkan
                 .setDebugName(stDesc.debugName)
                 .setByteSize(getShaderTableEntrySize() * stDesc.maxEntries)
                 .setIsShaderBindingTable(true)
+                .setCanHaveUAVs(stDesc.allowGpuWrites)
                 .enableAutomaticStateTracking(ResourceStates::ShaderResource);
 
             cache = m_Device->createBuffer(bufferDesc);
@@ -1747,7 +2502,7 @@ namespace nvrhi::vulkan
         if (verifyShaderGroupExists(exportName, shaderGroupIndex))
         {
             rayGenerationShader = shaderGroupIndex;
-            ++version;
+            markRecordDirty(0);
         }
     }
 
@@ -1761,7 +2516,7 @@ namespace nvrhi::vulkan
         if (verifyShaderGroupExists(exportName, shaderGroupIndex))
         {
             missShaders.push_back(uint32_t(shaderGroupIndex));
-            ++version;
+            markLayoutChanged();
 
             return int(missShaders.size()) - 1;
         }
@@ -1779,7 +2534,7 @@ namespace nvrhi::vulkan
         if (verifyShaderGroupExists(exportName, shaderGroupIndex))
         {
             hitGroups.push_back(uint32_t(shaderGroupIndex));
-            ++version;
+            markLayoutChanged();
 
             return int(hitGroups.size()) - 1;
         }
@@ -1797,7 +2552,7 @@ namespace nvrhi::vulkan
         if (verifyShaderGroupExists(exportName, shaderGroupIndex))
         {
             callableShaders.push_back(uint32_t(shaderGroupIndex));
-            ++version;
+            markLayoutChanged();
 
             return int(callableShaders.size()) - 1;
         }
@@ -1808,21 +2563,118 @@ namespace nvrhi::vulkan
     void ShaderTable::clearMissShaders()
     {
         missShaders.clear();
-        ++version;
+        markLayoutChanged();
     }
 
     void ShaderTable::clearHitShaders()
     {
         hitGroups.clear();
-        ++version;
+        markLayoutChanged();
     }
 
     void ShaderTable::clearCallableShaders()
     {
         callableShaders.clear();
-        ++version;
+        markLayoutChanged();
     }
     
+    bool ShaderTable::replaceRecord(std::vector<uint32_t>& section, uint32_t index, const char* exportName, IBindingSet* bindings)
+    {
+        if (bindings != nullptr)
+            utils::NotSupported();
+
+        if (index >= section.size())
+        {
+            std::stringstream ss;
+            ss << "Shader table record index " << index << " is out of range, the section has "
+                << section.size() << " records";
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
+
+        if (!verifyShaderGroupExists(exportName, shaderGroupIndex))
+            return false;
+
+        section[index] = uint32_t(shaderGroupIndex);
+        return true;
+    }
+
+    bool ShaderTable::setMissShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!replaceRecord(missShaders, index, exportName, bindings))
+            return false;
+
+        markRecordDirty(getRecordIndex(rt::ShaderTableSection::Miss, index));
+        return true;
+    }
+
+    bool ShaderTable::setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!replaceRecord(hitGroups, index, exportName, bindings))
+            return false;
+
+        markRecordDirty(getRecordIndex(rt::ShaderTableSection::HitGroup, index));
+        return true;
+    }
+
+    bool ShaderTable::setCallableShader(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!replaceRecord(callableShaders, index, exportName, bindings))
+            return false;
+
+        markRecordDirty(getRecordIndex(rt::ShaderTableSection::Callable, index));
+        return true;
+    }
+
+    uint32_t ShaderTable::getRecordIndex(rt::ShaderTableSection section, uint32_t index) const
+    {
+        switch (section)
+        {
+        case rt::ShaderTableSection::RayGeneration:
+            return 0;
+        case rt::ShaderTableSection::Miss:
+            return 1 + index;
+        case rt::ShaderTableSection::HitGroup:
+            return 1 + uint32_t(missShaders.size()) + index;
+        case rt::ShaderTableSection::Callable:
+            return 1 + uint32_t(missShaders.size()) + uint32_t(hitGroups.size()) + index;
+        default:
+            utils::InvalidEnum();
+            return 0;
+        }
+    }
+
+    uint64_t ShaderTable::getRecordOffset(rt::ShaderTableSection section, uint32_t index) const
+    {
+        return uint64_t(getRecordIndex(section, index)) * pipeline->getShaderTableEntrySize();
+    }
+
+    void ShaderTable::markRecordDirty(uint32_t recordIndex)
+    {
+        ++version;
+
+        if (!m_Desc.isCached)
+            return;
+
+        // When most of the table is dirty, a full rebuild is no more expensive than the record updates
+        if (dirtyRecords.size() >= getNumEntries() / 2)
+        {
+            markLayoutChanged();
+            return;
+        }
+
+        dirtyRecords.push_back(recordIndex);
+    }
+
+    void ShaderTable::markLayoutChanged()
+    {
+        ++version;
+        ++layoutVersion;
+        dirtyRecords.clear();
+    }
+
     uint32_t ShaderTable::getNumEntries() const
     {
         return 1 + // rayGeneration
@@ -29,11 +29,22 @@ namespace nvrhi::vulkan
 
     BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
     {
+        if (m_InternedStates)
+        {
+            if (BindingLayoutHandle existing = m_InternedStates->bindingLayouts.find(desc))
+                return existing;
+        }
+
         BindingLayout* ret = new BindingLayout(m_Context, desc);
 
         ret->bake();
 
-        return BindingLayoutHandle::Create(ret);
+        BindingLayoutHandle layoutHandle = BindingLayoutHandle::Create(ret);
+
+        if (m_InternedStates)
+            return m_InternedStates->bindingLayouts.insert(desc, ret, ret->internEntry);
+
+        return layoutHandle;
     }
 
     BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
@@ -84,6 +95,8 @@ namespace nvrhi::vulkan
     {
         vk::ShaderStageFlagBits shaderStageFlags = convertShaderTypeToShaderStageFlagBits(desc.visibility);
 
+        pushDescriptors = desc.usePushDescriptors && m_Context.extensions.KHR_push_descriptor;
+
         // iterate over all binding types and add to map
         for (const BindingLayoutItem& binding : desc.bindings)
         {
@@ -93,6 +106,13 @@ namespace nvrhi::vulkan
                 continue;
             }
 
+            if (binding.type == ResourceType::VolatileConstantBuffer && pushDescriptors)
+            {
+                // Dynamic uniform buffers cannot be pushed, fall back to a regular descriptor set
+                m_Context.error("Volatile constant buffers are not supported in push descriptor layouts");
+                pushDescriptors = false;
+            }
+
             vk::DescriptorType const descriptorType = convertResourceType(binding.type);
             uint32_t const descriptorCount = binding.size;
             uint32_t const registerOffset = getRegisterOffsetForResourceType(_desc.bindingOffsets, binding.type);
@@ -181,6 +201,9 @@ namespace nvrhi::vulkan
             .setBindingCount(uint32_t(vulkanLayoutBindings.size()))
             .setPBindings(vulkanLayoutBindings.data());
 
+        if (pushDescriptors)
+            descriptorSetLayoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR);
+
         std::vector<vk::DescriptorBindingFlags> bindFlag(vulkanLayoutBindings.size(), vk::DescriptorBindingFlagBits::ePartiallyBound);
 
         auto extendedInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfo()
@@ -246,6 +269,10 @@ namespace nvrhi::vulkan
                                                                         &descriptorSetLayout);
         CHECK_VK_RETURN(res)
 
+        // push descriptor sets are never allocated from pools
+        if (pushDescriptors)
+            return vk::Result::eSuccess;
+
         // count the number of descriptors required per type
         std::unordered_map<vk::DescriptorType, uint32_t> poolSizeMap;
         for (auto layoutBinding : vulkanLayoutBindings)
@@ -272,8 +299,85 @@ namespace nvrhi::vulkan
         return vk::Result::eSuccess;
     }
 
+    vk::Result BindingLayout::createDescriptorPool()
+    {
+        const uint32_t maxSets = m_NextDescriptorPoolSets;
+        m_NextDescriptorPoolSets = std::min(m_NextDescriptorPoolSets * 2, c_MaxDescriptorPoolSets);
+
+        std::vector<vk::DescriptorPoolSize> poolSizes = descriptorPoolSizeInfo;
+        for (auto& poolSize : poolSizes)
+            poolSize.descriptorCount *= maxSets;
+
+        auto poolInfo = vk::DescriptorPoolCreateInfo()
+            .setPoolSizeCount(uint32_t(poolSizes.size()))
+            .setPPoolSizes(poolSizes.data())
+            .setMaxSets(maxSets);
+
+        vk::DescriptorPool pool;
+        const vk::Result res = m_Context.device.createDescriptorPool(&poolInfo, m_Context.allocationCallbacks, &pool);
+        CHECK_VK_RETURN(res)
+
+        m_DescriptorPools.push_back(pool);
+        return vk::Result::eSuccess;
+    }
+
+    vk::Result BindingLayout::allocateDescriptorSet(vk::DescriptorPool& outPool, vk::DescriptorSet& outSet)
+    {
+        std::lock_guard lockGuard(m_DescriptorPoolMutex);
+
+        if (!m_FreeDescriptorSets.empty())
+        {
+            outPool = m_FreeDescriptorSets.back().first;
+            outSet = m_FreeDescriptorSets.back().second;
+            m_FreeDescriptorSets.pop_back();
+            return vk::Result::eSuccess;
+        }
+
+        if (m_DescriptorPools.empty())
+        {
+            const vk::Result res = createDescriptorPool();
+            CHECK_VK_RETURN(res)
+        }
+
+        auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
+            .setDescriptorPool(m_DescriptorPools.back())
+            .setDescriptorSetCount(1)
+            .setPSetLayouts(&descriptorSetLayout);
+
+        vk::Result res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+
+        if (res == vk::Result::eErrorOutOfPoolMemory || res == vk::Result::eErrorFragmentedPool)
+        {
+            // the last pool is full, sets are never returned to it, so start a new one
+            res = createDescriptorPool();
+            CHECK_VK_RETURN(res)
+
+            descriptorSetAllocInfo.setDescriptorPool(m_DescriptorPools.back());
+            res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+        }
+        CHECK_VK_RETURN(res)
+
+        outPool = m_DescriptorPools.back();
+        return vk::Result::eSuccess;
+    }
+
+    void BindingLayout::releaseDescriptorSet(vk::DescriptorPool pool, vk::DescriptorSet set)
+    {
+        // Binding sets are only destroyed after the command lists that reference them have finished executing,
+        // so the set can be rewritten right away.
+        std::lock_guard lockGuard(m_DescriptorPoolMutex);
+        m_FreeDescriptorSets.push_back(std::make_pair(pool, set));
+    }
+
     BindingLayout::~BindingLayout()
     {
+        for (vk::DescriptorPool pool : m_DescriptorPools)
+        {
+            m_Context.device.destroyDescriptorPool(pool, m_Context.allocationCallbacks);
+        }
+        m_DescriptorPools.clear();
+        m_FreeDescriptorSets.clear();
+
         if (descriptorSetLayout)
         {
             m_Context.device.destroyDescriptorSetLayout(descriptorSetLayout, m_Context.allocationCallbacks);
@@ -297,36 +401,69 @@ namespace nvrhi::vulkan
 
     BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
     {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
         BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
 
         BindingSet *ret = new BindingSet(m_Context);
         ret->desc = desc;
         ret->layout = layout;
 
-        const auto& descriptorSetLayout = layout->descriptorSetLayout;
-        const auto& poolSizes = layout->descriptorPoolSizeInfo;
+        // get a descriptor set from the pools shared by all binding sets of this layout
+        if (!layout->pushDescriptors)
+        {
+            vk::Result res = layout->allocateDescriptorSet(ret->descriptorPool, ret->descriptorSet);
+            CHECK_VK_FAIL(res)
+        }
 
-        // create descriptor pool to allocate a descriptor from
-        auto poolInfo = vk::DescriptorPoolCreateInfo()
-            .setPoolSizeCount(uint32_t(poolSizes.size()))
-            .setPPoolSizes(poolSizes.data())
-            .setMaxSets(1);
+        writeBindingSetDescriptors(ret);
 
-        vk::Result res = m_Context.device.createDescriptorPool(&poolInfo,
-                                                             m_Context.allocationCallbacks,
-                                                             &ret->descriptorPool);
-        CHECK_VK_FAIL(res)
-        
-        // create the descriptor set
-        auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
-            .setDescriptorPool(ret->descriptorPool)
-            .setDescriptorSetCount(1)
-            .setPSetLayouts(&descriptorSetLayout);
+        return BindingSetHandle::Create(ret);
+    }
+
+    IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    {
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CreateBindingSet);
+
+        assert(m_CurrentCmdBuf);
+
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        BindingSet *ret = new BindingSet(m_Context);
+        ret->desc = desc;
+        ret->layout = layout;
+        ret->transient = true;
+
+        const vk::Result res = layout->pushDescriptors
+            ? vk::Result::eSuccess
+            : m_CurrentCmdBuf->allocateTransientDescriptorSet(layout->descriptorSetLayout, ret->descriptorPool, ret->descriptorSet);
+        if (res != vk::Result::eSuccess)
+        {
+            std::stringstream ss;
+            ss << "Failed to allocate a transient descriptor set: " << resultToString(VkResult(res));
+            m_Context.error(ss.str());
+            delete ret;
+            return nullptr;
+        }
+
+        m_Device->writeBindingSetDescriptors(ret);
+
+        // Push descriptors are counted when they are pushed in bindBindingSets
+        if (!layout->pushDescriptors)
+            NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, desc.bindings.size());
+
+        // the command buffer owns the binding set until it's retired
+        BindingSetHandle handle = BindingSetHandle::Create(ret);
+        m_CurrentCmdBuf->referencedResources.push_back(handle);
+
+        return ret;
+    }
+
+    void Device::writeBindingSetDescriptors(BindingSet* ret)
+    {
+        const BindingSetDesc& desc = ret->desc;
+        BindingLayout* layout = checked_cast<BindingLayout*>(ret->layout.Get());
 
-        res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo,
-            &ret->descriptorSet);
-        CHECK_VK_FAIL(res)
-        
         // collect all of the descriptor write data
         std::vector<vk::DescriptorImageInfo> descriptorImageInfo;
         std::vector<vk::DescriptorBufferInfo> descriptorBufferInfo;
@@ -460,6 +597,7 @@ namespace nvrhi::vulkan
                 nvrhi::hash_combine(viewInfoHash, range.byteSize);
                 nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
 
+                std::lock_guard viewCacheLock(buffer->viewCacheMutex);
                 const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
                 auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
                 if (bufferViewFound == buffer->viewCache.end())
@@ -515,6 +653,15 @@ namespace nvrhi::vulkan
                     .setOffset(range.byteOffset)
                     .setRange(range.byteSize);
 
+                if (binding.type == ResourceType::VolatileConstantBuffer && m_VolatileConstantRing)
+                {
+                    // The writes are placed anywhere in the ring, see CommandList::writeVolatileBufferToRing
+                    if (Buffer* ringBuffer = m_VolatileConstantRing->getBuffer())
+                        bufferInfo.setBuffer(ringBuffer->buffer).setOffset(0);
+                    else
+                        m_Context.error("Failed to create the volatile constant ring buffer");
+                }
+
                 assert(buffer->buffer);
                 generateWriteDescriptorData(
                     registerOffset + binding.slot,
@@ -611,16 +758,27 @@ namespace nvrhi::vulkan
 
         }
 
-        m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+        if (layout->pushDescriptors)
+        {
+            // keep the write data for pushDescriptorSetKHR; moving the vectors keeps the pointers in the writes valid
+            ret->pushDescriptorImageInfo = std::move(descriptorImageInfo);
+            ret->pushDescriptorBufferInfo = std::move(descriptorBufferInfo);
+            ret->pushAccelStructWriteInfo = std::move(accelStructWriteInfo);
+            ret->pushDescriptorWriteInfo = std::move(descriptorWriteInfo);
+        }
+        else
+        {
+            m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+        }
 
-        return BindingSetHandle::Create(ret);
+        ret->buildRequiredStates();
     }
 
     BindingSet::~BindingSet()
     {
-        if (descriptorPool)
+        if (descriptorSet && !transient)
         {
-            m_Context.device.destroyDescriptorPool(descriptorPool, m_Context.allocationCallbacks);
+            checked_cast<BindingLayout*>(layout.Get())->releaseDescriptorSet(descriptorPool, descriptorSet);
             descriptorPool = vk::DescriptorPool();
             descriptorSet = vk::DescriptorSet();
         }
@@ -705,24 +863,28 @@ namespace nvrhi::vulkan
         (void)keepContents;
     }
 
-    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& binding)
+    bool Device::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& binding)
+    {
+        return writeDescriptorTable(descriptorTable, &binding, 1);
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem* items, uint32_t numItems)
     {
         DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
         BindingLayout* layout = checked_cast<BindingLayout*>(descriptorTable->layout.Get());
 
-        if (binding.slot >= descriptorTable->capacity)
-            return false;
-
-        if (binding.type == ResourceType::None)
-        {
-            // Vulkan doesn't support null descriptors, we use vk::DescriptorBindingFlagBits::ePartiallyBound
-            return true;
-        }
+        // collect all of the descriptor write data; every item produces at most one write per register space,
+        // and the write structures point into the info arrays, so those must not be reallocated
+        const size_t maxWrites = size_t(numItems) * std::max<size_t>(layout->bindlessDesc.registerSpaces.size(), 1);
+        std::vector<vk::DescriptorImageInfo> descriptorImageInfo;
+        std::vector<vk::DescriptorBufferInfo> descriptorBufferInfo;
+        std::vector<vk::WriteDescriptorSet> descriptorWriteInfo;
+        descriptorImageInfo.reserve(maxWrites);
+        descriptorBufferInfo.reserve(maxWrites);
+        descriptorWriteInfo.reserve(maxWrites);
 
-        // collect all of the descriptor write data
-        static_vector<vk::DescriptorImageInfo, c_MaxBindlessRegisterSpaces> descriptorImageInfo;
-        static_vector<vk::DescriptorBufferInfo, c_MaxBindlessRegisterSpaces> descriptorBufferInfo;
-        static_vector<vk::WriteDescriptorSet, c_MaxBindlessRegisterSpaces> descriptorWriteInfo;
+        bool success = true;
+        const BindingSetItem* pBinding = nullptr;
 
         auto generateWriteDescriptorData =
             // generates a vk::WriteDescriptorSet struct in descriptorWriteInfo
@@ -736,7 +898,7 @@ namespace nvrhi::vulkan
                 vk::WriteDescriptorSet()
                 .setDstSet(descriptorTable->descriptorSet)
                 .setDstBinding(bindingLocation)
-                .setDstArrayElement(binding.slot)
+                .setDstArrayElement(pBinding->slot)
                 .setDescriptorCount(1)
                 .setDescriptorType(descriptorType)
                 .setPImageInfo(imageInfo)
@@ -747,6 +909,8 @@ namespace nvrhi::vulkan
 
         auto writeDescriptorForBinding = [&](const vk::DescriptorSetLayoutBinding& layoutBinding) -> void
         {
+            const BindingSetItem& binding = *pBinding;
+
             switch (binding.type)
             {
             case ResourceType::Texture_SRV:
@@ -800,6 +964,7 @@ namespace nvrhi::vulkan
                 nvrhi::hash_combine(viewInfoHash, range.byteSize);
                 nvrhi::hash_combine(viewInfoHash, (uint64_t)vkformat);
 
+                std::lock_guard viewCacheLock(buffer->viewCacheMutex);
                 const auto& bufferViewFound = buffer->viewCache.find(viewInfoHash);
                 auto& bufferViewRef = (bufferViewFound != buffer->viewCache.end()) ? bufferViewFound->second : buffer->viewCache[viewInfoHash];
                 if (bufferViewFound == buffer->viewCache.end())
@@ -875,28 +1040,80 @@ namespace nvrhi::vulkan
             }
         };
 
-        if (layout->bindlessDesc.layoutType != BindlessLayoutDesc::LayoutType::Immutable)
+        for (uint32_t index = 0; index < numItems; index++)
         {
-            // For mutable descriptor sets, there are no register spaces, so always use the first layout binding
-            assert(layout->vulkanLayoutBindings.size() > 0);
-            writeDescriptorForBinding(layout->vulkanLayoutBindings[0]);
-        }
-        else
-        {
-            // For regular bindless layouts, iterate through register spaces to find matching binding type
-            for (uint32_t bindingLocation = 0; bindingLocation < uint32_t(layout->bindlessDesc.registerSpaces.size()); bindingLocation++)
+            pBinding = &items[index];
+
+            if (pBinding->slot >= descriptorTable->capacity)
+            {
+                success = false;
+                continue;
+            }
+
+            if (pBinding->type == ResourceType::None)
+            {
+                // Vulkan doesn't support null descriptors, we use vk::DescriptorBindingFlagBits::ePartiallyBound
+                continue;
+            }
+
+            if (layout->bindlessDesc.layoutType != BindlessLayoutDesc::LayoutType::Immutable)
+            {
+                // For mutable descriptor sets, there are no register spaces, so always use the first layout binding
+                assert(layout->vulkanLayoutBindings.size() > 0);
+                writeDescriptorForBinding(layout->vulkanLayoutBindings[0]);
+            }
+            else
             {
-                if (layout->bindlessDesc.registerSpaces[bindingLocation].type == binding.type)
+                // For regular bindless layouts, iterate through register spaces to find matching binding type
+                for (uint32_t bindingLocation = 0; bindingLocation < uint32_t(layout->bindlessDesc.registerSpaces.size()); bindingLocation++)
                 {
-                    const vk::DescriptorSetLayoutBinding& layoutBinding = layout->vulkanLayoutBindings[bindingLocation];
-                    writeDescriptorForBinding(layoutBinding);
+                    if (layout->bindlessDesc.registerSpaces[bindingLocation].type == pBinding->type)
+                    {
+                        const vk::DescriptorSetLayoutBinding& layoutBinding = layout->vulkanLayoutBindings[bindingLocation];
+                        writeDescriptorForBinding(layoutBinding);
+                    }
                 }
             }
         }
 
-        m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+        if (!descriptorWriteInfo.empty())
+        {
+            // vkUpdateDescriptorSets requires external synchronization of the destination set
+            std::lock_guard lockGuard(descriptorTable->writeMutex);
+
+            m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+        }
+
+        return success;
+    }
+
+    static IBindingSet* getBindingSetForDescriptorSet(const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx, uint32_t descriptorSetIndex)
+    {
+        if (descriptorSetIdxToBindingIdx.empty())
+            return bindings[descriptorSetIndex];
+
+        if (descriptorSetIdxToBindingIdx[descriptorSetIndex] != 0xffffffff)
+            return bindings[descriptorSetIdxToBindingIdx[descriptorSetIndex]];
 
-        return true;
+        return nullptr;
+    }
+
+    uint32_t CommandList::getVolatileBufferDynamicOffset(Buffer* constantBuffer)
+    {
+        auto found = m_VolatileBufferStates.find(constantBuffer);
+        if (found == m_VolatileBufferStates.end())
+        {
+            std::stringstream ss;
+            ss << "Binding volatile constant buffer " << utils::DebugNameToString(constantBuffer->desc.debugName)
+                << " before writing into it is invalid.";
+            m_Context.error(ss.str());
+
+            return 0; // use zero offset just to use something
+        }
+
+        uint64_t offset = found->second.latestOffset;
+        assert(offset < std::numeric_limits<uint32_t>::max());
+        return uint32_t(offset);
     }
 
     void CommandList::bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx)
@@ -907,63 +1124,75 @@ namespace nvrhi::vulkan
         BindingVector<vk::DescriptorSet> descriptorSets;
         uint32_t nextDescriptorSetToBind = 0;
         static_vector<uint32_t, c_MaxVolatileConstantBuffers> dynamicOffsets;
-        for (uint32_t i = 0; i < numDescriptorSets; ++i)
+
+        // remember the offsets for updateVolatileBindingSets
+        m_BoundDynamicOffsetsBindPoint = bindPoint;
+        m_BoundDynamicOffsetsLayout = pipelineLayout;
+        m_BoundDynamicOffsets.resize(numDescriptorSets);
+
+        // binds the contiguous descriptor sets collected so far
+        auto bindPendingDescriptorSets = [&]()
         {
-            IBindingSet* bindingSetHandle = nullptr;
-            if (descriptorSetIdxToBindingIdx.empty())
+            if (!descriptorSets.empty())
             {
-                bindingSetHandle = bindings[i];
-            }
-            else if(descriptorSetIdxToBindingIdx[i] != 0xffffffff)
-            {
-                bindingSetHandle = bindings[descriptorSetIdxToBindingIdx[i]];
+                m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
+                    /* firstSet = */ nextDescriptorSetToBind, uint32_t(descriptorSets.size()), descriptorSets.data(),
+                    uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+
+                descriptorSets.resize(0);
+                dynamicOffsets.resize(0);
             }
+        };
+
+        for (uint32_t i = 0; i < numDescriptorSets; ++i)
+        {
+            IBindingSet* bindingSetHandle = getBindingSetForDescriptorSet(bindings, descriptorSetIdxToBindingIdx, i);
+
+            m_BoundDynamicOffsets[i].resize(0);
 
             if (bindingSetHandle == nullptr)
             {
                 // This is a hole in the descriptor sets, so bind the contiguous descriptor sets we've got so far
-                if (!descriptorSets.empty())
-                {
-                    m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
-                        /* firstSet = */ nextDescriptorSetToBind, uint32_t(descriptorSets.size()), descriptorSets.data(),
-                        uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
-
-                    descriptorSets.resize(0);
-                    dynamicOffsets.resize(0);
-                }
+                bindPendingDescriptorSets();
                 nextDescriptorSetToBind = i + 1;
             }
             else
             {
+                NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
+
                 const BindingSetDesc* desc = bindingSetHandle->getDesc();
                 if (desc)
                 {
                     BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
-                    descriptorSets.push_back(bindingSet->descriptorSet);
+                    const BindingLayout* layout = checked_cast<const BindingLayout*>(bindingSet->layout.Get());
 
-                    for (Buffer* constantBuffer : bindingSet->volatileConstantBuffers)
+                    if (layout->pushDescriptors)
                     {
-                        auto found = m_VolatileBufferStates.find(constantBuffer);
-                        if (found == m_VolatileBufferStates.end())
-                        {
-                            std::stringstream ss;
-                            ss << "Binding volatile constant buffer " << utils::DebugNameToString(constantBuffer->desc.debugName)
-                                << " before writing into it is invalid.";
-                            m_Context.error(ss.str());
+                        // Push sets break the contiguous range of descriptor sets, same as holes
+                        bindPendingDescriptorSets();
+                        nextDescriptorSetToBind = i + 1;
 
-                            dynamicOffsets.push_back(0); // use zero offset just to use something
-                        }
-                        else
+                        if (!bindingSet->pushDescriptorWriteInfo.empty())
                         {
-                            uint32_t version = found->second.latestVersion;
-                            uint64_t offset = version * constantBuffer->desc.byteSize;
-                            assert(offset < std::numeric_limits<uint32_t>::max());
-                            dynamicOffsets.push_back(uint32_t(offset));
+                            m_CurrentCmdBuf->cmdBuf.pushDescriptorSetKHR(bindPoint, pipelineLayout, /* set = */ i,
+                                uint32_t(bindingSet->pushDescriptorWriteInfo.size()), bindingSet->pushDescriptorWriteInfo.data());
+                            NVRHI_COUNT_STATISTIC(m_Statistics, descriptorWrites, bindingSet->pushDescriptorWriteInfo.size());
                         }
                     }
+                    else
+                    {
+                        descriptorSets.push_back(bindingSet->descriptorSet);
+                    }
+
+                    for (Buffer* constantBuffer : bindingSet->volatileConstantBuffers)
+                    {
+                        const uint32_t offset = getVolatileBufferDynamicOffset(constantBuffer);
+                        dynamicOffsets.push_back(offset);
+                        m_BoundDynamicOffsets[i].push_back(offset);
+                    }
 
                     if (desc->trackLiveness)
-                        m_CurrentCmdBuf->referencedResources.push_back(bindingSetHandle);
+                        referenceResource(bindingSet);
                 }
                 else
                 {
@@ -972,12 +1201,46 @@ namespace nvrhi::vulkan
                 }
             }
         }
-        if (!descriptorSets.empty())
+        // Bind the remaining sets
+        bindPendingDescriptorSets();
+    }
+
+    void CommandList::updateVolatileBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx)
+    {
+        // The offsets are only known for the sets bound by the last bindBindingSets call
+        if (bindPoint != m_BoundDynamicOffsetsBindPoint || pipelineLayout != m_BoundDynamicOffsetsLayout || !m_BoundDynamicOffsetsLayout)
+        {
+            bindBindingSets(bindPoint, pipelineLayout, bindings, descriptorSetIdxToBindingIdx);
+            return;
+        }
+
+        const uint32_t numDescriptorSets = std::min(uint32_t(m_BoundDynamicOffsets.size()),
+            descriptorSetIdxToBindingIdx.empty() ? uint32_t(bindings.size()) : uint32_t(descriptorSetIdxToBindingIdx.size()));
+
+        // Rebind only the sets whose volatile buffers have been written since they were bound, each with its new offsets.
+        // The other sets stay bound because rebinding one set doesn't disturb the sets of a compatible layout.
+        for (uint32_t i = 0; i < numDescriptorSets; ++i)
         {
-            // Bind the remaining sets
-            m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
-                /* firstSet = */ nextDescriptorSetToBind, uint32_t(descriptorSets.size()), descriptorSets.data(),
-                uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+            IBindingSet* bindingSetHandle = getBindingSetForDescriptorSet(bindings, descriptorSetIdxToBindingIdx, i);
+            if (!bindingSetHandle || !bindingSetHandle->getDesc())
+                continue;
+
+            BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
+            if (bindingSet->volatileConstantBuffers.empty())
+                continue;
+
+            static_vector<uint32_t, c_MaxVolatileConstantBuffersPerLayout> dynamicOffsets;
+            for (Buffer* constantBuffer : bindingSet->volatileConstantBuffers)
+                dynamicOffsets.push_back(getVolatileBufferDynamicOffset(constantBuffer));
+
+            if (!arraysAreDifferent(dynamicOffsets, m_BoundDynamicOffsets[i]))
+                continue;
+
+            m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout, /* firstSet = */ i,
+                1, &bindingSet->descriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+            NVRHI_COUNT_STATISTIC(m_Statistics, bindingSetBinds, 1);
+
+            m_BoundDynamicOffsets[i] = dynamicOffsets;
         }
     }
 
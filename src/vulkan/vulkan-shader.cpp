@@ -28,6 +28,15 @@ namespace nvrhi::vulkan
 
     ShaderHandle Device::createShader(const ShaderDesc& desc, const void *binary, const size_t binarySize)
     {
+        const bool useCache = m_ShaderCache && ShaderCache::isCacheable(desc);
+        uint64_t cacheKey = 0;
+        if (useCache)
+        {
+            cacheKey = ShaderCache::getKey(desc, binary, binarySize);
+            if (ShaderHandle cachedShader = m_ShaderCache->find(cacheKey, desc, binary, binarySize))
+                return cachedShader;
+        }
+
         Shader *shader = new Shader(m_Context);
 
         shader->desc = desc;
@@ -43,7 +52,12 @@ namespace nvrhi::vulkan
         const std::string debugName = desc.debugName + ":" + desc.entryName;
         m_Context.nameVKObject(VkShaderModule(shader->shaderModule), vk::ObjectType::eShaderModule, vk::DebugReportObjectTypeEXT::eShaderModule, debugName.c_str());
 
-        return ShaderHandle::Create(shader);
+        ShaderHandle shaderHandle = ShaderHandle::Create(shader);
+
+        if (useCache)
+            return m_ShaderCache->insert(cacheKey, desc, binary, binarySize, shaderHandle);
+
+        return shaderHandle;
     }
 
     ShaderLibraryHandle Device::createShaderLibrary(const void* binary, const size_t binarySize)
@@ -66,6 +80,14 @@ namespace nvrhi::vulkan
         assert(constants);
         assert(numConstants != 0);
 
+        uint64_t cacheKey = 0;
+        if (m_ShaderCache)
+        {
+            cacheKey = ShaderCache::getKey(_baseShader, constants, numConstants);
+            if (ShaderHandle cachedShader = m_ShaderCache->find(cacheKey, _baseShader, constants, numConstants))
+                return cachedShader;
+        }
+
         Shader* newShader = new Shader(m_Context);
 
         // Hold a strong reference to the parent object
@@ -75,7 +97,12 @@ namespace nvrhi::vulkan
         newShader->stageFlagBits = baseShader->stageFlagBits;
         newShader->specializationConstants.assign(constants, constants + numConstants);
 
-        return ShaderHandle::Create(newShader);
+        ShaderHandle shaderHandle = ShaderHandle::Create(newShader);
+
+        if (m_ShaderCache)
+            return m_ShaderCache->insert(cacheKey, _baseShader, constants, numConstants, shaderHandle);
+
+        return shaderHandle;
     }
 
 
@@ -137,6 +164,14 @@ namespace nvrhi::vulkan
     {
         (void)vertexShader;
 
+        std::vector<VertexAttributeDesc> internKey;
+        if (m_InternedStates)
+        {
+            internKey.assign(attributeDesc, attributeDesc + attributeCount);
+            if (InputLayoutHandle existing = m_InternedStates->inputLayouts.find(internKey))
+                return existing;
+        }
+
         InputLayout *layout = new InputLayout();
 
         int total_attribute_array_size = 0;
@@ -197,7 +232,12 @@ namespace nvrhi::vulkan
             }
         }
 
-        return InputLayoutHandle::Create(layout);
+        InputLayoutHandle layoutHandle = InputLayoutHandle::Create(layout);
+
+        if (m_InternedStates)
+            return m_InternedStates->inputLayouts.insert(internKey, layout, layout->internEntry);
+
+        return layoutHandle;
     }
 
     uint32_t InputLayout::getNumAttributes() const 
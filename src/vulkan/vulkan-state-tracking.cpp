@@ -23,58 +23,81 @@
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
 
+#include <algorithm>
+
 namespace nvrhi::vulkan
 {
     
-    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    void BindingSet::buildRequiredStates()
     {
-        if (_bindingSet == nullptr)
-            return;
-        if (_bindingSet->getDesc() == nullptr)
-            return; // is bindless
+        requiredStates.clear();
+        requiredStates.reserve(bindingsThatNeedTransitions.size());
 
-        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
-
-        for (auto bindingIndex : bindingSet->bindingsThatNeedTransitions)
+        for (auto bindingIndex : bindingsThatNeedTransitions)
         {
-            const BindingSetItem& binding = bindingSet->desc.bindings[bindingIndex];
+            const BindingSetItem& binding = desc.bindings[bindingIndex];
+
+            RequiredResourceState required;
+            required.subresources = binding.subresources;
 
             switch(binding.type)  // NOLINT(clang-diagnostic-switch-enum)
             {
                 case ResourceType::Texture_SRV:
-                    requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::ShaderResource);
+                    required.texture = checked_cast<Texture*>(binding.resourceHandle);
+                    required.state = ResourceStates::ShaderResource;
                     break;
 
                 case ResourceType::Texture_UAV:
-                    requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::UnorderedAccess);
+                    required.texture = checked_cast<Texture*>(binding.resourceHandle);
+                    required.state = ResourceStates::UnorderedAccess;
                     break;
 
                 case ResourceType::TypedBuffer_SRV:
                 case ResourceType::StructuredBuffer_SRV:
                 case ResourceType::RawBuffer_SRV:
-                    requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ShaderResource);
+                    required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                    required.state = ResourceStates::ShaderResource;
                     break;
 
                 case ResourceType::TypedBuffer_UAV:
                 case ResourceType::StructuredBuffer_UAV:
                 case ResourceType::RawBuffer_UAV:
-                    requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::UnorderedAccess);
+                    required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                    required.state = ResourceStates::UnorderedAccess;
                     break;
 
                 case ResourceType::ConstantBuffer:
-                    requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ConstantBuffer);
+                    required.buffer = checked_cast<Buffer*>(binding.resourceHandle);
+                    required.state = ResourceStates::ConstantBuffer;
                     break;
 
                 case ResourceType::RayTracingAccelStruct:
-                    requireBufferState(checked_cast<AccelStruct*>(binding.resourceHandle)->dataBuffer, ResourceStates::AccelStructRead);
+                    required.buffer = checked_cast<Buffer*>(checked_cast<AccelStruct*>(binding.resourceHandle)->dataBuffer.Get());
+                    required.state = ResourceStates::AccelStructRead;
+                    break;
 
                 default:
                     // do nothing
-                    break;
+                    continue;
             }
+
+            requiredStates.push_back(required);
         }
     }
 
+    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    {
+        if (_bindingSet == nullptr)
+            return;
+        if (_bindingSet->getDesc() == nullptr)
+            return; // is bindless
+
+        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+        // Sets with UAVs may need UAV barriers on every use, so they can't be skipped
+        m_StateTracker.requireResourceStates(bindingSet->requiredStates, bindingSet->hasUavBindings ? nullptr : bindingSet);
+    }
+
     void CommandList::insertResourceBarriersForBindingSets(const BindingSetVector& newBindings, const BindingSetVector& oldBindings)
     {
         uint32_t bindingUpdateMask = 0;
@@ -128,6 +151,11 @@ namespace nvrhi::vulkan
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
 
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentGraphicsState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
         m_BindingStatesDirty = false;
     }
 
@@ -142,6 +170,11 @@ namespace nvrhi::vulkan
             requireBufferState(indirectParams, ResourceStates::IndirectArgument);
         }
 
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentComputeState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
         m_BindingStatesDirty = false;
     }
 
@@ -159,6 +192,11 @@ namespace nvrhi::vulkan
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
 
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentMeshletState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
         m_BindingStatesDirty = false;
     }
 
@@ -185,79 +223,251 @@ namespace nvrhi::vulkan
 
     bool CommandList::anyBarriers() const
     {
-        return !m_StateTracker.getBufferBarriers().empty() || !m_StateTracker.getTextureBarriers().empty();
+        return m_StateTracker.hasPendingBarriers();
+    }
+
+    static vk::ImageMemoryBarrier2 convertTextureBarrier(const TextureBarrier& barrier)
+    {
+        ResourceStateMapping before = convertResourceState(barrier.stateBefore, true);
+        ResourceStateMapping after = convertResourceState(barrier.stateAfter, true);
+
+        if (barrier.aliased)
+        {
+            // The layout transition from UNDEFINED must not start before the aliasing barrier completes,
+            // which it would do with the TOP_OF_PIPE source stage of the Common state.
+            before.stageFlags = vk::PipelineStageFlagBits2::eAllCommands;
+            before.accessMask = vk::AccessFlagBits2::eMemoryWrite;
+        }
+
+        assert(after.imageLayout != vk::ImageLayout::eUndefined);
+
+        Texture* texture = static_cast<Texture*>(barrier.texture);
+
+        const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+
+        vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
+        if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
+        if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
+        if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
+
+        vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
+            .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
+            .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
+            .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
+            .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
+            .setAspectMask(aspectMask);
+
+        return vk::ImageMemoryBarrier2()
+            .setSrcAccessMask(before.accessMask)
+            .setDstAccessMask(after.accessMask)
+            .setSrcStageMask(before.stageFlags)
+            .setDstStageMask(after.stageFlags)
+            .setOldLayout(before.imageLayout)
+            .setNewLayout(after.imageLayout)
+            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setImage(texture->image)
+            .setSubresourceRange(subresourceRange);
+    }
+
+    static vk::BufferMemoryBarrier2 convertBufferBarrier(const BufferBarrier& barrier)
+    {
+        ResourceStateMapping before = convertResourceState(barrier.stateBefore, false);
+        ResourceStateMapping after = convertResourceState(barrier.stateAfter, false);
+
+        Buffer* buffer = static_cast<Buffer*>(barrier.buffer);
+
+        return vk::BufferMemoryBarrier2()
+            .setSrcAccessMask(before.accessMask)
+            .setDstAccessMask(after.accessMask)
+            .setSrcStageMask(before.stageFlags)
+            .setDstStageMask(after.stageFlags)
+            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setBuffer(buffer->buffer)
+            .setOffset(0)
+            .setSize(buffer->desc.byteSize);
+    }
+
+    // Turns a barrier with equal source and destination states into one half of a queue family ownership transfer.
+    // The access and stage masks of the other queue's half are ignored by the transfer.
+    template<typename BarrierType>
+    static void applyQueueOwnershipTransfer(BarrierType& barrier, QueueOwnershipTransfer transfer, uint32_t ownFamily, uint32_t otherFamily)
+    {
+        if (ownFamily == otherFamily)
+            return;
+
+        if (transfer == QueueOwnershipTransfer::Release)
+        {
+            barrier.setSrcQueueFamilyIndex(ownFamily)
+                .setDstQueueFamilyIndex(otherFamily)
+                .setDstAccessMask(vk::AccessFlags2())
+                .setDstStageMask(vk::PipelineStageFlags2());
+        }
+        else
+        {
+            barrier.setSrcQueueFamilyIndex(otherFamily)
+                .setDstQueueFamilyIndex(ownFamily)
+                .setSrcAccessMask(vk::AccessFlags2())
+                .setSrcStageMask(vk::PipelineStageFlags2());
+        }
     }
 
     void CommandList::commitBarriersInternal()
     {
         std::vector<vk::ImageMemoryBarrier2> imageBarriers;
         std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
+        std::vector<vk::ImageMemoryBarrier2> acquireImageBarriers;
+        std::vector<vk::BufferMemoryBarrier2> acquireBufferBarriers;
+        std::vector<vk::ImageMemoryBarrier2> releaseImageBarriers;
+        std::vector<vk::BufferMemoryBarrier2> releaseBufferBarriers;
+        std::vector<uint32_t> endedSplits;
+        std::vector<uint32_t> begunSplits;
+
+        auto noteSplit = [](std::vector<uint32_t>& splits, uint32_t id)
+        {
+            // Split transitions are rare, and there are a few of them in one batch at most
+            if (std::find(splits.begin(), splits.end(), id) == splits.end())
+                splits.push_back(id);
+        };
+
+        // Sort the barriers into regular ones and the halves of split transitions. The End barriers only
+        // identify the transition, the wait has to use the dependency info that was stored with the Begin barriers.
+        const uint32_t ownFamily = m_Device->getQueue(m_CommandListParameters.queueType)->getQueueFamilyIndex();
+        auto getQueueFamily = [this, ownFamily](CommandQueue queue)
+        {
+            const Queue* otherQueue = m_Device->getQueue(queue);
+            return otherQueue ? otherQueue->getQueueFamilyIndex() : ownFamily;
+        };
 
         for (const TextureBarrier& barrier : m_StateTracker.getTextureBarriers())
         {
-            ResourceStateMapping before = convertResourceState(barrier.stateBefore, true);
-            ResourceStateMapping after = convertResourceState(barrier.stateAfter, true);
-
-            assert(after.imageLayout != vk::ImageLayout::eUndefined);
-
-            Texture* texture = static_cast<Texture*>(barrier.texture);
-
-            const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
-
-            vk::ImageAspectFlags aspectMask = (vk::ImageAspectFlagBits)0;
-            if (formatInfo.hasDepth) aspectMask |= vk::ImageAspectFlagBits::eDepth;
-            if (formatInfo.hasStencil) aspectMask |= vk::ImageAspectFlagBits::eStencil;
-            if (!aspectMask) aspectMask = vk::ImageAspectFlagBits::eColor;
-
-            vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
-                .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
-                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
-                .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
-                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
-                .setAspectMask(aspectMask);
-
-            imageBarriers.push_back(vk::ImageMemoryBarrier2()
-                .setSrcAccessMask(before.accessMask)
-                .setDstAccessMask(after.accessMask)
-                .setSrcStageMask(before.stageFlags)
-                .setDstStageMask(after.stageFlags)
-                .setOldLayout(before.imageLayout)
-                .setNewLayout(after.imageLayout)
-                .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                .setImage(texture->image)
-                .setSubresourceRange(subresourceRange));
+            if (barrier.ownershipTransfer != QueueOwnershipTransfer::None)
+            {
+                vk::ImageMemoryBarrier2 imageBarrier = convertTextureBarrier(barrier);
+                applyQueueOwnershipTransfer(imageBarrier, barrier.ownershipTransfer, ownFamily, getQueueFamily(barrier.otherQueue));
+
+                if (barrier.ownershipTransfer == QueueOwnershipTransfer::Acquire)
+                    acquireImageBarriers.push_back(imageBarrier);
+                else
+                    releaseImageBarriers.push_back(imageBarrier);
+                continue;
+            }
+
+            switch (barrier.splitPhase)
+            {
+            case SplitBarrierPhase::Begin:
+                m_PendingSplitBarriers[barrier.splitId].imageBarriers.push_back(convertTextureBarrier(barrier));
+                noteSplit(begunSplits, barrier.splitId);
+                break;
+            case SplitBarrierPhase::End:
+                noteSplit(endedSplits, barrier.splitId);
+                break;
+            case SplitBarrierPhase::None:
+            default:
+                imageBarriers.push_back(convertTextureBarrier(barrier));
+                break;
+            }
         }
 
-        if (!imageBarriers.empty())
+        for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
+        {
+            if (barrier.ownershipTransfer != QueueOwnershipTransfer::None)
+            {
+                vk::BufferMemoryBarrier2 bufferBarrier = convertBufferBarrier(barrier);
+                applyQueueOwnershipTransfer(bufferBarrier, barrier.ownershipTransfer, ownFamily, getQueueFamily(barrier.otherQueue));
+
+                if (barrier.ownershipTransfer == QueueOwnershipTransfer::Acquire)
+                    acquireBufferBarriers.push_back(bufferBarrier);
+                else
+                    releaseBufferBarriers.push_back(bufferBarrier);
+                continue;
+            }
+
+            switch (barrier.splitPhase)
+            {
+            case SplitBarrierPhase::Begin:
+                m_PendingSplitBarriers[barrier.splitId].bufferBarriers.push_back(convertBufferBarrier(barrier));
+                noteSplit(begunSplits, barrier.splitId);
+                break;
+            case SplitBarrierPhase::End:
+                noteSplit(endedSplits, barrier.splitId);
+                break;
+            case SplitBarrierPhase::None:
+            default:
+                bufferBarriers.push_back(convertBufferBarrier(barrier));
+                break;
+            }
+        }
+
+        // The split transitions that end in this batch were begun in earlier batches, complete them first
+        for (uint32_t splitId : endedSplits)
         {
+            auto it = m_PendingSplitBarriers.find(splitId);
+            if (it == m_PendingSplitBarriers.end())
+                continue;
+
+            const PendingSplitBarrier& split = it->second;
+
             vk::DependencyInfo dep_info;
-            dep_info.setImageMemoryBarriers(imageBarriers);
+            dep_info.setImageMemoryBarriers(split.imageBarriers);
+            dep_info.setBufferMemoryBarriers(split.bufferBarriers);
+
+            m_CurrentCmdBuf->cmdBuf.waitEvents2(split.event, dep_info);
+
+            // Reset the event after the wait so that the command buffer can reuse it
+            vk::PipelineStageFlags2 waitStages = vk::PipelineStageFlags2();
+            for (const auto& barrier : split.imageBarriers)
+                waitStages |= barrier.dstStageMask;
+            for (const auto& barrier : split.bufferBarriers)
+                waitStages |= barrier.dstStageMask;
+
+            m_CurrentCmdBuf->cmdBuf.resetEvent2(split.event, waitStages);
+
+            m_PendingSplitBarriers.erase(it);
+        }
+
+        if (!m_StateTracker.getAliasingBarriers().empty())
+        {
+            // The memory of aliased resources may have been written by any prior command, so one global barrier
+            // covers all aliasing barriers in the batch.
+            auto memoryBarrier = vk::MemoryBarrier2()
+                .setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+                .setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite);
+
+            vk::DependencyInfo dep_info;
+            dep_info.setMemoryBarriers(memoryBarrier);
 
             m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+            NVRHI_COUNT_STATISTIC(m_Statistics, barriers, 1);
         }
 
-        imageBarriers.clear();
+        NVRHI_COUNT_STATISTIC(m_Statistics, barriers, acquireImageBarriers.size() + acquireBufferBarriers.size()
+            + imageBarriers.size() + bufferBarriers.size() + releaseImageBarriers.size() + releaseBufferBarriers.size());
 
-        for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
+        // Acquires go before the transitions out of the handoff state, and releases after the transitions into it,
+        // because there is no ordering between the barriers of one pipelineBarrier2 call.
+        if (!acquireImageBarriers.empty() || !acquireBufferBarriers.empty())
         {
-            ResourceStateMapping before = convertResourceState(barrier.stateBefore, false);
-            ResourceStateMapping after = convertResourceState(barrier.stateAfter, false);
-
-            Buffer* buffer = static_cast<Buffer*>(barrier.buffer);
-
-            bufferBarriers.push_back(vk::BufferMemoryBarrier2()
-                .setSrcAccessMask(before.accessMask)
-                .setDstAccessMask(after.accessMask)
-                .setSrcStageMask(before.stageFlags)
-                .setDstStageMask(after.stageFlags)
-                .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                .setBuffer(buffer->buffer)
-                .setOffset(0)
-                .setSize(buffer->desc.byteSize));
+            vk::DependencyInfo dep_info;
+            dep_info.setImageMemoryBarriers(acquireImageBarriers);
+            dep_info.setBufferMemoryBarriers(acquireBufferBarriers);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
         }
 
+        if (!imageBarriers.empty())
+        {
+            vk::DependencyInfo dep_info;
+            dep_info.setImageMemoryBarriers(imageBarriers);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+        }
+
+        imageBarriers.clear();
+
         if (!bufferBarriers.empty())
         {
             vk::DependencyInfo dep_info;
@@ -267,19 +477,156 @@ namespace nvrhi::vulkan
         }
         bufferBarriers.clear();
 
+        if (!releaseImageBarriers.empty() || !releaseBufferBarriers.empty())
+        {
+            vk::DependencyInfo dep_info;
+            dep_info.setImageMemoryBarriers(releaseImageBarriers);
+            dep_info.setBufferMemoryBarriers(releaseBufferBarriers);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+        }
+
+        // Signal the events for the split transitions that begin in this batch, after the regular barriers
+        // that may have transitioned the same resources into the source states
+        for (uint32_t splitId : begunSplits)
+        {
+            PendingSplitBarrier& split = m_PendingSplitBarriers[splitId];
+            split.event = m_CurrentCmdBuf->acquireSplitBarrierEvent();
+
+            vk::DependencyInfo dep_info;
+            dep_info.setImageMemoryBarriers(split.imageBarriers);
+            dep_info.setBufferMemoryBarriers(split.bufferBarriers);
+
+            if (split.event)
+            {
+                m_CurrentCmdBuf->cmdBuf.setEvent2(split.event, dep_info);
+            }
+            else
+            {
+                // Couldn't create an event, don't split the transition
+                m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+                m_PendingSplitBarriers.erase(splitId);
+            }
+        }
+
         m_StateTracker.clearBarriers();
     }
 
+    void CommandList::recordStateFixups(const std::vector<StateFixup>& fixups)
+    {
+        for (const StateFixup& fixup : fixups)
+        {
+            if (fixup.texture)
+            {
+                m_StateTracker.beginTrackingTextureState(fixup.texture, AllSubresources, fixup.stateBefore);
+                m_StateTracker.requireTextureState(fixup.texture, AllSubresources, fixup.stateAfter);
+            }
+            else
+            {
+                m_StateTracker.beginTrackingBufferState(fixup.buffer, fixup.stateBefore);
+                m_StateTracker.requireBufferState(fixup.buffer, fixup.stateAfter);
+            }
+        }
+
+        commitBarriers();
+    }
+
     void CommandList::commitBarriers()
     {
-        if (m_StateTracker.getBufferBarriers().empty() && m_StateTracker.getTextureBarriers().empty())
+        if (!m_StateTracker.hasPendingBarriers())
             return;
 
+        InstrumentationScope instrumentationScope(m_Context.instrumentation, InstrumentationZone::CommitBarriers);
+
         endRenderPass();
 
         commitBarriersInternal();
     }
 
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, subresources, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::releaseTextureOwnership(ITexture* _texture, TextureSubresourceSet subresources, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.releaseTextureOwnership(texture, subresources, destinationQueue, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(texture);
+    }
+
+    void CommandList::acquireTextureOwnership(ITexture* _texture, TextureSubresourceSet subresources, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.acquireTextureOwnership(texture, subresources, sourceQueue, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(texture);
+    }
+
+    void CommandList::releaseBufferOwnership(IBuffer* _buffer, CommandQueue destinationQueue, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.releaseBufferOwnership(buffer, destinationQueue, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::acquireBufferOwnership(IBuffer* _buffer, CommandQueue sourceQueue, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.acquireBufferOwnership(buffer, sourceQueue, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::setAliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        if (ITexture* textureAfter = dynamic_cast<ITexture*>(resourceAfter))
+        {
+            Texture* texture = checked_cast<Texture*>(textureAfter);
+            m_StateTracker.discardTextureState(texture);
+        }
+        else if (IBuffer* bufferAfter = dynamic_cast<IBuffer*>(resourceAfter))
+        {
+            Buffer* buffer = checked_cast<Buffer*>(bufferAfter);
+            m_StateTracker.discardBufferState(buffer);
+        }
+
+        m_StateTracker.addAliasingBarrier(resourceBefore, resourceAfter);
+
+        if (m_CurrentCmdBuf)
+        {
+            if (resourceBefore)
+                m_CurrentCmdBuf->referencedResources.push_back(resourceBefore);
+            if (resourceAfter)
+                m_CurrentCmdBuf->referencedResources.push_back(resourceAfter);
+        }
+    }
+
     void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
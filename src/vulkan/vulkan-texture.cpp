@@ -344,6 +344,8 @@ namespace nvrhi::vulkan
             ASSERT_VK_OK(res);
             CHECK_VK_FAIL(res)
 
+            texture->trackedMemory.set(m_Context.memoryCounters, texture, texture->memorySize);
+
             if((desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0)
             {
 #ifdef _WIN32
@@ -353,7 +355,8 @@ namespace nvrhi::vulkan
 #endif
             }
 
-            m_Context.nameVKObject(texture->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            if (!texture->memoryBlock)
+                m_Context.nameVKObject(texture->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
         }
 
         return TextureHandle::Create(texture);
@@ -386,6 +389,7 @@ namespace nvrhi::vulkan
         m_Context.device.bindImageMemory(texture->image, heap->memory, offset);
 
         texture->heap = heap;
+        texture->trackedMemory.setPlaced(m_Context.memoryCounters, texture, getTextureMemoryRequirements(texture).size, heap, offset);
 
         return true;
     }
@@ -538,6 +542,106 @@ namespace nvrhi::vulkan
             1, &imageCopy);
     }
 
+    void CommandList::writeTextureRegions(ITexture* _dest, const TextureUploadRegion* regions, size_t numRegions)
+    {
+        endRenderPass();
+
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        if (numRegions == 0)
+            return;
+
+        const FormatInfo& formatInfo = getFormatInfo(dest->desc.format);
+        const vk::ImageAspectFlags aspectMask = guessImageAspectFlags(dest->imageInfo.format);
+
+        // Pack all the regions into one upload allocation, with the same per-region alignment as writeTexture
+        constexpr uint64_t regionAlignment = 256;
+
+        std::vector<TextureSlice> slices(numRegions);
+        std::vector<vk::BufferImageCopy> imageCopies(numRegions);
+        uint64_t totalBytes = 0;
+
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            const TextureSlice slice = regions[i].slice.resolve(dest->desc);
+            slices[i] = slice;
+
+            const uint32_t deviceNumCols = (slice.width + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            const uint32_t deviceNumRows = (slice.height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            const uint64_t regionOffset = (totalBytes + regionAlignment - 1) & ~(regionAlignment - 1);
+
+            imageCopies[i] = vk::BufferImageCopy()
+                .setBufferOffset(regionOffset)
+                .setBufferRowLength(deviceNumCols * formatInfo.blockSize)
+                .setBufferImageHeight(deviceNumRows * formatInfo.blockSize)
+                .setImageSubresource(vk::ImageSubresourceLayers()
+                    .setAspectMask(aspectMask)
+                    .setMipLevel(slice.mipLevel)
+                    .setBaseArrayLayer(slice.arraySlice)
+                    .setLayerCount(1))
+                .setImageOffset(vk::Offset3D(int32_t(slice.x), int32_t(slice.y), int32_t(slice.z)))
+                .setImageExtent(vk::Extent3D().setWidth(slice.width).setHeight(slice.height).setDepth(slice.depth));
+
+            totalBytes = regionOffset + uint64_t(deviceNumCols) * formatInfo.bytesPerBlock * deviceNumRows * slice.depth;
+        }
+
+        Buffer* uploadBuffer;
+        uint64_t uploadOffset;
+        void* uploadCpuVA;
+        if (!m_UploadManager->suballocateBuffer(
+            totalBytes,
+            &uploadBuffer,
+            &uploadOffset,
+            &uploadCpuVA,
+            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false)))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
+
+        for (size_t i = 0; i < numRegions; i++)
+        {
+            const TextureUploadRegion& region = regions[i];
+            const TextureSlice& slice = slices[i];
+            vk::BufferImageCopy& imageCopy = imageCopies[i];
+
+            const uint32_t deviceNumRows = imageCopy.bufferImageHeight / formatInfo.blockSize;
+            const size_t deviceRowPitch = size_t(imageCopy.bufferRowLength / formatInfo.blockSize) * formatInfo.bytesPerBlock;
+            const size_t minRowPitch = std::min(deviceRowPitch, region.rowPitch);
+
+            uint8_t* mappedPtr = (uint8_t*)uploadCpuVA + imageCopy.bufferOffset;
+            for (uint32_t depthSlice = 0; depthSlice < slice.depth; depthSlice++)
+            {
+                const uint8_t* sourcePtr = (const uint8_t*)region.data + region.depthPitch * depthSlice;
+                for (uint32_t row = 0; row < deviceNumRows; row++)
+                {
+                    memcpy(mappedPtr, sourcePtr, minRowPitch);
+                    mappedPtr += deviceRowPitch;
+                    sourcePtr += region.rowPitch;
+                }
+            }
+
+            imageCopy.bufferOffset += uploadOffset;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireTextureState(dest, TextureSubresourceSet(slice.mipLevel, 1, slice.arraySlice, 1), ResourceStates::CopyDest);
+            }
+        }
+
+        assert(m_CurrentCmdBuf);
+
+        if (m_EnableAutomaticBarriers)
+            m_BindingStatesDirty = true;
+        commitBarriers();
+
+        m_CurrentCmdBuf->referencedResources.push_back(dest);
+
+        m_CurrentCmdBuf->cmdBuf.copyBufferToImage(uploadBuffer->buffer,
+            dest->image, vk::ImageLayout::eTransferDstOptimal,
+            uint32_t(imageCopies.size()), imageCopies.data());
+    }
+
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
     {
         endRenderPass();
@@ -823,6 +927,12 @@ namespace nvrhi::vulkan
 
     SamplerHandle Device::createSampler(const SamplerDesc& desc)
     {
+        if (m_InternedStates)
+        {
+            if (SamplerHandle existing = m_InternedStates->samplers.find(desc))
+                return existing;
+        }
+
         Sampler *sampler = new Sampler(m_Context);
 
         const bool anisotropyEnable = desc.maxAnisotropy > 1.0f;
@@ -856,8 +966,13 @@ namespace nvrhi::vulkan
 
         const vk::Result res = m_Context.device.createSampler(&sampler->samplerInfo, m_Context.allocationCallbacks, &sampler->sampler);
         CHECK_VK_FAIL(res)
+
+        SamplerHandle samplerHandle = SamplerHandle::Create(sampler);
+
+        if (m_InternedStates)
+            return m_InternedStates->samplers.insert(desc, sampler, sampler->internEntry);
         
-        return SamplerHandle::Create(sampler);
+        return samplerHandle;
     }
 
     Object Sampler::getNativeObject(ObjectType objectType)
@@ -26,8 +26,284 @@
 namespace nvrhi::vulkan
 {
 
+    UploadRing::UploadRing(Device* pParent, uint64_t ringSize, uint64_t chunkSize, bool isVolatileConstantRing)
+        : m_Device(pParent)
+        , m_ChunkSize(align(std::max(chunkSize, BufferChunk::c_sizeAlignment), BufferChunk::c_sizeAlignment))
+        , m_IsVolatileConstantRing(isVolatileConstantRing)
+    {
+        m_RingSize = std::max(ringSize / m_ChunkSize, uint64_t(1)) * m_ChunkSize;
+    }
+
+    bool UploadRing::createBuffer()
+    {
+        BufferDesc desc;
+        desc.byteSize = m_RingSize;
+        desc.cpuAccess = CpuAccessMode::Write;
+        desc.debugName = m_IsVolatileConstantRing ? "VolatileConstantRing" : "UploadRing";
+        desc.isConstantBuffer = m_IsVolatileConstantRing;
+
+        // Same usage as the upload manager chunks, see UploadManager::CreateChunk
+        desc.isAccelStructBuildInput = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
+        desc.isShaderBindingTable = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
+
+        m_Buffer = m_Device->createBuffer(desc);
+        if (!m_Buffer)
+            return false;
+
+        checked_cast<Buffer*>(m_Buffer.Get())->trackedMemory.setCategory(MemoryCategory::UploadChunks);
+
+        char* mappedMemory = static_cast<char*>(m_Device->mapBuffer(m_Buffer, CpuAccessMode::Write));
+        if (!mappedMemory)
+        {
+            m_Buffer = nullptr;
+            return false;
+        }
+
+        size_t const numChunks = size_t(m_RingSize / m_ChunkSize);
+        m_Chunks.reserve(numChunks);
+
+        for (size_t index = 0; index < numChunks; index++)
+        {
+            auto chunk = std::make_shared<BufferChunk>();
+            chunk->buffer = m_Buffer;
+            chunk->bufferOffset = index * m_ChunkSize;
+            chunk->bufferSize = m_ChunkSize;
+            chunk->mappedMemory = mappedMemory + chunk->bufferOffset;
+            chunk->isRingChunk = true;
+            m_Chunks.push_back(chunk);
+        }
+
+        m_Statistics.capacity = m_RingSize;
+        return true;
+    }
+
+    bool UploadRing::isChunkInUse(const BufferChunk& chunk) const
+    {
+        if (chunk.version == 0)
+            return false;
+
+        // The volatile constant ring is shared by all queues, so look at the queue that used the chunk
+        return !VersionGetSubmitted(chunk.version)
+            || VersionGetInstance(chunk.version) > m_Device->queueGetCompletedInstance(VersionGetQueue(chunk.version));
+    }
+
+    bool UploadRing::ensureBuffer()
+    {
+        if (!m_Buffer)
+        {
+            // Don't retry creating the buffer on every allocation if it has failed once
+            if (m_CreationFailed || !createBuffer())
+            {
+                m_CreationFailed = true;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    Buffer* UploadRing::getBuffer()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!ensureBuffer())
+            return nullptr;
+
+        return checked_cast<Buffer*>(m_Buffer.Get());
+    }
+
+    std::shared_ptr<BufferChunk> UploadRing::claimChunk(uint64_t currentVersion)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!ensureBuffer())
+            return nullptr;
+
+        // Chunks are claimed in order, so if the oldest chunk is in use, the ring is full
+        std::shared_ptr<BufferChunk> const& chunk = m_Chunks[m_NextChunk];
+        if (isChunkInUse(*chunk))
+        {
+            ++m_Statistics.numClaimFailures;
+            return nullptr;
+        }
+
+        chunk->version = currentVersion;
+        chunk->writePointer = 0;
+        m_NextChunk = (m_NextChunk + 1) % m_Chunks.size();
+
+        ++m_Statistics.numChunksClaimed;
+        m_Statistics.peakBytesInUse = std::max(m_Statistics.peakBytesInUse, getBytesInUse());
+
+        return chunk;
+    }
+
+    void UploadRing::submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const auto& chunk : chunks)
+            chunk->version = submittedVersion;
+    }
+
+    void UploadRing::releaseChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // A chunk that has been submitted may have been claimed again by another recording since then, leave it alone
+        for (const auto& chunk : chunks)
+        {
+            if (!VersionGetSubmitted(chunk->version))
+                chunk->version = 0;
+        }
+    }
+
+    uint64_t UploadRing::getBytesInUse() const
+    {
+        uint64_t bytesInUse = 0;
+        for (const auto& chunk : m_Chunks)
+        {
+            if (isChunkInUse(*chunk))
+                bytesInUse += chunk->bufferSize;
+        }
+        return bytesInUse;
+    }
+
+    UploadRingStatistics UploadRing::getStatistics()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        UploadRingStatistics result = m_Statistics;
+        result.bytesInUse = getBytesInUse();
+        return result;
+    }
+
+    ScratchPool::ScratchPool(Device* pParent, CommandQueue queue, uint64_t maxMemory, uint64_t chunkSize)
+        : m_Device(pParent)
+        , m_Queue(queue)
+        , m_MaxMemory(maxMemory)
+        , m_ChunkSize(align(std::max(chunkSize, BufferChunk::c_sizeAlignment), BufferChunk::c_sizeAlignment))
+    { }
+
+    std::shared_ptr<BufferChunk> ScratchPool::claimChunk(uint64_t size, uint64_t currentVersion, bool& needsBarrier)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        needsBarrier = false;
+        uint64_t const completedInstance = m_Device->queueGetCompletedInstance(m_Queue);
+
+        auto isFree = [completedInstance](const BufferChunk& chunk)
+        {
+            return chunk.version == 0 ||
+                (VersionGetSubmitted(chunk.version) && VersionGetInstance(chunk.version) <= completedInstance);
+        };
+
+        // Pick the smallest free chunk that fits, and remember the oldest submitted one for the over-budget case
+        std::shared_ptr<BufferChunk> bestChunk;
+        std::shared_ptr<BufferChunk> oldestSubmittedChunk;
+        for (const auto& chunk : m_Chunks)
+        {
+            if (chunk->bufferSize < size)
+                continue;
+
+            if (isFree(*chunk))
+            {
+                if (!bestChunk || chunk->bufferSize < bestChunk->bufferSize)
+                    bestChunk = chunk;
+            }
+            else if (VersionGetSubmitted(chunk->version))
+            {
+                if (!oldestSubmittedChunk || VersionGetInstance(chunk->version) < VersionGetInstance(oldestSubmittedChunk->version))
+                    oldestSubmittedChunk = chunk;
+            }
+        }
+
+        if (!bestChunk)
+        {
+            uint64_t const sizeToAllocate = align(std::max(size, m_ChunkSize), BufferChunk::c_sizeAlignment);
+
+            // Free chunks that are too small for this allocation are released to make room in the budget
+            for (auto it = m_Chunks.begin(); it != m_Chunks.end() && m_AllocatedMemory + sizeToAllocate > m_MaxMemory; )
+            {
+                if (isFree(**it))
+                {
+                    m_AllocatedMemory -= (*it)->bufferSize;
+                    it = m_Chunks.erase(it);
+                }
+                else
+                    ++it;
+            }
+
+            if (m_AllocatedMemory + sizeToAllocate <= m_MaxMemory)
+            {
+                InstrumentationScope instrumentationScope(m_Device->getInstrumentation(), InstrumentationZone::AllocateUploadChunk);
+
+                BufferDesc desc;
+                desc.byteSize = sizeToAllocate;
+                desc.cpuAccess = CpuAccessMode::None;
+                desc.debugName = "SharedScratchBufferChunk";
+                desc.canHaveUAVs = true;
+
+                BufferHandle buffer = m_Device->createBuffer(desc);
+                if (buffer)
+                {
+                    checked_cast<Buffer*>(buffer.Get())->trackedMemory.setCategory(MemoryCategory::UploadChunks);
+
+                    bestChunk = std::make_shared<BufferChunk>();
+                    bestChunk->buffer = buffer;
+                    bestChunk->bufferSize = sizeToAllocate;
+                    bestChunk->isPoolChunk = true;
+
+                    m_AllocatedMemory += sizeToAllocate;
+                    m_Chunks.push_back(bestChunk);
+                }
+            }
+        }
+
+        if (!bestChunk && oldestSubmittedChunk)
+        {
+            // Over the budget: the submissions on one queue execute in order, so a chunk used by an earlier
+            // submission can be reused after a barrier that waits for its builds.
+            bestChunk = oldestSubmittedChunk;
+            needsBarrier = true;
+        }
+
+        if (bestChunk)
+        {
+            bestChunk->version = currentVersion;
+            bestChunk->writePointer = 0;
+        }
+
+        return bestChunk;
+    }
+
+    void ScratchPool::submitChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks, uint64_t submittedVersion)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const auto& chunk : chunks)
+            chunk->version = submittedVersion;
+    }
+
+    void ScratchPool::releaseChunks(const std::vector<std::shared_ptr<BufferChunk>>& chunks)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (const auto& chunk : chunks)
+        {
+            if (!VersionGetSubmitted(chunk->version))
+                chunk->version = 0;
+        }
+    }
+
+    UploadManager::~UploadManager()
+    {
+        releaseUnsubmittedChunks();
+    }
+
     std::shared_ptr<BufferChunk> UploadManager::CreateChunk(uint64_t size)
     {
+        InstrumentationScope instrumentationScope(m_Device->getInstrumentation(), InstrumentationZone::AllocateUploadChunk);
+
         std::shared_ptr<BufferChunk> chunk = std::make_shared<BufferChunk>();
 
         if (m_IsScratchBuffer)
@@ -58,12 +334,19 @@ namespace nvrhi::vulkan
             chunk->bufferSize = size;
         }
 
+        if (chunk->buffer)
+            checked_cast<Buffer*>(chunk->buffer.Get())->trackedMemory.setCategory(MemoryCategory::UploadChunks);
+
         return chunk;
     }
 
     bool UploadManager::suballocateBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA,
         uint64_t currentVersion, uint32_t alignment)
     {
+#if NVRHI_WITH_COMMAND_LIST_STATISTICS
+        m_SuballocatedBytes += size;
+#endif
+
         std::shared_ptr<BufferChunk> chunkToRetire;
 
         if (m_CurrentChunk)
@@ -76,7 +359,7 @@ namespace nvrhi::vulkan
                 m_CurrentChunk->writePointer = endOfDataInChunk;
 
                 *pBuffer = checked_cast<Buffer*>(m_CurrentChunk->buffer.Get());
-                *pOffset = alignedOffset;
+                *pOffset = m_CurrentChunk->bufferOffset + alignedOffset;
                 if (pCpuVA && m_CurrentChunk->mappedMemory)
                     *pCpuVA = (char*)m_CurrentChunk->mappedMemory + alignedOffset;
 
@@ -87,10 +370,23 @@ namespace nvrhi::vulkan
             m_CurrentChunk.reset();
         }
 
+        // Prefer the shared ring when the allocation fits into its chunks
+        if (m_Ring && size <= m_Ring->getChunkSize())
+        {
+            m_CurrentChunk = m_Ring->claimChunk(currentVersion);
+        }
+
+        if (m_ScratchPool && !m_CurrentChunk)
+        {
+            bool needsBarrier = false;
+            m_CurrentChunk = m_ScratchPool->claimChunk(size, currentVersion, needsBarrier);
+            m_ReusedChunkBarrier = m_ReusedChunkBarrier || (m_CurrentChunk && needsBarrier);
+        }
+
         CommandQueue queue = VersionGetQueue(currentVersion);
         uint64_t completedInstance = m_Device->queueGetCompletedInstance(queue);
 
-        for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); ++it)
+        for (auto it = m_ChunkPool.begin(); !m_CurrentChunk && it != m_ChunkPool.end(); ++it)
         {
             std::shared_ptr<BufferChunk> chunk = *it;
 
@@ -110,7 +406,7 @@ namespace nvrhi::vulkan
 
         if (chunkToRetire)
         {
-            m_ChunkPool.push_back(chunkToRetire);
+            retireChunk(chunkToRetire);
         }
 
         if (!m_CurrentChunk)
@@ -123,22 +419,35 @@ namespace nvrhi::vulkan
             m_CurrentChunk = CreateChunk(sizeToAllocate);
         }
 
-        m_CurrentChunk->version = currentVersion;
+        // The version of ring and pool chunks is set by their owner under its mutex
+        if (!m_CurrentChunk->isRingChunk && !m_CurrentChunk->isPoolChunk)
+            m_CurrentChunk->version = currentVersion;
         m_CurrentChunk->writePointer = size;
 
         *pBuffer = checked_cast<Buffer*>(m_CurrentChunk->buffer.Get());
-        *pOffset = 0;
+        *pOffset = m_CurrentChunk->bufferOffset;
         if (pCpuVA)
             *pCpuVA = m_CurrentChunk->mappedMemory;
 
         return true;
     }
 
+    void UploadManager::retireChunk(const std::shared_ptr<BufferChunk>& chunk)
+    {
+        // Ring and pool chunks go back to their owner on submission, they're not reused by this manager directly
+        if (chunk->isRingChunk)
+            m_RingChunks.push_back(chunk);
+        else if (chunk->isPoolChunk)
+            m_PoolChunks.push_back(chunk);
+        else
+            m_ChunkPool.push_back(chunk);
+    }
+
     void UploadManager::submitChunks(uint64_t currentVersion, uint64_t submittedVersion)
     {
         if (m_CurrentChunk)
         {
-            m_ChunkPool.push_back(m_CurrentChunk);
+            retireChunk(m_CurrentChunk);
             m_CurrentChunk.reset();
         }
 
@@ -147,6 +456,45 @@ namespace nvrhi::vulkan
             if (chunk->version == currentVersion)
                 chunk->version = submittedVersion;
         }
+
+        if (!m_RingChunks.empty())
+        {
+            m_Ring->submitChunks(m_RingChunks, submittedVersion);
+            m_RingChunks.clear();
+        }
+
+        if (!m_PoolChunks.empty())
+        {
+            m_ScratchPool->submitChunks(m_PoolChunks, submittedVersion);
+            m_PoolChunks.clear();
+        }
+    }
+
+    void UploadManager::releaseUnsubmittedChunks()
+    {
+        if (m_CurrentChunk)
+        {
+            retireChunk(m_CurrentChunk);
+            m_CurrentChunk.reset();
+        }
+
+        for (const auto& chunk : m_ChunkPool)
+        {
+            if (!VersionGetSubmitted(chunk->version))
+                chunk->version = 0;
+        }
+
+        if (!m_RingChunks.empty())
+        {
+            m_Ring->releaseChunks(m_RingChunks);
+            m_RingChunks.clear();
+        }
+
+        if (!m_PoolChunks.empty())
+        {
+            m_ScratchPool->releaseChunks(m_PoolChunks);
+            m_PoolChunks.clear();
+        }
     }
 
 }
\ No newline at end of file